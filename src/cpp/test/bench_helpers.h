@@ -0,0 +1,102 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// shared by the benchmark executables
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace webifc::bench
+{
+
+    // the seconds one stage took in every repetition
+    struct Stage
+    {
+        const char *name;
+        std::vector<double> samples;
+    };
+
+    inline double Seconds(uint64_t start, uint64_t end)
+    {
+        return (end - start) / 1e9;
+    }
+
+    inline std::shared_ptr<const std::vector<uint8_t>> ReadModel(const std::filesystem::path &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return nullptr;
+        auto data = std::make_shared<std::vector<uint8_t>>(std::filesystem::file_size(path));
+        file.read(reinterpret_cast<char *>(data->data()), data->size());
+        if (!file) return nullptr;
+        return data;
+    }
+
+    // the .ifc files at path, directories are searched recursively
+    inline void CollectModels(const std::filesystem::path &path, std::vector<std::filesystem::path> &models)
+    {
+        auto isModel = [](const std::filesystem::path &file)
+        {
+            std::string extension = file.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+            return extension == ".ifc";
+        };
+        if (std::filesystem::is_directory(path))
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file() && isModel(entry.path())) models.push_back(entry.path());
+            }
+        }
+        else if (std::filesystem::is_regular_file(path)) models.push_back(path);
+        else std::cerr << "skipping " << path.string() << ", no such file or directory" << std::endl;
+    }
+
+    inline std::string Escape(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\') escaped += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) escaped += ' ';
+            else escaped += c;
+        }
+        return escaped;
+    }
+
+    // "name": {"min": ..., "median": ..., "mean": ..., "max": ..., "samples": [...]}
+    inline void WriteStage(std::ostream &out, const Stage &stage)
+    {
+        std::vector<double> sorted = stage.samples;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double value : sorted) sum += value;
+        const size_t middle = sorted.size() / 2;
+        const double median = sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+        out << "\"" << stage.name << "\": {\"min\": " << sorted.front() << ", \"median\": " << median << ", \"mean\": " << sum / sorted.size() << ", \"max\": " << sorted.back() << ", \"samples\": [";
+        for (size_t i = 0; i < stage.samples.size(); i++) out << (i > 0 ? ", " : "") << stage.samples[i];
+        out << "]}";
+    }
+
+    // the value after argv[argi], which is consumed
+    inline bool ReadCount(int &argi, int argc, char *argv[], uint32_t &count)
+    {
+        if (argi + 1 >= argc) return false;
+        char *end = nullptr;
+        const long value = std::strtol(argv[++argi], &end, 10);
+        if (*end != '\0' || value < 0) return false;
+        count = static_cast<uint32_t>(value);
+        return true;
+    }
+
+}
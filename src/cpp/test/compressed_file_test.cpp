@@ -0,0 +1,432 @@
+#include "TinyCppTest.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../web-ifc/parsing/IfcCompressedFile.h"
+
+using namespace std;
+using webifc::parsing::IfcCompressedFile;
+
+namespace
+{
+    const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    const uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    const uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    struct BitWriter
+    {
+        vector<uint8_t> bytes;
+        uint64_t buffer = 0;
+        uint32_t count = 0;
+
+        // values are sent from their least significant bit on
+        void Put(uint32_t value, uint32_t bits)
+        {
+            buffer |= uint64_t(value) << count;
+            count += bits;
+            while (count >= 8)
+            {
+                bytes.push_back(static_cast<uint8_t>(buffer));
+                buffer >>= 8;
+                count -= 8;
+            }
+        }
+
+        // huffman codes from their most significant bit on
+        void PutCode(uint32_t code, uint32_t bits)
+        {
+            for (uint32_t bit = bits; bit-- > 0;) Put((code >> bit) & 1, 1);
+        }
+
+        void Align()
+        {
+            if (count > 0) Put(0, 8 - count);
+        }
+    };
+
+    void PutFixedLiteral(BitWriter &writer, uint32_t symbol)
+    {
+        if (symbol < 144) writer.PutCode(0x30 + symbol, 8);
+        else if (symbol < 256) writer.PutCode(0x190 + symbol - 144, 9);
+        else if (symbol < 280) writer.PutCode(symbol - 256, 7);
+        else writer.PutCode(0xc0 + symbol - 280, 8);
+    }
+
+    void PutFixedMatch(BitWriter &writer, uint32_t length, uint32_t distance)
+    {
+        uint32_t lengthSymbol = 28;
+        while (LENGTH_BASE[lengthSymbol] > length) lengthSymbol--;
+        PutFixedLiteral(writer, 257 + lengthSymbol);
+        writer.Put(length - LENGTH_BASE[lengthSymbol], LENGTH_EXTRA[lengthSymbol]);
+        uint32_t distanceSymbol = 29;
+        while (DISTANCE_BASE[distanceSymbol] > distance) distanceSymbol--;
+        writer.PutCode(distanceSymbol, 5);
+        writer.Put(distance - DISTANCE_BASE[distanceSymbol], DISTANCE_EXTRA[distanceSymbol]);
+    }
+
+    // one final block with the fixed codes and greedy matches on the last position of each hashed 3 byte prefix, so
+    // streams have back references without a compression library
+    vector<uint8_t> Deflate(const string &text)
+    {
+        BitWriter writer;
+        writer.Put(1, 1);
+        writer.Put(1, 2);
+        vector<int64_t> last(1 << 16, -1);
+        size_t i = 0;
+        while (i < text.size())
+        {
+            uint32_t length = 0;
+            uint32_t distance = 0;
+            if (i + 3 <= text.size())
+            {
+                const uint32_t key = (uint8_t(text[i]) << 16) | (uint8_t(text[i + 1]) << 8) | uint8_t(text[i + 2]);
+                const uint32_t hash = (key * 2654435761u) >> 16;
+                const int64_t candidate = last[hash];
+                last[hash] = static_cast<int64_t>(i);
+                if (candidate >= 0 && i - candidate <= 32768)
+                {
+                    while (length < 258 && i + length < text.size() && text[candidate + length] == text[i + length]) length++;
+                    distance = static_cast<uint32_t>(i - candidate);
+                }
+            }
+            if (length >= 3)
+            {
+                PutFixedMatch(writer, length, distance);
+                i += length;
+            }
+            else
+            {
+                PutFixedLiteral(writer, uint8_t(text[i]));
+                i++;
+            }
+        }
+        PutFixedLiteral(writer, 256);
+        writer.Align();
+        return writer.bytes;
+    }
+
+    // one final stored block, up to 65535 bytes
+    vector<uint8_t> DeflateStored(const string &text)
+    {
+        BitWriter writer;
+        writer.Put(1, 1);
+        writer.Put(0, 2);
+        writer.Align();
+        writer.Put(static_cast<uint32_t>(text.size()), 16);
+        writer.Put(~static_cast<uint32_t>(text.size()) & 0xffff, 16);
+        writer.bytes.insert(writer.bytes.end(), text.begin(), text.end());
+        return writer.bytes;
+    }
+
+    uint32_t Crc32(const string &text)
+    {
+        uint32_t crc = 0xffffffff;
+        for (unsigned char c : text)
+        {
+            crc ^= c;
+            for (int k = 0; k < 8; k++) crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+        }
+        return ~crc;
+    }
+
+    uint32_t Adler32(const string &text)
+    {
+        uint32_t a = 1;
+        uint32_t b = 0;
+        for (unsigned char c : text)
+        {
+            a = (a + c) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    void PutLE(vector<uint8_t> &bytes, uint32_t value, size_t size)
+    {
+        for (size_t i = 0; i < size; i++) bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    vector<uint8_t> Zlib(const string &text, const vector<uint8_t> &deflated)
+    {
+        vector<uint8_t> bytes = {0x78, 0x01};
+        bytes.insert(bytes.end(), deflated.begin(), deflated.end());
+        const uint32_t adler = Adler32(text);
+        for (int shift = 24; shift >= 0; shift -= 8) bytes.push_back(static_cast<uint8_t>(adler >> shift));
+        return bytes;
+    }
+
+    vector<uint8_t> Gzip(const string &text)
+    {
+        // with a file name, which the header skips up to its NUL
+        vector<uint8_t> bytes = {0x1f, 0x8b, 8, 8, 0, 0, 0, 0, 0, 3, 'm', '.', 'i', 'f', 'c', 0};
+        const vector<uint8_t> deflated = Deflate(text);
+        bytes.insert(bytes.end(), deflated.begin(), deflated.end());
+        PutLE(bytes, Crc32(text), 4);
+        PutLE(bytes, static_cast<uint32_t>(text.size()), 4);
+        return bytes;
+    }
+
+    struct ZipEntry
+    {
+        string name;
+        string text;
+        bool deflated;
+    };
+
+    // local file headers only, the reader never looks at the central directory
+    vector<uint8_t> Zip(const vector<ZipEntry> &entries)
+    {
+        vector<uint8_t> bytes;
+        for (const auto &entry : entries)
+        {
+            const vector<uint8_t> data = entry.deflated ? Deflate(entry.text) : vector<uint8_t>(entry.text.begin(), entry.text.end());
+            PutLE(bytes, 0x04034b50, 4);
+            PutLE(bytes, 20, 2);
+            PutLE(bytes, 0, 2);
+            PutLE(bytes, entry.deflated ? 8 : 0, 2);
+            PutLE(bytes, 0, 4);
+            PutLE(bytes, Crc32(entry.text), 4);
+            PutLE(bytes, static_cast<uint32_t>(data.size()), 4);
+            PutLE(bytes, static_cast<uint32_t>(entry.text.size()), 4);
+            PutLE(bytes, static_cast<uint32_t>(entry.name.size()), 2);
+            PutLE(bytes, 0, 2);
+            bytes.insert(bytes.end(), entry.name.begin(), entry.name.end());
+            bytes.insert(bytes.end(), data.begin(), data.end());
+        }
+        return bytes;
+    }
+
+    string ModelText(size_t lines)
+    {
+        string text = "ISO-10303-21;\nHEADER;\nFILE_SCHEMA(('IFC4'));\nENDSEC;\nDATA;\n";
+        for (size_t i = 1; i <= lines; i++)
+        {
+            text += "#" + to_string(i) + "=IFCCARTESIANPOINT((" + to_string(i * 7 % 1000) + ".," + to_string(i * 13 % 977) + ".,0.));\n";
+        }
+        return text + "ENDSEC;\nEND-ISO-10303-21;\n";
+    }
+
+    string ReadAll(IfcCompressedFile &file, size_t step = 1000)
+    {
+        string text;
+        vector<char> buffer(step);
+        uint32_t read;
+        while ((read = file.Read(buffer.data(), text.size(), step)) > 0) text.append(buffer.data(), read);
+        return text;
+    }
+
+    // opens the bytes and reads them to the end, they either turn out corrupt or inflate to the text
+    bool FailsCleanly(const vector<uint8_t> &bytes, const string &text)
+    {
+        IfcCompressedFile file;
+        if (!file.Open(bytes.data(), bytes.size())) return true;
+        const string read = ReadAll(file);
+        return file.IsCorrupt() || read == text;
+    }
+}
+
+TEST(InflateGzipRoundTrip)
+{
+    const string text = ModelText(2000);
+    const vector<uint8_t> gzip = Gzip(text);
+    ASSERT_EQ(IfcCompressedFile::IsCompressed(gzip.data(), gzip.size()), true);
+    IfcCompressedFile file;
+    ASSERT_EQ(file.Open(gzip.data(), gzip.size()), true);
+    ASSERT_EQ(ReadAll(file) == text, true);
+    ASSERT_EQ(file.IsCorrupt(), false);
+}
+
+TEST(InflateZlibRoundTrip)
+{
+    const string text = ModelText(2000);
+    const string stored = text.substr(0, 60000);
+    for (const auto &[expected, deflated] : vector<pair<string, vector<uint8_t>>>{{text, Deflate(text)}, {stored, DeflateStored(stored)}})
+    {
+        const vector<uint8_t> zlib = Zlib(expected, deflated);
+        ASSERT_EQ(IfcCompressedFile::IsCompressed(zlib.data(), zlib.size()), true);
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(zlib.data(), zlib.size()), true);
+        ASSERT_EQ(ReadAll(file, 777) == expected, true);
+        ASSERT_EQ(file.IsCorrupt(), false);
+    }
+}
+
+TEST(InflateZipRoundTrip)
+{
+    // the first .ifc entry is read, whatever comes before it
+    const string text = ModelText(500);
+    for (bool deflated : {false, true})
+    {
+        const vector<uint8_t> zip = Zip({{"readme.txt", "not the model", true}, {"Model.IFC", text, deflated}});
+        ASSERT_EQ(IfcCompressedFile::IsCompressed(zip.data(), zip.size()), true);
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(zip.data(), zip.size()), true);
+        ASSERT_EQ(ReadAll(file) == text, true);
+        ASSERT_EQ(file.IsCorrupt(), false);
+    }
+}
+
+TEST(InflateRereadsFromCheckpoints)
+{
+    // past several checkpoints, so reads behind the kept bytes inflate again from one of them
+    const string text = ModelText(300000);
+    const vector<uint8_t> gzip = Gzip(text);
+    IfcCompressedFile file;
+    ASSERT_EQ(file.Open(gzip.data(), gzip.size()), true);
+    ASSERT_EQ(ReadAll(file, 64 * 1024) == text, true);
+    for (size_t offset : {size_t(10), text.size() / 2, text.size() - 100})
+    {
+        char buffer[100];
+        ASSERT_EQ(file.Read(buffer, offset, sizeof(buffer)), 100u);
+        ASSERT_EQ(string(buffer, sizeof(buffer)) == text.substr(offset, sizeof(buffer)), true);
+    }
+    ASSERT_EQ(ReadAll(file, 64 * 1024) == text, true);
+    ASSERT_EQ(file.IsCorrupt(), false);
+}
+
+TEST(TruncatedStreamsFailCleanly)
+{
+    const string text = ModelText(100);
+    for (const auto &bytes : {Gzip(text), Zlib(text, Deflate(text)), Zip({{"m.ifc", text, true}}), Zip({{"m.ifc", text, false}})})
+    {
+        for (size_t size = 0; size < bytes.size(); size++)
+        {
+            const vector<uint8_t> truncated(bytes.begin(), bytes.begin() + size);
+            IfcCompressedFile file;
+            if (!file.Open(truncated.data(), truncated.size())) continue;
+            const string read = ReadAll(file);
+            ASSERT_EQ(read.size() <= text.size(), true);
+            ASSERT_EQ(file.IsCorrupt(), true);
+        }
+    }
+}
+
+TEST(CorruptHuffmanTablesFailCleanly)
+{
+    vector<vector<uint8_t>> streams;
+    {
+        // the code length code gives all 19 symbols a length of one bit, more codes than one bit has
+        BitWriter writer;
+        writer.Put(1, 1);
+        writer.Put(2, 2);
+        writer.Put(0, 5);
+        writer.Put(0, 5);
+        writer.Put(15, 4);
+        for (int i = 0; i < 19; i++) writer.Put(1, 3);
+        writer.Put(0, 32);
+        streams.push_back(writer.bytes);
+    }
+    {
+        // the reserved block type
+        BitWriter writer;
+        writer.Put(1, 1);
+        writer.Put(3, 2);
+        writer.Put(0, 32);
+        streams.push_back(writer.bytes);
+    }
+    {
+        // a back reference before the first byte
+        BitWriter writer;
+        writer.Put(1, 1);
+        writer.Put(1, 2);
+        PutFixedMatch(writer, 3, 1);
+        PutFixedLiteral(writer, 256);
+        writer.Align();
+        streams.push_back(writer.bytes);
+    }
+    {
+        // the length of a stored block does not match its complement
+        vector<uint8_t> stored = DeflateStored("abc");
+        stored[3] ^= 1;
+        streams.push_back(stored);
+    }
+    for (const auto &deflated : streams)
+    {
+        const vector<uint8_t> zlib = Zlib("", deflated);
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(zlib.data(), zlib.size()), true);
+        char buffer[16];
+        ASSERT_EQ(file.Read(buffer, 0, sizeof(buffer)), 0u);
+        ASSERT_EQ(file.IsCorrupt(), true);
+    }
+}
+
+TEST(WrongChecksumsFailCleanly)
+{
+    const string text = ModelText(100);
+    vector<vector<uint8_t>> streams;
+    vector<uint8_t> gzip = Gzip(text);
+    // the CRC32 and the size at the end of the gzip stream
+    gzip[gzip.size() - 8] ^= 1;
+    streams.push_back(gzip);
+    gzip = Gzip(text);
+    gzip[gzip.size() - 1] ^= 1;
+    streams.push_back(gzip);
+    vector<uint8_t> zlib = Zlib(text, Deflate(text));
+    zlib.back() ^= 1;
+    streams.push_back(zlib);
+    // the CRC32 of the local header
+    vector<uint8_t> zip = Zip({{"m.ifc", text, true}});
+    zip[14] ^= 1;
+    streams.push_back(zip);
+    for (const auto &bytes : streams)
+    {
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(bytes.data(), bytes.size()), true);
+        ReadAll(file);
+        ASSERT_EQ(file.IsCorrupt(), true);
+    }
+}
+
+TEST(ZipEntriesPastTheBufferFailCleanly)
+{
+    const string text = ModelText(100);
+    {
+        // a stored entry larger than what follows its header
+        vector<uint8_t> zip = Zip({{"m.ifc", text, false}});
+        zip.resize(zip.size() - 10);
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(zip.data(), zip.size()), false);
+    }
+    {
+        // a name running past the end
+        vector<uint8_t> zip = Zip({{"m.ifc", text, false}});
+        zip[26] = 0xff;
+        zip[27] = 0xff;
+        zip.resize(100);
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(zip.data(), zip.size()), false);
+    }
+    {
+        // the compressed size of the first entry points past the end, the entry itself is cut off
+        vector<uint8_t> zip = Zip({{"a.txt", text, true}, {"m.ifc", text, true}});
+        zip[18] = 0xff;
+        zip[19] = 0xff;
+        zip[20] = 0xff;
+        zip.resize(200);
+        IfcCompressedFile file;
+        ASSERT_EQ(file.Open(zip.data(), zip.size()), true);
+        ASSERT_EQ(ReadAll(file).size() <= text.size(), true);
+        ASSERT_EQ(file.IsCorrupt(), true);
+    }
+}
+
+TEST(RandomCorruptionFailsCleanly)
+{
+    const string text = ModelText(200);
+    const vector<uint8_t> gzip = Gzip(text);
+    uint32_t state = 12345;
+    auto next = [&]() { return state = state * 1664525u + 1013904223u; };
+    for (int i = 0; i < 2000; i++)
+    {
+        vector<uint8_t> corrupt = gzip;
+        for (uint32_t flips = 1 + next() % 4; flips > 0; flips--)
+        {
+            // past the header, which fails by itself
+            corrupt[16 + next() % (corrupt.size() - 16)] ^= static_cast<uint8_t>(1 + next() % 255);
+        }
+        ASSERT_EQ(FailsCleanly(corrupt, text), true);
+    }
+}
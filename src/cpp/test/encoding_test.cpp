@@ -2,6 +2,8 @@
 
 namespace webifc::parsing {
     std::string p21decode(std::string_view & str);
+    std::string_view p21decode(std::string_view str, std::string &buffer);
+    void p21encode(std::string_view input, std::string &output);
 }
 
 using namespace std;
@@ -55,3 +57,124 @@ TEST(EscapePTest)
     auto str = webifc::parsing::p21decode(strIn);
     ASSERT_EQ(str, "Њет");
 }
+
+TEST(DecodePlainStringTest)
+{
+    // strings without escapes are returned as they are, the bytes of UTF-8 included
+    string_view strIn = "Basic Wall:Generic - 200mm, Ärger"sv;
+    string buffer;
+    auto str = webifc::parsing::p21decode(strIn, buffer);
+    ASSERT_EQ(str.data() == strIn.data(), true);
+    ASSERT_EQ(str, strIn);
+
+    strIn = "it''s \\X\\A7 4.1 and more text past sixteen bytes"sv;
+    str = webifc::parsing::p21decode(strIn, buffer);
+    ASSERT_EQ(str.data() == buffer.data(), true);
+    ASSERT_EQ(str, "it's § 4.1 and more text past sixteen bytes");
+}
+
+TEST(EncodeTest)
+{
+    string encoded;
+    webifc::parsing::p21encode("a plain name longer than a vector"sv, encoded);
+    ASSERT_EQ(encoded, "a plain name longer than a vector");
+
+    encoded.clear();
+    webifc::parsing::p21encode("it's π"sv, encoded);
+    ASSERT_EQ(encoded, "it''s \\X2\\03C0\\X0\\");
+}
+
+namespace webifc::parsing {
+    std::string compressIfcGuid(const std::string& guid);
+    bool decodeIfcGuid(const std::string_view &guid, uint64_t &high, uint64_t &low);
+}
+
+TEST(DecodeIfcGuid)
+{
+    uint64_t high = 1, low = 1;
+    ASSERT_EQ(webifc::parsing::decodeIfcGuid(webifc::parsing::compressIfcGuid("00000000-0000-0000-0000-000000000001"), high, low), true);
+    ASSERT_EQ(high, 0ull);
+    ASSERT_EQ(low, 1ull);
+
+    ASSERT_EQ(webifc::parsing::decodeIfcGuid(webifc::parsing::compressIfcGuid("FEDCBA98-7654-3210-0123-456789ABCDEF"), high, low), true);
+    ASSERT_EQ(high, 0xFEDCBA9876543210ull);
+    ASSERT_EQ(low, 0x0123456789ABCDEFull);
+
+    // too short, not in the alphabet and above 128 bits
+    ASSERT_EQ(webifc::parsing::decodeIfcGuid("0000000000000000000000"sv.substr(1), high, low), false);
+    ASSERT_EQ(webifc::parsing::decodeIfcGuid("000000000000000000000-"sv, high, low), false);
+    ASSERT_EQ(webifc::parsing::decodeIfcGuid("4000000000000000000000"sv, high, low), false);
+}
+
+#include "../web-ifc/utility/shared_pages.h"
+
+TEST(SharedPagesCopyOnWrite)
+{
+    webifc::utility::SharedPages<uint32_t, 2> pages;
+    pages.resize(6, 7);
+    pages.Mutable(1) = 1;
+    auto copy = pages;
+    copy.Mutable(5) = 5;
+    copy.push_back(8);
+    ASSERT_EQ(pages[5], 7u);
+    ASSERT_EQ(pages.size(), 6u);
+    ASSERT_EQ(copy[1], 1u);
+    ASSERT_EQ(copy[5], 5u);
+    ASSERT_EQ(copy[6], 8u);
+
+    // values past a shrink are filled in again when the array grows
+    copy.resize(2, 0);
+    copy.resize(4, 3);
+    ASSERT_EQ(copy[1], 1u);
+    ASSERT_EQ(copy[2], 3u);
+    ASSERT_EQ(copy[3], 3u);
+    ASSERT_EQ(pages[2], 7u);
+}
+
+#include "../web-ifc/utility/scratch.h"
+
+TEST(ScratchVectorReuse)
+{
+    const uint32_t *buffer = nullptr;
+    {
+        webifc::utility::ScratchVector<uint32_t> outer;
+        outer->resize(64, 1);
+        buffer = outer->data();
+        {
+            // a nested lease gets a vector of its own
+            webifc::utility::ScratchVector<uint32_t> inner;
+            ASSERT_EQ(inner->size(), 0u);
+            inner->push_back(2);
+            ASSERT_EQ((*outer)[0], 1u);
+        }
+    }
+    webifc::utility::ScratchVector<uint32_t> again;
+    ASSERT_EQ(again->size(), 0u);
+    ASSERT_EQ(again->capacity() >= 64, true);
+    ASSERT_EQ(again->data() == buffer, true);
+}
+
+#include "../web-ifc/parsing/IfcTokenCursor.h"
+
+TEST(TokenCursorStopsAtSplitTokens)
+{
+    using webifc::parsing::IfcTokenType;
+    std::vector<uint8_t> tape = {IfcTokenType::SET_BEGIN, IfcTokenType::REF, 7, 0, 0, 0, IfcTokenType::STRING, 2, 0, 'a', 'b', IfcTokenType::SET_END};
+    webifc::parsing::IfcToken token;
+    webifc::parsing::IfcTokenCursor cursor(tape.data(), tape.size());
+    ASSERT_EQ(cursor.Next(token), true);
+    ASSERT_EQ(cursor.Next(token), true);
+    ASSERT_EQ(token.ref, 7u);
+    ASSERT_EQ(cursor.Next(token), true);
+    ASSERT_EQ(token.Text(), "ab");
+    ASSERT_EQ(cursor.Next(token), true);
+    ASSERT_EQ(token.type == IfcTokenType::SET_END, true);
+    ASSERT_EQ(cursor.Next(token), false);
+
+    // a token cut off by the end of the range is left for the next one
+    webifc::parsing::IfcTokenCursor cut(tape.data(), 10);
+    ASSERT_EQ(cut.Next(token), true);
+    ASSERT_EQ(cut.Next(token), true);
+    ASSERT_EQ(cut.Next(token), false);
+    ASSERT_EQ(cut.Position(), 6u);
+}
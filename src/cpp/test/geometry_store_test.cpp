@@ -0,0 +1,130 @@
+#include "TinyCppTest.hpp"
+
+#include <cstdint>
+#include "../web-ifc/geometry/IfcGeometryStore.h"
+
+using namespace std;
+using webifc::geometry::IfcGeometry;
+using webifc::geometry::IfcGeometryStore;
+
+namespace
+{
+    const size_t GEOMETRY_BYTES = IfcGeometry().GetMemorySize();
+
+    bool Has(const IfcGeometryStore &store, uint32_t expressID)
+    {
+        return store.find(expressID) != store.end();
+    }
+}
+
+TEST(TrimDropsTheLeastRecentlyUsed)
+{
+    IfcGeometryStore store;
+    // tracking starts with the first Trim
+    store.Trim(SIZE_MAX);
+    store[1] = IfcGeometry();
+    store[2] = IfcGeometry();
+    store[3] = IfcGeometry();
+    store[1];
+    store.Trim(SIZE_MAX);
+    ASSERT_EQ(store.GetMemorySize(), 3 * GEOMETRY_BYTES);
+    store.Trim(2 * GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), true);
+    ASSERT_EQ(Has(store, 2), false);
+    ASSERT_EQ(Has(store, 3), true);
+    ASSERT_EQ(store.GetMemorySize(), 2 * GEOMETRY_BYTES);
+}
+
+TEST(TrimKeepsReusedGeometriesLonger)
+{
+    IfcGeometryStore store;
+    store.Trim(SIZE_MAX);
+    store[1] = IfcGeometry();
+    store[2] = IfcGeometry();
+    store.Reuse(1);
+    store.Reuse(1);
+    store[3] = IfcGeometry();
+    store[2];
+    store[3];
+    // 1 is the least recently used, but each of its reuses buys it a round
+    store.Trim(2 * GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), true);
+    ASSERT_EQ(Has(store, 2), false);
+    ASSERT_EQ(Has(store, 3), true);
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), true);
+    ASSERT_EQ(Has(store, 3), false);
+    ASSERT_EQ(store.GetMemorySize(), GEOMETRY_BYTES);
+    // every round halves the reuses, 1 has one left
+    store[4] = IfcGeometry();
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), true);
+    ASSERT_EQ(Has(store, 4), false);
+    store[5] = IfcGeometry();
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), false);
+    ASSERT_EQ(Has(store, 5), true);
+    ASSERT_EQ(store.size(), size_t(1));
+}
+
+TEST(RemoveDropsTheBookkeeping)
+{
+    IfcGeometryStore store;
+    store.Trim(SIZE_MAX);
+    store[1] = IfcGeometry();
+    store[2] = IfcGeometry();
+    store.Reuse(2);
+    store.Trim(SIZE_MAX);
+    store.Remove(2);
+    ASSERT_EQ(store.GetMemorySize(), GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 2), false);
+    // meshed again, it counts once and starts without reuses
+    store[2] = IfcGeometry();
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), false);
+    ASSERT_EQ(Has(store, 2), true);
+    ASSERT_EQ(store.GetMemorySize(), GEOMETRY_BYTES);
+    store.clear();
+    ASSERT_EQ(store.size(), size_t(0));
+    ASSERT_EQ(store.GetMemorySize(), size_t(0));
+}
+
+TEST(CopiesStartTheBookkeepingOver)
+{
+    IfcGeometryStore store;
+    store.Trim(SIZE_MAX);
+    store[1] = IfcGeometry();
+    store[2] = IfcGeometry();
+    IfcGeometryStore copy(store);
+    ASSERT_EQ(copy.size(), size_t(2));
+    ASSERT_EQ(copy.GetMemorySize(), size_t(0));
+    copy.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(copy.size(), size_t(1));
+    ASSERT_EQ(store.size(), size_t(2));
+}
+
+TEST(TrimLeavesKeptGeometries)
+{
+    IfcGeometryStore store;
+    store.Trim(SIZE_MAX);
+    store[1] = IfcGeometry();
+    store.Keep(1);
+    // used after the kept one, as the intermediates of later elements are
+    store[2] = IfcGeometry();
+    store[3] = IfcGeometry();
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), true);
+    ASSERT_EQ(Has(store, 2), false);
+    ASSERT_EQ(Has(store, 3), false);
+    // the memory is still counted, the kept geometry goes once released
+    ASSERT_EQ(store.GetMemorySize(), GEOMETRY_BYTES);
+    store[4] = IfcGeometry();
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), true);
+    ASSERT_EQ(Has(store, 4), false);
+    store.ReleaseKept();
+    store[5] = IfcGeometry();
+    store.Trim(GEOMETRY_BYTES);
+    ASSERT_EQ(Has(store, 1), false);
+    ASSERT_EQ(Has(store, 5), true);
+}
@@ -4,6 +4,8 @@
 
 #include "io_helpers.h"
 #include <fstream>
+#include <limits>
+#include <cstdlib>
 #include "../web-ifc/geometry/operations/boolean-utils/fuzzy-bools.h"
 #include "../web-ifc/geometry/representation/IfcGeometry.h"
 #include "../web-ifc/geometry/representation/geometry.h"
@@ -149,6 +151,8 @@ namespace webifc::io
     std::string ToObj(const webifc::geometry::IfcGeometry &geom, size_t &offset, glm::dmat4 transform, double inputScale)
     {
         std::stringstream obj;
+        // enough digits to read back the same doubles, boolean cases depend on them
+        obj.precision(std::numeric_limits<double>::max_digits10);
 
         double scale = inputScale;
 
@@ -216,6 +220,48 @@ namespace webifc::io
         out << ToObj(geom, offset, glm::dmat4(1), inputScale);
     }
 
+    bool ReadObj(const std::string &path, webifc::geometry::IfcGeometry &geom)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream tokens(line);
+            std::string kind;
+            tokens >> kind;
+            if (kind == "v")
+            {
+                glm::dvec3 point;
+                tokens >> point.x >> point.y >> point.z;
+                geom.AddPoint(point, glm::dvec3(0));
+            }
+            else if (kind == "f")
+            {
+                // vertex indices start at 1 and may be followed by /texture/normal
+                uint32_t indices[3];
+                for (auto &index : indices)
+                {
+                    std::string vertex;
+                    tokens >> vertex;
+                    index = static_cast<uint32_t>(std::strtoul(vertex.c_str(), nullptr, 10));
+                    if (index == 0 || index > geom.numPoints)
+                    {
+                        return false;
+                    }
+                    index--;
+                }
+                geom.AddFace(indices[0], indices[1], indices[2], UINT32_MAX);
+            }
+        }
+
+        return true;
+    }
+
     std::string ToObj(webifc::geometry::IfcGeometry &geom, size_t &offset, glm::dmat4 transform)
     {
         std::stringstream obj;
@@ -125,6 +125,9 @@ namespace webifc::io
     void DumpAlignment(std::vector<webifc::geometry::IfcAlignment> &align, std::string filenameV, std::string filenameH);
     void DumpCrossSections(std::vector<webifc::geometry::IfcCrossSections> &crossSection, std::string filename);
     void DumpIfcGeometryToPath(const webifc::geometry::IfcGeometry &geom, std::string path, double inputScale);
+    // the vertices and triangles of an obj file as DumpIfcGeometryToPath writes it, normals are left zero. False when the
+    // file cannot be read or a face refers to a missing vertex
+    bool ReadObj(const std::string &path, webifc::geometry::IfcGeometry &geom);
     std::string ToObj(webifc::geometry::IfcGeometry &geom, size_t &offset, glm::dmat4 transform = glm::dmat4(1));
     void DumpIfcGeometry(webifc::geometry::IfcGeometry &geom, std::string filename);
     void DumpFlatMesh(webifc::geometry::IfcFlatMesh &mesh, webifc::geometry::IfcGeometryProcessor &processor, std::string filename);
@@ -0,0 +1,423 @@
+#include "TinyCppTest.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../web-ifc/parsing/IfcLoader.h"
+#include "../web-ifc/schema/IfcSchemaManager.h"
+
+using namespace std;
+using webifc::parsing::IfcLoader;
+using webifc::parsing::IfcTokenType;
+
+namespace
+{
+    const webifc::schema::IfcSchemaManager schemaManager;
+
+    const string MODEL =
+        "ISO-10303-21;\n"
+        "HEADER;\n"
+        "FILE_DESCRIPTION(('ViewDefinition [CoordinationView]'),'2;1');\n"
+        "FILE_NAME('model.ifc','2024-01-01T00:00:00',(''),(''),'','','');\n"
+        "FILE_SCHEMA(('IFC4'));\n"
+        "ENDSEC;\n"
+        "DATA;\n"
+        "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+        "#2=IFCDIRECTION((0.,0.,1.));\n"
+        "#3=IFCAXIS2PLACEMENT3D(#1,#2,$);\n"
+        "#4=IFCLOCALPLACEMENT($,#3);\n"
+        "#5=IFCWALL('0000000000000000000001',$,'Wall \\X2\\03C0\\X0\\',$,$,#4,$,$,.STANDARD.);\n"
+        "#6=IFCWALL('0000000000000000000002',$,'Other wall',$,$,#4,$,$,*);\n"
+        "#7=IFCRELAGGREGATES('0000000000000000000003',$,$,$,#5,(#6));\n"
+        "#9=IFCPROPERTYSINGLEVALUE('Width',$,IFCLENGTHMEASURE(0.2),$);\n"
+        "#10=IFCCARTESIANPOINTLIST3D(((0.,0.,0.),(1.,0.,0.),(1.,1.,1.5E-3)));\n"
+        "ENDSEC;\n"
+        "END-ISO-10303-21;\n";
+
+    shared_ptr<const vector<uint8_t>> Bytes(const string &text)
+    {
+        return make_shared<const vector<uint8_t>>(text.begin(), text.end());
+    }
+
+    string SaveText(const IfcLoader &loader)
+    {
+        ostringstream output;
+        loader.SaveFile(output, true);
+        return output.str();
+    }
+
+    string TempPath(const string &name)
+    {
+        return (filesystem::temp_directory_path() / name).string();
+    }
+
+    void SaveTape(const IfcLoader &loader, const string &path)
+    {
+        ofstream output(path, ios::binary);
+        loader.SaveTape(output);
+    }
+
+    // writes the line the way WriteLine does, every argument is $, a reference or a set of references
+    void WriteLine(IfcLoader &loader, uint32_t expressID, const string &type, const vector<vector<uint32_t>> &arguments, bool set = false)
+    {
+        const uint32_t start = loader.GetTotalSize();
+        loader.Push<uint8_t>(IfcTokenType::REF);
+        loader.Push<uint32_t>(expressID);
+        loader.Push<uint8_t>(IfcTokenType::LABEL);
+        loader.Push<uint16_t>(type.size());
+        loader.Push((void *)type.data(), type.size());
+        loader.Push<uint8_t>(IfcTokenType::SET_BEGIN);
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            // the last argument of a relationship is a set even with one reference
+            const bool isSet = arguments[i].size() > 1 || (set && i + 1 == arguments.size());
+            if (arguments[i].empty()) loader.Push<uint8_t>(IfcTokenType::EMPTY);
+            if (isSet) loader.Push<uint8_t>(IfcTokenType::SET_BEGIN);
+            for (uint32_t ref : arguments[i])
+            {
+                loader.Push<uint8_t>(IfcTokenType::REF);
+                loader.Push<uint32_t>(ref);
+            }
+            if (isSet) loader.Push<uint8_t>(IfcTokenType::SET_END);
+        }
+        loader.Push<uint8_t>(IfcTokenType::SET_END);
+        loader.Push<uint8_t>(IfcTokenType::LINE_END);
+        loader.UpdateLineTape(expressID, schemaManager.IfcTypeToTypeCode(type), start);
+    }
+
+    // a model of many tape chunks with ';', quotes and comments in strings and between lines to cut it at
+    string LargeModel(uint32_t lines)
+    {
+        string model = MODEL.substr(0, MODEL.find("ENDSEC;\nEND"));
+        for (uint32_t expressID = 100; expressID < 100 + lines; expressID++)
+        {
+            const string id = to_string(expressID);
+            if (expressID % 7 == 0) model += "/* #" + id + "=IFCWALL('x;'); */\n";
+            // the comment goes on past the '/' that follows its opening '*'
+            if (expressID % 11 == 0) model += "/*/ #" + to_string(expressID + 100000) + "=IFCWALL('x;'); */\n";
+            model += "#" + id + "=IFCPROPERTYSINGLEVALUE('Name;" + id + "','it''s /* ; */ " + id + "',IFCLENGTHMEASURE(" + id + ".5E-2),#" + to_string(expressID - 1) + ");\n";
+        }
+        return model + "ENDSEC;\nEND-ISO-10303-21;\n";
+    }
+
+    // the tokens of the loaded file, the tape comes last in a snapshot
+    string Tape(const IfcLoader &loader)
+    {
+        ostringstream output;
+        loader.SaveTape(output);
+        const string snapshot = output.str();
+        return snapshot.substr(snapshot.size() - loader.GetTotalSize());
+    }
+
+    vector<pair<uint32_t, uint32_t>> Inverse(const IfcLoader &loader, uint32_t expressID)
+    {
+        vector<pair<uint32_t, uint32_t>> references;
+        for (const auto &reference : loader.GetInverseReferences(expressID)) references.push_back({reference.expressID, reference.argumentIndex});
+        sort(references.begin(), references.end());
+        return references;
+    }
+
+    // the inverse references kept up to date against those of the lines parsed again
+    bool InverseMatchesRescan(const IfcLoader &loader)
+    {
+        const string text = SaveText(loader);
+        IfcLoader rescanned(4096, 0, 10000, schemaManager);
+        rescanned.LoadFile(Bytes(text));
+        for (uint32_t expressID = 0; expressID <= loader.GetMaxExpressId() + 1; expressID++)
+        {
+            if (Inverse(loader, expressID) != Inverse(rescanned, expressID)) return false;
+        }
+        return true;
+    }
+}
+
+TEST(TapeRoundTrip)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    const auto data = Bytes(MODEL);
+    loader.LoadFile(data);
+    const string path = TempPath("web-ifc-test-round-trip.tape");
+    SaveTape(loader, path);
+
+    IfcLoader loaded(4096, 0, 10000, schemaManager);
+    ASSERT_EQ(loaded.LoadTape(path, IfcLoader::GetTapeSource(data->data(), data->size())), true);
+    ASSERT_EQ(loaded.GetMaxExpressId(), loader.GetMaxExpressId());
+    ASSERT_EQ(loaded.GetAllLines() == loader.GetAllLines(), true);
+    for (uint32_t expressID : loader.GetAllLines())
+    {
+        ASSERT_EQ(loaded.GetLineType(expressID), loader.GetLineType(expressID));
+        ASSERT_EQ(loaded.GetNoLineArguments(expressID), loader.GetNoLineArguments(expressID));
+    }
+    ASSERT_EQ(SaveText(loaded), SaveText(loader));
+    ASSERT_EQ(loaded.GetTapeHash(), loader.GetTapeHash());
+    filesystem::remove(path);
+}
+
+TEST(TapeRejectsOtherSources)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    const auto data = Bytes(MODEL);
+    loader.LoadFile(data);
+    const string path = TempPath("web-ifc-test-other-source.tape");
+    SaveTape(loader, path);
+
+    // the same file saved at another time, and one with a line more
+    string edited = MODEL;
+    edited.replace(edited.find("2024"), 4, "2025");
+    IfcLoader other(4096, 0, 10000, schemaManager);
+    ASSERT_EQ(other.LoadTape(path, IfcLoader::GetTapeSource(reinterpret_cast<const uint8_t *>(edited.data()), edited.size())), false);
+    edited = MODEL;
+    edited.insert(edited.find("ENDSEC;\nEND"), "#11=IFCDIRECTION((1.,0.,0.));\n");
+    ASSERT_EQ(other.LoadTape(path, IfcLoader::GetTapeSource(reinterpret_cast<const uint8_t *>(edited.data()), edited.size())), false);
+    ASSERT_EQ(other.GetAllLines().empty(), true);
+    filesystem::remove(path);
+
+    // a large file edited at its end without a change of size
+    const string large = LargeModel(10000);
+    IfcLoader largeLoader(4096, 0, 10000, schemaManager);
+    largeLoader.LoadFile(Bytes(large));
+    SaveTape(largeLoader, path);
+    edited = large;
+    const size_t last = edited.rfind("#10099=");
+    ASSERT_EQ(last > (1 << 16), true);
+    edited.replace(last + 1, 5, "10098");
+    ASSERT_EQ(other.LoadTape(path, IfcLoader::GetTapeSource(reinterpret_cast<const uint8_t *>(edited.data()), edited.size())), false);
+    ASSERT_EQ(other.LoadTape(path, IfcLoader::GetTapeSource(reinterpret_cast<const uint8_t *>(large.data()), large.size())), true);
+    // read through a callback the file is the same source
+    istringstream input(large);
+    IfcLoader streamed(4096, 0, 10000, schemaManager);
+    streamed.LoadFile(input);
+    ASSERT_EQ(streamed.GetLoadedTapeSource() == largeLoader.GetLoadedTapeSource(), true);
+    filesystem::remove(path);
+}
+
+TEST(TapeRejectsEditedTapes)
+{
+    const auto data = Bytes(MODEL);
+    const IfcLoader::TapeSource source = IfcLoader::GetTapeSource(data->data(), data->size());
+    const string path = TempPath("web-ifc-test-edited.tape");
+    for (bool removed : {false, true})
+    {
+        IfcLoader loader(4096, 0, 10000, schemaManager);
+        loader.LoadFile(data);
+        ASSERT_EQ(loader.GetLoadedTapeSource() == source, true);
+        ASSERT_EQ(loader.IsEdited(), false);
+        if (removed) loader.RemoveLine(6);
+        else WriteLine(loader, 7, "IFCRELAGGREGATES", {{}, {}, {}, {}, {6}, {5}}, true);
+        ASSERT_EQ(loader.GetLoadedTapeSource() == source, false);
+        ASSERT_EQ(loader.IsEdited(), true);
+        SaveTape(loader, path);
+        IfcLoader loaded(4096, 0, 10000, schemaManager);
+        ASSERT_EQ(loaded.LoadTape(path, source), false);
+        ASSERT_EQ(loaded.LoadTape(path, loader.GetLoadedTapeSource()), false);
+    }
+    filesystem::remove(path);
+}
+
+TEST(TapeRejectsOtherVersions)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    const auto data = Bytes(MODEL);
+    loader.LoadFile(data);
+    const IfcLoader::TapeSource source = IfcLoader::GetTapeSource(data->data(), data->size());
+    ostringstream output;
+    loader.SaveTape(output);
+    const string tape = output.str();
+
+    // the version follows the 8 bytes of the magic
+    const string path = TempPath("web-ifc-test-version.tape");
+    for (uint32_t version : {0u, 1u, 2u, 3u, 5u})
+    {
+        string patched = tape;
+        memcpy(patched.data() + 8, &version, sizeof(version));
+        ofstream(path, ios::binary) << patched;
+        IfcLoader loaded(4096, 0, 10000, schemaManager);
+        ASSERT_EQ(loaded.LoadTape(path, source), false);
+    }
+    string patched = tape;
+    patched[0] = 'X';
+    ofstream(path, ios::binary) << patched;
+    IfcLoader loaded(4096, 0, 10000, schemaManager);
+    ASSERT_EQ(loaded.LoadTape(path, source), false);
+    // cut off in the token chunks
+    ofstream(path, ios::binary) << tape.substr(0, tape.size() - 10);
+    ASSERT_EQ(loaded.LoadTape(path, source), false);
+    ofstream(path, ios::binary) << tape;
+    ASSERT_EQ(loaded.LoadTape(path, source), true);
+    filesystem::remove(path);
+}
+
+TEST(InverseReferencesFollowEdits)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    loader.LoadFile(Bytes(MODEL));
+    // the index is built before the edits
+    ASSERT_EQ(Inverse(loader, 4).size(), size_t(2));
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+
+    WriteLine(loader, 7, "IFCRELAGGREGATES", {{}, {}, {}, {}, {6}, {5, 1}}, true);
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    // written again, its references of the first edit go
+    WriteLine(loader, 7, "IFCRELAGGREGATES", {{}, {}, {}, {}, {5}, {6}}, true);
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    // a new line, then edited
+    WriteLine(loader, 11, "IFCRELAGGREGATES", {{}, {}, {}, {}, {6}, {4, 5}}, true);
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    WriteLine(loader, 11, "IFCRELAGGREGATES", {{}, {}, {}, {}, {3}, {4}}, true);
+    ASSERT_EQ(Inverse(loader, 4).size(), size_t(3));
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    // a parsed line, an edited one and a new one removed
+    loader.RemoveLine(6);
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    loader.RemoveLine(7);
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    loader.RemoveLine(11);
+    ASSERT_EQ(Inverse(loader, 4).size(), size_t(1));
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+    // and written back after removal
+    WriteLine(loader, 6, "IFCRELAGGREGATES", {{}, {}, {}, {}, {4}, {5}}, true);
+    ASSERT_EQ(InverseMatchesRescan(loader), true);
+}
+
+TEST(ArgumentOffsetsFollowEdits)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    loader.LoadFile(Bytes(MODEL));
+    const auto argumentIndexBytes = [](const IfcLoader &loaded)
+    {
+        webifc::utility::MemoryStats stats;
+        loaded.AddMemoryStats(stats);
+        return stats.argumentIndexBytes;
+    };
+    const auto relatingObject = [](const IfcLoader &loaded, uint32_t expressID)
+    {
+        loaded.MoveToArgumentOffset(expressID, 4);
+        return loaded.GetRefArgument();
+    };
+    // a line written and read in turn reuses the end of the index
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        WriteLine(loader, 7, "IFCRELAGGREGATES", {{}, {}, {}, {}, {5 + i % 2}, {6}}, true);
+        ASSERT_EQ(relatingObject(loader, 7), 5 + i % 2);
+    }
+    const uint64_t bytes = argumentIndexBytes(loader);
+    // with another line read after it the entries of the rewritten line are left behind, until the index is reset
+    for (uint32_t i = 0; i < 200000; i++)
+    {
+        WriteLine(loader, 7, "IFCRELAGGREGATES", {{}, {}, {}, {}, {5 + i % 2}, {6}}, true);
+        ASSERT_EQ(relatingObject(loader, 7), 5 + i % 2);
+        loader.MoveToArgumentOffset(5 + i % 2, 5);
+        ASSERT_EQ(loader.GetRefArgument(), uint32_t(4));
+    }
+    ASSERT_EQ(argumentIndexBytes(loader) <= bytes + 4 * sizeof(uint32_t) * (1 << 16), true);
+    // a removed line written back is indexed again
+    loader.RemoveLine(7);
+    WriteLine(loader, 7, "IFCRELAGGREGATES", {{}, {}, {}, {}, {6}, {5}}, true);
+    ASSERT_EQ(relatingObject(loader, 7), uint32_t(6));
+    loader.MoveToArgumentOffset(5, 5);
+    ASSERT_EQ(loader.GetRefArgument(), uint32_t(4));
+}
+
+TEST(ReadScopesIndexArgumentsOfTheirOwn)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    loader.LoadFile(Bytes(MODEL));
+    ASSERT_EQ(loader.PrepareConcurrentReads(), true);
+    const auto argumentIndexBytes = [&]()
+    {
+        webifc::utility::MemoryStats stats;
+        loader.AddMemoryStats(stats);
+        return stats.argumentIndexBytes;
+    };
+    const uint64_t bytes = argumentIndexBytes();
+    {
+        IfcLoader::ReadScope scope(loader);
+        // the second round reads what the scope indexed in the first
+        for (int round = 0; round < 2; round++)
+        {
+            loader.MoveToArgumentOffset(5, 5);
+            ASSERT_EQ(loader.GetRefArgument(), uint32_t(4));
+            loader.MoveToArgumentOffset(7, 4);
+            ASSERT_EQ(loader.GetRefArgument(), uint32_t(5));
+            loader.MoveToArgumentOffset(3, 1);
+            ASSERT_EQ(loader.GetRefArgument(), uint32_t(2));
+        }
+    }
+    ASSERT_EQ(argumentIndexBytes(), bytes);
+    loader.MoveToArgumentOffset(5, 5);
+    ASSERT_EQ(loader.GetRefArgument(), uint32_t(4));
+    ASSERT_EQ(argumentIndexBytes() > bytes, true);
+}
+
+TEST(SameContentFollowsReferences)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    loader.LoadFile(Bytes(MODEL));
+    ASSERT_EQ(loader.HasSameContent(3, 3), true);
+    ASSERT_EQ(loader.HasSameContent(1, 2), false);
+    // a copy of a line under another id, and copies that differ in what they reference
+    WriteLine(loader, 11, "IFCAXIS2PLACEMENT3D", {{1}, {2}, {}});
+    WriteLine(loader, 12, "IFCAXIS2PLACEMENT3D", {{2}, {2}, {}});
+    ASSERT_EQ(loader.HasSameContent(3, 11), true);
+    ASSERT_EQ(loader.HasSameContent(3, 12), false);
+    WriteLine(loader, 13, "IFCLOCALPLACEMENT", {{}, {11}});
+    WriteLine(loader, 14, "IFCLOCALPLACEMENT", {{}, {12}});
+    ASSERT_EQ(loader.HasSameContent(4, 13), true);
+    ASSERT_EQ(loader.HasSameContent(4, 14), false);
+    // an ignored argument is left out of the line itself only
+    WriteLine(loader, 15, "IFCLOCALPLACEMENT", {{13}, {11}});
+    ASSERT_EQ(loader.HasSameContent(4, 15), false);
+    ASSERT_EQ(loader.HasSameContent(4, 15, 0), true);
+    ASSERT_EQ(loader.HasSameContent(4, 14, 0), false);
+    ASSERT_EQ(loader.HasSameContent(5, 6), false);
+    // lines that reference each other
+    WriteLine(loader, 16, "IFCLOCALPLACEMENT", {{17}, {3}});
+    WriteLine(loader, 17, "IFCLOCALPLACEMENT", {{16}, {3}});
+    WriteLine(loader, 18, "IFCLOCALPLACEMENT", {{19}, {11}});
+    WriteLine(loader, 19, "IFCLOCALPLACEMENT", {{18}, {11}});
+    WriteLine(loader, 20, "IFCLOCALPLACEMENT", {{21}, {12}});
+    WriteLine(loader, 21, "IFCLOCALPLACEMENT", {{20}, {12}});
+    ASSERT_EQ(loader.HasSameContent(16, 18), true);
+    ASSERT_EQ(loader.HasSameContent(16, 20), false);
+}
+
+TEST(ParallelTokenizingMatchesSequential)
+{
+    const string model = LargeModel(3000);
+    const auto data = Bytes(model);
+    IfcLoader sequential(4096, 0, 10000, schemaManager);
+    sequential.SetTokenizerThreads(1);
+    sequential.LoadFile(data);
+    ASSERT_EQ(sequential.GetTotalSize() > 16 * 4096, true);
+    const string tape = Tape(sequential);
+    // tokenizing is sequential unless asked for
+    IfcLoader byDefault(4096, 0, 10000, schemaManager);
+    byDefault.LoadFile(data);
+    ASSERT_EQ(Tape(byDefault) == tape, true);
+    ASSERT_EQ(sequential.GetMaxExpressId(), uint32_t(3099));
+    for (size_t threads : {2, 3, 8})
+    {
+        IfcLoader parallel(4096, 0, 10000, schemaManager);
+        parallel.SetTokenizerThreads(threads);
+        parallel.LoadFile(data);
+        ASSERT_EQ(Tape(parallel) == tape, true);
+        ASSERT_EQ(parallel.GetAllLines() == sequential.GetAllLines(), true);
+        for (uint32_t expressID : sequential.GetAllLines())
+        {
+            ASSERT_EQ(parallel.GetLineType(expressID), sequential.GetLineType(expressID));
+        }
+        ASSERT_EQ(SaveText(parallel), SaveText(sequential));
+        // read from a stream, and with a memory limit that evicts and reloads chunks
+        istringstream input(model);
+        IfcLoader streamed(4096, 4 * 4096, 10000, schemaManager);
+        streamed.SetTokenizerThreads(threads);
+        streamed.LoadFile(input);
+        ASSERT_EQ(Tape(streamed) == tape, true);
+        ASSERT_EQ(SaveText(streamed), SaveText(sequential));
+    }
+}
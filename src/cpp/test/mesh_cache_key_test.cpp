@@ -0,0 +1,55 @@
+#include "TinyCppTest.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <vector>
+#include "../web-ifc/geometry/IfcGeometryProcessor.h"
+
+using namespace std;
+using webifc::geometry::GetMeshCacheKey;
+using webifc::geometry::IfcGeometrySettings;
+
+TEST(MeshCacheKeyChangesWithEverySetting)
+{
+    const IfcGeometrySettings defaults;
+    const glm::dmat4 identity(1);
+    const uint64_t key = GetMeshCacheKey(defaults, 1, identity);
+    ASSERT_EQ(GetMeshCacheKey(defaults, 1, identity), key);
+
+    const vector<function<void(IfcGeometrySettings &)>> changes = {
+        [](IfcGeometrySettings &settings) { settings._coordinateToOrigin = !settings._coordinateToOrigin; },
+        [](IfcGeometrySettings &settings) { settings._optimize_profiles = !settings._optimize_profiles; },
+        [](IfcGeometrySettings &settings) { settings._exportPolylines = !settings._exportPolylines; },
+        [](IfcGeometrySettings &settings) { settings._weldVertices = !settings._weldVertices; },
+        [](IfcGeometrySettings &settings) { settings._optimizeVertexCache = !settings._optimizeVertexCache; },
+        [](IfcGeometrySettings &settings) { settings._terrainChunkTriangles = 1000; },
+        [](IfcGeometrySettings &settings) { settings._circleSegments++; },
+        [](IfcGeometrySettings &settings) { settings.TOLERANCE_PLANE_INTERSECTION *= 2; },
+        [](IfcGeometrySettings &settings) { settings.TOLERANCE_PLANE_DEVIATION *= 2; },
+        [](IfcGeometrySettings &settings) { settings.TOLERANCE_BACK_DEVIATION_DISTANCE *= 2; },
+        [](IfcGeometrySettings &settings) { settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER *= 2; },
+        [](IfcGeometrySettings &settings) { settings.TOLERANCE_SCALAR_EQUALITY *= 2; },
+        [](IfcGeometrySettings &settings) { settings.PLANE_REFIT_ITERATIONS++; },
+        [](IfcGeometrySettings &settings) { settings._BOOLEAN_UNION_THRESHOLD++; },
+        [](IfcGeometrySettings &settings) { settings.CIRCLE_CHORD_TOLERANCE = 0.01; },
+    };
+    set<uint64_t> keys = {key};
+    for (const auto &change : changes)
+    {
+        IfcGeometrySettings settings = defaults;
+        change(settings);
+        ASSERT_EQ(keys.insert(GetMeshCacheKey(settings, 1, identity)).second, true);
+    }
+    // another model, and every element of the transformation
+    ASSERT_EQ(keys.insert(GetMeshCacheKey(defaults, 2, identity)).second, true);
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            glm::dmat4 transformation = identity;
+            transformation[i][j] += 0.5;
+            ASSERT_EQ(keys.insert(GetMeshCacheKey(defaults, 1, transformation)).second, true);
+        }
+    }
+}
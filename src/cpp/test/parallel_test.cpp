@@ -0,0 +1,85 @@
+#include "TinyCppTest.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "../web-ifc/utility/parallel.h"
+
+using namespace std;
+using webifc::utility::ParallelFor;
+using webifc::utility::ParallelPipeline;
+using webifc::utility::ParallelProduce;
+using webifc::utility::PerThread;
+
+TEST(PerThreadReusesTheValuesOfEndedThreads)
+{
+    PerThread<uint64_t> counts;
+    atomic<uint64_t> total = 0;
+    // every call starts new workers, they take over the values of the ones that ended
+    for (size_t run = 0; run < 200; run++)
+    {
+        ParallelFor(64, 4, [&](size_t)
+        {
+            counts.Get()++;
+            total++;
+        });
+        ParallelProduce(16, 3, 2, []() { return 0; }, [&](size_t)
+        {
+            counts.Get()++;
+            total++;
+            return 0;
+        }, [](int) {});
+    }
+    size_t values = 0;
+    uint64_t sum = 0;
+    counts.ForEach([&](uint64_t count)
+    {
+        values++;
+        sum += count;
+    });
+    ASSERT_EQ(values <= 8, true);
+    ASSERT_EQ(sum, total.load());
+}
+
+TEST(PerThreadClearsEveryValue)
+{
+    PerThread<uint64_t> counts;
+    ParallelFor(64, 4, [&](size_t) { counts.Get()++; });
+    counts.Clear();
+    uint64_t sum = 0;
+    counts.ForEach([&](uint64_t count) { sum += count; });
+    ASSERT_EQ(sum, uint64_t(0));
+    ASSERT_EQ(counts.Get(), uint64_t(0));
+}
+
+TEST(ParallelPipelineConsumesInReadOrder)
+{
+    for (size_t threads : {1, 2, 5})
+    {
+        const thread::id caller = this_thread::get_id();
+        size_t read = 0;
+        vector<size_t> consumed;
+        bool onCaller = true;
+        ParallelPipeline<pair<size_t, size_t>>(threads, 3, [&](pair<size_t, size_t> &item)
+        {
+            onCaller = onCaller && this_thread::get_id() == caller;
+            if (read == 500) return false;
+            item = {read++, 0};
+            return true;
+        }, [](pair<size_t, size_t> &item)
+        {
+            // later items tend to finish first
+            this_thread::sleep_for(chrono::microseconds(item.first % 7 == 0 ? 200 : 0));
+            item.second = item.first * 2;
+        }, [&](pair<size_t, size_t> &item)
+        {
+            onCaller = onCaller && this_thread::get_id() == caller;
+            ASSERT_EQ(item.second, item.first * 2);
+            consumed.push_back(item.first);
+        });
+        ASSERT_EQ(onCaller, true);
+        ASSERT_EQ(consumed.size(), size_t(500));
+        for (size_t i = 0; i < consumed.size(); i++) ASSERT_EQ(consumed[i], i);
+    }
+}
@@ -0,0 +1,62 @@
+#include "TinyCppTest.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../web-ifc/geometry/IfcGeometryProcessor.h"
+#include "../web-ifc/parsing/IfcLoader.h"
+#include "../web-ifc/schema/IfcSchemaManager.h"
+
+using namespace std;
+using webifc::geometry::IfcGeometryProcessor;
+using webifc::parsing::IfcLoader;
+
+namespace
+{
+    const webifc::schema::IfcSchemaManager schemaManager;
+
+    const string MODEL =
+        "ISO-10303-21;\n"
+        "HEADER;\n"
+        "FILE_DESCRIPTION(('ViewDefinition [CoordinationView]'),'2;1');\n"
+        "FILE_NAME('model.ifc','2024-01-01T00:00:00',(''),(''),'','','');\n"
+        "FILE_SCHEMA(('IFC4'));\n"
+        "ENDSEC;\n"
+        "DATA;\n"
+        "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+        "#2=IFCCARTESIANPOINT((1.,0.,0.));\n"
+        "#3=IFCCARTESIANPOINT((0.,0.,0.));\n"
+        "ENDSEC;\n"
+        "END-ISO-10303-21;\n";
+
+    // the sharing of geometries by content, reachable so that a collision of content hashes can be staged
+    class SharingProcessor : public IfcGeometryProcessor
+    {
+    public:
+        using IfcGeometryProcessor::IfcGeometryProcessor;
+        using IfcGeometryProcessor::GetSharedGeometry;
+        using IfcGeometryProcessor::ShareGeometry;
+    };
+}
+
+TEST(SharedGeometriesNeedTheSameContent)
+{
+    IfcLoader loader(4096, 0, 10000, schemaManager);
+    loader.LoadFile(make_shared<const vector<uint8_t>>(MODEL.begin(), MODEL.end()));
+    SharingProcessor processor(loader, schemaManager, 12, false, 1.0E-04, 1.0E-04, 1.0E-04, 1.0E-10, 1.0E-04, 1, 150);
+    processor.GetGeometry(1);
+    uint64_t hash = 0;
+    ASSERT_EQ(processor.GetSharedGeometry(1, UINT32_MAX, hash).has_value(), false);
+    processor.ShareGeometry(1, hash);
+    uint64_t sameHash = 0;
+    ASSERT_EQ(processor.GetSharedGeometry(3, UINT32_MAX, sameHash) == optional<uint32_t>(1), true);
+    ASSERT_EQ(sameHash, hash);
+    // #1 shared under the hash of #2 stands for two items of other content that hash alike
+    uint64_t otherHash = 0;
+    ASSERT_EQ(processor.GetSharedGeometry(2, UINT32_MAX, otherHash).has_value(), false);
+    ASSERT_EQ(otherHash != hash, true);
+    processor.ShareGeometry(1, otherHash);
+    ASSERT_EQ(processor.GetSharedGeometry(2, UINT32_MAX, otherHash).has_value(), false);
+}
@@ -0,0 +1,169 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// times the native pipeline stage by stage over a corpus of models and writes the results as JSON
+//
+//   web-ifc-bench [--warmup N] [--repeat N] [--out results.json] [files or directories...]
+//
+// directories are searched recursively for .ifc files, without any path tests/ifcfiles is used. Every repetition
+// loads the model into a new loader and meshes it with a new processor, so no cache carries over between runs
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../web-ifc/parsing/IfcLoader.h"
+#include "../web-ifc/schema/IfcSchemaManager.h"
+#include "../web-ifc/geometry/IfcGeometryProcessor.h"
+#include "../web-ifc/modelmanager/ModelManager.h"
+#include "../web-ifc/utility/timing.h"
+#include "bench_helpers.h"
+
+namespace
+{
+    using namespace webifc::bench;
+
+    struct ModelResult
+    {
+        std::string path;
+        uint64_t bytes = 0;
+        uint32_t lines = 0;
+        uint32_t elements = 0;
+        uint64_t triangles = 0;
+        uint64_t booleanCalls = 0;
+        // in the order they run, GetMesh includes the booleans
+        std::vector<Stage> stages = {{"tokenize"}, {"parseLines"}, {"geometryLoader"}, {"getMesh"}, {"booleans"}, {"flatten"}, {"total"}};
+    };
+
+    // one load and one full meshing of the model, the samples of every stage get one value each
+    void RunOnce(const webifc::manager::LoaderSettings &settings, const webifc::schema::IfcSchemaManager &schemaManager, const std::shared_ptr<const std::vector<uint8_t>> &data, ModelResult &result)
+    {
+        const uint64_t start = webifc::utility::NowNanoseconds();
+
+        webifc::parsing::IfcLoader loader(settings.TAPE_SIZE, settings.MEMORY_LIMIT, settings.LINEWRITER_BUFFER, schemaManager, settings.BINARY_NUMBERS);
+        loader.LoadFile(data);
+        const auto loadTimes = loader.GetLoadTimes();
+
+        const uint64_t processorStart = webifc::utility::NowNanoseconds();
+        webifc::geometry::IfcGeometryProcessor processor(loader, schemaManager, settings.CIRCLE_SEGMENTS, settings.COORDINATE_TO_ORIGIN, settings.TOLERANCE_PLANE_INTERSECTION, settings.TOLERANCE_PLANE_DEVIATION, settings.TOLERANCE_BACK_DEVIATION_DISTANCE, settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER, settings.TOLERANCE_SCALAR_EQUALITY, settings.PLANE_REFIT_ITERATIONS, settings.BOOLEAN_UNION_THRESHOLD);
+        const uint64_t processorEnd = webifc::utility::NowNanoseconds();
+
+        uint32_t elements = 0;
+        uint64_t triangles = 0;
+        for (uint32_t type : schemaManager.GetIfcElementList())
+        {
+            for (uint32_t expressID : loader.GetExpressIDsWithType(type))
+            {
+                auto flatMesh = processor.GetFlatMesh(expressID);
+                for (const auto &placedGeometry : flatMesh.geometries)
+                {
+                    triangles += processor.GetGeometry(placedGeometry.geometryExpressID).numFaces;
+                }
+                elements++;
+            }
+        }
+        const uint64_t end = webifc::utility::NowNanoseconds();
+        const auto meshingTimes = processor.GetMeshingTimes();
+
+        result.lines = loader.GetAllLines().size();
+        result.elements = elements;
+        result.triangles = triangles;
+        result.booleanCalls = meshingTimes.booleanCalls;
+        const double meshing = Seconds(processorEnd, end);
+        const double values[] = {loadTimes.tokenize, loadTimes.parse, Seconds(processorStart, processorEnd), meshing - meshingTimes.flatten, meshingTimes.booleans, meshingTimes.flatten, Seconds(start, end)};
+        for (size_t i = 0; i < result.stages.size(); i++) result.stages[i].samples.push_back(values[i]);
+    }
+
+    void WriteResults(std::ostream &out, const std::vector<ModelResult> &results, uint32_t warmup, uint32_t repeat)
+    {
+        out.precision(9);
+        out << "{\n  \"unit\": \"seconds\",\n  \"warmup\": " << warmup << ",\n  \"repeat\": " << repeat << ",\n  \"models\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const auto &result = results[i];
+            out << (i > 0 ? "," : "") << "\n    {\n      \"path\": \"" << Escape(result.path) << "\",\n      \"bytes\": " << result.bytes << ",\n      \"lines\": " << result.lines << ",\n      \"elements\": " << result.elements << ",\n      \"triangles\": " << result.triangles << ",\n      \"booleanCalls\": " << result.booleanCalls << ",\n      \"stages\": {";
+            for (size_t j = 0; j < result.stages.size(); j++)
+            {
+                out << (j > 0 ? "," : "") << "\n        ";
+                WriteStage(out, result.stages[j]);
+            }
+            out << "\n      }\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t warmup = 1;
+    uint32_t repeat = 5;
+    std::string outPath;
+    std::vector<std::filesystem::path> inputs;
+    for (int argi = 1; argi < argc; argi++)
+    {
+        const std::string arg = argv[argi];
+        if (arg == "--warmup" && ReadCount(argi, argc, argv, warmup)) continue;
+        if (arg == "--repeat" && ReadCount(argi, argc, argv, repeat) && repeat > 0) continue;
+        if (arg == "--out" && argi + 1 < argc)
+        {
+            outPath = argv[++argi];
+            continue;
+        }
+        if (arg.starts_with("--"))
+        {
+            std::cerr << "usage: web-ifc-bench [--warmup N] [--repeat N] [--out results.json] [files or directories...]" << std::endl;
+            return 1;
+        }
+        inputs.push_back(arg);
+    }
+    if (inputs.empty()) inputs.push_back("tests/ifcfiles");
+
+    std::vector<std::filesystem::path> models;
+    for (const auto &input : inputs) CollectModels(input, models);
+    std::sort(models.begin(), models.end());
+    if (models.empty())
+    {
+        std::cerr << "no models found" << std::endl;
+        return 1;
+    }
+
+    webifc::manager::LoaderSettings settings;
+    webifc::schema::IfcSchemaManager schemaManager;
+    std::vector<ModelResult> results;
+    for (const auto &path : models)
+    {
+        auto data = ReadModel(path);
+        if (!data)
+        {
+            std::cerr << "skipping " << path.string() << ", could not be read" << std::endl;
+            continue;
+        }
+        std::cerr << path.string() << std::endl;
+
+        ModelResult result;
+        result.path = path.generic_string();
+        result.bytes = data->size();
+        for (uint32_t i = 0; i < warmup; i++)
+        {
+            ModelResult discarded;
+            RunOnce(settings, schemaManager, data, discarded);
+        }
+        for (uint32_t i = 0; i < repeat; i++) RunOnce(settings, schemaManager, data, result);
+        results.push_back(std::move(result));
+    }
+
+    if (outPath.empty())
+    {
+        WriteResults(std::cout, results, warmup, repeat);
+        return 0;
+    }
+    std::ofstream out(outPath);
+    WriteResults(out, results, warmup, repeat);
+    return out ? 0 : 1;
+}
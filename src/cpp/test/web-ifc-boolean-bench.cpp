@@ -0,0 +1,349 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// a micro benchmark of the boolean engine over a corpus of boolean cases, a case being the operands of one BoolProcess
+// call as obj files
+//
+//   web-ifc-boolean-bench extract [--limit N] <corpus directory> [files or directories...]
+//   web-ifc-boolean-bench run [--warmup N] [--repeat N] [--out results.json] <corpus directory>
+//
+// extract meshes the models and writes the booleans they run into the corpus, one directory per case, sorted into the
+// categories openings (a difference with many cutters), curved (a cutter with many faces), union, halfspace and clip.
+// run times the cases one by one and reports the time, the triangles of the result and whether it failed, that is came
+// out empty or with vertices that are not finite
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "io_helpers.h"
+#include "bench_helpers.h"
+#include "../web-ifc/parsing/IfcLoader.h"
+#include "../web-ifc/schema/IfcSchemaManager.h"
+#include "../web-ifc/geometry/IfcGeometryProcessor.h"
+#include "../web-ifc/geometry/operations/geometryutils.h"
+#include "../web-ifc/modelmanager/ModelManager.h"
+#include "../web-ifc/utility/timing.h"
+
+namespace
+{
+    using namespace webifc::bench;
+
+    // a difference with at least this many cutters is a wall with openings
+    constexpr size_t OPENINGS_CUTTERS = 4;
+    // a cutter with more faces than this is curved
+    constexpr uint32_t CURVED_FACES = 64;
+
+    struct BooleanCase
+    {
+        std::string name;
+        webifc::geometry::BooleanOperation op = webifc::geometry::BooleanOperation::DIFFERENCE;
+        bool hasOp = false;
+        std::string category;
+        std::vector<webifc::geometry::IfcGeometry> first;
+        std::vector<webifc::geometry::IfcGeometry> second;
+    };
+
+    struct CaseResult
+    {
+        std::string name;
+        std::string category;
+        uint64_t triangles = 0;
+        bool failed = false;
+        Stage time = {"time"};
+    };
+
+    std::string Categorize(const std::vector<webifc::geometry::IfcGeometry> &second, webifc::geometry::BooleanOperation op)
+    {
+        bool curved = false;
+        for (const auto &geom : second)
+        {
+            if (geom.halfSpace) return "halfspace";
+            curved |= geom.numFaces > CURVED_FACES;
+        }
+        if (op == webifc::geometry::BooleanOperation::UNION) return "union";
+        if (second.size() >= OPENINGS_CUTTERS) return "openings";
+        return curved ? "curved" : "clip";
+    }
+
+    void WriteVec(std::ostream &out, const glm::dvec3 &v)
+    {
+        out << " " << v.x << " " << v.y << " " << v.z;
+    }
+
+    // first_<i>.obj and second_<i>.obj with a case.txt naming the op, the category and the half spaces
+    void WriteCase(const std::filesystem::path &directory, const std::vector<webifc::geometry::IfcGeometry> &first, const std::vector<webifc::geometry::IfcGeometry> &second, webifc::geometry::BooleanOperation op)
+    {
+        std::filesystem::create_directories(directory);
+        std::ofstream info(directory / "case.txt");
+        info.precision(std::numeric_limits<double>::max_digits10);
+        info << "op " << webifc::geometry::GetBooleanOperationName(op) << "\ncategory " << Categorize(second, op) << "\n";
+        for (size_t i = 0; i < first.size(); i++)
+        {
+            webifc::io::DumpIfcGeometryToPath(first[i], (directory / ("first_" + std::to_string(i) + ".obj")).string(), 1);
+        }
+        for (size_t i = 0; i < second.size(); i++)
+        {
+            webifc::io::DumpIfcGeometryToPath(second[i], (directory / ("second_" + std::to_string(i) + ".obj")).string(), 1);
+            if (!second[i].halfSpace) continue;
+            info << "halfspace second_" << i;
+            WriteVec(info, second[i].halfSpaceOrigin);
+            WriteVec(info, second[i].halfSpaceX);
+            WriteVec(info, second[i].halfSpaceY);
+            WriteVec(info, second[i].halfSpaceZ);
+            info << "\n";
+        }
+    }
+
+    bool ReadCase(const std::filesystem::path &directory, BooleanCase &booleanCase)
+    {
+        std::ifstream info(directory / "case.txt");
+        if (!info) return false;
+        booleanCase.name = directory.filename().string();
+        std::map<std::string, webifc::geometry::IfcGeometry *> byName;
+        for (auto [prefix, operands] : {std::pair{"first_", &booleanCase.first}, std::pair{"second_", &booleanCase.second}})
+        {
+            for (size_t i = 0;; i++)
+            {
+                const std::string name = prefix + std::to_string(i);
+                const auto path = directory / (name + ".obj");
+                if (!std::filesystem::exists(path)) break;
+                webifc::geometry::IfcGeometry geom;
+                if (!webifc::io::ReadObj(path.string(), geom)) return false;
+                operands->push_back(std::move(geom));
+            }
+        }
+        for (size_t i = 0; i < booleanCase.second.size(); i++) byName["second_" + std::to_string(i)] = &booleanCase.second[i];
+
+        std::string line;
+        while (std::getline(info, line))
+        {
+            std::istringstream tokens(line);
+            std::string kind;
+            tokens >> kind;
+            if (kind == "op")
+            {
+                std::string op;
+                tokens >> op;
+                booleanCase.hasOp = webifc::geometry::ParseBooleanOperation(op, booleanCase.op);
+            }
+            else if (kind == "category") tokens >> booleanCase.category;
+            else if (kind == "halfspace")
+            {
+                std::string name;
+                tokens >> name;
+                auto it = byName.find(name);
+                if (it == byName.end()) return false;
+                auto &geom = *it->second;
+                geom.halfSpace = true;
+                for (auto *v : {&geom.halfSpaceOrigin, &geom.halfSpaceX, &geom.halfSpaceY, &geom.halfSpaceZ}) tokens >> v->x >> v->y >> v->z;
+                if (!tokens) return false;
+            }
+        }
+        return booleanCase.hasOp && !booleanCase.first.empty() && !booleanCase.second.empty();
+    }
+
+    bool IsFinite(const webifc::geometry::IfcGeometry &geom)
+    {
+        for (uint32_t i = 0; i < geom.numPoints; i++)
+        {
+            const glm::dvec3 point = geom.GetPoint(i);
+            if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) return false;
+        }
+        return true;
+    }
+
+    int Extract(const std::filesystem::path &corpus, const std::vector<std::filesystem::path> &models, const uint32_t limit)
+    {
+        webifc::manager::LoaderSettings settings;
+        webifc::schema::IfcSchemaManager schemaManager;
+        for (const auto &path : models)
+        {
+            auto data = ReadModel(path);
+            if (!data)
+            {
+                std::cerr << "skipping " << path.string() << ", could not be read" << std::endl;
+                continue;
+            }
+            std::cerr << path.string() << std::endl;
+
+            webifc::parsing::IfcLoader loader(settings.TAPE_SIZE, settings.MEMORY_LIMIT, settings.LINEWRITER_BUFFER, schemaManager, settings.BINARY_NUMBERS);
+            loader.LoadFile(data);
+            webifc::geometry::IfcGeometryProcessor processor(loader, schemaManager, settings.CIRCLE_SEGMENTS, settings.COORDINATE_TO_ORIGIN, settings.TOLERANCE_PLANE_INTERSECTION, settings.TOLERANCE_PLANE_DEVIATION, settings.TOLERANCE_BACK_DEVIATION_DISTANCE, settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER, settings.TOLERANCE_SCALAR_EQUALITY, settings.PLANE_REFIT_ITERATIONS, settings.BOOLEAN_UNION_THRESHOLD);
+
+            // unions of parallel fusing call in from several threads
+            std::mutex mutex;
+            std::atomic<uint32_t> written = 0;
+            const std::string stem = path.stem().string();
+            processor.SetBooleanObserver([&](const std::vector<webifc::geometry::IfcGeometry> &first, const std::vector<webifc::geometry::IfcGeometry> &second, webifc::geometry::BooleanOperation op)
+                                         {
+                const uint32_t index = written++;
+                if (limit != 0 && index >= limit) return;
+                std::lock_guard<std::mutex> lock(mutex);
+                WriteCase(corpus / (stem + "_" + std::to_string(index)), first, second, op); });
+
+            for (uint32_t type : schemaManager.GetIfcElementList())
+            {
+                for (uint32_t expressID : loader.GetExpressIDsWithType(type))
+                {
+                    processor.GetFlatMesh(expressID);
+                    if (limit != 0 && written >= limit) break;
+                }
+            }
+            std::cerr << (limit == 0 ? written.load() : std::min(written.load(), limit)) << " cases" << std::endl;
+        }
+        return 0;
+    }
+
+    void WriteResults(std::ostream &out, const std::vector<CaseResult> &results, uint32_t warmup, uint32_t repeat)
+    {
+        struct Rate
+        {
+            uint32_t cases = 0;
+            uint32_t failed = 0;
+        };
+        std::map<std::string, Rate> rates;
+        for (const auto &result : results)
+        {
+            rates[result.category].cases++;
+            rates[result.category].failed += result.failed;
+        }
+
+        out.precision(9);
+        out << "{\n  \"unit\": \"seconds\",\n  \"warmup\": " << warmup << ",\n  \"repeat\": " << repeat << ",\n  \"categories\": {";
+        bool first = true;
+        for (const auto &[category, rate] : rates)
+        {
+            out << (first ? "" : ",") << "\n    \"" << Escape(category) << "\": {\"cases\": " << rate.cases << ", \"failed\": " << rate.failed << ", \"failureRate\": " << static_cast<double>(rate.failed) / rate.cases << "}";
+            first = false;
+        }
+        out << "\n  },\n  \"cases\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const auto &result = results[i];
+            out << (i > 0 ? "," : "") << "\n    {\"name\": \"" << Escape(result.name) << "\", \"category\": \"" << Escape(result.category) << "\", \"triangles\": " << result.triangles << ", \"failed\": " << (result.failed ? "true" : "false") << ", ";
+            WriteStage(out, result.time);
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    int Run(const std::filesystem::path &corpus, const uint32_t warmup, const uint32_t repeat, const std::string &outPath)
+    {
+        std::vector<std::filesystem::path> directories;
+        if (std::filesystem::is_directory(corpus))
+        {
+            for (const auto &entry : std::filesystem::directory_iterator(corpus))
+            {
+                if (entry.is_directory()) directories.push_back(entry.path());
+            }
+        }
+        std::sort(directories.begin(), directories.end());
+        if (directories.empty())
+        {
+            std::cerr << "no cases found" << std::endl;
+            return 1;
+        }
+
+        const webifc::geometry::IfcGeometrySettings settings;
+        webifc::geometry::SetEpsilons(settings.TOLERANCE_SCALAR_EQUALITY, settings.PLANE_REFIT_ITERATIONS, settings._BOOLEAN_UNION_THRESHOLD);
+        webifc::geometry::booleanManager engine;
+        std::vector<CaseResult> results;
+        for (const auto &directory : directories)
+        {
+            BooleanCase booleanCase;
+            if (!ReadCase(directory, booleanCase))
+            {
+                std::cerr << "skipping " << directory.string() << ", not a valid case" << std::endl;
+                continue;
+            }
+
+            CaseResult result;
+            result.name = booleanCase.name;
+            result.category = booleanCase.category;
+            for (uint32_t i = 0; i < warmup + repeat; i++)
+            {
+                const uint64_t start = webifc::utility::NowNanoseconds();
+                webifc::geometry::IfcGeometry output = engine.BoolProcess(booleanCase.first, booleanCase.second, booleanCase.op, settings);
+                const uint64_t end = webifc::utility::NowNanoseconds();
+                if (i < warmup) continue;
+                result.time.samples.push_back(Seconds(start, end));
+                result.triangles = output.numFaces;
+                result.failed = output.numFaces == 0 || !IsFinite(output);
+            }
+            results.push_back(std::move(result));
+        }
+
+        if (outPath.empty())
+        {
+            WriteResults(std::cout, results, warmup, repeat);
+            return 0;
+        }
+        std::ofstream out(outPath);
+        WriteResults(out, results, warmup, repeat);
+        return out ? 0 : 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const std::string usage = "usage: web-ifc-boolean-bench extract [--limit N] <corpus> [files or directories...]\n"
+                              "       web-ifc-boolean-bench run [--warmup N] [--repeat N] [--out results.json] <corpus>";
+    if (argc < 2)
+    {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    const std::string mode = argv[1];
+    uint32_t limit = 0;
+    uint32_t warmup = 1;
+    uint32_t repeat = 5;
+    std::string outPath;
+    std::vector<std::filesystem::path> inputs;
+    for (int argi = 2; argi < argc; argi++)
+    {
+        const std::string arg = argv[argi];
+        if (mode == "extract" && arg == "--limit" && ReadCount(argi, argc, argv, limit)) continue;
+        if (mode == "run" && arg == "--warmup" && ReadCount(argi, argc, argv, warmup)) continue;
+        if (mode == "run" && arg == "--repeat" && ReadCount(argi, argc, argv, repeat) && repeat > 0) continue;
+        if (mode == "run" && arg == "--out" && argi + 1 < argc)
+        {
+            outPath = argv[++argi];
+            continue;
+        }
+        if (arg.starts_with("--"))
+        {
+            std::cerr << usage << std::endl;
+            return 1;
+        }
+        inputs.push_back(arg);
+    }
+
+    if (mode == "run" && inputs.size() == 1) return Run(inputs[0], warmup, repeat, outPath);
+    if (mode == "extract" && !inputs.empty())
+    {
+        std::vector<std::filesystem::path> models;
+        for (size_t i = 1; i < inputs.size(); i++) CollectModels(inputs[i], models);
+        if (inputs.size() == 1) CollectModels("tests/ifcfiles", models);
+        std::sort(models.begin(), models.end());
+        if (models.empty())
+        {
+            std::cerr << "no models found" << std::endl;
+            return 1;
+        }
+        return Extract(inputs[0], models, limit);
+    }
+    std::cerr << usage << std::endl;
+    return 1;
+}
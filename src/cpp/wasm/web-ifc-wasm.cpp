@@ -6,11 +6,27 @@
 #include <algorithm>
 #include <vector>
 #include <stack>
+#include <unordered_set>
+#include <unordered_map>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <limits>
+#include <cfloat>
+#include <cmath>
+#include <optional>
+#include <functional>
+#include <tuple>
 #include <emscripten/bind.h>
 #include <spdlog/spdlog.h>
 #include "../web-ifc/modelmanager/ModelManager.h"
+#include "../web-ifc/utility/parallel.h"
+#include "../web-ifc/utility/timing.h"
+#include "../web-ifc/utility/trace.h"
+#include "../web-ifc/geometry/IfcGlbWriter.h"
+#include "../web-ifc/geometry/IfcTileset.h"
+#include "../web-ifc/geometry/IfcClashDetector.h"
+#include "../web-ifc/parsing/IfcRelationshipIndex.h"
 #include "../version.h"
 #include "../web-ifc/geometry/operations/bim-geometry/extrusion.h"
 #include "../web-ifc/geometry/operations/bim-geometry/sweep.h"
@@ -24,6 +40,7 @@
 #include "../web-ifc/geometry/operations/bim-geometry/utils.h"
 #include "../web-ifc/geometry/operations/bim-geometry/boolean.h"
 #include "../web-ifc/geometry/operations/bim-geometry/profile.h"
+#include "../web-ifc/geometry/operations/bim-geometry/batch.h"
 
 namespace webifc::parsing
 {
@@ -39,6 +56,56 @@ constexpr bool MT_ENABLED = false;
 
 webifc::manager::ModelManager manager = new webifc::manager::ModelManager(MT_ENABLED);
 
+// a StreamAllMeshes that returns to the caller between elements, for the threads that must not block for long
+struct StreamSession
+{
+    uint32_t modelID;
+    std::vector<uint32_t> elements;
+    size_t next = 0;
+};
+
+std::unordered_map<uint32_t, StreamSession> streamSessions;
+uint32_t nextStreamSession = 0;
+
+void EndStreamsOfModel(uint32_t modelID)
+{
+    for (auto it = streamSessions.begin(); it != streamSessions.end();)
+        it = it->second.modelID == modelID ? streamSessions.erase(it) : std::next(it);
+}
+
+// a JS array or typed array of IDs copied in one go, typed arrays are copied without a call per element
+std::vector<uint32_t> ToIDVector(const emscripten::val &ids)
+{
+    return emscripten::convertJSArrayToNumberVector<uint32_t>(ids);
+}
+
+// a Uint32Array owning a copy of ids on the JS side
+emscripten::val ToUint32Array(const std::vector<uint32_t> &ids)
+{
+    return emscripten::val::global("Uint32Array").new_(emscripten::typed_memory_view(ids.size(), ids.data()));
+}
+
+// the type lists of the settings as plain arrays on the JS side
+emscripten::val GetIncludeTypes(const webifc::manager::LoaderSettings &settings)
+{
+    return ToUint32Array(settings.INCLUDE_TYPES);
+}
+
+void SetIncludeTypes(webifc::manager::LoaderSettings &settings, emscripten::val types)
+{
+    settings.INCLUDE_TYPES = types.isUndefined() || types.isNull() ? std::vector<uint32_t>() : ToIDVector(types);
+}
+
+emscripten::val GetExcludeTypes(const webifc::manager::LoaderSettings &settings)
+{
+    return ToUint32Array(settings.EXCLUDE_TYPES);
+}
+
+void SetExcludeTypes(webifc::manager::LoaderSettings &settings, emscripten::val types)
+{
+    settings.EXCLUDE_TYPES = types.isUndefined() || types.isNull() ? std::vector<uint32_t>() : ToIDVector(types);
+}
+
 int CreateModel(webifc::manager::LoaderSettings settings)
 {
     return manager.CreateModel(settings);
@@ -46,6 +113,7 @@ int CreateModel(webifc::manager::LoaderSettings settings)
 
 void CloseAllModels()
 {
+    streamSessions.clear();
     return manager.CloseAllModels();
 }
 
@@ -63,6 +131,49 @@ int OpenModel(webifc::manager::LoaderSettings settings, emscripten::val callback
     return modelID;
 }
 
+// every file is copied into wasm memory in one go and kept by its model, the files are then tokenized concurrently on the
+// thread pool of the mt build
+emscripten::val OpenModels(webifc::manager::LoaderSettings settings, emscripten::val dataSets)
+{
+    const uint32_t count = dataSets["length"].as<uint32_t>();
+    std::vector<std::shared_ptr<const std::vector<uint8_t>>> files(count);
+    for (uint32_t i = 0; i < count; i++)
+        files[i] = std::make_shared<const std::vector<uint8_t>>(emscripten::convertJSArrayToNumberVector<uint8_t>(dataSets[i]));
+    return ToUint32Array(manager.OpenModels(settings, files));
+}
+
+// a model holding only the header lines of the file, which is read up to the end of its HEADER section, modelID is -1
+// and the model closed when the section does not end
+emscripten::val ProbeModel(webifc::manager::LoaderSettings settings, emscripten::val callback, uint32_t fileSize)
+{
+    auto modelID = manager.CreateModel(settings);
+    const std::function<uint32_t(char *, size_t, size_t)> loaderFunc = [callback](char *dest, size_t sourceOffset, size_t destSize)
+    {
+        emscripten::val retVal = callback((uint32_t)dest, sourceOffset, destSize);
+        return retVal.as<uint32_t>();
+    };
+
+    auto result = emscripten::val::object();
+    const auto info = manager.GetIfcLoader(modelID)->LoadHeader(loaderFunc, fileSize);
+    if (!info)
+    {
+        manager.CloseModel(modelID);
+        result.set("modelID", -1);
+        return result;
+    }
+    result.set("modelID", modelID);
+    result.set("dataOffset", static_cast<double>(info->dataOffset));
+    result.set("estimatedLines", static_cast<double>(info->estimatedLines));
+    return result;
+}
+
+// a model sharing the loaded data of modelID with its own geometry, -1 when it cannot be attached
+int AttachModel(uint32_t modelID)
+{
+    const auto attached = manager.AttachModel(modelID);
+    return attached ? static_cast<int>(*attached) : -1;
+}
+
 void SaveModel(uint32_t modelID, emscripten::val callback)
 {
     if (!manager.IsModelOpen(modelID))
@@ -76,116 +187,1121 @@ int GetModelSize(uint32_t modelID)
     return manager.IsModelOpen(modelID) ? manager.GetIfcLoader(modelID)->GetTotalSize() : 0;
 }
 
+emscripten::val GetMemoryStats(uint32_t modelID)
+{
+    const auto stats = manager.GetMemoryStats(modelID);
+    auto result = emscripten::val::object();
+    result.set("loadedChunks", static_cast<double>(stats.loadedChunks));
+    result.set("evictedChunks", static_cast<double>(stats.evictedChunks));
+    result.set("loadedChunkBytes", static_cast<double>(stats.loadedChunkBytes));
+    result.set("evictedChunkBytes", static_cast<double>(stats.evictedChunkBytes));
+    result.set("fileBytes", static_cast<double>(stats.fileBytes));
+    result.set("lineTableBytes", static_cast<double>(stats.lineTableBytes));
+    result.set("typeIndexBytes", static_cast<double>(stats.typeIndexBytes));
+    result.set("argumentIndexBytes", static_cast<double>(stats.argumentIndexBytes));
+    result.set("inverseIndexBytes", static_cast<double>(stats.inverseIndexBytes));
+    result.set("globalIdIndexBytes", static_cast<double>(stats.globalIdIndexBytes));
+    result.set("placementBytes", static_cast<double>(stats.placementBytes));
+    result.set("pointBytes", static_cast<double>(stats.pointBytes));
+    result.set("curveBytes", static_cast<double>(stats.curveBytes));
+    result.set("profileBytes", static_cast<double>(stats.profileBytes));
+    result.set("relationBytes", static_cast<double>(stats.relationBytes));
+    result.set("geometryBytes", static_cast<double>(stats.geometryBytes));
+    result.set("totalBytes", static_cast<double>(stats.GetTotal()));
+    return result;
+}
+
 void CloseModel(uint32_t modelID)
 {
+    EndStreamsOfModel(modelID);
     return manager.CloseModel(modelID);
 }
 
+webifc::geometry::VertexFormat GetVertexFormat(uint32_t modelID)
+{
+    return static_cast<webifc::geometry::VertexFormat>(manager.GetSettings(modelID).VERTEX_FORMAT);
+}
+
 webifc::geometry::IfcFlatMesh GetFlatMesh(uint32_t modelID, uint32_t expressID)
 {
     if (!manager.IsModelOpen(modelID))
         return {};
     webifc::geometry::IfcFlatMesh mesh = manager.GetGeometryProcessor(modelID)->GetFlatMesh(expressID);
     for (auto &geom : mesh.geometries)
-        manager.GetGeometryProcessor(modelID)->GetGeometry(geom.geometryExpressID).GetVertexData();
+        manager.GetGeometryProcessor(modelID)->GetGeometry(geom.geometryExpressID).PrepareVertexData(GetVertexFormat(modelID));
+    return mesh;
+}
+
+webifc::geometry::IfcFlatMesh GetFlatMeshLOD(uint32_t modelID, uint32_t expressID, uint32_t lod)
+{
+    if (!manager.IsModelOpen(modelID))
+        return {};
+    webifc::geometry::IfcFlatMesh mesh = manager.GetGeometryProcessor(modelID)->GetFlatMeshLOD(expressID, lod);
+    for (auto &geom : mesh.geometries)
+        manager.GetGeometryProcessor(modelID)->GetGeometry(geom.geometryExpressID, lod).PrepareVertexData(GetVertexFormat(modelID));
     return mesh;
 }
 
-void StreamMeshes(uint32_t modelID, const std::vector<uint32_t> &expressIds, emscripten::val callback)
+// the elements outside [first, last] are skipped but still counted, so every mesh gets the index and total it would
+// get from the whole list
+void StreamMesh(webifc::geometry::IfcGeometryProcessor *geomLoader, webifc::geometry::VertexFormat vertexFormat, uint32_t expressID, int index, int total, emscripten::val &callback)
+{
+    // read the mesh from IFC
+    webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(expressID);
+
+    // prepare the geometry data
+    for (auto &geom : mesh.geometries)
+    {
+        auto &flatGeom = geomLoader->GetGeometry(geom.geometryExpressID);
+        flatGeom.PrepareVertexData(vertexFormat);
+    }
+
+    if (!mesh.geometries.empty())
+    {
+        // transfer control to client, geometry data is alive for the time of the callback
+        callback(mesh, index, total);
+    }
+
+    // the client is expected to have consumed the data, what later elements share is kept within a budget
+    geomLoader->TrimStreamingCaches();
+}
+
+void StreamMeshes(uint32_t modelID, const std::vector<uint32_t> &expressIds, emscripten::val callback, uint32_t first = 0, uint32_t last = UINT32_MAX)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
+    int index = 0;
+    int total = expressIds.size();
+
+    for (const auto &id : expressIds)
+    {
+        if (id >= first && id <= last)
+            StreamMesh(geomLoader, vertexFormat, id, index, total, callback);
+        index++;
+    }
+    geomLoader->Clear();
+}
+
+void StreamMeshesWithExpressID(uint32_t modelID, emscripten::val expressIdsVal, emscripten::val callback)
+{
+    StreamMeshes(modelID, ToIDVector(expressIdsVal), callback);
+}
+
+// buffers of the placed geometries of one element baked into world space, kept from element to element
+struct BakedMeshBuffers
+{
+    std::vector<std::vector<float>> vertexData;
+    std::vector<std::vector<uint32_t>> indexData;
+};
+
+// the flat mesh as { expressID, geometries: [{ geometryExpressID, color, vertexData, indexData }] } with the vertices
+// already transformed by their placement. With copy the arrays are the JS side's own, otherwise views into buffers
+// that stay valid until they are baked into again
+emscripten::val BakeFlatMesh(uint32_t modelID, const webifc::geometry::IfcFlatMesh &mesh, BakedMeshBuffers &buffers, bool copy)
+{
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    if (buffers.vertexData.size() < mesh.geometries.size())
+    {
+        buffers.vertexData.resize(mesh.geometries.size());
+        buffers.indexData.resize(mesh.geometries.size());
+    }
+    auto geometries = emscripten::val::array();
+    uint32_t baked = 0;
+    for (size_t i = 0; i < mesh.geometries.size(); i++)
+    {
+        auto &vertexData = buffers.vertexData[i];
+        auto &indexData = buffers.indexData[i];
+        if (!geomLoader->BakePlacedGeometry(mesh.geometries[i], vertexData, indexData))
+            continue;
+        auto geometry = emscripten::val::object();
+        geometry.set("geometryExpressID", mesh.geometries[i].geometryExpressID);
+        geometry.set("color", mesh.geometries[i].color);
+        emscripten::val vertices(emscripten::typed_memory_view(vertexData.size(), vertexData.data()));
+        emscripten::val indices(emscripten::typed_memory_view(indexData.size(), indexData.data()));
+        geometry.set("vertexData", copy ? emscripten::val::global("Float32Array").new_(vertices) : vertices);
+        geometry.set("indexData", copy ? emscripten::val::global("Uint32Array").new_(indices) : indices);
+        geometries.set(baked++, geometry);
+    }
+    auto result = emscripten::val::object();
+    result.set("expressID", mesh.expressID);
+    result.set("geometries", geometries);
+    return result;
+}
+
+emscripten::val GetFlatMeshWorldSpace(uint32_t modelID, uint32_t expressID)
+{
+    if (!manager.IsModelOpen(modelID))
+        return emscripten::val::null();
+    BakedMeshBuffers buffers;
+    return BakeFlatMesh(modelID, manager.GetGeometryProcessor(modelID)->GetFlatMesh(expressID), buffers, true);
+}
+
+// like StreamMeshes, the meshes are handed over by BakeFlatMesh with views that are only valid during the callback, so
+// nothing has to be transformed on the JS side
+void StreamMeshesWorldSpace(uint32_t modelID, emscripten::val expressIdsVal, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const std::vector<uint32_t> expressIds = ToIDVector(expressIdsVal);
+    const int total = expressIds.size();
+    BakedMeshBuffers buffers;
+    for (int index = 0; index < total; index++)
+    {
+        webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(expressIds[index]);
+        if (!mesh.geometries.empty())
+            callback(BakeFlatMesh(modelID, mesh, buffers, false), index, total);
+        // the baked buffers are copies, what later elements share is kept within a budget
+        geomLoader->TrimStreamingCaches();
+    }
+    geomLoader->Clear();
+}
+
+// like StreamMeshes, every mesh is handed to the callback once for every level of detail from levels down to the full
+// mesh at 0, the coarse levels are decimated from the full geometry, which is meshed once
+void StreamMeshesLOD(uint32_t modelID, emscripten::val expressIdsVal, uint32_t levels, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
+    const std::vector<uint32_t> expressIds = ToIDVector(expressIdsVal);
+    const uint32_t total = expressIds.size();
+
+    for (uint32_t index = 0; index < total; index++)
+    {
+        const uint32_t id = expressIds[index];
+        webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(id);
+
+        if (!mesh.geometries.empty())
+        {
+            // coarse to fine, the full geometry may release its vertices and is prepared last
+            for (uint32_t lod = levels + 1; lod-- > 0;)
+            {
+                for (auto &geom : mesh.geometries)
+                    geomLoader->GetGeometry(geom.geometryExpressID, lod).PrepareVertexData(vertexFormat);
+                callback(mesh, lod, index, total);
+            }
+        }
+
+        geomLoader->TrimStreamingCaches();
+    }
+    geomLoader->Clear();
+}
+
+// per instance: the element's expressID, the geometry's expressID, the color and the 16 values of the transformation
+constexpr size_t INSTANCE_RECORD_SIZE = 22;
+constexpr size_t INSTANCE_BATCH_SIZE = 1024;
+
+// every geometry is handed to geometryCallback with its expressID once, the first time an element places it, read it
+// with GetGeometry within the callback. The placements follow in batches of instance records to instanceCallback, a
+// record always comes after the callback of its geometry and the records are only valid for the time of the callback
+void StreamInstancedMeshes(uint32_t modelID, emscripten::val expressIdsVal, emscripten::val geometryCallback, emscripten::val instanceCallback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
+    const std::vector<uint32_t> expressIds = ToIDVector(expressIdsVal);
+    const uint32_t total = expressIds.size();
+
+    std::unordered_set<uint32_t> streamed;
+    std::vector<double> records;
+    records.reserve(INSTANCE_BATCH_SIZE * INSTANCE_RECORD_SIZE);
+    auto flush = [&]()
+    {
+        if (records.empty())
+            return;
+        instanceCallback(emscripten::val(emscripten::typed_memory_view(records.size(), records.data())));
+        records.clear();
+    };
+
+    for (uint32_t index = 0; index < total; index++)
+    {
+        const uint32_t id = expressIds[index];
+        webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(id);
+
+        for (auto &geom : mesh.geometries)
+        {
+            if (streamed.insert(geom.geometryExpressID).second)
+            {
+                geomLoader->GetGeometry(geom.geometryExpressID).PrepareVertexData(vertexFormat);
+                geometryCallback(geom.geometryExpressID);
+            }
+            records.push_back(mesh.expressID);
+            records.push_back(geom.geometryExpressID);
+            for (int i = 0; i < 4; i++)
+                records.push_back(geom.color[i]);
+            records.insert(records.end(), geom.flatTransformation.begin(), geom.flatTransformation.end());
+            if (records.size() >= INSTANCE_BATCH_SIZE * INSTANCE_RECORD_SIZE)
+                flush();
+        }
+
+        // the geometries were streamed already, so they may be dropped, the mapped representations are kept for later
+        // instances
+        geomLoader->TrimStreamingCaches();
+    }
+    flush();
+    geomLoader->Clear();
+}
+
+// per placed geometry: the element's expressID, the geometry's expressID, the element's index in the stream, the color,
+// the 16 values of the transformation and the pointer and size of the vertex and of the index data
+constexpr size_t MESH_RECORD_SIZE = 27;
+constexpr size_t MESH_BATCH_BYTES = 16 * 1024 * 1024;
+
+// like StreamMeshes, but the placed geometries of many elements are handed to callback at once as records, with the total
+// number of elements. A batch is sent once its geometries hold batchBytes, or the geometry memory limit when that is
+// lower, and the vertex and index data of a batch is only valid for the time of the callback
+void StreamMeshesBatched(uint32_t modelID, emscripten::val expressIdsVal, uint32_t batchBytes, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
+    const std::vector<uint32_t> expressIds = ToIDVector(expressIdsVal);
+    const uint32_t total = expressIds.size();
+    size_t budget = batchBytes > 0 ? batchBytes : MESH_BATCH_BYTES;
+    // the geometries of a pending batch are kept through the trims of GetFlatMesh, which bring the rest of the geometry
+    // within the limit, so a batch holds no more than the limit either
+    if (manager.GetSettings(modelID).GEOMETRY_MEMORY_LIMIT > 0)
+        budget = std::min<size_t>(budget, manager.GetSettings(modelID).GEOMETRY_MEMORY_LIMIT);
+
+    std::vector<double> records;
+    std::unordered_set<uint32_t> batchGeometries;
+    size_t bytes = 0;
+    auto flush = [&]()
+    {
+        if (!records.empty())
+            callback(emscripten::val(emscripten::typed_memory_view(records.size(), records.data())), total);
+        records.clear();
+        batchGeometries.clear();
+        bytes = 0;
+        geomLoader->ReleaseKeptGeometries();
+        geomLoader->TrimStreamingCaches();
+    };
+
+    for (uint32_t index = 0; index < total; index++)
+    {
+        const uint32_t id = expressIds[index];
+        webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(id);
+
+        size_t elementBytes = 0;
+        for (auto &geom : mesh.geometries)
+        {
+            if (batchGeometries.count(geom.geometryExpressID) != 0)
+                continue;
+            // with the float vertices it gets once prepared
+            auto &flatGeom = geomLoader->GetGeometry(geom.geometryExpressID);
+            elementBytes += flatGeom.GetMemorySize() + flatGeom.vertexData.size() * sizeof(float);
+        }
+        // the pending batch is still held, the element starts the next one
+        if (!records.empty() && bytes + elementBytes > budget)
+            flush();
+
+        for (auto &geom : mesh.geometries)
+        {
+            auto &flatGeom = geomLoader->GetGeometry(geom.geometryExpressID);
+            if (batchGeometries.insert(geom.geometryExpressID).second)
+            {
+                geomLoader->KeepGeometry(geom.geometryExpressID);
+                flatGeom.PrepareVertexData(vertexFormat);
+                bytes += flatGeom.GetMemorySize();
+            }
+            records.push_back(mesh.expressID);
+            records.push_back(geom.geometryExpressID);
+            records.push_back(index);
+            for (int i = 0; i < 4; i++)
+                records.push_back(geom.color[i]);
+            records.insert(records.end(), geom.flatTransformation.begin(), geom.flatTransformation.end());
+            records.push_back(flatGeom.GetVertexData());
+            records.push_back(flatGeom.GetVertexDataSize());
+            records.push_back(flatGeom.GetIndexData());
+            records.push_back(flatGeom.GetIndexDataSize());
+        }
+    }
+    flush();
+    geomLoader->Clear();
+}
+
+// the meshes of the elements merged into one mesh per color, callback gets every mesh's color, its vertices, its
+// indices and its element ranges as expressID, first index and index count. The arrays are only valid for the time of
+// the callback
+void GetMergedMeshes(uint32_t modelID, emscripten::val expressIdsVal, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    const std::vector<uint32_t> expressIds = ToIDVector(expressIdsVal);
+
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    std::vector<webifc::geometry::IfcMergedMesh> meshes = geomLoader->GetMergedMeshes(expressIds);
+    // the merged meshes hold copies of the vertices, so the geometries may be dropped
+    geomLoader->Clear();
+
+    std::vector<uint32_t> ranges;
+    for (auto &mesh : meshes)
+    {
+        ranges.clear();
+        for (auto &range : mesh.ranges)
+            ranges.insert(ranges.end(), {range.expressID, range.indexOffset, range.indexCount});
+        callback(emscripten::val(mesh.color),
+                 emscripten::val(emscripten::typed_memory_view(mesh.vertexData.size(), mesh.vertexData.data())),
+                 emscripten::val(emscripten::typed_memory_view(mesh.indexData.size(), mesh.indexData.data())),
+                 emscripten::val(emscripten::typed_memory_view(ranges.size(), ranges.data())));
+    }
+}
+
+void BuildSpatialIndex(uint32_t modelID, emscripten::val expressIdsVal)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    const std::vector<uint32_t> expressIds = ToIDVector(expressIdsVal);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    geomLoader->BuildSpatialIndex(expressIds);
+    // the index holds copies of the geometries
+    geomLoader->Clear();
+}
+
+emscripten::val RayCast(uint32_t modelID, glm::dvec3 origin, glm::dvec3 direction, double maxDistance)
+{
+    if (!manager.IsModelOpen(modelID))
+        return emscripten::val::null();
+    auto hit = manager.GetGeometryProcessor(modelID)->GetSpatialIndex().RayCast(origin, direction, maxDistance > 0 ? maxDistance : std::numeric_limits<double>::infinity());
+    if (!hit)
+        return emscripten::val::null();
+    auto result = emscripten::val::object();
+    result.set("expressID", hit->expressID);
+    result.set("geometryExpressID", hit->geometryExpressID);
+    result.set("faceIndex", hit->faceIndex);
+    result.set("distance", hit->distance);
+    result.set("position", hit->position);
+    result.set("normal", hit->normal);
+    return result;
+}
+
+// planes holds 4 numbers per plane, the normal and d of dot(normal, p) + d >= 0 for what is kept
+emscripten::val FrustumQuery(uint32_t modelID, emscripten::val planesVal)
+{
+    if (!manager.IsModelOpen(modelID))
+        return ToUint32Array({});
+    const std::vector<double> values = emscripten::convertJSArrayToNumberVector<double>(planesVal);
+    std::vector<glm::dvec4> planes(values.size() / 4);
+    for (size_t i = 0; i < planes.size(); i++)
+        planes[i] = glm::dvec4(values[i * 4], values[i * 4 + 1], values[i * 4 + 2], values[i * 4 + 3]);
+    return ToUint32Array(manager.GetGeometryProcessor(modelID)->GetSpatialIndex().FrustumQuery(planes));
+}
+
+emscripten::val ClosestPoint(uint32_t modelID, glm::dvec3 point, double maxDistance)
+{
+    if (!manager.IsModelOpen(modelID))
+        return emscripten::val::null();
+    auto closest = manager.GetGeometryProcessor(modelID)->GetSpatialIndex().ClosestPoint(point, maxDistance > 0 ? maxDistance : std::numeric_limits<double>::infinity());
+    if (!closest)
+        return emscripten::val::null();
+    auto result = emscripten::val::object();
+    result.set("expressID", closest->expressID);
+    result.set("geometryExpressID", closest->geometryExpressID);
+    result.set("faceIndex", closest->faceIndex);
+    result.set("distance", closest->distance);
+    result.set("position", closest->position);
+    return result;
+}
+
+// the pairs of elements of idsA in modelA and idsB in modelB whose meshes clash within tolerance, see IfcClashDetector.
+// callback gets the pairs in batches as [expressIDA, expressIDB, ...], the batch is only valid during the call. The
+// triangles are tested on several threads, false when a model is not open
+bool DetectClashes(uint32_t modelA, emscripten::val idsAVal, uint32_t modelB, emscripten::val idsBVal, double tolerance, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelA) || !manager.IsModelOpen(modelB))
+        return false;
+    const std::vector<uint32_t> ids[2] = {ToIDVector(idsAVal), ToIDVector(idsBVal)};
+    const uint32_t models[2] = {modelA, modelB};
+    webifc::geometry::IfcClashDetector detector;
+    for (uint32_t set = 0; set < 2; set++)
+    {
+        auto geomLoader = manager.GetGeometryProcessor(models[set]);
+        for (uint32_t expressID : ids[set])
+        {
+            webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(expressID);
+            for (auto &geom : mesh.geometries)
+                detector.Add(set, expressID, geom.geometryExpressID, geomLoader->GetGeometry(geom.geometryExpressID), geom.transformation);
+            geomLoader->TrimStreamingCaches();
+        }
+        // the detector holds copies of the geometries
+        geomLoader->Clear();
+    }
+
+    std::vector<uint32_t> pairs;
+    detector.Detect(tolerance, modelA == modelB, webifc::utility::GetThreadCount(), [&](const std::vector<webifc::geometry::IfcClash> &clashes)
+                    {
+        pairs.clear();
+        for (const auto &clash : clashes)
+        {
+            pairs.push_back(clash.expressIDA);
+            pairs.push_back(clash.expressIDB);
+        }
+        callback(emscripten::val(emscripten::typed_memory_view(pairs.size(), pairs.data()))); });
+    return true;
+}
+
+// false when the build has no profiling, see WEBIFC_GEOMETRY_PROFILING
+bool SetGeometryProfiling(uint32_t modelID, bool enabled)
+{
+    if (!manager.IsModelOpen(modelID))
+        return false;
+    return manager.GetGeometryProcessor(modelID)->SetProfilingEnabled(enabled);
+}
+
+emscripten::val ToProfileCounters(const webifc::geometry::IfcProfileCounters &counters)
+{
+    auto result = emscripten::val::object();
+    result.set("calls", static_cast<double>(counters.calls));
+    result.set("inclusiveTime", counters.inclusiveTime / 1e6);
+    result.set("exclusiveTime", counters.exclusiveTime / 1e6);
+    result.set("triangles", static_cast<double>(counters.triangles));
+    result.set("bytes", static_cast<double>(counters.bytes));
+    return result;
+}
+
+emscripten::val GetGeometryProfile(uint32_t modelID)
+{
+    auto types = emscripten::val::array();
+    auto elements = emscripten::val::array();
+    if (manager.IsModelOpen(modelID))
+    {
+        const auto profile = manager.GetGeometryProcessor(modelID)->GetProfile();
+        for (const auto &[type, counters] : profile.types)
+        {
+            auto entry = ToProfileCounters(counters);
+            entry.set("type", type);
+            types.call<void>("push", entry);
+        }
+        for (const auto &[expressID, element] : profile.elements)
+        {
+            auto entry = ToProfileCounters(element.counters);
+            entry.set("expressID", expressID);
+            entry.set("type", element.type);
+            elements.call<void>("push", entry);
+        }
+    }
+    auto result = emscripten::val::object();
+    result.set("types", types);
+    result.set("elements", elements);
+    return result;
+}
+
+void ResetGeometryProfile(uint32_t modelID)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    manager.GetGeometryProcessor(modelID)->ResetProfile();
+}
+
+emscripten::val GetOverBudgetElements(uint32_t modelID)
+{
+    if (!manager.IsModelOpen(modelID))
+        return ToUint32Array({});
+    return ToUint32Array(manager.GetGeometryProcessor(modelID)->GetOverBudgetElements());
+}
+
+void ClearOverBudgetElements(uint32_t modelID)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    manager.GetGeometryProcessor(modelID)->ClearOverBudgetElements();
+}
+
+emscripten::val InvalidateLines(uint32_t modelID, emscripten::val expressIDsVal)
+{
+    if (!manager.IsModelOpen(modelID))
+        return ToUint32Array({});
+    return ToUint32Array(manager.GetGeometryProcessor(modelID)->InvalidateLines(ToIDVector(expressIDsVal)));
+}
+
+// loads what the workers would otherwise load lazily and at once, false when there are no threads or the tape cannot be
+// read concurrently, the tables are then loaded for meshing on the calling thread
+bool PrepareParallelMeshing(uint32_t modelID)
+{
+    auto &geometryLoader = manager.GetGeometryProcessor(modelID)->GetLoader();
+    const size_t threads = webifc::utility::GetThreadCount();
+    const bool parallel = threads >= 2 && manager.GetIfcLoader(modelID)->PrepareConcurrentReads();
+    if (parallel)
+        geometryLoader.LoadRelations();
+    geometryLoader.LoadCartesianPoints(parallel ? threads : 1);
+    geometryLoader.ResolvePlacements(parallel ? threads : 1);
+    geometryLoader.ResolveStyles();
+    manager.GetGeometryProcessor(modelID)->CoordinateFromPlacements();
+    return parallel;
+}
+
+// meshes each group of elements on the thread pool, the callback still runs on the calling thread and sees every group
+// with the index and total it would get from StreamMeshes, though the meshes arrive in the order they are finished.
+// Elements with openings are started first unless the groups are in the order they are to arrive in, then the caller has
+// prepared the meshing already
+bool StreamMeshesParallel(uint32_t modelID, const std::vector<std::vector<uint32_t>> &groups, emscripten::val callback, bool ordered = false)
+{
+    constexpr size_t BATCH_SIZE = 16;
+    auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
+    const size_t threads = webifc::utility::GetThreadCount();
+    if (!ordered && (threads < 2 || !loader->PrepareConcurrentReads()))
+        return false;
+    if (!ordered)
+    {
+        geomLoader->GetLoader().LoadRelations();
+        geomLoader->GetLoader().LoadCartesianPoints(threads);
+        geomLoader->GetLoader().ResolvePlacements(threads);
+        geomLoader->GetLoader().ResolveStyles();
+        geomLoader->CoordinateFromPlacements();
+    }
+
+    struct Task
+    {
+        uint32_t expressID;
+        int index;
+        int total;
+    };
+    std::vector<Task> tasks;
+    for (auto &group : groups)
+    {
+        for (size_t i = 0; i < group.size(); i++)
+            tasks.push_back({group[i], (int)i, (int)group.size()});
+    }
+    // elements with openings go through booleans, they are started first so that none of them is left for the end
+    auto &relVoids = geomLoader->GetLoader().GetRelVoids();
+    if (!ordered)
+        std::stable_partition(tasks.begin(), tasks.end(), [&](const Task &task)
+                              { return relVoids.count(task.expressID) != 0; });
+
+    struct Result
+    {
+        webifc::geometry::IfcFlatMesh mesh;
+        std::vector<std::pair<uint32_t, webifc::geometry::IfcGeometry>> geometries;
+        int index;
+        int total;
+    };
+    webifc::parsing::IfcLoader::ReadScope scope(*loader);
+    webifc::utility::ParallelProduce(
+        tasks.size(), threads, BATCH_SIZE,
+        [&]()
+        { return std::make_unique<webifc::parsing::IfcLoader::ReadScope>(*loader); },
+        [&](const size_t i)
+        {
+            Result result{geomLoader->GetFlatMesh(tasks[i].expressID), {}, tasks[i].index, tasks[i].total};
+            // the geometry lives in this thread's store, it is handed over to the calling thread with the mesh
+            for (auto &geom : result.mesh.geometries)
+            {
+                auto found = std::find_if(result.geometries.begin(), result.geometries.end(), [&](auto &entry)
+                                          { return entry.first == geom.geometryExpressID; });
+                if (found != result.geometries.end())
+                    continue;
+                auto &flatGeom = geomLoader->GetGeometry(geom.geometryExpressID);
+                flatGeom.PrepareVertexData(vertexFormat);
+                result.geometries.emplace_back(geom.geometryExpressID, std::move(flatGeom));
+            }
+            geomLoader->ClearThread();
+            return result;
+        },
+        [&](Result &result)
+        {
+            for (auto &[expressID, geometry] : result.geometries)
+                geomLoader->GetGeometry(expressID) = std::move(geometry);
+            if (!result.mesh.geometries.empty())
+            {
+                // transfer control to client, geometry data is alive for the time of the callback
+                callback(result.mesh, result.index, result.total);
+            }
+            geomLoader->ClearThread();
+        });
+    return true;
+}
+
+void StreamAllMeshesWithTypes(uint32_t modelID, const std::vector<uint32_t> &types, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    auto loader = manager.GetIfcLoader(modelID);
+
+    std::vector<std::vector<uint32_t>> groups;
+    for (auto &type : types)
+        groups.push_back(loader->GetExpressIDsWithType(type));
+    if (StreamMeshesParallel(modelID, groups, callback))
+        return;
+
+    // StreamMeshes clears the point and placement caches after every element, the tables are kept
+    auto &geometryLoader = manager.GetGeometryProcessor(modelID)->GetLoader();
+    geometryLoader.LoadCartesianPoints(1);
+    geometryLoader.ResolvePlacements(1);
+    geometryLoader.ResolveStyles();
+    for (auto &elements : groups)
+        StreamMeshes(modelID, elements, callback);
+}
+
+void StreamAllMeshesWithTypesVal(uint32_t modelID, emscripten::val typesVal, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    StreamAllMeshesWithTypes(modelID, ToIDVector(typesVal), callback);
+}
+
+// the element types StreamAllMeshes meshes, all but openings and spaces
+std::vector<uint32_t> GetMeshedElementTypes()
+{
+    std::vector<uint32_t> types;
+
+    for (auto &type : manager.GetSchemaManager().GetIfcElementList())
+    {
+        if (type == webifc::schema::IFCOPENINGELEMENT || type == webifc::schema::IFCSPACE || type == webifc::schema::IFCOPENINGSTANDARDCASE)
+        {
+            continue;
+        }
+
+        types.push_back(type);
+    }
+    return types;
+}
+
+void StreamAllMeshes(uint32_t modelID, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    StreamAllMeshesWithTypes(modelID, GetMeshedElementTypes(), callback);
+}
+
+// starts streaming the elements of the types, all that StreamAllMeshes meshes when typesVal is empty, in the order
+// StreamAllMeshes streams them on one thread. Returns the session for StepStream and EndStream, -1 when the model is not
+// open. The model must not change while the session is open
+int BeginStream(uint32_t modelID, emscripten::val typesVal)
+{
+    if (!manager.IsModelOpen(modelID))
+        return -1;
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
+    auto loader = manager.GetIfcLoader(modelID);
+    StreamSession session{modelID};
+    for (uint32_t type : types)
+    {
+        auto ids = loader->GetExpressIDsWithType(type);
+        session.elements.insert(session.elements.end(), ids.begin(), ids.end());
+    }
+    // the tables are kept for every step, StreamMeshes would drop the point and placement caches after every element
+    auto &geometryLoader = manager.GetGeometryProcessor(modelID)->GetLoader();
+    geometryLoader.LoadCartesianPoints(1);
+    geometryLoader.ResolvePlacements(1);
+    geometryLoader.ResolveStyles();
+    const uint32_t id = nextStreamSession++;
+    streamSessions.emplace(id, std::move(session));
+    return static_cast<int>(id);
+}
+
+// streams the next elements of the session to callback(mesh, index, total) like StreamAllMeshes until timeBudgetMs have
+// passed, at least one element per call. True while elements are left, false once the session is done or unknown
+bool StepStream(uint32_t sessionID, double timeBudgetMs, emscripten::val callback)
+{
+    auto it = streamSessions.find(sessionID);
+    if (it == streamSessions.end())
+        return false;
+    const uint32_t modelID = it->second.modelID;
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
+    const uint64_t deadline = webifc::utility::NowNanoseconds() + static_cast<uint64_t>(std::max(timeBudgetMs, 0.0) * 1e6);
+    while (it->second.next < it->second.elements.size())
+    {
+        auto &session = it->second;
+        const size_t index = session.next++;
+        StreamMesh(geomLoader, vertexFormat, session.elements[index], static_cast<int>(index), static_cast<int>(session.elements.size()), callback);
+        // the callback may have ended the session
+        it = streamSessions.find(sessionID);
+        if (it == streamSessions.end())
+            return false;
+        if (webifc::utility::NowNanoseconds() >= deadline)
+            break;
+    }
+    return it->second.next < it->second.elements.size();
+}
+
+// ends the session early or once it is done and drops what was cached for it
+void EndStream(uint32_t sessionID)
+{
+    auto it = streamSessions.find(sessionID);
+    if (it == streamSessions.end())
+        return;
+    const uint32_t modelID = it->second.modelID;
+    streamSessions.erase(it);
+    manager.GetGeometryProcessor(modelID)->Clear();
+}
+
+// splits the elements of the types, all that StreamAllMeshes meshes when typesVal is empty, into at most shards ranges
+// of consecutive expressIDs of about the same EstimateMeshingCost, so that nodes that open the same file can each mesh one
+// with StreamAllMeshesShard. The manifest is [shardCount, then for every shard firstExpressID, lastExpressID,
+// elementCount, cost] and only depends on the file and the types
+emscripten::val GetPartitionManifest(uint32_t modelID, emscripten::val typesVal, uint32_t shards)
+{
+    if (!manager.IsModelOpen(modelID))
+        return emscripten::val::null();
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
+    auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    std::vector<uint32_t> elements;
+    for (uint32_t type : types)
+    {
+        auto ids = loader->GetExpressIDsWithType(type);
+        elements.insert(elements.end(), ids.begin(), ids.end());
+    }
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+
+    std::vector<uint32_t> costs;
+    costs.reserve(elements.size());
+    uint64_t totalCost = 0;
+    for (uint32_t expressID : elements)
+    {
+        // elements without geometry still have to be looked at
+        costs.push_back(std::max<uint32_t>(1, geomLoader->EstimateMeshingCost(expressID)));
+        totalCost += costs.back();
+    }
+
+    shards = std::max<uint32_t>(1, std::min<uint32_t>(shards, elements.size()));
+    std::vector<uint32_t> manifest = {0};
+    if (elements.empty())
+        return ToUint32Array(manifest);
+    size_t begin = 0;
+    uint64_t prefix = 0;
+    for (uint32_t shard = 0; shard < shards; shard++)
+    {
+        // the shard ends where the running cost reaches its share, leaving an element for every shard after it
+        const uint64_t target = totalCost * (shard + 1) / shards;
+        const size_t limit = elements.size() - (shards - shard - 1);
+        size_t end = begin;
+        uint64_t cost = 0;
+        while (end < limit && (end == begin || prefix < target || shard + 1 == shards))
+        {
+            prefix += costs[end];
+            cost += costs[end];
+            end++;
+        }
+        manifest.push_back(elements[begin]);
+        manifest.push_back(elements[end - 1]);
+        manifest.push_back(static_cast<uint32_t>(end - begin));
+        manifest.push_back(static_cast<uint32_t>(std::min<uint64_t>(cost, UINT32_MAX)));
+        begin = end;
+    }
+    manifest[0] = shards;
+    return ToUint32Array(manifest);
+}
+
+// streams the meshes of one shard of a manifest from GetPartitionManifest made with the same types, in the order and with
+// the index and total StreamAllMeshesWithTypes would give them, so the output of all shards together is that of a single
+// run. False when the shard is not in the manifest
+bool StreamAllMeshesShard(uint32_t modelID, emscripten::val typesVal, emscripten::val manifestVal, uint32_t shard, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return false;
+    std::vector<uint32_t> manifest = ToIDVector(manifestVal);
+    if (manifest.empty() || shard >= manifest[0] || manifest.size() < 1 + 4 * (size_t(shard) + 1))
+    {
+        spdlog::error("[StreamAllMeshesShard()] shard {} is not in the manifest", shard);
+        return false;
+    }
+    const uint32_t first = manifest[1 + 4 * shard];
+    const uint32_t last = manifest[2 + 4 * shard];
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
+    auto loader = manager.GetIfcLoader(modelID);
+
+    // StreamMeshes clears the point and placement caches after every element, the tables are kept
+    auto &geometryLoader = manager.GetGeometryProcessor(modelID)->GetLoader();
+    geometryLoader.LoadCartesianPoints(1);
+    geometryLoader.ResolvePlacements(1);
+    geometryLoader.ResolveStyles();
+    for (uint32_t type : types)
+        StreamMeshes(modelID, loader->GetExpressIDsWithType(type), callback, first, last);
+    return true;
+}
+
+// the elements of the types, all that StreamAllMeshes meshes when typesVal is empty, largest first, or with a camera
+// position [x, y, z] in the space of the flat meshes by the angle their box covers from it, so that what is seen first
+// arrives first. The boxes come from GetElementBounds without meshing, elements it cannot bound follow in type order.
+// index is the rank of the element and total the number of elements
+void StreamAllMeshesPrioritized(uint32_t modelID, emscripten::val typesVal, emscripten::val cameraVal, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return;
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
+    auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    std::optional<glm::dvec3> camera;
+    if (!cameraVal.isNull() && !cameraVal.isUndefined())
+    {
+        const std::vector<double> position = emscripten::convertJSArrayToNumberVector<double>(cameraVal);
+        if (position.size() >= 3)
+            camera = glm::dvec3(position[0], position[1], position[2]);
+    }
+    // the placements and points the bounds read are the ones meshing reads
+    const bool parallel = PrepareParallelMeshing(modelID);
+
+    std::vector<std::pair<double, uint32_t>> priorities;
+    for (uint32_t type : types)
+    {
+        for (uint32_t expressID : loader->GetExpressIDsWithType(type))
+        {
+            glm::dvec3 min, max;
+            double priority = -1;
+            if (geomLoader->GetElementBounds(expressID, min, max))
+            {
+                const double size = glm::length(max - min);
+                priority = size;
+                if (camera)
+                {
+                    const double distance = glm::length(glm::max(glm::max(min - *camera, *camera - max), glm::dvec3(0)));
+                    priority = std::atan2(size, distance);
+                }
+            }
+            priorities.emplace_back(priority, expressID);
+        }
+    }
+    std::stable_sort(priorities.begin(), priorities.end(), [](const auto &a, const auto &b)
+                     { return a.first > b.first; });
+    std::vector<uint32_t> order;
+    order.reserve(priorities.size());
+    for (auto &[priority, expressID] : priorities)
+        order.push_back(expressID);
+
+    if (parallel)
+        StreamMeshesParallel(modelID, {order}, callback, true);
+    else
+        StreamMeshes(modelID, order, callback);
+}
+
+// the elements of the types, all that StreamAllMeshes meshes when typesVal is empty, converted into a GLB one element at a
+// time. callback(bytes, isPrefix) gets the binary chunk as it is written and at last the start of the file, the GLB is
+// that prefix followed by the bytes before it. The bytes are only valid during the call, false when the GLB exceeds 4GB
+bool ExportGLB(uint32_t modelID, emscripten::val typesVal, emscripten::val callback)
 {
     if (!manager.IsModelOpen(modelID))
-        return;
+        return false;
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
+    auto loader = manager.GetIfcLoader(modelID);
     auto geomLoader = manager.GetGeometryProcessor(modelID);
-    int index = 0;
-    int total = expressIds.size();
-
-    for (const auto &id : expressIds)
+    auto output = [&](bool isPrefix)
     {
-        // read the mesh from IFC
-        webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(id);
-
-        // prepare the geometry data
-        for (auto &geom : mesh.geometries)
+        return [&, isPrefix](const char *data, size_t size)
+        { callback(emscripten::val(emscripten::typed_memory_view(size, reinterpret_cast<const uint8_t *>(data))), isPrefix); };
+    };
+    webifc::geometry::IfcGlbWriter writer(output(false));
+
+    // StreamMeshes clears the point and placement caches after every element, the tables are kept
+    auto &geometryLoader = geomLoader->GetLoader();
+    geometryLoader.LoadCartesianPoints(1);
+    geometryLoader.ResolvePlacements(1);
+    geometryLoader.ResolveStyles();
+    for (uint32_t type : types)
+    {
+        const std::string typeName = manager.GetSchemaManager().IfcTypeCodeToType(type);
+        for (uint32_t expressID : loader->GetExpressIDsWithType(type))
         {
-            auto &flatGeom = geomLoader->GetGeometry(geom.geometryExpressID);
-            flatGeom.GetVertexData();
+            webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(expressID);
+            if (!mesh.geometries.empty())
+                writer.Add(mesh, typeName, [&](uint32_t geometryExpressID)
+                           { return &geomLoader->GetGeometry(geometryExpressID); });
+            // a geometry is written the first time it is placed, later placements only refer to it
+            geomLoader->TrimStreamingCaches();
         }
+    }
+    geomLoader->Clear();
+    return writer.Finish(output(true));
+}
 
-        if (!mesh.geometries.empty())
+// produce(i) for every i below count and consume(result) on the calling thread, on several threads where there are
+// threads and the tape can be read concurrently, then the results arrive in the order they are done. The geometries
+// produce meshes live in the store of its thread, they are all cleared at the end
+template <typename Produce, typename Consume>
+void ProduceMeshed(uint32_t modelID, size_t count, size_t batchSize, const Produce &produce, const Consume &consume)
+{
+    auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    auto &geometryLoader = geomLoader->GetLoader();
+    const size_t threads = webifc::utility::GetThreadCount();
+    if (threads < 2 || count < 2 || !loader->PrepareConcurrentReads())
+    {
+        geometryLoader.LoadCartesianPoints(1);
+        geometryLoader.ResolvePlacements(1);
+        geometryLoader.ResolveStyles();
+        for (size_t i = 0; i < count; i++)
         {
-            // transfer control to client, geometry data is alive for the time of the callback
-            callback(mesh, index, total);
+            auto result = produce(i);
+            consume(result);
         }
-
-        // clear geometry, freeing memory, client is expected to have consumed the data
         geomLoader->Clear();
-
-        index++;
+        return;
     }
-}
-
-void StreamMeshesWithExpressID(uint32_t modelID, emscripten::val expressIdsVal, emscripten::val callback)
-{
-    std::vector<uint32_t> expressIds;
-
-    uint32_t size = expressIdsVal["length"].as<uint32_t>();
-    for (size_t i = 0; i < size; i++)
+    geometryLoader.LoadRelations();
+    geometryLoader.LoadCartesianPoints(threads);
+    geometryLoader.ResolvePlacements(threads);
+    geometryLoader.ResolveStyles();
+    // the workers would otherwise all wait for the first of them to set it
+    geomLoader->CoordinateFromPlacements();
     {
-        emscripten::val expressIdVal = expressIdsVal[std::to_string(i)];
-
-        uint32_t expressId = expressIdVal.as<uint32_t>();
-
-        expressIds.push_back(expressId);
+        webifc::parsing::IfcLoader::ReadScope scope(*loader);
+        webifc::utility::ParallelProduce(
+            count, threads, batchSize,
+            [&]()
+            { return std::make_unique<webifc::parsing::IfcLoader::ReadScope>(*loader); },
+            produce, consume);
     }
-
-    StreamMeshes(modelID, expressIds, callback);
+    geomLoader->Clear();
 }
 
-void StreamAllMeshesWithTypes(uint32_t modelID, const std::vector<uint32_t> &types, emscripten::val callback)
+// the elements of the types, all that StreamAllMeshes meshes when typesVal is empty, as 3D Tiles: an octree of GLB tiles
+// with at most maxElementsPerTile elements each, except where elements are too large for smaller tiles or the tree is
+// too deep. callback(path, bytes) gets every tile at tiles/<index>.glb and at last tileset.json, the bytes are only valid
+// during the call. The elements are meshed twice on several threads, once for their boxes and once into their tile, so
+// that no more than a tile per thread is held. False when there was nothing to tile
+bool ExportTiles(uint32_t modelID, emscripten::val typesVal, uint32_t maxElementsPerTile, emscripten::val callback)
 {
     if (!manager.IsModelOpen(modelID))
-        return;
+        return false;
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
     auto loader = manager.GetIfcLoader(modelID);
-
-    for (auto &type : types)
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    std::vector<uint32_t> elements;
+    for (uint32_t type : types)
     {
-        auto elements = loader->GetExpressIDsWithType(type);
-        StreamMeshes(modelID, elements, callback);
+        auto ids = loader->GetExpressIDsWithType(type);
+        elements.insert(elements.end(), ids.begin(), ids.end());
     }
-}
 
-void StreamAllMeshesWithTypesVal(uint32_t modelID, emscripten::val typesVal, emscripten::val callback)
-{
-    if (!manager.IsModelOpen(modelID))
-        return;
-    std::vector<uint32_t> types;
-    uint32_t size = typesVal["length"].as<uint32_t>();
-    uint32_t index = 0;
-    while (index < size)
+    std::vector<webifc::geometry::IfcElementBox> boxes;
+    ProduceMeshed(
+        modelID, elements.size(), 16,
+        [&](const size_t i)
+        {
+            webifc::geometry::IfcElementBox box{elements[i], glm::dvec3(DBL_MAX), glm::dvec3(-DBL_MAX)};
+            webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(elements[i]);
+            for (auto &geom : mesh.geometries)
+                webifc::geometry::IfcTileset::GetPlacedBox(geomLoader->GetGeometry(geom.geometryExpressID), geom.transformation, box.min, box.max);
+            geomLoader->TrimStreamingCaches();
+            return box;
+        },
+        [&](webifc::geometry::IfcElementBox &box)
+        { boxes.push_back(box); });
+
+    webifc::geometry::IfcTileset tileset;
+    tileset.Build(boxes, std::max<uint32_t>(maxElementsPerTile, 1));
+    const auto &tiles = tileset.GetTiles();
+    if (tiles.empty())
+        return false;
+    auto tileUri = [](uint32_t tile)
+    { return "tiles/" + std::to_string(tile) + ".glb"; };
+    auto emit = [&](const std::string &path, const char *data, size_t size)
+    { callback(path, emscripten::val(emscripten::typed_memory_view(size, reinterpret_cast<const uint8_t *>(data)))); };
+
+    std::vector<uint32_t> contentTiles;
+    for (uint32_t tile = 0; tile < tiles.size(); tile++)
     {
-        emscripten::val typeVal = typesVal[std::to_string(index++)];
-        uint32_t type = typeVal.as<uint32_t>();
-        types.push_back(type);
+        if (!tiles[tile].elements.empty())
+            contentTiles.push_back(tile);
     }
-    StreamAllMeshesWithTypes(modelID, types, callback);
+    ProduceMeshed(
+        modelID, contentTiles.size(), 1,
+        [&](const size_t i)
+        {
+            const uint32_t tile = contentTiles[i];
+            std::vector<char> body;
+            webifc::geometry::IfcGlbWriter writer([&](const char *data, size_t size)
+                                                  { body.insert(body.end(), data, data + size); });
+            for (uint32_t expressID : tiles[tile].elements)
+            {
+                webifc::geometry::IfcFlatMesh mesh = geomLoader->GetFlatMesh(expressID);
+                if (!mesh.geometries.empty())
+                    writer.Add(mesh, manager.GetSchemaManager().IfcTypeCodeToType(loader->GetLineType(expressID)), [&](uint32_t geometryExpressID)
+                               { return &geomLoader->GetGeometry(geometryExpressID); });
+                geomLoader->TrimStreamingCaches();
+            }
+            std::vector<char> glb;
+            if (!writer.Finish([&](const char *data, size_t size)
+                               { glb.insert(glb.end(), data, data + size); }))
+                glb.clear();
+            else
+                glb.insert(glb.end(), body.begin(), body.end());
+            geomLoader->ClearThread();
+            return std::make_pair(tile, std::move(glb));
+        },
+        [&](std::pair<uint32_t, std::vector<char>> &result)
+        {
+            if (result.second.empty())
+            {
+                spdlog::error("[ExportTiles()] tile {} exceeds the size of a GLB", result.first);
+                return;
+            }
+            emit(tileUri(result.first), result.second.data(), result.second.size());
+        });
+
+    const std::string json = tileset.GetTilesetJson(tileUri);
+    emit("tileset.json", json.data(), json.size());
+    return true;
 }
 
-void StreamAllMeshes(uint32_t modelID, emscripten::val callback)
+// per element: volume, surface area, then the min and max corner of its box
+constexpr size_t QUANTITY_RECORD_SIZE = 8;
+
+// the quantities of the elements, of all that StreamAllMeshes meshes when expressIdsVal is empty, measured on several
+// threads from their flat meshes without preparing vertex data. The records follow the order of the elements, elements
+// without measured geometry have a volume and area of 0 and a box of NaN
+emscripten::val GetElementQuantities(uint32_t modelID, emscripten::val expressIdsVal)
 {
     if (!manager.IsModelOpen(modelID))
-        return;
-    std::vector<uint32_t> types;
-
-    for (auto &type : manager.GetSchemaManager().GetIfcElementList())
+        return emscripten::val::null();
+    auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    std::vector<uint32_t> elements = ToIDVector(expressIdsVal);
+    if (elements.empty())
     {
-        if (type == webifc::schema::IFCOPENINGELEMENT || type == webifc::schema::IFCSPACE || type == webifc::schema::IFCOPENINGSTANDARDCASE)
+        for (uint32_t type : GetMeshedElementTypes())
         {
-            continue;
+            auto ids = loader->GetExpressIDsWithType(type);
+            elements.insert(elements.end(), ids.begin(), ids.end());
         }
-
-        types.push_back(type);
     }
-    StreamAllMeshesWithTypes(modelID, types, callback);
+
+    std::vector<double> records(elements.size() * QUANTITY_RECORD_SIZE, std::numeric_limits<double>::quiet_NaN());
+    ProduceMeshed(
+        modelID, elements.size(), 16,
+        [&](const size_t i)
+        {
+            webifc::geometry::IfcElementQuantities quantities;
+            const bool measured = geomLoader->GetElementQuantities(elements[i], quantities);
+            geomLoader->TrimStreamingCaches();
+            return std::make_tuple(i, measured, quantities);
+        },
+        [&](std::tuple<size_t, bool, webifc::geometry::IfcElementQuantities> &result)
+        {
+            auto &[i, measured, quantities] = result;
+            double *record = records.data() + i * QUANTITY_RECORD_SIZE;
+            record[0] = quantities.volume;
+            record[1] = quantities.area;
+            if (!measured)
+                return;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                record[2 + axis] = quantities.min[axis];
+                record[5 + axis] = quantities.max[axis];
+            }
+        });
+    return emscripten::val::global("Float64Array").new_(emscripten::typed_memory_view(records.size(), records.data()));
 }
 
 std::vector<webifc::geometry::IfcFlatMesh> LoadAllGeometry(uint32_t modelID)
@@ -194,6 +1310,7 @@ std::vector<webifc::geometry::IfcFlatMesh> LoadAllGeometry(uint32_t modelID)
         return std::vector<webifc::geometry::IfcFlatMesh>();
     auto loader = manager.GetIfcLoader(modelID);
     auto geomLoader = manager.GetGeometryProcessor(modelID);
+    const auto vertexFormat = GetVertexFormat(modelID);
     std::vector<webifc::geometry::IfcFlatMesh> meshes;
 
     for (auto type : manager.GetSchemaManager().GetIfcElementList())
@@ -211,7 +1328,7 @@ std::vector<webifc::geometry::IfcFlatMesh> LoadAllGeometry(uint32_t modelID)
             for (auto &geom : mesh.geometries)
             {
                 auto &flatGeom = geomLoader->GetGeometry(geom.geometryExpressID);
-                flatGeom.GetVertexData();
+                flatGeom.PrepareVertexData(vertexFormat);
             }
             meshes.push_back(std::move(mesh));
         }
@@ -225,41 +1342,126 @@ webifc::geometry::IfcGeometry GetGeometry(uint32_t modelID, uint32_t expressID)
     return manager.IsModelOpen(modelID) ? manager.GetGeometryProcessor(modelID)->GetGeometry(expressID) : webifc::geometry::IfcGeometry();
 }
 
-std::vector<webifc::geometry::IfcCrossSections> GetAllCrossSections(uint32_t modelID, uint8_t dimensions)
+webifc::geometry::IfcGeometry GetGeometryLOD(uint32_t modelID, uint32_t expressID, uint32_t lod)
 {
-    if (!manager.IsModelOpen(modelID))
-        return std::vector<webifc::geometry::IfcCrossSections>();
-    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    return manager.IsModelOpen(modelID) ? manager.GetGeometryProcessor(modelID)->GetGeometry(expressID, lod) : webifc::geometry::IfcGeometry();
+}
+
+// views into the buffers of the geometry instead of copies, a view is valid while the geometry keeps its buffers and
+// only until wasm memory grows, which any call that allocates may do
+emscripten::val GetGeometryVertexArray(webifc::geometry::IfcGeometry &geometry)
+{
+    const uintptr_t data = geometry.GetVertexData();
+    const size_t size = data == 0 ? 0 : geometry.GetVertexDataSize();
+    if (geometry.GetVertexFormat() == static_cast<uint8_t>(webifc::geometry::VertexFormat::QUANTIZED))
+        return emscripten::val(emscripten::typed_memory_view(size, reinterpret_cast<const uint16_t *>(data)));
+    return emscripten::val(emscripten::typed_memory_view(size, reinterpret_cast<const float *>(data)));
+}
+
+emscripten::val GetGeometryIndexArray(webifc::geometry::IfcGeometry &geometry)
+{
+    const uintptr_t data = geometry.GetIndexData();
+    const size_t size = data == 0 ? 0 : geometry.GetIndexDataSize();
+    return emscripten::val(emscripten::typed_memory_view(size, reinterpret_cast<const uint32_t *>(data)));
+}
+
+bool PinGeometry(uint32_t modelID, uint32_t expressID)
+{
+    return manager.IsModelOpen(modelID) && manager.GetGeometryProcessor(modelID)->PinGeometry(expressID);
+}
+
+void ReleaseGeometry(uint32_t modelID, uint32_t expressID)
+{
+    if (manager.IsModelOpen(modelID))
+        manager.GetGeometryProcessor(modelID)->ReleaseGeometry(expressID);
+}
 
-    std::vector<uint32_t> typeList;
-    typeList.push_back(webifc::schema::IFCSECTIONEDSOLIDHORIZONTAL);
-    typeList.push_back(webifc::schema::IFCSECTIONEDSOLID);
-    typeList.push_back(webifc::schema::IFCSECTIONEDSURFACE);
+emscripten::val GetPinnedVertexArray(uint32_t modelID, uint32_t expressID)
+{
+    auto geometry = manager.IsModelOpen(modelID) ? manager.GetGeometryProcessor(modelID)->GetPinnedGeometry(expressID) : nullptr;
+    return geometry == nullptr ? emscripten::val::null() : GetGeometryVertexArray(*geometry);
+}
 
-    std::vector<webifc::geometry::IfcCrossSections> crossSections;
+emscripten::val GetPinnedIndexArray(uint32_t modelID, uint32_t expressID)
+{
+    auto geometry = manager.IsModelOpen(modelID) ? manager.GetGeometryProcessor(modelID)->GetPinnedGeometry(expressID) : nullptr;
+    return geometry == nullptr ? emscripten::val::null() : GetGeometryIndexArray(*geometry);
+}
 
-    for (auto &type : typeList)
+// the sectioned solids and surfaces of the model, IFCSECTIONEDSOLIDHORIZONTAL, IFCSECTIONEDSOLID then IFCSECTIONEDSURFACE
+std::vector<uint32_t> GetSectionedElements(uint32_t modelID)
+{
+    auto loader = manager.GetIfcLoader(modelID);
+    std::vector<uint32_t> elements;
+    for (uint32_t type : {webifc::schema::IFCSECTIONEDSOLIDHORIZONTAL, webifc::schema::IFCSECTIONEDSOLID, webifc::schema::IFCSECTIONEDSURFACE})
     {
-        auto elements = manager.GetIfcLoader(modelID)->GetExpressIDsWithType(type);
+        auto ids = loader->GetExpressIDsWithType(type);
+        elements.insert(elements.end(), ids.begin(), ids.end());
+    }
+    return elements;
+}
 
+// consume(index, crossSections) on the calling thread for every element, the cross sections are extracted on several
+// threads where there are threads and the tape can be read concurrently, then they arrive in the order they are done
+template <typename Consume>
+void ForEachCrossSection(uint32_t modelID, const std::vector<uint32_t> &elements, uint8_t dimensions, const Consume &consume)
+{
+    constexpr size_t BATCH_SIZE = 16;
+    auto loader = manager.GetIfcLoader(modelID);
+    auto &geometryLoader = manager.GetGeometryProcessor(modelID)->GetLoader();
+    auto extract = [&](const size_t i)
+    {
+        return std::make_pair(i, dimensions == 2 ? geometryLoader.GetCrossSections2D(elements[i]) : geometryLoader.GetCrossSections3D(elements[i]));
+    };
+    const size_t threads = webifc::utility::GetThreadCount();
+    if (threads < 2 || elements.size() < 2 || !loader->PrepareConcurrentReads())
+    {
         for (size_t i = 0; i < elements.size(); i++)
         {
-            webifc::geometry::IfcCrossSections crossSection;
-            if (dimensions == 2)
-                crossSection = geomLoader->GetLoader().GetCrossSections2D(elements[i]);
-            else
-                crossSection = geomLoader->GetLoader().GetCrossSections3D(elements[i]);
-            crossSections.push_back(crossSection);
+            auto [index, crossSections] = extract(i);
+            consume(index, crossSections);
         }
+        return;
     }
+    // what the workers would otherwise load lazily and at once
+    geometryLoader.LoadRelations();
+    geometryLoader.LoadCartesianPoints(threads);
+    geometryLoader.ResolvePlacements(threads);
+    webifc::parsing::IfcLoader::ReadScope scope(*loader);
+    webifc::utility::ParallelProduce(
+        elements.size(), threads, BATCH_SIZE,
+        [&]()
+        { return std::make_unique<webifc::parsing::IfcLoader::ReadScope>(*loader); },
+        extract,
+        [&](std::pair<size_t, webifc::geometry::IfcCrossSections> &result)
+        { consume(result.first, result.second); });
+}
 
+std::vector<webifc::geometry::IfcCrossSections> GetAllCrossSections(uint32_t modelID, uint8_t dimensions)
+{
+    if (!manager.IsModelOpen(modelID))
+        return std::vector<webifc::geometry::IfcCrossSections>();
+    const std::vector<uint32_t> elements = GetSectionedElements(modelID);
+    std::vector<webifc::geometry::IfcCrossSections> crossSections(elements.size());
+    ForEachCrossSection(modelID, elements, dimensions, [&](size_t index, webifc::geometry::IfcCrossSections &sections)
+                        { crossSections[index] = std::move(sections); });
     return crossSections;
 }
 
-std::vector<webifc::geometry::IfcAlignment> GetAllAlignments(uint32_t modelID)
+// callback(crossSections, index, total) for every sectioned solid and surface, in the order they are done
+void StreamAllCrossSections(uint32_t modelID, uint8_t dimensions, emscripten::val callback)
 {
     if (!manager.IsModelOpen(modelID))
-        return std::vector<webifc::geometry::IfcAlignment>();
+        return;
+    const std::vector<uint32_t> elements = GetSectionedElements(modelID);
+    size_t done = 0;
+    ForEachCrossSection(modelID, elements, dimensions, [&](size_t index, webifc::geometry::IfcCrossSections &sections)
+                        { callback(sections, (int)done++, (int)elements.size()); });
+}
+
+// the alignments of the model in coordinated space, each with the 3D curve of its horizontal and vertical curves
+std::vector<webifc::geometry::IfcAlignment> ReadAlignments(uint32_t modelID)
+{
     auto geomLoader = manager.GetGeometryProcessor(modelID);
     auto type = webifc::schema::IFCALIGNMENT;
 
@@ -301,6 +1503,92 @@ std::vector<webifc::geometry::IfcAlignment> GetAllAlignments(uint32_t modelID)
     return alignments;
 }
 
+std::vector<webifc::geometry::IfcAlignment> GetAllAlignments(uint32_t modelID)
+{
+    if (!manager.IsModelOpen(modelID))
+        return std::vector<webifc::geometry::IfcAlignment>();
+    return ReadAlignments(modelID);
+}
+
+// the curves as { points, offsets, expressIDs }, see IfcPolylineBuffer, on the JS side in three typed arrays
+emscripten::val ToPolylineBuffer(const webifc::geometry::IfcPolylineBuffer &buffer)
+{
+    auto result = emscripten::val::object();
+    result.set("points", emscripten::val::global("Float32Array").new_(emscripten::typed_memory_view(buffer.points.size(), buffer.points.data())));
+    result.set("offsets", ToUint32Array(buffer.offsets));
+    result.set("expressIDs", ToUint32Array(buffer.expressIDs));
+    return result;
+}
+
+// the curves of the elements of the types, all that StreamAllMeshes meshes when typesVal is empty, of a model opened
+// with EXPORT_POLYLINES, in place and packed in one buffer instead of a value object per curve
+emscripten::val GetPolylines(uint32_t modelID, emscripten::val typesVal)
+{
+    if (!manager.IsModelOpen(modelID))
+        return emscripten::val::null();
+    std::vector<uint32_t> types = ToIDVector(typesVal);
+    if (types.empty())
+        types = GetMeshedElementTypes();
+    auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    auto &geometryLoader = geomLoader->GetLoader();
+    geometryLoader.LoadCartesianPoints(1);
+    geometryLoader.ResolvePlacements(1);
+    webifc::geometry::IfcPolylineBuffer buffer;
+    for (uint32_t type : types)
+    {
+        for (uint32_t expressID : loader->GetExpressIDsWithType(type))
+        {
+            geomLoader->AddPolylines(expressID, buffer);
+            geomLoader->TrimStreamingCaches();
+        }
+    }
+    geomLoader->Clear();
+    return ToPolylineBuffer(buffer);
+}
+
+// the curves of all alignments like GetAllAlignments packed in one buffer, with part 0 the horizontal curves, 1 the
+// vertical ones and 2 the 3D curve of every alignment
+emscripten::val GetAlignmentPolylines(uint32_t modelID, uint8_t part)
+{
+    if (!manager.IsModelOpen(modelID) || part > 2)
+        return emscripten::val::null();
+    auto elements = manager.GetIfcLoader(modelID)->GetExpressIDsWithType(webifc::schema::IFCALIGNMENT);
+    auto alignments = ReadAlignments(modelID);
+    webifc::geometry::IfcPolylineBuffer buffer;
+    for (size_t i = 0; i < alignments.size(); i++)
+    {
+        const auto &segment = part == 0 ? alignments[i].Horizontal : part == 1 ? alignments[i].Vertical : alignments[i].Absolute;
+        for (const auto &curve : segment.curves)
+        {
+            for (const auto &point : curve.points)
+                buffer.AddPoint(point);
+            buffer.EndCurve(elements[i]);
+        }
+    }
+    return ToPolylineBuffer(buffer);
+}
+
+// the terrains of the element left out of its mesh by TERRAIN_CHUNK_TRIANGLES, chunk by chunk with their vertices in
+// place. The arrays of a chunk are views that are only valid during the callback. -1 when the model is not open, else
+// the number of chunks
+int StreamTerrain(uint32_t modelID, uint32_t expressID, double maxError, emscripten::val callback)
+{
+    if (!manager.IsModelOpen(modelID))
+        return -1;
+    size_t chunks = manager.GetGeometryProcessor(modelID)->StreamTerrain(expressID, maxError, [&](const webifc::geometry::IfcTerrainChunk &chunk)
+                                                                        {
+        auto result = emscripten::val::object();
+        result.set("expressID", chunk.expressID);
+        result.set("index", chunk.index);
+        result.set("count", chunk.count);
+        result.set("color", chunk.color);
+        result.set("vertexData", emscripten::val(emscripten::typed_memory_view(chunk.vertexData.size(), chunk.vertexData.data())));
+        result.set("indexData", emscripten::val(emscripten::typed_memory_view(chunk.indexData.size(), chunk.indexData.data())));
+        callback(result); });
+    return static_cast<int>(chunks);
+}
+
 void SetGeometryTransformation(uint32_t modelID, std::array<double, 16> m)
 {
     if (manager.IsModelOpen(modelID))
@@ -312,69 +1600,60 @@ std::array<double, 16> GetCoordinationMatrix(uint32_t modelID)
     return manager.IsModelOpen(modelID) ? manager.GetGeometryProcessor(modelID)->GetFlatCoordinationMatrix() : std::array<double, 16>();
 }
 
-std::vector<uint32_t> GetLineIDsWithType(uint32_t modelID, emscripten::val types)
+emscripten::val GetLineIDsWithType(uint32_t modelID, emscripten::val types)
 {
     if (!manager.IsModelOpen(modelID))
-        return {};
+        return ToUint32Array({});
     auto loader = manager.GetIfcLoader(modelID);
     std::vector<uint32_t> expressIDs;
 
-    uint32_t size = types["length"].as<uint32_t>();
-    for (uint32_t i = 0; i < size; i++)
+    for (uint32_t type : ToIDVector(types))
     {
-
-        uint32_t type = types[std::to_string(i)].as<uint32_t>();
         auto ids = loader->GetExpressIDsWithType(type);
         expressIDs.insert(expressIDs.end(), ids.begin(), ids.end());
     }
-    return expressIDs;
+    return ToUint32Array(expressIDs);
 }
 
-std::vector<uint32_t> GetInversePropertyForItem(uint32_t modelID, uint32_t expressID, emscripten::val targetTypes, uint32_t position, bool set)
+emscripten::val GetInversePropertyForItem(uint32_t modelID, uint32_t expressID, emscripten::val targetTypes, uint32_t position, bool set)
 {
+    std::vector<uint32_t> inverseIDs;
     if (!manager.IsModelOpen(modelID))
-        return {};
+        return ToUint32Array(inverseIDs);
     auto loader = manager.GetIfcLoader(modelID);
-    std::vector<uint32_t> inverseIDs;
-    auto expressIDs = GetLineIDsWithType(modelID, targetTypes);
-    for (auto foundExpressID : expressIDs)
+    // only the lines referencing expressID are visited instead of every line of the target types
+    auto references = loader->GetInverseReferences(expressID);
+    if (references.empty())
+        return ToUint32Array(inverseIDs);
+    for (auto type : ToIDVector(targetTypes))
     {
-        loader->MoveToLineArgument(foundExpressID, position);
-
-        webifc::parsing::IfcTokenType t = loader->GetTokenType();
-        if (t == webifc::parsing::IfcTokenType::REF)
-        {
-            loader->StepBack();
-            uint32_t val = loader->GetRefArgument();
-            if (val == expressID)
-            {
-                inverseIDs.push_back(foundExpressID);
-                if (!set)
-                    return inverseIDs;
-            }
-        }
-        else if (t == webifc::parsing::IfcTokenType::SET_BEGIN)
+        for (auto &reference : references)
         {
-            while (!loader->IsAtEnd())
-            {
-                webifc::parsing::IfcTokenType setValueType = loader->GetTokenType();
-                if (setValueType == webifc::parsing::IfcTokenType::SET_END)
-                    break;
-                if (setValueType == webifc::parsing::IfcTokenType::REF)
-                {
-                    loader->StepBack();
-                    uint32_t val = loader->GetRefArgument();
-                    if (val == expressID)
-                    {
-                        inverseIDs.push_back(foundExpressID);
-                        if (!set)
-                            return inverseIDs;
-                    }
-                }
-            }
+            if (reference.argumentIndex != position || loader->GetLineType(reference.expressID) != type)
+                continue;
+            inverseIDs.push_back(reference.expressID);
+            if (!set)
+                return ToUint32Array(inverseIDs);
         }
     }
-    return inverseIDs;
+    return ToUint32Array(inverseIDs);
+}
+
+// the spatial tree of every IfcProject in the layout of IfcRelationshipIndex::GetSpatialTree
+emscripten::val GetSpatialTree(uint32_t modelID, bool propertySets, bool typeProperties)
+{
+    if (!manager.IsModelOpen(modelID))
+        return ToUint32Array({});
+    auto loader = manager.GetIfcLoader(modelID);
+    return ToUint32Array(loader->GetRelationshipIndex().GetSpatialTree(*loader, propertySets, typeProperties));
+}
+
+// per element the number of its property sets and their expressIDs
+emscripten::val GetPropertySetIDs(uint32_t modelID, emscripten::val expressIDsVal, bool typeProperties)
+{
+    if (!manager.IsModelOpen(modelID))
+        return ToUint32Array({});
+    return ToUint32Array(manager.GetIfcLoader(modelID)->GetRelationshipIndex().GetPropertySets(ToIDVector(expressIDsVal), typeProperties));
 }
 
 bool ValidateExpressID(uint32_t modelID, uint32_t expressId)
@@ -387,9 +1666,9 @@ uint32_t GetNextExpressID(uint32_t modelID, uint32_t expressId)
     return manager.IsModelOpen(modelID) ? manager.GetIfcLoader(modelID)->GetNextExpressID(expressId) : 0;
 }
 
-std::vector<uint32_t> GetAllLines(uint32_t modelID)
+emscripten::val GetAllLines(uint32_t modelID)
 {
-    return manager.IsModelOpen(modelID) ? manager.GetIfcLoader(modelID)->GetAllLines() : std::vector<uint32_t>();
+    return ToUint32Array(manager.IsModelOpen(modelID) ? manager.GetIfcLoader(modelID)->GetAllLines() : std::vector<uint32_t>());
 }
 
 bool WriteValue(uint32_t modelID, webifc::parsing::IfcTokenType t, emscripten::val value)
@@ -597,10 +1876,14 @@ bool WriteHeaderLine(uint32_t modelID, uint32_t type, emscripten::val parameters
     return responseCode;
 }
 
+// the geometry derived from a line is dropped before it changes and once more after it is written, for what it then
+// references, so that only the elements depending on it mesh anew
 void RemoveLine(uint32_t modelID, uint32_t expressID)
 {
-    if (manager.IsModelOpen(modelID))
-        manager.GetIfcLoader(modelID)->RemoveLine(expressID);
+    if (!manager.IsModelOpen(modelID))
+        return;
+    manager.GetGeometryProcessor(modelID)->InvalidateLines({expressID});
+    manager.GetIfcLoader(modelID)->RemoveLine(expressID);
 }
 
 bool WriteLine(uint32_t modelID, uint32_t expressID, uint32_t type, emscripten::val parameters)
@@ -608,6 +1891,8 @@ bool WriteLine(uint32_t modelID, uint32_t expressID, uint32_t type, emscripten::
     if (!manager.IsModelOpen(modelID))
         return false;
     auto loader = manager.GetIfcLoader(modelID);
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    geomLoader->InvalidateLines({expressID});
     uint32_t start = loader->GetTotalSize();
 
     // line ID
@@ -625,9 +1910,41 @@ bool WriteLine(uint32_t modelID, uint32_t expressID, uint32_t type, emscripten::
     loader->Push<uint8_t>(webifc::parsing::IfcTokenType::LINE_END);
 
     loader->UpdateLineTape(expressID, type, start);
+    geomLoader->InvalidateLines({expressID});
     return responseCode;
 }
 
+// writes many lines in one call from a buffer in the layout GetLinesBinary exports, so lines read with it can be written
+// back unchanged, nothing is written when the buffer is malformed
+bool WriteLinesBinary(uint32_t modelID, emscripten::val bytes)
+{
+    if (!manager.IsModelOpen(modelID))
+        return false;
+    const std::vector<uint8_t> data = emscripten::convertJSArrayToNumberVector<uint8_t>(bytes);
+    // the expressIDs of the lines, AppendLines checks the rest of the layout
+    std::vector<uint32_t> expressIDs;
+    uint32_t count = 0;
+    if (data.size() >= sizeof(uint32_t))
+        std::memcpy(&count, data.data(), sizeof(uint32_t));
+    for (uint32_t i = 0; i < count && (i + 2) * sizeof(uint32_t) <= data.size(); i++)
+    {
+        uint32_t offset = 0;
+        std::memcpy(&offset, data.data() + (i + 1) * sizeof(uint32_t), sizeof(uint32_t));
+        uint32_t expressID = 0;
+        if (offset <= data.size() - sizeof(uint32_t))
+            std::memcpy(&expressID, data.data() + offset, sizeof(uint32_t));
+        expressIDs.push_back(expressID);
+    }
+    // what the replaced lines related is read before they are overwritten, the geometry is dropped once all are written
+    auto geomLoader = manager.GetGeometryProcessor(modelID);
+    std::vector<uint32_t> lines = geomLoader->GetRelatedLines(expressIDs);
+    if (!manager.GetIfcLoader(modelID)->AppendLines(data.data(), data.size()))
+        return false;
+    lines.insert(lines.end(), expressIDs.begin(), expressIDs.end());
+    geomLoader->InvalidateLines(lines);
+    return true;
+}
+
 emscripten::val ReadValue(uint32_t modelID, webifc::parsing::IfcTokenType t)
 {
     auto loader = manager.GetIfcLoader(modelID);
@@ -798,14 +2115,128 @@ emscripten::val GetLine(uint32_t modelID, uint32_t expressID)
 emscripten::val GetLines(uint32_t modelID, emscripten::val expressIDs)
 {
     auto result = emscripten::val::array();
-    uint32_t size = expressIDs["length"].as<uint32_t>();
+    const std::vector<uint32_t> ids = ToIDVector(expressIDs);
 
-    for (size_t x = 0; x < size; x++)
-        result.set(x, GetLine(modelID, expressIDs[x].as<uint32_t>()));
+    for (size_t x = 0; x < ids.size(); x++)
+        result.set(x, GetLine(modelID, ids[x]));
 
     return result;
 }
 
+namespace
+{
+    template <typename T>
+    void AppendBinary(std::vector<uint8_t> &buffer, T value)
+    {
+        const size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    void AppendBinaryString(std::vector<uint8_t> &buffer, std::string_view value)
+    {
+        AppendBinary<uint32_t>(buffer, static_cast<uint32_t>(value.size()));
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    // the tokens of the line's arguments as GetArgs reads them, up to the set that closes the arguments
+    void AppendBinaryArguments(uint32_t modelID, std::vector<uint8_t> &buffer)
+    {
+        using webifc::parsing::IfcTokenType;
+        auto loader = manager.GetIfcLoader(modelID);
+        uint32_t depth = 0;
+        std::string decoded;
+        while (!loader->IsAtEnd())
+        {
+            const IfcTokenType t = loader->GetTokenType();
+            if (t == IfcTokenType::LINE_END || (t == IfcTokenType::SET_END && depth == 0))
+                break;
+            switch (t)
+            {
+            case IfcTokenType::EMPTY:
+                AppendBinary<uint8_t>(buffer, t);
+                break;
+            case IfcTokenType::SET_BEGIN:
+                depth++;
+                AppendBinary<uint8_t>(buffer, t);
+                break;
+            case IfcTokenType::SET_END:
+                depth--;
+                AppendBinary<uint8_t>(buffer, t);
+                break;
+            case IfcTokenType::LABEL:
+                loader->StepBack();
+                AppendBinary<uint8_t>(buffer, t);
+                AppendBinary<uint32_t>(buffer, manager.GetSchemaManager().IfcTypeToTypeCode(loader->GetStringArgument()));
+                break;
+            case IfcTokenType::STRING:
+                loader->StepBack();
+                AppendBinary<uint8_t>(buffer, t);
+                AppendBinaryString(buffer, loader->GetDecodedStringArgument(decoded));
+                break;
+            case IfcTokenType::ENUM:
+                loader->StepBack();
+                AppendBinary<uint8_t>(buffer, t);
+                AppendBinaryString(buffer, loader->GetStringArgument());
+                break;
+            case IfcTokenType::REAL:
+                loader->StepBack();
+                AppendBinary<uint8_t>(buffer, t);
+                AppendBinaryString(buffer, loader->GetDoubleArgumentAsString());
+                break;
+            case IfcTokenType::INTEGER:
+                loader->StepBack();
+                AppendBinary<uint8_t>(buffer, t);
+                AppendBinary<double>(buffer, static_cast<double>(loader->GetIntArgument()));
+                break;
+            case IfcTokenType::REF:
+                loader->StepBack();
+                AppendBinary<uint8_t>(buffer, t);
+                AppendBinary<uint32_t>(buffer, loader->GetRefArgument());
+                break;
+            default:
+                break;
+            }
+        }
+        AppendBinary<uint8_t>(buffer, IfcTokenType::LINE_END);
+    }
+}
+
+// the lines in one buffer instead of a value per token, little endian: the uint32 line count, a uint32 byte offset per
+// line and then the lines. A line is its uint32 expressID and type, 0 for lines that do not exist, and the tokens of its
+// arguments: a uint8 token type and its value, a uint32 length and the bytes for STRING, ENUM and REAL, a float64 for
+// INTEGER, a uint32 for REF and the type code for LABEL. Sets are enclosed by SET_BEGIN and SET_END and a line ends
+// with LINE_END. The view is valid until the next call
+emscripten::val GetLinesBinary(uint32_t modelID, emscripten::val expressIDs)
+{
+    static std::vector<uint8_t> buffer;
+    buffer.clear();
+    const std::vector<uint32_t> ids = ToIDVector(expressIDs);
+    const uint32_t count = ids.size();
+    const bool open = manager.IsModelOpen(modelID);
+    auto loader = open ? manager.GetIfcLoader(modelID) : nullptr;
+
+    AppendBinary<uint32_t>(buffer, count);
+    buffer.resize(buffer.size() + count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t offset = static_cast<uint32_t>(buffer.size());
+        std::memcpy(buffer.data() + sizeof(uint32_t) * (i + 1), &offset, sizeof(uint32_t));
+        const uint32_t expressID = ids[i];
+        const uint32_t lineType = open && loader->IsValidExpressID(expressID) ? loader->GetLineType(expressID) : 0;
+        AppendBinary<uint32_t>(buffer, lineType == 0 ? 0 : expressID);
+        AppendBinary<uint32_t>(buffer, lineType);
+        if (lineType == 0)
+        {
+            AppendBinary<uint8_t>(buffer, webifc::parsing::IfcTokenType::LINE_END);
+            continue;
+        }
+        loader->MoveToArgumentOffset(expressID, 0);
+        AppendBinaryArguments(modelID, buffer);
+    }
+    return emscripten::val(emscripten::typed_memory_view(buffer.size(), buffer.data()));
+}
+
 uint32_t GetLineType(uint32_t modelID, uint32_t expressID)
 {
     return manager.IsModelOpen(modelID) ? manager.GetIfcLoader(modelID)->GetLineType(expressID) : 0;
@@ -816,6 +2247,16 @@ std::string GetVersion()
     return std::string(WEB_IFC_VERSION_NUMBER);
 }
 
+// the expressID of the line with each GlobalId, 0 for GlobalIds no line has
+emscripten::val GetExpressIDsByGlobalIds(uint32_t modelID, emscripten::val globalIdsVal)
+{
+    if (!manager.IsModelOpen(modelID))
+        return ToUint32Array({});
+    const std::vector<std::string> globalIds = emscripten::vecFromJSArray<std::string>(globalIdsVal);
+    const std::vector<std::string_view> views(globalIds.begin(), globalIds.end());
+    return ToUint32Array(manager.GetIfcLoader(modelID)->GetExpressIDsByGlobalIds(views));
+}
+
 std::string GenerateGuid(uint32_t modelID)
 {
     if (!manager.IsModelOpen(modelID))
@@ -839,6 +2280,21 @@ void SetLogLevel(uint8_t levelArg)
     manager.SetLogLevel(levelArg);
 }
 
+void SetTracing(bool enabled)
+{
+    webifc::utility::trace::SetEnabled(enabled);
+}
+
+std::string GetTrace()
+{
+    return webifc::utility::trace::ExportChromeTrace();
+}
+
+void ClearTrace()
+{
+    webifc::utility::trace::Clear();
+}
+
 std::string EncodeText(std::string text)
 {
     const std::string_view strView{text};
@@ -919,6 +2375,34 @@ bimGeometry::Profile CreateProfile()
     return bimGeometry::Profile();
 }
 
+// the buffers of every primitive of a packed description, see bimGeometry::BatchKind, generated on several threads with
+// the tolerances of the calling thread, as { fvertexData, indexData, ranges } with four ranges per item. Null when the
+// description is malformed
+emscripten::val GetBatchBuffers(emscripten::val packedVal)
+{
+    std::vector<std::function<bimGeometry::Buffers()>> items;
+    if (!bimGeometry::ReadBatch(emscripten::convertJSArrayToNumberVector<double>(packedVal), items))
+        return emscripten::val::null();
+    const double scalarEquality = bimGeometry::_TOLERANCE_SCALAR_EQUALITY;
+    const double planeRefitIterations = bimGeometry::_PLANE_REFIT_ITERATIONS;
+    const double booleanUnionThreshold = bimGeometry::_BOOLEAN_UNION_THRESHOLD;
+    const double circleChordTolerance = bimGeometry::_CIRCLE_CHORD_TOLERANCE;
+    std::vector<bimGeometry::Buffers> buffers(items.size());
+    webifc::utility::ParallelFor(items.size(), webifc::utility::GetThreadCount(), [&](size_t i)
+                                 {
+        bimGeometry::_TOLERANCE_SCALAR_EQUALITY = scalarEquality;
+        bimGeometry::_PLANE_REFIT_ITERATIONS = planeRefitIterations;
+        bimGeometry::_BOOLEAN_UNION_THRESHOLD = booleanUnionThreshold;
+        bimGeometry::_CIRCLE_CHORD_TOLERANCE = circleChordTolerance;
+        buffers[i] = items[i](); });
+    const bimGeometry::BatchBuffers batch = bimGeometry::JoinBatchBuffers(buffers);
+    auto result = emscripten::val::object();
+    result.set("fvertexData", emscripten::val::global("Float32Array").new_(emscripten::typed_memory_view(batch.fvertexData.size(), batch.fvertexData.data())));
+    result.set("indexData", ToUint32Array(batch.indexData));
+    result.set("ranges", ToUint32Array(batch.ranges));
+    return result;
+}
+
 EMSCRIPTEN_BINDINGS(my_module)
 {
 
@@ -928,7 +2412,12 @@ EMSCRIPTEN_BINDINGS(my_module)
         .function("GetVertexDataSize", &webifc::geometry::IfcGeometry::GetVertexDataSize)
         .function("GetIndexData", &webifc::geometry::IfcGeometry::GetIndexData)
         .function("GetIndexDataSize", &webifc::geometry::IfcGeometry::GetIndexDataSize)
-        .function("GetSweptDiskSolid", &webifc::geometry::IfcGeometry::GetSweptDiskSolid);
+        .function("GetSweptDiskSolid", &webifc::geometry::IfcGeometry::GetSweptDiskSolid)
+        .function("GetVertexFormat", &webifc::geometry::IfcGeometry::GetVertexFormat)
+        .function("GetQuantizationOffset", &webifc::geometry::IfcGeometry::GetQuantizationOffset)
+        .function("GetQuantizationScale", &webifc::geometry::IfcGeometry::GetQuantizationScale)
+        .function("GetVertexArray", &GetGeometryVertexArray)
+        .function("GetIndexArray", &GetGeometryIndexArray);
 
     emscripten::value_object<glm::dvec4>("dvec4")
         .field("x", &glm::dvec4::x)
@@ -948,7 +2437,21 @@ EMSCRIPTEN_BINDINGS(my_module)
         .field("TOLERANCE_INSIDE_OUTSIDE_PERIMETER", &webifc::manager::LoaderSettings::TOLERANCE_INSIDE_OUTSIDE_PERIMETER)
         .field("TOLERANCE_SCALAR_EQUALITY", &webifc::manager::LoaderSettings::TOLERANCE_SCALAR_EQUALITY)
         .field("PLANE_REFIT_ITERATIONS", &webifc::manager::LoaderSettings::PLANE_REFIT_ITERATIONS)
-        .field("BOOLEAN_UNION_THRESHOLD", &webifc::manager::LoaderSettings::BOOLEAN_UNION_THRESHOLD);
+        .field("BOOLEAN_UNION_THRESHOLD", &webifc::manager::LoaderSettings::BOOLEAN_UNION_THRESHOLD)
+        .field("BINARY_NUMBERS", &webifc::manager::LoaderSettings::BINARY_NUMBERS)
+        .field("PARALLEL_TOKENIZING", &webifc::manager::LoaderSettings::PARALLEL_TOKENIZING)
+        .field("GEOMETRY_MEMORY_LIMIT", &webifc::manager::LoaderSettings::GEOMETRY_MEMORY_LIMIT)
+        .field("VERTEX_FORMAT", &webifc::manager::LoaderSettings::VERTEX_FORMAT)
+        .field("WELD_VERTICES", &webifc::manager::LoaderSettings::WELD_VERTICES)
+        .field("OPTIMIZE_VERTEX_CACHE", &webifc::manager::LoaderSettings::OPTIMIZE_VERTEX_CACHE)
+        .field("CIRCLE_CHORD_TOLERANCE", &webifc::manager::LoaderSettings::CIRCLE_CHORD_TOLERANCE)
+        .field("BOOLEAN_TIME_BUDGET", &webifc::manager::LoaderSettings::BOOLEAN_TIME_BUDGET)
+        .field("ELEMENT_TIME_BUDGET", &webifc::manager::LoaderSettings::ELEMENT_TIME_BUDGET)
+        .field("BOOLEAN_FACE_BUDGET", &webifc::manager::LoaderSettings::BOOLEAN_FACE_BUDGET)
+        .field("EXPORT_POLYLINES", &webifc::manager::LoaderSettings::EXPORT_POLYLINES)
+        .field("TERRAIN_CHUNK_TRIANGLES", &webifc::manager::LoaderSettings::TERRAIN_CHUNK_TRIANGLES)
+        .field("INCLUDE_TYPES", &GetIncludeTypes, &SetIncludeTypes)
+        .field("EXCLUDE_TYPES", &GetExcludeTypes, &SetExcludeTypes);
 
     emscripten::value_array<std::array<double, 16>>("array_double_16")
         .element(emscripten::index<0>())
@@ -1120,26 +2623,69 @@ EMSCRIPTEN_BINDINGS(my_module)
     emscripten::function("CreateAlignment", &CreateAlignment);
     emscripten::function("CreateBooleanOperator", &CreateBoolean);
     emscripten::function("CreateProfile", &CreateProfile);
+    emscripten::function("GetBatchBuffers", &GetBatchBuffers);
     emscripten::function("LoadAllGeometry", &LoadAllGeometry);
     emscripten::function("GetAllCrossSections", &GetAllCrossSections);
+    emscripten::function("StreamAllCrossSections", &StreamAllCrossSections);
     emscripten::function("GetAllAlignments", &GetAllAlignments);
+    emscripten::function("GetPolylines", &GetPolylines);
+    emscripten::function("GetAlignmentPolylines", &GetAlignmentPolylines);
+    emscripten::function("StreamTerrain", &StreamTerrain);
     emscripten::function("OpenModel", &OpenModel);
+    emscripten::function("OpenModels", &OpenModels);
+    emscripten::function("AttachModel", &AttachModel);
+    emscripten::function("ProbeModel", &ProbeModel);
     emscripten::function("CreateModel", &CreateModel);
     emscripten::function("GetMaxExpressID", &GetMaxExpressID);
     emscripten::function("CloseModel", &CloseModel);
     emscripten::function("GetModelSize", &GetModelSize);
+    emscripten::function("GetMemoryStats", &GetMemoryStats);
     emscripten::function("IsModelOpen", &IsModelOpen);
     emscripten::function("GetGeometry", &GetGeometry);
+    emscripten::function("GetGeometryLOD", &GetGeometryLOD);
     emscripten::function("GetFlatMesh", &GetFlatMesh);
+    emscripten::function("GetFlatMeshLOD", &GetFlatMeshLOD);
     emscripten::function("GetCoordinationMatrix", &GetCoordinationMatrix);
     emscripten::function("StreamMeshes", &StreamMeshesWithExpressID);
+    emscripten::function("StreamMeshesWorldSpace", &StreamMeshesWorldSpace);
+    emscripten::function("GetFlatMeshWorldSpace", &GetFlatMeshWorldSpace);
+    emscripten::function("StreamMeshesLOD", &StreamMeshesLOD);
+    emscripten::function("StreamInstancedMeshes", &StreamInstancedMeshes);
+    emscripten::function("StreamMeshesBatched", &StreamMeshesBatched);
+    emscripten::function("GetMergedMeshes", &GetMergedMeshes);
+    emscripten::function("BuildSpatialIndex", &BuildSpatialIndex);
+    emscripten::function("DetectClashes", &DetectClashes);
+    emscripten::function("RayCast", &RayCast);
+    emscripten::function("FrustumQuery", &FrustumQuery);
+    emscripten::function("ClosestPoint", &ClosestPoint);
+    emscripten::function("SetGeometryProfiling", &SetGeometryProfiling);
+    emscripten::function("GetGeometryProfile", &GetGeometryProfile);
+    emscripten::function("ResetGeometryProfile", &ResetGeometryProfile);
+    emscripten::function("GetOverBudgetElements", &GetOverBudgetElements);
+    emscripten::function("ClearOverBudgetElements", &ClearOverBudgetElements);
+    emscripten::function("InvalidateLines", &InvalidateLines);
     emscripten::function("StreamAllMeshes", &StreamAllMeshes);
+    emscripten::function("StreamAllMeshesPrioritized", &StreamAllMeshesPrioritized);
+    emscripten::function("ExportGLB", &ExportGLB);
+    emscripten::function("ExportTiles", &ExportTiles);
+    emscripten::function("GetElementQuantities", &GetElementQuantities);
     emscripten::function("StreamAllMeshesWithTypes", &StreamAllMeshesWithTypesVal);
+    emscripten::function("GetPartitionManifest", &GetPartitionManifest);
+    emscripten::function("StreamAllMeshesShard", &StreamAllMeshesShard);
+    emscripten::function("BeginStream", &BeginStream);
+    emscripten::function("StepStream", &StepStream);
+    emscripten::function("EndStream", &EndStream);
     emscripten::function("GetLine", &GetLine);
     emscripten::function("GetLines", &GetLines);
+    emscripten::function("GetLinesBinary", &GetLinesBinary);
+    emscripten::function("PinGeometry", &PinGeometry);
+    emscripten::function("ReleaseGeometry", &ReleaseGeometry);
+    emscripten::function("GetPinnedVertexArray", &GetPinnedVertexArray);
+    emscripten::function("GetPinnedIndexArray", &GetPinnedIndexArray);
     emscripten::function("GetLineType", &GetLineType);
     emscripten::function("GetHeaderLine", &GetHeaderLine);
     emscripten::function("WriteLine", &WriteLine);
+    emscripten::function("WriteLinesBinary", &WriteLinesBinary);
     emscripten::function("RemoveLine", &RemoveLine);
     emscripten::function("WriteHeaderLine", &WriteHeaderLine);
     emscripten::function("SaveModel", &SaveModel);
@@ -1147,9 +2693,14 @@ EMSCRIPTEN_BINDINGS(my_module)
     emscripten::function("GetNextExpressID", &GetNextExpressID);
     emscripten::function("GetLineIDsWithType", &GetLineIDsWithType);
     emscripten::function("GetInversePropertyForItem", &GetInversePropertyForItem);
+    emscripten::function("GetSpatialTree", &GetSpatialTree);
+    emscripten::function("GetPropertySetIDs", &GetPropertySetIDs);
     emscripten::function("GetAllLines", &GetAllLines);
     emscripten::function("SetGeometryTransformation", &SetGeometryTransformation);
     emscripten::function("SetLogLevel", &SetLogLevel);
+    emscripten::function("SetTracing", &SetTracing);
+    emscripten::function("GetTrace", &GetTrace);
+    emscripten::function("ClearTrace", &ClearTrace);
     emscripten::function("GetNameFromTypeCode", &GetNameFromTypeCode);
     emscripten::function("GetTypeCodeFromName", &GetTypeCodeFromName);
     emscripten::function("IsIfcElement", &IsIfcElement);
@@ -1158,4 +2709,5 @@ EMSCRIPTEN_BINDINGS(my_module)
     emscripten::function("DecodeText", &DecodeText);
     emscripten::function("EncodeText", &EncodeText);
     emscripten::function("GenerateGuid", &GenerateGuid);
+    emscripten::function("GetExpressIDsByGlobalIds", &GetExpressIDsByGlobalIds);
 }
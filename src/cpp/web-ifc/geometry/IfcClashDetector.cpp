@@ -0,0 +1,302 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <tuple>
+#include <spdlog/spdlog.h>
+#include "IfcClashDetector.h"
+#include "IfcSpatialIndex.h"
+#include "../utility/parallel.h"
+
+namespace webifc::geometry
+{
+
+  namespace
+  {
+    using Triangle = std::array<glm::dvec3, 3>;
+
+    // element pairs narrowed down on the threads at once before their clashes are handed on
+    constexpr size_t CLASH_BATCH_SIZE = 256;
+
+    // separating axis test, on the normals, the edges of each triangle in its plane for coplanar pairs and the cross
+    // products of their edges: the triangles clash unless their projections on one of the axes are tolerance apart
+    bool TrianglesClash(const Triangle &a, const Triangle &b, double tolerance)
+    {
+      const std::array<glm::dvec3, 3> edgesA = {a[1] - a[0], a[2] - a[1], a[0] - a[2]};
+      const std::array<glm::dvec3, 3> edgesB = {b[1] - b[0], b[2] - b[1], b[0] - b[2]};
+      auto separates = [&](const glm::dvec3 &axis, double scale)
+      {
+        const double length = glm::length(axis);
+        // parallel edges and degenerate triangles give no axis
+        if (!(length > EPS_TINY * scale))
+        {
+          return false;
+        }
+        const glm::dvec3 n = axis / length;
+        const double a0 = glm::dot(n, a[0]), a1 = glm::dot(n, a[1]), a2 = glm::dot(n, a[2]);
+        const double b0 = glm::dot(n, b[0]), b1 = glm::dot(n, b[1]), b2 = glm::dot(n, b[2]);
+        const double gap = std::max(std::min({b0, b1, b2}) - std::max({a0, a1, a2}), std::min({a0, a1, a2}) - std::max({b0, b1, b2}));
+        return gap >= tolerance;
+      };
+
+      const glm::dvec3 normalA = glm::cross(edgesA[0], edgesA[1]);
+      const glm::dvec3 normalB = glm::cross(edgesB[0], edgesB[1]);
+      if (separates(normalA, glm::length(edgesA[0]) * glm::length(edgesA[1])) || separates(normalB, glm::length(edgesB[0]) * glm::length(edgesB[1])))
+      {
+        return false;
+      }
+      for (const auto &edgeA : edgesA)
+      {
+        for (const auto &edgeB : edgesB)
+        {
+          if (separates(glm::cross(edgeA, edgeB), glm::length(edgeA) * glm::length(edgeB)))
+          {
+            return false;
+          }
+        }
+      }
+      for (int i = 0; i < 3; i++)
+      {
+        if (separates(glm::cross(normalA, edgesA[i]), glm::length(normalA) * glm::length(edgesA[i])) || separates(glm::cross(normalB, edgesB[i]), glm::length(normalB) * glm::length(edgesB[i])))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    Triangle GetPlacedTriangle(const fuzzybools::Geometry &geometry, uint32_t face, const glm::dmat4 &transformation)
+    {
+      Triangle triangle;
+      for (int i = 0; i < 3; i++)
+      {
+        triangle[i] = glm::dvec3(transformation * glm::dvec4(geometry.GetPoint(geometry.indexData[face * 3 + i]), 1));
+      }
+      return triangle;
+    }
+
+    bool BoxesOverlap(const fuzzybools::AABB &a, const fuzzybools::AABB &b, double margin)
+    {
+      return a.max.x + margin >= b.min.x && b.max.x + margin >= a.min.x &&
+             a.max.y + margin >= b.min.y && b.max.y + margin >= a.min.y &&
+             a.max.z + margin >= b.min.z && b.max.z + margin >= a.min.z;
+    }
+  }
+
+  void IfcClashDetector::Add(uint32_t set, uint32_t expressID, uint32_t geometryExpressID, const IfcGeometry &geometry, const glm::dmat4 &transformation)
+  {
+    if (set > 1)
+    {
+      return;
+    }
+    const Mesh *mesh = nullptr;
+    auto existing = _meshByGeometry[set].find(geometryExpressID);
+    if (existing != _meshByGeometry[set].end())
+    {
+      mesh = existing->second;
+    }
+    else
+    {
+      const size_t size = static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS;
+      auto newMesh = std::make_unique<Mesh>();
+      if (geometry.vertexData.size() == size)
+      {
+        newMesh->geometry.vertexData = geometry.vertexData;
+      }
+      else if (geometry.fvertexData.size() == size)
+      {
+        newMesh->geometry.vertexData.assign(geometry.fvertexData.begin(), geometry.fvertexData.end());
+      }
+      else
+      {
+        spdlog::warn("[ClashDetector::Add()] vertices of geometry {} were released", geometryExpressID);
+        _meshByGeometry[set][geometryExpressID] = nullptr;
+        return;
+      }
+      newMesh->geometry.indexData = geometry.indexData;
+      newMesh->geometry.numPoints = geometry.numPoints;
+      newMesh->geometry.numFaces = geometry.numFaces;
+      newMesh->bvh = fuzzybools::MakeBVH(newMesh->geometry);
+      mesh = newMesh.get();
+      _meshes.push_back(std::move(newMesh));
+      _meshByGeometry[set][geometryExpressID] = mesh;
+    }
+
+    const glm::dmat3 linear(transformation);
+    const double determinant = glm::determinant(linear);
+    if (mesh == nullptr || mesh->geometry.numFaces == 0 || !std::isfinite(determinant) || determinant == 0)
+    {
+      return;
+    }
+    Instance instance{expressID, mesh, transformation, glm::inverse(transformation), GetMinScale(linear), fuzzybools::AABB()};
+    const auto &local = mesh->bvh.box;
+    for (int corner = 0; corner < 8; corner++)
+    {
+      const glm::dvec4 point((corner & 1) ? local.max.x : local.min.x, (corner & 2) ? local.max.y : local.min.y, (corner & 4) ? local.max.z : local.min.z, 1);
+      instance.box.merge(glm::dvec3(transformation * point));
+    }
+    _instances[set].push_back(instance);
+  }
+
+  void IfcClashDetector::Clear()
+  {
+    _meshes.clear();
+    for (int set = 0; set < 2; set++)
+    {
+      _meshByGeometry[set].clear();
+      _instances[set].clear();
+    }
+  }
+
+  bool IfcClashDetector::InstancesClash(const Instance &a, const Instance &b, double tolerance) const
+  {
+    // the faces of the smaller mesh are looked up in the BVH of the larger one, in its local space
+    const bool swap = a.mesh->geometry.numFaces < b.mesh->geometry.numFaces;
+    const Instance &tree = swap ? b : a;
+    const Instance &probe = swap ? a : b;
+    const double margin = std::max(tolerance, 0.0);
+    const double localMargin = margin / tree.minScale;
+    const auto &nodes = tree.mesh->bvh.nodes;
+    const auto &faceBoxes = tree.mesh->bvh.boxes;
+
+    std::array<uint32_t, fuzzybools::BVH_STACK_SIZE> stack;
+    for (uint32_t face = 0; face < probe.mesh->geometry.numFaces; face++)
+    {
+      const Triangle placed = GetPlacedTriangle(probe.mesh->geometry, face, probe.transformation);
+      fuzzybools::AABB placedBox;
+      for (const auto &point : placed)
+      {
+        placedBox.merge(point);
+      }
+      if (!BoxesOverlap(placedBox, tree.box, margin))
+      {
+        continue;
+      }
+      fuzzybools::AABB localBox;
+      for (const auto &point : placed)
+      {
+        localBox.merge(glm::dvec3(tree.inverse * glm::dvec4(point, 1)));
+      }
+
+      size_t stackSize = 0;
+      stack[stackSize++] = 0;
+      while (stackSize > 0)
+      {
+        const auto &node = nodes[stack[--stackSize]];
+        if (!BoxesOverlap(node.box, localBox, localMargin))
+        {
+          continue;
+        }
+        if (!node.IsLeaf())
+        {
+          stack[stackSize++] = node.left;
+          stack[stackSize++] = node.right;
+          continue;
+        }
+        for (uint32_t i = node.start; i < node.end; i++)
+        {
+          if (BoxesOverlap(faceBoxes[i], localBox, localMargin) && TrianglesClash(GetPlacedTriangle(tree.mesh->geometry, faceBoxes[i].index, tree.transformation), placed, tolerance))
+          {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  void IfcClashDetector::Detect(double tolerance, bool skipSameExpressID, size_t threads, const std::function<void(const std::vector<IfcClash> &)> &onClashes) const
+  {
+    // sweep and prune along x over the boxes of both sets, only pairs across the sets are kept
+    const double margin = std::max(tolerance, 0.0);
+    std::vector<std::pair<uint32_t, uint32_t>> order;
+    order.reserve(_instances[0].size() + _instances[1].size());
+    for (uint32_t set = 0; set < 2; set++)
+    {
+      for (uint32_t i = 0; i < _instances[set].size(); i++)
+      {
+        order.emplace_back(set, i);
+      }
+    }
+    std::sort(order.begin(), order.end(), [&](const auto &first, const auto &second)
+              { return _instances[first.first][first.second].box.min.x < _instances[second.first][second.second].box.min.x; });
+
+    // expressIDs of the pair, then the instances of each set
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> candidates;
+    std::vector<uint32_t> active[2];
+    for (const auto &[set, index] : order)
+    {
+      const Instance &instance = _instances[set][index];
+      for (uint32_t activeSet = 0; activeSet < 2; activeSet++)
+      {
+        auto &list = active[activeSet];
+        list.erase(std::remove_if(list.begin(), list.end(), [&](uint32_t other)
+                                  { return _instances[activeSet][other].box.max.x + margin < instance.box.min.x; }),
+                   list.end());
+      }
+      for (uint32_t other : active[1 - set])
+      {
+        const Instance &otherInstance = _instances[1 - set][other];
+        if (!BoxesOverlap(instance.box, otherInstance.box, margin))
+        {
+          continue;
+        }
+        const Instance &a = set == 0 ? instance : otherInstance;
+        const Instance &b = set == 0 ? otherInstance : instance;
+        if (skipSameExpressID && a.expressID == b.expressID)
+        {
+          continue;
+        }
+        candidates.emplace_back(a.expressID, b.expressID, set == 0 ? index : other, set == 0 ? other : index);
+      }
+      active[set].push_back(index);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // the placements of an element pair are tested one after the other, the pairs are spread over the threads
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t begin = 0; begin < candidates.size();)
+    {
+      size_t end = begin + 1;
+      while (end < candidates.size() && std::get<0>(candidates[end]) == std::get<0>(candidates[begin]) && std::get<1>(candidates[end]) == std::get<1>(candidates[begin]))
+      {
+        end++;
+      }
+      pairs.emplace_back(begin, end);
+      begin = end;
+    }
+
+    std::vector<uint8_t> clashes;
+    std::vector<IfcClash> batch;
+    for (size_t first = 0; first < pairs.size(); first += CLASH_BATCH_SIZE)
+    {
+      const size_t count = std::min(CLASH_BATCH_SIZE, pairs.size() - first);
+      clashes.assign(count, 0);
+      utility::ParallelFor(count, threads, [&](size_t i)
+                           {
+        const auto [begin, end] = pairs[first + i];
+        for (size_t c = begin; c < end && !clashes[i]; c++)
+        {
+          clashes[i] = InstancesClash(_instances[0][std::get<2>(candidates[c])], _instances[1][std::get<3>(candidates[c])], tolerance);
+        } });
+      batch.clear();
+      for (size_t i = 0; i < count; i++)
+      {
+        if (clashes[i])
+        {
+          const auto &candidate = candidates[pairs[first + i].first];
+          batch.push_back({std::get<0>(candidate), std::get<1>(candidate)});
+        }
+      }
+      if (!batch.empty())
+      {
+        onClashes(batch);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,63 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "representation/IfcGeometry.h"
+#include "operations/boolean-utils/bvh.h"
+
+namespace webifc::geometry
+{
+
+  struct IfcClash
+  {
+    // of the first and the second set
+    uint32_t expressIDA;
+    uint32_t expressIDB;
+  };
+
+  // clashes between the placed meshes of two sets of elements, which may come from different models: a sweep and prune
+  // over the placed boxes finds the pairs of placements that may touch, then their triangles are tested against each
+  // other through the triangle BVH of one of them, on several threads. Every geometry gets one BVH, shared by all its
+  // placements in the set
+  class IfcClashDetector
+  {
+  public:
+    // set is 0 or 1, the geometry is copied the first time its geometryExpressID is added to the set
+    void Add(uint32_t set, uint32_t expressID, uint32_t geometryExpressID, const IfcGeometry &geometry, const glm::dmat4 &transformation);
+    // calls onClashes on the calling thread with the clashing pairs of elements, in batches and in a fixed order. Two
+    // elements clash when a triangle of one comes closer than tolerance to a triangle of the other, with a negative
+    // tolerance they have to overlap by that much, so that faces that only touch are not reported. Pairs of the same
+    // expressID are skipped when skipSameExpressID is set, for sets from the same model
+    void Detect(double tolerance, bool skipSameExpressID, size_t threads, const std::function<void(const std::vector<IfcClash> &)> &onClashes) const;
+    void Clear();
+
+  private:
+    struct Mesh
+    {
+      fuzzybools::Geometry geometry;
+      fuzzybools::BVH bvh;
+    };
+    struct Instance
+    {
+      uint32_t expressID;
+      const Mesh *mesh;
+      glm::dmat4 transformation;
+      glm::dmat4 inverse;
+      // no vector gets shorter than by this factor under the transformation
+      double minScale;
+      fuzzybools::AABB box;
+    };
+    bool InstancesClash(const Instance &a, const Instance &b, double tolerance) const;
+    std::vector<std::unique_ptr<Mesh>> _meshes;
+    std::unordered_map<uint32_t, const Mesh *> _meshByGeometry[2];
+    std::vector<Instance> _instances[2];
+  };
+}
@@ -4,9 +4,12 @@
 
 #include <spdlog/spdlog.h>
 #include <iomanip>
+#include <array>
 #include "IfcGeometryLoader.h"
 #include "operations/curve-utils.h"
 #include "operations/geometryutils.h"
+#include "../utility/parallel.h"
+#include "../utility/scratch.h"
 #ifdef DEBUG_DUMP_SVG
 #include "../../test/io_helpers.h"
 #include "../../test/dumpToThree.h"
@@ -16,30 +19,157 @@ namespace webifc::geometry
 {
 
   IfcGeometryLoader::IfcGeometryLoader(const webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, uint16_t circleSegments, double TOLERANCE_PLANE_INTERSECTION, double TOLERANCE_PLANE_DEVIATION, double TOLERANCE_BACK_DEVIATION_DISTANCE, double TOLERANCE_INSIDE_OUTSIDE_PERIMETER, double TOLERANCE_SCALAR_EQUALITY, double PLANE_REFIT_ITERATIONS, double BOOLEAN_UNION_THRESHOLD)
-      : _loader(loader), _schemaManager(schemaManager), _relVoids(PopulateRelVoidsMap()), _relNests(PopulateRelNestsMap()), _relAggregates(PopulateRelAggregatesMap()),
-        _styledItems(PopulateStyledItemMap()), _relMaterials(PopulateRelMaterialsMap()), _materialDefinitions(PopulateMaterialDefinitionsMap()), _circleSegments(circleSegments)
+      : _loader(loader), _schemaManager(schemaManager), _circleSegments(circleSegments)
   {
     ReadLinearScalingFactor();
   }
 
   void IfcGeometryLoader::ResetCache()
   {
-    _relVoids = PopulateRelVoidsMap();
-    _relAggregates = PopulateRelAggregatesMap();
-    _relNests = PopulateRelNestsMap();
-    _styledItems = PopulateStyledItemMap();
-    _relMaterials = PopulateRelMaterialsMap();
-    _materialDefinitions = PopulateMaterialDefinitionsMap();
+    std::lock_guard<std::mutex> lock(_relations.mutex);
+    _relations.built = 0;
+    _resolvedPlacements.clear();
+    _resolvedPlacementIndices.clear();
+    _pointStore = PointStore();
+    _styleStore = StyleStore();
+  }
+
+  void IfcGeometryLoader::AddMemoryStats(utility::MemoryStats &stats) const
+  {
+    _expressIDToPlacement.ForEach([&](const auto &placements) { stats.placementBytes += utility::MapBytes(placements); });
+    stats.placementBytes += utility::VectorBytes(_resolvedPlacements) + utility::MapBytes(_resolvedPlacementIndices);
+    _cartesianPoint3DCache.ForEach([&](const auto &points) { stats.pointBytes += utility::MapBytes(points); });
+    _cartesianPoint2DCache.ForEach([&](const auto &points) { stats.pointBytes += utility::MapBytes(points); });
+    stats.pointBytes += utility::VectorBytes(_pointStore.slots) + utility::VectorBytes(_pointStore.x) + utility::VectorBytes(_pointStore.y) + utility::VectorBytes(_pointStore.z);
+    _localCurves.ForEach([&](const LocalCurveCache &cache) { stats.curveBytes += cache.bytes + utility::MapBytes(cache.curves); });
+    _profiles.ForEach([&](const ProfileCache &cache) { stats.profileBytes += cache.bytes + utility::MapBytes(cache.profiles); });
+    stats.relationBytes += utility::MapOfVectorsBytes(_relVoids) + utility::MapOfVectorsBytes(_relNests) + utility::MapOfVectorsBytes(_relAggregates);
+    stats.relationBytes += utility::VectorBytes(_styleStore.slots) + utility::VectorBytes(_styleStore.colors);
+    stats.relationBytes += utility::MapOfVectorsBytes(_styledItems) + utility::MapOfVectorsBytes(_relMaterials) + utility::MapOfVectorsBytes(_materialDefinitions);
+  }
+
+  void IfcGeometryLoader::LoadRelations() const
+  {
+    ensureRelations(RELATIONS_ALL);
+  }
+
+  void IfcGeometryLoader::ensureRelations(const uint8_t relations) const
+  {
+    if ((_relations.built.load(std::memory_order_acquire) & relations) == relations) return;
+    std::lock_guard<std::mutex> lock(_relations.mutex);
+    const uint8_t missing = relations & ~_relations.built.load(std::memory_order_relaxed);
+    std::vector<uint8_t> pending;
+    for (uint8_t relation = 1; relation <= RELATIONS_ALL; relation <<= 1)
+    {
+      if (missing & relation) pending.push_back(relation);
+    }
+    // each map reads the loader through its own cursor, so the maps are built concurrently when threads are available
+    size_t threads = std::min(utility::GetThreadCount(), pending.size());
+    if (threads > 1 && !_loader.PrepareConcurrentReads()) threads = 1;
+    utility::ParallelFor(pending.size(), threads, [&](const size_t i)
+    {
+      if (threads == 1)
+      {
+        buildRelation(pending[i]);
+        return;
+      }
+      parsing::IfcLoader::ReadScope scope(_loader);
+      buildRelation(pending[i]);
+    });
+    _relations.built.fetch_or(missing, std::memory_order_release);
+  }
+
+  void IfcGeometryLoader::buildRelation(const uint8_t relation) const
+  {
+    switch (relation)
+    {
+    case RELATIONS_VOIDS:
+      _relVoids = PopulateRelVoidsMap();
+      _relAggregates = PopulateRelAggregatesMap();
+      break;
+    case RELATIONS_NESTS:
+      _relNests = PopulateRelNestsMap();
+      break;
+    case RELATIONS_STYLED_ITEMS:
+      _styledItems = PopulateStyledItemMap();
+      break;
+    case RELATIONS_MATERIALS:
+      _relMaterials = PopulateRelMaterialsMap();
+      break;
+    case RELATIONS_MATERIAL_DEFINITIONS:
+      _materialDefinitions = PopulateMaterialDefinitionsMap();
+      break;
+    default:
+      break;
+    }
   }
 
   void IfcGeometryLoader::Clear() const
   {
-    _expressIDToPlacement.clear();
-    std::unordered_map<uint32_t, glm::dmat4>().swap(_expressIDToPlacement);
-    _cartesianPoint3DCache.clear();
-    std::unordered_map<uint32_t, glm::dvec3>().swap(_cartesianPoint3DCache);
-    _cartesianPoint2DCache.clear();
-    std::unordered_map<uint32_t, glm::dvec2>().swap(_cartesianPoint2DCache);
+    _expressIDToPlacement.Clear();
+    _cartesianPoint3DCache.Clear();
+    _cartesianPoint2DCache.Clear();
+  }
+
+  void IfcGeometryLoader::ClearThread() const
+  {
+    _expressIDToPlacement.Get().clear();
+    _cartesianPoint3DCache.Get().clear();
+    _cartesianPoint2DCache.Get().clear();
+  }
+
+  void IfcGeometryLoader::Invalidate(const std::unordered_set<uint32_t> &expressIDs) const
+  {
+    auto erase = [&](auto &cache)
+    {
+      for (uint32_t expressID : expressIDs) cache.erase(expressID);
+    };
+    _expressIDToPlacement.ForEachMutable(erase);
+    _cartesianPoint3DCache.ForEachMutable(erase);
+    _cartesianPoint2DCache.ForEachMutable(erase);
+    // the records in the age order keep their bytes until they age out
+    _localCurves.ForEachMutable([&](LocalCurveCache &cache) { erase(cache.curves); });
+    _profiles.ForEachMutable([&](ProfileCache &cache) { erase(cache.profiles); });
+    // the tables fall back to reading the lines
+    erase(_resolvedPlacementIndices);
+    for (uint32_t expressID : expressIDs)
+    {
+      if (expressID < _pointStore.slots.size()) _pointStore.slots[expressID] = 0;
+    }
+    // a colour is read through a chain of lines, any of which may have changed
+    if (!expressIDs.empty()) _styleStore = StyleStore();
+  }
+
+  void IfcGeometryLoader::InvalidateRelations(const std::vector<uint32_t> &lineTypes) const
+  {
+    uint8_t relations = 0;
+    for (uint32_t lineType : lineTypes)
+    {
+      switch (lineType)
+      {
+      case schema::IFCRELVOIDSELEMENT:
+      case schema::IFCRELAGGREGATES:
+        relations |= RELATIONS_VOIDS;
+        break;
+      case schema::IFCRELNESTS:
+        relations |= RELATIONS_NESTS;
+        break;
+      case schema::IFCSTYLEDITEM:
+        relations |= RELATIONS_STYLED_ITEMS;
+        break;
+      case schema::IFCRELASSOCIATESMATERIAL:
+        relations |= RELATIONS_MATERIALS;
+        break;
+      case schema::IFCMATERIALDEFINITIONREPRESENTATION:
+        relations |= RELATIONS_MATERIAL_DEFINITIONS;
+        break;
+      default:
+        break;
+      }
+    }
+    if (relations == 0) return;
+    std::lock_guard<std::mutex> lock(_relations.mutex);
+    _relations.built.fetch_and(static_cast<uint8_t>(~relations));
   }
 
   IfcCrossSections IfcGeometryLoader::GetCrossSections2D(uint32_t expressID) const
@@ -165,23 +295,27 @@ namespace webifc::geometry
       double minDistance = mapPlacements.begin()->first;
       double maxDistance = mapPlacements.rbegin()->first;
       
-      IfcCurve BasisCurve = GetLocalCurve(curveID);
+      auto basisCurve = GetLocalCurve(curveID);
+      const IfcCurve &BasisCurve = *basisCurve;
       if (BasisCurve.points.size() == 0)
       {
           spdlog::error("[getPlacementsOnCurve] BasisCurve has no points {}", curveID);
           return;
       }
 
-      // re-compute placement at existing points
+      // the existing placements are computed again, then the ones at the start, at every point of the curve between
+      // the first and the last placement and at the end are added, all of them in one batch
+      std::vector<double> distances;
+      distances.reserve(mapPlacements.size() + BasisCurve.points.size() + 1);
       for (auto& it : mapPlacements)
       {
-          it.second = BasisCurve.getPlacementAtDistance(it.first, IfcCurve::CurvePlacementMode::TangentAsZAxis);
+          distances.push_back(it.first);
       }
-      
+      const size_t existing = distances.size();
+
       if (minDistance <= 0)
       {
-          glm::dmat4 result = BasisCurve.getPlacementAtDistance(0, IfcCurve::CurvePlacementMode::TangentAsZAxis);
-          mapPlacements.insert({ 0, result });
+          distances.push_back(0);
       }
 
       // get placement for each point on the curve
@@ -195,8 +329,7 @@ namespace webifc::geometry
 
           if (sumLength >= minDistance)
           {
-              glm::dmat4 result = BasisCurve.getPlacementAtDistance(sumLength, IfcCurve::CurvePlacementMode::TangentAsZAxis);
-              mapPlacements.insert({ sumLength, result });
+              distances.push_back(sumLength);
           }
           
           if (sumLength > maxDistance)
@@ -208,8 +341,22 @@ namespace webifc::geometry
 
       if (maxDistance >= sumLength)
       {
-          glm::dmat4 result = BasisCurve.getPlacementAtDistance(sumLength, IfcCurve::CurvePlacementMode::TangentAsZAxis);
-          mapPlacements.insert({ sumLength, result });
+          distances.push_back(sumLength);
+      }
+
+      std::vector<glm::dmat4> placements = BasisCurve.getPlacementsAtDistances(distances, IfcCurve::CurvePlacementMode::TangentAsZAxis);
+      size_t index = 0;
+      for (auto& it : mapPlacements)
+      {
+          it.second = placements[index++];
+          if (index == existing)
+          {
+              break;
+          }
+      }
+      for (size_t i = existing; i < distances.size(); i++)
+      {
+          mapPlacements.insert({ distances[i], placements[i] });
       }
   }
 
@@ -543,18 +690,18 @@ namespace webifc::geometry
         transform_t = GetLocalPlacement(localPlacement);
       }
 
-      if (_relAggregates.count(expressID) == 1)
+      if (getRelAggregates().count(expressID) == 1)
       {
-        auto &relAgg = _relAggregates.at(expressID);
+        auto &relAgg = getRelAggregates().at(expressID);
         for (auto expressID : relAgg)
         {
           alignment = GetAlignment(expressID, alignment, transform * transform_t, expressID);
         }
       }
 
-      if (_relNests.count(expressID) == 1)
+      if (getRelNests().count(expressID) == 1)
       {
-        auto &relNest = _relNests.at(expressID);
+        auto &relNest = getRelNests().at(expressID);
         for (auto expressID : relNest)
         {
           alignment = GetAlignment(expressID, alignment, transform * transform_t, expressID);
@@ -579,9 +726,9 @@ namespace webifc::geometry
         transform_t = GetLocalPlacement(localPlacement);
       }
 
-      if (_relAggregates.count(expressID) == 1)
+      if (getRelAggregates().count(expressID) == 1)
       {
-        auto &relAgg = _relAggregates.at(expressID);
+        auto &relAgg = getRelAggregates().at(expressID);
         for (auto expressID : relAgg)
         {
           alignment.Horizontal.curves.push_back(GetAlignmentCurve(expressID, sourceExpressID));
@@ -597,9 +744,9 @@ namespace webifc::geometry
         }
       }
 
-      if (_relNests.count(expressID) == 1)
+      if (getRelNests().count(expressID) == 1)
       {
-        auto &relNest = _relNests.at(expressID);
+        auto &relNest = getRelNests().at(expressID);
         for (auto expressID : relNest)
         {
           alignment.Horizontal.curves.push_back(GetAlignmentCurve(expressID, sourceExpressID));
@@ -633,9 +780,9 @@ namespace webifc::geometry
         transform_t = GetLocalPlacement(localPlacement);
       }
 
-      if (_relAggregates.count(expressID) == 1)
+      if (getRelAggregates().count(expressID) == 1)
       {
-        auto &relAgg = _relAggregates.at(expressID);
+        auto &relAgg = getRelAggregates().at(expressID);
         for (auto expressID : relAgg)
         {
           alignment.Vertical.curves.push_back(GetAlignmentCurve(expressID, sourceExpressID));
@@ -651,9 +798,9 @@ namespace webifc::geometry
         }
       }
 
-      if (_relNests.count(expressID) == 1)
+      if (getRelNests().count(expressID) == 1)
       {
-        auto &relNest = _relNests.at(expressID);
+        auto &relNest = getRelNests().at(expressID);
         for (auto expressID : relNest)
         {
           alignment.Vertical.curves.push_back(GetAlignmentCurve(expressID, sourceExpressID));
@@ -1257,6 +1404,119 @@ namespace webifc::geometry
     return {};
   }
 
+  std::optional<glm::dvec4> IfcGeometryLoader::resolveStyleColor(uint32_t expressID, std::unordered_map<uint32_t, std::optional<glm::dvec4>> &colors) const
+  {
+    // the walks start from style assignments, material definitions and materials that many items share
+    auto getColor = [&](uint32_t styleID)
+    {
+      auto it = colors.find(styleID);
+      if (it == colors.end())
+      {
+        it = colors.emplace(styleID, GetColor(styleID)).first;
+      }
+      return it->second;
+    };
+
+    std::optional<glm::dvec4> styledItemColor;
+    auto &styledItems = GetStyledItems();
+    auto &relMaterials = GetRelMaterials();
+    auto &materialDefinitions = GetMaterialDefinitions();
+    auto styledItem = styledItems.find(expressID);
+    if (styledItem != styledItems.end())
+    {
+      for (auto &item : styledItem->second)
+      {
+        styledItemColor = getColor(item.second);
+        if (styledItemColor)
+          break;
+      }
+    }
+
+    if (!styledItemColor)
+    {
+      auto material = relMaterials.find(expressID);
+      if (material != relMaterials.end())
+      {
+        for (auto &item : material->second)
+        {
+          auto defs = materialDefinitions.find(item.second);
+          if (defs != materialDefinitions.end())
+          {
+            for (auto &def : defs->second)
+            {
+              styledItemColor = getColor(def.second);
+              if (styledItemColor)
+                break;
+            }
+          }
+
+          // if no color found, check material itself
+          if (!styledItemColor)
+          {
+            styledItemColor = getColor(item.second);
+            if (styledItemColor)
+              break;
+          }
+        }
+      }
+    }
+    return styledItemColor;
+  }
+
+  void IfcGeometryLoader::ResolveStyles() const
+  {
+    auto &styledItems = GetStyledItems();
+    auto &relMaterials = GetRelMaterials();
+    StyleStore store;
+    // every line without a styled item or material has no colour, those added later are not resolved
+    store.slots.assign(_loader.GetMaxExpressId() + 1, 1);
+    store.colors.resize(2);
+    std::unordered_map<uint32_t, std::optional<glm::dvec4>> colors;
+    std::map<std::array<double, 4>, uint32_t> slotByColor;
+    auto resolve = [&](uint32_t expressID)
+    {
+      if (expressID >= store.slots.size() || store.slots[expressID] != 1)
+      {
+        return;
+      }
+      auto color = resolveStyleColor(expressID, colors);
+      if (!color)
+      {
+        return;
+      }
+      auto [it, added] = slotByColor.emplace(std::array<double, 4>{color->r, color->g, color->b, color->a}, static_cast<uint32_t>(store.colors.size()));
+      if (added)
+      {
+        store.colors.push_back(*color);
+      }
+      store.slots[expressID] = it->second;
+    };
+    for (auto &[expressID, styles] : styledItems)
+    {
+      resolve(expressID);
+    }
+    for (auto &[expressID, materials] : relMaterials)
+    {
+      resolve(expressID);
+    }
+    _styleStore = std::move(store);
+  }
+
+  std::optional<glm::dvec4> IfcGeometryLoader::GetStyleColor(uint32_t expressID) const
+  {
+    if (expressID < _styleStore.slots.size() && _styleStore.slots[expressID] != 0)
+    {
+      const uint32_t slot = _styleStore.slots[expressID];
+      if (slot == 1)
+      {
+        return std::nullopt;
+      }
+      return _styleStore.colors[slot];
+    }
+    std::unordered_map<uint32_t, std::optional<glm::dvec4>> colors;
+    return resolveStyleColor(expressID, colors);
+  }
+
   IfcBound3D IfcGeometryLoader::GetBound(uint32_t expressID) const
   {
     spdlog::debug("[GetBound({})]", expressID);
@@ -1324,14 +1584,14 @@ namespace webifc::geometry
       IfcCurve curve;
 
       _loader.MoveToArgumentOffset(expressID, 0);
-      auto points = _loader.GetSetArgument();
+      utility::ScratchVector<uint32_t> points;
+      _loader.GetRefSetArgument(*points);
 
-      curve.points.reserve(points.size());
+      curve.points.reserve(points->size());
 
       uint32_t prevID = 0;
-      for (auto &token : points)
+      for (uint32_t pointId : *points)
       {
-        uint32_t pointId = _loader.GetRefArgument(token);
 
         // trim out consecutive equal points
         if (pointId != prevID)
@@ -1349,12 +1609,12 @@ namespace webifc::geometry
       IfcCurve curve;
 
       _loader.MoveToArgumentOffset(expressID, 0);
-      auto edges = _loader.GetSetArgument();
+      utility::ScratchVector<uint32_t> edges;
+      _loader.GetRefSetArgument(*edges);
       int id = 0;
 
-      for (auto &token : edges)
+      for (uint32_t edgeId : *edges)
       {
-        uint32_t edgeId = _loader.GetRefArgument(token);
         IfcCurve edgeCurve = GetOrientedEdge(edgeId);
 
         // Important not to repeat the last point otherwise triangulation fails
@@ -1528,10 +1788,73 @@ namespace webifc::geometry
     return ts;
   }
 
+  void IfcGeometryLoader::LoadCartesianPoints(const size_t threads) const
+  {
+    const auto pointIDs = _loader.GetExpressIDsWithType(schema::IFCCARTESIANPOINT);
+    PointStore store;
+    if (!pointIDs.empty())
+    {
+      const uint32_t maxExpressID = std::max(_loader.GetMaxExpressId(), *std::max_element(pointIDs.begin(), pointIDs.end()));
+      store.slots.assign(maxExpressID + 1, 0);
+      store.x.resize(pointIDs.size() + 1);
+      store.y.resize(pointIDs.size() + 1);
+      store.z.resize(pointIDs.size() + 1);
+    }
+    auto decode = [&](const size_t begin, const size_t end)
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        const uint32_t slot = i + 1;
+        _loader.MoveToArgumentOffset(pointIDs[i], 0);
+        _loader.GetTokenType();
+        // because these calls cannot be reordered we have to use intermediate variables
+        store.x[slot] = _loader.GetDoubleArgument();
+        store.y[slot] = _loader.GetDoubleArgument();
+        store.z[slot] = _loader.GetOptionalDoubleParam(0);
+        store.slots[pointIDs[i]] = slot;
+      }
+    };
+    // every slot is written by one chunk only
+    const size_t chunkSize = 4096;
+    const size_t chunks = (pointIDs.size() + chunkSize - 1) / chunkSize;
+    if (threads > 1 && chunks > 1 && _loader.PrepareConcurrentReads())
+    {
+      utility::ParallelFor(chunks, threads, [&](const size_t chunk)
+                           {
+                             parsing::IfcLoader::ReadScope scope(_loader);
+                             decode(chunk * chunkSize, std::min(pointIDs.size(), (chunk + 1) * chunkSize)); });
+    }
+    else
+    {
+      decode(0, pointIDs.size());
+    }
+    _pointStore = std::move(store);
+  }
+
+  bool IfcGeometryLoader::findStoredPoint(const uint32_t expressID, glm::dvec3 &point) const
+  {
+    if (expressID >= _pointStore.slots.size())
+    {
+      return false;
+    }
+    const uint32_t slot = _pointStore.slots[expressID];
+    if (slot == 0)
+    {
+      return false;
+    }
+    point = glm::dvec3(_pointStore.x[slot], _pointStore.y[slot], _pointStore.z[slot]);
+    return true;
+  }
+
   glm::dvec3 IfcGeometryLoader::GetCartesianPoint3D(const uint32_t expressID) const
   {
     spdlog::debug("[GetCartesianPoint3D({})]", expressID);
-    if (auto it = _cartesianPoint3DCache.find(expressID); it != _cartesianPoint3DCache.end())
+    if (glm::dvec3 point; findStoredPoint(expressID, point))
+    {
+      return point;
+    }
+    auto &cache = _cartesianPoint3DCache.Get();
+    if (auto it = cache.find(expressID); it != cache.end())
     {
       return it->second;
     }
@@ -1542,14 +1865,19 @@ namespace webifc::geometry
     double y = _loader.GetDoubleArgument();
     double z = _loader.GetOptionalDoubleParam(0);
     glm::dvec3 point(x, y, z);
-    _cartesianPoint3DCache.emplace(expressID, point);
+    cache.emplace(expressID, point);
     return point;
   }
 
   glm::dvec2 IfcGeometryLoader::GetCartesianPoint2D(const uint32_t expressID) const
   {
     spdlog::debug("[GetCartesianPoint2D({})]", expressID);
-    if (auto it = _cartesianPoint2DCache.find(expressID); it != _cartesianPoint2DCache.end())
+    if (glm::dvec3 point; findStoredPoint(expressID, point))
+    {
+      return glm::dvec2(point);
+    }
+    auto &cache = _cartesianPoint2DCache.Get();
+    if (auto it = cache.find(expressID); it != cache.end())
     {
       return it->second;
     }
@@ -1559,7 +1887,7 @@ namespace webifc::geometry
     double x = _loader.GetDoubleArgument();
     double y = _loader.GetDoubleArgument();
     glm::dvec2 point(x, y);
-    _cartesianPoint2DCache.emplace(expressID, point);
+    cache.emplace(expressID, point);
     return point;
   }
 
@@ -1587,6 +1915,18 @@ namespace webifc::geometry
 
     std::vector<glm::dvec3> result;
 
+    // large lists are converted in parallel, the token by token read below is kept for rounding and for malformed lists
+    std::vector<double> coordinates;
+    if (ROUNDING_ENABLE == 0 && _loader.GetNumberSetListArgument(coordinates, 3, utility::GetThreadCount()))
+    {
+      result.resize(coordinates.size() / 3);
+      for (size_t i = 0; i < result.size(); i++)
+      {
+        result[i] = glm::dvec3(coordinates[i * 3], coordinates[i * 3 + 1], coordinates[i * 3 + 2]);
+      }
+      return result;
+    }
+
     _loader.GetTokenType();
 
     // while we have point set begin
@@ -1720,11 +2060,11 @@ namespace webifc::geometry
     case schema::IFCPOLYLINE:
     {
       _loader.MoveToArgumentOffset(expressID, 0);
-      auto points = _loader.GetSetArgument();
+      utility::ScratchVector<uint32_t> points;
+      _loader.GetRefSetArgument(*points);
 
-      for (auto &token : points)
+      for (uint32_t pointId : *points)
       {
-        uint32_t pointId = _loader.GetRefArgument(token);
         if (params.dimensions == 2)
           curve.Add(GetCartesianPoint2D(pointId));
         else
@@ -2200,7 +2540,7 @@ namespace webifc::geometry
             }
         }
         curve.arcSegments.push_back(curve.points.size());
-        const int numPointsCurrentArc = _circleSegments;
+        const int numPointsCurrentArc = bimGeometry::GetArcPointCount(std::max(std::fabs(radius1), std::fabs(radius2)), openingAngleRad, _circleSegments);
         double deltaAngle = openingAngleRad / (numPointsCurrentArc - 1);
         double angle = startRad;
         std::vector<glm::dvec3> points;
@@ -3033,7 +3373,80 @@ namespace webifc::geometry
     }
   }
 
+  namespace
+  {
+    size_t GetProfileMemorySize(const IfcProfile &profile)
+    {
+      size_t size = sizeof(IfcProfile) + profile.curve.GetMemorySize() + profile.tags.capacity() * sizeof(double);
+      for (const auto &hole : profile.holes)
+      {
+        size += hole.GetMemorySize();
+      }
+      for (const auto &child : profile.profiles)
+      {
+        size += GetProfileMemorySize(child);
+      }
+      return size;
+    }
+  }
+
+  const std::vector<uint32_t> &IfcCachedProfile::GetCap(size_t index) const
+  {
+    if (!triangulated)
+    {
+      if (profile.isComposite)
+      {
+        for (const auto &child : profile.profiles)
+        {
+          caps.push_back(child.curve.points.empty() ? std::vector<uint32_t>() : TriangulateProfileCap(child));
+        }
+      }
+      else if (!profile.curve.points.empty())
+      {
+        caps.push_back(TriangulateProfileCap(profile));
+      }
+      triangulated = true;
+    }
+    static const std::vector<uint32_t> noCap;
+    return index < caps.size() ? caps[index] : noCap;
+  }
+
   IfcProfile IfcGeometryLoader::GetProfile(uint32_t expressID) const
+  {
+    return GetCachedProfile(expressID)->profile;
+  }
+
+  std::shared_ptr<const IfcCachedProfile> IfcGeometryLoader::GetCachedProfile(uint32_t expressID) const
+  {
+    auto &profiles = _profiles.Get();
+    const double chordTolerance = bimGeometry::_CIRCLE_CHORD_TOLERANCE;
+    if (auto it = profiles.profiles.find(expressID); it != profiles.profiles.end())
+    {
+      if (it->second->chordTolerance == chordTolerance)
+      {
+        return it->second;
+      }
+    }
+
+    auto cached = std::make_shared<IfcCachedProfile>();
+    cached->profile = ResolveProfile(expressID);
+    cached->chordTolerance = chordTolerance;
+    const size_t bytes = GetProfileMemorySize(cached->profile);
+    while (!profiles.order.empty() && profiles.bytes + bytes > PROFILE_CACHE_BYTES)
+    {
+      auto [oldestID, oldestBytes] = profiles.order.front();
+      profiles.order.pop_front();
+      profiles.profiles.erase(oldestID);
+      profiles.bytes -= oldestBytes;
+    }
+    // a profile built for another tolerance is replaced, its old record still ages out and takes the new entry with it
+    profiles.profiles.insert_or_assign(expressID, cached);
+    profiles.order.emplace_back(expressID, bytes);
+    profiles.bytes += bytes;
+    return cached;
+  }
+
+  IfcProfile IfcGeometryLoader::ResolveProfile(uint32_t expressID) const
   {
     spdlog::debug("[GetProfile({})]", expressID);
     auto profile = GetProfileByLine(expressID);
@@ -3803,27 +4216,145 @@ namespace webifc::geometry
     return glm::dmat3();
   }
 
-  IfcCurve IfcGeometryLoader::GetLocalCurve(uint32_t expressID) const
+  std::shared_ptr<const IfcCurve> IfcGeometryLoader::GetLocalCurve(uint32_t expressID) const
   {
     spdlog::debug("[GetLocalCurve({})]", expressID);
-    for (uint32_t i = 0; i < _localcurvesIndices.size(); i++)
+    auto &localCurves = _localCurves.Get();
+    if (auto it = localCurves.curves.find(expressID); it != localCurves.curves.end())
+    {
+      return it->second;
+    }
+    IfcCurve localCurve = GetCurve(expressID, 3, false);
+    // local curves are placed along by distance over and over, the arc lengths turn every placement into a lookup
+    localCurve.BuildArcLengths();
+    auto curve = std::make_shared<const IfcCurve>(std::move(localCurve));
+    const size_t bytes = curve->GetMemorySize();
+    while (!localCurves.order.empty() && localCurves.bytes + bytes > LOCAL_CURVE_CACHE_BYTES)
+    {
+      auto [oldestID, oldestBytes] = localCurves.order.front();
+      localCurves.order.pop_front();
+      localCurves.curves.erase(oldestID);
+      localCurves.bytes -= oldestBytes;
+    }
+    localCurves.curves.emplace(expressID, curve);
+    localCurves.order.emplace_back(expressID, bytes);
+    localCurves.bytes += bytes;
+    return curve;
+  }
+
+  void IfcGeometryLoader::ResolvePlacements(const size_t threads) const
+  {
+    const auto placementIDs = _loader.GetExpressIDsWithType(schema::IFCLOCALPLACEMENT);
+    std::unordered_map<uint32_t, uint32_t> indices;
+    indices.reserve(placementIDs.size());
+    for (uint32_t i = 0; i < placementIDs.size(); i++)
+    {
+      indices.emplace(placementIDs[i], i);
+    }
+
+    // PlacementRelTo, either another local placement of the table or a placement of another type
+    constexpr uint32_t NO_PARENT = UINT32_MAX;
+    std::vector<uint32_t> parents(placementIDs.size(), NO_PARENT);
+    std::vector<uint32_t> parentIDs(placementIDs.size(), 0);
+    for (uint32_t i = 0; i < placementIDs.size(); i++)
     {
-      if (_localcurvesIndices[i] == expressID)
+      _loader.MoveToArgumentOffset(placementIDs[i], 0);
+      if (_loader.GetTokenType() != parsing::IfcTokenType::REF)
+      {
+        continue;
+      }
+      _loader.StepBack();
+      parentIDs[i] = _loader.GetRefArgument();
+      if (auto it = indices.find(parentIDs[i]); it != indices.end())
       {
-        return _localCurvesList[i];
+        parents[i] = it->second;
       }
     }
-    IfcCurve curve = GetCurve(expressID, 3, false);
-    _localcurvesIndices.push_back(expressID);
-    _localCurvesList.push_back(curve);
-    return curve;
+
+    // group the placements by their depth in the tree, a placement that ends up in a cycle is treated as a root
+    constexpr uint32_t UNKNOWN_DEPTH = UINT32_MAX;
+    constexpr uint32_t VISITING = UINT32_MAX - 1;
+    std::vector<uint32_t> depths(placementIDs.size(), UNKNOWN_DEPTH);
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<uint32_t> chain;
+    for (uint32_t i = 0; i < placementIDs.size(); i++)
+    {
+      for (uint32_t current = i; current != NO_PARENT && depths[current] == UNKNOWN_DEPTH; current = parents[current])
+      {
+        depths[current] = VISITING;
+        chain.push_back(current);
+      }
+      while (!chain.empty())
+      {
+        const uint32_t current = chain.back();
+        chain.pop_back();
+        const uint32_t parent = parents[current];
+        if (parent != NO_PARENT && depths[parent] == VISITING)
+        {
+          spdlog::error("[ResolvePlacements()] cyclic placement {}", placementIDs[current]);
+          parents[current] = NO_PARENT;
+          parentIDs[current] = 0;
+        }
+        depths[current] = parents[current] == NO_PARENT ? 0 : depths[parents[current]] + 1;
+        if (levels.size() <= depths[current])
+        {
+          levels.resize(depths[current] + 1);
+        }
+        levels[depths[current]].push_back(current);
+      }
+    }
+
+    std::vector<glm::dmat4> placements(placementIDs.size(), glm::dmat4(1));
+    auto resolve = [&](const uint32_t index)
+    {
+      glm::dmat4 relPlacement(1);
+      if (parents[index] != NO_PARENT)
+      {
+        relPlacement = placements[parents[index]];
+      }
+      else if (parentIDs[index] != 0)
+      {
+        relPlacement = GetLocalPlacement(parentIDs[index]);
+      }
+      _loader.MoveToArgumentOffset(placementIDs[index], 1);
+      return relPlacement * GetLocalPlacement(_loader.GetRefArgument());
+    };
+    const bool parallel = threads > 1 && _loader.PrepareConcurrentReads();
+    for (const auto &level : levels)
+    {
+      if (!parallel)
+      {
+        for (const uint32_t index : level)
+        {
+          placements[index] = resolve(index);
+        }
+        continue;
+      }
+      // a level only reads the levels above it, which are complete
+      utility::ParallelProduce(
+          level.size(), threads, 64,
+          [&]()
+          { return std::make_unique<parsing::IfcLoader::ReadScope>(_loader); },
+          [&](const size_t i)
+          { return std::make_pair(level[i], resolve(level[i])); },
+          [&](std::pair<uint32_t, glm::dmat4> &result)
+          { placements[result.first] = result.second; });
+    }
+
+    _resolvedPlacements = std::move(placements);
+    _resolvedPlacementIndices = std::move(indices);
   }
 
   glm::dmat4 IfcGeometryLoader::GetLocalPlacement(uint32_t expressID, glm::dvec3 vector) const
   {
-    if (_expressIDToPlacement.contains(expressID))
+    // vector only reaches the location of an IfcAxis2PlacementLinear, which is not a local placement
+    if (auto it = _resolvedPlacementIndices.find(expressID); it != _resolvedPlacementIndices.end())
     {
-      return _expressIDToPlacement[expressID];
+      return _resolvedPlacements[it->second];
+    }
+    if (auto it = _expressIDToPlacement.Get().find(expressID); it != _expressIDToPlacement.Get().end())
+    {
+      return it->second;
     }
     else
     {
@@ -3841,7 +4372,6 @@ namespace webifc::geometry
         //    IfcCurve								BasisCurve;
 
         _loader.MoveToArgumentOffset(expressID, 0);
-        IfcCurve curve;
         double DistanceAlong = 0;
         double OffsetLateral = 0;
         double OffsetVertical = 0;
@@ -3896,12 +4426,12 @@ namespace webifc::geometry
         {
             _loader.StepBack();
             auto curveId = _loader.GetRefArgument();
-            curve = GetLocalCurve(curveId);
-            result = curve.getPlacementAtDistance(DistanceAlong, IfcCurve::CurvePlacementMode::GlobalZAxis);
+            auto curve = GetLocalCurve(curveId);
+            result = curve->getPlacementAtDistance(DistanceAlong, IfcCurve::CurvePlacementMode::GlobalZAxis);
         }
         else
         {
-            result = curve.getPlacementAtDistance(DistanceAlong, IfcCurve::CurvePlacementMode::GlobalZAxis);
+            result = IfcCurve().getPlacementAtDistance(DistanceAlong, IfcCurve::CurvePlacementMode::GlobalZAxis);
         }
 
         if (std::abs(OffsetLateral) > EPS_SMALL || std::abs(OffsetVertical) > EPS_SMALL || std::abs(OffsetLongitudinal) > EPS_SMALL)
@@ -3910,7 +4440,7 @@ namespace webifc::geometry
             glm::dmat4 globalVerticalTranslation = glm::translate(glm::dmat4(1), glm::dvec3(0, 0, OffsetVertical));
             result = globalVerticalTranslation * (result * localTranslation);
         }
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       case schema::IFCAXIS1PLACEMENT:
@@ -3939,7 +4469,7 @@ namespace webifc::geometry
             glm::dvec4(zAxis, 0),
             glm::dvec4(pos, 1));
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       case schema::IFCAXIS2PLACEMENT3D:
@@ -3979,7 +4509,7 @@ namespace webifc::geometry
             glm::dvec4(zAxis, 0),
             glm::dvec4(pos, 1));
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
 
         return result;
       }
@@ -4012,7 +4542,7 @@ namespace webifc::geometry
             glm::dvec4(zAxis, 0),
             glm::dvec4(pos, 1));
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       case schema::IFCLOCALPLACEMENT:
@@ -4034,7 +4564,7 @@ namespace webifc::geometry
 
         auto result = relPlacement * axis2Placement;
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       case schema::IFCCARTESIANTRANSFORMATIONOPERATOR3D:
@@ -4119,7 +4649,7 @@ namespace webifc::geometry
             glm::dvec4(Axis3 * scale3, 0),
             glm::dvec4(LocalOrigin, 1));
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       case schema::IFCAXIS2PLACEMENTLINEAR:
@@ -4145,7 +4675,7 @@ namespace webifc::geometry
             result = GetLocalPlacement(posID, vector);
         }
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       case schema::IFCLINEARPLACEMENT:
@@ -4154,7 +4684,7 @@ namespace webifc::geometry
         uint32_t posID = _loader.GetRefArgument();
         glm::dmat4 result = GetLocalPlacement(posID);
 
-        _expressIDToPlacement[expressID] = result;
+        _expressIDToPlacement.Get()[expressID] = result;
         return result;
       }
       default:
@@ -4185,7 +4715,7 @@ namespace webifc::geometry
     return {axis, pos};
   }
 
-  std::unordered_map<uint32_t, std::vector<uint32_t>> IfcGeometryLoader::PopulateRelVoidsMap()
+  std::unordered_map<uint32_t, std::vector<uint32_t>> IfcGeometryLoader::PopulateRelVoidsMap() const
   {
     std::unordered_map<uint32_t, std::vector<uint32_t>> resultVector;
     auto relVoids = _loader.GetExpressIDsWithType(schema::IFCRELVOIDSELEMENT);
@@ -4203,7 +4733,7 @@ namespace webifc::geometry
     return resultVector;
   }
 
-  std::unordered_map<uint32_t, std::vector<uint32_t>> IfcGeometryLoader::PopulateRelAggregatesMap()
+  std::unordered_map<uint32_t, std::vector<uint32_t>> IfcGeometryLoader::PopulateRelAggregatesMap() const
   {
     std::unordered_map<uint32_t, std::vector<uint32_t>> resultVector;
     auto relAggregates = _loader.GetExpressIDsWithType(schema::IFCRELAGGREGATES);
@@ -4237,7 +4767,7 @@ namespace webifc::geometry
     return resultVector;
   }
 
-  std::unordered_map<uint32_t, std::vector<uint32_t>> IfcGeometryLoader::PopulateRelNestsMap()
+  std::unordered_map<uint32_t, std::vector<uint32_t>> IfcGeometryLoader::PopulateRelNestsMap() const
   {
     std::unordered_map<uint32_t, std::vector<uint32_t>> resultVector;
     auto relNests = _loader.GetExpressIDsWithType(schema::IFCRELNESTS);
@@ -4258,7 +4788,7 @@ namespace webifc::geometry
     return resultVector;
   }
 
-  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> IfcGeometryLoader::PopulateStyledItemMap()
+  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> IfcGeometryLoader::PopulateStyledItemMap() const
   {
     std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> returnVector;
     auto styledItems = _loader.GetExpressIDsWithType(schema::IFCSTYLEDITEM);
@@ -4284,7 +4814,7 @@ namespace webifc::geometry
     return returnVector;
   }
 
-  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> IfcGeometryLoader::PopulateRelMaterialsMap()
+  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> IfcGeometryLoader::PopulateRelMaterialsMap() const
   {
     std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> resultVector;
     auto styledItems = _loader.GetExpressIDsWithType(schema::IFCRELASSOCIATESMATERIAL);
@@ -4308,7 +4838,7 @@ namespace webifc::geometry
     return resultVector;
   }
 
-  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> IfcGeometryLoader::PopulateMaterialDefinitionsMap()
+  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> IfcGeometryLoader::PopulateMaterialDefinitionsMap() const
   {
     std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> resultVector;
     auto matDefs = _loader.GetExpressIDsWithType(schema::IFCMATERIALDEFINITIONREPRESENTATION);
@@ -4481,24 +5011,40 @@ namespace webifc::geometry
 
   const std::unordered_map<uint32_t, std::vector<uint32_t>> &IfcGeometryLoader::GetRelVoids() const
   {
+    ensureRelations(RELATIONS_MESH);
     return _relVoids;
   }
 
   const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &IfcGeometryLoader::GetStyledItems() const
   {
+    ensureRelations(RELATIONS_MESH);
     return _styledItems;
   }
 
   const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &IfcGeometryLoader::GetRelMaterials() const
   {
+    ensureRelations(RELATIONS_MESH);
     return _relMaterials;
   }
 
   const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &IfcGeometryLoader::GetMaterialDefinitions() const
   {
+    ensureRelations(RELATIONS_MESH);
     return _materialDefinitions;
   }
 
+  const std::unordered_map<uint32_t, std::vector<uint32_t>> &IfcGeometryLoader::getRelAggregates() const
+  {
+    ensureRelations(RELATIONS_VOIDS);
+    return _relAggregates;
+  }
+
+  const std::unordered_map<uint32_t, std::vector<uint32_t>> &IfcGeometryLoader::getRelNests() const
+  {
+    ensureRelations(RELATIONS_NESTS);
+    return _relNests;
+  }
+
   double IfcGeometryLoader::GetLinearScalingFactor() const
   {
     return _linearScalingFactor;
@@ -4602,13 +5148,15 @@ namespace webifc::geometry
 
   IfcGeometryLoader *IfcGeometryLoader::Clone(const webifc::parsing::IfcLoader &newLoader) const
   {
-    IfcGeometryLoader *newGeomLoader = new IfcGeometryLoader(newLoader, _schemaManager, _relVoids, _relNests, _relAggregates, _styledItems, _relMaterials, _materialDefinitions, _linearScalingFactor, _squaredScalingFactor, _cubicScalingFactor, _angularScalingFactor, _angleUnits, _circleSegments, _localCurvesList, _localcurvesIndices, _expressIDToPlacement);
+    ensureRelations(RELATIONS_ALL);
+    IfcGeometryLoader *newGeomLoader = new IfcGeometryLoader(newLoader, _schemaManager, _relVoids, _relNests, _relAggregates, _styledItems, _relMaterials, _materialDefinitions, _linearScalingFactor, _squaredScalingFactor, _cubicScalingFactor, _angularScalingFactor, _angleUnits, _circleSegments, _localCurves.Get(), _expressIDToPlacement.Get());
     return newGeomLoader;
   }
 
-  IfcGeometryLoader::IfcGeometryLoader(const webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relVoids, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relNests, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relAggregates, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &styledItems, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &relMaterials, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &materialDefinitions, double linearScalingFactor, double squaredScalingFactor, double cubicScalingFactor, double angularScalingFactor, std::string angleUnits, uint16_t circleSegments, std::vector<IfcCurve> &localCurvesList, std::vector<uint32_t> &localcurvesIndices, std::unordered_map<uint32_t, glm::dmat4> expressIDToPlacement)
-      : _loader(loader), _schemaManager(schemaManager), _relVoids(relVoids), _relNests(relNests), _relAggregates(relAggregates), _styledItems(styledItems), _relMaterials(relMaterials), _materialDefinitions(materialDefinitions), _linearScalingFactor(linearScalingFactor), _squaredScalingFactor(squaredScalingFactor), _cubicScalingFactor(cubicScalingFactor), _angularScalingFactor(angularScalingFactor), _angleUnits(angleUnits), _circleSegments(circleSegments), _localCurvesList(localCurvesList), _localcurvesIndices(localcurvesIndices), _expressIDToPlacement(expressIDToPlacement)
+  IfcGeometryLoader::IfcGeometryLoader(const webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relVoids, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relNests, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relAggregates, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &styledItems, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &relMaterials, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &materialDefinitions, double linearScalingFactor, double squaredScalingFactor, double cubicScalingFactor, double angularScalingFactor, std::string angleUnits, uint16_t circleSegments, const LocalCurveCache &localCurves, std::unordered_map<uint32_t, glm::dmat4> expressIDToPlacement)
+      : _loader(loader), _schemaManager(schemaManager), _relVoids(relVoids), _relNests(relNests), _relAggregates(relAggregates), _styledItems(styledItems), _relMaterials(relMaterials), _materialDefinitions(materialDefinitions), _linearScalingFactor(linearScalingFactor), _squaredScalingFactor(squaredScalingFactor), _cubicScalingFactor(cubicScalingFactor), _angularScalingFactor(angularScalingFactor), _angleUnits(angleUnits), _circleSegments(circleSegments), _localCurves(localCurves), _expressIDToPlacement(expressIDToPlacement)
   {
+    _relations.built = RELATIONS_ALL;
   }
 
 }
@@ -5,7 +5,12 @@
 #pragma once
 
 #include <map>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <optional>
 #include <cstdint>
@@ -13,6 +18,8 @@
 
 #include "../parsing/IfcLoader.h"
 #include "../schema/IfcSchemaManager.h"
+#include "../utility/parallel.h"
+#include "../utility/memory.h"
 
 #include "representation/geometry.h"
 #include "representation/IfcGeometry.h"
@@ -23,20 +30,53 @@
 namespace webifc::geometry
 {
 
+  // a resolved profile as GetProfile returns it, together with the triangulations of its caps
+  struct IfcCachedProfile
+  {
+    IfcProfile profile;
+    // the circle chord tolerance the outline was built with, the circle segments are fixed for a loader
+    double chordTolerance = 0;
+    // TriangulateProfileCap of the profile, or of its index'th profile when it is composite. The caps are made on first
+    // use, which is safe because every thread has cached profiles of its own
+    const std::vector<uint32_t> &GetCap(size_t index = 0) const;
+
+  private:
+    mutable std::vector<std::vector<uint32_t>> caps;
+    mutable bool triangulated = false;
+  };
+
   class IfcGeometryLoader
   {
   public:
     IfcGeometryLoader(const webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, uint16_t circleSegments, double TOLERANCE_PLANE_INTERSECTION, double TOLERANCE_PLANE_DEVIATION, double TOLERANCE_BACK_DEVIATION_DISTANCE, double TOLERANCE_INSIDE_OUTSIDE_PERIMETER, double TOLERANCE_SCALAR_EQUALITY, double, double BOOLEAN_UNION_THRESHOLD);
     void ResetCache();
+    // the caches of all threads and the relationship maps, no thread may read geometry meanwhile
+    void AddMemoryStats(utility::MemoryStats &stats) const;
+    // builds every relationship map now instead of on first use, call it before geometry is read from several threads
+    void LoadRelations() const;
     std::array<glm::dvec3, 2> GetAxis1Placement(const uint32_t expressID) const;
     glm::dmat3 GetAxis2Placement2D(const uint32_t expressID) const;
     glm::dmat4 GetLocalPlacement(const uint32_t expressID, glm::dvec3 vector = glm::dvec3(1)) const;
+    // resolves every IfcLocalPlacement of the model at once, parents before children and each level on up to `threads`
+    // threads. GetLocalPlacement then looks them up until ResetCache
+    void ResolvePlacements(const size_t threads) const;
+    // decodes every IfcCartesianPoint of the model into one table, GetCartesianPoint3D and GetCartesianPoint2D then read
+    // them from it until ResetCache. Placements read points, so this goes before ResolvePlacements
+    void LoadCartesianPoints(const size_t threads) const;
+    // resolves the colour of every styled representation item and of every object with a material at once, a style that
+    // many items share is read once. GetStyleColor then looks them up until ResetCache
+    void ResolveStyles() const;
+    // the colour of the styled item of the representation item, else of the materials of the object
+    std::optional<glm::dvec4> GetStyleColor(uint32_t expressID) const;
     glm::dvec3 GetCartesianPoint3D(const uint32_t expressID) const;
     glm::dvec2 GetCartesianPoint2D(const uint32_t expressID) const;
     glm::dvec3 GetVector(const uint32_t expressID) const;
     IfcProfile GetProfile(uint32_t expressID) const;
+    // the cached profile, it stays valid while the returned pointer is held
+    std::shared_ptr<const IfcCachedProfile> GetCachedProfile(uint32_t expressID) const;
     IfcProfile GetProfile3D(uint32_t expressID) const;
-    IfcCurve GetLocalCurve(uint32_t expressID) const;
+    // the curve is cached, it stays valid while the returned pointer is held
+    std::shared_ptr<const IfcCurve> GetLocalCurve(uint32_t expressID) const;
     IfcCurve GetCurve(uint32_t expressID, uint8_t dimensions, bool edge = false) const;
 
     // Helper function to compute the total length of the curve
@@ -68,10 +108,33 @@ namespace webifc::geometry
     double GetLinearScalingFactor() const;
     std::string GetAngleUnits() const;
     void Clear() const;
+    void ClearThread() const;
+    // drops the cached placements, points, profiles and curves of the lines on every thread, no thread may read geometry
+    // meanwhile
+    void Invalidate(const std::unordered_set<uint32_t> &expressIDs) const;
+    // the relationship maps lines of the types feed are built anew on next use
+    void InvalidateRelations(const std::vector<uint32_t> &lineTypes) const;
     IfcGeometryLoader *Clone(const webifc::parsing::IfcLoader &loader) const;
 
   private:
-    IfcGeometryLoader(const webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relVoids, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relNests, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relAggregates, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &styledItems, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &relMaterials, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &materialDefinitions, double linearScalingFactor, double squaredScalingFactor, double cubicScalingFactor, double angularScalingFactor, std::string angleUnits, uint16_t circleSegments, std::vector<IfcCurve> &localCurvesList, std::vector<uint32_t> &localcurvesIndices, std::unordered_map<uint32_t, glm::dmat4> expressIDToPlacement);
+    // curves by express id, the oldest are dropped once they hold more than LOCAL_CURVE_CACHE_BYTES
+    static constexpr size_t LOCAL_CURVE_CACHE_BYTES = 64 * 1024 * 1024;
+    struct LocalCurveCache
+    {
+      std::unordered_map<uint32_t, std::shared_ptr<const IfcCurve>> curves;
+      std::deque<std::pair<uint32_t, size_t>> order;
+      size_t bytes = 0;
+    };
+    // profiles by express id, the oldest are dropped once they hold more than PROFILE_CACHE_BYTES
+    static constexpr size_t PROFILE_CACHE_BYTES = 64 * 1024 * 1024;
+    struct ProfileCache
+    {
+      std::unordered_map<uint32_t, std::shared_ptr<const IfcCachedProfile>> profiles;
+      std::deque<std::pair<uint32_t, size_t>> order;
+      size_t bytes = 0;
+    };
+    IfcProfile ResolveProfile(uint32_t expressID) const;
+    IfcGeometryLoader(const webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relVoids, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relNests, const std::unordered_map<uint32_t, std::vector<uint32_t>> &relAggregates, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &styledItems, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &relMaterials, const std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> &materialDefinitions, double linearScalingFactor, double squaredScalingFactor, double cubicScalingFactor, double angularScalingFactor, std::string angleUnits, uint16_t circleSegments, const LocalCurveCache &localCurves, std::unordered_map<uint32_t, glm::dmat4> expressIDToPlacement);
     IfcCurve GetAlignmentCurve(uint32_t expressID, uint32_t parentExpressID = -1) const;
     IfcProfile GetProfileByLine(uint32_t expressID) const;
     glm::dvec3 GetVertexPoint(uint32_t expressID) const;
@@ -105,32 +168,81 @@ namespace webifc::geometry
     std::vector<IfcSegmentIndexSelect> ReadCurveIndices() const;
     const webifc::parsing::IfcLoader &_loader;
     const webifc::schema::IfcSchemaManager &_schemaManager;
-    std::unordered_map<uint32_t, std::vector<uint32_t>> _relVoids;
-    std::unordered_map<uint32_t, std::vector<uint32_t>> _relNests;
-    std::unordered_map<uint32_t, std::vector<uint32_t>> _relAggregates;
-    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> _styledItems;
-    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> _relMaterials;
-    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> _materialDefinitions;
+    // the relationship maps are only built when they are first needed, the aggregates are built with the voids
+    // because aggregated elements inherit the voids of their parent
+    enum Relations : uint8_t
+    {
+      RELATIONS_VOIDS = 1,
+      RELATIONS_NESTS = 2,
+      RELATIONS_STYLED_ITEMS = 4,
+      RELATIONS_MATERIALS = 8,
+      RELATIONS_MATERIAL_DEFINITIONS = 16,
+      // every mesh needs these, so they are built together
+      RELATIONS_MESH = RELATIONS_VOIDS | RELATIONS_STYLED_ITEMS | RELATIONS_MATERIALS | RELATIONS_MATERIAL_DEFINITIONS,
+      RELATIONS_ALL = RELATIONS_MESH | RELATIONS_NESTS
+    };
+    struct RelationsState
+    {
+      std::mutex mutex;
+      std::atomic<uint8_t> built = 0;
+      RelationsState() = default;
+      RelationsState(const RelationsState &other) : built(other.built.load()) {}
+    };
+    mutable RelationsState _relations;
+    mutable std::unordered_map<uint32_t, std::vector<uint32_t>> _relVoids;
+    mutable std::unordered_map<uint32_t, std::vector<uint32_t>> _relNests;
+    mutable std::unordered_map<uint32_t, std::vector<uint32_t>> _relAggregates;
+    mutable std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> _styledItems;
+    mutable std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> _relMaterials;
+    mutable std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> _materialDefinitions;
+    void ensureRelations(const uint8_t relations) const;
+    void buildRelation(const uint8_t relation) const;
+    const std::unordered_map<uint32_t, std::vector<uint32_t>> &getRelAggregates() const;
+    const std::unordered_map<uint32_t, std::vector<uint32_t>> &getRelNests() const;
     double _linearScalingFactor = 1;
     double _squaredScalingFactor = 1;
     double _cubicScalingFactor = 1;
     double _angularScalingFactor = 1;
     std::string _angleUnits;
     uint16_t _circleSegments;
-    mutable std::vector<IfcCurve> _localCurvesList;
-    mutable std::vector<uint32_t> _localcurvesIndices;
+    // the caches are kept per thread so that several threads can read geometry at once
+    utility::PerThread<LocalCurveCache> _localCurves;
+    utility::PerThread<ProfileCache> _profiles;
     // Caches to avoid repeatedly decoding the same points
-    mutable std::unordered_map<uint32_t, glm::dvec3> _cartesianPoint3DCache;
-    mutable std::unordered_map<uint32_t, glm::dvec2> _cartesianPoint2DCache;
-    std::unordered_map<uint32_t, std::vector<uint32_t>> PopulateRelVoidsMap();
-    std::unordered_map<uint32_t, std::vector<uint32_t>> PopulateRelNestsMap();
-    std::unordered_map<uint32_t, std::vector<uint32_t>> PopulateRelAggregatesMap();
-    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> PopulateStyledItemMap();
-    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> PopulateRelMaterialsMap();
-    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> PopulateMaterialDefinitionsMap();
+    utility::PerThread<std::unordered_map<uint32_t, glm::dvec3>> _cartesianPoint3DCache;
+    utility::PerThread<std::unordered_map<uint32_t, glm::dvec2>> _cartesianPoint2DCache;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> PopulateRelVoidsMap() const;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> PopulateRelNestsMap() const;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> PopulateRelAggregatesMap() const;
+    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> PopulateStyledItemMap() const;
+    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> PopulateRelMaterialsMap() const;
+    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> PopulateMaterialDefinitionsMap() const;
     void ReadLinearScalingFactor();
     double ConvertPrefix(const std::string_view &prefix);
-    mutable std::unordered_map<uint32_t, glm::dmat4> _expressIDToPlacement;
+    utility::PerThread<std::unordered_map<uint32_t, glm::dmat4>> _expressIDToPlacement;
+    // filled by LoadCartesianPoints and only read while geometry is read, slots maps an express id to its index in x, y
+    // and z, 0 is no point
+    struct PointStore
+    {
+      std::vector<uint32_t> slots;
+      std::vector<double> x;
+      std::vector<double> y;
+      std::vector<double> z;
+    };
+    mutable PointStore _pointStore;
+    bool findStoredPoint(const uint32_t expressID, glm::dvec3 &point) const;
+    // filled by ResolveStyles and only read while geometry is read, slots maps an express id to its colour in colors: 0
+    // is not resolved, 1 is no colour
+    struct StyleStore
+    {
+      std::vector<uint32_t> slots;
+      std::vector<glm::dvec4> colors;
+    };
+    mutable StyleStore _styleStore;
+    std::optional<glm::dvec4> resolveStyleColor(uint32_t expressID, std::unordered_map<uint32_t, std::optional<glm::dvec4>> &colors) const;
+    // filled by ResolvePlacements and only read while geometry is read
+    mutable std::vector<glm::dmat4> _resolvedPlacements;
+    mutable std::unordered_map<uint32_t, uint32_t> _resolvedPlacementIndices;
   };
 
 }
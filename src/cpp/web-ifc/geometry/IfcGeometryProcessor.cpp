@@ -2,6 +2,12 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+#include <cfloat>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <numeric>
 #include <spdlog/spdlog.h>
 
 #if defined(DEBUG_DUMP_SVG) || defined(DUMP_CSG_MESHES)
@@ -15,10 +21,199 @@
 #include "operations/geometryutils.h"
 #include "operations/curve-utils.h"
 #include "operations/mesh_utils.h"
+#include "operations/bake_vertices.h"
 #include "operations/boolean-utils/fuzzy-bools.h"
+#include "../utility/arena.h"
+#include "../utility/binary_io.h"
+#include "../utility/hash.h"
+#include "../utility/scratch.h"
+#include "../utility/timing.h"
+#include "../utility/trace.h"
 
 namespace webifc::geometry
 {
+    namespace
+    {
+        // mesh caches: header with the key of the model and settings, the coordination, then flat meshes and geometries
+        constexpr char MESH_CACHE_MAGIC[8] = {'W', 'I', 'F', 'C', 'M', 'E', 'S', 'H'};
+        constexpr uint32_t MESH_CACHE_VERSION = 2;
+
+        uint64_t meshCacheEntry(uint32_t expressID, bool applyLinearScalingFactor)
+        {
+            return ((uint64_t)expressID << 1) | (applyLinearScalingFactor ? 1 : 0);
+        }
+
+        // the element GetFlatMesh meshes on this thread and the steady clock time its booleans have to be done by, 0 for
+        // no element budget. Workers that run booleans of the element take it over
+        struct ElementBudget
+        {
+            uint32_t expressID = 0;
+            uint64_t deadline = 0;
+        };
+
+        ElementBudget &CurrentElementBudget()
+        {
+            thread_local ElementBudget budget;
+            return budget;
+        }
+
+        class ElementBudgetScope
+        {
+        public:
+            explicit ElementBudgetScope(const ElementBudget &budget) : _previous(CurrentElementBudget())
+            {
+                CurrentElementBudget() = budget;
+            }
+
+            ~ElementBudgetScope()
+            {
+                CurrentElementBudget() = _previous;
+            }
+
+        private:
+            ElementBudget _previous;
+        };
+
+        // relative work of meshing a representation item of the type, extrusions and instances are cheap, booleans and
+        // curved surfaces are tessellated and clipped
+        uint32_t ItemMeshingCost(uint32_t type)
+        {
+            switch (type)
+            {
+            case schema::IFCBOOLEANRESULT:
+            case schema::IFCBOOLEANCLIPPINGRESULT:
+                return 8;
+            case schema::IFCADVANCEDBREP:
+            case schema::IFCADVANCEDBREPWITHVOIDS:
+            case schema::IFCBSPLINESURFACE:
+            case schema::IFCBSPLINESURFACEWITHKNOTS:
+            case schema::IFCSECTIONEDSOLID:
+            case schema::IFCSECTIONEDSOLIDHORIZONTAL:
+            case schema::IFCSECTIONEDSURFACE:
+                return 6;
+            case schema::IFCFACETEDBREP:
+            case schema::IFCFACETEDBREPWITHVOIDS:
+            case schema::IFCSWEPTDISKSOLID:
+            case schema::IFCREVOLVEDAREASOLID:
+            case schema::IFCSURFACECURVESWEPTAREASOLID:
+            case schema::IFCFIXEDREFERENCESWEPTAREASOLID:
+                return 4;
+            case schema::IFCPOLYGONALFACESET:
+            case schema::IFCTRIANGULATEDFACESET:
+            case schema::IFCFACEBASEDSURFACEMODEL:
+            case schema::IFCSHELLBASEDSURFACEMODEL:
+                return 2;
+            default:
+                return 1;
+            }
+        }
+
+        // breps with fewer faces are triangulated on the calling thread
+        constexpr size_t MIN_PARALLEL_BREP_FACES = 16;
+
+        // the faces of part after those of geometry, as if they had been added to it one after the other
+        void AppendGeometry(IfcGeometry &geometry, const IfcGeometry &part)
+        {
+            const uint32_t offset = geometry.numPoints;
+            geometry.vertexData.insert(geometry.vertexData.end(), part.vertexData.begin(), part.vertexData.end());
+            geometry.indexData.reserve(geometry.indexData.size() + part.indexData.size());
+            for (uint32_t index : part.indexData)
+            {
+                geometry.indexData.push_back(index + offset);
+            }
+            geometry.planeData.insert(geometry.planeData.end(), part.planeData.begin(), part.planeData.end());
+            geometry.numPoints += part.numPoints;
+            geometry.numFaces += part.numFaces;
+        }
+
+        uint64_t Deadline(double seconds)
+        {
+            return seconds > 0 ? utility::NowNanoseconds() + static_cast<uint64_t>(seconds * 1e9) : 0;
+        }
+
+        // what an operation leaves when it gives up: the first operands, with the second ones merged in for a union
+        IfcGeometry BooleanFallback(const std::vector<IfcGeometry> &firstGeoms, const std::vector<IfcGeometry> &secondGeoms, BooleanOperation op)
+        {
+            IfcGeometry result;
+            for (const auto &geom : firstGeoms) result.MergeGeometry(geom);
+            if (op == BooleanOperation::UNION)
+            {
+                for (const auto &geom : secondGeoms)
+                {
+                    if (!geom.halfSpace) result.MergeGeometry(geom);
+                }
+            }
+            return result;
+        }
+
+        // the first coarse level merges vertices in cells of 1/64 of the geometry's diagonal, every further level doubles
+        // the cells until the diagonal spans two of them
+        constexpr uint32_t LOD_FINEST_CELLS = 64;
+        constexpr uint32_t LOD_COARSEST_CELLS = 2;
+
+        // cutters with more faces are not tested for convexity, the test costs faces times points
+        constexpr uint32_t MAX_CONVEX_CUTTER_FACES = 64;
+
+        enum class CutterOverlap
+        {
+            APART,
+            CONTAINS,
+            PARTIAL
+        };
+
+        // the outward face planes (normal, distance) of a small convex mesh, false when the mesh is not convex
+        bool GetConvexPlanes(const IfcGeometry &geom, std::vector<glm::dvec4> &planes, double tolerance)
+        {
+            if (geom.numFaces == 0 || geom.numFaces > MAX_CONVEX_CUTTER_FACES)
+            {
+                return false;
+            }
+            for (uint32_t i = 0; i < geom.numFaces; i++)
+            {
+                const bimGeometry::Face f = geom.GetFace(i);
+                const glm::dvec3 a = geom.GetPoint(f.i0);
+                const glm::dvec3 normal = glm::cross(geom.GetPoint(f.i1) - a, geom.GetPoint(f.i2) - a);
+                const double length = glm::length(normal);
+                if (length == 0)
+                {
+                    continue;
+                }
+                const glm::dvec4 plane(normal / length, glm::dot(normal / length, a));
+                for (uint32_t j = 0; j < geom.numPoints; j++)
+                {
+                    if (glm::dot(glm::dvec3(plane), geom.GetPoint(j)) - plane.w > tolerance)
+                    {
+                        return false;
+                    }
+                }
+                planes.push_back(plane);
+            }
+            return !planes.empty();
+        }
+
+        // where the host lies relative to a convex cutter given by its planes
+        CutterOverlap ClassifyAgainstConvex(const IfcGeometry &host, const std::vector<glm::dvec4> &planes, double tolerance)
+        {
+            bool inside = true;
+            for (const auto &plane : planes)
+            {
+                bool front = true;
+                for (uint32_t i = 0; i < host.numPoints && (front || inside); i++)
+                {
+                    const double distance = glm::dot(glm::dvec3(plane), host.GetPoint(i)) - plane.w;
+                    front = front && distance >= -tolerance;
+                    inside = inside && distance <= tolerance;
+                }
+                if (front)
+                {
+                    // the plane separates the host from the cutter
+                    return CutterOverlap::APART;
+                }
+            }
+            return inside ? CutterOverlap::CONTAINS : CutterOverlap::PARTIAL;
+        }
+    }
+
     IfcGeometryProcessor::IfcGeometryProcessor(webifc::parsing::IfcLoader &loader, const webifc::schema::IfcSchemaManager &schemaManager, uint16_t circleSegments, bool coordinateToOrigin, double TOLERANCE_PLANE_INTERSECTION, double TOLERANCE_PLANE_DEVIATION, double TOLERANCE_BACK_DEVIATION_DISTANCE, double TOLERANCE_INSIDE_OUTSIDE_PERIMETER, double TOLERANCE_SCALAR_EQUALITY, double PLANE_REFIT_ITERATIONS, double BOOLEAN_UNION_THRESHOLD)
         : _geometryLoader(loader, schemaManager, circleSegments, TOLERANCE_PLANE_INTERSECTION, TOLERANCE_PLANE_DEVIATION, TOLERANCE_BACK_DEVIATION_DISTANCE, TOLERANCE_INSIDE_OUTSIDE_PERIMETER, TOLERANCE_SCALAR_EQUALITY, PLANE_REFIT_ITERATIONS, BOOLEAN_UNION_THRESHOLD), _loader(loader), _schemaManager(schemaManager)
     {
@@ -29,9 +224,38 @@ namespace webifc::geometry
         _settings.TOLERANCE_BACK_DEVIATION_DISTANCE = TOLERANCE_BACK_DEVIATION_DISTANCE;
         _settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER = TOLERANCE_INSIDE_OUTSIDE_PERIMETER;
         _settings._BOOLEAN_UNION_THRESHOLD = BOOLEAN_UNION_THRESHOLD;
+        _settings.TOLERANCE_SCALAR_EQUALITY = TOLERANCE_SCALAR_EQUALITY;
+        _settings.PLANE_REFIT_ITERATIONS = PLANE_REFIT_ITERATIONS;
         SetEpsilons(TOLERANCE_SCALAR_EQUALITY, PLANE_REFIT_ITERATIONS, BOOLEAN_UNION_THRESHOLD);
     }
 
+    void IfcGeometryProcessor::SetGeometryMemoryLimit(size_t bytes)
+    {
+        _geometryMemoryLimit = bytes;
+    }
+
+    void IfcGeometryProcessor::SetCircleChordTolerance(double tolerance)
+    {
+        _settings.CIRCLE_CHORD_TOLERANCE = tolerance;
+        geometry::SetCircleChordTolerance(tolerance);
+    }
+
+    void IfcGeometryProcessor::SetExportPolylines(bool exportPolylines)
+    {
+        _settings._exportPolylines = exportPolylines;
+    }
+
+    void IfcGeometryProcessor::SetTerrainChunkTriangles(uint32_t triangles)
+    {
+        _settings._terrainChunkTriangles = triangles;
+    }
+
+    void IfcGeometryProcessor::SetVertexWelding(bool weld, bool optimizeVertexCache)
+    {
+        _settings._weldVertices = weld;
+        _settings._optimizeVertexCache = optimizeVertexCache;
+    }
+
     IfcGeometryLoader& IfcGeometryProcessor::GetLoader()
     {
          return _geometryLoader;
@@ -54,24 +278,326 @@ namespace webifc::geometry
 
     IfcGeometry &IfcGeometryProcessor::GetGeometry(uint32_t expressID)
     {
-        return _expressIDToGeometry[expressID];
+        return _expressIDToGeometry.Get()[expressID];
+    }
+
+    IfcGeometry &IfcGeometryProcessor::GetGeometry(uint32_t expressID, uint32_t lod)
+    {
+        if (lod == 0)
+        {
+            return GetGeometry(expressID);
+        }
+        auto &lodGeometries = _lodGeometries.Get();
+        const uint64_t key = ((uint64_t)lod << 32) | expressID;
+        auto it = lodGeometries.find(key);
+        if (it != lodGeometries.end())
+        {
+            return it->second;
+        }
+
+        IfcGeometry &geometry = GetGeometry(expressID);
+        geometry.RestoreVertexData();
+        if (geometry.IsReleased())
+        {
+            spdlog::error("[GetGeometry({}, {})] the vertices of the geometry were released already", expressID, lod);
+            return lodGeometries[key];
+        }
+        glm::dvec3 center;
+        glm::dvec3 extents;
+        geometry.GetCenterExtents(center, extents);
+        const uint32_t cells = std::max(LOD_FINEST_CELLS >> std::min(lod - 1, 31u), LOD_COARSEST_CELLS);
+        return lodGeometries[key] = geometry.Decimate(glm::length(extents) / cells);
     }
 
     void IfcGeometryProcessor::Clear()
     {
-        _expressIDToGeometry.clear();
-        std::unordered_map<uint32_t, IfcGeometry>().swap(_expressIDToGeometry);
+        _expressIDToGeometry.Clear();
+        _lodGeometries.Clear();
+        _mappedMeshes.Clear();
+        _contentHashes.Clear();
+        _expressIDByContent.Clear();
         _geometryLoader.Clear();
     }
 
+    std::vector<uint32_t> IfcGeometryProcessor::InvalidateLines(const std::vector<uint32_t> &expressIDs)
+    {
+        std::vector<uint32_t> pending;
+        std::vector<uint32_t> lineTypes;
+        for (uint32_t expressID : expressIDs)
+        {
+            pending.push_back(expressID);
+            if (!_loader.IsValidExpressID(expressID))
+            {
+                continue;
+            }
+            const uint32_t lineType = _loader.GetLineType(expressID);
+            lineTypes.push_back(lineType);
+            // parts take the openings of what they are aggregated to and nested elements go with what they are nested in
+            if (lineType == schema::IFCRELAGGREGATES || lineType == schema::IFCRELNESTS)
+            {
+                AddRefArgument(expressID, 4, pending);
+                AddRefArgument(expressID, 5, pending);
+            }
+        }
+        std::unordered_set<uint32_t> lines;
+        AddDependentLines(std::move(pending), lines);
+
+        // items of the same content share the geometry of the first of them, so lines sharing a dropped geometry are
+        // dropped with it
+        std::unordered_set<uint64_t> sharedContent;
+        _expressIDByContent.ForEach([&](const auto &expressIDByContent)
+                                    {
+            for (const auto &[contentHash, expressID] : expressIDByContent)
+            {
+                if (lines.contains(expressID)) sharedContent.insert(contentHash);
+            } });
+        if (!sharedContent.empty())
+        {
+            std::vector<uint32_t> sharing;
+            _contentHashes.ForEach([&](const auto &contentHashes)
+                                   {
+                for (const auto &[expressID, contentHash] : contentHashes)
+                {
+                    if (sharedContent.contains(contentHash) && !lines.contains(expressID)) sharing.push_back(expressID);
+                } });
+            AddDependentLines(std::move(sharing), lines);
+        }
+
+        _expressIDToGeometry.ForEachMutable([&](IfcGeometryStore &store)
+                                            {
+            for (uint32_t expressID : lines) store.Remove(expressID); });
+        _lodGeometries.ForEachMutable([&](auto &lodGeometries)
+                                      { std::erase_if(lodGeometries, [&](const auto &entry)
+                                                      { return lines.contains(static_cast<uint32_t>(entry.first)); }); });
+        _mappedMeshes.ForEachMutable([&](auto &mappedMeshes)
+                                     {
+            for (uint32_t expressID : lines) mappedMeshes.erase(expressID); });
+        _contentHashes.ForEachMutable([&](auto &contentHashes)
+                                      {
+            for (uint32_t expressID : lines) contentHashes.erase(expressID); });
+        _expressIDByContent.ForEachMutable([&](auto &expressIDByContent)
+                                           { std::erase_if(expressIDByContent, [&](const auto &entry)
+                                                           { return lines.contains(entry.second); }); });
+        {
+            std::lock_guard<std::mutex> lock(_meshCache.mutex);
+            for (uint32_t expressID : lines)
+            {
+                const size_t erased = _meshCache.meshes.erase(meshCacheEntry(expressID, true)) + _meshCache.meshes.erase(meshCacheEntry(expressID, false)) + _meshCache.geometries.erase(expressID);
+                _meshCache.changed |= erased > 0;
+            }
+        }
+        _geometryLoader.Invalidate(lines);
+        // the maps hold ids only, so they only change with the relationships themselves
+        _geometryLoader.InvalidateRelations(lineTypes);
+
+        std::vector<uint32_t> elements;
+        for (uint32_t expressID : lines)
+        {
+            if (_loader.IsValidExpressID(expressID) && _schemaManager.IsIfcElement(_loader.GetLineType(expressID)))
+            {
+                elements.push_back(expressID);
+            }
+        }
+        std::sort(elements.begin(), elements.end());
+        return elements;
+    }
+
+    std::vector<uint32_t> IfcGeometryProcessor::GetRelatedLines(const std::vector<uint32_t> &expressIDs)
+    {
+        std::vector<uint32_t> related;
+        for (uint32_t expressID : expressIDs)
+        {
+            if (!_loader.IsValidExpressID(expressID))
+            {
+                continue;
+            }
+            switch (_loader.GetLineType(expressID))
+            {
+            case schema::IFCRELAGGREGATES:
+            case schema::IFCRELNESTS:
+                AddRefArgument(expressID, 4, related);
+                AddRefArgument(expressID, 5, related);
+                break;
+            case schema::IFCRELVOIDSELEMENT:
+            case schema::IFCRELASSOCIATESMATERIAL:
+                AddRefArgument(expressID, 4, related);
+                break;
+            case schema::IFCSTYLEDITEM:
+                AddRefArgument(expressID, 0, related);
+                break;
+            case schema::IFCMATERIALDEFINITIONREPRESENTATION:
+                AddRefArgument(expressID, 3, related);
+                break;
+            default:
+                break;
+            }
+        }
+        return related;
+    }
+
+    void IfcGeometryProcessor::AddRefArgument(uint32_t expressID, uint32_t argument, std::vector<uint32_t> &refs)
+    {
+        _loader.MoveToArgumentOffset(expressID, argument);
+        if (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
+        {
+            _loader.StepBack();
+            for (auto &token : _loader.GetSetArgument())
+            {
+                refs.push_back(_loader.GetRefArgument(token));
+            }
+            return;
+        }
+        _loader.StepBack();
+        refs.push_back(_loader.GetOptionalRefArgument());
+    }
+
+    void IfcGeometryProcessor::AddDependentLines(std::vector<uint32_t> pending, std::unordered_set<uint32_t> &lines)
+    {
+        const auto &relVoids = _geometryLoader.GetRelVoids();
+        auto pushArgument = [&](uint32_t expressID, uint32_t argument)
+        {
+            AddRefArgument(expressID, argument, pending);
+        };
+        while (!pending.empty())
+        {
+            const uint32_t expressID = pending.back();
+            pending.pop_back();
+            if (expressID == 0 || !lines.insert(expressID).second)
+            {
+                continue;
+            }
+            for (auto &reference : _loader.GetInverseReferences(expressID))
+            {
+                pending.push_back(reference.expressID);
+                // parts take the openings of what they are aggregated to
+                if (reference.argumentIndex == 4 && relVoids.contains(expressID) && _loader.GetLineType(reference.expressID) == schema::IFCRELAGGREGATES)
+                {
+                    pushArgument(reference.expressID, 5);
+                }
+            }
+            if (!_loader.IsValidExpressID(expressID))
+            {
+                continue;
+            }
+            // relationships reference what they affect, so what they relate depends on them
+            switch (_loader.GetLineType(expressID))
+            {
+            case schema::IFCRELVOIDSELEMENT:
+            case schema::IFCRELASSOCIATESMATERIAL:
+                pushArgument(expressID, 4);
+                break;
+            case schema::IFCSTYLEDITEM:
+                pushArgument(expressID, 0);
+                break;
+            case schema::IFCMATERIALDEFINITIONREPRESENTATION:
+                pushArgument(expressID, 3);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void IfcGeometryProcessor::ClearThread()
+    {
+        _expressIDToGeometry.Get().clear();
+        _lodGeometries.Get().clear();
+        _mappedMeshes.Get().clear();
+        _contentHashes.Get().clear();
+        _expressIDByContent.Get().clear();
+        _geometryLoader.ClearThread();
+    }
+
+    void IfcGeometryProcessor::TrimStreamingCaches(size_t budget)
+    {
+        if (budget == 0)
+        {
+            budget = _geometryMemoryLimit > 0 ? _geometryMemoryLimit : STREAMING_GEOMETRY_BUDGET;
+        }
+        _expressIDToGeometry.Get().Trim(budget);
+        _lodGeometries.Get().clear();
+    }
+
+    void IfcGeometryProcessor::KeepGeometry(uint32_t expressID)
+    {
+        _expressIDToGeometry.Get().Keep(expressID);
+    }
+
+    void IfcGeometryProcessor::ReleaseKeptGeometries()
+    {
+        _expressIDToGeometry.Get().ReleaseKept();
+    }
+
+    bool IfcGeometryProcessor::ReuseMappedMesh(const IfcComposedMesh &mesh)
+    {
+        if (mesh.hasGeometry)
+        {
+            auto &store = _expressIDToGeometry.Get();
+            auto geometryIt = store.find(mesh.expressID);
+            // elements with openings are cut from the vertices, so released geometries are not reused
+            if (geometryIt == store.end() || geometryIt->second.IsReleased())
+            {
+                return false;
+            }
+            store.Reuse(mesh.expressID);
+        }
+        for (const auto &child : mesh.children)
+        {
+            if (!ReuseMappedMesh(child))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::optional<uint32_t> IfcGeometryProcessor::GetSharedGeometry(uint32_t expressID, uint32_t ignoredArgument, uint64_t &contentHash)
+    {
+        contentHash = _loader.GetContentHash(expressID, _contentHashes.Get(), ignoredArgument);
+        auto &expressIDByContent = _expressIDByContent.Get();
+        auto sharedIt = expressIDByContent.find(contentHash);
+        // a hash alone may collide, the item meshes itself unless its content is that of the shared one
+        if (sharedIt == expressIDByContent.end() || !_loader.HasSameContent(expressID, sharedIt->second, ignoredArgument))
+            return std::nullopt;
+        auto geometryIt = _expressIDToGeometry.Get().find(sharedIt->second);
+        if (geometryIt == _expressIDToGeometry.Get().end() || geometryIt->second.IsReleased())
+        {
+            // a released geometry was handed out already and has no vertices left to share
+            expressIDByContent.erase(sharedIt);
+            return std::nullopt;
+        }
+        _expressIDToGeometry.Get().Reuse(sharedIt->second);
+        return sharedIt->second;
+    }
+
+    void IfcGeometryProcessor::ShareGeometry(uint32_t expressID, uint64_t contentHash)
+    {
+        _expressIDByContent.Get().try_emplace(contentHash, expressID);
+    }
+
+    const IfcProfile &IfcGeometryProcessor::GetDiskProfile(double radius)
+    {
+        auto &diskProfiles = _diskProfiles.Get();
+        const auto key = std::make_tuple(radius, _settings._circleSegments, bimGeometry::_CIRCLE_CHORD_TOLERANCE);
+        auto it = diskProfiles.find(key);
+        if (it == diskProfiles.end())
+        {
+            IfcProfile profile;
+            profile.curve = GetCircleCurve(radius, _settings._circleSegments);
+            it = diskProfiles.emplace(key, std::move(profile)).first;
+        }
+        return it->second;
+    }
+
     std::array<double, 16> IfcGeometryProcessor::GetFlatCoordinationMatrix() const
     {
         std::array<double, 16> flatTransformation;
+        const glm::dmat4 coordinationMatrix = GetCoordinationMatrix();
         for (int i = 0; i < 4; i++)
         {
             for (int j = 0; j < 4; j++)
             {
-                flatTransformation[i * 4 + j] = _coordinationMatrix[i][j];
+                flatTransformation[i * 4 + j] = coordinationMatrix[i][j];
             }
         }
         return flatTransformation;
@@ -79,63 +605,96 @@ namespace webifc::geometry
 
     glm::dmat4 IfcGeometryProcessor::GetCoordinationMatrix() const
     {
+        if (!_settings._coordinateToOrigin || _isCoordinated.load(std::memory_order_acquire)) return _coordinationMatrix;
+        std::lock_guard<std::mutex> lock(_coordinationMutex);
         return _coordinationMatrix;
     }
 
-    std::optional<glm::dvec4> IfcGeometryProcessor::GetStyleItemFromExpressId(uint32_t expressID)
+    bool IfcGeometryProcessor::CoordinateFromPlacements(bool applyLinearScalingFactor)
     {
-        std::optional<glm::dvec4> styledItemColor;
-        auto &styledItems = _geometryLoader.GetStyledItems();
-        auto &relMaterials = _geometryLoader.GetRelMaterials();
-        auto &materialDefinitions = _geometryLoader.GetMaterialDefinitions();
-        auto styledItem = styledItems.find(expressID);
-        if (styledItem != styledItems.end())
+        if (!_settings._coordinateToOrigin || _isCoordinated.load(std::memory_order_acquire) || _placementsSearched.load(std::memory_order_acquire)) return false;
+        std::lock_guard<std::mutex> lock(_coordinationMutex);
+        if (_isCoordinated.load(std::memory_order_relaxed) || _placementsSearched.load(std::memory_order_relaxed)) return false;
+        _placementsSearched.store(true, std::memory_order_release);
+
+        glm::dmat4 mat = glm::dmat4(1);
+        if (applyLinearScalingFactor)
         {
-            auto items = styledItem->second;
-            for (auto item : items)
-            {
-                styledItemColor = _geometryLoader.GetColor(item.second);
-                if (styledItemColor)
-                    break;
-            }
+            mat = glm::scale(glm::dvec3(_geometryLoader.GetLinearScalingFactor()));
         }
-
-        if (!styledItemColor)
+        // the origin goes through the same transformations as the vertices in GetFlatMesh. Geometry is in the engineering
+        // coordinates the map conversion starts from, so its eastings and northings are no part of the shift
+        for (uint32_t type : {schema::IFCSITE, schema::IFCBUILDING})
         {
-            auto material = relMaterials.find(expressID);
-            if (material != relMaterials.end())
+            auto expressIDs = _loader.GetExpressIDsWithType(type);
+            std::sort(expressIDs.begin(), expressIDs.end());
+            for (uint32_t expressID : expressIDs)
             {
-                auto &materials = material->second;
-                for (auto item : materials)
+                _loader.MoveToArgumentOffset(expressID, 5);
+                uint32_t localPlacement = _loader.GetOptionalRefArgument();
+                if (localPlacement == 0 || !_loader.IsValidExpressID(localPlacement))
                 {
-                    if (materialDefinitions.count(item.second) != 0)
-                    {
-                        auto &defs = materialDefinitions.at(item.second);
-                        for (auto def : defs)
-                        {
-                            styledItemColor = _geometryLoader.GetColor(def.second);
-                            if (styledItemColor)
-                                break;
-                        }
-                    }
-
-                    // if no color found, check material itself
-                    if (!styledItemColor)
-                    {
-                        styledItemColor = _geometryLoader.GetColor(item.second);
-                        if (styledItemColor)
-                            break;
-                    }
+                    continue;
                 }
+                glm::dvec4 origin = _transformation * NormalizeIFC * mat * _geometryLoader.GetLocalPlacement(localPlacement)[3];
+                _coordinationMatrix = glm::translate(-glm::dvec3(origin));
+                _isCoordinated.store(true, std::memory_order_release);
+                return true;
             }
         }
-        return styledItemColor;
+        return false;
+    }
+
+    std::optional<glm::dvec4> IfcGeometryProcessor::GetStyleItemFromExpressId(uint32_t expressID)
+    {
+        return _geometryLoader.GetStyleColor(expressID);
     }
 
+#ifdef WEBIFC_GEOMETRY_PROFILING
+    class IfcGeometryProcessor::ProfileScope
+    {
+    public:
+        ProfileScope(IfcGeometryProcessor &processor, uint32_t expressID, uint32_t lineType) : _processor(processor), _expressID(expressID), _active(processor._profiler.IsEnabled())
+        {
+            if (!_active) return;
+            auto &geometries = _processor._expressIDToGeometry.Get();
+            _hadGeometry = geometries.find(expressID) != geometries.end();
+            _processor._profiler.Enter(expressID, lineType, _processor._schemaManager.IsIfcElement(lineType));
+        }
+
+        ~ProfileScope()
+        {
+            if (!_active) return;
+            uint64_t triangles = 0;
+            uint64_t bytes = 0;
+            auto &geometries = _processor._expressIDToGeometry.Get();
+            auto geometryIt = geometries.find(_expressID);
+            if (!_hadGeometry && geometryIt != geometries.end())
+            {
+                triangles = geometryIt->second.numFaces;
+                bytes = geometryIt->second.GetMemorySize();
+            }
+            _processor._profiler.Leave(triangles, bytes);
+        }
+
+    private:
+        IfcGeometryProcessor &_processor;
+        uint32_t _expressID;
+        bool _active;
+        bool _hadGeometry = false;
+    };
+#endif
+
     IfcComposedMesh IfcGeometryProcessor::GetMesh(uint32_t expressID)
     {
         spdlog::debug("[GetMesh({})]", expressID);
+        // the tolerances are per thread, so every call sets this processor's on the calling thread
+        SetEpsilons(_settings.TOLERANCE_SCALAR_EQUALITY, _settings.PLANE_REFIT_ITERATIONS, _settings._BOOLEAN_UNION_THRESHOLD);
+        geometry::SetCircleChordTolerance(_settings.CIRCLE_CHORD_TOLERANCE);
         auto lineType = _loader.GetLineType(expressID);
+#ifdef WEBIFC_GEOMETRY_PROFILING
+        ProfileScope profileScope(*this, expressID, lineType);
+#endif
         auto &relVoids = _geometryLoader.GetRelVoids();
 
         IfcComposedMesh mesh;
@@ -186,9 +745,9 @@ namespace webifc::geometry
             {
                 IfcComposedMesh resultMesh;
 
-                auto origin = GetOrigin(mesh, _expressIDToGeometry);
+                auto origin = GetOrigin(mesh, _expressIDToGeometry.Get().GetGeometries());
                 auto normalizeMat = glm::translate(-origin);
-                auto flatElementMeshes = flatten(mesh, _expressIDToGeometry, normalizeMat);
+                auto flatElementMeshes = flatten(mesh, _expressIDToGeometry.Get().GetGeometries(), normalizeMat);
                 auto elementColor = mesh.GetColor();
 
                 IfcGeometry finalGeometry;
@@ -201,26 +760,26 @@ namespace webifc::geometry
                     for (auto relVoidExpressID : relVoidsIt->second)
                     {
                         IfcComposedMesh voidGeom = GetMesh(relVoidExpressID);
-                        auto flatVoidMesh = flatten(voidGeom, _expressIDToGeometry, normalizeMat);
+                        auto flatVoidMesh = flatten(voidGeom, _expressIDToGeometry.Get().GetGeometries(), normalizeMat);
                         voidGeoms.insert(voidGeoms.end(), flatVoidMesh.begin(), flatVoidMesh.end());
                     }
 
                     if (relVoidsIt->second.size() > _settings._BOOLEAN_UNION_THRESHOLD) // When voids are greater than 10 they are all fused
                     {
                         std::vector<IfcGeometry> joinedVoidGeoms;
-                        IfcGeometry fusedVoids;
-                        for (auto geom : voidGeoms)
+                        std::vector<IfcGeometry> solidVoidGeoms;
+                        for (auto &geom : voidGeoms)
                         {
                             if (geom.halfSpace)
                             {
-                                joinedVoidGeoms.push_back(geom);
+                                joinedVoidGeoms.push_back(std::move(geom));
                             }
                             else
                             {
-                                std::vector<IfcGeometry> geomVector = {geom}; // Wrap 'geom' in a vector
-                                fusedVoids = BoolProcess(std::vector<IfcGeometry>{fusedVoids}, geomVector, "UNION", _settings);
+                                solidVoidGeoms.push_back(std::move(geom));
                             }
                         }
+                        IfcGeometry fusedVoids = FuseGeometries(std::move(solidVoidGeoms));
 
 #ifdef CSG_DEBUG_OUTPUT
                         // io::DumpIfcGeometry(fusedVoids, "union_bool_void.obj");
@@ -253,7 +812,7 @@ namespace webifc::geometry
                     //             #endif
 
                     //             std::vector<IfcGeometry> geomVector = {geom};  // Wrap 'geom' in a vector
-                    //             fusedMesh = BoolProcess(std::vector<IfcGeometry>{fusedMesh}, geomVector, "UNION");
+                    //             fusedMesh = BoolProcess(std::vector<IfcGeometry>{fusedMesh}, geomVector, BooleanOperation::UNION);
 
                     //             #ifdef CSG_DEBUG_OUTPUT
                     //                 // io::DumpIfcGeometry(fusedMesh, "union_bool_solid_partial.obj");
@@ -271,14 +830,14 @@ namespace webifc::geometry
                     //     flatElementMeshes.shrink_to_fit();
                     // }
 
-                    finalGeometry = BoolProcess(flatElementMeshes, voidGeoms, "DIFFERENCE", _settings);
+                    finalGeometry = BoolProcess(flatElementMeshes, voidGeoms, BooleanOperation::DIFFERENCE, _settings);
 
 #ifdef CSG_DEBUG_OUTPUT
 //    io::DumpIfcGeometry(finalGeometry, "mesh_bool.obj");
 #endif
                 }
 
-                _expressIDToGeometry[expressID] = finalGeometry;
+                _expressIDToGeometry.Get()[expressID] = finalGeometry;
                 resultMesh.transformation = glm::translate(origin);
                 resultMesh.expressID = expressID;
                 resultMesh.hasGeometry = true;
@@ -332,7 +891,7 @@ namespace webifc::geometry
 
                 mesh.transformation = glm::dmat4(1);
                 
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.hasGeometry = true;
 
                 // #ifdef DEBUG_DUMP_SVG
@@ -351,7 +910,19 @@ namespace webifc::geometry
                 uint32_t localPlacement = _loader.GetRefArgument();
 
                 mesh.transformation = _geometryLoader.GetLocalPlacement(localPlacement);
-                mesh.children.push_back(GetMesh(ifcPresentation));
+
+                // every instance of a representation map meshes to the same tree, so it is meshed once while its
+                // geometries are kept
+                auto &mappedMeshes = _mappedMeshes.Get();
+                auto mappedIt = mappedMeshes.find(ifcPresentation);
+                if (mappedIt != mappedMeshes.end() && ReuseMappedMesh(mappedIt->second))
+                {
+                    mesh.children.push_back(mappedIt->second);
+                    return mesh;
+                }
+                IfcComposedMesh mappedMesh = GetMesh(ifcPresentation);
+                mappedMeshes.insert_or_assign(ifcPresentation, mappedMesh);
+                mesh.children.push_back(std::move(mappedMesh));
 
                 return mesh;
             }
@@ -364,15 +935,15 @@ namespace webifc::geometry
                 auto firstMesh = GetMesh(firstOperandID);
                 auto secondMesh = GetMesh(secondOperandID);
 
-                auto origin = GetOrigin(firstMesh, _expressIDToGeometry);
+                auto origin = GetOrigin(firstMesh, _expressIDToGeometry.Get().GetGeometries());
                 auto normalizeMat = glm::translate(-origin);
 
-                auto flatFirstMeshes = flatten(firstMesh, _expressIDToGeometry, normalizeMat);
-                auto flatSecondMeshes = flatten(secondMesh, _expressIDToGeometry, normalizeMat);
+                auto flatFirstMeshes = flatten(firstMesh, _expressIDToGeometry.Get().GetGeometries(), normalizeMat);
+                auto flatSecondMeshes = flatten(secondMesh, _expressIDToGeometry.Get().GetGeometries(), normalizeMat);
 
-                IfcGeometry resultMesh = BoolProcess(flatFirstMeshes, flatSecondMeshes, "DIFFERENCE", _settings);
+                IfcGeometry resultMesh = BoolProcess(flatFirstMeshes, flatSecondMeshes, BooleanOperation::DIFFERENCE, _settings);
 
-                _expressIDToGeometry[expressID] = resultMesh;
+                _expressIDToGeometry.Get()[expressID] = resultMesh;
                 mesh.hasGeometry = true;
                 mesh.transformation = glm::translate(origin);
 
@@ -389,11 +960,12 @@ namespace webifc::geometry
                 // @Refactor: duplicate of above
 
                 _loader.MoveToArgumentOffset(expressID, 0);
-                std::string_view op = _loader.GetStringArgument();
+                std::string_view opName = _loader.GetStringArgument();
+                BooleanOperation op;
 
-                if (op != "DIFFERENCE" && op != "UNION")
+                if (!ParseBooleanOperation(opName, op))
                 {
-                    spdlog::error("[GetMesh()] Unsupported boolean op {}", std::string(op), expressID);
+                    spdlog::error("[GetMesh()] Unsupported boolean op {}", std::string(opName), expressID);
                     return mesh;
                 }
 
@@ -403,11 +975,11 @@ namespace webifc::geometry
                 auto firstMesh = GetMesh(firstOperandID);
                 auto secondMesh = GetMesh(secondOperandID);
 
-                auto origin = GetOrigin(firstMesh, _expressIDToGeometry);
+                auto origin = GetOrigin(firstMesh, _expressIDToGeometry.Get().GetGeometries());
                 auto normalizeMat = glm::translate(-origin);
 
-                auto flatFirstMeshes = flatten(firstMesh, _expressIDToGeometry, normalizeMat);
-                auto flatSecondMeshes = flatten(secondMesh, _expressIDToGeometry, normalizeMat);
+                auto flatFirstMeshes = flatten(firstMesh, _expressIDToGeometry.Get().GetGeometries(), normalizeMat);
+                auto flatSecondMeshes = flatten(secondMesh, _expressIDToGeometry.Get().GetGeometries(), normalizeMat);
 
                 if (flatFirstMeshes.size() == 0)
                 {
@@ -416,9 +988,9 @@ namespace webifc::geometry
                     return mesh;
                 }
 
-                IfcGeometry resultMesh = BoolProcess(flatFirstMeshes, flatSecondMeshes, std::string(op), _settings);
+                IfcGeometry resultMesh = BoolProcess(flatFirstMeshes, flatSecondMeshes, op, _settings);
 
-                _expressIDToGeometry[expressID] = resultMesh;
+                _expressIDToGeometry.Get()[expressID] = resultMesh;
                 mesh.hasGeometry = true;
                 mesh.transformation = glm::translate(origin);
                 if (!mesh.hasColor && firstMesh.hasColor)
@@ -469,7 +1041,7 @@ namespace webifc::geometry
 
                 mesh.transformation = surface.transformation;
                 // TODO: this is getting problematic.....
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.hasGeometry = true;
 
                 return mesh;
@@ -537,7 +1109,7 @@ namespace webifc::geometry
 #endif
 
                 // TODO: this is getting problematic.....
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.hasGeometry = true;
                 mesh.transformation = position;
 
@@ -558,13 +1130,13 @@ namespace webifc::geometry
             case schema::IFCSHELLBASEDSURFACEMODEL:
             {
                 _loader.MoveToArgumentOffset(expressID, 0);
-                auto shells = _loader.GetSetArgument();
+                utility::ScratchVector<uint32_t> shells;
+                _loader.GetRefSetArgument(*shells);
 
-                for (auto &shell : shells)
+                for (uint32_t shellRef : *shells)
                 {
-                    uint32_t shellRef = _loader.GetRefArgument(shell);
                     IfcComposedMesh temp;
-                    _expressIDToGeometry[shellRef] = GetBrep(shellRef);
+                    _expressIDToGeometry.Get()[shellRef] = GetBrep(shellRef);
                     std::optional<glm::dvec4> shellColor = GetStyleItemFromExpressId(shellRef);
                     if (shellColor)
                     {
@@ -580,7 +1152,7 @@ namespace webifc::geometry
                 int unitaryFaces = 0;
                 for (auto &child : mesh.children)
                 {
-                    auto temp = _expressIDToGeometry[child.expressID];
+                    auto temp = _expressIDToGeometry.Get()[child.expressID];
                     if (temp.numFaces < 4)
                     {
                         unitaryFaces++;
@@ -592,11 +1164,11 @@ namespace webifc::geometry
                 {
                     for (auto &child : mesh.children)
                     {
-                        auto temp = _expressIDToGeometry[child.expressID];
+                        auto temp = _expressIDToGeometry.Get()[child.expressID];
                         newGeometry.AddGeometry(temp);
                     }
                     IfcComposedMesh newMesh;
-                    _expressIDToGeometry[expressID] = newGeometry;
+                    _expressIDToGeometry.Get()[expressID] = newGeometry;
                     std::optional<glm::dvec4> shellColor = GetStyleItemFromExpressId(expressID);
                     if (shellColor)
                     {
@@ -616,7 +1188,16 @@ namespace webifc::geometry
                 _loader.MoveToArgumentOffset(expressID, 0);
                 uint32_t ifcPresentation = _loader.GetRefArgument();
 
-                _expressIDToGeometry[expressID] = GetBrep(ifcPresentation);
+                uint64_t contentHash;
+                if (auto shared = GetSharedGeometry(expressID, UINT32_MAX, contentHash))
+                {
+                    mesh.expressID = *shared;
+                }
+                else
+                {
+                    _expressIDToGeometry.Get()[expressID] = GetBrep(ifcPresentation);
+                    ShareGeometry(expressID, contentHash);
+                }
                 if (!mesh.hasColor)
                     mesh.color = GetStyleItemFromExpressId(ifcPresentation).value_or(glm::dvec4(1.0));
                 mesh.hasGeometry = true;
@@ -628,7 +1209,16 @@ namespace webifc::geometry
                 _loader.MoveToArgumentOffset(expressID, 0);
                 uint32_t ifcPresentation = _loader.GetRefArgument();
 
-                _expressIDToGeometry[expressID] = GetBrep(ifcPresentation);
+                uint64_t contentHash;
+                if (auto shared = GetSharedGeometry(expressID, UINT32_MAX, contentHash))
+                {
+                    mesh.expressID = *shared;
+                }
+                else
+                {
+                    _expressIDToGeometry.Get()[expressID] = GetBrep(ifcPresentation);
+                    ShareGeometry(expressID, contentHash);
+                }
                 if (!mesh.hasColor)
                     mesh.color = GetStyleItemFromExpressId(ifcPresentation).value_or(glm::dvec4(1.0));
                 ;
@@ -640,11 +1230,11 @@ namespace webifc::geometry
             case schema::IFCPRODUCTDEFINITIONSHAPE:
             {
                 _loader.MoveToArgumentOffset(expressID, 2);
-                auto representations = _loader.GetSetArgument();
+                utility::ScratchVector<uint32_t> representations;
+                _loader.GetRefSetArgument(*representations);
 
-                for (auto &repToken : representations)
+                for (uint32_t repID : *representations)
                 {
-                    uint32_t repID = _loader.GetRefArgument(repToken);
                     mesh.children.push_back(GetMesh(repID));
                 }
 
@@ -658,11 +1248,11 @@ namespace webifc::geometry
                 auto type = _loader.GetStringArgument();
 
                 _loader.MoveToArgumentOffset(expressID, 3);
-                auto repItems = _loader.GetSetArgument();
+                utility::ScratchVector<uint32_t> repItems;
+                _loader.GetRefSetArgument(*repItems);
 
-                for (auto &repToken : repItems)
+                for (uint32_t repID : *repItems)
                 {
-                    uint32_t repID = _loader.GetRefArgument(repToken);
                     mesh.children.push_back(GetMesh(repID));
                 }
 
@@ -670,6 +1260,14 @@ namespace webifc::geometry
             }
             case schema::IFCPOLYGONALFACESET:
             {
+                uint64_t contentHash;
+                if (auto shared = GetSharedGeometry(expressID, UINT32_MAX, contentHash))
+                {
+                    mesh.expressID = *shared;
+                    mesh.hasGeometry = true;
+                    return mesh;
+                }
+
                 _loader.MoveToArgumentOffset(expressID, 0);
 
                 auto coordinatesRef = _loader.GetRefArgument();
@@ -679,14 +1277,14 @@ namespace webifc::geometry
 
                 // indices
                 _loader.MoveToArgumentOffset(expressID, 2);
-                auto faces = _loader.GetSetArgument();
+                utility::ScratchVector<uint32_t> faces;
+                _loader.GetRefSetArgument(*faces);
 
                 IfcGeometry geom;
 
                 std::vector<IfcBound3D> bounds;
-                for (auto &face : faces)
+                for (uint32_t faceID : *faces)
                 {
-                    uint32_t faceID = _loader.GetRefArgument(face);
                     ReadIndexedPolygonalFace(faceID, bounds, points);
 
                     TriangulateBounds(geom, bounds, expressID);
@@ -700,7 +1298,8 @@ namespace webifc::geometry
                     spdlog::error("[GetMesh()] Unsupported IFCPOLYGONALFACESET with PnIndex {}", expressID);
                 }
 
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
+                ShareGeometry(expressID, contentHash);
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
 
@@ -710,14 +1309,14 @@ namespace webifc::geometry
             {
                 IfcGeometry geometry;
                 _loader.MoveToArgumentOffset(expressID, 0);
-                auto bounds = _loader.GetSetArgument();
+                utility::ScratchVector<uint32_t> bounds;
+                _loader.GetRefSetArgument(*bounds);
 
-                std::vector<IfcBound3D> bounds3D(bounds.size());
+                std::vector<IfcBound3D> bounds3D(bounds->size());
 
-                for (size_t i = 0; i < bounds.size(); i++)
+                for (size_t i = 0; i < bounds->size(); i++)
                 {
-                    uint32_t boundID = _loader.GetRefArgument(bounds[i]);
-                    bounds3D[i] = _geometryLoader.GetBound(boundID);
+                    bounds3D[i] = _geometryLoader.GetBound((*bounds)[i]);
                 }
 
                 TriangulateBounds(geometry, bounds3D, expressID);
@@ -748,7 +1347,7 @@ namespace webifc::geometry
                     TriangulateBounds(geometry, bounds3D, expressID);
                 }
 
-                _expressIDToGeometry[expressID] = geometry;
+                _expressIDToGeometry.Get()[expressID] = geometry;
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
 
@@ -757,43 +1356,26 @@ namespace webifc::geometry
             case schema::IFCTRIANGULATEDIRREGULARNETWORK:
             case schema::IFCTRIANGULATEDFACESET:
             {
-                _loader.MoveToArgumentOffset(expressID, 0);
-
-                auto coordinatesRef = _loader.GetRefArgument();
-                auto points = _geometryLoader.ReadIfcCartesianPointList3D(coordinatesRef);
-
-                // second argument normals, ignored
-                // third argument closed, ignored
-
-                // indices
-                _loader.MoveToArgumentOffset(expressID, 3);
-                auto indices = Read2DArrayOfThreeIndices();
-
-                IfcGeometry geom;
-
-                _loader.MoveToArgumentOffset(expressID, 4);
-                if (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
+                std::vector<glm::dvec3> points;
+                std::vector<uint32_t> indices;
+                ReadTriangulatedFaceSet(expressID, points, indices);
+                mesh.expressID = expressID;
+                // StreamTerrain hands it over in chunks instead of as one geometry
+                if (IsChunkedTerrain(lineType, indices.size() / 3))
                 {
-                    _loader.StepBack();
-                    auto pnIndex = Read2DArrayOfThreeIndices();
-
-                    // ignore
-                    // std::cout << "Unsupported IFCTRIANGULATEDFACESET with PnIndex!" << std::endl;
+                    return mesh;
                 }
 
+                IfcGeometry geom;
+
                 for (size_t i = 0; i < indices.size(); i += 3)
                 {
-                    int i1 = indices[i + 0] - 1;
-                    int i2 = indices[i + 1] - 1;
-                    int i3 = indices[i + 2] - 1;
-
-                    geom.AddFace(points[i1], points[i2], points[i3]);
+                    geom.AddFace(points[indices[i + 0]], points[indices[i + 1]], points[indices[i + 2]]);
                 }
 
                 // DumpIfcGeometry(geom, "test.obj");
 
-                _expressIDToGeometry[expressID] = geom;
-                mesh.expressID = expressID;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.hasGeometry = true;
 
                 return mesh;
@@ -875,7 +1457,7 @@ namespace webifc::geometry
                 IfcGeometry geom = Sweep(_geometryLoader.GetLinearScalingFactor(), closed, profile, directrix, surface.normal(), true);
 
                 mesh.transformation = placement;
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
 
@@ -890,7 +1472,8 @@ namespace webifc::geometry
                 uint32_t fixedReferenceID = _loader.GetRefArgument();
 
                 // Retrieve profile, placement, directrix, and fixed reference direction
-                IfcProfile profile = _geometryLoader.GetProfile(profileID);
+                auto cachedProfile = _geometryLoader.GetCachedProfile(profileID);
+                const IfcProfile &profile = cachedProfile->profile;
                 glm::dmat4 placement = placementID ? _geometryLoader.GetLocalPlacement(placementID) : glm::dmat4(1.0);
                 IfcCurve directrix = _geometryLoader.GetCurve(directrixRef, 3);
                 glm::dvec3 fixedReference = _geometryLoader.GetCartesianPoint3D(fixedReferenceID);
@@ -914,7 +1497,7 @@ namespace webifc::geometry
                 );
 
                 // Store the geometry and update mesh
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
                 mesh.transformation = placement;
@@ -923,9 +1506,6 @@ namespace webifc::geometry
             }
             case schema::IFCSWEPTDISKSOLID:
             {
-                // TODO: prevent self intersections in Sweep function still not working properly
-                bool closed = false;
-
                 _loader.MoveToArgumentOffset(expressID, 0);
                 auto directrixRef = _loader.GetRefArgument();
 
@@ -956,16 +1536,15 @@ namespace webifc::geometry
 
                 IfcCurve directrix = _geometryLoader.GetCurve(directrixRef, 3);
 
-                IfcProfile profile;
-                profile.curve = GetCircleCurve(radius, _settings._circleSegments);
+                const IfcProfile &profile = GetDiskProfile(radius);
 
-                IfcGeometry geom = SweepCircular(_geometryLoader.GetLinearScalingFactor(), closed, profile, radius, directrix);
+                IfcGeometry geom = SweepDisk(_geometryLoader.GetLinearScalingFactor(), profile, directrix);
 
                 geom.sweptDiskSolid.axis = std::vector<IfcCurve>{directrix};
                 geom.sweptDiskSolid.profiles = std::vector<IfcProfile>{profile};
                 geom.sweptDiskSolid.profileRadius = radius;
 
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
 
@@ -981,7 +1560,8 @@ namespace webifc::geometry
                 uint32_t axis1PlacementID = _loader.GetRefArgument();
                 double angle = angleConversion(_loader.GetDoubleArgument(), _geometryLoader.GetAngleUnits());
 
-                IfcProfile profile = _geometryLoader.GetProfile(profileID);
+                auto cachedProfile = _geometryLoader.GetCachedProfile(profileID);
+                const IfcProfile &profile = cachedProfile->profile;
                 glm::dmat4 placement = _geometryLoader.GetLocalPlacement(placementID);
                 glm::dvec3 axis = _geometryLoader.GetAxis1Placement(axis1PlacementID)[0];
 
@@ -1012,7 +1592,7 @@ namespace webifc::geometry
                 }
 
                 mesh.transformation = placement;
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
                 if (!mesh.hasColor)
@@ -1029,8 +1609,23 @@ namespace webifc::geometry
                 uint32_t directionID = _loader.GetRefArgument();
                 double depth = _loader.GetDoubleArgument();
 
+                // the placement is applied as the mesh transformation, so solids placed differently share their geometry
+                uint64_t contentHash;
+                if (auto shared = GetSharedGeometry(expressID, 1, contentHash))
+                {
+                    if (placementID)
+                    {
+                        mesh.transformation = _geometryLoader.GetLocalPlacement(placementID);
+                    }
+                    mesh.expressID = *shared;
+                    mesh.hasGeometry = true;
+                    return mesh;
+                }
+
                 auto lineProfileType = _loader.GetLineType(profileID);
-                IfcProfile profile = _geometryLoader.GetProfile(profileID);
+                // extrusions of the same profile definition share its outline and the triangulation of its caps
+                auto cachedProfile = _geometryLoader.GetCachedProfile(profileID);
+                const IfcProfile &profile = cachedProfile->profile;
                 if (!profile.isComposite)
                 {
                     if (profile.curve.points.empty())
@@ -1068,7 +1663,7 @@ namespace webifc::geometry
 
                 if (!profile.isComposite)
                 {
-                    geom = Extrude(profile, dir, depth);
+                    geom = Extrude(profile, cachedProfile->GetCap(), dir, depth);
                     if (flipWinding)
                     {
                         for (uint32_t i = 0; i < geom.numFaces; i++)
@@ -1084,7 +1679,7 @@ namespace webifc::geometry
                 {
                     for (uint32_t i = 0; i < profile.profiles.size(); i++)
                     {
-                        IfcGeometry geom_t = Extrude(profile.profiles[i], dir, depth);
+                        IfcGeometry geom_t = Extrude(profile.profiles[i], cachedProfile->GetCap(i), dir, depth);
                         if (flipWinding)
                         {
                             for (uint32_t k = 0; k < geom_t.numFaces; k++)
@@ -1105,7 +1700,8 @@ namespace webifc::geometry
 //    io::DumpIfcGeometry(geom, "IFCEXTRUDEDAREASOLID_geom.obj");
 #endif
 
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
+                ShareGeometry(expressID, contentHash);
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
 
@@ -1137,7 +1733,7 @@ namespace webifc::geometry
                 io::DumpIfcGeometry(geom, "IFCRIGHTCIRCULARCYLINDER_geom.obj");
 #endif
 
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
                 mesh.expressID = expressID;
                 mesh.hasGeometry = true;
                 return mesh;
@@ -1176,7 +1772,7 @@ namespace webifc::geometry
                 geom.numPoints = 1;
                 geom.isPolygon = true;
                 mesh.hasGeometry = true;
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
 
                 return mesh;
             }
@@ -1200,7 +1796,7 @@ namespace webifc::geometry
                 geom.numPoints = edge.points.size();
                 geom.isPolygon = true;
                 mesh.hasGeometry = true;
-                _expressIDToGeometry[expressID] = geom;
+                _expressIDToGeometry.Get()[expressID] = geom;
 
                 return mesh;
             }
@@ -1232,7 +1828,7 @@ namespace webifc::geometry
                     geom.numPoints = curve.points.size();
                     geom.isPolygon = true;
                     mesh.hasGeometry = true;
-                    _expressIDToGeometry[expressID] = geom;
+                    _expressIDToGeometry.Get()[expressID] = geom;
                 }
 
                 return mesh;
@@ -1641,10 +2237,28 @@ namespace webifc::geometry
     IfcFlatMesh IfcGeometryProcessor::GetFlatMesh(uint32_t expressID, bool applyLinearScalingFactor)
     {
         spdlog::debug("[GetFlatMesh({})]", expressID);
+        WEBIFC_TRACE_SCOPE("GetFlatMesh", expressID);
+        // the previous element is done with its geometry, so this is where the store is brought back within its budget
+        if (_geometryMemoryLimit > 0)
+        {
+            _expressIDToGeometry.Get().Trim(_geometryMemoryLimit);
+            _lodGeometries.Get().clear();
+        }
+        if (auto cached = GetCachedFlatMesh(expressID, applyLinearScalingFactor))
+        {
+            return *cached;
+        }
+
         IfcFlatMesh flatMesh;
         flatMesh.expressID = expressID;
 
-        IfcComposedMesh composedMesh = GetMesh(expressID);
+        IfcComposedMesh composedMesh;
+        {
+            // the transient buffers of the element come from the arena of this thread, which is reset once it is meshed
+            utility::ArenaScope arenaScope;
+            ElementBudgetScope budgetScope({expressID, Deadline(_elementTimeBudget)});
+            composedMesh = GetMesh(expressID);
+        }
 
         glm::dmat4 mat = glm::dmat4(1);
         if (applyLinearScalingFactor)
@@ -1653,286 +2267,1341 @@ namespace webifc::geometry
             ;
         }
 
+        CoordinateFromPlacements(applyLinearScalingFactor);
+
         glm::dvec4 color = glm::dvec4(1, 1, 1, 1);
         bool hasColor = false;
-        AddComposedMeshToFlatMesh(flatMesh, composedMesh, _transformation * NormalizeIFC * mat, color, hasColor);
+        {
+            utility::ScopedTimer timer(_flattenTime);
+            AddComposedMeshToFlatMesh(flatMesh, composedMesh, _transformation * NormalizeIFC * mat, color, hasColor);
+        }
+        if (!IsOverBudget(expressID))
+        {
+            CacheFlatMesh(flatMesh, applyLinearScalingFactor);
+        }
 
         return flatMesh;
     }
 
-    void IfcGeometryProcessor::AddComposedMeshToFlatMesh(IfcFlatMesh &flatMesh, const IfcComposedMesh &composedMesh, const glm::dmat4 &parentMatrix, const glm::dvec4 &color, bool hasColor)
+    bool IfcGeometryProcessor::GetElementBounds(uint32_t expressID, glm::dvec3 &min, glm::dvec3 &max, bool applyLinearScalingFactor)
     {
-
-        glm::dvec4 newParentColor = color;
-        bool newHasColor = hasColor;
-        glm::dmat4 newMatrix = parentMatrix * composedMesh.transformation;
-
-        if (composedMesh.hasColor && !hasColor)
+        if (!_loader.IsValidExpressID(expressID) || !_schemaManager.IsIfcElement(_loader.GetLineType(expressID)))
         {
-            newHasColor = true;
-            newParentColor = composedMesh.color;
+            return false;
         }
-
-        if (composedMesh.hasGeometry)
+        _loader.MoveToArgumentOffset(expressID, 5);
+        uint32_t localPlacement = _loader.GetOptionalRefArgument();
+        uint32_t representation = _loader.GetOptionalRefArgument();
+        if (representation == 0 || !_loader.IsValidExpressID(representation))
         {
-            IfcPlacedGeometry geometry;
+            return false;
+        }
 
-            if (!_isCoordinated && _settings._coordinateToOrigin)
-            {
-                auto &geom = _expressIDToGeometry[composedMesh.expressID];
-                if (geom.numPoints > 0)
-                {
-                    auto pt = geom.GetPoint(0);
-                    auto transformedPt = newMatrix * glm::dvec4(pt, 1);
-                    _coordinationMatrix = glm::translate(-glm::dvec3(transformedPt));
-                    _isCoordinated = true;
-                }
-            }
+        glm::dmat4 transformation = _transformation * NormalizeIFC;
+        if (applyLinearScalingFactor)
+        {
+            transformation *= glm::scale(glm::dvec3(_geometryLoader.GetLinearScalingFactor()));
+        }
+        if (localPlacement != 0 && _loader.IsValidExpressID(localPlacement))
+        {
+            transformation *= _geometryLoader.GetLocalPlacement(localPlacement);
+        }
 
-            auto geom = _expressIDToGeometry[composedMesh.expressID];
-            if (geom.isPolygon)
+        min = glm::dvec3(DBL_MAX);
+        max = glm::dvec3(-DBL_MAX);
+        if (_loader.GetLineType(representation) != schema::IFCPRODUCTDEFINITIONSHAPE)
+        {
+            return AddItemBounds(representation, transformation, min, max);
+        }
+        _loader.MoveToArgumentOffset(representation, 2);
+        auto representations = _loader.GetSetArgument();
+        std::vector<uint32_t> representationIDs;
+        for (auto &repToken : representations)
+        {
+            representationIDs.push_back(_loader.GetRefArgument(repToken));
+        }
+        // a Box representation is the element's own bounding box, it is taken alone
+        for (uint32_t repID : representationIDs)
+        {
+            _loader.MoveToArgumentOffset(repID, 1);
+            if (_loader.GetTokenType() == parsing::IfcTokenType::STRING)
             {
-                if (!_settings._exportPolylines)
+                _loader.StepBack();
+                if (_loader.GetStringArgument() == "Box" && AddItemBounds(repID, transformation, min, max))
                 {
-                    return; // only triangles
+                    return true;
                 }
             }
-            if (geometry.testReverse())
-                geom.ReverseFaces();
-
-            auto translation = glm::dmat4(1.0);
-
-            translation = geom.Normalize();
-
-            _expressIDToGeometry[composedMesh.expressID] = geom;
-
-            if (!composedMesh.hasColor)
-            {
-                geometry.color = newParentColor;
-            }
-            else
-            {
-                geometry.color = composedMesh.color;
-                newParentColor = composedMesh.color;
-                newHasColor = composedMesh.hasColor;
-            }
-
-            geometry.transformation = _coordinationMatrix * newMatrix * translation;
-
-            geometry.SetFlatTransformation();
-            geometry.geometryExpressID = composedMesh.expressID;
-
-            flatMesh.geometries.push_back(geometry);
-        }
-        else if (composedMesh.hasColor)
-        {
-            newParentColor = composedMesh.color;
-            newHasColor = composedMesh.hasColor;
         }
-
-        for (auto &c : composedMesh.children)
+        bool bounded = false;
+        for (uint32_t repID : representationIDs)
         {
-            AddComposedMeshToFlatMesh(flatMesh, c, newMatrix, newParentColor, newHasColor);
+            bounded |= AddItemBounds(repID, transformation, min, max);
         }
+        return bounded;
     }
 
-    IfcGeometry IfcGeometryProcessor::BoolProcess(const std::vector<IfcGeometry> &firstGeoms, std::vector<IfcGeometry> &secondGeoms, std::string op, IfcGeometrySettings _settings)
-    {
-        return _boolEngine.BoolProcess(firstGeoms, secondGeoms, op, _settings);
-    }
-
-    std::vector<uint32_t> IfcGeometryProcessor::Read2DArrayOfThreeIndices()
+    uint32_t IfcGeometryProcessor::EstimateMeshingCost(uint32_t expressID)
     {
-        std::vector<uint32_t> result;
-
-        _loader.GetTokenType();
-
-        // while we have point set begin
-        while (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
+        if (!_loader.IsValidExpressID(expressID) || !_schemaManager.IsIfcElement(_loader.GetLineType(expressID)))
         {
-            result.push_back((uint32_t)_loader.GetIntArgument());
-            result.push_back((uint32_t)_loader.GetIntArgument());
-            result.push_back((uint32_t)_loader.GetIntArgument());
-
-            // read point set end
-            _loader.GetTokenType();
+            return 0;
+        }
+        _loader.MoveToArgumentOffset(expressID, 6);
+        uint32_t representation = _loader.GetOptionalRefArgument();
+        if (representation == 0 || !_loader.IsValidExpressID(representation))
+        {
+            return 0;
         }
 
-        return result;
-    }
-
-    void IfcGeometryProcessor::ReadIndexedPolygonalFace(uint32_t expressID, std::vector<IfcBound3D> &bounds, const std::vector<glm::dvec3> &points)
-    {
-
-        spdlog::debug("[ReadIndexedPolygonalFace({})]", expressID);
-        auto lineType = _loader.GetLineType(expressID);
-
-        bounds.emplace_back();
-
-        switch (lineType)
+        std::vector<uint32_t> representationIDs;
+        if (_loader.GetLineType(representation) == schema::IFCPRODUCTDEFINITIONSHAPE)
         {
-        case schema::IFCINDEXEDPOLYGONALFACEWITHVOIDS:
-        case schema::IFCINDEXEDPOLYGONALFACE:
+            _loader.MoveToArgumentOffset(representation, 2);
+            _loader.GetRefSetArgument(representationIDs);
+        }
+        else
         {
-            _loader.MoveToArgumentOffset(expressID, 0);
-            auto indexIDs = _loader.GetSetArgument();
-
-            IfcGeometry geometry;
-            for (auto &indexID : indexIDs)
+            representationIDs.push_back(representation);
+        }
+        uint32_t cost = 1;
+        std::vector<uint32_t> items;
+        for (uint32_t repID : representationIDs)
+        {
+            if (!_loader.IsValidExpressID(repID))
             {
-                uint32_t index = _loader.GetIntArgument(indexID);
-                glm::dvec3 point = points[index - 1]; // indices are 1-based
-
-                // I am not proud of this
-                bounds.back().curve.points.push_back(point);
+                continue;
             }
-
-            if (lineType == schema::IFCINDEXEDPOLYGONALFACE)
+            const uint32_t repType = _loader.GetLineType(repID);
+            if (repType != schema::IFCSHAPEREPRESENTATION && repType != schema::IFCTOPOLOGYREPRESENTATION)
             {
-                break;
+                continue;
             }
-
-            // case IFCINDEXEDPOLYGONALFACEWITHVOIDS
-            _loader.MoveToArgumentOffset(expressID, 1);
-
-            // guaranteed to be set begin
-            _loader.GetTokenType();
-
-            // while we have hole-index set begin
-            while (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
+            _loader.MoveToArgumentOffset(repID, 3);
+            _loader.GetRefSetArgument(items);
+            for (uint32_t item : items)
             {
-                bounds.emplace_back();
-
-                while (_loader.GetTokenType() != parsing::IfcTokenType::SET_END)
+                if (_loader.IsValidExpressID(item))
                 {
-                    _loader.StepBack();
-                    uint32_t index = _loader.GetIntArgument();
-
-                    glm::dvec3 point = points[index - 1]; // indices are still 1-based
-
-                    // I am also not proud of this
-                    bounds.back().curve.points.push_back(point);
+                    cost += ItemMeshingCost(_loader.GetLineType(item));
                 }
             }
-
-            break;
         }
-        default:
-            spdlog::error("[ReadIndexedPolygonalFace()] unexpected indexedface type {}", expressID, lineType);
-            break;
+        // every opening is meshed and subtracted from the element
+        auto &relVoids = _geometryLoader.GetRelVoids();
+        auto voids = relVoids.find(expressID);
+        if (voids != relVoids.end())
+        {
+            cost += 8 * static_cast<uint32_t>(voids->second.size());
         }
+        return cost;
     }
 
-    IfcGeometry IfcGeometryProcessor::GetBrep(uint32_t expressID)
+    bool IfcGeometryProcessor::GetElementQuantities(uint32_t expressID, IfcElementQuantities &quantities)
     {
-        spdlog::debug("[GetBrep({})]", expressID);
-        auto lineType = _loader.GetLineType(expressID);
-        switch (lineType)
-        {
-        case schema::IFCCONNECTEDFACESET:
-        case schema::IFCCLOSEDSHELL:
-        case schema::IFCOPENSHELL:
+        quantities = IfcElementQuantities();
+        IfcFlatMesh mesh = GetFlatMesh(expressID);
+        bool measured = false;
+        for (auto &placed : mesh.geometries)
         {
-            _loader.MoveToArgumentOffset(expressID, 0);
-            auto faces = _loader.GetSetArgument();
-
-            IfcGeometry geometry;
-            for (auto &faceToken : faces)
+            IfcGeometry &geometry = GetGeometry(placed.geometryExpressID);
+            if (geometry.numPoints == 0 || geometry.vertexData.size() != static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS)
             {
-                uint32_t faceID = _loader.GetRefArgument(faceToken);
-                AddFaceToGeometry(faceID, geometry);
+                continue;
             }
-
-            return geometry;
-        }
-        default:
-            spdlog::error("[GetBrep()] unexpected shell type {}", expressID, lineType);
-            break;
+            quantities.volume += geometry.Volume(placed.transformation);
+            quantities.area += geometry.Area(placed.transformation);
+            for (uint32_t i = 0; i < geometry.numPoints; i++)
+            {
+                const glm::dvec3 point = glm::dvec3(placed.transformation * glm::dvec4(geometry.GetPoint(i), 1));
+                quantities.min = glm::min(quantities.min, point);
+                quantities.max = glm::max(quantities.max, point);
+            }
+            measured = true;
         }
-
-        return IfcGeometry();
+        return measured;
     }
 
-    void IfcGeometryProcessor::AddFaceToGeometry(uint32_t expressID, IfcGeometry &geometry)
+    bool IfcGeometryProcessor::AddItemBounds(uint32_t expressID, const glm::dmat4 &transformation, glm::dvec3 &min, glm::dvec3 &max)
     {
-        spdlog::debug("[AddFaceToGeometry({})]", expressID);
-        auto lineType = _loader.GetLineType(expressID);
-
-        switch (lineType)
+        if (expressID == 0 || !_loader.IsValidExpressID(expressID))
         {
-        case schema::IFCFACE:
-        {
-            _loader.MoveToArgumentOffset(expressID, 0);
-            auto bounds = _loader.GetSetArgument();
-
-            std::vector<IfcBound3D> bounds3D(bounds.size());
-
-            for (size_t i = 0; i < bounds.size(); i++)
-            {
-                uint32_t boundID = _loader.GetRefArgument(bounds[i]);
-                bounds3D[i] = _geometryLoader.GetBound(boundID);
-            }
-
-            TriangulateBounds(geometry, bounds3D, expressID);
-            break;
+            return false;
         }
-        case schema::IFCADVANCEDFACE:
+        auto addPoint = [&](const glm::dvec3 &point)
         {
-            _loader.MoveToArgumentOffset(expressID, 0);
-            auto bounds = _loader.GetSetArgument();
-
-            std::vector<IfcBound3D> bounds3D(bounds.size());
-
-            for (size_t i = 0; i < bounds.size(); i++)
-            {
-                uint32_t boundID = _loader.GetRefArgument(bounds[i]);
-                bounds3D[i] = _geometryLoader.GetBound(boundID);
-            }
-
-            _loader.MoveToArgumentOffset(expressID, 1);
-            auto surfRef = _loader.GetRefArgument();
-
-            auto surface = GetSurface(surfRef);
-
-            // TODO: place the face in the surface and tringulate
-
-            if (surface.BSplineSurface.Active)
+            const glm::dvec3 placed = glm::dvec3(transformation * glm::dvec4(point, 1));
+            min = glm::min(min, placed);
+            max = glm::max(max, placed);
+        };
+        switch (_loader.GetLineType(expressID))
+        {
+        case schema::IFCTOPOLOGYREPRESENTATION:
+        case schema::IFCSHAPEREPRESENTATION:
+        case schema::IFCFACETEDBREP:
+        case schema::IFCCLOSEDSHELL:
+        case schema::IFCOPENSHELL:
+        case schema::IFCCONNECTEDFACESET:
+        case schema::IFCFACE:
+        case schema::IFCFACEBASEDSURFACEMODEL:
+        case schema::IFCSHELLBASEDSURFACEMODEL:
+        {
+            // the items of a representation are its fourth argument, the shell of a brep, the faces of a shell, the bounds
+            // of a face and the shells of a surface model are the first
+            const bool representation = _loader.GetLineType(expressID) == schema::IFCTOPOLOGYREPRESENTATION || _loader.GetLineType(expressID) == schema::IFCSHAPEREPRESENTATION;
+            _loader.MoveToArgumentOffset(expressID, representation ? 3 : 0);
+            std::vector<uint32_t> children;
+            if (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
             {
-                TriangulateBspline(geometry, bounds3D, surface, _geometryLoader.GetLinearScalingFactor());
+                _loader.StepBack();
+                for (auto &token : _loader.GetSetArgument())
+                {
+                    children.push_back(_loader.GetRefArgument(token));
+                }
             }
-            else if (surface.CylinderSurface.Active)
+            else
             {
-                TriangulateCylindricalSurface(geometry, bounds3D, surface, _settings._circleSegments);
+                _loader.StepBack();
+                children.push_back(_loader.GetOptionalRefArgument());
             }
-            else if (surface.RevolutionSurface.Active)
+            bool bounded = false;
+            for (uint32_t child : children)
             {
-                TriangulateRevolution(geometry, bounds3D, surface, _settings._circleSegments);
+                bounded |= AddItemBounds(child, transformation, min, max);
             }
-            else if (surface.ExtrusionSurface.Active)
+            return bounded;
+        }
+        case schema::IFCFACEOUTERBOUND:
+        case schema::IFCFACEBOUND:
+        {
+            auto bound = _geometryLoader.GetBound(expressID);
+            for (auto &point : bound.curve.points)
             {
-                TriangulateExtrusion(geometry, bounds3D, surface);
+                addPoint(point);
             }
-            else
+            return !bound.curve.points.empty();
+        }
+        case schema::IFCBOUNDINGBOX:
+        {
+            _loader.MoveToArgumentOffset(expressID, 0);
+            uint32_t cornerID = _loader.GetRefArgument();
+            glm::dvec3 size;
+            size.x = _loader.GetDoubleArgument();
+            size.y = _loader.GetDoubleArgument();
+            size.z = _loader.GetDoubleArgument();
+            const glm::dvec3 corner = _geometryLoader.GetCartesianPoint3D(cornerID);
+            for (int i = 0; i < 8; i++)
             {
-                TriangulateBounds(geometry, bounds3D, expressID);
+                addPoint(corner + glm::dvec3((i & 1) ? size.x : 0, (i & 2) ? size.y : 0, (i & 4) ? size.z : 0));
             }
-            break;
+            return true;
         }
-        default:
-            spdlog::error("[AddFaceToGeometry()] unexpected face type {}", expressID, lineType);
-            break;
+        case schema::IFCMAPPEDITEM:
+        {
+            _loader.MoveToArgumentOffset(expressID, 0);
+            uint32_t mapID = _loader.GetRefArgument();
+            uint32_t targetID = _loader.GetRefArgument();
+            _loader.MoveToArgumentOffset(mapID, 0);
+            uint32_t originID = _loader.GetRefArgument();
+            uint32_t representationID = _loader.GetRefArgument();
+            return AddItemBounds(representationID, transformation * _geometryLoader.GetLocalPlacement(targetID) * _geometryLoader.GetLocalPlacement(originID), min, max);
         }
-    }
-
-    fuzzybools::Geometry booleanManager::convertToEngine(Geometry geom)
-    {
-        fuzzybools::Geometry newGeom;
-        newGeom.fvertexData = geom.fvertexData;
-        newGeom.vertexData = geom.vertexData;
-        newGeom.indexData = geom.indexData;
-        newGeom.planeData = geom.planeData;
+        case schema::IFCBOOLEANRESULT:
+        case schema::IFCBOOLEANCLIPPINGRESULT:
+        {
+            // the first operand bounds differences and clippings, which are most booleans
+            _loader.MoveToArgumentOffset(expressID, 1);
+            return AddItemBounds(_loader.GetRefArgument(), transformation, min, max);
+        }
+        case schema::IFCEXTRUDEDAREASOLID:
+        {
+            _loader.MoveToArgumentOffset(expressID, 0);
+            uint32_t profileID = _loader.GetRefArgument();
+            uint32_t placementID = _loader.GetOptionalRefArgument();
+            uint32_t directionID = _loader.GetRefArgument();
+            double depth = _loader.GetDoubleArgument();
+            // the profile is cached, so the extrusion meshed later reuses it
+            auto cachedProfile = _geometryLoader.GetCachedProfile(profileID);
+            const glm::dmat4 placement = placementID ? transformation * _geometryLoader.GetLocalPlacement(placementID) : transformation;
+            const glm::dvec3 extrusion = _geometryLoader.GetCartesianPoint3D(directionID) * depth;
+            bool bounded = false;
+            auto addProfile = [&](const IfcProfile &profile)
+            {
+                for (auto &point : profile.curve.points)
+                {
+                    const glm::dvec3 base(point.x, point.y, 0);
+                    for (const glm::dvec3 &p : {base, base + extrusion})
+                    {
+                        const glm::dvec3 placed = glm::dvec3(placement * glm::dvec4(p, 1));
+                        min = glm::min(min, placed);
+                        max = glm::max(max, placed);
+                    }
+                    bounded = true;
+                }
+            };
+            addProfile(cachedProfile->profile);
+            for (auto &profile : cachedProfile->profile.profiles)
+            {
+                addProfile(profile);
+            }
+            return bounded;
+        }
+        case schema::IFCTRIANGULATEDFACESET:
+        case schema::IFCPOLYGONALFACESET:
+        {
+            _loader.MoveToArgumentOffset(expressID, 0);
+            auto points = _geometryLoader.ReadIfcCartesianPointList3D(_loader.GetRefArgument());
+            for (auto &point : points)
+            {
+                addPoint(point);
+            }
+            return !points.empty();
+        }
+        default:
+            return false;
+        }
+    }
+
+    IfcFlatMesh IfcGeometryProcessor::GetFlatMeshLOD(uint32_t expressID, uint32_t lod, bool applyLinearScalingFactor)
+    {
+        IfcFlatMesh flatMesh = GetFlatMesh(expressID, applyLinearScalingFactor);
+        if (lod > 0)
+        {
+            for (const auto &placedGeometry : flatMesh.geometries)
+            {
+                GetGeometry(placedGeometry.geometryExpressID, lod);
+            }
+        }
+        return flatMesh;
+    }
+
+    bool IfcGeometryProcessor::BakePlacedGeometry(const IfcPlacedGeometry &placedGeometry, std::vector<float> &vertexData, std::vector<uint32_t> &indexData)
+    {
+        IfcGeometry &geometry = GetGeometry(placedGeometry.geometryExpressID);
+        const size_t size = static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS;
+        const bool useDoubles = geometry.vertexData.size() == size;
+        const bool useFloats = !useDoubles && geometry.fvertexData.size() == size;
+        vertexData.clear();
+        indexData.clear();
+        if (geometry.numPoints != 0 && !useDoubles && !useFloats)
+        {
+            spdlog::warn("[BakePlacedGeometry()] vertices of geometry {} were released", placedGeometry.geometryExpressID);
+            return false;
+        }
+
+        vertexData.resize(size);
+        if (useDoubles)
+        {
+            BakeVertices(geometry.vertexData.data(), geometry.numPoints, placedGeometry.transformation, vertexData.data());
+        }
+        else if (useFloats)
+        {
+            BakeVertices(geometry.fvertexData.data(), geometry.numPoints, placedGeometry.transformation, vertexData.data());
+        }
+        const bool reverse = glm::determinant(glm::dmat3(placedGeometry.transformation)) < 0;
+        indexData.resize(static_cast<size_t>(geometry.numFaces) * 3);
+        for (uint32_t i = 0; i < geometry.numFaces; i++)
+        {
+            indexData[i * 3 + 0] = geometry.indexData[i * 3 + 0];
+            indexData[i * 3 + 1] = geometry.indexData[i * 3 + (reverse ? 2 : 1)];
+            indexData[i * 3 + 2] = geometry.indexData[i * 3 + (reverse ? 1 : 2)];
+        }
+        return true;
+    }
+
+    size_t IfcGeometryProcessor::AddPolylines(uint32_t expressID, IfcPolylineBuffer &buffer, bool applyLinearScalingFactor)
+    {
+        size_t curves = 0;
+        IfcFlatMesh flatMesh = GetFlatMesh(expressID, applyLinearScalingFactor);
+        for (auto &placedGeometry : flatMesh.geometries)
+        {
+            IfcGeometry &geometry = GetGeometry(placedGeometry.geometryExpressID);
+            if (!geometry.isPolygon)
+            {
+                continue;
+            }
+            const size_t size = static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS;
+            const bool useDoubles = geometry.vertexData.size() == size;
+            if (!useDoubles && geometry.fvertexData.size() != size)
+            {
+                spdlog::warn("[AddPolylines()] vertices of geometry {} were released", placedGeometry.geometryExpressID);
+                continue;
+            }
+            for (uint32_t i = 0; i < geometry.numPoints; i++)
+            {
+                const size_t offset = static_cast<size_t>(i) * VERTEX_FORMAT_SIZE_FLOATS;
+                const glm::dvec3 point = useDoubles ? glm::dvec3(geometry.vertexData[offset], geometry.vertexData[offset + 1], geometry.vertexData[offset + 2])
+                                                    : glm::dvec3(geometry.fvertexData[offset], geometry.fvertexData[offset + 1], geometry.fvertexData[offset + 2]);
+                buffer.AddPoint(glm::dvec3(placedGeometry.transformation * glm::dvec4(point, 1)));
+            }
+            const size_t before = buffer.expressIDs.size();
+            buffer.EndCurve(expressID);
+            curves += buffer.expressIDs.size() - before;
+        }
+        return curves;
+    }
+
+    std::vector<IfcMergedMesh> IfcGeometryProcessor::GetMergedMeshes(const std::vector<uint32_t> &expressIDs, bool applyLinearScalingFactor)
+    {
+        std::vector<IfcMergedMesh> meshes;
+        std::map<std::array<double, 4>, size_t> meshByColor;
+
+        for (uint32_t expressID : expressIDs)
+        {
+            IfcFlatMesh flatMesh = GetFlatMesh(expressID, applyLinearScalingFactor);
+            for (auto &placedGeometry : flatMesh.geometries)
+            {
+                IfcGeometry &geometry = GetGeometry(placedGeometry.geometryExpressID);
+                // released float vertices are still good to merge, quantized ones are not
+                const bool useDoubles = geometry.vertexData.size() == geometry.numPoints * VERTEX_FORMAT_SIZE_FLOATS;
+                const bool useFloats = !useDoubles && geometry.fvertexData.size() == geometry.numPoints * VERTEX_FORMAT_SIZE_FLOATS;
+                if (geometry.numPoints == 0 || (!useDoubles && !useFloats))
+                {
+                    if (geometry.numPoints != 0)
+                    {
+                        spdlog::warn("[GetMergedMeshes()] vertices of geometry {} were released", placedGeometry.geometryExpressID);
+                    }
+                    continue;
+                }
+
+                const glm::dvec4 &color = placedGeometry.color;
+                auto [entry, added] = meshByColor.try_emplace({color.r, color.g, color.b, color.a}, meshes.size());
+                if (added)
+                {
+                    meshes.emplace_back();
+                    meshes.back().color = color;
+                }
+                IfcMergedMesh &mesh = meshes[entry->second];
+
+                const glm::dmat4 &transformation = placedGeometry.transformation;
+                const bool reverse = glm::determinant(glm::dmat3(transformation)) < 0;
+                const uint32_t firstVertex = static_cast<uint32_t>(mesh.vertexData.size() / VERTEX_FORMAT_SIZE_FLOATS);
+
+                mesh.vertexData.resize(mesh.vertexData.size() + static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS);
+                float *output = mesh.vertexData.data() + static_cast<size_t>(firstVertex) * VERTEX_FORMAT_SIZE_FLOATS;
+                if (useDoubles)
+                {
+                    BakeVertices(geometry.vertexData.data(), geometry.numPoints, transformation, output);
+                }
+                else
+                {
+                    BakeVertices(geometry.fvertexData.data(), geometry.numPoints, transformation, output);
+                }
+
+                const uint32_t indexOffset = static_cast<uint32_t>(mesh.indexData.size());
+                mesh.indexData.reserve(mesh.indexData.size() + geometry.numFaces * 3);
+                for (uint32_t i = 0; i < geometry.numFaces; i++)
+                {
+                    const uint32_t a = firstVertex + geometry.indexData[i * 3 + 0];
+                    const uint32_t b = firstVertex + geometry.indexData[i * 3 + 1];
+                    const uint32_t c = firstVertex + geometry.indexData[i * 3 + 2];
+                    mesh.indexData.insert(mesh.indexData.end(), {a, reverse ? c : b, reverse ? b : c});
+                }
+                const uint32_t indexCount = static_cast<uint32_t>(mesh.indexData.size()) - indexOffset;
+
+                // the geometries of an element are merged one after the other, so its ranges in a mesh join up
+                if (!mesh.ranges.empty() && mesh.ranges.back().expressID == expressID)
+                {
+                    mesh.ranges.back().indexCount += indexCount;
+                }
+                else
+                {
+                    mesh.ranges.push_back({expressID, indexOffset, indexCount});
+                }
+            }
+            TrimStreamingCaches();
+        }
+
+        return meshes;
+    }
+
+    bool IfcGeometryProcessor::PinGeometry(uint32_t expressID)
+    {
+        std::lock_guard<std::mutex> lock(_pinnedMutex);
+        auto pinnedIt = _pinnedGeometries.find(expressID);
+        if (pinnedIt != _pinnedGeometries.end())
+        {
+            pinnedIt->second.pins++;
+            return true;
+        }
+        auto &store = _expressIDToGeometry.Get();
+        auto geometryIt = store.find(expressID);
+        if (geometryIt == store.end())
+        {
+            return false;
+        }
+        _pinnedGeometries[expressID] = {geometryIt->second, 1};
+        return true;
+    }
+
+    void IfcGeometryProcessor::ReleaseGeometry(uint32_t expressID)
+    {
+        std::lock_guard<std::mutex> lock(_pinnedMutex);
+        auto pinnedIt = _pinnedGeometries.find(expressID);
+        if (pinnedIt != _pinnedGeometries.end() && --pinnedIt->second.pins == 0)
+        {
+            _pinnedGeometries.erase(pinnedIt);
+        }
+    }
+
+    IfcGeometry *IfcGeometryProcessor::GetPinnedGeometry(uint32_t expressID)
+    {
+        std::lock_guard<std::mutex> lock(_pinnedMutex);
+        auto pinnedIt = _pinnedGeometries.find(expressID);
+        return pinnedIt == _pinnedGeometries.end() ? nullptr : &pinnedIt->second.geometry;
+    }
+
+    void IfcGeometryProcessor::BuildSpatialIndex(const std::vector<uint32_t> &expressIDs)
+    {
+        _spatialIndex.Clear();
+        for (uint32_t expressID : expressIDs)
+        {
+            IfcFlatMesh flatMesh = GetFlatMesh(expressID);
+            for (auto &placedGeometry : flatMesh.geometries)
+            {
+                _spatialIndex.Add(expressID, placedGeometry.geometryExpressID, GetGeometry(placedGeometry.geometryExpressID), placedGeometry.transformation);
+            }
+            TrimStreamingCaches();
+        }
+        _spatialIndex.Build();
+    }
+
+    const IfcSpatialIndex &IfcGeometryProcessor::GetSpatialIndex() const
+    {
+        return _spatialIndex;
+    }
+
+    uint64_t GetMeshCacheKey(const IfcGeometrySettings &settings, uint64_t tapeHash, const glm::dmat4 &transformation)
+    {
+        utility::Fnv1a hash;
+        hash.Add(MESH_CACHE_VERSION);
+        hash.Add(tapeHash);
+        hash.Add(settings._coordinateToOrigin);
+        hash.Add(settings._optimize_profiles);
+        hash.Add(settings._exportPolylines);
+        hash.Add(settings._weldVertices);
+        hash.Add(settings._optimizeVertexCache);
+        hash.Add(settings._terrainChunkTriangles);
+        hash.Add(settings._circleSegments);
+        hash.Add(settings.TOLERANCE_PLANE_INTERSECTION);
+        hash.Add(settings.TOLERANCE_PLANE_DEVIATION);
+        hash.Add(settings.TOLERANCE_BACK_DEVIATION_DISTANCE);
+        hash.Add(settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER);
+        hash.Add(settings.TOLERANCE_SCALAR_EQUALITY);
+        hash.Add(settings.PLANE_REFIT_ITERATIONS);
+        hash.Add(settings._BOOLEAN_UNION_THRESHOLD);
+        hash.Add(settings.CIRCLE_CHORD_TOLERANCE);
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                hash.Add(transformation[i][j]);
+            }
+        }
+        return hash.Get();
+    }
+
+    uint64_t IfcGeometryProcessor::GetMeshCacheKey() const
+    {
+        return geometry::GetMeshCacheKey(_settings, _loader.GetTapeHash(), _transformation);
+    }
+
+    bool IfcGeometryProcessor::OpenMeshCache(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(_meshCache.mutex);
+        _meshCache.enabled = true;
+        _meshCache.changed = false;
+        _meshCache.path = path;
+        _meshCache.key = GetMeshCacheKey();
+        _meshCache.meshes.clear();
+        _meshCache.geometries.clear();
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        utility::BinaryReader reader{data.data(), data.size()};
+        if (reader.size < sizeof(MESH_CACHE_MAGIC) || std::memcmp(reader.data, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0)
+        {
+            spdlog::error("[OpenMeshCache()] {} is not a mesh cache", path);
+            return false;
+        }
+        reader.offset = sizeof(MESH_CACHE_MAGIC);
+        const uint32_t version = reader.Read<uint32_t>();
+        const uint64_t key = reader.Read<uint64_t>();
+        if (version != MESH_CACHE_VERSION || key != _meshCache.key)
+        {
+            spdlog::info("[OpenMeshCache()] {} was made for another model or other settings", path);
+            return false;
+        }
+        const bool isCoordinated = reader.Read<uint8_t>() != 0;
+        const auto coordinationMatrix = reader.Read<glm::dmat4>();
+
+        std::unordered_map<uint64_t, IfcFlatMesh> meshes;
+        const uint64_t meshCount = reader.Read<uint64_t>();
+        for (uint64_t i = 0; i < meshCount && reader.valid; i++)
+        {
+            const uint64_t entry = reader.Read<uint64_t>();
+            IfcFlatMesh flatMesh;
+            flatMesh.expressID = reader.Read<uint32_t>();
+            const uint64_t geometryCount = reader.Read<uint64_t>();
+            for (uint64_t j = 0; j < geometryCount && reader.valid; j++)
+            {
+                IfcPlacedGeometry geometry;
+                geometry.geometryExpressID = reader.Read<uint32_t>();
+                geometry.color = reader.Read<glm::dvec4>();
+                geometry.transformation = reader.Read<glm::dmat4>();
+                geometry.SetFlatTransformation();
+                flatMesh.geometries.push_back(std::move(geometry));
+            }
+            meshes[entry] = std::move(flatMesh);
+        }
+
+        std::unordered_map<uint32_t, IfcGeometry> geometries;
+        const uint64_t geometryCount = reader.Read<uint64_t>();
+        for (uint64_t i = 0; i < geometryCount && reader.valid; i++)
+        {
+            const uint32_t geometryExpressID = reader.Read<uint32_t>();
+            IfcGeometry geometry;
+            geometry.numPoints = reader.Read<uint32_t>();
+            geometry.numFaces = reader.Read<uint32_t>();
+            geometry.isPolygon = reader.Read<uint8_t>() != 0;
+            const bool normalized = reader.Read<uint8_t>() != 0;
+            const auto normalizationCenter = reader.Read<glm::dvec3>();
+            if (normalized)
+            {
+                geometry.MarkNormalized(normalizationCenter);
+            }
+            geometry.vertexData = reader.ReadValues<double>();
+            geometry.indexData = reader.ReadValues<uint32_t>();
+            geometries[geometryExpressID] = std::move(geometry);
+        }
+        if (!reader.valid)
+        {
+            spdlog::error("[OpenMeshCache()] truncated mesh cache {}", path);
+            return false;
+        }
+
+        _meshCache.meshes = std::move(meshes);
+        _meshCache.geometries = std::move(geometries);
+        // the cached transformations already hold the coordination of the run that made them
+        if (isCoordinated)
+        {
+            std::lock_guard<std::mutex> coordinationLock(_coordinationMutex);
+            _coordinationMatrix = coordinationMatrix;
+            _isCoordinated.store(true, std::memory_order_release);
+        }
+        return true;
+    }
+
+    bool IfcGeometryProcessor::SaveMeshCache() const
+    {
+        std::lock_guard<std::mutex> lock(_meshCache.mutex);
+        if (!_meshCache.enabled)
+        {
+            return false;
+        }
+        if (!_meshCache.changed)
+        {
+            return true;
+        }
+        // the key is that of the model as it was loaded, the meshes of an edited one would be handed to the next load
+        if (_loader.IsEdited())
+        {
+            spdlog::info("[SaveMeshCache()] the model was edited, {} is left as it was", _meshCache.path);
+            return false;
+        }
+        std::ofstream file(_meshCache.path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            spdlog::error("[SaveMeshCache()] unable to write {}", _meshCache.path);
+            return false;
+        }
+        const std::function<void(char *, size_t)> output = [&](char *src, size_t srcSize)
+        { file.write(src, srcSize); };
+
+        output((char *)MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+        utility::WriteValue<uint32_t>(output, MESH_CACHE_VERSION);
+        utility::WriteValue<uint64_t>(output, _meshCache.key);
+        utility::WriteValue<uint8_t>(output, _isCoordinated.load() ? 1 : 0);
+        utility::WriteValue(output, GetCoordinationMatrix());
+
+        utility::WriteValue<uint64_t>(output, _meshCache.meshes.size());
+        for (const auto &[entry, flatMesh] : _meshCache.meshes)
+        {
+            utility::WriteValue<uint64_t>(output, entry);
+            utility::WriteValue<uint32_t>(output, flatMesh.expressID);
+            utility::WriteValue<uint64_t>(output, flatMesh.geometries.size());
+            for (const auto &geometry : flatMesh.geometries)
+            {
+                utility::WriteValue<uint32_t>(output, geometry.geometryExpressID);
+                utility::WriteValue(output, geometry.color);
+                utility::WriteValue(output, geometry.transformation);
+            }
+        }
+
+        utility::WriteValue<uint64_t>(output, _meshCache.geometries.size());
+        for (const auto &[geometryExpressID, geometry] : _meshCache.geometries)
+        {
+            utility::WriteValue<uint32_t>(output, geometryExpressID);
+            utility::WriteValue<uint32_t>(output, geometry.numPoints);
+            utility::WriteValue<uint32_t>(output, geometry.numFaces);
+            utility::WriteValue<uint8_t>(output, geometry.isPolygon ? 1 : 0);
+            utility::WriteValue<uint8_t>(output, geometry.IsNormalized() ? 1 : 0);
+            utility::WriteValue(output, glm::dvec3(geometry.normalizationCenter));
+            utility::WriteValues(output, geometry.vertexData);
+            utility::WriteValues(output, geometry.indexData);
+        }
+        _meshCache.changed = false;
+        return file.good();
+    }
+
+    std::optional<IfcFlatMesh> IfcGeometryProcessor::GetCachedFlatMesh(uint32_t expressID, bool applyLinearScalingFactor)
+    {
+        std::lock_guard<std::mutex> lock(_meshCache.mutex);
+        if (!_meshCache.enabled)
+        {
+            return std::nullopt;
+        }
+        auto meshIt = _meshCache.meshes.find(meshCacheEntry(expressID, applyLinearScalingFactor));
+        if (meshIt == _meshCache.meshes.end())
+        {
+            return std::nullopt;
+        }
+        // the geometry goes to the calling thread's store, where GetGeometry finds it
+        for (auto &geometry : meshIt->second.geometries)
+        {
+            auto geometryIt = _meshCache.geometries.find(geometry.geometryExpressID);
+            if (geometryIt != _meshCache.geometries.end())
+            {
+                _expressIDToGeometry.Get()[geometry.geometryExpressID] = geometryIt->second;
+            }
+        }
+        return meshIt->second;
+    }
+
+    void IfcGeometryProcessor::CacheFlatMesh(const IfcFlatMesh &flatMesh, bool applyLinearScalingFactor)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_meshCache.mutex);
+            if (!_meshCache.enabled)
+            {
+                return;
+            }
+        }
+        // only what the flat mesh output needs is kept
+        std::vector<std::pair<uint32_t, IfcGeometry>> geometries;
+        for (auto &placed : flatMesh.geometries)
+        {
+            auto &geometry = _expressIDToGeometry.Get()[placed.geometryExpressID];
+            geometry.RestoreVertexData();
+            IfcGeometry cached;
+            cached.numPoints = geometry.numPoints;
+            cached.numFaces = geometry.numFaces;
+            cached.isPolygon = geometry.isPolygon;
+            cached.vertexData = geometry.vertexData;
+            cached.indexData = geometry.indexData;
+            if (geometry.IsNormalized())
+            {
+                cached.MarkNormalized(geometry.normalizationCenter);
+            }
+            geometries.emplace_back(placed.geometryExpressID, std::move(cached));
+        }
+        std::lock_guard<std::mutex> lock(_meshCache.mutex);
+        _meshCache.meshes[meshCacheEntry(flatMesh.expressID, applyLinearScalingFactor)] = flatMesh;
+        for (auto &[geometryExpressID, geometry] : geometries)
+        {
+            _meshCache.geometries.try_emplace(geometryExpressID, std::move(geometry));
+        }
+        _meshCache.changed = true;
+    }
+
+    void IfcGeometryProcessor::AddComposedMeshToFlatMesh(IfcFlatMesh &flatMesh, const IfcComposedMesh &composedMesh, const glm::dmat4 &parentMatrix, const glm::dvec4 &color, bool hasColor)
+    {
+
+        glm::dvec4 newParentColor = color;
+        bool newHasColor = hasColor;
+        glm::dmat4 newMatrix = parentMatrix * composedMesh.transformation;
+
+        if (composedMesh.hasColor && !hasColor)
+        {
+            newHasColor = true;
+            newParentColor = composedMesh.color;
+        }
+
+        if (composedMesh.hasGeometry)
+        {
+            // the geometry is shared by every placement of it, so it is worked on in place and normalized only once
+            auto &geom = _expressIDToGeometry.Get()[composedMesh.expressID];
+
+            if (_settings._coordinateToOrigin && !_isCoordinated.load(std::memory_order_acquire))
+            {
+                // without a placed site or building the first geometry meshed on any thread sets the origin
+                std::lock_guard<std::mutex> lock(_coordinationMutex);
+                if (!_isCoordinated.load(std::memory_order_relaxed) && geom.numPoints > 0)
+                {
+                    auto pt = geom.GetPoint(0);
+                    auto transformedPt = newMatrix * glm::dvec4(pt, 1);
+                    _coordinationMatrix = glm::translate(-glm::dvec3(transformedPt));
+                    _isCoordinated.store(true, std::memory_order_release);
+                }
+            }
+
+            if (geom.isPolygon)
+            {
+                if (!_settings._exportPolylines)
+                {
+                    return; // only triangles
+                }
+            }
+
+            if (_settings._weldVertices)
+            {
+                geom.WeldVertices(_settings._optimizeVertexCache);
+            }
+
+            const glm::dmat4 translation = geom.Normalize();
+
+            IfcPlacedGeometry geometry;
+            if (!composedMesh.hasColor)
+            {
+                geometry.color = newParentColor;
+            }
+            else
+            {
+                geometry.color = composedMesh.color;
+                newParentColor = composedMesh.color;
+                newHasColor = composedMesh.hasColor;
+            }
+
+            geometry.transformation = GetCoordinationMatrix() * newMatrix * translation;
+
+            geometry.SetFlatTransformation();
+            geometry.geometryExpressID = composedMesh.expressID;
+
+            flatMesh.geometries.push_back(std::move(geometry));
+        }
+        else if (composedMesh.hasColor)
+        {
+            newParentColor = composedMesh.color;
+            newHasColor = composedMesh.hasColor;
+        }
+
+        for (auto &c : composedMesh.children)
+        {
+            AddComposedMeshToFlatMesh(flatMesh, c, newMatrix, newParentColor, newHasColor);
+        }
+    }
+
+    IfcGeometry IfcGeometryProcessor::BoolProcess(const std::vector<IfcGeometry> &firstGeoms, const std::vector<IfcGeometry> &secondGeoms, BooleanOperation op, const IfcGeometrySettings &_settings)
+    {
+        if (_booleanObserver) _booleanObserver(firstGeoms, secondGeoms, op);
+        const ElementBudget &element = CurrentElementBudget();
+        bool overBudget = element.deadline != 0 && utility::NowNanoseconds() >= element.deadline;
+        if (!overBudget && _booleanFaceBudget > 0)
+        {
+            uint64_t faces = 0;
+            for (const auto &geom : firstGeoms) faces += geom.numFaces;
+            for (const auto &geom : secondGeoms) faces += geom.numFaces;
+            overBudget = faces > _booleanFaceBudget;
+        }
+        IfcGeometry result;
+        if (!overBudget)
+        {
+            uint64_t deadline = Deadline(_booleanTimeBudget);
+            if (element.deadline != 0 && (deadline == 0 || element.deadline < deadline)) deadline = element.deadline;
+            fuzzybools::SetBooleanDeadline(deadline);
+            {
+                utility::ScopedTimer timer(_booleanTime);
+                _booleanCalls.fetch_add(1, std::memory_order_relaxed);
+                result = _boolEngine.BoolProcess(firstGeoms, secondGeoms, op, _settings);
+            }
+            overBudget = fuzzybools::_BOOLEAN_ABORTED;
+            fuzzybools::SetBooleanDeadline(0);
+        }
+        if (overBudget)
+        {
+            spdlog::warn("[BoolProcess()] {} over budget in element {}, kept the operands", GetBooleanOperationName(op), element.expressID);
+            if (element.expressID != 0) FlagOverBudget(element.expressID);
+            return BooleanFallback(firstGeoms, secondGeoms, op);
+        }
+        return result;
+    }
+
+    void IfcGeometryProcessor::ReadTriangulatedFaceSet(uint32_t expressID, std::vector<glm::dvec3> &points, std::vector<uint32_t> &indices)
+    {
+        _loader.MoveToArgumentOffset(expressID, 0);
+
+        auto coordinatesRef = _loader.GetRefArgument();
+        points = _geometryLoader.ReadIfcCartesianPointList3D(coordinatesRef);
+
+        // second argument normals, ignored
+        // third argument closed, ignored
+        // fifth argument PnIndex, unsupported and ignored
+
+        _loader.MoveToArgumentOffset(expressID, 3);
+        indices = Read2DArrayOfThreeIndices();
+
+        // the indices count from 1, triangles with a corner that is not a point are dropped
+        size_t kept = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            bool valid = true;
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                valid = valid && indices[i + corner] >= 1 && indices[i + corner] <= points.size();
+            }
+            if (!valid)
+            {
+                spdlog::error("[ReadTriangulatedFaceSet({})] triangle {} refers to a missing point", expressID, i / 3);
+                continue;
+            }
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                indices[kept++] = indices[i + corner] - 1;
+            }
+        }
+        indices.resize(kept);
+    }
+
+    bool IfcGeometryProcessor::IsChunkedTerrain(uint32_t lineType, size_t triangles) const
+    {
+        return _settings._terrainChunkTriangles > 0 && triangles > _settings._terrainChunkTriangles &&
+               (lineType == schema::IFCTRIANGULATEDIRREGULARNETWORK || lineType == schema::IFCTRIANGULATEDFACESET);
+    }
+
+    size_t IfcGeometryProcessor::StreamTerrain(uint32_t expressID, double maxError, const std::function<void(const IfcTerrainChunk &)> &onChunk, bool applyLinearScalingFactor)
+    {
+        spdlog::debug("[StreamTerrain({})]", expressID);
+        IfcComposedMesh composedMesh;
+        {
+            utility::ArenaScope arenaScope;
+            composedMesh = GetMesh(expressID);
+        }
+
+        glm::dmat4 mat = glm::dmat4(1);
+        if (applyLinearScalingFactor)
+        {
+            mat = glm::scale(glm::dvec3(_geometryLoader.GetLinearScalingFactor()));
+        }
+        CoordinateFromPlacements(applyLinearScalingFactor);
+
+        size_t chunks = 0;
+        AddTerrainChunks(composedMesh, _transformation * NormalizeIFC * mat, glm::dvec4(1, 1, 1, 1), false, maxError, onChunk, chunks);
+        return chunks;
+    }
+
+    void IfcGeometryProcessor::AddTerrainChunks(const IfcComposedMesh &composedMesh, const glm::dmat4 &parentMatrix, const glm::dvec4 &color, bool hasColor, double maxError, const std::function<void(const IfcTerrainChunk &)> &onChunk, size_t &chunks)
+    {
+        // the colours are handed down as AddComposedMeshToFlatMesh does
+        const glm::dmat4 newMatrix = parentMatrix * composedMesh.transformation;
+        const glm::dvec4 newColor = composedMesh.hasColor ? composedMesh.color : color;
+        const bool newHasColor = composedMesh.hasColor || hasColor;
+
+        const uint32_t lineType = !composedMesh.hasGeometry && _loader.IsValidExpressID(composedMesh.expressID) ? _loader.GetLineType(composedMesh.expressID) : 0;
+        if (lineType == schema::IFCTRIANGULATEDIRREGULARNETWORK || lineType == schema::IFCTRIANGULATEDFACESET)
+        {
+            std::vector<glm::dvec3> points;
+            std::vector<uint32_t> indices;
+            ReadTriangulatedFaceSet(composedMesh.expressID, points, indices);
+            if (IsChunkedTerrain(lineType, indices.size() / 3))
+            {
+                if (_settings._coordinateToOrigin && !_isCoordinated.load(std::memory_order_acquire) && !points.empty())
+                {
+                    std::lock_guard<std::mutex> lock(_coordinationMutex);
+                    if (!_isCoordinated.load(std::memory_order_relaxed))
+                    {
+                        _coordinationMatrix = glm::translate(-glm::dvec3(newMatrix * glm::dvec4(points[0], 1)));
+                        _isCoordinated.store(true, std::memory_order_release);
+                    }
+                }
+                const glm::dmat4 transformation = GetCoordinationMatrix() * newMatrix;
+
+                // the points of a cell are replaced by their mean, which is no further than the cell diagonal from any of
+                // them, and the placement stretches that by at most its largest scale. The cells are laid over the whole
+                // terrain, so a point on the border of two chunks moves the same in both
+                std::vector<uint32_t> clusterOfPoint(points.size());
+                std::iota(clusterOfPoint.begin(), clusterOfPoint.end(), 0);
+                const double scale = GetMaxScale(glm::dmat3(transformation));
+                const double cellSize = scale > 0 ? maxError / scale / std::sqrt(3.0) : 0;
+                if (cellSize > 0 && std::isfinite(cellSize) && !points.empty())
+                {
+                    glm::dvec3 min(DBL_MAX, DBL_MAX, DBL_MAX);
+                    for (const auto &point : points)
+                    {
+                        min = glm::min(min, point);
+                    }
+                    std::vector<std::pair<std::array<int64_t, 3>, uint32_t>> cells(points.size());
+                    for (size_t i = 0; i < points.size(); i++)
+                    {
+                        const glm::dvec3 scaled = (points[i] - min) / cellSize;
+                        for (int axis = 0; axis < 3; axis++)
+                        {
+                            cells[i].first[axis] = std::isfinite(scaled[axis]) ? static_cast<int64_t>(std::floor(std::clamp(scaled[axis], 0.0, 1.0e18))) : 0;
+                        }
+                        cells[i].second = static_cast<uint32_t>(i);
+                    }
+                    std::sort(cells.begin(), cells.end());
+
+                    std::vector<glm::dvec3> clusterPoints;
+                    std::vector<uint32_t> clusterSizes;
+                    for (size_t i = 0; i < cells.size(); i++)
+                    {
+                        if (i == 0 || cells[i].first != cells[i - 1].first)
+                        {
+                            clusterPoints.push_back(glm::dvec3(0));
+                            clusterSizes.push_back(0);
+                        }
+                        clusterPoints.back() += points[cells[i].second];
+                        clusterSizes.back()++;
+                        clusterOfPoint[cells[i].second] = static_cast<uint32_t>(clusterPoints.size() - 1);
+                    }
+                    for (size_t i = 0; i < clusterPoints.size(); i++)
+                    {
+                        clusterPoints[i] /= static_cast<double>(clusterSizes[i]);
+                    }
+                    points = std::move(clusterPoints);
+                }
+
+                // the triangles that keep three corners, by the square of the grid their centre falls in
+                std::vector<uint32_t> triangles;
+                glm::dvec2 min(DBL_MAX, DBL_MAX);
+                glm::dvec2 max(-DBL_MAX, -DBL_MAX);
+                for (size_t i = 0; i < indices.size(); i += 3)
+                {
+                    const uint32_t a = indices[i + 0] = clusterOfPoint[indices[i + 0]];
+                    const uint32_t b = indices[i + 1] = clusterOfPoint[indices[i + 1]];
+                    const uint32_t c = indices[i + 2] = clusterOfPoint[indices[i + 2]];
+                    if (a == b || b == c || c == a)
+                    {
+                        continue;
+                    }
+                    const glm::dvec2 center = glm::dvec2(points[a] + points[b] + points[c]) / 3.0;
+                    min = glm::min(min, center);
+                    max = glm::max(max, center);
+                    triangles.push_back(static_cast<uint32_t>(i / 3));
+                }
+                clusterOfPoint = std::vector<uint32_t>();
+
+                const uint32_t side = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangles.size()) / _settings._terrainChunkTriangles))));
+                const glm::dvec2 squareSize = (max - min) / static_cast<double>(side);
+                auto squareOf = [&](uint32_t triangle)
+                {
+                    const glm::dvec2 center = glm::dvec2(points[indices[triangle * 3 + 0]] + points[indices[triangle * 3 + 1]] + points[indices[triangle * 3 + 2]]) / 3.0;
+                    uint32_t square[2] = {0, 0};
+                    for (int axis = 0; axis < 2; axis++)
+                    {
+                        if (squareSize[axis] > 0)
+                        {
+                            square[axis] = static_cast<uint32_t>(std::clamp(std::floor((center[axis] - min[axis]) / squareSize[axis]), 0.0, static_cast<double>(side - 1)));
+                        }
+                    }
+                    return square[1] * side + square[0];
+                };
+                std::vector<uint32_t> offsets(static_cast<size_t>(side) * side + 1, 0);
+                for (uint32_t triangle : triangles)
+                {
+                    offsets[squareOf(triangle) + 1]++;
+                }
+                uint32_t count = 0;
+                for (size_t i = 1; i < offsets.size(); i++)
+                {
+                    count += offsets[i] > 0 ? 1 : 0;
+                    offsets[i] += offsets[i - 1];
+                }
+                std::vector<uint32_t> order(triangles.size());
+                std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+                for (uint32_t triangle : triangles)
+                {
+                    order[next[squareOf(triangle)]++] = triangle;
+                }
+                triangles = std::vector<uint32_t>();
+                next = std::vector<uint32_t>();
+
+                const bool reverse = glm::determinant(glm::dmat3(transformation)) < 0;
+                uint32_t index = 0;
+                for (size_t square = 0; square + 1 < offsets.size(); square++)
+                {
+                    if (offsets[square] == offsets[square + 1])
+                    {
+                        continue;
+                    }
+                    IfcGeometry geometry;
+                    for (uint32_t i = offsets[square]; i < offsets[square + 1]; i++)
+                    {
+                        const uint32_t triangle = order[i];
+                        geometry.AddFace(points[indices[triangle * 3 + 0]], points[indices[triangle * 3 + 1]], points[indices[triangle * 3 + 2]]);
+                    }
+
+                    IfcTerrainChunk chunk;
+                    chunk.expressID = composedMesh.expressID;
+                    chunk.index = index++;
+                    chunk.count = count;
+                    chunk.color = newColor;
+                    chunk.vertexData.resize(static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS);
+                    BakeVertices(geometry.vertexData.data(), geometry.numPoints, transformation, chunk.vertexData.data());
+                    chunk.indexData.resize(static_cast<size_t>(geometry.numFaces) * 3);
+                    for (uint32_t i = 0; i < geometry.numFaces; i++)
+                    {
+                        chunk.indexData[i * 3 + 0] = geometry.indexData[i * 3 + 0];
+                        chunk.indexData[i * 3 + 1] = geometry.indexData[i * 3 + (reverse ? 2 : 1)];
+                        chunk.indexData[i * 3 + 2] = geometry.indexData[i * 3 + (reverse ? 1 : 2)];
+                    }
+                    onChunk(chunk);
+                    chunks++;
+                }
+            }
+        }
+
+        for (const auto &child : composedMesh.children)
+        {
+            AddTerrainChunks(child, newMatrix, newColor, newHasColor, maxError, onChunk, chunks);
+        }
+    }
+
+    std::vector<uint32_t> IfcGeometryProcessor::Read2DArrayOfThreeIndices()
+    {
+        std::vector<uint32_t> result;
+        if (_loader.GetNumberSetListArgument(result, 3, utility::GetThreadCount()))
+        {
+            return result;
+        }
+
+        _loader.GetTokenType();
+
+        // while we have point set begin
+        while (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
+        {
+            result.push_back((uint32_t)_loader.GetIntArgument());
+            result.push_back((uint32_t)_loader.GetIntArgument());
+            result.push_back((uint32_t)_loader.GetIntArgument());
+
+            // read point set end
+            _loader.GetTokenType();
+        }
+
+        return result;
+    }
+
+    void IfcGeometryProcessor::ReadIndexedPolygonalFace(uint32_t expressID, std::vector<IfcBound3D> &bounds, const std::vector<glm::dvec3> &points)
+    {
+
+        spdlog::debug("[ReadIndexedPolygonalFace({})]", expressID);
+        auto lineType = _loader.GetLineType(expressID);
+
+        bounds.emplace_back();
+
+        switch (lineType)
+        {
+        case schema::IFCINDEXEDPOLYGONALFACEWITHVOIDS:
+        case schema::IFCINDEXEDPOLYGONALFACE:
+        {
+            _loader.MoveToArgumentOffset(expressID, 0);
+            utility::ScratchVector<uint32_t> indexIDs;
+            _loader.GetSetArgument(*indexIDs);
+
+            IfcGeometry geometry;
+            for (auto &indexID : *indexIDs)
+            {
+                uint32_t index = _loader.GetIntArgument(indexID);
+                glm::dvec3 point = points[index - 1]; // indices are 1-based
+
+                // I am not proud of this
+                bounds.back().curve.points.push_back(point);
+            }
+
+            if (lineType == schema::IFCINDEXEDPOLYGONALFACE)
+            {
+                break;
+            }
+
+            // case IFCINDEXEDPOLYGONALFACEWITHVOIDS
+            _loader.MoveToArgumentOffset(expressID, 1);
+
+            // guaranteed to be set begin
+            _loader.GetTokenType();
+
+            // while we have hole-index set begin
+            while (_loader.GetTokenType() == parsing::IfcTokenType::SET_BEGIN)
+            {
+                bounds.emplace_back();
+
+                while (_loader.GetTokenType() != parsing::IfcTokenType::SET_END)
+                {
+                    _loader.StepBack();
+                    uint32_t index = _loader.GetIntArgument();
+
+                    glm::dvec3 point = points[index - 1]; // indices are still 1-based
+
+                    // I am also not proud of this
+                    bounds.back().curve.points.push_back(point);
+                }
+            }
+
+            break;
+        }
+        default:
+            spdlog::error("[ReadIndexedPolygonalFace()] unexpected indexedface type {}", expressID, lineType);
+            break;
+        }
+    }
+
+    IfcGeometry IfcGeometryProcessor::GetBrep(uint32_t expressID)
+    {
+        spdlog::debug("[GetBrep({})]", expressID);
+        auto lineType = _loader.GetLineType(expressID);
+        switch (lineType)
+        {
+        case schema::IFCCONNECTEDFACESET:
+        case schema::IFCCLOSEDSHELL:
+        case schema::IFCOPENSHELL:
+        {
+            _loader.MoveToArgumentOffset(expressID, 0);
+            utility::ScratchVector<uint32_t> faces;
+            _loader.GetRefSetArgument(*faces);
+
+            IfcGeometry geometry;
+            const size_t threads = utility::GetThreadCount();
+            if (threads < 2 || faces->size() < MIN_PARALLEL_BREP_FACES || utility::InParallelWork())
+            {
+                for (uint32_t faceID : *faces)
+                {
+                    AddFaceToGeometry(faceID, geometry);
+                }
+
+                return geometry;
+            }
+
+            // the faces are read here, on the thread that holds the tape, then triangulated on the threads into meshes of
+            // their own that are appended in the order of the faces, the same mesh one after the other would give
+            std::vector<IfcFaceInput> inputs(faces->size());
+            std::vector<uint8_t> valid(faces->size());
+            for (size_t i = 0; i < faces->size(); i++)
+            {
+                valid[i] = ReadFace((*faces)[i], inputs[i]);
+            }
+            std::vector<IfcGeometry> faceGeometries(faces->size());
+            utility::ParallelFor(faces->size(), threads, [&](size_t i)
+                                 {
+                if (!valid[i]) return;
+                // the tolerances are per thread
+                SetEpsilons(_settings.TOLERANCE_SCALAR_EQUALITY, _settings.PLANE_REFIT_ITERATIONS, _settings._BOOLEAN_UNION_THRESHOLD);
+                geometry::SetCircleChordTolerance(_settings.CIRCLE_CHORD_TOLERANCE);
+                TriangulateFace(inputs[i], faceGeometries[i]); });
+            for (auto &faceGeometry : faceGeometries)
+            {
+                AppendGeometry(geometry, faceGeometry);
+            }
+
+            return geometry;
+        }
+        default:
+            spdlog::error("[GetBrep()] unexpected shell type {}", expressID, lineType);
+            break;
+        }
+
+        return IfcGeometry();
+    }
+
+    void IfcGeometryProcessor::AddFaceToGeometry(uint32_t expressID, IfcGeometry &geometry)
+    {
+        spdlog::debug("[AddFaceToGeometry({})]", expressID);
+        IfcFaceInput face;
+        if (ReadFace(expressID, face))
+        {
+            TriangulateFace(face, geometry);
+        }
+    }
+
+    bool IfcGeometryProcessor::ReadFace(uint32_t expressID, IfcFaceInput &face)
+    {
+        auto lineType = _loader.GetLineType(expressID);
+        if (lineType != schema::IFCFACE && lineType != schema::IFCADVANCEDFACE)
+        {
+            spdlog::error("[AddFaceToGeometry()] unexpected face type {}", expressID, lineType);
+            return false;
+        }
+
+        face.expressID = expressID;
+        _loader.MoveToArgumentOffset(expressID, 0);
+        utility::ScratchVector<uint32_t> bounds;
+        _loader.GetRefSetArgument(*bounds);
+
+        face.bounds.resize(bounds->size());
+        for (size_t i = 0; i < bounds->size(); i++)
+        {
+            face.bounds[i] = _geometryLoader.GetBound((*bounds)[i]);
+        }
+
+        if (lineType == schema::IFCADVANCEDFACE)
+        {
+            _loader.MoveToArgumentOffset(expressID, 1);
+            auto surfRef = _loader.GetRefArgument();
+
+            face.surface = GetSurface(surfRef);
+        }
+        return true;
+    }
+
+    void IfcGeometryProcessor::TriangulateFace(IfcFaceInput &face, IfcGeometry &geometry)
+    {
+        if (!face.surface)
+        {
+            TriangulateBounds(geometry, face.bounds, face.expressID);
+            return;
+        }
+        auto &surface = *face.surface;
+
+        // TODO: place the face in the surface and tringulate
+
+        if (surface.BSplineSurface.Active)
+        {
+            TriangulateBspline(geometry, face.bounds, surface, _geometryLoader.GetLinearScalingFactor());
+        }
+        else if (surface.CylinderSurface.Active)
+        {
+            TriangulateCylindricalSurface(geometry, face.bounds, surface, _settings._circleSegments);
+        }
+        else if (surface.RevolutionSurface.Active)
+        {
+            TriangulateRevolution(geometry, face.bounds, surface, _settings._circleSegments);
+        }
+        else if (surface.ExtrusionSurface.Active)
+        {
+            TriangulateExtrusion(geometry, face.bounds, surface);
+        }
+        else
+        {
+            TriangulateBounds(geometry, face.bounds, face.expressID);
+        }
+    }
+
+    const char *GetBooleanOperationName(BooleanOperation op)
+    {
+        return op == BooleanOperation::UNION ? "UNION" : "DIFFERENCE";
+    }
+
+    bool ParseBooleanOperation(std::string_view name, BooleanOperation &op)
+    {
+        if (name == "UNION") op = BooleanOperation::UNION;
+        else if (name == "DIFFERENCE") op = BooleanOperation::DIFFERENCE;
+        else return false;
+        return true;
+    }
+
+    fuzzybools::Geometry booleanManager::convertToEngine(Geometry &&geom)
+    {
+        // the buffers are handed over, only the planes differ between the two representations
+        fuzzybools::Geometry newGeom;
+        newGeom.fvertexData = std::move(geom.fvertexData);
+        newGeom.vertexData = std::move(geom.vertexData);
+        newGeom.indexData = std::move(geom.indexData);
+        newGeom.planeData = std::move(geom.planeData);
         newGeom.numPoints = geom.numPoints;
         newGeom.numFaces = geom.numFaces;
+        newGeom.planes.reserve(geom.planes.size());
         for (auto plane : geom.planes)
         {
             fuzzybools::SimplePlane newPlane;
@@ -1944,16 +3613,17 @@ namespace webifc::geometry
         return newGeom;
     }
 
-    IfcGeometry booleanManager::convertToWebIfc(fuzzybools::Geometry geom)
+    IfcGeometry booleanManager::convertToWebIfc(fuzzybools::Geometry &&geom)
     {
         IfcGeometry newGeom;
-        newGeom.fvertexData = geom.fvertexData;
-        newGeom.vertexData = geom.vertexData;
-        newGeom.indexData = geom.indexData;
-        newGeom.planeData = geom.planeData;
+        newGeom.fvertexData = std::move(geom.fvertexData);
+        newGeom.vertexData = std::move(geom.vertexData);
+        newGeom.indexData = std::move(geom.indexData);
+        newGeom.planeData = std::move(geom.planeData);
         newGeom.numPoints = geom.numPoints;
         newGeom.numFaces = geom.numFaces;
         uint32_t id = 0;
+        newGeom.planes.reserve(geom.planes.size());
         for (auto plane : geom.planes)
         {
             webifc::geometry::Plane newPlane;
@@ -1967,14 +3637,93 @@ namespace webifc::geometry
         return newGeom;
     }
 
-    IfcGeometry booleanManager::BoolProcess(const std::vector<IfcGeometry> &firstGeoms, std::vector<IfcGeometry> &secondGeoms, std::string op, IfcGeometrySettings _settings)
+    IfcGeometry IfcGeometryProcessor::FuseGeometries(std::vector<IfcGeometry> geoms)
+    {
+        if (geoms.empty())
+        {
+            return IfcGeometry();
+        }
+
+        // neighbours are fused, so order the geometries along the longest axis to keep neighbours close in space
+        bimGeometry::AABB totalBox;
+        std::vector<bimGeometry::AABB> geomBoxes(geoms.size());
+        for (size_t i = 0; i < geoms.size(); i++)
+        {
+            geomBoxes[i] = geoms[i].GetAABB();
+            totalBox.merge(geomBoxes[i]);
+        }
+        const glm::dvec3 extents = totalBox.max - totalBox.min;
+        const int axis = extents.x >= extents.y && extents.x >= extents.z ? 0 : (extents.y >= extents.z ? 1 : 2);
+        std::vector<size_t> order(geoms.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  { return geomBoxes[a].min[axis] + geomBoxes[a].max[axis] < geomBoxes[b].min[axis] + geomBoxes[b].max[axis]; });
+
+        std::vector<IfcGeometry> level;
+        std::vector<bimGeometry::AABB> levelBoxes;
+        level.reserve(geoms.size());
+        levelBoxes.reserve(geoms.size());
+        for (size_t index : order)
+        {
+            level.push_back(std::move(geoms[index]));
+            levelBoxes.push_back(geomBoxes[index]);
+        }
+
+        const size_t threads = utility::GetThreadCount();
+        const ElementBudget element = CurrentElementBudget();
+        while (level.size() > 1)
+        {
+            const size_t pairs = level.size() / 2;
+            std::vector<IfcGeometry> nextLevel(pairs + level.size() % 2);
+            std::vector<bimGeometry::AABB> nextBoxes(nextLevel.size());
+            utility::ParallelFor(pairs, threads, [&](size_t i)
+                                 {
+                utility::ArenaScope arenaScope;
+                ElementBudgetScope budgetScope(element);
+                IfcGeometry &first = level[i * 2];
+                IfcGeometry &second = level[i * 2 + 1];
+                nextBoxes[i] = levelBoxes[i * 2];
+                nextBoxes[i].merge(levelBoxes[i * 2 + 1]);
+                if (!levelBoxes[i * 2].intersects(levelBoxes[i * 2 + 1]))
+                {
+                    // apart, the union is both meshes side by side
+                    nextLevel[i].MergeGeometry(first);
+                    nextLevel[i].MergeGeometry(second);
+                }
+                else
+                {
+                    // the tolerances are per thread
+                    SetEpsilons(_settings.TOLERANCE_SCALAR_EQUALITY, _settings.PLANE_REFIT_ITERATIONS, _settings._BOOLEAN_UNION_THRESHOLD);
+                    std::vector<IfcGeometry> secondGeoms = {std::move(second)};
+                    nextLevel[i] = BoolProcess(std::vector<IfcGeometry>{std::move(first)}, secondGeoms, BooleanOperation::UNION, _settings);
+                }
+                first = IfcGeometry();
+                second = IfcGeometry(); });
+            if (level.size() % 2 == 1)
+            {
+                nextLevel.back() = std::move(level.back());
+                nextBoxes.back() = levelBoxes.back();
+            }
+            level.swap(nextLevel);
+            levelBoxes.swap(nextBoxes);
+        }
+
+        return std::move(level[0]);
+    }
+
+    IfcGeometry booleanManager::BoolProcess(const std::vector<IfcGeometry> &firstGeoms, const std::vector<IfcGeometry> &secondGeoms, BooleanOperation op, const IfcGeometrySettings &_settings)
     {
         spdlog::debug("[BoolProcess({})]");
+        WEBIFC_TRACE_SCOPE("BoolProcess");
         IfcGeometry finalResult;
 
         for (auto &firstGeom : firstGeoms)
         {
             IfcGeometry firstOperator = firstGeom;
+            // differences are collected and subtracted together once every operator is prepared, the cutters are the
+            // operands themselves except for the half spaces, which are built here
+            std::vector<const IfcGeometry *> cutters;
+            std::deque<IfcGeometry> halfSpaceCutters;
             for (auto &secondGeom : secondGeoms)
             {
                 bool doit = true;
@@ -1987,7 +3736,7 @@ namespace webifc::geometry
                     doit = false;
                 }
 
-                if (firstOperator.numFaces == 0 && op != "UNION")
+                if (firstOperator.numFaces == 0 && op != BooleanOperation::UNION)
                 {
                     spdlog::error("[BoolProcess()] bool aborted due to empty source or target");
 
@@ -1998,6 +3747,12 @@ namespace webifc::geometry
 
                 if (doit)
                 {
+                    if (op == BooleanOperation::DIFFERENCE && !secondGeom.halfSpace)
+                    {
+                        cutters.push_back(&secondGeom);
+                        continue;
+                    }
+
                     IfcGeometry secondOperator;
 
                     if (secondGeom.halfSpace)
@@ -2051,18 +3806,21 @@ namespace webifc::geometry
                     io::DumpIfcGeometry(firstOperator, "first.obj");
 #endif
 
+                    if (op == BooleanOperation::DIFFERENCE)
+                    {
+                        halfSpaceCutters.push_back(std::move(secondOperator));
+                        cutters.push_back(&halfSpaceCutters.back());
+                        continue;
+                    }
+
                     firstOperator.buildPlanes();
                     secondOperator.buildPlanes();
 
                     fuzzybools::SetEpsilons(_settings.TOLERANCE_PLANE_INTERSECTION, _settings.TOLERANCE_PLANE_DEVIATION, _settings.TOLERANCE_BACK_DEVIATION_DISTANCE, _settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER);
 
-                    if (op == "DIFFERENCE")
-                    {
-                        firstOperator = Subtract(firstOperator, secondOperator);
-                    }
-                    else if (op == "UNION")
+                    if (op == BooleanOperation::UNION)
                     {
-                        firstOperator = Union(firstOperator, secondOperator);
+                        firstOperator = Union(std::move(firstOperator), std::move(secondOperator));
                     }
 
 #ifdef CSG_DEBUG_OUTPUT
@@ -2070,29 +3828,218 @@ namespace webifc::geometry
 #endif
                 }
             }
-            finalResult.AddGeometry(firstOperator);
+            if (!cutters.empty())
+            {
+                fuzzybools::SetEpsilons(_settings.TOLERANCE_PLANE_INTERSECTION, _settings.TOLERANCE_PLANE_DEVIATION, _settings.TOLERANCE_BACK_DEVIATION_DISTANCE, _settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER);
+                firstOperator = SubtractAll(std::move(firstOperator), cutters);
+
+#ifdef CSG_DEBUG_OUTPUT
+                io::DumpIfcGeometry(firstOperator, "result.obj");
+#endif
+            }
+            finalResult.AddGeometry(std::move(firstOperator));
         }
 
         return finalResult;
     }
 
-    IfcGeometry booleanManager::Union(IfcGeometry firstOperator, IfcGeometry secondOperator)
+    IfcGeometry booleanManager::Union(IfcGeometry &&firstOperator, IfcGeometry &&secondOperator)
     {
-        fuzzybools::Geometry firstEngGeom = convertToEngine(firstOperator);
-        fuzzybools::Geometry secondEngGeom = convertToEngine(secondOperator);
+        fuzzybools::Geometry firstEngGeom = convertToEngine(std::move(firstOperator));
+        fuzzybools::Geometry secondEngGeom = convertToEngine(std::move(secondOperator));
         return convertToWebIfc(fuzzybools::Union(firstEngGeom, secondEngGeom));
     }
 
-    IfcGeometry booleanManager::Subtract(IfcGeometry firstOperator, IfcGeometry secondOperator)
+    IfcGeometry booleanManager::Subtract(IfcGeometry &&firstOperator, IfcGeometry &&secondOperator)
     {
-        fuzzybools::Geometry firstEngGeom = convertToEngine(firstOperator);
-        fuzzybools::Geometry secondEngGeom = convertToEngine(secondOperator);
+        fuzzybools::Geometry firstEngGeom = convertToEngine(std::move(firstOperator));
+        fuzzybools::Geometry secondEngGeom = convertToEngine(std::move(secondOperator));
         return convertToWebIfc(fuzzybools::Subtract(firstEngGeom, secondEngGeom));
     }
 
+    IfcGeometry booleanManager::SubtractAll(IfcGeometry firstOperator, const std::vector<const IfcGeometry *> &cutters)
+    {
+        // cutters that miss the host by box or, for small convex ones, by a separating face plane are skipped. The others go
+        // into the first batch none of whose cutters their box touches, a batch is then a set of separate closed meshes
+        // that can be subtracted as one
+        const bimGeometry::AABB hostBox = firstOperator.GetAABB();
+        std::vector<std::vector<size_t>> batches;
+        std::vector<std::vector<bimGeometry::AABB>> batchBoxes;
+        for (size_t i = 0; i < cutters.size(); i++)
+        {
+            const bimGeometry::AABB box = cutters[i]->GetAABB();
+            if (!hostBox.intersects(box))
+            {
+                // cannot remove anything
+                continue;
+            }
+            std::vector<glm::dvec4> planes;
+            if (GetConvexPlanes(*cutters[i], planes, _TOLERANCE_PLANE_INTERSECTION))
+            {
+                const CutterOverlap overlap = ClassifyAgainstConvex(firstOperator, planes, _TOLERANCE_PLANE_INTERSECTION);
+                if (overlap == CutterOverlap::APART)
+                {
+                    continue;
+                }
+                if (overlap == CutterOverlap::CONTAINS)
+                {
+                    // nothing is left whatever the other cutters do
+                    return IfcGeometry();
+                }
+            }
+            size_t batch = 0;
+            for (; batch < batches.size(); batch++)
+            {
+                bool disjoint = true;
+                for (const auto &other : batchBoxes[batch])
+                {
+                    if (other.intersects(box))
+                    {
+                        disjoint = false;
+                        break;
+                    }
+                }
+                if (disjoint)
+                {
+                    break;
+                }
+            }
+            if (batch == batches.size())
+            {
+                batches.emplace_back();
+                batchBoxes.emplace_back();
+            }
+            batches[batch].push_back(i);
+            batchBoxes[batch].push_back(box);
+        }
+
+        for (const auto &batch : batches)
+        {
+            if (firstOperator.numFaces == 0)
+            {
+                spdlog::error("[BoolProcess()] bool aborted due to empty source or target");
+                break;
+            }
+
+            IfcGeometry cutter;
+            if (batch.size() == 1)
+            {
+                cutter = *cutters[batch[0]];
+            }
+            else
+            {
+                for (size_t index : batch)
+                {
+                    cutter.MergeGeometry(*cutters[index]);
+                }
+            }
+
+            firstOperator.buildPlanes();
+            cutter.buildPlanes();
+            firstOperator = Subtract(std::move(firstOperator), std::move(cutter));
+        }
+
+        return firstOperator;
+    }
+
+    IfcGeometryProcessor::MeshingTimes IfcGeometryProcessor::GetMeshingTimes() const
+    {
+        MeshingTimes times;
+        times.booleans = _booleanTime.load() / 1e9;
+        times.flatten = _flattenTime.load() / 1e9;
+        times.booleanCalls = _booleanCalls.load();
+        return times;
+    }
+
+    void IfcGeometryProcessor::ResetMeshingTimes()
+    {
+        _booleanTime = 0;
+        _flattenTime = 0;
+        _booleanCalls = 0;
+    }
+
+    bool IfcGeometryProcessor::SetProfilingEnabled(bool enabled)
+    {
+#ifdef WEBIFC_GEOMETRY_PROFILING
+        _profiler.SetEnabled(enabled);
+        return true;
+#else
+        (void)enabled;
+        return false;
+#endif
+    }
+
+    IfcGeometryProfile IfcGeometryProcessor::GetProfile() const
+    {
+#ifdef WEBIFC_GEOMETRY_PROFILING
+        return _profiler.GetProfile();
+#else
+        return {};
+#endif
+    }
+
+    void IfcGeometryProcessor::SetBooleanBudget(double booleanSeconds, double elementSeconds, uint32_t booleanFaces)
+    {
+        _booleanTimeBudget = booleanSeconds;
+        _elementTimeBudget = elementSeconds;
+        _booleanFaceBudget = booleanFaces;
+    }
+
+    std::vector<uint32_t> IfcGeometryProcessor::GetOverBudgetElements() const
+    {
+        std::lock_guard<std::mutex> lock(_overBudgetMutex);
+        std::vector<uint32_t> elements(_overBudgetElements.begin(), _overBudgetElements.end());
+        std::sort(elements.begin(), elements.end());
+        return elements;
+    }
+
+    void IfcGeometryProcessor::ClearOverBudgetElements()
+    {
+        std::lock_guard<std::mutex> lock(_overBudgetMutex);
+        _overBudgetElements.clear();
+    }
+
+    void IfcGeometryProcessor::FlagOverBudget(uint32_t expressID)
+    {
+        std::lock_guard<std::mutex> lock(_overBudgetMutex);
+        _overBudgetElements.insert(expressID);
+    }
+
+    bool IfcGeometryProcessor::IsOverBudget(uint32_t expressID) const
+    {
+        std::lock_guard<std::mutex> lock(_overBudgetMutex);
+        return _overBudgetElements.count(expressID) > 0;
+    }
+
+    void IfcGeometryProcessor::SetBooleanObserver(const std::function<void(const std::vector<IfcGeometry> &, const std::vector<IfcGeometry> &, BooleanOperation)> &observer)
+    {
+        _booleanObserver = observer;
+    }
+
+    void IfcGeometryProcessor::AddMemoryStats(utility::MemoryStats &stats) const
+    {
+        _expressIDToGeometry.ForEach([&](const IfcGeometryStore &geometries)
+                                     {
+            stats.geometryBytes += utility::MapBytes(geometries.GetGeometries()) - geometries.size() * sizeof(IfcGeometry);
+            for (const auto &[expressID, geometry] : geometries) stats.geometryBytes += geometry.GetMemorySize(); });
+        _lodGeometries.ForEach([&](const auto &geometries)
+                               {
+            stats.geometryBytes += utility::MapBytes(geometries) - geometries.size() * sizeof(IfcGeometry);
+            for (const auto &[key, geometry] : geometries) stats.geometryBytes += geometry.GetMemorySize(); });
+        _geometryLoader.AddMemoryStats(stats);
+    }
+
+    void IfcGeometryProcessor::ResetProfile()
+    {
+#ifdef WEBIFC_GEOMETRY_PROFILING
+        _profiler.Reset();
+#endif
+    }
+
     IfcGeometryProcessor *IfcGeometryProcessor::Clone(const webifc::parsing::IfcLoader &newLoader) const
     {
-        IfcGeometryProcessor *newProcessor = new IfcGeometryProcessor(_settings, _expressIDToGeometry, *_geometryLoader.Clone(newLoader), _transformation, newLoader, _boolEngine, _schemaManager, _isCoordinated, _expressIdCyl, _expressIdRect, _coordinationMatrix, _predefinedCylinder, _predefinedCube);
+        IfcGeometryProcessor *newProcessor = new IfcGeometryProcessor(_settings, _expressIDToGeometry.Get().GetGeometries(), *_geometryLoader.Clone(newLoader), _transformation, newLoader, _boolEngine, _schemaManager, _isCoordinated.load(), _expressIdCyl, _expressIdRect, _coordinationMatrix, _predefinedCylinder, _predefinedCube);
+        newProcessor->SetBooleanBudget(_booleanTimeBudget, _elementTimeBudget, _booleanFaceBudget);
         return newProcessor;
     }
 
@@ -6,11 +6,25 @@
 
 #include <glm/glm.hpp>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <cfloat>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include "representation/geometry.h"
 #include "../parsing/IfcLoader.h"
 #include "../schema/IfcSchemaManager.h"
 #include "IfcGeometryLoader.h"
+#include "IfcGeometryStore.h"
+#include "IfcSpatialIndex.h"
+#include "IfcGeometryProfiler.h"
+#include "../utility/parallel.h"
 
 namespace fuzzybools
 {
@@ -27,26 +41,104 @@ namespace webifc::geometry
     bool _coordinateToOrigin = false;
     bool _optimize_profiles = true;
     bool _exportPolylines = false;
+    bool _weldVertices = false;
+    bool _optimizeVertexCache = false;
+    uint32_t _terrainChunkTriangles = 0;
     uint16_t _circleSegments = 12;
     double TOLERANCE_PLANE_INTERSECTION = 1.0E-04;
     double TOLERANCE_PLANE_DEVIATION = 1.0E-04;
     double TOLERANCE_BACK_DEVIATION_DISTANCE = 1.0E-04;
     double TOLERANCE_INSIDE_OUTSIDE_PERIMETER = 1.0E-10;
+    double TOLERANCE_SCALAR_EQUALITY = 1.0E-04;
+    double PLANE_REFIT_ITERATIONS = 1;
     uint16_t _BOOLEAN_UNION_THRESHOLD = 150;
+    double CIRCLE_CHORD_TOLERANCE = 0;
   };
 
+  // the key of the mesh cache of a model with the tape hash, meshed with the settings and transformation, every setting
+  // that changes the meshes goes into it
+  uint64_t GetMeshCacheKey(const IfcGeometrySettings &settings, uint64_t tapeHash, const glm::dmat4 &transformation);
+
+  // the operators of IfcBooleanResult that are meshed
+  enum class BooleanOperation
+  {
+    UNION,
+    DIFFERENCE
+  };
+
+  // the IFC name of the operation, UNION or DIFFERENCE
+  const char *GetBooleanOperationName(BooleanOperation op);
+  // false for names of operations that are not meshed
+  bool ParseBooleanOperation(std::string_view name, BooleanOperation &op);
+
   class booleanManager
   {
   public:
-    IfcGeometry BoolProcess(const std::vector<IfcGeometry> &firstGeoms, std::vector<IfcGeometry> &secondGeoms, std::string op, IfcGeometrySettings _settings);
+    // the operands are not changed, only the ones that take part are copied, once, and their copies are handed on to
+    // the boolean engine and back without further copies
+    IfcGeometry BoolProcess(const std::vector<IfcGeometry> &firstGeoms, const std::vector<IfcGeometry> &secondGeoms, BooleanOperation op, const IfcGeometrySettings &_settings);
 
   private:
-    fuzzybools::Geometry convertToEngine(Geometry geom);
-    IfcGeometry convertToWebIfc(fuzzybools::Geometry geom);
-    IfcGeometry Union(IfcGeometry firstOperator, IfcGeometry secondOperator);
-    IfcGeometry Subtract(IfcGeometry firstOperator, IfcGeometry secondOperator);
+    fuzzybools::Geometry convertToEngine(Geometry &&geom);
+    IfcGeometry convertToWebIfc(fuzzybools::Geometry &&geom);
+    IfcGeometry Union(IfcGeometry &&firstOperator, IfcGeometry &&secondOperator);
+    IfcGeometry Subtract(IfcGeometry &&firstOperator, IfcGeometry &&secondOperator);
+    // subtracts all cutters from firstOperator, the ones that miss it are skipped and the ones whose boxes are apart
+    // are subtracted together, so the host is normalized and indexed once per group instead of once per cutter
+    IfcGeometry SubtractAll(IfcGeometry firstOperator, const std::vector<const IfcGeometry *> &cutters);
+  };
+
+  // what GetElementQuantities measures of an element, in the space of its flat mesh
+  struct IfcElementQuantities
+  {
+    double volume = 0;
+    double area = 0;
+    glm::dvec3 min = glm::dvec3(DBL_MAX);
+    glm::dvec3 max = glm::dvec3(-DBL_MAX);
+  };
+
+  // curves packed for drawing as lines, the points of all curves in one buffer
+  struct IfcPolylineBuffer
+  {
+    // x, y, z of every point, curve after curve
+    std::vector<float> points;
+    // the first point of every curve and at last the point count, curve i runs from offsets[i] to offsets[i + 1]
+    std::vector<uint32_t> offsets = {0};
+    // of the element or alignment of every curve
+    std::vector<uint32_t> expressIDs;
+
+    void AddPoint(const glm::dvec3 &point)
+    {
+      points.push_back(static_cast<float>(point.x));
+      points.push_back(static_cast<float>(point.y));
+      points.push_back(static_cast<float>(point.z));
+    }
+
+    // ends a curve of expressID with the points added since the last one, a curve without points is dropped
+    void EndCurve(uint32_t expressID)
+    {
+      const uint32_t count = static_cast<uint32_t>(points.size() / 3);
+      if (count == offsets.back()) return;
+      offsets.push_back(count);
+      expressIDs.push_back(expressID);
+    }
+  };
+
+  // a square of a terrain handed over by StreamTerrain, its vertices in place like BakePlacedGeometry gives them
+  struct IfcTerrainChunk
+  {
+    // the triangulated irregular network or face set
+    uint32_t expressID = 0;
+    // among the chunks of the terrain that have triangles
+    uint32_t index = 0;
+    uint32_t count = 0;
+    glm::dvec4 color = glm::dvec4(1);
+    std::vector<float> vertexData;
+    std::vector<uint32_t> indexData;
   };
 
+  // GetMesh and GetFlatMesh can be called from several threads at once as long as each of them holds an
+  // IfcLoader::ReadScope, every thread computes into its own geometry store, which GetGeometry reads
   class IfcGeometryProcessor
   {
   public:
@@ -54,35 +146,232 @@ namespace webifc::geometry
     IfcGeometry &GetGeometry(uint32_t expressID);
     IfcGeometryLoader& GetLoader();
     IfcFlatMesh GetFlatMesh(uint32_t expressID, bool applyLinearScalingFactor = true);
+    // the flat mesh at a level of detail, 0 is the full mesh and every further level is coarser, its geometries are read
+    // through GetGeometry with the same level. The levels are decimated from the full geometry, so they are fetched from
+    // coarse to fine before the full geometry is prepared with a format that releases its vertices
+    IfcFlatMesh GetFlatMeshLOD(uint32_t expressID, uint32_t lod, bool applyLinearScalingFactor = true);
+    IfcGeometry &GetGeometry(uint32_t expressID, uint32_t lod);
+    // a cheap box of the element in the space of GetFlatMesh without meshing it, from its placement and its IfcBoundingBox
+    // where it has a Box representation, else from the profiles and depths of its extrusions and the points of its
+    // faceted items. It leaves out what it does not know how to bound and does not subtract openings, false when nothing
+    // bounded the element
+    bool GetElementBounds(uint32_t expressID, glm::dvec3 &min, glm::dvec3 &max, bool applyLinearScalingFactor = true);
+    // a relative estimate of the work of meshing the element without meshing it, from the types of the items of its
+    // representations and the openings voiding it, used to balance shards of a model. 0 when it has no representation
+    uint32_t EstimateMeshingCost(uint32_t expressID);
+    // the volume, surface area and exact box of the placed geometries of the element, from its flat mesh without preparing
+    // vertex data. Geometries whose double vertices were released by an earlier output format are left out, false when
+    // nothing was measured
+    bool GetElementQuantities(uint32_t expressID, IfcElementQuantities &quantities);
+    // the flat meshes of all elements merged into one mesh per color, the colors in the order they first appear. The
+    // vertices are transformed by their placement, so the meshes are drawn without one, and every element keeps the
+    // index ranges it covers for picking
+    std::vector<IfcMergedMesh> GetMergedMeshes(const std::vector<uint32_t> &expressIDs, bool applyLinearScalingFactor = true);
+    // the vertices of the placed geometry of a flat mesh transformed into place, 6 floats per vertex like GetVertexData,
+    // and its indices with the winding kept for mirroring placements, so the mesh is drawn without its transformation.
+    // False when the vertices of the geometry were released
+    bool BakePlacedGeometry(const IfcPlacedGeometry &placedGeometry, std::vector<float> &vertexData, std::vector<uint32_t> &indexData);
+    // adds the curves and points of the element's flat mesh to buffer transformed into place, they are only meshed with
+    // _exportPolylines. Returns the number of curves added
+    size_t AddPolylines(uint32_t expressID, IfcPolylineBuffer &buffer, bool applyLinearScalingFactor = true);
+    // the terrains of the element that SetTerrainChunkTriangles left out, split on x and y of their items into squares
+    // of about that many triangles, each handed to onChunk on its own. With maxError above 0 the vertices are clustered
+    // first, over the whole terrain so that neighbouring chunks still meet, and no vertex moves further than maxError in
+    // the space of GetFlatMesh, so a coarse pass may be streamed before a fine one. Returns the number of chunks
+    size_t StreamTerrain(uint32_t expressID, double maxError, const std::function<void(const IfcTerrainChunk &)> &onChunk, bool applyLinearScalingFactor = true);
+    // a copy of the calling thread's geometry that Clear and the memory limit leave alone until it is released as many
+    // times as it was pinned, so that its buffers can be read in place meanwhile. False when there is no such geometry
+    bool PinGeometry(uint32_t expressID);
+    void ReleaseGeometry(uint32_t expressID);
+    // nullptr when the geometry is not pinned
+    IfcGeometry *GetPinnedGeometry(uint32_t expressID);
+    // indexes the flat meshes of the elements for ray casts and proximity queries in the space of GetFlatMesh, replacing
+    // what was indexed before. The index keeps copies of the geometries, so they may be cleared afterwards
+    void BuildSpatialIndex(const std::vector<uint32_t> &expressIDs);
+    const IfcSpatialIndex &GetSpatialIndex() const;
     IfcComposedMesh GetMesh(uint32_t expressID);
     void SetTransformation(const std::array<double, 16> &val);
+    // bytes of geometry every thread keeps at most between two elements, 0 keeps everything, with a limit the geometry of
+    // a flat mesh is only guaranteed to be available until the next GetFlatMesh on the same thread
+    void SetGeometryMemoryLimit(size_t bytes);
+    // largest distance between an arc and its chords, arcs then get as many points as they need instead of
+    // circleSegments. 0 turns it off
+    void SetCircleChordTolerance(double tolerance);
+    // the geometries of flat meshes have their vertices welded before they are placed the first time, and with
+    // optimizeVertexCache their faces ordered for the GPU's vertex cache, see IfcGeometry::WeldVertices
+    void SetVertexWelding(bool weld, bool optimizeVertexCache);
+    // flat meshes keep the geometries of curves, points and edges, one point per vertex in order, set before meshing
+    void SetExportPolylines(bool exportPolylines);
+    // triangulated irregular networks and face sets of more than triangles triangles are left out of the meshes of their
+    // elements and of booleans, StreamTerrain hands them over in chunks. 0 meshes them whole, set before meshing
+    void SetTerrainChunkTriangles(uint32_t triangles);
+    // seconds a single boolean and all booleans of one GetFlatMesh may take, and the faces the operands of a boolean may
+    // have, 0 leaves each unlimited. A boolean over budget gives up and leaves the host un-cut, or the operands side by
+    // side for a union, and the element is flagged
+    void SetBooleanBudget(double booleanSeconds, double elementSeconds, uint32_t booleanFaces);
+    // the elements GetFlatMesh meshed with a boolean over budget since the last ClearOverBudgetElements, in ascending
+    // order. Their meshes stay out of the mesh cache, so that they can be meshed again without a budget
+    std::vector<uint32_t> GetOverBudgetElements() const;
+    void ClearOverBudgetElements();
     std::array<double, 16> GetFlatCoordinationMatrix() const;
     glm::dmat4 GetCoordinationMatrix() const;
+    // with COORDINATE_TO_ORIGIN, sets the coordination from the placement of the first IfcSite in expressID order, or of
+    // the first IfcBuilding without a placed site, so that it does not depend on which element is meshed first. GetFlatMesh
+    // calls it, call it before meshing on several threads so that they do not wait on it. False when the coordination was
+    // set already or the model places neither, the first vertex meshed then sets it as before
+    bool CoordinateFromPlacements(bool applyLinearScalingFactor = true);
     void Clear();
+    // for edits: drops what the caches derived from the lines, the geometry, placements, points, profiles and curves of
+    // them and of every line that references them directly or indirectly or shares its geometry, and the relationship
+    // maps they feed. Everything else stays cached. Returns the elements among the dropped lines in ascending order,
+    // they mesh anew on their next GetFlatMesh. Call it before lines change or are removed and again once they are
+    // written, for the lines they then reference, no thread may be meshing meanwhile. The spatial index and the units are
+    // left as they are
+    std::vector<uint32_t> InvalidateLines(const std::vector<uint32_t> &expressIDs);
+    // the lines that the relationships among expressIDs relate as they are now. Lines overwritten in one go can instead be
+    // invalidated once they are written, with these lines read before and added to them
+    std::vector<uint32_t> GetRelatedLines(const std::vector<uint32_t> &expressIDs);
+    // clears the calling thread's caches only, other threads may keep working meanwhile
+    void ClearThread();
+    // for streaming one element after another: drops the calling thread's output of the elements streamed so far beyond
+    // budget bytes, least recently used first, and keeps what later elements share, the meshes of mapped representations,
+    // placements and profiles. 0 uses the geometry memory limit or STREAMING_GEOMETRY_BUDGET without one
+    void TrimStreamingCaches(size_t budget = 0);
+    // the memory limit and TrimStreamingCaches leave the calling thread's geometry in place until it is released, so its
+    // buffers stay valid over the next elements, unlike PinGeometry nothing is copied
+    void KeepGeometry(uint32_t expressID);
+    void ReleaseKeptGeometries();
     IfcGeometryProcessor *Clone(const webifc::parsing::IfcLoader &loader) const;
+    // GetFlatMesh keeps the meshes it produces in a cache file and answers from it for the elements the file holds, the
+    // file only applies to the same model loaded with the same settings, so open it after SetTransformation and before
+    // meshing. False when the file holds no usable cache, the cache then starts out empty
+    bool OpenMeshCache(const std::string &path);
+    // writes what was meshed since the cache was opened, together with what it held already. Fails once lines of the
+    // model were written or removed, the file would no longer match the model it is opened for
+    bool SaveMeshCache() const;
+    // seconds spent in booleans and in flattening composed meshes since the last ResetMeshingTimes, summed over threads
+    struct MeshingTimes
+    {
+      double booleans = 0;
+      double flatten = 0;
+      uint64_t booleanCalls = 0;
+    };
+    MeshingTimes GetMeshingTimes() const;
+    void ResetMeshingTimes();
+    // collects counters per type and per element of what GetMesh meshes, only builds with WEBIFC_GEOMETRY_PROFILING
+    // have them, false otherwise. Read and reset them while no thread is meshing
+    bool SetProfilingEnabled(bool enabled);
+    IfcGeometryProfile GetProfile() const;
+    void ResetProfile();
+    // called with the operands of every boolean before it runs, on the thread that runs it, e.g. to extract boolean cases
+    void SetBooleanObserver(const std::function<void(const std::vector<IfcGeometry> &, const std::vector<IfcGeometry> &, BooleanOperation)> &observer);
+    // the geometry of all threads and the caches of the geometry loader, no thread may be meshing meanwhile
+    void AddMemoryStats(utility::MemoryStats &stats) const;
 
   protected:
     IfcGeometryProcessor(const IfcGeometrySettings &settings, std::unordered_map<uint32_t, IfcGeometry> expressIDToGeometry, const IfcGeometryLoader &geometryLoader, glm::dmat4 transformation, const parsing::IfcLoader &loader, booleanManager boolEngine, const schema::IfcSchemaManager &schemaManager, bool isCoordinated, uint32_t expressIdCyl, uint32_t expressIdRect, glm::dmat4 coordinationMatrix, IfcGeometry predefinedCylinder, IfcGeometry predefinedCube);
     IfcGeometrySettings _settings;
     std::optional<glm::dvec4> GetStyleItemFromExpressId(uint32_t expressID);
+    // what AddFaceToGeometry reads of a face before it triangulates it, the triangulation reads nothing more of the tape,
+    // so faces that were read can be triangulated on other threads
+    struct IfcFaceInput
+    {
+      uint32_t expressID = 0;
+      std::vector<IfcBound3D> bounds;
+      std::optional<IfcSurface> surface;
+    };
     void AddFaceToGeometry(uint32_t expressID, IfcGeometry &geometry);
+    bool ReadFace(uint32_t expressID, IfcFaceInput &face);
+    void TriangulateFace(IfcFaceInput &face, IfcGeometry &geometry);
     IfcGeometry GetBrep(uint32_t expressID);
-    IfcGeometry BoolProcess(const std::vector<IfcGeometry> &firstGroups, std::vector<IfcGeometry> &secondGroups, std::string op, IfcGeometrySettings _settings);
-    std::unordered_map<uint32_t, IfcGeometry> _expressIDToGeometry;
+    IfcGeometry BoolProcess(const std::vector<IfcGeometry> &firstGroups, const std::vector<IfcGeometry> &secondGroups, BooleanOperation op, const IfcGeometrySettings &_settings);
+    // the union of all geometries, fused pairwise in a balanced tree whose pairs run in parallel where threads are
+    // available. Pairs whose boxes are apart are concatenated without a boolean
+    IfcGeometry FuseGeometries(std::vector<IfcGeometry> geoms);
+    utility::PerThread<IfcGeometryStore> _expressIDToGeometry;
+    // by level of detail in the upper and expressID in the lower half
+    utility::PerThread<std::unordered_map<uint64_t, IfcGeometry>> _lodGeometries;
+    size_t _geometryMemoryLimit = 0;
+    static constexpr size_t STREAMING_GEOMETRY_BUDGET = 64 * 1024 * 1024;
+    // the meshes of mapped representations by the representation's expressID, good as long as their geometries are held
+    utility::PerThread<std::unordered_map<uint32_t, IfcComposedMesh>> _mappedMeshes;
+    // true when all geometries of the mesh are held, they then count as reused
+    bool ReuseMappedMesh(const IfcComposedMesh &mesh);
+    // representation items with the same content share the geometry meshed for the first of them, the content hash leaves
+    // out ignoredArgument, the item's own placement, when the geometry does not depend on it
+    std::optional<uint32_t> GetSharedGeometry(uint32_t expressID, uint32_t ignoredArgument, uint64_t &contentHash);
+    void ShareGeometry(uint32_t expressID, uint64_t contentHash);
+    utility::PerThread<std::unordered_map<uint32_t, uint64_t>> _contentHashes;
+    utility::PerThread<std::unordered_map<uint64_t, uint32_t>> _expressIDByContent;
+    // swept disks of the same radius share their circle, by radius, circle segments and chord tolerance
+    const IfcProfile &GetDiskProfile(double radius);
+    utility::PerThread<std::map<std::tuple<double, uint16_t, double>, IfcProfile>> _diskProfiles;
+    IfcSpatialIndex _spatialIndex;
+    struct PinnedGeometry
+    {
+      IfcGeometry geometry;
+      uint32_t pins = 0;
+    };
+    std::mutex _pinnedMutex;
+    std::unordered_map<uint32_t, PinnedGeometry> _pinnedGeometries;
     IfcSurface GetSurface(uint32_t expressID);
     IfcGeometryLoader _geometryLoader;
     glm::dmat4 _transformation = glm::dmat4(1.0);
     const parsing::IfcLoader &_loader;
     booleanManager _boolEngine;
     const schema::IfcSchemaManager &_schemaManager;
-    bool _isCoordinated = false;
+    std::atomic<bool> _isCoordinated = false;
+    // CoordinateFromPlacements looked for a placement already
+    std::atomic<bool> _placementsSearched = false;
     uint32_t _expressIdCyl = 0;
     uint32_t _expressIdRect = 0;
     glm::dmat4 _coordinationMatrix = glm::dmat4(1.0);
+    mutable std::mutex _coordinationMutex;
     void AddComposedMeshToFlatMesh(IfcFlatMesh &flatMesh, const IfcComposedMesh &composedMesh, const glm::dmat4 &parentMatrix = glm::dmat4(1), const glm::dvec4 &color = glm::dvec4(1, 1, 1, 1), bool hasColor = false);
     std::vector<uint32_t> Read2DArrayOfThreeIndices();
+    // the triangle corners of a triangulated irregular network or face set, from 0, and its points
+    void ReadTriangulatedFaceSet(uint32_t expressID, std::vector<glm::dvec3> &points, std::vector<uint32_t> &indices);
+    bool IsChunkedTerrain(uint32_t lineType, size_t triangles) const;
+    void AddTerrainChunks(const IfcComposedMesh &composedMesh, const glm::dmat4 &parentMatrix, const glm::dvec4 &color, bool hasColor, double maxError, const std::function<void(const IfcTerrainChunk &)> &onChunk, size_t &chunks);
+    // adds the lines that depend on the pending ones to lines, see InvalidateLines
+    void AddDependentLines(std::vector<uint32_t> pending, std::unordered_set<uint32_t> &lines);
+    // adds the lines a reference or a set of references argument of the line refers to to refs
+    void AddRefArgument(uint32_t expressID, uint32_t argument, std::vector<uint32_t> &refs);
+    // grows min and max by the item placed with transformation, see GetElementBounds
+    bool AddItemBounds(uint32_t expressID, const glm::dmat4 &transformation, glm::dvec3 &min, glm::dvec3 &max);
     void ReadIndexedPolygonalFace(uint32_t expressID, std::vector<IfcBound3D> &bounds, const std::vector<glm::dvec3> &points);
     IfcGeometry _predefinedCylinder;
     IfcGeometry _predefinedCube;
+    struct MeshCache
+    {
+      std::mutex mutex;
+      bool enabled = false;
+      bool changed = false;
+      std::string path;
+      uint64_t key = 0;
+      // by expressID and whether the linear scaling factor was applied, see GetFlatMesh
+      std::unordered_map<uint64_t, IfcFlatMesh> meshes;
+      std::unordered_map<uint32_t, IfcGeometry> geometries;
+    };
+    mutable MeshCache _meshCache;
+    std::atomic<uint64_t> _booleanTime = 0;
+    std::atomic<uint64_t> _flattenTime = 0;
+    std::atomic<uint64_t> _booleanCalls = 0;
+    std::function<void(const std::vector<IfcGeometry> &, const std::vector<IfcGeometry> &, BooleanOperation)> _booleanObserver;
+    double _booleanTimeBudget = 0;
+    double _elementTimeBudget = 0;
+    uint32_t _booleanFaceBudget = 0;
+    mutable std::mutex _overBudgetMutex;
+    std::unordered_set<uint32_t> _overBudgetElements;
+    void FlagOverBudget(uint32_t expressID);
+    bool IsOverBudget(uint32_t expressID) const;
+#ifdef WEBIFC_GEOMETRY_PROFILING
+    IfcGeometryProfiler _profiler;
+    // enters the profiler for the GetMesh call it lives in
+    class ProfileScope;
+#endif
+    uint64_t GetMeshCacheKey() const;
+    std::optional<IfcFlatMesh> GetCachedFlatMesh(uint32_t expressID, bool applyLinearScalingFactor);
+    void CacheFlatMesh(const IfcFlatMesh &flatMesh, bool applyLinearScalingFactor);
   };
 }
\ No newline at end of file
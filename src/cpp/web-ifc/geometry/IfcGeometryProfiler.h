@@ -0,0 +1,148 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../utility/parallel.h"
+#include "../utility/timing.h"
+
+namespace webifc::geometry
+{
+
+  // times are in nanoseconds
+  struct IfcProfileCounters
+  {
+    uint64_t calls = 0;
+    uint64_t inclusiveTime = 0;
+    // without the nested GetMesh calls
+    uint64_t exclusiveTime = 0;
+    uint64_t triangles = 0;
+    // held by the geometry produced
+    uint64_t bytes = 0;
+
+    void Add(const IfcProfileCounters &other)
+    {
+      calls += other.calls;
+      inclusiveTime += other.inclusiveTime;
+      exclusiveTime += other.exclusiveTime;
+      triangles += other.triangles;
+      bytes += other.bytes;
+    }
+  };
+
+  struct IfcElementProfile
+  {
+    uint32_t type = 0;
+    IfcProfileCounters counters;
+  };
+
+  struct IfcGeometryProfile
+  {
+    // by the type of the line GetMesh was called for, triangles and bytes are the ones of that line's own geometry
+    std::unordered_map<uint32_t, IfcProfileCounters> types;
+    // by expressID, triangles and bytes include everything meshed for the element
+    std::unordered_map<uint32_t, IfcElementProfile> elements;
+  };
+
+#ifdef WEBIFC_GEOMETRY_PROFILING
+  // counts nested GetMesh calls with a stack per thread, so calls on several threads at once are accounted apart
+  class IfcGeometryProfiler
+  {
+  public:
+    void SetEnabled(bool enabled)
+    {
+      _enabled = enabled;
+    }
+
+    bool IsEnabled() const
+    {
+      return _enabled.load(std::memory_order_relaxed);
+    }
+
+    void Enter(uint32_t expressID, uint32_t type, bool isElement)
+    {
+      _threads.Get().stack.push_back({expressID, type, isElement, utility::NowNanoseconds()});
+    }
+
+    // triangles and bytes of the geometry the call itself produced
+    void Leave(uint64_t triangles, uint64_t bytes)
+    {
+      auto &thread = _threads.Get();
+      if (thread.stack.empty()) return;
+      const Frame frame = thread.stack.back();
+      thread.stack.pop_back();
+      const uint64_t time = utility::NowNanoseconds() - frame.start;
+      const uint64_t totalTriangles = frame.childTriangles + triangles;
+      const uint64_t totalBytes = frame.childBytes + bytes;
+
+      auto &counters = thread.profile.types[frame.type];
+      counters.calls++;
+      counters.inclusiveTime += time;
+      counters.exclusiveTime += time - frame.childTime;
+      counters.triangles += triangles;
+      counters.bytes += bytes;
+
+      if (frame.isElement)
+      {
+        auto &element = thread.profile.elements[frame.expressID];
+        element.type = frame.type;
+        element.counters.Add({1, time, time - frame.childTime, totalTriangles, totalBytes});
+      }
+
+      if (!thread.stack.empty())
+      {
+        auto &parent = thread.stack.back();
+        parent.childTime += time;
+        parent.childTriangles += totalTriangles;
+        parent.childBytes += totalBytes;
+      }
+    }
+
+    // merged over the threads, none may be meshing meanwhile
+    IfcGeometryProfile GetProfile() const
+    {
+      IfcGeometryProfile merged;
+      _threads.ForEach([&](const ThreadState &thread)
+                       {
+        for (const auto &[type, counters] : thread.profile.types) merged.types[type].Add(counters);
+        for (const auto &[expressID, element] : thread.profile.elements)
+        {
+          auto &mergedElement = merged.elements[expressID];
+          mergedElement.type = element.type;
+          mergedElement.counters.Add(element.counters);
+        } });
+      return merged;
+    }
+
+    void Reset()
+    {
+      _threads.Clear();
+    }
+
+  private:
+    struct Frame
+    {
+      uint32_t expressID;
+      uint32_t type;
+      bool isElement;
+      uint64_t start;
+      uint64_t childTime = 0;
+      uint64_t childTriangles = 0;
+      uint64_t childBytes = 0;
+    };
+    struct ThreadState
+    {
+      std::vector<Frame> stack;
+      IfcGeometryProfile profile;
+    };
+    std::atomic<bool> _enabled = false;
+    utility::PerThread<ThreadState> _threads;
+  };
+#endif
+
+}
@@ -0,0 +1,194 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "IfcGeometryStore.h"
+
+#include <iterator>
+
+namespace webifc::geometry
+{
+
+  IfcGeometryStore::IfcGeometryStore(const std::unordered_map<uint32_t, IfcGeometry> &geometries) : _geometries(geometries) {}
+
+  // the bookkeeping holds positions in its own list, so a copy starts it over
+  IfcGeometryStore::IfcGeometryStore(const IfcGeometryStore &other) : IfcGeometryStore(other._geometries) {}
+
+  IfcGeometryStore &IfcGeometryStore::operator=(const IfcGeometryStore &other)
+  {
+    if (this != &other)
+    {
+      *this = IfcGeometryStore(other);
+    }
+    return *this;
+  }
+
+  IfcGeometry &IfcGeometryStore::operator[](const uint32_t expressID)
+  {
+    use(expressID);
+    return _geometries[expressID];
+  }
+
+  void IfcGeometryStore::Reuse(const uint32_t expressID)
+  {
+    auto geometryIt = _geometries.find(expressID);
+    if (geometryIt != _geometries.end())
+    {
+      geometryIt->second.RestoreVertexData();
+    }
+    Entry *entry = use(expressID);
+    if (entry != nullptr)
+    {
+      entry->reuses++;
+    }
+  }
+
+  IfcGeometryStore::Entry *IfcGeometryStore::use(const uint32_t expressID)
+  {
+    if (!_tracking)
+    {
+      return nullptr;
+    }
+    auto [entryIt, inserted] = _entries.try_emplace(expressID);
+    Entry &entry = entryIt->second;
+    if (inserted)
+    {
+      _recent.push_front(expressID);
+    }
+    else
+    {
+      _recent.splice(_recent.begin(), _recent, entry.position);
+    }
+    entry.position = _recent.begin();
+    if (entry.measured)
+    {
+      entry.measured = false;
+      _unmeasured.push_back(expressID);
+    }
+    else if (inserted)
+    {
+      _unmeasured.push_back(expressID);
+    }
+    return &entry;
+  }
+
+  void IfcGeometryStore::Trim(const size_t budget)
+  {
+    if (budget == 0)
+    {
+      return;
+    }
+    if (!_tracking)
+    {
+      _tracking = true;
+      for (const auto &[expressID, geometry] : _geometries)
+      {
+        use(expressID);
+      }
+    }
+    for (const uint32_t expressID : _unmeasured)
+    {
+      auto entryIt = _entries.find(expressID);
+      if (entryIt == _entries.end() || entryIt->second.measured)
+      {
+        continue;
+      }
+      Entry &entry = entryIt->second;
+      auto geometryIt = _geometries.find(expressID);
+      const size_t bytes = geometryIt == _geometries.end() ? 0 : geometryIt->second.GetMemorySize();
+      _bytes = _bytes - entry.bytes + bytes;
+      entry.bytes = bytes;
+      entry.measured = true;
+    }
+    _unmeasured.clear();
+    // the kept geometries at the back are passed over, the next one to drop sits before next
+    auto next = _recent.end();
+    while (_bytes > budget && next != _recent.begin())
+    {
+      const auto position = std::prev(next);
+      const uint32_t expressID = *position;
+      if (_kept.count(expressID) != 0)
+      {
+        next = position;
+        continue;
+      }
+      Entry &entry = _entries[expressID];
+      if (entry.reuses > 0)
+      {
+        // a reused geometry goes back to the front at the cost of a reuse
+        entry.reuses /= 2;
+        _recent.splice(_recent.begin(), _recent, position);
+        entry.position = _recent.begin();
+        continue;
+      }
+      _bytes -= entry.bytes;
+      _recent.erase(position);
+      _entries.erase(expressID);
+      _geometries.erase(expressID);
+    }
+  }
+
+  void IfcGeometryStore::Keep(const uint32_t expressID)
+  {
+    _kept.insert(expressID);
+  }
+
+  void IfcGeometryStore::ReleaseKept()
+  {
+    _kept.clear();
+  }
+
+  void IfcGeometryStore::Remove(const uint32_t expressID)
+  {
+    auto entryIt = _entries.find(expressID);
+    if (entryIt != _entries.end())
+    {
+      _bytes -= entryIt->second.bytes;
+      _recent.erase(entryIt->second.position);
+      _entries.erase(entryIt);
+    }
+    _geometries.erase(expressID);
+    _kept.erase(expressID);
+  }
+
+  size_t IfcGeometryStore::GetMemorySize() const
+  {
+    return _bytes;
+  }
+
+  void IfcGeometryStore::clear()
+  {
+    _geometries.clear();
+    _recent.clear();
+    _entries.clear();
+    _unmeasured.clear();
+    _kept.clear();
+    _bytes = 0;
+  }
+
+  std::unordered_map<uint32_t, IfcGeometry>::const_iterator IfcGeometryStore::find(const uint32_t expressID) const
+  {
+    return _geometries.find(expressID);
+  }
+
+  std::unordered_map<uint32_t, IfcGeometry>::const_iterator IfcGeometryStore::begin() const
+  {
+    return _geometries.begin();
+  }
+
+  std::unordered_map<uint32_t, IfcGeometry>::const_iterator IfcGeometryStore::end() const
+  {
+    return _geometries.end();
+  }
+
+  size_t IfcGeometryStore::size() const
+  {
+    return _geometries.size();
+  }
+
+  const std::unordered_map<uint32_t, IfcGeometry> &IfcGeometryStore::GetGeometries() const
+  {
+    return _geometries;
+  }
+
+}
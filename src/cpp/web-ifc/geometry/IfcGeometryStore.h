@@ -0,0 +1,69 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "representation/IfcGeometry.h"
+
+namespace webifc::geometry
+{
+
+  // geometry by expressID, operator[] keeps track of use so that Trim can drop the least recently used geometries once
+  // the store holds more bytes than its budget, geometries reused for several placements get another round for every
+  // reuse before they are dropped. The map is only handed out to read, so nothing changes it past the bookkeeping
+  class IfcGeometryStore
+  {
+  public:
+    IfcGeometryStore() = default;
+    IfcGeometryStore(const std::unordered_map<uint32_t, IfcGeometry> &geometries);
+    IfcGeometryStore(const IfcGeometryStore &other);
+    IfcGeometryStore(IfcGeometryStore &&other) = default;
+    IfcGeometryStore &operator=(const IfcGeometryStore &other);
+    IfcGeometryStore &operator=(IfcGeometryStore &&other) = default;
+    IfcGeometry &operator[](const uint32_t expressID);
+    // a geometry that was found for another placement rather than meshed again, a compact one gets its doubles back
+    void Reuse(const uint32_t expressID);
+    // geometry a caller may still be using must not be dropped, so call it between elements only, use is only tracked
+    // once Trim has been called with a budget
+    void Trim(const size_t budget);
+    // Trim leaves the geometry alone until ReleaseKept, for buffers handed out past the next element
+    void Keep(const uint32_t expressID);
+    void ReleaseKept();
+    // drops the geometry together with its bookkeeping
+    void Remove(const uint32_t expressID);
+    size_t GetMemorySize() const;
+    void clear();
+    std::unordered_map<uint32_t, IfcGeometry>::const_iterator find(const uint32_t expressID) const;
+    std::unordered_map<uint32_t, IfcGeometry>::const_iterator begin() const;
+    std::unordered_map<uint32_t, IfcGeometry>::const_iterator end() const;
+    size_t size() const;
+    const std::unordered_map<uint32_t, IfcGeometry> &GetGeometries() const;
+
+  private:
+    struct Entry
+    {
+      size_t bytes = 0;
+      uint32_t reuses = 0;
+      bool measured = false;
+      std::list<uint32_t>::iterator position;
+    };
+    Entry *use(const uint32_t expressID);
+    std::unordered_map<uint32_t, IfcGeometry> _geometries;
+    bool _tracking = false;
+    // most recently used first
+    std::list<uint32_t> _recent;
+    std::unordered_map<uint32_t, Entry> _entries;
+    // used since the last Trim, their size may have changed
+    std::vector<uint32_t> _unmeasured;
+    std::unordered_set<uint32_t> _kept;
+    size_t _bytes = 0;
+  };
+
+}
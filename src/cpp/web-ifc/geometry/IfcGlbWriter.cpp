@@ -0,0 +1,334 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include "IfcGlbWriter.h"
+
+namespace webifc::geometry
+{
+
+  namespace
+  {
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr uint32_t GLB_VERSION = 2;
+    constexpr uint32_t CHUNK_JSON = 0x4E4F534A;
+    constexpr uint32_t CHUNK_BIN = 0x004E4942;
+    constexpr uint32_t ARRAY_BUFFER = 34962;
+    constexpr uint32_t ELEMENT_ARRAY_BUFFER = 34963;
+    constexpr uint32_t FLOAT = 5126;
+    constexpr uint32_t UNSIGNED_INT = 5125;
+
+    void AppendNumber(std::string &json, double value, int digits)
+    {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.*g", digits, std::isfinite(value) ? value : 0.0);
+      json += buffer;
+    }
+
+    void AppendString(std::string &json, const std::string &value)
+    {
+      json += '"';
+      for (char c : value)
+      {
+        if (c == '"' || c == '\\')
+        {
+          json += '\\';
+          json += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char buffer[8];
+          std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+          json += buffer;
+        }
+        else
+        {
+          json += c;
+        }
+      }
+      json += '"';
+    }
+
+    void AppendUint32(std::vector<char> &bytes, uint32_t value)
+    {
+      char buffer[4];
+      std::memcpy(buffer, &value, 4);
+      bytes.insert(bytes.end(), buffer, buffer + 4);
+    }
+  }
+
+  IfcGlbWriter::IfcGlbWriter(const Output &binary) : _binary(binary) {}
+
+  void IfcGlbWriter::Add(const IfcFlatMesh &mesh, const std::string &typeName, const std::function<IfcGeometry *(uint32_t)> &getGeometry)
+  {
+    Node element;
+    element.expressID = mesh.expressID;
+    element.type = typeName;
+    for (const auto &placed : mesh.geometries)
+    {
+      auto [geometryIt, added] = _geometries.try_emplace(placed.geometryExpressID);
+      if (added)
+      {
+        GeometryAccessors accessors;
+        const IfcGeometry *geometry = getGeometry(placed.geometryExpressID);
+        if (geometry != nullptr && writeGeometry(*geometry, accessors))
+        {
+          geometryIt->second = accessors;
+        }
+      }
+      if (!geometryIt->second)
+      {
+        continue;
+      }
+
+      const std::array<double, 4> color = {placed.color.r, placed.color.g, placed.color.b, placed.color.a};
+      auto [materialIt, newMaterial] = _materialByColor.try_emplace(color, static_cast<uint32_t>(_materials.size()));
+      if (newMaterial)
+      {
+        _materials.push_back(color);
+      }
+      auto [meshIt, newMesh] = _meshByGeometryAndMaterial.try_emplace({placed.geometryExpressID, materialIt->second}, static_cast<uint32_t>(_meshes.size()));
+      if (newMesh)
+      {
+        const GeometryAccessors &accessors = *geometryIt->second;
+        _meshes.push_back({accessors.position, accessors.normal, accessors.indices, materialIt->second});
+      }
+
+      Node node;
+      node.mesh = meshIt->second;
+      node.matrix = placed.flatTransformation;
+      element.children.push_back(static_cast<uint32_t>(_nodes.size()));
+      _nodes.push_back(std::move(node));
+    }
+    _elementNodes.push_back(static_cast<uint32_t>(_nodes.size()));
+    _nodes.push_back(std::move(element));
+  }
+
+  bool IfcGlbWriter::writeGeometry(const IfcGeometry &geometry, GeometryAccessors &accessors)
+  {
+    // released float vertices are still good to write, quantized ones are not
+    const size_t vertexSize = static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS;
+    const bool useDoubles = geometry.vertexData.size() == vertexSize;
+    const bool useFloats = !useDoubles && geometry.fvertexData.size() == vertexSize;
+    if (geometry.isPolygon || geometry.numPoints == 0 || geometry.numFaces == 0 || geometry.indexData.size() < static_cast<size_t>(geometry.numFaces) * 3)
+    {
+      return false;
+    }
+    if (!useDoubles && !useFloats)
+    {
+      spdlog::warn("[IfcGlbWriter::Add()] vertices of a geometry were released, it is left out");
+      return false;
+    }
+
+    std::vector<float> vertices(vertexSize);
+    std::array<float, 3> min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    std::array<float, 3> max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (size_t i = 0; i < vertexSize; i++)
+    {
+      vertices[i] = useDoubles ? static_cast<float>(geometry.vertexData[i]) : geometry.fvertexData[i];
+    }
+    for (size_t i = 0; i < vertexSize; i += VERTEX_FORMAT_SIZE_FLOATS)
+    {
+      for (int axis = 0; axis < 3; axis++)
+      {
+        min[axis] = std::min(min[axis], vertices[i + axis]);
+        max[axis] = std::max(max[axis], vertices[i + axis]);
+      }
+    }
+
+    const uint32_t vertexView = static_cast<uint32_t>(_bufferViews.size());
+    _bufferViews.push_back({_binarySize, vertices.size() * sizeof(float), VERTEX_FORMAT_SIZE_FLOATS * sizeof(float), ARRAY_BUFFER});
+    write(vertices.data(), vertices.size() * sizeof(float));
+
+    const uint32_t indexCount = geometry.numFaces * 3;
+    const uint32_t indexView = static_cast<uint32_t>(_bufferViews.size());
+    _bufferViews.push_back({_binarySize, indexCount * sizeof(uint32_t), 0, ELEMENT_ARRAY_BUFFER});
+    write(geometry.indexData.data(), indexCount * sizeof(uint32_t));
+
+    accessors.position = static_cast<uint32_t>(_accessors.size());
+    _accessors.push_back({vertexView, 0, FLOAT, geometry.numPoints, true, min, max});
+    accessors.normal = static_cast<uint32_t>(_accessors.size());
+    _accessors.push_back({vertexView, 3 * sizeof(float), FLOAT, geometry.numPoints, true, {}, {}});
+    accessors.indices = static_cast<uint32_t>(_accessors.size());
+    _accessors.push_back({indexView, 0, UNSIGNED_INT, indexCount, false, {}, {}});
+    return true;
+  }
+
+  void IfcGlbWriter::write(const void *data, size_t size)
+  {
+    const char *bytes = static_cast<const char *>(data);
+    _pending.insert(_pending.end(), bytes, bytes + size);
+    _binarySize += size;
+    if (_pending.size() >= FLUSH_SIZE)
+    {
+      flush();
+    }
+  }
+
+  void IfcGlbWriter::flush()
+  {
+    if (!_pending.empty())
+    {
+      _binary(_pending.data(), _pending.size());
+      _pending.clear();
+    }
+  }
+
+  uint64_t IfcGlbWriter::GetBinarySize() const
+  {
+    return _binarySize;
+  }
+
+  bool IfcGlbWriter::Finish(const Output &prefix)
+  {
+    flush();
+
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"web-ifc\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for (size_t i = 0; i < _elementNodes.size(); i++)
+    {
+      if (i > 0) json += ',';
+      json += std::to_string(_elementNodes[i]);
+    }
+    json += "]}],\"nodes\":[";
+    for (size_t i = 0; i < _nodes.size(); i++)
+    {
+      const Node &node = _nodes[i];
+      if (i > 0) json += ',';
+      json += '{';
+      if (node.mesh >= 0)
+      {
+        json += "\"mesh\":" + std::to_string(node.mesh) + ",\"matrix\":[";
+        for (int j = 0; j < 16; j++)
+        {
+          if (j > 0) json += ',';
+          AppendNumber(json, node.matrix[j], 17);
+        }
+        json += ']';
+      }
+      else
+      {
+        json += "\"extras\":{\"expressID\":" + std::to_string(node.expressID) + ",\"type\":";
+        AppendString(json, node.type);
+        json += '}';
+        if (!node.children.empty())
+        {
+          json += ",\"children\":[";
+          for (size_t j = 0; j < node.children.size(); j++)
+          {
+            if (j > 0) json += ',';
+            json += std::to_string(node.children[j]);
+          }
+          json += ']';
+        }
+      }
+      json += '}';
+    }
+    json += ']';
+
+    if (!_meshes.empty())
+    {
+      json += ",\"meshes\":[";
+      for (size_t i = 0; i < _meshes.size(); i++)
+      {
+        if (i > 0) json += ',';
+        json += "{\"primitives\":[{\"attributes\":{\"POSITION\":" + std::to_string(_meshes[i][0]) + ",\"NORMAL\":" + std::to_string(_meshes[i][1]) +
+                "},\"indices\":" + std::to_string(_meshes[i][2]) + ",\"material\":" + std::to_string(_meshes[i][3]) + "}]}";
+      }
+      json += "],\"materials\":[";
+      for (size_t i = 0; i < _materials.size(); i++)
+      {
+        const auto &color = _materials[i];
+        if (i > 0) json += ',';
+        json += "{\"pbrMetallicRoughness\":{\"baseColorFactor\":[";
+        for (int j = 0; j < 4; j++)
+        {
+          if (j > 0) json += ',';
+          AppendNumber(json, std::clamp(color[j], 0.0, 1.0), 9);
+        }
+        json += "],\"metallicFactor\":0,\"roughnessFactor\":1},\"doubleSided\":true";
+        if (color[3] < 1)
+        {
+          json += ",\"alphaMode\":\"BLEND\"";
+        }
+        json += '}';
+      }
+      json += "],\"accessors\":[";
+      for (size_t i = 0; i < _accessors.size(); i++)
+      {
+        const Accessor &accessor = _accessors[i];
+        if (i > 0) json += ',';
+        json += "{\"bufferView\":" + std::to_string(accessor.bufferView) + ",\"byteOffset\":" + std::to_string(accessor.offset) +
+                ",\"componentType\":" + std::to_string(accessor.componentType) + ",\"count\":" + std::to_string(accessor.count) +
+                ",\"type\":" + (accessor.vec3 ? "\"VEC3\"" : "\"SCALAR\"");
+        // positions must have their bounds
+        if (accessor.vec3 && accessor.offset == 0)
+        {
+          json += ",\"min\":[";
+          for (int j = 0; j < 3; j++)
+          {
+            if (j > 0) json += ',';
+            AppendNumber(json, accessor.min[j], 9);
+          }
+          json += "],\"max\":[";
+          for (int j = 0; j < 3; j++)
+          {
+            if (j > 0) json += ',';
+            AppendNumber(json, accessor.max[j], 9);
+          }
+          json += ']';
+        }
+        json += '}';
+      }
+      json += "],\"bufferViews\":[";
+      for (size_t i = 0; i < _bufferViews.size(); i++)
+      {
+        const BufferView &view = _bufferViews[i];
+        if (i > 0) json += ',';
+        json += "{\"buffer\":0,\"byteOffset\":" + std::to_string(view.offset) + ",\"byteLength\":" + std::to_string(view.length);
+        if (view.stride != 0)
+        {
+          json += ",\"byteStride\":" + std::to_string(view.stride);
+        }
+        json += ",\"target\":" + std::to_string(view.target) + '}';
+      }
+      json += "],\"buffers\":[{\"byteLength\":" + std::to_string(_binarySize) + "}]";
+    }
+    json += '}';
+    // chunks are 4 byte aligned, JSON is padded with spaces, the binary data is made of 4 byte values already
+    while (json.size() % 4 != 0)
+    {
+      json += ' ';
+    }
+
+    const bool hasBinary = _binarySize > 0;
+    const uint64_t totalSize = 12 + 8 + json.size() + (hasBinary ? 8 + _binarySize : 0);
+    if (totalSize > UINT32_MAX)
+    {
+      spdlog::error("[IfcGlbWriter::Finish()] {} bytes exceed what a GLB can hold", totalSize);
+      return false;
+    }
+
+    std::vector<char> header;
+    header.reserve(12 + 8 + json.size() + 8);
+    AppendUint32(header, GLB_MAGIC);
+    AppendUint32(header, GLB_VERSION);
+    AppendUint32(header, static_cast<uint32_t>(totalSize));
+    AppendUint32(header, static_cast<uint32_t>(json.size()));
+    AppendUint32(header, CHUNK_JSON);
+    header.insert(header.end(), json.begin(), json.end());
+    if (hasBinary)
+    {
+      AppendUint32(header, static_cast<uint32_t>(_binarySize));
+      AppendUint32(header, CHUNK_BIN);
+    }
+    prefix(header.data(), header.size());
+    return true;
+  }
+
+}
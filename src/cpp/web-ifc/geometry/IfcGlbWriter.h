@@ -0,0 +1,98 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "representation/IfcGeometry.h"
+#include "representation/geometry.h"
+
+namespace webifc::geometry
+{
+
+  // writes flat meshes into a binary glTF 2.0 as they are added. A geometry is written once, the first time it is
+  // placed, and every placement of it with the same color shares one mesh. An element is a node with its expressID and
+  // type in extras and a child node per placed geometry. The binary chunk is handed to the output as it grows, only the
+  // bookkeeping for the JSON is kept, so the GLB is what Finish writes followed by everything written before it
+  class IfcGlbWriter
+  {
+  public:
+    using Output = std::function<void(const char *, size_t)>;
+
+    explicit IfcGlbWriter(const Output &binary);
+    // getGeometry gives the geometry of a geometryExpressID, nullptr when there is none. It is only asked for geometries
+    // that were not written yet, which must have their double or float vertices
+    void Add(const IfcFlatMesh &mesh, const std::string &typeName, const std::function<IfcGeometry *(uint32_t)> &getGeometry);
+    // writes the GLB header, the JSON chunk and the header of the binary chunk, false when the GLB would exceed the 4GB
+    // a GLB can have, then nothing is written. Nothing may be added afterwards
+    bool Finish(const Output &prefix);
+    uint64_t GetBinarySize() const;
+
+  private:
+    static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+    struct GeometryAccessors
+    {
+      uint32_t position;
+      uint32_t normal;
+      uint32_t indices;
+    };
+    struct BufferView
+    {
+      uint64_t offset;
+      uint64_t length;
+      // 0 for tightly packed data
+      uint32_t stride;
+      uint32_t target;
+    };
+    struct Accessor
+    {
+      uint32_t bufferView;
+      uint32_t offset;
+      uint32_t componentType;
+      uint32_t count;
+      bool vec3;
+      std::array<float, 3> min;
+      std::array<float, 3> max;
+    };
+    struct Node
+    {
+      // mesh nodes
+      int64_t mesh = -1;
+      std::array<double, 16> matrix;
+      // element nodes
+      uint32_t expressID = 0;
+      std::string type;
+      std::vector<uint32_t> children;
+    };
+
+    // false for geometries without triangles or vertices
+    bool writeGeometry(const IfcGeometry &geometry, GeometryAccessors &accessors);
+    void write(const void *data, size_t size);
+    void flush();
+
+    Output _binary;
+    std::vector<char> _pending;
+    uint64_t _binarySize = 0;
+    std::vector<BufferView> _bufferViews;
+    std::vector<Accessor> _accessors;
+    std::vector<std::array<double, 4>> _materials;
+    std::map<std::array<double, 4>, uint32_t> _materialByColor;
+    // position, normal and index accessors and the material
+    std::vector<std::array<uint32_t, 4>> _meshes;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> _meshByGeometryAndMaterial;
+    // geometries that have nothing to write map to nothing
+    std::unordered_map<uint32_t, std::optional<GeometryAccessors>> _geometries;
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _elementNodes;
+  };
+
+}
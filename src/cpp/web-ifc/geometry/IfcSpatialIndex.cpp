@@ -0,0 +1,369 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cmath>
+#include <unordered_set>
+#include <spdlog/spdlog.h>
+#include "IfcSpatialIndex.h"
+#include "operations/boolean-utils/intersect-ray-tri.h"
+
+namespace webifc::geometry
+{
+
+  namespace
+  {
+    double GetBoxDistance(const fuzzybools::AABB &box, const glm::dvec3 &point)
+    {
+      const glm::dvec3 outside = glm::max(glm::max(box.min - point, point - box.max), glm::dvec3(0));
+      return glm::length(outside);
+    }
+
+    bool IsOutsidePlane(const fuzzybools::AABB &box, const glm::dvec4 &plane)
+    {
+      // the corner furthest along the normal
+      const glm::dvec3 corner(plane.x > 0 ? box.max.x : box.min.x, plane.y > 0 ? box.max.y : box.min.y, plane.z > 0 ? box.max.z : box.min.z);
+      return plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0;
+    }
+
+    // Ericson, Real-Time Collision Detection, 5.1.5
+    glm::dvec3 GetClosestPointOnTriangle(const glm::dvec3 &p, const glm::dvec3 &a, const glm::dvec3 &b, const glm::dvec3 &c)
+    {
+      const glm::dvec3 ab = b - a;
+      const glm::dvec3 ac = c - a;
+      const glm::dvec3 ap = p - a;
+      const double d1 = glm::dot(ab, ap);
+      const double d2 = glm::dot(ac, ap);
+      if (d1 <= 0 && d2 <= 0) return a;
+
+      const glm::dvec3 bp = p - b;
+      const double d3 = glm::dot(ab, bp);
+      const double d4 = glm::dot(ac, bp);
+      if (d3 >= 0 && d4 <= d3) return b;
+
+      const double vc = d1 * d4 - d3 * d2;
+      if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+      const glm::dvec3 cp = p - c;
+      const double d5 = glm::dot(ab, cp);
+      const double d6 = glm::dot(ac, cp);
+      if (d6 >= 0 && d5 <= d6) return c;
+
+      const double vb = d5 * d2 - d1 * d6;
+      if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+      const double va = d3 * d6 - d5 * d4;
+      if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+      const double denominator = va + vb + vc;
+      // degenerate triangles are handled by their edges above, what is left has no area to project onto
+      if (!(std::fabs(denominator) > 0)) return a;
+      return a + ab * (vb / denominator) + ac * (vc / denominator);
+    }
+
+    // rigid placements with a uniform scale, by far the most common, scale every vector by the same factor
+    bool GetUniformScale(const glm::dmat3 &m, double &scale)
+    {
+      const glm::dmat3 gram = glm::transpose(m) * m;
+      const double scale2 = (gram[0][0] + gram[1][1] + gram[2][2]) / 3;
+      bool uniform = scale2 > 0;
+      for (int i = 0; i < 3 && uniform; i++)
+      {
+        for (int j = 0; j < 3 && uniform; j++)
+        {
+          uniform = std::fabs(gram[i][j] - (i == j ? scale2 : 0)) <= 1e-9 * scale2;
+        }
+      }
+      scale = std::sqrt(scale2);
+      return uniform;
+    }
+  }
+
+  double GetMinScale(const glm::dmat3 &m)
+  {
+    double scale;
+    if (GetUniformScale(m, scale)) return scale;
+
+    // the smallest singular value is at least 1 / |m^-1|, and the frobenius norm bounds the spectral norm from above
+    const glm::dmat3 inverse = glm::inverse(m);
+    double norm2 = 0;
+    for (int i = 0; i < 3; i++)
+    {
+      norm2 += glm::dot(inverse[i], inverse[i]);
+    }
+    return 1 / std::sqrt(norm2);
+  }
+
+  double GetMaxScale(const glm::dmat3 &m)
+  {
+    double scale;
+    if (GetUniformScale(m, scale)) return scale;
+
+    // the frobenius norm bounds the spectral norm from above, for any scale or shear
+    double norm2 = 0;
+    for (int i = 0; i < 3; i++)
+    {
+      norm2 += glm::dot(m[i], m[i]);
+    }
+    return std::sqrt(norm2);
+  }
+
+  void IfcSpatialIndex::Add(uint32_t expressID, uint32_t geometryExpressID, const IfcGeometry &geometry, const glm::dmat4 &transformation)
+  {
+    const Mesh *mesh = nullptr;
+    auto existing = _meshByGeometry.find(geometryExpressID);
+    if (existing != _meshByGeometry.end())
+    {
+      mesh = existing->second;
+    }
+    else
+    {
+      const size_t size = static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS;
+      auto newMesh = std::make_unique<Mesh>();
+      if (geometry.vertexData.size() == size)
+      {
+        newMesh->geometry.vertexData = geometry.vertexData;
+      }
+      else if (geometry.fvertexData.size() == size)
+      {
+        newMesh->geometry.vertexData.assign(geometry.fvertexData.begin(), geometry.fvertexData.end());
+      }
+      else
+      {
+        spdlog::warn("[SpatialIndex::Add()] vertices of geometry {} were released", geometryExpressID);
+        _meshByGeometry[geometryExpressID] = nullptr;
+        return;
+      }
+      newMesh->geometry.indexData = geometry.indexData;
+      newMesh->geometry.numPoints = geometry.numPoints;
+      newMesh->geometry.numFaces = geometry.numFaces;
+      newMesh->bvh = fuzzybools::MakeBVH(newMesh->geometry);
+      mesh = newMesh.get();
+      _meshes.push_back(std::move(newMesh));
+      _meshByGeometry[geometryExpressID] = mesh;
+    }
+
+    const glm::dmat3 linear(transformation);
+    const double determinant = glm::determinant(linear);
+    if (mesh == nullptr || mesh->geometry.numFaces == 0 || !std::isfinite(determinant) || determinant == 0)
+    {
+      return;
+    }
+    _instances.push_back({expressID, geometryExpressID, mesh, transformation, glm::inverse(transformation), GetMinScale(linear)});
+  }
+
+  void IfcSpatialIndex::Build()
+  {
+    _instanceBVH = fuzzybools::BVH();
+    _instanceBVH.ptr = nullptr;
+    _instanceBVH.boxes.resize(_instances.size());
+    for (size_t i = 0; i < _instances.size(); i++)
+    {
+      const auto &instance = _instances[i];
+      const auto &local = instance.mesh->bvh.box;
+      fuzzybools::AABB &box = _instanceBVH.boxes[i];
+      box.index = static_cast<uint32_t>(i);
+      for (int corner = 0; corner < 8; corner++)
+      {
+        const glm::dvec4 point((corner & 1) ? local.max.x : local.min.x, (corner & 2) ? local.max.y : local.min.y, (corner & 4) ? local.max.z : local.min.z, 1);
+        box.merge(glm::dvec3(instance.transformation * point));
+      }
+      box.center = (box.min + box.max) * 0.5;
+      _instanceBVH.box.merge(box);
+    }
+    if (!_instanceBVH.boxes.empty())
+    {
+      _instanceBVH.nodes.reserve(2 * (_instanceBVH.boxes.size() / fuzzybools::BVH_MIN_LEAF_SIZE) + 1);
+      fuzzybools::MakeBVH(_instanceBVH.boxes, _instanceBVH.nodes, 0, static_cast<uint32_t>(_instanceBVH.boxes.size()), 0);
+    }
+  }
+
+  void IfcSpatialIndex::Clear()
+  {
+    _meshes.clear();
+    _meshByGeometry.clear();
+    _instances.clear();
+    _instanceBVH = fuzzybools::BVH();
+  }
+
+  bool IfcSpatialIndex::IsEmpty() const
+  {
+    return _instanceBVH.nodes.empty();
+  }
+
+  std::optional<IfcRayHit> IfcSpatialIndex::RayCast(const glm::dvec3 &origin, const glm::dvec3 &direction, double maxDistance) const
+  {
+    const double length = glm::length(direction);
+    if (!(length > 0))
+    {
+      return std::nullopt;
+    }
+    // with a unit direction the ray parameter is the distance, an affine transformation keeps the parameter
+    const glm::dvec3 dir = direction / length;
+    std::optional<IfcRayHit> best;
+    double bestDistance = maxDistance;
+
+    _instanceBVH.IntersectRay(origin, dir, [&](uint32_t instanceIndex)
+    {
+      const auto &instance = _instances[instanceIndex];
+      const auto &geometry = instance.mesh->geometry;
+      const glm::dvec3 localOrigin = instance.inverse * glm::dvec4(origin, 1);
+      const glm::dvec3 localDir = glm::dmat3(instance.inverse) * dir;
+
+      instance.mesh->bvh.IntersectRay(localOrigin, localDir, [&](uint32_t face)
+      {
+        const glm::dvec3 a = geometry.GetPoint(geometry.indexData[face * 3 + 0]);
+        const glm::dvec3 b = geometry.GetPoint(geometry.indexData[face * 3 + 1]);
+        const glm::dvec3 c = geometry.GetPoint(geometry.indexData[face * 3 + 2]);
+        glm::dvec3 hitPosition;
+        double t, planeDistance;
+        if (fuzzybools::intersect_ray_triangle(localOrigin, localOrigin + localDir, a, b, c, hitPosition, t, planeDistance) && t >= 0 && t < bestDistance)
+        {
+          bestDistance = t;
+          const glm::dvec3 worldA = instance.transformation * glm::dvec4(a, 1);
+          const glm::dvec3 worldB = instance.transformation * glm::dvec4(b, 1);
+          const glm::dvec3 worldC = instance.transformation * glm::dvec4(c, 1);
+          const glm::dvec3 normal = glm::cross(worldB - worldA, worldC - worldA);
+          const double normalLength = glm::length(normal);
+          best = IfcRayHit{instance.expressID, instance.geometryExpressID, face, t, origin + dir * t, normalLength > 0 ? normal / normalLength : normal};
+        }
+        // all triangles along the ray are visited, the closest one wins
+        return false;
+      });
+      return false;
+    });
+
+    return best;
+  }
+
+  std::vector<uint32_t> IfcSpatialIndex::FrustumQuery(const std::vector<glm::dvec4> &planes) const
+  {
+    std::vector<uint32_t> expressIDs;
+    if (_instanceBVH.nodes.empty())
+    {
+      return expressIDs;
+    }
+    auto isOutside = [&](const fuzzybools::AABB &box)
+    {
+      for (const auto &plane : planes)
+      {
+        if (IsOutsidePlane(box, plane)) return true;
+      }
+      return false;
+    };
+
+    std::unordered_set<uint32_t> found;
+    std::array<uint32_t, fuzzybools::BVH_STACK_SIZE> stack;
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+      const auto &node = _instanceBVH.nodes[stack[--stackSize]];
+      if (isOutside(node.box))
+      {
+        continue;
+      }
+      if (node.IsLeaf())
+      {
+        for (uint32_t i = node.start; i < node.end; i++)
+        {
+          const auto &box = _instanceBVH.boxes[i];
+          const uint32_t expressID = _instances[box.index].expressID;
+          if (!isOutside(box) && found.insert(expressID).second)
+          {
+            expressIDs.push_back(expressID);
+          }
+        }
+      }
+      else
+      {
+        stack[stackSize++] = node.left;
+        stack[stackSize++] = node.right;
+      }
+    }
+    return expressIDs;
+  }
+
+  std::optional<IfcClosestPoint> IfcSpatialIndex::ClosestPoint(const glm::dvec3 &point, double maxDistance) const
+  {
+    std::optional<IfcClosestPoint> best;
+    double bestDistance = maxDistance;
+    if (_instanceBVH.nodes.empty())
+    {
+      return best;
+    }
+
+    auto visitInstance = [&](const Instance &instance)
+    {
+      const auto &geometry = instance.mesh->geometry;
+      const auto &bvh = instance.mesh->bvh;
+      const glm::dvec3 localPoint = instance.inverse * glm::dvec4(point, 1);
+
+      std::array<uint32_t, fuzzybools::BVH_STACK_SIZE> stack;
+      size_t stackSize = 0;
+      stack[stackSize++] = 0;
+      while (stackSize > 0)
+      {
+        const auto &node = bvh.nodes[stack[--stackSize]];
+        if (GetBoxDistance(node.box, localPoint) * instance.minScale >= bestDistance)
+        {
+          continue;
+        }
+        if (!node.IsLeaf())
+        {
+          stack[stackSize++] = node.left;
+          stack[stackSize++] = node.right;
+          continue;
+        }
+        for (uint32_t i = node.start; i < node.end; i++)
+        {
+          if (GetBoxDistance(bvh.boxes[i], localPoint) * instance.minScale >= bestDistance)
+          {
+            continue;
+          }
+          // measured in placed space, so placements that scale unevenly are measured right
+          const uint32_t face = bvh.boxes[i].index;
+          const glm::dvec3 a = instance.transformation * glm::dvec4(geometry.GetPoint(geometry.indexData[face * 3 + 0]), 1);
+          const glm::dvec3 b = instance.transformation * glm::dvec4(geometry.GetPoint(geometry.indexData[face * 3 + 1]), 1);
+          const glm::dvec3 c = instance.transformation * glm::dvec4(geometry.GetPoint(geometry.indexData[face * 3 + 2]), 1);
+          const glm::dvec3 closest = GetClosestPointOnTriangle(point, a, b, c);
+          const double distance = glm::length(closest - point);
+          if (distance < bestDistance)
+          {
+            bestDistance = distance;
+            best = IfcClosestPoint{instance.expressID, instance.geometryExpressID, face, distance, closest};
+          }
+        }
+      }
+    };
+
+    std::array<uint32_t, fuzzybools::BVH_STACK_SIZE> stack;
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+      const auto &node = _instanceBVH.nodes[stack[--stackSize]];
+      if (GetBoxDistance(node.box, point) >= bestDistance)
+      {
+        continue;
+      }
+      if (!node.IsLeaf())
+      {
+        // the nearer child is visited first, so the best distance shrinks early
+        const bool leftFirst = GetBoxDistance(_instanceBVH.nodes[node.left].box, point) <= GetBoxDistance(_instanceBVH.nodes[node.right].box, point);
+        stack[stackSize++] = leftFirst ? node.right : node.left;
+        stack[stackSize++] = leftFirst ? node.left : node.right;
+        continue;
+      }
+      for (uint32_t i = node.start; i < node.end; i++)
+      {
+        const auto &box = _instanceBVH.boxes[i];
+        if (GetBoxDistance(box, point) < bestDistance)
+        {
+          visitInstance(_instances[box.index]);
+        }
+      }
+    }
+    return best;
+  }
+}
@@ -0,0 +1,89 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "representation/IfcGeometry.h"
+#include "operations/boolean-utils/bvh.h"
+
+namespace webifc::geometry
+{
+
+  struct IfcRayHit
+  {
+    uint32_t expressID;
+    uint32_t geometryExpressID;
+    uint32_t faceIndex;
+    // from the ray origin
+    double distance;
+    glm::dvec3 position;
+    glm::dvec3 normal;
+  };
+
+  struct IfcClosestPoint
+  {
+    uint32_t expressID;
+    uint32_t geometryExpressID;
+    uint32_t faceIndex;
+    double distance;
+    glm::dvec3 position;
+  };
+
+  // no vector gets shorter than by this factor under m, exact for rotations with a uniform scale and a lower bound
+  // otherwise
+  double GetMinScale(const glm::dmat3 &m);
+  // no vector gets longer than by this factor under m, exact for rotations with a uniform scale and an upper bound
+  // otherwise
+  double GetMaxScale(const glm::dmat3 &m);
+
+  // a two level index for picking and measuring: every geometry gets a triangle BVH of its own, shared by all its
+  // placements, and the placements get a BVH over their boxes. Queries are in the space of the placements, call Build
+  // after the last Add and before querying
+  class IfcSpatialIndex
+  {
+  public:
+    // the geometry is copied the first time its geometryExpressID is added, later placements share the copy
+    void Add(uint32_t expressID, uint32_t geometryExpressID, const IfcGeometry &geometry, const glm::dmat4 &transformation);
+    void Build();
+    void Clear();
+    bool IsEmpty() const;
+    // the first triangle hit by the ray from origin along direction within maxDistance, triangles are hit from both sides
+    std::optional<IfcRayHit> RayCast(const glm::dvec3 &origin, const glm::dvec3 &direction, double maxDistance = std::numeric_limits<double>::infinity()) const;
+    // the elements whose placed boxes are not fully outside one of the planes, a plane keeps what has
+    // dot(normal, p) + d >= 0 with the plane given as (normal, d)
+    std::vector<uint32_t> FrustumQuery(const std::vector<glm::dvec4> &planes) const;
+    // the closest point on any triangle within maxDistance of point
+    std::optional<IfcClosestPoint> ClosestPoint(const glm::dvec3 &point, double maxDistance = std::numeric_limits<double>::infinity()) const;
+
+  private:
+    struct Mesh
+    {
+      fuzzybools::Geometry geometry;
+      fuzzybools::BVH bvh;
+    };
+    struct Instance
+    {
+      uint32_t expressID;
+      uint32_t geometryExpressID;
+      const Mesh *mesh;
+      glm::dmat4 transformation;
+      glm::dmat4 inverse;
+      // no vector gets shorter than by this factor under the transformation, bounds local distances from below
+      double minScale;
+    };
+    std::vector<std::unique_ptr<Mesh>> _meshes;
+    std::unordered_map<uint32_t, const Mesh *> _meshByGeometry;
+    std::vector<Instance> _instances;
+    // over the placed boxes of the instances, the box index is the instance
+    fuzzybools::BVH _instanceBVH;
+  };
+}
@@ -0,0 +1,198 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include "IfcTileset.h"
+
+namespace webifc::geometry
+{
+
+  namespace
+  {
+    void AppendNumber(std::string &json, double value)
+    {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.17g", std::isfinite(value) ? value : 0.0);
+      json += buffer;
+    }
+
+    double GetDiagonal(const glm::dvec3 &min, const glm::dvec3 &max)
+    {
+      return glm::length(max - min);
+    }
+  }
+
+  void IfcTileset::Build(const std::vector<IfcElementBox> &boxes, uint32_t maxElementsPerTile, uint32_t maxDepth)
+  {
+    _boxes.clear();
+    _tiles.clear();
+    _maxElementsPerTile = std::max<uint32_t>(maxElementsPerTile, 1);
+    _maxDepth = maxDepth;
+    std::vector<uint32_t> items;
+    for (const auto &box : boxes)
+    {
+      if (box.min.x <= box.max.x && box.min.y <= box.max.y && box.min.z <= box.max.z)
+      {
+        items.push_back(static_cast<uint32_t>(_boxes.size()));
+        _boxes.push_back(box);
+      }
+    }
+    if (items.empty())
+    {
+      return;
+    }
+    _tiles.emplace_back();
+    split(0, items, 0);
+  }
+
+  void IfcTileset::split(uint32_t tile, std::vector<uint32_t> &items, uint32_t depth)
+  {
+    glm::dvec3 min(DBL_MAX);
+    glm::dvec3 max(-DBL_MAX);
+    for (uint32_t item : items)
+    {
+      min = glm::min(min, _boxes[item].min);
+      max = glm::max(max, _boxes[item].max);
+    }
+    _tiles[tile].min = min;
+    _tiles[tile].max = max;
+
+    std::vector<uint32_t> elements;
+    std::vector<uint32_t> octants[8];
+    if (items.size() <= _maxElementsPerTile || depth >= _maxDepth)
+    {
+      elements = std::move(items);
+    }
+    else
+    {
+      const glm::dvec3 center = (min + max) / 2.0;
+      const glm::dvec3 half = (max - min) / 2.0;
+      for (uint32_t item : items)
+      {
+        const IfcElementBox &box = _boxes[item];
+        const glm::dvec3 extent = box.max - box.min;
+        if (extent.x > half.x || extent.y > half.y || extent.z > half.z)
+        {
+          elements.push_back(item);
+          continue;
+        }
+        const glm::dvec3 boxCenter = (box.min + box.max) / 2.0;
+        const int octant = (boxCenter.x > center.x ? 1 : 0) | (boxCenter.y > center.y ? 2 : 0) | (boxCenter.z > center.z ? 4 : 0);
+        octants[octant].push_back(item);
+      }
+    }
+
+    double geometricError = 0;
+    for (auto &octant : octants)
+    {
+      if (octant.empty())
+      {
+        continue;
+      }
+      const uint32_t child = static_cast<uint32_t>(_tiles.size());
+      _tiles.emplace_back();
+      _tiles[tile].children.push_back(child);
+      for (uint32_t item : octant)
+      {
+        geometricError = std::max(geometricError, GetDiagonal(_boxes[item].min, _boxes[item].max));
+      }
+      split(child, octant, depth + 1);
+      geometricError = std::max(geometricError, _tiles[child].geometricError);
+    }
+
+    Tile &result = _tiles[tile];
+    result.geometricError = geometricError;
+    result.elements.reserve(elements.size());
+    for (uint32_t item : elements)
+    {
+      result.elements.push_back(_boxes[item].expressID);
+    }
+  }
+
+  const std::vector<IfcTileset::Tile> &IfcTileset::GetTiles() const
+  {
+    return _tiles;
+  }
+
+  std::string IfcTileset::GetTilesetJson(const std::function<std::string(uint32_t)> &contentUri) const
+  {
+    std::string json = "{\"asset\":{\"version\":\"1.1\",\"generator\":\"web-ifc\"},\"geometricError\":";
+    if (_tiles.empty())
+    {
+      json += "0}";
+      return json;
+    }
+    AppendNumber(json, std::max(_tiles[0].geometricError, GetDiagonal(_tiles[0].min, _tiles[0].max)));
+    json += ",\"root\":";
+    appendTile(json, 0, contentUri);
+    json += '}';
+    return json;
+  }
+
+  void IfcTileset::appendTile(std::string &json, uint32_t tile, const std::function<std::string(uint32_t)> &contentUri) const
+  {
+    const Tile &t = _tiles[tile];
+    // y up to z up: (x, y, z) becomes (x, -z, y)
+    const glm::dvec3 center = (t.min + t.max) / 2.0;
+    const glm::dvec3 half = (t.max - t.min) / 2.0;
+    const double box[12] = {center.x, -center.z, center.y, half.x, 0, 0, 0, half.z, 0, 0, 0, half.y};
+    json += "{\"boundingVolume\":{\"box\":[";
+    for (int i = 0; i < 12; i++)
+    {
+      if (i > 0) json += ',';
+      AppendNumber(json, box[i]);
+    }
+    json += "]},\"geometricError\":";
+    AppendNumber(json, t.geometricError);
+    json += ",\"refine\":\"ADD\"";
+    if (!t.elements.empty())
+    {
+      json += ",\"content\":{\"uri\":\"" + contentUri(tile) + "\"}";
+    }
+    if (!t.children.empty())
+    {
+      json += ",\"children\":[";
+      for (size_t i = 0; i < t.children.size(); i++)
+      {
+        if (i > 0) json += ',';
+        appendTile(json, t.children[i], contentUri);
+      }
+      json += ']';
+    }
+    json += '}';
+  }
+
+  bool IfcTileset::GetPlacedBox(const IfcGeometry &geometry, const glm::dmat4 &transformation, glm::dvec3 &min, glm::dvec3 &max)
+  {
+    const size_t vertexSize = static_cast<size_t>(geometry.numPoints) * VERTEX_FORMAT_SIZE_FLOATS;
+    const bool useDoubles = geometry.vertexData.size() == vertexSize;
+    const bool useFloats = !useDoubles && geometry.fvertexData.size() == vertexSize;
+    if (geometry.numPoints == 0 || (!useDoubles && !useFloats))
+    {
+      return false;
+    }
+    glm::dvec3 localMin(DBL_MAX);
+    glm::dvec3 localMax(-DBL_MAX);
+    for (size_t i = 0; i < vertexSize; i += VERTEX_FORMAT_SIZE_FLOATS)
+    {
+      const glm::dvec3 point = useDoubles ? glm::dvec3(geometry.vertexData[i], geometry.vertexData[i + 1], geometry.vertexData[i + 2])
+                                          : glm::dvec3(geometry.fvertexData[i], geometry.fvertexData[i + 1], geometry.fvertexData[i + 2]);
+      localMin = glm::min(localMin, point);
+      localMax = glm::max(localMax, point);
+    }
+    // the corners of the local box are placed, which is tight for translations and rotations by right angles
+    for (int corner = 0; corner < 8; corner++)
+    {
+      const glm::dvec3 local((corner & 1) ? localMax.x : localMin.x, (corner & 2) ? localMax.y : localMin.y, (corner & 4) ? localMax.z : localMin.z);
+      const glm::dvec3 placed = glm::dvec3(transformation * glm::dvec4(local, 1));
+      min = glm::min(min, placed);
+      max = glm::max(max, placed);
+    }
+    return true;
+  }
+
+}
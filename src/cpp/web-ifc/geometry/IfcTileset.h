@@ -0,0 +1,62 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "representation/IfcGeometry.h"
+
+namespace webifc::geometry
+{
+
+  struct IfcElementBox
+  {
+    uint32_t expressID;
+    glm::dvec3 min;
+    glm::dvec3 max;
+  };
+
+  // a loose octree over the boxes of elements for 3D Tiles with additive refinement: a tile is split into the octants of
+  // its box while it has more than maxElementsPerTile elements, elements larger than an octant stay in the tile. Boxes
+  // are in the space of the flat meshes
+  class IfcTileset
+  {
+  public:
+    struct Tile
+    {
+      // tight around the elements of the tile and its children
+      glm::dvec3 min;
+      glm::dvec3 max;
+      // the largest box diagonal of the elements below the tile, which are missing while its children are not drawn, 0
+      // for leaves
+      double geometricError = 0;
+      std::vector<uint32_t> elements;
+      std::vector<uint32_t> children;
+    };
+
+    // elements with empty boxes are left out
+    void Build(const std::vector<IfcElementBox> &boxes, uint32_t maxElementsPerTile, uint32_t maxDepth = 12);
+    // the root first, empty when there were no boxes
+    const std::vector<Tile> &GetTiles() const;
+    // the tileset of 3D Tiles 1.1, tiles with elements get the content at contentUri(tile). The content is taken to be y
+    // up glTF like the flat meshes, so the bounding volumes are turned z up as 3D Tiles expects
+    std::string GetTilesetJson(const std::function<std::string(uint32_t)> &contentUri) const;
+    // the box of the geometry's vertices under transformation, false for geometries without double or float vertices
+    static bool GetPlacedBox(const IfcGeometry &geometry, const glm::dmat4 &transformation, glm::dvec3 &min, glm::dvec3 &max);
+
+  private:
+    void split(uint32_t tile, std::vector<uint32_t> &items, uint32_t depth);
+    void appendTile(std::string &json, uint32_t tile, const std::function<std::string(uint32_t)> &contentUri) const;
+
+    std::vector<IfcElementBox> _boxes;
+    std::vector<Tile> _tiles;
+    uint32_t _maxElementsPerTile = 0;
+    uint32_t _maxDepth = 0;
+  };
+
+}
@@ -3,6 +3,8 @@
 #include "representation/geometry.h"
 #include "nurbs.h"
 #include "operations/geometryutils.h"
+#include "../utility/parallel.h"
+#include "../utility/trace.h"
 #include <tinynurbs/tinynurbs.h>
 #include <CDT.h>
 #include <numeric>
@@ -10,7 +12,13 @@
 
 namespace webifc::geometry{
 
+	// samples per direction of the grid that seeds the inverse projections
+	constexpr size_t SEED_GRID_SIZE {16};
+	// surface points evaluated per task when the tessellation is evaluated in parallel
+	constexpr size_t EVALUATION_CHUNK_SIZE {1024};
+
 	void Nurbs::fill_geometry(){
+		WEBIFC_TRACE_SCOPE("Nurbs::fill_geometry");
 		if (!_initialized) {
 			return;
 		}
@@ -59,15 +67,18 @@ namespace webifc::geometry{
 			indices = newIndices;
 		}
 
+		// every uv point is shared by several triangles, evaluate each once
+		std::vector<glm::dvec3> surface_points(uv_points.size());
+		auto const num_chunks {(uv_points.size() + EVALUATION_CHUNK_SIZE - 1) / EVALUATION_CHUNK_SIZE};
+		utility::ParallelFor(num_chunks, utility::GetThreadCount(), [&](size_t chunk){
+			auto const end {std::min(uv_points.size(), (chunk + 1) * EVALUATION_CHUNK_SIZE)};
+			for (size_t i = chunk * EVALUATION_CHUNK_SIZE; i < end; i++)
+				surface_points[i] = tinynurbs::surfacePoint(*this->nurbs, uv_points[i].x, uv_points[i].y);
+		});
+
 		for (size_t i = 0; i < indices.size(); i += 3)
 		{
-			auto const& p0 {uv_points[indices[i + 0]]};
-			auto const& p1 {uv_points[indices[i + 1]]};
-			auto const& p2 {uv_points[indices[i + 2]]};
-			auto pt00 {tinynurbs::surfacePoint(*this->nurbs, p0.x, p0.y)};
-			auto pt01 {tinynurbs::surfacePoint(*this->nurbs, p1.x, p1.y)};
-			auto pt10 {tinynurbs::surfacePoint(*this->nurbs, p2.x, p2.y)};
-			geometry.AddFace(pt00, pt01, pt10);
+			geometry.AddFace(surface_points[indices[i + 0]], surface_points[indices[i + 1]], surface_points[indices[i + 2]]);
 		}
 	}	
 
@@ -189,8 +200,33 @@ namespace webifc::geometry{
 		// Scale error tolerances.
 		this->minError /= this->scaling;
 		this->maxError /= this->scaling;
+		this->init_seeds();
 		_initialized = true;
 	}
+	void Nurbs::init_seeds() {
+		this->seed_points.reserve((SEED_GRID_SIZE + 1) * (SEED_GRID_SIZE + 1));
+		this->seed_uvs.reserve((SEED_GRID_SIZE + 1) * (SEED_GRID_SIZE + 1));
+		for (size_t i = 0; i <= SEED_GRID_SIZE; i++) {
+			auto const u {this->range_knots_u.x + (this->range_knots_u.y - this->range_knots_u.x) * i / SEED_GRID_SIZE};
+			for (size_t j = 0; j <= SEED_GRID_SIZE; j++) {
+				auto const v {this->range_knots_v.x + (this->range_knots_v.y - this->range_knots_v.x) * j / SEED_GRID_SIZE};
+				this->seed_points.push_back(tinynurbs::surfacePoint(*this->nurbs, u, v));
+				this->seed_uvs.emplace_back(u, v);
+			}
+		}
+	}
+	Nurbs::uv_point_t Nurbs::get_seed(glm::dvec3 const& pt) const {
+		uv_point_t seed {0.5, 0.5};
+		auto min_distance = std::numeric_limits<double>::max();
+		for (size_t i = 0; i < this->seed_points.size(); i++) {
+			auto const distance {glm::distance(this->seed_points[i], pt)};
+			if (distance < min_distance) {
+				min_distance = distance;
+				seed = this->seed_uvs[i];
+			}
+		}
+		return seed;
+	}
 	std::vector<double> Nurbs::get_weights() const{
 		std::vector<double> result(this->num_u * this->num_v);
 		std::fill(result.begin(), result.end(), 1.0);
@@ -226,11 +262,9 @@ namespace webifc::geometry{
 		auto const& bound_points {this->bounds.front().curve.points};
 		size_t num_points{bound_points.size()};
 		points.resize(num_points);
-		auto count{0};
-		std::transform(bound_points.begin(), bound_points.end(), points.begin(), [&](auto const& point){
-			++count;
-			auto uv {this->inverse_evaluation(point)};
-			return Nurbs::uv_point_t{uv.x, uv.y};				
+		// the projections are independent of each other
+		utility::ParallelFor(num_points, utility::GetThreadCount(), [&](size_t i){
+			points[i] = this->inverse_evaluation(bound_points[i]);
 		});
 		std::sort(points.begin(), points.end(),[](auto const& left, auto const& right){
 			  if (left[0] != right[0]) return left[0] < right[0];
@@ -283,8 +317,9 @@ namespace webifc::geometry{
 	{
 		spdlog::debug("[InverseMethod({})]");
 		glm::highp_dvec3 pt00{};
-		double fU {0.5};
-		double fV {0.5};
+		auto const seed {this->get_seed(pt)};
+		double fU {seed.x};
+		double fV {seed.y};
 		// auto [max_distance, fU, fV, new_range_u, new_range_v] {this->get_approximation(pt, this->range_knots_u, this->range_knots_v)};
 		// if(max_distance <= maxError) return {fU, fV};
 		// auto previous_distance{max_distance};
@@ -302,9 +337,12 @@ namespace webifc::geometry{
 		
 		size_t count{0};
 		double divisor {100.0};
-		auto max_distance = std::numeric_limits<double>::max();
-		while (max_distance > maxError && divisor < 10000)
+		auto max_distance = glm::distance(tinynurbs::surfacePoint(*this->nurbs, fU, fV), pt);
+		// the first pass always runs, it refines the seed down to minError
+		bool first_pass {true};
+		while ((first_pass || max_distance > maxError) && divisor < 10000)
 		{
+			first_pass = false;
 			for (double r = 1; r < 5; r++)
 			{
 				int round = 0;
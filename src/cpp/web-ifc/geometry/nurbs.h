@@ -41,6 +41,8 @@ namespace webifc::geometry{
 		uv_points_t get_uv_points() const;
 		uv_point_t inverse_evaluation(glm::dvec3 const& pt) const;
 		uv_point_t inverse_method(glm::dvec3 const& pt) const;
+		void init_seeds();
+		uv_point_t get_seed(glm::dvec3 const& pt) const;
 		std::vector<uint32_t> get_triangulation_uv_points(uv_points_t const& uv_points) const;
 		std::vector<double> get_zscores(std::vector<double> const& knots) const;
 		std::vector<double> check_knots(std::vector<double> const& knots) const;
@@ -64,5 +66,8 @@ namespace webifc::geometry{
 		double dv{0.0};
 		double pr{0.0};
 		bool _initialized = false;
+		// a coarse grid of surface samples, the inverse projection starts from the one closest to the point
+		std::vector<glm::dvec3> seed_points;
+		uv_points_t seed_uvs;
 	};
 }
\ No newline at end of file
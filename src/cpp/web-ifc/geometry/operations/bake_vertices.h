@@ -0,0 +1,86 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Vectorised transformation of vertices into the output buffer, 4 or 2 doubles per step with a scalar fallback
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace webifc::geometry
+{
+
+	// result = ((m[0] * v.x + m[1] * v.y) + m[2] * v.z) + translation, translation is m[3] for positions and 0 for normals
+	inline void TransformColumns(const glm::dmat4 &m, const double x, const double y, const double z, const bool translate, double result[3])
+	{
+#if defined(__AVX__)
+		__m256d sum = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&m[0][0]), _mm256_set1_pd(x)), _mm256_mul_pd(_mm256_loadu_pd(&m[1][0]), _mm256_set1_pd(y)));
+		sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_loadu_pd(&m[2][0]), _mm256_set1_pd(z)));
+		if (translate) sum = _mm256_add_pd(sum, _mm256_loadu_pd(&m[3][0]));
+		alignas(32) double lanes[4];
+		_mm256_store_pd(lanes, sum);
+		result[0] = lanes[0];
+		result[1] = lanes[1];
+		result[2] = lanes[2];
+#elif defined(__SSE2__) || defined(_M_X64)
+		__m128d sum = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&m[0][0]), _mm_set1_pd(x)), _mm_mul_pd(_mm_loadu_pd(&m[1][0]), _mm_set1_pd(y)));
+		sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(&m[2][0]), _mm_set1_pd(z)));
+		if (translate) sum = _mm_add_pd(sum, _mm_loadu_pd(&m[3][0]));
+		_mm_storeu_pd(result, sum);
+		result[2] = (m[0][2] * x + m[1][2] * y) + m[2][2] * z;
+		if (translate) result[2] += m[3][2];
+#elif defined(__wasm_simd128__)
+		v128_t sum = wasm_f64x2_add(wasm_f64x2_mul(wasm_v128_load(&m[0][0]), wasm_f64x2_splat(x)), wasm_f64x2_mul(wasm_v128_load(&m[1][0]), wasm_f64x2_splat(y)));
+		sum = wasm_f64x2_add(sum, wasm_f64x2_mul(wasm_v128_load(&m[2][0]), wasm_f64x2_splat(z)));
+		if (translate) sum = wasm_f64x2_add(sum, wasm_v128_load(&m[3][0]));
+		wasm_v128_store(result, sum);
+		result[2] = (m[0][2] * x + m[1][2] * y) + m[2][2] * z;
+		if (translate) result[2] += m[3][2];
+#else
+		for (int i = 0; i < 3; i++)
+		{
+			result[i] = (m[0][i] * x + m[1][i] * y) + m[2][i] * z;
+			if (translate) result[i] += m[3][i];
+		}
+#endif
+	}
+
+	// count vertices of 6 values, position then normal, transformed into 6 floats each at output: the positions by
+	// transformation and the normals by its inverse transpose, normalized. The positions are rounded to float once they
+	// are placed, so coordinates far from the origin keep what a float can hold of them
+	template <typename T>
+	void BakeVertices(const T *vertices, const size_t count, const glm::dmat4 &transformation, float *output)
+	{
+		const glm::dmat3 inverseTranspose = glm::transpose(glm::inverse(glm::dmat3(transformation)));
+		const glm::dmat4 normalMatrix(glm::dvec4(inverseTranspose[0], 0), glm::dvec4(inverseTranspose[1], 0), glm::dvec4(inverseTranspose[2], 0), glm::dvec4(0, 0, 0, 1));
+		double position[3];
+		double normal[3];
+		for (size_t i = 0; i < count; i++)
+		{
+			const T *vertex = vertices + i * 6;
+			TransformColumns(transformation, vertex[0], vertex[1], vertex[2], true, position);
+			TransformColumns(normalMatrix, vertex[3], vertex[4], vertex[5], false, normal);
+			const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			const double scale = length > 0 ? 1 / length : 1;
+			float *out = output + i * 6;
+			out[0] = static_cast<float>(position[0]);
+			out[1] = static_cast<float>(position[1]);
+			out[2] = static_cast<float>(position[2]);
+			out[3] = static_cast<float>(normal[0] * scale);
+			out[4] = static_cast<float>(normal[1] * scale);
+			out[5] = static_cast<float>(normal[2] * scale);
+		}
+	}
+
+}
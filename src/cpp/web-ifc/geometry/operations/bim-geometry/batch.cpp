@@ -0,0 +1,282 @@
+#include <vector>
+#include <cmath>
+#include <string>
+#include "batch.h"
+#include "aabb.h"
+#include "extrusion.h"
+#include "sweep.h"
+#include "circularSweep.h"
+#include "revolution.h"
+#include "cylindricalRevolution.h"
+#include "parabola.h"
+#include "clothoid.h"
+#include "arc.h"
+#include "alignment.h"
+#include "boolean.h"
+#include "profile.h"
+
+namespace bimGeometry {
+
+    namespace
+    {
+        struct BatchReader
+        {
+            const std::vector<double> &packed;
+            size_t position = 0;
+            bool valid = true;
+
+            double Number()
+            {
+                if (position >= packed.size())
+                {
+                    valid = false;
+                    return 0;
+                }
+                return packed[position++];
+            }
+
+            bool Bool()
+            {
+                return Number() != 0;
+            }
+
+            uint32_t Count()
+            {
+                const double count = Number();
+                if (!(count >= 0) || count != std::floor(count) || count > packed.size() - position)
+                {
+                    valid = false;
+                    return 0;
+                }
+                return static_cast<uint32_t>(count);
+            }
+
+            // the length, then the values, of a fixed length when size is not 0
+            std::vector<double> Array(size_t size = 0)
+            {
+                const uint32_t count = Count();
+                if (!valid || (size != 0 && count != size))
+                {
+                    valid = false;
+                    return {};
+                }
+                std::vector<double> values(packed.begin() + position, packed.begin() + position + count);
+                position += count;
+                return values;
+            }
+        };
+
+        template <typename Primitive>
+        std::function<Buffers()> Generate(Primitive primitive)
+        {
+            return [primitive]() mutable
+            { return primitive.GetBuffers(); };
+        }
+
+        std::function<Buffers()> ReadItem(BatchReader &reader)
+        {
+            const double number = reader.Number();
+            if (!(number >= 0 && number <= static_cast<double>(BatchKind::PROFILE)) || number != std::floor(number))
+            {
+                return {};
+            }
+            const BatchKind kind = static_cast<BatchKind>(static_cast<uint32_t>(number));
+            switch (kind)
+            {
+            case BatchKind::AABB:
+            {
+                AABB aabb;
+                const double minX = reader.Number(), minY = reader.Number(), minZ = reader.Number();
+                const double maxX = reader.Number(), maxY = reader.Number(), maxZ = reader.Number();
+                aabb.SetValues(minX, minY, minZ, maxX, maxY, maxZ);
+                return Generate(aabb);
+            }
+            case BatchKind::EXTRUSION:
+            {
+                Extrusion extrusion;
+                auto profile = reader.Array();
+                auto dir = reader.Array();
+                const double len = reader.Number();
+                auto cuttingPlaneNormal = reader.Array(3);
+                auto cuttingPlanePos = reader.Array(3);
+                const bool cap = reader.Bool();
+                if (!reader.valid) return {};
+                extrusion.SetValues(profile, dir, len, cuttingPlaneNormal, cuttingPlanePos, cap);
+                extrusion.ClearHoles();
+                const uint32_t holes = reader.Count();
+                for (uint32_t i = 0; i < holes && reader.valid; i++)
+                {
+                    extrusion.SetHoles(reader.Array());
+                }
+                return Generate(extrusion);
+            }
+            case BatchKind::SWEEP:
+            {
+                Sweep sweep;
+                const double scaling = reader.Number();
+                const bool closed = reader.Bool();
+                auto profilePoints = reader.Array();
+                auto directrix = reader.Array();
+                auto initialDirectrixNormal = reader.Array(3);
+                const bool rotate90 = reader.Bool();
+                const bool optimize = reader.Bool();
+                if (!reader.valid) return {};
+                sweep.SetValues(scaling, closed, profilePoints, directrix, initialDirectrixNormal, rotate90, optimize);
+                return Generate(sweep);
+            }
+            case BatchKind::CIRCULAR_SWEEP:
+            {
+                CircularSweep sweep;
+                const double scaling = reader.Number();
+                const bool closed = reader.Bool();
+                auto profilePoints = reader.Array();
+                const double radius = reader.Number();
+                auto directrix = reader.Array();
+                auto initialDirectrixNormal = reader.Array(3);
+                const bool rotate90 = reader.Bool();
+                if (!reader.valid) return {};
+                sweep.SetValues(scaling, closed, profilePoints, radius, directrix, initialDirectrixNormal, rotate90);
+                return Generate(sweep);
+            }
+            case BatchKind::REVOLUTION:
+            {
+                Revolve revolution;
+                auto profile = reader.Array();
+                auto transform = reader.Array(16);
+                const double startDegrees = reader.Number();
+                const double endDegrees = reader.Number();
+                const double numRots = reader.Number();
+                if (!reader.valid) return {};
+                revolution.SetValues(profile, transform, startDegrees, endDegrees, static_cast<uint32_t>(numRots));
+                return Generate(revolution);
+            }
+            case BatchKind::CYLINDRICAL_REVOLUTION:
+            {
+                CylindricalRevolution revolution;
+                auto transform = reader.Array(16);
+                const double startDegrees = reader.Number();
+                const double endDegrees = reader.Number();
+                const double minZ = reader.Number();
+                const double maxZ = reader.Number();
+                const double numRots = reader.Number();
+                const double radius = reader.Number();
+                if (!reader.valid) return {};
+                revolution.SetValues(transform, startDegrees, endDegrees, minZ, maxZ, numRots, radius);
+                return Generate(revolution);
+            }
+            case BatchKind::PARABOLA:
+            case BatchKind::CLOTHOID:
+            {
+                double values[8];
+                for (double &value : values)
+                {
+                    value = reader.Number();
+                }
+                if (!reader.valid) return {};
+                if (kind == BatchKind::PARABOLA)
+                {
+                    Parabola parabola;
+                    parabola.SetValues(static_cast<uint16_t>(values[0]), values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+                    return Generate(parabola);
+                }
+                Clothoid clothoid;
+                clothoid.SetValues(static_cast<uint16_t>(values[0]), values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+                return Generate(clothoid);
+            }
+            case BatchKind::ARC:
+            {
+                Arc arc;
+                const double radiusX = reader.Number();
+                const double radiusY = reader.Number();
+                const double numSegments = reader.Number();
+                auto placement = reader.Array();
+                const double startRad = reader.Number();
+                const double endRad = reader.Number();
+                const bool swap = reader.Bool();
+                const bool normalToCenterEnding = reader.Bool();
+                if (!reader.valid) return {};
+                arc.SetValues(radiusX, radiusY, static_cast<int>(numSegments), placement, startRad, endRad, swap, normalToCenterEnding);
+                return Generate(arc);
+            }
+            case BatchKind::ALIGNMENT:
+            {
+                Alignment alignment;
+                auto horizontal = reader.Array();
+                auto vertical = reader.Array();
+                if (!reader.valid) return {};
+                alignment.SetValues(horizontal, vertical);
+                return Generate(alignment);
+            }
+            case BatchKind::BOOLEAN:
+            {
+                Boolean boolean;
+                const double op = reader.Number();
+                auto triangles = reader.Array();
+                if (!reader.valid || (op != 0 && op != 1)) return {};
+                boolean.clear();
+                boolean.SetValues(triangles, op == 0 ? "DIFFERENCE" : "UNION");
+                const uint32_t seconds = reader.Count();
+                for (uint32_t i = 0; i < seconds && reader.valid; i++)
+                {
+                    boolean.SetSecond(reader.Array());
+                }
+                return Generate(boolean);
+            }
+            case BatchKind::PROFILE:
+            {
+                Profile profile;
+                double values[10];
+                for (double &value : values)
+                {
+                    value = reader.Number();
+                }
+                auto placement = reader.Array(16);
+                if (!reader.valid) return {};
+                profile.SetValues(static_cast<uint16_t>(values[0]), values[1], values[2], values[3], values[4], values[5] != 0, values[6], values[7], values[8], static_cast<uint16_t>(values[9]), placement);
+                return Generate(profile);
+            }
+            }
+            return {};
+        }
+    }
+
+    bool ReadBatch(const std::vector<double> &packed, std::vector<std::function<Buffers()>> &items)
+    {
+        BatchReader reader{packed};
+        while (reader.position < packed.size())
+        {
+            auto item = ReadItem(reader);
+            if (!item || !reader.valid)
+            {
+                return false;
+            }
+            items.push_back(std::move(item));
+        }
+        return true;
+    }
+
+    BatchBuffers JoinBatchBuffers(const std::vector<Buffers> &buffers)
+    {
+        BatchBuffers batch;
+        size_t vertexFloats = 0;
+        size_t indices = 0;
+        for (const auto &item : buffers)
+        {
+            vertexFloats += item.fvertexData.size();
+            indices += item.indexData.size();
+        }
+        batch.fvertexData.reserve(vertexFloats);
+        batch.indexData.reserve(indices);
+        batch.ranges.reserve(buffers.size() * 4);
+        for (const auto &item : buffers)
+        {
+            batch.ranges.push_back(batch.fvertexData.size());
+            batch.ranges.push_back(item.fvertexData.size());
+            batch.ranges.push_back(batch.indexData.size());
+            batch.ranges.push_back(item.indexData.size());
+            batch.fvertexData.insert(batch.fvertexData.end(), item.fvertexData.begin(), item.fvertexData.end());
+            batch.indexData.insert(batch.indexData.end(), item.indexData.begin(), item.indexData.end());
+        }
+        return batch;
+    }
+}
@@ -0,0 +1,54 @@
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "buffers.h"
+
+#pragma once
+
+namespace bimGeometry {
+
+    // the primitives of a packed batch. Every item is its kind followed by the arguments of the primitive's SetValues in
+    // order, numbers as they are, bools as 0 or 1 and arrays as their length followed by their values:
+    //  AABB: minX, minY, minZ, maxX, maxY, maxZ
+    //  EXTRUSION: profile[], dir[], len, cuttingPlaneNormal[], cuttingPlanePos[], cap, holeCount, hole[] for each hole
+    //  SWEEP: scaling, closed, profilePoints[], directrix[], initialDirectrixNormal[], rotate90, optimize
+    //  CIRCULAR_SWEEP: scaling, closed, profilePoints[], radius, directrix[], initialDirectrixNormal[], rotate90
+    //  REVOLUTION: profile[], transform[], startDegrees, endDegrees, numRots
+    //  CYLINDRICAL_REVOLUTION: transform[], startDegrees, endDegrees, minZ, maxZ, numRots, radius
+    //  PARABOLA: segments, startPointX, startPointY, startPointZ, horizontalLength, startHeight, startGradient, endGradient
+    //  CLOTHOID: segments, startPointX, startPointY, startPointZ, startDirection, startRadius, endRadius, segmentLength
+    //  ARC: radiusX, radiusY, numSegments, placement[], startRad, endRad, swap, normalToCenterEnding
+    //  ALIGNMENT: horizontal[], vertical[]
+    //  BOOLEAN: op (0 difference, 1 union), triangles[], secondCount, triangles[] for each second operand
+    //  PROFILE: pType, width, depth, webThickness, flangeThickness, hasFillet, filletRadius, radius, slope, numSegments, placement[]
+    enum class BatchKind : uint32_t
+    {
+        AABB = 0,
+        EXTRUSION,
+        SWEEP,
+        CIRCULAR_SWEEP,
+        REVOLUTION,
+        CYLINDRICAL_REVOLUTION,
+        PARABOLA,
+        CLOTHOID,
+        ARC,
+        ALIGNMENT,
+        BOOLEAN,
+        PROFILE
+    };
+
+    // the buffers of all items one after the other, the indices of an item count from its own first vertex. ranges holds
+    // for every item the first float of its vertices, their float count, its first index and the index count
+    struct BatchBuffers
+    {
+        std::vector<float> fvertexData;
+        std::vector<uint32_t> indexData;
+        std::vector<uint32_t> ranges;
+    };
+
+    // reads the items of packed into a GetBuffers call each, which may run on any thread. False when packed is not a
+    // sequence of complete items, items then holds those read before
+    bool ReadBatch(const std::vector<double> &packed, std::vector<std::function<Buffers()>> &items);
+    // the buffers in item order
+    BatchBuffers JoinBatchBuffers(const std::vector<Buffers> &buffers);
+}
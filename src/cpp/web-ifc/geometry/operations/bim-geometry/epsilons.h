@@ -3,9 +3,15 @@
 namespace bimGeometry
 {
 
-    inline double _TOLERANCE_SCALAR_EQUALITY = 1.0E-04;
-    inline double _PLANE_REFIT_ITERATIONS = 1;
-    inline double _BOOLEAN_UNION_THRESHOLD = 150;
+    inline thread_local double _TOLERANCE_SCALAR_EQUALITY = 1.0E-04;
+    inline thread_local double _PLANE_REFIT_ITERATIONS = 1;
+    inline thread_local double _BOOLEAN_UNION_THRESHOLD = 150;
+    // largest distance between an arc and the chords that approximate it, 0 places a fixed number of points on every arc
+    inline thread_local double _CIRCLE_CHORD_TOLERANCE = 0;
+
+    // bounds of the segment count of a full circle in chord tolerance mode
+    constexpr int ADAPTIVE_CIRCLE_SEGMENTS_MIN = 8;
+    constexpr int ADAPTIVE_CIRCLE_SEGMENTS_MAX = 256;
 
     constexpr double EPS_TINY_CURVE = 1.0E-09;
     constexpr double EPS_NONZERO = 1.0E-20;
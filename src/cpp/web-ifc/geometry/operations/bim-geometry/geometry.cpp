@@ -1,4 +1,6 @@
 #include <vector>
+#include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <glm/glm.hpp>
 #include "geometry.h"
@@ -9,6 +11,51 @@
 #pragma once
 namespace bimGeometry
 {
+    namespace
+    {
+        constexpr double PLANE_CELL_LIMIT = 1.0E+15;
+
+        // cells are four tolerances wide, a value looked up two tolerances around it covers at most two of them and
+        // always the cell of every value within tolerance, whatever the rounding
+        double PlaneCellSize(double tolerance)
+        {
+            return tolerance > 0 ? 4 * tolerance : 1;
+        }
+
+        int64_t PlaneCell(double value, double size)
+        {
+            const double cell = std::floor(value / size);
+            if (!(cell > -PLANE_CELL_LIMIT))
+            {
+                return static_cast<int64_t>(-PLANE_CELL_LIMIT);
+            }
+            if (!(cell < PLANE_CELL_LIMIT))
+            {
+                return static_cast<int64_t>(PLANE_CELL_LIMIT);
+            }
+            return static_cast<int64_t>(cell);
+        }
+
+        uint64_t PlaneCellKey(const int64_t cell[4])
+        {
+            uint64_t key = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                key ^= static_cast<uint64_t>(cell[i]) + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2);
+            }
+            return key;
+        }
+
+        void PlaneCells(const Vec &normal, double d, int64_t cell[4])
+        {
+            const double normalSize = PlaneCellSize(toleranceVectorEquality);
+            cell[0] = PlaneCell(normal.x, normalSize);
+            cell[1] = PlaneCell(normal.y, normalSize);
+            cell[2] = PlaneCell(normal.z, normalSize);
+            cell[3] = PlaneCell(d, PlaneCellSize(_TOLERANCE_SCALAR_EQUALITY));
+        }
+    }
+
     void Geometry::AddPoint(glm::dvec4 &pt, glm::dvec3 &n)
     {
         glm::dvec3 p = pt;
@@ -95,17 +142,67 @@ namespace bimGeometry
         numFaces++;
 
         planeData.push_back(pId);
+        // a face without its plane leaves the planes of the geometry incomplete, they are built again when needed
+        if (pId == UINT32_MAX)
+        {
+            hasPlanes = false;
+        }
+    }
+
+    void Geometry::ResetPlaneIndex()
+    {
+        planeCells.clear();
+        indexedPlanes = 0;
     }
 
     size_t Geometry::AddPlane(const glm::dvec3 &normal, double d)
     {
-        for (auto &plane : planes)
+        // planes may have been appended since the last call, the lookup covers them all
+        if (indexedPlanes > planes.size())
+        {
+            ResetPlaneIndex();
+        }
+        for (; indexedPlanes < planes.size(); indexedPlanes++)
         {
-            if (plane.IsEqualTo(normal, d))
+            int64_t cell[4];
+            PlaneCells(planes[indexedPlanes].normal, planes[indexedPlanes].distance, cell);
+            planeCells.emplace(PlaneCellKey(cell), static_cast<uint32_t>(indexedPlanes));
+        }
+
+        // the first matching plane, as a search through planes in order would find it
+        const double normalReach = 2 * toleranceVectorEquality;
+        const double distanceReach = 2 * _TOLERANCE_SCALAR_EQUALITY;
+        int64_t low[4];
+        int64_t high[4];
+        PlaneCells(normal - Vec(normalReach), d - distanceReach, low);
+        PlaneCells(normal + Vec(normalReach), d + distanceReach, high);
+
+        uint32_t match = UINT32_MAX;
+        int64_t cell[4];
+        for (cell[0] = low[0]; cell[0] <= high[0]; cell[0]++)
+        {
+            for (cell[1] = low[1]; cell[1] <= high[1]; cell[1]++)
             {
-                return plane.id;
+                for (cell[2] = low[2]; cell[2] <= high[2]; cell[2]++)
+                {
+                    for (cell[3] = low[3]; cell[3] <= high[3]; cell[3]++)
+                    {
+                        auto range = planeCells.equal_range(PlaneCellKey(cell));
+                        for (auto it = range.first; it != range.second; ++it)
+                        {
+                            if (it->second < match && planes[it->second].IsEqualTo(normal, d))
+                            {
+                                match = it->second;
+                            }
+                        }
+                    }
+                }
             }
         }
+        if (match != UINT32_MAX)
+        {
+            return planes[match].id;
+        }
 
         Plane p;
         p.id = planes.size();
@@ -134,6 +231,7 @@ namespace bimGeometry
             {
                 planes.clear();
                 planeData.clear();
+                ResetPlaneIndex();
 
                 for (size_t i = 0; i < numFaces; i++)
                 {
@@ -247,6 +345,8 @@ namespace bimGeometry
                     planes[f.pId].distance = da;
                 }
             }
+            // the distances moved, later planes must not be matched against the old ones
+            ResetPlaneIndex();
         }
         // TODO: Remove unused planes
     }
@@ -1,5 +1,7 @@
 #include <vector>
+#include <cstdint>
 #include <algorithm>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include "aabb.h"
 #include "face.h"
@@ -19,6 +21,9 @@ namespace bimGeometry {
         std::vector<uint32_t> indexData;
         std::vector<uint32_t> planeData;
         std::vector<Plane> planes;
+        // the positions in planes by the cell of their normal and distance, filled up to indexedPlanes by AddPlane
+        std::unordered_multimap<uint64_t, uint32_t> planeCells;
+        size_t indexedPlanes = 0;
 
         AABB GetAABB() const;
         Vec GetPoint(size_t index) const;
@@ -26,6 +31,7 @@ namespace bimGeometry {
         Face GetFace(size_t index) const;
         void buildPlanes();
         size_t AddPlane(const glm::dvec3 &normal, double d);
+        void ResetPlaneIndex();
         void AddFace(glm::dvec3 a, glm::dvec3 b, glm::dvec3 c, uint32_t pId = UINT32_MAX);
         void AddFace(uint32_t a, uint32_t b, uint32_t c, uint32_t pId);
         void AddPoint(glm::dvec4& pt, glm::dvec3& n);
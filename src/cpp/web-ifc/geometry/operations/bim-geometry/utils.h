@@ -1,6 +1,9 @@
 #include <array>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
 #include <glm/glm.hpp>
 #include "geometry.h"
 #include "epsilons.h"
@@ -109,6 +112,41 @@ namespace bimGeometry
 		return glm::dot(norm, glm::dvec3(0, 0, 1)) > 0.0;
 	}
 
+	struct AngleTable
+	{
+		std::vector<double> sin;
+		std::vector<double> cos;
+	};
+
+	// the sines and cosines of startRad + r * radStep for r below count, kept per thread by count and range so that the
+	// rings of revolutions and cylinders with the same segments share them. The table stays valid until the next call
+	// on the thread
+	inline const AngleTable &GetAngleTable(int count, double startRad, double radStep)
+	{
+		constexpr size_t MAX_ANGLE_TABLES = 256;
+		thread_local std::map<std::tuple<int, double, double>, AngleTable> tables;
+		const auto key = std::make_tuple(count, startRad, radStep);
+		auto found = tables.find(key);
+		if (found != tables.end())
+		{
+			return found->second;
+		}
+		if (tables.size() >= MAX_ANGLE_TABLES)
+		{
+			tables.clear();
+		}
+		AngleTable &table = tables[key];
+		table.sin.resize(std::max(count, 0));
+		table.cos.resize(std::max(count, 0));
+		for (int r = 0; r < count; r++)
+		{
+			double angle = startRad + r * radStep;
+			table.sin[r] = std::sin(angle);
+			table.cos[r] = std::cos(angle);
+		}
+		return table;
+	}
+
 	inline Geometry Revolution(glm::dmat4 transform, double startDegrees, double endDegrees, std::vector<glm::dvec3> Profile, double numRots)
 	{
 		Geometry geometry;
@@ -132,6 +170,7 @@ namespace bimGeometry
 		double endRad = endDegrees / 180 * CONST_PI;
 		double radSpan = endRad - startRad;
 		double radStep = radSpan / (numRots - 1);
+		const AngleTable &angles = GetAngleTable(static_cast<int>(newPoints.size()), startRad, radStep);
 
 		for (size_t i = 0; i < Profile.size(); i++)
 		{
@@ -145,9 +184,8 @@ namespace bimGeometry
 			double dd = sqrt(dx * dx + dy * dy);
 			for (int r = 0; r < numRots; r++)
 			{
-				double angle = startRad + r * radStep;
-				double dtempX = sin(angle) * dd;
-				double dtempY = cos(angle) * dd;
+				double dtempX = angles.sin[r] * dd;
+				double dtempY = angles.cos[r] * dd;
 				double newPx = dtempX * vecX.x + dtempY * vecY.x + dz * vecZ.x + cent.x;
 				double newPy = dtempX * vecX.y + dtempY * vecY.y + dz * vecZ.y + cent.y;
 				double newPz = dtempX * vecX.z + dtempY * vecY.z + dz * vecZ.z + cent.z;
@@ -189,10 +227,30 @@ namespace bimGeometry
 		return geometry;
 	}
 
+	// the number of points to place on an arc of the given radius and sweep. With a chord tolerance the arc stays within
+	// the tolerance of its chords, otherwise every arc gets numPoints points
+	inline int GetArcPointCount(double radius, double sweepRad, int numPoints)
+	{
+		if (_CIRCLE_CHORD_TOLERANCE <= 0 || !(radius > 0) || !std::isfinite(radius) || !std::isfinite(sweepRad))
+		{
+			return numPoints;
+		}
+		const double sweep = std::fabs(sweepRad);
+		const double fraction = std::min(sweep / (2 * CONST_PI), 1.0);
+		// a chord spanning step deviates radius * (1 - cos(step / 2)) from the arc
+		const double step = 2 * std::acos(std::max(-1.0, 1 - _CIRCLE_CHORD_TOLERANCE / radius));
+		const int minSegments = std::max(2, static_cast<int>(std::ceil(ADAPTIVE_CIRCLE_SEGMENTS_MIN * fraction)));
+		const int maxSegments = std::max(minSegments, static_cast<int>(std::ceil(ADAPTIVE_CIRCLE_SEGMENTS_MAX * fraction)));
+		const double segments = step > 0 ? std::ceil(sweep / step) : maxSegments;
+		return static_cast<int>(std::clamp(segments, static_cast<double>(minSegments), static_cast<double>(maxSegments))) + 1;
+	}
+
 	inline Geometry RevolveCylinder(glm::dmat4 transform, double startDegrees, double endDegrees, double minZ, double maxZ, int numRots, double radius)
 	{
 		Geometry geometry;
 
+		numRots = GetArcPointCount(radius, (endDegrees - startDegrees) / 180 * CONST_PI, numRots);
+
 		glm::dvec3 cent = transform[3];
 		glm::dvec3 vecX = glm::normalize(transform[0]);
 		glm::dvec3 vecY = glm::normalize(transform[1]);
@@ -209,12 +267,12 @@ namespace bimGeometry
 		double endRad = endDegrees / 180 * CONST_PI;
 		double radSpan = endRad - startRad;
 		double radStep = radSpan / (numRots - 1);
+		const AngleTable &angles = GetAngleTable(numRots, startRad, radStep);
 
 		for (int r = 0; r < numRots; r++)
 		{
-			double angle = startRad + r * radStep;
-			double dtempX = sin(angle) * radius;
-			double dtempY = cos(angle) * radius;
+			double dtempX = angles.sin[r] * radius;
+			double dtempY = angles.cos[r] * radius;
 			double newPx = dtempX * vecX.x + dtempY * vecY.x + minZ * vecZ.x + cent.x;
 			double newPy = dtempX * vecX.y + dtempY * vecY.y + minZ * vecZ.y + cent.y;
 			double newPz = dtempX * vecX.z + dtempY * vecY.z + minZ * vecZ.z + cent.z;
@@ -226,9 +284,8 @@ namespace bimGeometry
 		}
 		for (int r = 0; r < numRots; r++)
 		{
-			double angle = startRad + r * radStep;
-			double dtempX = sin(angle) * radius;
-			double dtempY = cos(angle) * radius;
+			double dtempX = angles.sin[r] * radius;
+			double dtempY = angles.cos[r] * radius;
 			double newPx = dtempX * vecX.x + dtempY * vecY.x + maxZ * vecZ.x + cent.x;
 			double newPy = dtempX * vecX.y + dtempY * vecY.y + maxZ * vecZ.y + cent.y;
 			double newPz = dtempX * vecX.z + dtempY * vecY.z + maxZ * vecZ.z + cent.z;
@@ -1227,6 +1284,160 @@ namespace bimGeometry
 		return geom;
 	}
 
+	// joints that turn further than this, where the bisecting plane cuts a tube nearly along its axis, get a ring across
+	// the outgoing segment instead
+	constexpr double SWEEP_DISK_MIN_MITER_COS = 0.1;
+
+	// sweeps a profile around the origin of the xy plane, a disk in practice, along an open directrix as one tube. The
+	// frame of every segment is carried over from the previous one by the rotation that turns one segment direction
+	// into the next, the rotation minimizing frame of a polyline, so the tube does not twist. Every directrix point gets
+	// one ring on the plane that bisects the segments meeting there, and both segments share it, so the buffers are sized
+	// up front and every face is written by index
+	inline Geometry SweepDisk(const double scaling, const std::vector<glm::dvec3> &profile, const std::vector<glm::dvec3> &directrix)
+	{
+		Geometry geom;
+
+		// a closed profile repeats its first point, the ring wraps around instead
+		size_t ringSize = profile.size();
+		if (ringSize > 1 && glm::distance(profile.front(), profile.back()) <= EPS_BIG2 * scaling)
+		{
+			ringSize--;
+		}
+		if (ringSize < 3)
+		{
+			return geom;
+		}
+
+		// the rings go counterclockwise around the segments, so that the faces point outwards
+		double area = 0;
+		for (size_t j = 0; j < ringSize; j++)
+		{
+			const glm::dvec3 &a = profile[j];
+			const glm::dvec3 &b = profile[(j + 1) % ringSize];
+			area += a.x * b.y - b.x * a.y;
+		}
+		const bool counterClockwise = area > 0;
+
+		// Remove repeated points
+		std::vector<glm::dvec3> points;
+		points.reserve(directrix.size());
+		for (size_t i = 0; i < directrix.size(); i++)
+		{
+			if (i + 1 == directrix.size() || glm::distance(directrix[i], directrix[i + 1]) > EPS_BIG2 * scaling)
+			{
+				points.push_back(directrix[i]);
+			}
+		}
+		if (points.size() < 2)
+		{
+			// nothing to sweep
+			return geom;
+		}
+
+		const size_t segmentCount = points.size() - 1;
+		std::vector<glm::dvec3> tangents(segmentCount);
+		for (size_t k = 0; k < segmentCount; k++)
+		{
+			tangents[k] = glm::normalize(points[k + 1] - points[k]);
+		}
+
+		// the first frame is perpendicular to the first segment, across its smallest component
+		std::vector<glm::dvec3> frames(segmentCount);
+		{
+			const glm::dvec3 &t = tangents[0];
+			const glm::dvec3 magnitude = glm::abs(t);
+			glm::dvec3 axis(0, 0, 1);
+			if (magnitude.x <= magnitude.y && magnitude.x <= magnitude.z)
+			{
+				axis = glm::dvec3(1, 0, 0);
+			}
+			else if (magnitude.y <= magnitude.z)
+			{
+				axis = glm::dvec3(0, 1, 0);
+			}
+			frames[0] = glm::normalize(glm::cross(t, axis));
+		}
+		for (size_t k = 1; k < segmentCount; k++)
+		{
+			const glm::dvec3 &a = tangents[k - 1];
+			const glm::dvec3 &b = tangents[k];
+			const glm::dvec3 &r = frames[k - 1];
+			const double c = glm::dot(a, b);
+			glm::dvec3 rotated = r;
+			if (c > -1 + EPS_BIG2)
+			{
+				// the rotation taking a to b about their common perpendicular, Rodrigues' formula
+				const glm::dvec3 w = glm::cross(a, b);
+				rotated = c * r + glm::cross(w, r) + (glm::dot(w, r) / (1 + c)) * w;
+			}
+			// a directrix that turns back keeps its frame, which is perpendicular to both segments already
+			rotated -= b * glm::dot(rotated, b);
+			const double length = glm::length(rotated);
+			frames[k] = length > EPS_BIG2 ? rotated / length : frames[k - 1];
+		}
+
+		geom.vertexData.reserve(points.size() * ringSize * VERTEX_FORMAT_SIZE_FLOATS);
+		geom.indexData.reserve(segmentCount * ringSize * 6);
+		geom.planeData.reserve(segmentCount * ringSize * 2);
+
+		for (size_t k = 0; k < points.size(); k++)
+		{
+			// the ring is laid out in the frame of the outgoing segment and moved along it onto the bisecting plane
+			const size_t segment = std::min(k, segmentCount - 1);
+			const glm::dvec3 &t = tangents[segment];
+			const glm::dvec3 &r = frames[segment];
+			const glm::dvec3 u = glm::cross(t, r);
+			glm::dvec3 planeNormal = t;
+			glm::dvec3 normalR = r;
+			glm::dvec3 normalU = u;
+			if (k > 0 && k < segmentCount)
+			{
+				const glm::dvec3 bisector = tangents[k - 1] + t;
+				const double length = glm::length(bisector);
+				if (length > EPS_BIG2 && glm::dot(t, bisector) / length > SWEEP_DISK_MIN_MITER_COS)
+				{
+					planeNormal = bisector / length;
+				}
+				normalR += frames[k - 1];
+				normalU += glm::cross(tangents[k - 1], frames[k - 1]);
+			}
+			const double tDotN = glm::dot(t, planeNormal);
+
+			for (size_t j = 0; j < ringSize; j++)
+			{
+				const glm::dvec3 offset = profile[j].x * r + profile[j].y * u;
+				const glm::dvec3 pt = points[k] + offset - t * (glm::dot(offset, planeNormal) / tDotN);
+				glm::dvec3 normal = profile[j].x * normalR + profile[j].y * normalU;
+				const double normalLength = glm::length(normal);
+				normal = normalLength > 0 ? normal / normalLength : r;
+				geom.AddPoint(pt, normal);
+			}
+		}
+
+		for (size_t k = 0; k < segmentCount; k++)
+		{
+			const uint32_t start = static_cast<uint32_t>(k * ringSize);
+			const uint32_t end = static_cast<uint32_t>((k + 1) * ringSize);
+			for (size_t j = 0; j < ringSize; j++)
+			{
+				const uint32_t j1 = static_cast<uint32_t>(j);
+				const uint32_t j2 = static_cast<uint32_t>((j + 1) % ringSize);
+				if (counterClockwise)
+				{
+					geom.AddFace(start + j1, start + j2, end + j2, -1);
+					geom.AddFace(start + j1, end + j2, end + j1, -1);
+				}
+				else
+				{
+					geom.AddFace(start + j1, end + j2, start + j2, -1);
+					geom.AddFace(start + j1, end + j1, end + j2, -1);
+				}
+			}
+		}
+
+		return geom;
+	}
+
 	inline Geometry SectionedSurface(std::vector<std::vector<glm::dvec3>> profiles, bool buildCaps, double eps=0.0)
 	{
 		Geometry geom;
@@ -1444,10 +1655,11 @@ namespace bimGeometry
 			placement4[2][1] = tr.y;
 
 			// Generate the rounded corners with appropriate angles for each quadrant
-			std::vector<glm::dvec3> round1 = (bimGeometry::GetEllipseCurve(radius, radius, numSegments, placement1, CONST_PI, 3 * CONST_PI / 2)).points;	 // BL: 180° to 270°
-			std::vector<glm::dvec3> round2 = (bimGeometry::GetEllipseCurve(radius, radius, numSegments, placement2, 3 * CONST_PI / 2, 2 * CONST_PI)).points; // BR: 270° to 360°
-			std::vector<glm::dvec3> round3 = (bimGeometry::GetEllipseCurve(radius, radius, numSegments, placement3, CONST_PI / 2, CONST_PI)).points;		 // TL: 90° to 180°
-			std::vector<glm::dvec3> round4 = (bimGeometry::GetEllipseCurve(radius, radius, numSegments, placement4, 0, CONST_PI / 2)).points;
+			const int cornerPoints = GetArcPointCount(radius, CONST_PI / 2, numSegments);
+			std::vector<glm::dvec3> round1 = (bimGeometry::GetEllipseCurve(radius, radius, cornerPoints, placement1, CONST_PI, 3 * CONST_PI / 2)).points;	 // BL: 180° to 270°
+			std::vector<glm::dvec3> round2 = (bimGeometry::GetEllipseCurve(radius, radius, cornerPoints, placement2, 3 * CONST_PI / 2, 2 * CONST_PI)).points; // BR: 270° to 360°
+			std::vector<glm::dvec3> round3 = (bimGeometry::GetEllipseCurve(radius, radius, cornerPoints, placement3, CONST_PI / 2, CONST_PI)).points;		 // TL: 90° to 180°
+			std::vector<glm::dvec3> round4 = (bimGeometry::GetEllipseCurve(radius, radius, cornerPoints, placement4, 0, CONST_PI / 2)).points;
 
 			Curve c;
 			for (size_t i = 0; i < round1.size(); i++)
@@ -1789,4 +2001,9 @@ namespace bimGeometry
 		}
 		_BOOLEAN_UNION_THRESHOLD = BOOLEAN_UNION_THRESHOLD;
 	}
+
+	inline void SetCircleChordTolerance(double CIRCLE_CHORD_TOLERANCE)
+	{
+		_CIRCLE_CHORD_TOLERANCE = CIRCLE_CHORD_TOLERANCE > 0 ? CIRCLE_CHORD_TOLERANCE : 0;
+	}
 }
\ No newline at end of file
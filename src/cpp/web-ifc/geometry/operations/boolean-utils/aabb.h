@@ -52,6 +52,12 @@ namespace fuzzybools
             dirfrac.x = 1.0 / dir.x;
             dirfrac.y = 1.0 / dir.y;
             dirfrac.z = 1.0 / dir.z;
+            return IntersectInverse(origin, dirfrac);
+        }
+
+        // same as Intersect, with the reciprocal of the ray direction computed once by the caller
+        bool IntersectInverse(const Vec& origin, const Vec& dirfrac) const
+        {
             // lb is the corner of AABB with minimal coordinates - left bottom, rt is maximal corner
             // r.org is origin of ray
             double t1 = (min.x - origin.x) * dirfrac.x;
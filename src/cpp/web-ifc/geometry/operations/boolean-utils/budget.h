@@ -0,0 +1,34 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace fuzzybools
+{
+    // the steady clock time in nanoseconds at which the booleans of this thread give up, 0 never
+    inline thread_local uint64_t _BOOLEAN_DEADLINE = 0;
+    // set once the deadline passed, cleared by whoever set the deadline
+    inline thread_local bool _BOOLEAN_ABORTED = false;
+    inline thread_local uint32_t _budgetChecks = 0;
+
+    inline void SetBooleanDeadline(uint64_t deadline)
+    {
+        _BOOLEAN_DEADLINE = deadline;
+        _BOOLEAN_ABORTED = false;
+    }
+
+    // checked in the long loops of Normalize and the clipping, which stop early once it is true, their result is then
+    // incomplete and must be discarded. The clock is read on every 64th check only
+    inline bool BudgetExceeded()
+    {
+        if (_BOOLEAN_ABORTED) return true;
+        if (_BOOLEAN_DEADLINE == 0 || (++_budgetChecks & 63) != 0) return false;
+        const uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        _BOOLEAN_ABORTED = now >= _BOOLEAN_DEADLINE;
+        return _BOOLEAN_ABORTED;
+    }
+}
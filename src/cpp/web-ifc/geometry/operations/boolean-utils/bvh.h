@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -27,6 +29,15 @@ namespace fuzzybools
         }
     };
 
+    // the build stops splitting at this depth, which bounds the fixed size traversal stacks below
+    constexpr uint32_t BVH_MAX_DEPTH = 32;
+    constexpr size_t BVH_STACK_SIZE = BVH_MAX_DEPTH * 2 + 2;
+    // leaves this small are never split, larger ones are split when the surface area heuristic says so
+    constexpr uint32_t BVH_MIN_LEAF_SIZE = 4;
+    // leaves larger than this are always split, with a median split when the heuristic finds no split
+    constexpr uint32_t BVH_MAX_LEAF_SIZE = 16;
+    constexpr uint32_t BVH_SAH_BINS = 16;
+
     struct BVH
     {
         AABB box;
@@ -37,13 +48,19 @@ namespace fuzzybools
         template <typename T>
         void Intersect(const BVH& other, T callback)
         {
-            std::stack<std::pair<uint32_t, uint32_t>> bvhStack;
-            bvhStack.emplace(0, 0);
+            if (nodes.empty() || other.nodes.empty())
+            {
+                return;
+            }
 
-            while (!bvhStack.empty())
+            // every pop pushes at most two pairs, so the stack never holds more than the summed depth of both trees
+            std::array<std::pair<uint32_t, uint32_t>, BVH_STACK_SIZE> bvhStack;
+            size_t stackSize = 0;
+            bvhStack[stackSize++] = {0, 0};
+
+            while (stackSize > 0)
             {
-                const auto [i1, i2] = bvhStack.top();
-                bvhStack.pop();
+                const auto [i1, i2] = bvhStack[--stackSize];
 
                 auto& n1 = nodes[i1];
                 auto& n2 = other.nodes[i2];
@@ -64,21 +81,16 @@ namespace fuzzybools
                             }
                         }
                     }
-                    else if (n1.IsLeaf())
+                    else if (n1.IsLeaf() || (!n2.IsLeaf() && SurfaceArea(n2.box) > SurfaceArea(n1.box)))
                     {
-                        bvhStack.emplace(i1, n2.left);
-                        bvhStack.emplace(i1, n2.right);
-                    }
-                    else if (n2.IsLeaf())
-                    {
-                        bvhStack.emplace(n1.left, i2);
-                        bvhStack.emplace(n1.right, i2);
+                        bvhStack[stackSize++] = {i1, n2.left};
+                        bvhStack[stackSize++] = {i1, n2.right};
                     }
                     else
                     {
-                        // neither are leaves, split n1
-                        bvhStack.emplace(n1.left, i2);
-                        bvhStack.emplace(n1.right, i2);
+                        // split the larger node
+                        bvhStack[stackSize++] = {n1.left, i2};
+                        bvhStack[stackSize++] = {n1.right, i2};
                     }
                 }
                 else
@@ -88,24 +100,64 @@ namespace fuzzybools
             }
         }
 
-        template <typename T>
-        bool IntersectRay(const glm::dvec3& origin, const glm::dvec3& dir, T callback)
+        // true when a face box overlaps box
+        bool IntersectsBox(const AABB& box) const
         {
-            static std::vector<uint32_t> stack;
-            stack.clear();
+            if (nodes.empty())
+            {
+                return false;
+            }
+
+            std::array<uint32_t, BVH_STACK_SIZE> stack;
+            size_t stackSize = 0;
+            stack[stackSize++] = 0;
+            while (stackSize > 0)
+            {
+                const auto& node = nodes[stack[--stackSize]];
 
+                if (!node.box.intersects(box))
+                {
+                    continue;
+                }
+
+                if (node.IsLeaf())
+                {
+                    for (uint32_t i = node.start; i < node.end; i++)
+                    {
+                        if (boxes[i].intersects(box))
+                        {
+                            return true;
+                        }
+                    }
+                }
+                else
+                {
+                    stack[stackSize++] = node.left;
+                    stack[stackSize++] = node.right;
+                }
+            }
+
+            return false;
+        }
+
+        template <typename T>
+        bool IntersectRay(const glm::dvec3& origin, const glm::dvec3& dir, T callback) const
+        {
             if (nodes.empty())
             {
                 return false;
             }
 
-            stack.emplace_back(0);
-            while (!stack.empty())
+            const glm::dvec3 dirfrac = 1.0 / dir;
+
+            std::array<uint32_t, BVH_STACK_SIZE> stack;
+            size_t stackSize = 0;
+            stack[stackSize++] = 0;
+            while (stackSize > 0)
             {
-                const auto& node = nodes[stack.back()];
-                stack.pop_back();
+                const auto& node = nodes[stack[--stackSize]];
 
-                if (node.box.Intersect(origin, dir))
+                if (node.box.IntersectInverse(origin, dirfrac))
                 {
                     // hit!
                     if (node.IsLeaf())
@@ -114,7 +166,7 @@ namespace fuzzybools
                         for (uint32_t i = node.start; i < node.end; i++)
                         {
                             const auto& box = boxes[i];
-                            if (box.Intersect(origin, dir))
+                            if (box.IntersectInverse(origin, dirfrac))
                             {
                                 if (callback(box.index))
                                 {
@@ -130,8 +182,8 @@ namespace fuzzybools
                     else
                     {
                         // visit children
-                        stack.emplace_back(node.left);
-                        stack.emplace_back(node.right);
+                        stack[stackSize++] = node.left;
+                        stack[stackSize++] = node.right;
                     }
                 }
                 else
@@ -143,48 +195,135 @@ namespace fuzzybools
             return false;
         }
 
+        static double SurfaceArea(const AABB& box)
+        {
+            const glm::dvec3 size = box.max - box.min;
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
     };
 
-    static int MakeBVH(std::vector<AABB>& boxes, std::vector<BVHNode>& nodes, int start, int end, int axis, int depth, int& offset)
+    inline uint32_t GetSAHBin(double value, double min, double scale)
     {
-        int nodeID = offset++;
+        const double bin = (value - min) * scale;
+        // also catches NaN
+        if (!(bin > 0))
+        {
+            return 0;
+        }
+        return bin >= BVH_SAH_BINS - 1 ? BVH_SAH_BINS - 1 : static_cast<uint32_t>(bin);
+    }
 
-        nodes.resize(nodeID + 1);
-        BVHNode& node = nodes[nodeID];
+    // nodes are stored depth first, the left child of a node directly follows it
+    static uint32_t MakeBVH(std::vector<AABB>& boxes, std::vector<BVHNode>& nodes, uint32_t start, uint32_t end, uint32_t depth)
+    {
+        const uint32_t nodeID = static_cast<uint32_t>(nodes.size());
 
+        BVHNode node;
         node.start = start;
         node.end = end;
 
-        for (int i = start; i < end; i++)
+        AABB centers;
+        for (uint32_t i = start; i < end; i++)
         {
             node.box.merge(boxes[i]);
+            centers.merge(boxes[i].center);
         }
 
-        nodes.reserve(nodeID + 1);
+        nodes.push_back(node);
 
-        if (depth == 6)
+        const uint32_t size = end - start;
+        if (size <= BVH_MIN_LEAF_SIZE || depth == BVH_MAX_DEPTH)
         {
             return nodeID;
         }
 
+        // binned surface area heuristic, one unit to visit a node and one per box tested
+        struct Bin
+        {
+            AABB box;
+            uint32_t count = 0;
+        };
+
+        double bestCost = BVH::SurfaceArea(node.box) * size;
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const double extent = centers.max[axis] - centers.min[axis];
+            if (!(extent > 0))
+            {
+                continue;
+            }
+            const double scale = BVH_SAH_BINS / extent;
+
+            std::array<Bin, BVH_SAH_BINS> bins;
+            for (uint32_t i = start; i < end; i++)
+            {
+                auto& bin = bins[GetSAHBin(boxes[i].center[axis], centers.min[axis], scale)];
+                bin.box.merge(boxes[i]);
+                bin.count++;
+            }
+
+            std::array<double, BVH_SAH_BINS> rightCosts;
+            AABB right;
+            uint32_t rightCount = 0;
+            for (uint32_t b = BVH_SAH_BINS - 1; b > 0; b--)
+            {
+                right.merge(bins[b].box);
+                rightCount += bins[b].count;
+                rightCosts[b - 1] = rightCount == 0 ? -1 : BVH::SurfaceArea(right) * rightCount;
+            }
 
-        int size = end - start;
+            AABB left;
+            uint32_t leftCount = 0;
+            for (uint32_t b = 0; b < BVH_SAH_BINS - 1; b++)
+            {
+                left.merge(bins[b].box);
+                leftCount += bins[b].count;
+                if (leftCount == 0 || rightCosts[b] < 0)
+                {
+                    continue;
+                }
+                const double cost = BVH::SurfaceArea(node.box) + BVH::SurfaceArea(left) * leftCount + rightCosts[b];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
 
-        // ignore cubes
-        if (size <= 12)
+        uint32_t middle;
+        if (bestAxis >= 0)
+        {
+            const double scale = BVH_SAH_BINS / (centers.max[bestAxis] - centers.min[bestAxis]);
+            auto split = std::partition(boxes.begin() + start, boxes.begin() + end, [&](const AABB& box)
+                {
+                    return GetSAHBin(box.center[bestAxis], centers.min[bestAxis], scale) <= bestBin;
+                });
+            middle = static_cast<uint32_t>(split - boxes.begin());
+        }
+        else if (size > BVH_MAX_LEAF_SIZE)
+        {
+            // no useful split, e.g. all centers coincide, fall back to a median split along the longest axis
+            const glm::dvec3 extent = node.box.max - node.box.min;
+            const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            middle = (start + end) / 2;
+            std::nth_element(boxes.begin() + start, boxes.begin() + middle, boxes.begin() + end, [&](const AABB& first, const AABB& second)
+                {
+                    return first.center[axis] < second.center[axis];
+                });
+        }
+        else
         {
             return nodeID;
         }
 
-        int middle = (end + start) / 2;
-
-        std::nth_element(boxes.begin() + start, boxes.begin() + middle, boxes.begin() + end, [&](const AABB& first, const AABB& second)
-            {
-                return first.center[axis] > second.center[axis];
-            });
-
-        nodes[nodeID].left = MakeBVH(boxes, nodes, start, middle, (axis + 1) % 3, depth + 1, offset);
-        nodes[nodeID].right = MakeBVH(boxes, nodes, middle, end, (axis + 1) % 3, depth + 1, offset);
+        const uint32_t left = MakeBVH(boxes, nodes, start, middle, depth + 1);
+        const uint32_t right = MakeBVH(boxes, nodes, middle, end, depth + 1);
+        nodes[nodeID].left = left;
+        nodes[nodeID].right = right;
 
         return nodeID;
     }
@@ -200,9 +339,8 @@ namespace fuzzybools
             bvh.box.merge(bvh.boxes[i]);
         }
 
-        int offset = 0;
-        // start BVH at Y axis
-        MakeBVH(bvh.boxes, bvh.nodes, 0, static_cast<int>(bvh.boxes.size()), 1, 0, offset);
+        bvh.nodes.reserve(2 * (bvh.boxes.size() / BVH_MIN_LEAF_SIZE) + 1);
+        MakeBVH(bvh.boxes, bvh.nodes, 0, static_cast<uint32_t>(bvh.boxes.size()), 0);
 
         return bvh;
     }
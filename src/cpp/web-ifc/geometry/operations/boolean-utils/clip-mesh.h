@@ -4,15 +4,197 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
 #include <glm/glm.hpp>
 
 #include "util.h"
 #include "is-inside-mesh.h"
 #include "geometry.h"
 #include "bvh.h"
+#include "budget.h"
 
 namespace fuzzybools
 {
+    // the tested faces of a normalized mesh, [0, mesh.data), grouped into regions that are connected through edges
+    // shared by exactly two faces of the same plane with matching winding. Every surface crossing a region has been cut
+    // into it by normalization, where its faces meet the region's edges, so a region lies on one side of both operands
+    struct ClipRegions
+    {
+        // per face
+        std::vector<uint32_t> region;
+        // per region, the number of faces and the largest of them
+        std::vector<uint32_t> size;
+        std::vector<uint32_t> representative;
+    };
+
+    static ClipRegions findClipRegions(const Geometry &mesh)
+    {
+        const uint32_t faceCount = mesh.data;
+        ClipRegions regions;
+
+        // corners are the same point when their positions are equal bit for bit, normalization places shared points exactly
+        std::vector<std::pair<glm::dvec3, uint32_t>> corners;
+        corners.reserve(faceCount * 3);
+        for (uint32_t i = 0; i < faceCount * 3; i++)
+        {
+            corners.emplace_back(mesh.GetPoint(mesh.indexData[i]), i);
+        }
+        std::sort(corners.begin(), corners.end(), [](const auto &l, const auto &r)
+                  { return std::tie(l.first.x, l.first.y, l.first.z) < std::tie(r.first.x, r.first.y, r.first.z); });
+        std::vector<uint32_t> cornerPoint(corners.size());
+        uint32_t pointCount = 0;
+        for (size_t i = 0; i < corners.size(); i++)
+        {
+            if (i > 0 && corners[i].first != corners[i - 1].first)
+            {
+                pointCount++;
+            }
+            cornerPoint[corners[i].second] = pointCount;
+        }
+
+        struct HalfEdge
+        {
+            uint32_t from;
+            uint32_t to;
+            uint32_t face;
+        };
+        std::vector<HalfEdge> halfEdges;
+        halfEdges.reserve(faceCount * 3);
+        for (uint32_t i = 0; i < faceCount; i++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint32_t from = cornerPoint[i * 3 + k];
+                const uint32_t to = cornerPoint[i * 3 + (k + 1) % 3];
+                if (from != to)
+                {
+                    halfEdges.push_back({from, to, i});
+                }
+            }
+        }
+        auto edgeKey = [](const HalfEdge &e)
+        { return std::make_pair(std::min(e.from, e.to), std::max(e.from, e.to)); };
+        std::sort(halfEdges.begin(), halfEdges.end(), [&](const HalfEdge &l, const HalfEdge &r)
+                  { return edgeKey(l) < edgeKey(r); });
+
+        std::vector<uint32_t> parent(faceCount);
+        for (uint32_t i = 0; i < faceCount; i++)
+        {
+            parent[i] = i;
+        }
+        auto root = [&](uint32_t face)
+        {
+            while (parent[face] != face)
+            {
+                parent[face] = parent[parent[face]];
+                face = parent[face];
+            }
+            return face;
+        };
+        for (size_t start = 0; start < halfEdges.size();)
+        {
+            size_t end = start + 1;
+            while (end < halfEdges.size() && edgeKey(halfEdges[end]) == edgeKey(halfEdges[start]))
+            {
+                end++;
+            }
+            // an edge of more than two faces is where surfaces intersect
+            if (end - start == 2)
+            {
+                const HalfEdge &e0 = halfEdges[start];
+                const HalfEdge &e1 = halfEdges[start + 1];
+                if (e0.from == e1.to && mesh.planeData[e0.face] == mesh.planeData[e1.face])
+                {
+                    parent[root(e0.face)] = root(e1.face);
+                }
+            }
+            start = end;
+        }
+
+        regions.region.resize(faceCount);
+        std::vector<uint32_t> rootRegion(faceCount, UINT32_MAX);
+        std::vector<double> largestArea;
+        for (uint32_t i = 0; i < faceCount; i++)
+        {
+            uint32_t &region = rootRegion[root(i)];
+            if (region == UINT32_MAX)
+            {
+                region = static_cast<uint32_t>(regions.size.size());
+                regions.size.push_back(0);
+                regions.representative.push_back(i);
+                largestArea.push_back(-1);
+            }
+            regions.region[i] = region;
+            regions.size[region]++;
+            const Face f = mesh.GetFace(i);
+            const double area = areaOfTriangle(mesh.GetPoint(f.i0), mesh.GetPoint(f.i1), mesh.GetPoint(f.i2));
+            if (area > largestArea[region])
+            {
+                largestArea[region] = area;
+                regions.representative[region] = i;
+            }
+        }
+
+        return regions;
+    }
+
+    // the location of pt on the mesh of bvh from rays along dir and extraDir1, and extraDir2 when those two disagree or
+    // castAll is set. Where the first two disagree extraDir1 is taken unless extraDir2 agrees with dir, certain tells
+    // whether every ray cast agreed
+    static InsideResult voteInsideMesh(const Vec &pt, const Vec &n, BVH &bvh, const Vec &dir, const Vec &extraDir1, const Vec &extraDir2, bool UNION, bool castAll, bool &certain)
+    {
+        auto loc = isInsideMesh(pt, n, *bvh.ptr, bvh, dir, UNION);
+        auto locB = isInsideMesh(pt, n, *bvh.ptr, bvh, extraDir1, UNION);
+        certain = loc.loc == locB.loc;
+        if (!certain || castAll)
+        {
+            auto locC = isInsideMesh(pt, n, *bvh.ptr, bvh, extraDir2, UNION);
+            if (!certain && locC.loc != loc.loc)
+            {
+                loc = locB;
+            }
+            certain = certain && locC.loc == loc.loc;
+        }
+        return loc;
+    }
+
+    // the locations of a region's representative on the first and second operand, cast when a face of it is first clipped
+    struct RegionLocation
+    {
+        bool located = false;
+        bool certain = false;
+        std::pair<InsideResult, InsideResult> locations;
+    };
+
+    // the locations of a tested face on the first and second operand, locate(face, castAll, certain) casts them. Faces
+    // of a region take the locations of its representative, cast once with all three rays, unless those rays disagree,
+    // then every face of the region is cast on its own like faces that are alone in their region
+    template <typename Locate>
+    static std::pair<InsideResult, InsideResult> locateClipFace(uint32_t face, const ClipRegions &regions, std::vector<RegionLocation> &located, const Locate &locate)
+    {
+        bool certain = false;
+        const uint32_t region = regions.region[face];
+        if (regions.size[region] < 2)
+        {
+            return locate(face, false, certain);
+        }
+        RegionLocation &location = located[region];
+        if (!location.located)
+        {
+            location.located = true;
+            location.locations = locate(regions.representative[region], true, location.certain);
+        }
+        if (location.certain)
+        {
+            return location.locations;
+        }
+        return locate(face, false, certain);
+    }
+
     static void doubleClipSingleMesh(Geometry& mesh, BVH& bvh1, BVH& bvh2, Geometry& result)
     {  
         #ifdef CSG_DEBUG_OUTPUT
@@ -27,8 +209,34 @@ namespace fuzzybools
             result.planes.push_back(plane);
         }
 
+        const ClipRegions regions = findClipRegions(mesh);
+        std::vector<RegionLocation> located(regions.size.size());
+        auto locate = [&](uint32_t face, bool castAll, bool &certain)
+        {
+            Face tri = mesh.GetFace(face);
+            glm::dvec3 a = mesh.GetPoint(tri.i0);
+            glm::dvec3 b = mesh.GetPoint(tri.i1);
+            glm::dvec3 c = mesh.GetPoint(tri.i2);
+
+            glm::dvec3 n = computeNormal(a, b, c);
+
+            glm::dvec3 triCenter = (a + b * 1.02 + c * 1.03) * 1.0 / 3.05; // Using true centroid could cause issues (#540)
+
+            Vec raydir = n;
+            Vec extraDir1 = glm::normalize(raydir + Vec(0.02,0.01,0.04));
+            Vec extraDir2 = glm::normalize(raydir + Vec(0.20,-0.1,0.40));
+
+            bool certain1 = false;
+            bool certain2 = false;
+            auto isInside1Loc = voteInsideMesh(triCenter, n, bvh1, raydir, extraDir1, extraDir2, false, castAll, certain1);
+            auto isInside2Loc = voteInsideMesh(triCenter, n, bvh2, raydir, extraDir1, extraDir2, false, castAll, certain2);
+            certain = certain1 && certain2;
+            return std::make_pair(isInside1Loc, isInside2Loc);
+        };
+
         for (uint32_t i = 0; i < mesh.data; i++)
         {
+            if (BudgetExceeded()) return;
             bool doit = false;
             Face tri = mesh.GetFace(i);
             glm::dvec3 a = mesh.GetPoint(tri.i0);
@@ -82,40 +290,7 @@ namespace fuzzybools
 
             glm::dvec3 n = computeNormal(a, b, c);
 
-            glm::dvec3 triCenter = (a + b * 1.02 + c * 1.03) * 1.0 / 3.05; // Using true centroid could cause issues (#540)
-
-            auto isInsideTarget = MeshLocation::INSIDE;
-
-            Vec raydir = computeNormal(a, b, c);
-
-            auto isInside1Loc = isInsideMesh(triCenter, n, *bvh1.ptr, bvh1, raydir);
-            auto isInside2Loc = isInsideMesh(triCenter, n, *bvh2.ptr, bvh2, raydir);
-
-            Vec extraDir1 = glm::normalize(raydir + Vec(0.02,0.01,0.04));
-            Vec extraDir2 = glm::normalize(raydir + Vec(0.20,-0.1,0.40));
-
-            auto isInside1Loc_B = isInsideMesh(triCenter, n, *bvh1.ptr, bvh1, extraDir1);
-            auto isInside2Loc_B = isInsideMesh(triCenter, n, *bvh2.ptr, bvh2, extraDir1);
-
-            if(isInside1Loc.loc != isInside1Loc_B.loc)
-            {
-                auto isInside1Loc_C = isInsideMesh(triCenter, n, *bvh1.ptr, bvh1, extraDir2);
-                if(isInside1Loc_C.loc == isInside1Loc_B.loc){isInside1Loc = isInside1Loc_B;}
-                else if(isInside1Loc_B.loc != isInside1Loc_C.loc && isInside1Loc.loc != isInside1Loc_C.loc)
-                {
-                    isInside1Loc = isInside1Loc_B;
-                }
-            }
-
-            if(isInside2Loc.loc != isInside2Loc_B.loc)
-            {
-                auto isInside2Loc_C = isInsideMesh(triCenter, n, *bvh2.ptr, bvh2, extraDir2);
-                if(isInside2Loc_C.loc == isInside2Loc_B.loc){isInside2Loc = isInside2Loc_B;}
-                else if(isInside2Loc_B.loc != isInside2Loc_C.loc && isInside2Loc.loc != isInside2Loc_C.loc)
-                {
-                    isInside2Loc = isInside2Loc_B;
-                }
-            }
+            auto [isInside1Loc, isInside2Loc] = locateClipFace(i, regions, located, locate);
 
             auto isInside1 = isInside1Loc.loc;
             auto isInside2 = isInside2Loc.loc;
@@ -223,51 +398,42 @@ namespace fuzzybools
             result.planes.push_back(plane);
         }
 
-        for (uint32_t i = 0; i < mesh.data; i++)
+        const ClipRegions regions = findClipRegions(mesh);
+        std::vector<RegionLocation> located(regions.size.size());
+        auto locate = [&](uint32_t face, bool castAll, bool &certain)
         {
-            Face tri = mesh.GetFace(i);
+            Face tri = mesh.GetFace(face);
             glm::dvec3 a = mesh.GetPoint(tri.i0);
             glm::dvec3 b = mesh.GetPoint(tri.i1);
             glm::dvec3 c = mesh.GetPoint(tri.i2);
 
             glm::dvec3 n = computeNormal(a, b, c);
 
-            auto area = areaOfTriangle(a, b, c);
-
             glm::dvec3 triCenter = (a + b * 2.0 + c * 3.0) * 1.0 / 6.0; // Using true centroid could cause issues (#540)
 
-            auto isInsideTarget = MeshLocation::INSIDE;
-
-            Vec raydir = computeNormal(a, b, c);
-
-            auto isInside1Loc = isInsideMesh(triCenter, n, *bvh1.ptr, bvh1, raydir, true);
-            auto isInside2Loc = isInsideMesh(triCenter, n, *bvh2.ptr, bvh2, raydir, true);
-
+            Vec raydir = n;
             Vec extraDir1 = glm::normalize(Vec(1.1, 1.4, 1.2));
             Vec extraDir2 = glm::normalize(Vec(-2.1, 1.4, -3.2));
 
-            auto isInside1Loc_B = isInsideMesh(triCenter, n, *bvh1.ptr, bvh1, extraDir1, true);
-            auto isInside2Loc_B = isInsideMesh(triCenter, n, *bvh2.ptr, bvh2, extraDir1, true);
+            bool certain1 = false;
+            bool certain2 = false;
+            auto isInside1Loc = voteInsideMesh(triCenter, n, bvh1, raydir, extraDir1, extraDir2, true, castAll, certain1);
+            auto isInside2Loc = voteInsideMesh(triCenter, n, bvh2, raydir, extraDir1, extraDir2, true, castAll, certain2);
+            certain = certain1 && certain2;
+            return std::make_pair(isInside1Loc, isInside2Loc);
+        };
 
-            if(isInside1Loc.loc != isInside1Loc_B.loc)
-            {
-                auto isInside1Loc_C = isInsideMesh(triCenter, n, *bvh1.ptr, bvh1, extraDir2, true);
-                if(isInside1Loc_C.loc == isInside1Loc_B.loc){isInside1Loc = isInside1Loc_B;}
-                else if(isInside1Loc_B.loc != isInside1Loc_C.loc && isInside1Loc.loc != isInside1Loc_C.loc)
-                {
-                    isInside1Loc = isInside1Loc_B;
-                }
-            }
+        for (uint32_t i = 0; i < mesh.data; i++)
+        {
+            if (BudgetExceeded()) return;
+            Face tri = mesh.GetFace(i);
+            glm::dvec3 a = mesh.GetPoint(tri.i0);
+            glm::dvec3 b = mesh.GetPoint(tri.i1);
+            glm::dvec3 c = mesh.GetPoint(tri.i2);
 
-            if(isInside2Loc.loc != isInside2Loc_B.loc)
-            {
-                auto isInside2Loc_C = isInsideMesh(triCenter, n, *bvh2.ptr, bvh2, extraDir2, true);
-                if(isInside2Loc_C.loc == isInside2Loc_B.loc){isInside2Loc = isInside2Loc_B;}
-                else if(isInside2Loc_B.loc != isInside2Loc_C.loc && isInside2Loc.loc != isInside2Loc_C.loc)
-                {
-                    isInside2Loc = isInside2Loc_B;
-                }
-            }
+            glm::dvec3 n = computeNormal(a, b, c);
+
+            auto [isInside1Loc, isInside2Loc] = locateClipFace(i, regions, located, locate);
 
             auto isInside1 = isInside1Loc.loc;
             auto isInside2 = isInside2Loc.loc;
@@ -1,9 +1,9 @@
 #pragma once
 
-inline double _TOLERANCE_PLANE_INTERSECTION = 1.0E-04;
-inline double _TOLERANCE_PLANE_DEVIATION = 1.0E-04;
-inline double _TOLERANCE_BACK_DEVIATION_DISTANCE = 1.0E-04;
-inline double _TOLERANCE_INSIDE_OUTSIDE_PERIMETER = 1.0E-10;
+inline thread_local double _TOLERANCE_PLANE_INTERSECTION = 1.0E-04;
+inline thread_local double _TOLERANCE_PLANE_DEVIATION = 1.0E-04;
+inline thread_local double _TOLERANCE_BACK_DEVIATION_DISTANCE = 1.0E-04;
+inline thread_local double _TOLERANCE_INSIDE_OUTSIDE_PERIMETER = 1.0E-10;
 
 constexpr bool messages = false;
 
@@ -11,7 +11,8 @@
     Also useful is the site
     https://iquilezles.org/articles/intersectors/
 
-    The constants TOLERANCE_INSIDE_OUTSIDE_PERIMETER and toleranceParallelTight are set in eps.h.
+    The constant toleranceParallelTight is set in eps.h.  The inside-outside test uses the exact orientation
+    predicate of predicates.h instead of a tolerance.
 
     The parameter infiniteLength is retained but not used.  It probably could be purged along with references elsewhere.
 */
@@ -20,6 +21,7 @@
 #include <glm/glm.hpp>
 #include "eps.h"
 #include "math.h"
+#include "predicates.h"
 using Vec = glm::dvec3;
 namespace fuzzybools
 {
@@ -103,50 +105,16 @@ namespace fuzzybools
                         Apply the inside-outside test to decide whether the point of intersection p lies inside
                         the triangle defined by v0, v1 and v2.
 
-                        The edges of the triangle are considered in turn.  For the vertex v0 and the edge defined by
-                        the vector from v0 to v1, the vectors
-                            edge0 = (v1 - v0)
-                        and
-                            v0p = (p - v0)
-                        both lie in the plane, so vector
-                            c = edge0 x v0p
-                        is perpendicular to the plane.  If c and n point in opposite directions, then point p lies to the
-                        right of edge0, and so will lie outside the triangle.  In that case, return false.
-
-                        Check the other vertices and edges similarly.
+                        The line through origin and end passes each edge on one side, given by the sign of the
+                        volume of the tetrahedron spanned by the edge, end and origin.  The line pierces the triangle
+                        when no two edges are passed on opposite sides.  The signs come from the exact orientation
+                        predicate, so rays through a shared edge or vertex are classified the same way for every
+                        triangle that shares it.
                 */
-
-                Vec c;
-                double cLength = 0.0;
-
-                // edge 0
-                Vec edge0 = v1 - v0;
-                Vec v0p = p - v0;
-                c = glm::cross(edge0, v0p);
-                cLength = c.length();
-                double valdot = glm::dot(n, c);
-                //      if (glm::dot(n, c) < -TOLERANCE_INSIDE_OUTSIDE_PERIMETER * nLength * cLength) return false;
-                if (valdot < -_TOLERANCE_INSIDE_OUTSIDE_PERIMETER)
-                        return false;
-
-                // edge 1
-                Vec edge1 = v2 - v1;
-                Vec v1p = p - v1;
-                c = glm::cross(edge1, v1p);
-                cLength = c.length();
-                valdot = glm::dot(n, c);
-                //      if (glm::dot(n, c) < -TOLERANCE_INSIDE_OUTSIDE_PERIMETER * nLength * cLength) return false;
-                if (valdot < -_TOLERANCE_INSIDE_OUTSIDE_PERIMETER)
-                        return false;
-
-                // edge 2
-                Vec edge2 = v0 - v2;
-                Vec v2p = p - v2;
-                c = glm::cross(edge2, v2p);
-                cLength = c.length();
-                valdot = glm::dot(n, c);
-                //      if (glm::dot(n, c) < -TOLERANCE_INSIDE_OUTSIDE_PERIMETER * nLength * cLength) return false;
-                if (valdot < -_TOLERANCE_INSIDE_OUTSIDE_PERIMETER)
+                const int side0 = predicates::Orient3D(v0, v1, end, origin);
+                const int side1 = predicates::Orient3D(v1, v2, end, origin);
+                const int side2 = predicates::Orient3D(v2, v0, end, origin);
+                if ((side0 < 0 || side1 < 0 || side2 < 0) && (side0 > 0 || side1 > 0 || side2 > 0))
                         return false;
 
                 hitPosition = p;
@@ -6,6 +6,7 @@
 #include "intersect-ray-tri.h"
 #include "geometry.h"
 #include "bvh.h"
+#include "loop-finder.h"
 #include <set>
 
 namespace fuzzybools
@@ -15,7 +16,7 @@ namespace fuzzybools
         glm::dvec2 t1, 
         glm::dvec2 t2, 
         glm::dvec2 t3, 
-        const std::set<std::pair<size_t, size_t>>& edges, 
+        const EdgeAdjacency& adjacency, 
         const std::vector<glm::dvec2>& projectedPoints)
     {
         // Compute the centroid of the triangle
@@ -24,7 +25,7 @@ namespace fuzzybools
         // Use the ray casting algorithm to determine if the centroid is inside the polygon
         int crossings = 0;
 
-        for (const auto& edge : edges) {
+        adjacency.ForEachEdgeAcrossY(centroid.y, [&](const std::pair<size_t, size_t>& edge) {
             glm::dvec2 p1 = projectedPoints[edge.first];
             glm::dvec2 p2 = projectedPoints[edge.second];
 
@@ -36,7 +37,7 @@ namespace fuzzybools
                     crossings++;
                 }
             }
-        }
+        });
 
         // If crossings are odd, the point is inside the polygon
         return (crossings % 2) == 1;
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <set>
-#include <unordered_map>
 #include <optional>
 
 #include "math.h"
@@ -28,6 +29,136 @@ namespace fuzzybools
         }
     };
 
+    // the contour edges of one plane, built once and shared by loop finding, the inside test of its triangles and the CDT
+    // constraints. Neighbours are kept in compressed rows, ascending and without duplicates, and edges by the bands of y
+    // they span, so that a horizontal ray only visits the edges of the band it is cast in
+    struct EdgeAdjacency
+    {
+        // in the order of the set they were built from
+        std::vector<std::pair<size_t, size_t>> edges;
+
+        EdgeAdjacency(const std::vector<glm::dvec2>& points, const std::set<std::pair<size_t, size_t>>& edgeSet) : edges(edgeSet.begin(), edgeSet.end())
+        {
+            size_t pointCount = points.size();
+            for (auto& edge : edges)
+            {
+                pointCount = std::max(pointCount, std::max(edge.first, edge.second) + 1);
+            }
+
+            _offsets.assign(pointCount + 1, 0);
+            for (auto& edge : edges)
+            {
+                _offsets[edge.first + 1]++;
+                _offsets[edge.second + 1]++;
+            }
+            for (size_t i = 0; i < pointCount; i++)
+            {
+                _offsets[i + 1] += _offsets[i];
+            }
+            _neighbours.resize(_offsets.back());
+            std::vector<size_t> fill(_offsets.begin(), _offsets.end() - 1);
+            for (auto& edge : edges)
+            {
+                _neighbours[fill[edge.first]++] = edge.second;
+                _neighbours[fill[edge.second]++] = edge.first;
+            }
+            // rows are sorted and deduplicated in place, then compacted
+            size_t write = 0;
+            for (size_t i = 0; i < pointCount; i++)
+            {
+                auto begin = _neighbours.begin() + _offsets[i];
+                auto end = _neighbours.begin() + _offsets[i + 1];
+                std::sort(begin, end);
+                end = std::unique(begin, end);
+                _offsets[i] = write;
+                write = std::copy(begin, end, _neighbours.begin() + write) - _neighbours.begin();
+            }
+            _offsets[pointCount] = write;
+            _neighbours.resize(write);
+
+            if (edges.empty())
+            {
+                return;
+            }
+            _minY = DBL_MAX;
+            _maxY = -DBL_MAX;
+            for (auto& edge : edges)
+            {
+                _minY = std::min(_minY, std::min(points[edge.first].y, points[edge.second].y));
+                _maxY = std::max(_maxY, std::max(points[edge.first].y, points[edge.second].y));
+            }
+            // the square root keeps the bands of long edges in check, plane contours are mostly short segments
+            const size_t bandCount = static_cast<size_t>(std::sqrt(static_cast<double>(edges.size()))) * 2 + 1;
+            _bandHeight = (_maxY - _minY) / bandCount;
+            _bandOffsets.assign(bandCount + 1, 0);
+            auto forEachBand = [&](const std::pair<size_t, size_t>& edge, auto&& f)
+            {
+                const double y1 = points[edge.first].y;
+                const double y2 = points[edge.second].y;
+                const size_t last = GetBand(std::max(y1, y2));
+                for (size_t band = GetBand(std::min(y1, y2)); band <= last; band++)
+                {
+                    f(band);
+                }
+            };
+            for (auto& edge : edges)
+            {
+                forEachBand(edge, [&](size_t band) { _bandOffsets[band + 1]++; });
+            }
+            for (size_t i = 0; i < bandCount; i++)
+            {
+                _bandOffsets[i + 1] += _bandOffsets[i];
+            }
+            _bandEdges.resize(_bandOffsets.back());
+            std::vector<size_t> bandFill(_bandOffsets.begin(), _bandOffsets.end() - 1);
+            for (size_t i = 0; i < edges.size(); i++)
+            {
+                forEachBand(edges[i], [&](size_t band) { _bandEdges[bandFill[band]++] = i; });
+            }
+        }
+
+        const size_t* NeighboursBegin(size_t point) const
+        {
+            return point + 1 < _offsets.size() ? _neighbours.data() + _offsets[point] : nullptr;
+        }
+
+        const size_t* NeighboursEnd(size_t point) const
+        {
+            return point + 1 < _offsets.size() ? _neighbours.data() + _offsets[point + 1] : nullptr;
+        }
+
+        // calls f with every edge that has one end above y and the other not, and possibly some others of its band
+        template <typename F>
+        void ForEachEdgeAcrossY(double y, F f) const
+        {
+            if (!(y >= _minY && y < _maxY))
+            {
+                return;
+            }
+            const size_t band = GetBand(y);
+            for (size_t i = _bandOffsets[band]; i < _bandOffsets[band + 1]; i++)
+            {
+                f(edges[_bandEdges[i]]);
+            }
+        }
+
+    private:
+        size_t GetBand(double y) const
+        {
+            const double scaled = _bandHeight > 0 ? (y - _minY) / _bandHeight : 0;
+            const size_t bandCount = _bandOffsets.size() - 1;
+            return std::isfinite(scaled) ? std::min(static_cast<size_t>(std::max(scaled, 0.0)), bandCount - 1) : 0;
+        }
+
+        std::vector<size_t> _offsets;
+        std::vector<size_t> _neighbours;
+        double _minY = 0;
+        double _maxY = 0;
+        double _bandHeight = 0;
+        std::vector<size_t> _bandOffsets;
+        std::vector<size_t> _bandEdges;
+    };
+
     // assume points vector is non overlapping, assume id is not in loop
     inline bool IsPointInsideLoop(const std::vector<glm::dvec2>& points, Loop& loop, glm::dvec2 pt)
     {
@@ -100,21 +231,18 @@ namespace fuzzybools
     }
 
 
-    inline Loop FindOuterLoop(const std::vector<glm::dvec2>& points, const std::set<std::pair<size_t, size_t>>& edges, bool forward)
+    inline Loop FindOuterLoop(const std::vector<glm::dvec2>& points, const EdgeAdjacency& adjacency, bool forward)
     {
         Loop result;
 
-        std::unordered_map<size_t, std::set<size_t>> connections;
-
-        for (auto& edge : edges)
+        if (adjacency.edges.empty())
         {
-            connections[edge.first].insert(edge.second);
-            connections[edge.second].insert(edge.first);
+            return result;
         }
 
         // keep walking right, if we find a ccw loop, we're good. If its not ccw, we invert current/prev
-        size_t cur = edges.begin()->first;
-        size_t prev = edges.begin()->second;
+        size_t cur = adjacency.edges.front().first;
+        size_t prev = adjacency.edges.front().second;
         if (forward)
         {
             std::swap(cur, prev);
@@ -140,29 +268,23 @@ namespace fuzzybools
                 break;
             }
 
-            // TODO: copy
-            std::set<size_t> nbs = connections[cur];
-
-            nbs.erase(prev);
-            nbs.erase(cur);
-
-            if (nbs.empty())
-            {
-                // broken poly
-                if (messages) {  printf("Found vert without neighbours other than the origin of this search!\n"); }
-                loop.clear();
-                return result;
-            }
-
             // find right-hand neighbour with narrowest "turn"
             double maxSign = -DBL_MAX;
             size_t maxNB = 0;
+            bool hasNB = false;
 
             auto& a = points[prev];
             auto& b = points[cur];
 
-            for (auto& nb : nbs)
+            for (auto nbIt = adjacency.NeighboursBegin(cur); nbIt != adjacency.NeighboursEnd(cur); nbIt++)
             {
+                const size_t nb = *nbIt;
+                if (nb == prev || nb == cur)
+                {
+                    continue;
+                }
+                hasNB = true;
+
                 auto& p = points[nb];
 
                 double sign = ComparableAngle(p, a, b);
@@ -174,6 +296,14 @@ namespace fuzzybools
                 }
             }
 
+            if (!hasNB)
+            {
+                // broken poly
+                if (messages) {  printf("Found vert without neighbours other than the origin of this search!\n"); }
+                loop.clear();
+                return result;
+            }
+
             // assign maxNB to cur
             prev = cur;
             cur = maxNB;
@@ -184,10 +314,15 @@ namespace fuzzybools
         return result;
     }
 
-    inline Loop FindLargestEdgeLoop(const std::vector<glm::dvec2>& points, const std::set<std::pair<size_t, size_t>>& edges)
+    inline Loop FindOuterLoop(const std::vector<glm::dvec2>& points, const std::set<std::pair<size_t, size_t>>& edges, bool forward)
+    {
+        return FindOuterLoop(points, EdgeAdjacency(points, edges), forward);
+    }
+
+    inline Loop FindLargestEdgeLoop(const std::vector<glm::dvec2>& points, const EdgeAdjacency& adjacency)
     {
-        auto l1 = FindOuterLoop(points, edges, false);
-        auto l2 = FindOuterLoop(points, edges, true);
+        auto l1 = FindOuterLoop(points, adjacency, false);
+        auto l2 = FindOuterLoop(points, adjacency, true);
 
         if (AInsideB(points, l1, l2))
         {
@@ -198,4 +333,9 @@ namespace fuzzybools
             return l1;
         }
     }
+
+    inline Loop FindLargestEdgeLoop(const std::vector<glm::dvec2>& points, const std::set<std::pair<size_t, size_t>>& edges)
+    {
+        return FindLargestEdgeLoop(points, EdgeAdjacency(points, edges));
+    }
 }
@@ -0,0 +1,167 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/*
+    Adaptive precision orientation predicate after J. R. Shewchuk, "Adaptive Precision Floating-Point Arithmetic
+    and Fast Robust Geometric Predicates".  The determinant is first computed in plain floating point, and only
+    when its magnitude is below the rounding error bound it is recomputed exactly with expansion arithmetic, so the
+    common case costs the same as the unfiltered determinant.
+*/
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <glm/glm.hpp>
+
+namespace fuzzybools
+{
+    namespace predicates
+    {
+        constexpr double EPSILON = std::numeric_limits<double>::epsilon() / 2;
+        constexpr double ORIENT3D_ERROR_BOUND = (7.0 + 56.0 * EPSILON) * EPSILON;
+        // 2^27 + 1, splits a double into two non-overlapping halves of 26 bits
+        constexpr double SPLITTER = 134217729.0;
+
+        inline void TwoSum(double a, double b, double &sum, double &error)
+        {
+            sum = a + b;
+            const double bVirtual = sum - a;
+            const double aVirtual = sum - bVirtual;
+            error = (a - aVirtual) + (b - bVirtual);
+        }
+
+        inline void Split(double a, double &high, double &low)
+        {
+            const double c = SPLITTER * a;
+            high = c - (c - a);
+            low = a - high;
+        }
+
+        inline void TwoProduct(double a, double b, double &product, double &error)
+        {
+            product = a * b;
+            double aHigh, aLow, bHigh, bLow;
+            Split(a, aHigh, aLow);
+            Split(b, bHigh, bLow);
+            error = aLow * bLow - (((product - aHigh * bHigh) - aLow * bHigh) - aHigh * bLow);
+        }
+
+        // an exact sum of N doubles at most, the terms do not overlap and grow in magnitude
+        template <size_t N>
+        struct Expansion
+        {
+            std::array<double, N> terms;
+            size_t size = 0;
+
+            // adds value without rounding, zero terms are dropped
+            void Grow(double value)
+            {
+                size_t count = 0;
+                double sum = value;
+                for (size_t i = 0; i < size; i++)
+                {
+                    double error;
+                    TwoSum(sum, terms[i], sum, error);
+                    if (error != 0)
+                    {
+                        terms[count++] = error;
+                    }
+                }
+                if (sum != 0)
+                {
+                    terms[count++] = sum;
+                }
+                size = count;
+            }
+
+            // adds sign * a * b without rounding, sign is 1 or -1
+            template <size_t A, size_t B>
+            void GrowProduct(const Expansion<A> &a, const Expansion<B> &b, double sign)
+            {
+                for (size_t i = 0; i < a.size; i++)
+                {
+                    for (size_t j = 0; j < b.size; j++)
+                    {
+                        double product, error;
+                        TwoProduct(a.terms[i], sign * b.terms[j], product, error);
+                        Grow(error);
+                        Grow(product);
+                    }
+                }
+            }
+
+            // the largest term decides the sign of the sum
+            int Sign() const
+            {
+                if (size == 0)
+                {
+                    return 0;
+                }
+                return terms[size - 1] > 0 ? 1 : -1;
+            }
+        };
+
+        inline Expansion<2> Difference(double a, double b)
+        {
+            Expansion<2> result;
+            result.Grow(a);
+            result.Grow(-b);
+            return result;
+        }
+
+        inline int Orient3DExact(const glm::dvec3 &a, const glm::dvec3 &b, const glm::dvec3 &c, const glm::dvec3 &d)
+        {
+            const Expansion<2> ad[3] = {Difference(a.x, d.x), Difference(a.y, d.y), Difference(a.z, d.z)};
+            const Expansion<2> bd[3] = {Difference(b.x, d.x), Difference(b.y, d.y), Difference(b.z, d.z)};
+            const Expansion<2> cd[3] = {Difference(c.x, d.x), Difference(c.y, d.y), Difference(c.z, d.z)};
+
+            // expanded along the x column, every minor holds 16 terms at most and every product with it 64
+            Expansion<192> determinant;
+            const Expansion<2> *rows[3] = {ad, bd, cd};
+            for (int i = 0; i < 3; i++)
+            {
+                const Expansion<2> *first = rows[(i + 1) % 3];
+                const Expansion<2> *second = rows[(i + 2) % 3];
+                Expansion<16> minor;
+                minor.GrowProduct(first[1], second[2], 1);
+                minor.GrowProduct(first[2], second[1], -1);
+                determinant.GrowProduct(rows[i][0], minor, 1);
+            }
+            return determinant.Sign();
+        }
+
+        // the sign of det[a - d, b - d, c - d]: positive when d lies below the plane through a, b and c, which appear
+        // counterclockwise seen from above, zero only when the four points are exactly coplanar
+        inline int Orient3D(const glm::dvec3 &a, const glm::dvec3 &b, const glm::dvec3 &c, const glm::dvec3 &d)
+        {
+            const double adx = a.x - d.x, ady = a.y - d.y, adz = a.z - d.z;
+            const double bdx = b.x - d.x, bdy = b.y - d.y, bdz = b.z - d.z;
+            const double cdx = c.x - d.x, cdy = c.y - d.y, cdz = c.z - d.z;
+
+            const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+            const double cdxady = cdx * ady, adxcdy = adx * cdy;
+            const double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+            const double determinant = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+            const double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * std::fabs(adz) +
+                                     (std::fabs(cdxady) + std::fabs(adxcdy)) * std::fabs(bdz) +
+                                     (std::fabs(adxbdy) + std::fabs(bdxady)) * std::fabs(cdz);
+
+            const double bound = ORIENT3D_ERROR_BOUND * permanent;
+            if (determinant > bound)
+            {
+                return 1;
+            }
+            if (-determinant > bound)
+            {
+                return -1;
+            }
+            // NaN coordinates end up here as well
+            return Orient3DExact(a, b, c, d);
+        }
+    }
+}
@@ -18,11 +18,13 @@
 #include "bvh.h"
 #include "util.h"
 #include "svg.h"
+#include "budget.h"
 #include "math.h"
 #include "loop-finder.h"
 #include "obj-exporter.h"
 #include "is-inside-mesh.h"
 #include "is-inside-boundary.h"
+#include "spatial-hash.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/norm.hpp>
@@ -87,7 +89,7 @@ namespace fuzzybools
 
         Line()
         {
-            static size_t idcounter = 0;
+            static thread_local size_t idcounter = 0;
             idcounter++;
             globalID = idcounter;
         }
@@ -226,7 +228,7 @@ namespace fuzzybools
 
         Point()
         {
-            static size_t idcounter = 0;
+            static thread_local size_t idcounter = 0;
             idcounter++;
             globalID = idcounter;
         }
@@ -254,6 +256,8 @@ namespace fuzzybools
         Vec3 normal;
 
         std::vector<Line> lines;
+        // line ids by unit direction
+        SpatialHash<3> lineDirections = SpatialHash<3>(EPS_SMALL);
         AABB aabb;
 
         //============================================================================================
@@ -267,7 +271,7 @@ namespace fuzzybools
 
         Plane()
         {
-            static size_t idcounter = 0;
+            static thread_local size_t idcounter = 0;
             idcounter++;
             globalID = idcounter;
         }
@@ -350,22 +354,31 @@ namespace fuzzybools
 
         std::pair<size_t, bool> AddLine(const Vec3 &pos, const Vec3 &dir)
         {
-            for (auto &line : lines)
+            // only lines with the same or the opposite direction can be equal, the first equal line is taken
+            Vec3 temp = glm::normalize(dir);
+            size_t equalLine = SIZE_MAX;
+            auto check = [&](size_t id)
             {
-                if (line.IsEqualTo(pos, dir))
+                if (id < equalLine && lines[id].IsEqualTo(pos, dir))
                 {
-                    return {line.id, false};
+                    equalLine = id;
                 }
+            };
+            lineDirections.ForEachNear({temp.x, temp.y, temp.z}, check);
+            lineDirections.ForEachNear({-temp.x, -temp.y, -temp.z}, check);
+            if (equalLine != SIZE_MAX)
+            {
+                return {equalLine, false};
             }
 
             Line l;
             l.id = lines.size();
             l.origin = pos;
             //          l.direction = dir;
-            Vec3 temp = glm::normalize(dir);
             l.direction = temp;
 
             lines.push_back(l);
+            lineDirections.Add({temp.x, temp.y, temp.z}, l.id);
 
             return {l.id, true};
         }
@@ -374,6 +387,8 @@ namespace fuzzybools
 
         void RemoveLastLine()
         {
+            const Vec3 &direction = lines.back().direction;
+            lineDirections.Remove({direction.x, direction.y, direction.z}, lines.back().id);
             lines.pop_back();
         }
 
@@ -528,6 +543,8 @@ namespace fuzzybools
 
         std::map<size_t, std::vector<std::pair<size_t, size_t>>> planeSegments;
         std::map<size_t, std::map<std::pair<size_t, size_t>, size_t>> planeSegmentCounts;
+        // triangle ids by point, in the order the triangles were added
+        std::unordered_map<size_t, std::vector<size_t>> pointTriangles;
 
         //============================================================================================
 
@@ -566,23 +583,29 @@ namespace fuzzybools
             t.c = c;
 
             triangles.push_back(t);
+
+            pointTriangles[a].push_back(t.id);
+            if (b != a)
+            {
+                pointTriangles[b].push_back(t.id);
+            }
+            if (c != a && c != b)
+            {
+                pointTriangles[c].push_back(t.id);
+            }
         }
 
         //============================================================================================
 
         std::vector<size_t> GetTrianglesWithPoint(size_t p)
         {
-            std::vector<size_t> returnTriangles;
-
-            for (auto &t : triangles)
+            auto it = pointTriangles.find(p);
+            if (it == pointTriangles.end())
             {
-                if (t.HasPoint(p))
-                {
-                    returnTriangles.push_back(t.id);
-                }
+                return {};
             }
 
-            return returnTriangles;
+            return it->second;
         }
 
         //============================================================================================
@@ -591,11 +614,17 @@ namespace fuzzybools
         {
             std::vector<size_t> returnTriangles;
 
-            for (auto &t : triangles)
+            auto it = pointTriangles.find(a);
+            if (it == pointTriangles.end())
+            {
+                return returnTriangles;
+            }
+
+            for (auto id : it->second)
             {
-                if (t.HasPoint(a) && t.HasPoint(b))
+                if (triangles[id].HasPoint(b))
                 {
-                    returnTriangles.push_back(t.id);
+                    returnTriangles.push_back(id);
                 }
             }
 
@@ -667,6 +696,11 @@ namespace fuzzybools
         std::vector<Point> points;
         std::vector<Plane> planes;
 
+        // point ids by location, plane ids by distance and by the plane they were made from
+        SpatialHash<3> pointLocations = SpatialHash<3>(toleranceVectorEquality);
+        SpatialHash<1> planeDistances = SpatialHash<1>(TOLERANCE_SCALAR_EQUALITY);
+        std::unordered_map<uint32_t, size_t> planeByRef;
+
         SegmentSet A;
         SegmentSet B;
 
@@ -842,12 +876,17 @@ namespace fuzzybools
 
         size_t AddPoint(const Vec3 &newPoint)
         {
-            for (auto &pt : points)
-            {
-                if (pt == newPoint)
+            // the first equal point is taken
+            size_t equalPoint = SIZE_MAX;
+            pointLocations.ForEachNear({newPoint.x, newPoint.y, newPoint.z}, [&](size_t id)
+                                       {
+                if (id < equalPoint && points[id] == newPoint)
                 {
-                    return pt.id;
-                }
+                    equalPoint = id;
+                } });
+            if (equalPoint != SIZE_MAX)
+            {
+                return equalPoint;
             }
 
             Point p;
@@ -855,6 +894,7 @@ namespace fuzzybools
             p.location3D = newPoint;
 
             points.push_back(p);
+            pointLocations.Add({newPoint.x, newPoint.y, newPoint.z}, p.id);
 
             return p.id;
         }
@@ -863,12 +903,21 @@ namespace fuzzybools
 
         size_t AddPlane(const Vec3 &normal, double d, uint32_t refId)
         {
-            for (auto &plane : planes)
+            // the first plane made from refId or equal to normal and d is taken
+            size_t equalPlane = SIZE_MAX;
+            if (auto it = planeByRef.find(refId); it != planeByRef.end())
             {
-                if (plane.refPlane == refId || plane.IsEqualTo(normal, d))
+                equalPlane = it->second;
+            }
+            planeDistances.ForEachNear({d}, [&](size_t id)
+                                       {
+                if (id < equalPlane && planes[id].IsEqualTo(normal, d))
                 {
-                    return plane.id;
-                }
+                    equalPlane = id;
+                } });
+            if (equalPlane != SIZE_MAX)
+            {
+                return equalPlane;
             }
 
             Plane p;
@@ -877,6 +926,8 @@ namespace fuzzybools
             p.normal = glm::normalize(normal);
             p.distance = d;
             planes.push_back(p);
+            planeDistances.Add({d}, p.id);
+            planeByRef.try_emplace(refId, p.id);
 
             return p.id;
         }
@@ -902,6 +953,7 @@ namespace fuzzybools
 #ifdef CSG_DEBUG_OUTPUT
             Geometry relevant;
 #endif
+            auto secondBVH = MakeBVH(secondGeom);
 
             for (size_t i = 0; i < geom.numFaces; i++)
             {
@@ -923,18 +975,7 @@ namespace fuzzybools
                     continue;
                 }
 
-                bool contact = false;
-
-                for (size_t j = 0; j < secondGeom.numFaces; j++)
-                {
-                    auto faceBox2 = secondGeom.GetFaceBox(j);
-
-                    if (faceBox.intersects(faceBox2))
-                    {
-                        contact = true;
-                        break;
-                    }
-                }
+                bool contact = secondBVH.IntersectsBox(faceBox);
 
                 if (!contact)
                 {
@@ -1306,9 +1347,11 @@ namespace fuzzybools
             // DumpSVGLines(edgesPrinted, L"poly.html");
 #endif
 
+            const EdgeAdjacency adjacency(projectedPoints, edges);
+
             CDT::Triangulation<double> cdt(CDT::VertexInsertionOrder::AsProvided);
             std::vector<CDT::Edge> cdt_edges;
-            cdt_edges.reserve(edges.size());
+            cdt_edges.reserve(adjacency.edges.size());
 
             std::vector<CDT::V2d<double>> cdt_verts;
             cdt_verts.reserve(projectedPoints.size());
@@ -1318,7 +1361,7 @@ namespace fuzzybools
                 cdt_verts.emplace_back(CDT::V2d<double>::make(point.x, point.y));
             }
 
-            for (auto &edge : edges)
+            for (auto &edge : adjacency.edges)
             {
                 cdt_edges.emplace_back((uint32_t)edge.first, (uint32_t)edge.second);
             }
@@ -1332,7 +1375,7 @@ namespace fuzzybools
 
             auto triangles = cdt.triangles;
 
-            // auto contourLoop = FindLargestEdgeLoop(projectedPoints, edges);
+            // auto contourLoop = FindLargestEdgeLoop(projectedPoints, adjacency);
 
 #ifdef CSG_DEBUG_OUTPUT
             // std::vector<std::vector<glm::dvec2>> edges3DTriangles;
@@ -1394,7 +1437,7 @@ namespace fuzzybools
                 glm::dvec2 t2 = projectedPoints[tri.vertices[1]];
                 glm::dvec2 t3 = projectedPoints[tri.vertices[2]];
 
-                bool inside2d = isInsideBoundary(t1, t2, t3, edges, projectedPoints);
+                bool inside2d = isInsideBoundary(t1, t2, t3, adjacency, projectedPoints);
 
                 if (!inside2d)
                 {
@@ -1800,6 +1843,7 @@ namespace fuzzybools
         // put all points on lines/planes
         for (auto &p : sp.points)
         {
+            if (BudgetExceeded()) return Geometry();
             for (auto &plane : sp.planes)
             {
                 if (plane.IsPointOnPlane(p.location3D))
@@ -1812,12 +1856,14 @@ namespace fuzzybools
 
         for (auto &plane : sp.planes)
         {
+            if (BudgetExceeded()) return Geometry();
             AddLineLineIsects(plane, sp);
         }
 
         // intersect planes
         for (size_t planeAIndex = 0; planeAIndex < sp.planes.size(); planeAIndex++)
         {
+            if (BudgetExceeded()) return Geometry();
             for (size_t planeBIndex = 0; planeBIndex < sp.planes.size(); planeBIndex++)
             {
                 auto &planeA = sp.planes[planeAIndex];
@@ -1883,11 +1929,13 @@ namespace fuzzybools
 
         for (auto &plane : sp.planes)
         {
+            if (BudgetExceeded()) return Geometry();
             AddLineLineIsects(plane, sp);
         }
 
         for (auto &p : sp.points)
         {
+            if (BudgetExceeded()) return Geometry();
             for (auto &plane : sp.planes)
             {
                 if (plane.IsPointOnPlane(p.location3D))
@@ -1904,6 +1952,7 @@ namespace fuzzybools
         Geometry geom;
         for (auto &plane : sp.planes)
         {
+            if (BudgetExceeded()) return Geometry();
 
 #ifdef CSG_DEBUG_OUTPUT
             // std::vector<std::vector<glm::dvec2>> edges;
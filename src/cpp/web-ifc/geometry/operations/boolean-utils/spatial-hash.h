@@ -0,0 +1,102 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace fuzzybools
+{
+    // buckets ids by grid cell, a value that differs from a query by at most cellSize in every component lies in the
+    // query's cell or one of its direct neighbours. The caller decides which candidates match, an id can be reported
+    // more than once
+    template <size_t N>
+    struct SpatialHash
+    {
+        using Value = std::array<double, N>;
+
+        double cellSize;
+        std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+
+        explicit SpatialHash(double size) : cellSize(size) {}
+
+        void Add(const Value &value, size_t id)
+        {
+            buckets[GetKey(GetCell(value))].push_back(id);
+        }
+
+        void Remove(const Value &value, size_t id)
+        {
+            auto it = buckets.find(GetKey(GetCell(value)));
+            if (it == buckets.end())
+            {
+                return;
+            }
+            auto &ids = it->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty())
+            {
+                buckets.erase(it);
+            }
+        }
+
+        template <typename T>
+        void ForEachNear(const Value &value, T callback) const
+        {
+            const auto cell = GetCell(value);
+            std::array<int64_t, N> neighbour;
+            size_t count = 1;
+            for (size_t i = 0; i < N; i++)
+            {
+                count *= 3;
+            }
+            for (size_t offset = 0; offset < count; offset++)
+            {
+                size_t rest = offset;
+                for (size_t i = 0; i < N; i++)
+                {
+                    neighbour[i] = cell[i] + static_cast<int64_t>(rest % 3) - 1;
+                    rest /= 3;
+                }
+                auto it = buckets.find(GetKey(neighbour));
+                if (it == buckets.end())
+                {
+                    continue;
+                }
+                for (size_t id : it->second)
+                {
+                    callback(id);
+                }
+            }
+        }
+
+    private:
+        std::array<int64_t, N> GetCell(const Value &value) const
+        {
+            std::array<int64_t, N> cell;
+            for (size_t i = 0; i < N; i++)
+            {
+                const double scaled = value[i] / cellSize;
+                cell[i] = std::isfinite(scaled) ? static_cast<int64_t>(std::floor(std::clamp(scaled, -1.0e18, 1.0e18))) : 0;
+            }
+            return cell;
+        }
+
+        static uint64_t GetKey(const std::array<int64_t, N> &cell)
+        {
+            uint64_t key = 14695981039346656037ull;
+            for (size_t i = 0; i < N; i++)
+            {
+                key = (key ^ static_cast<uint64_t>(cell[i])) * 1099511628211ull;
+            }
+            return key;
+        }
+    };
+}
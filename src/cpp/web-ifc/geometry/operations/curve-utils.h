@@ -63,6 +63,9 @@ inline IfcCurve Build3DArc3Pt(const glm::dvec3 &p1, const glm::dvec3 &p2, const
 
     // Calculate the radius
     double radius = glm::distance(center, p1);
+    double sweep = std::acos(std::clamp(glm::dot(glm::normalize(p1 - center), glm::normalize(p2 - center)), -1.0, 1.0)) +
+                   std::acos(std::clamp(glm::dot(glm::normalize(p2 - center), glm::normalize(p3 - center)), -1.0, 1.0));
+    circleSegments = static_cast<uint16_t>(bimGeometry::GetArcPointCount(radius, sweep, circleSegments));
 
     // Using geometrical subdivision to create points on the arc
     std::vector<glm::dvec3> pointList;
@@ -136,6 +139,9 @@ inline IfcCurve Build3DArc3Pt(const glm::dvec3 &p1, const glm::dvec3 &p2, const
 		pCen.y = cenY;
 
 		double radius = sqrt(pow(cenX - p1.x, 2) + pow(cenY - p1.y, 2));
+		double sweep = std::acos(std::clamp(glm::dot(glm::normalize(p1 - pCen), glm::normalize(p2 - pCen)), -1.0, 1.0)) +
+					   std::acos(std::clamp(glm::dot(glm::normalize(p2 - pCen), glm::normalize(p3 - pCen)), -1.0, 1.0));
+		circleSegments = static_cast<uint16_t>(bimGeometry::GetArcPointCount(radius, sweep, circleSegments));
 
 			// Using geometrical subdivision to avoid complex calculus with angles
 
@@ -371,7 +377,10 @@ inline IfcCurve Build3DArc3Pt(const glm::dvec3 &p1, const glm::dvec3 &p2, const
 	{
 		spdlog::debug("[GetEllipseCurve({})]");
 		IfcCurve c;
-		
+
+		// the placement may scale the ellipse
+		const double scale = std::max(glm::length(glm::dvec2(placement[0])), glm::length(glm::dvec2(placement[1])));
+		numSegments = bimGeometry::GetArcPointCount(std::max(std::fabs(radiusX), std::fabs(radiusY)) * scale, endRad - startRad, numSegments);
 		c.points = (bimGeometry::GetEllipseCurve(radiusX, radiusY, numSegments, placement, startRad, endRad, swap, normalToCenterEnding)).points;
 
 		return c;
@@ -512,7 +521,7 @@ inline IfcCurve Build3DArc3Pt(const glm::dvec3 &p1, const glm::dvec3 &p2, const
 			right = glm::dvec3(EPS_BIG2, 0, 0);
 			glm::dvec3 up = glm::cross(axis, right);
 
-			auto curve2D = GetEllipseCurve(1, 1, _circleSegments, glm::dmat3(1), 0, angleRad, true, true);
+			auto curve2D = bimGeometry::GetEllipseCurve(1, 1, bimGeometry::GetArcPointCount(glm::length(right), angleRad, _circleSegments), glm::dmat3(1), 0, angleRad, true, true);
 
 			for (auto &pt2D : curve2D.points)
 			{
@@ -524,7 +533,7 @@ inline IfcCurve Build3DArc3Pt(const glm::dvec3 &p1, const glm::dvec3 &p2, const
 		{
 			glm::dvec3 up = glm::cross(axis, right);
 
-			auto curve2D = GetEllipseCurve(1, 1, _circleSegments, glm::dmat3(1), 0, angleRad, true);
+			auto curve2D = bimGeometry::GetEllipseCurve(1, 1, bimGeometry::GetArcPointCount(glm::length(right), angleRad, _circleSegments), glm::dmat3(1), 0, angleRad, true);
 
 			for (auto &pt2D : curve2D.points)
 			{
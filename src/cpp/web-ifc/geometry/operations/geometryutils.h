@@ -16,6 +16,7 @@
 #include "../representation/IfcGeometry.h"
 #include <mapbox/earcut.hpp>
 #include "bim-geometry/utils.h"
+#include "../../utility/arena.h"
 
 namespace mapbox::util {
 	template <>
@@ -37,6 +38,11 @@ namespace webifc::geometry
 		bimGeometry::SetEpsilons(TOLERANCE_SCALAR_EQUALITY, PLANE_REFIT_ITERATIONS, BOOLEAN_UNION_THRESHOLD);
 	}
 
+	inline void SetCircleChordTolerance(double CIRCLE_CHORD_TOLERANCE)
+	{
+		bimGeometry::SetCircleChordTolerance(CIRCLE_CHORD_TOLERANCE);
+	}
+
 	inline double angleConversion(double angle, std::string angleUnits)
 	{
 		if (angleUnits == "RADIAN")
@@ -108,6 +114,12 @@ namespace webifc::geometry
 		return ToIfcGeometry(bimGeometry::SweepCircular(scaling, closed, profile_vector, radius, directrix_vector, initialDirectrixNormal, rotate90));
 	}
 
+	inline IfcGeometry SweepDisk(const double scaling, const IfcProfile &profile, const IfcCurve &directrix)
+	{
+		spdlog::debug("[SweepDisk({})]");
+		return ToIfcGeometry(bimGeometry::SweepDisk(scaling, profile.curve.points, directrix.points));
+	}
+
 	inline bool computeSafeNormal(const glm::dvec3 v1, const glm::dvec3 v2, const glm::dvec3 v3, glm::dvec3 &normal, double eps = 0)
 	{
 		return bimGeometry::computeSafeNormal(v1, v2, v3, normal, eps);
@@ -185,17 +197,77 @@ namespace webifc::geometry
 		return computeSafeNormal(v1, v2, v3, normal, 1e-08);
 	}
 
+	// the normal of a loop that is convex and winds around once, such loops are fanned from their first point. Every turn of
+	// the loop and every triangle of the fan must turn the same way, which also rules out loops that wind around twice.
+	// Collinear and repeated points fail the test, those loops go to earcut
+	inline bool GetConvexLoopNormal(const std::vector<glm::dvec3> &points, glm::dvec3 &normal)
+	{
+		const size_t count = points.size();
+		const glm::dvec3 &origin = points[0];
+
+		glm::dvec3 area(0);
+		for (size_t i = 1; i + 1 < count; i++)
+		{
+			area += glm::cross(points[i] - origin, points[i + 1] - origin);
+		}
+		const double length = glm::length(area);
+		if (!(length > 0))
+		{
+			return false;
+		}
+		normal = area / length;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const glm::dvec3 &previous = points[(i + count - 1) % count];
+			const glm::dvec3 &current = points[i];
+			const glm::dvec3 &next = points[(i + 1) % count];
+			const glm::dvec3 in = current - previous;
+			const glm::dvec3 out = next - current;
+			if (glm::dot(glm::cross(in, out), normal) <= EPS_TINY * glm::length(in) * glm::length(out))
+			{
+				return false;
+			}
+			if (i > 0 && i + 1 < count)
+			{
+				const glm::dvec3 first = current - origin;
+				const glm::dvec3 second = next - origin;
+				if (glm::dot(glm::cross(first, second), normal) <= EPS_TINY * glm::length(first) * glm::length(second))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
 	inline void TriangulateBounds(IfcGeometry &geometry, std::vector<IfcBound3D> &bounds, uint32_t expressID)
 	{
 		spdlog::debug("[TriangulateBounds({})]");
+		glm::dvec3 convexNormal;
 		if (bounds.size() == 1 && bounds[0].curve.points.size() == 3)
 		{
-			auto c = bounds[0].curve;
+			const auto &c = bounds[0].curve;
 
 			// size_t offset = geometry.numPoints;
 
 			geometry.AddFace(c.points[0], c.points[1], c.points[2]);
 		}
+		else if (bounds.size() == 1 && bounds[0].curve.points.size() >= 4 && GetConvexLoopNormal(bounds[0].curve.points, convexNormal))
+		{
+			// the fan keeps the winding of the loop, as earcut does for the loops it gets in counterclockwise order
+			uint32_t offset = geometry.numPoints;
+			const auto &points = bounds[0].curve.points;
+			for (const glm::dvec3 &pt : points)
+			{
+				geometry.AddPoint(pt, convexNormal);
+			}
+			for (uint32_t i = 1; i + 1 < points.size(); i++)
+			{
+				geometry.AddFace(offset, offset + i, offset + i + 1, -1);
+			}
+		}
 		else if (bounds.size() > 0 && bounds[0].curve.points.size() >= 3)
 		{
 			// bound greater than 4 vertices or with holes, triangulate
@@ -268,7 +340,7 @@ namespace webifc::geometry
 				std::swap(v12, v13);
 			}
 
-			std::vector<std::vector<glm::dvec2>> polygon(bounds.size());
+			std::pmr::vector<std::pmr::vector<glm::dvec2>> polygon(bounds.size(), utility::TransientMemory());
 
 			for (size_t i = 0; i < bounds.size(); i++)
 			{
@@ -506,39 +578,143 @@ namespace webifc::geometry
 		return geom;
 	}
 
-	inline IfcGeometry Extrude(IfcProfile profile, glm::dvec3 dir, double distance, glm::dvec3 cuttingPlaneNormal = glm::dvec3(0), glm::dvec3 cuttingPlanePos = glm::dvec3(0))
+	// calls callback(point, loop, loopStart) for the points of an extrusion cap in the order the cap triangulation refers
+	// to them: the outer loop of the profile, closed when it does not end where it starts, then the holes as they are
+	template <typename T>
+	inline void ForEachCapPoint(const IfcProfile &profile, const T &callback)
+	{
+		const auto &outer = profile.curve.points;
+		for (size_t i = 0; i < outer.size(); i++)
+		{
+			callback(outer[i], 0, i == 0);
+		}
+		if (glm::length(outer.front() - outer.back()) > 1e-8)
+		{
+			callback(outer.front(), 0, false);
+		}
+		for (size_t i = 0; i < profile.holes.size(); i++)
+		{
+			const auto &hole = profile.holes[i].points;
+			for (size_t j = 0; j < hole.size(); j++)
+			{
+				callback(hole[j], i + 1, j == 0);
+			}
+		}
+	}
+
+	// the triangles of an extrusion cap as earcut returns them, they do not depend on the extrusion, so one triangulation
+	// serves both caps and every extrusion of the same profile
+	inline std::vector<uint32_t> TriangulateProfileCap(const IfcProfile &profile)
+	{
+		std::vector<std::vector<bimGeometry::Point>> polygon(profile.holes.size() + 1);
+		ForEachCapPoint(profile, [&](const glm::dvec3 &pt, size_t loop, bool)
+			{
+				polygon[loop].push_back({pt.x, pt.y, pt.z});
+			});
+
+		bimGeometry::Projection proj = bimGeometry::bestProjection(polygon[0]);
+		return mapbox::earcut<uint32_t>(bimGeometry::projectTo2D(polygon, proj));
+	}
+
+	// the buffers are sized up front for the caps and two side triangles per profile edge, the cap triangulation comes
+	// from TriangulateProfileCap for the same profile
+	inline IfcGeometry Extrude(const IfcProfile &profile, const std::vector<uint32_t> &capIndices, glm::dvec3 dir, double distance, glm::dvec3 cuttingPlaneNormal = glm::dvec3(0), glm::dvec3 cuttingPlanePos = glm::dvec3(0))
 	{
 		spdlog::debug("[Extrude({})]");
 
-		std::vector<bool> holesIndicesHash;
+		IfcGeometry geom;
 
-		// check if first point is equal to last point, otherwise the outer loop of the shape is not closed
-		glm::dvec3 lastToFirstPoint = profile.curve.points.front() - profile.curve.points.back();
-		if (glm::length(lastToFirstPoint) > 1e-8)
-		{
-			profile.curve.points.push_back(profile.curve.points.front());
-		}
+		uint32_t capSize = 0;
+		uint32_t sideCount = 0;
+		ForEachCapPoint(profile, [&](const glm::dvec3 &, size_t loop, bool loopStart)
+			{
+				// there is no side between a loop and the first point of the next hole
+				if (capSize > 0 && !(loop > 0 && loopStart))
+				{
+					sideCount++;
+				}
+				capSize++;
+			});
+
+		const size_t pointCount = 2 * capSize + 6 * sideCount;
+		const size_t faceCount = capIndices.size() / 3 * 2 + 2 * sideCount;
+		geom.vertexData.reserve(pointCount * VERTEX_FORMAT_SIZE_FLOATS);
+		geom.indexData.reserve(faceCount * 3);
+		geom.planeData.reserve(faceCount);
 
-		std::vector<std::vector<glm::dvec3>> profile_vector;
-		std::vector<glm::dvec3> profile_contour;
-		for (size_t i = 0; i < profile.curve.points.size(); i++)
+		ForEachCapPoint(profile, [&](const glm::dvec3 &pt, size_t, bool)
+			{
+				geom.AddPoint(pt + dir * distance, dir);
+			});
+
+		// the top cap is turned to face up, the bottom cap is the reverse of earcut's order
+		bool flipWinding = false;
+		if (capIndices.size() >= 3)
 		{
-			profile_contour.push_back(profile.curve.points[i]);
+			flipWinding = !bimGeometry::GetWindingOfTriangle(geom.GetPoint(capIndices[0]), geom.GetPoint(capIndices[1]), geom.GetPoint(capIndices[2]));
 		}
-		profile_vector.push_back(profile_contour);
-		for (size_t i = 0; i < profile.holes.size(); i++)
+		for (size_t i = 0; i < capIndices.size(); i += 3)
 		{
-			std::vector<glm::dvec3> hole_contour;
-			IfcCurve hole = profile.holes[i];
-			int pointCount = hole.points.size();
-			for (int j = 0; j < pointCount; j++)
+			if (flipWinding)
 			{
-				hole_contour.push_back(hole.points[j]);
+				geom.AddFace(capIndices[i + 0], capIndices[i + 2], capIndices[i + 1], -1);
 			}
-			profile_vector.push_back(hole_contour);
+			else
+			{
+				geom.AddFace(capIndices[i + 0], capIndices[i + 1], capIndices[i + 2], -1);
+			}
+		}
+
+		const glm::dvec3 bottomNormal = -dir;
+		const bool cut = cuttingPlaneNormal != glm::dvec3(0);
+		const double ldotn = glm::dot(dir, cuttingPlaneNormal);
+		ForEachCapPoint(profile, [&](const glm::dvec3 &pt, size_t, bool)
+			{
+				glm::dvec3 et = pt;
+				if (cut && ldotn != 0)
+				{
+					// project {et} onto the plane, following the extrusion normal, we want to apply dist, even when negative
+					double dist = glm::dot(cuttingPlanePos - pt, cuttingPlaneNormal) / ldotn;
+					et = pt + dist * dir;
+				}
+				geom.AddPoint(et, bottomNormal);
+			});
+
+		for (size_t i = 0; i < capIndices.size(); i += 3)
+		{
+			geom.AddFace(capSize + capIndices[i + 0], capSize + capIndices[i + 2], capSize + capIndices[i + 1], -1);
 		}
 
-		return ToIfcGeometry(bimGeometry::Extrude(profile_vector, dir, distance, cuttingPlaneNormal, cuttingPlanePos));
+		uint32_t i = 0;
+		ForEachCapPoint(profile, [&](const glm::dvec3 &, size_t loop, bool loopStart)
+			{
+				// https://github.com/tomvandig/web-ifc/issues/5
+				if (i > 0 && !(loop > 0 && loopStart))
+				{
+					uint32_t bl = i - 1;
+					uint32_t br = i - 0;
+
+					uint32_t tl = capSize + i - 1;
+					uint32_t tr = capSize + i - 0;
+
+					// this winding should be correct
+					geom.AddFace(geom.GetPoint(tl),
+								 geom.GetPoint(br),
+								 geom.GetPoint(bl));
+
+					geom.AddFace(geom.GetPoint(tl),
+								 geom.GetPoint(tr),
+								 geom.GetPoint(br));
+				}
+				i++;
+			});
+
+		return geom;
+	}
+
+	inline IfcGeometry Extrude(const IfcProfile &profile, glm::dvec3 dir, double distance, glm::dvec3 cuttingPlaneNormal = glm::dvec3(0), glm::dvec3 cuttingPlanePos = glm::dvec3(0))
+	{
+		return Extrude(profile, TriangulateProfileCap(profile), dir, distance, cuttingPlaneNormal, cuttingPlanePos);
 	}
 
 	inline IfcGeometry SweepFixedReference(double linearScalingFactor, bool closed, const IfcProfile& profile, const IfcCurve& directrix, const glm::dvec3& fixedReference)
@@ -671,7 +847,7 @@ namespace webifc::geometry
 		return lo + static_cast<double>(rand()) / (static_cast<double>(RAND_MAX / (hi - lo)));
 	}
 
-	inline std::optional<glm::dvec3> GetOriginRec(IfcComposedMesh &mesh, std::unordered_map<uint32_t, IfcGeometry> &geometryMap, glm::dmat4 mat)
+	inline std::optional<glm::dvec3> GetOriginRec(IfcComposedMesh &mesh, const std::unordered_map<uint32_t, IfcGeometry> &geometryMap, glm::dmat4 mat)
 	{
 		glm::dmat4 newMat = mat * mesh.transformation;
 
@@ -681,14 +857,14 @@ namespace webifc::geometry
 
 		if (geomIt != geometryMap.end())
 		{
-			auto meshGeom = geomIt->second;
+			auto &meshGeom = geomIt->second;
 
 			if (meshGeom.numFaces)
 			{
 				for (uint32_t i = 0; i < meshGeom.numFaces; i++)
 				{
 					bimGeometry::Face f = meshGeom.GetFace(i);
-					glm::dvec3 a = newMat * glm::dvec4(meshGeom.GetPoint(f.i0), 1);
+					glm::dvec3 a = newMat * glm::translate(glm::dvec3(meshGeom.normalizationCenter)) * glm::dvec4(meshGeom.GetPoint(f.i0), 1);
 
 					return a;
 				}
@@ -707,7 +883,7 @@ namespace webifc::geometry
 		return std::nullopt;
 	}
 
-	inline glm::dvec3 GetOrigin(IfcComposedMesh &mesh, std::unordered_map<uint32_t, IfcGeometry> &geometryMap)
+	inline glm::dvec3 GetOrigin(IfcComposedMesh &mesh, const std::unordered_map<uint32_t, IfcGeometry> &geometryMap)
 	{
 		auto v = GetOriginRec(mesh, geometryMap, glm::dmat4(1));
 
@@ -721,7 +897,7 @@ namespace webifc::geometry
 		}
 	}
 
-	inline void flattenRecursive(IfcComposedMesh &mesh, std::unordered_map<uint32_t, IfcGeometry> &geometryMap, std::vector<IfcGeometry> &geoms, glm::dmat4 mat)
+	inline void flattenRecursive(IfcComposedMesh &mesh, const std::unordered_map<uint32_t, IfcGeometry> &geometryMap, std::vector<IfcGeometry> &geoms, glm::dmat4 mat)
 	{
 		glm::dmat4 newMat = mat * mesh.transformation;
 
@@ -731,7 +907,7 @@ namespace webifc::geometry
 
 		if (geomIt != geometryMap.end())
 		{
-			auto meshGeom = geomIt->second;
+			auto &meshGeom = geomIt->second;
 
 			if (meshGeom.part.size() > 0)
 			{
@@ -786,12 +962,14 @@ namespace webifc::geometry
 						newGeom.halfSpaceZ = newMat * glm::dvec4(meshGeom.halfSpaceZ, 1);
 					}
 
+					// a geometry that was normalized for a flat mesh already has its points moved by its center
+					const glm::dmat4 pointMat = newMat * glm::translate(glm::dvec3(meshGeom.normalizationCenter));
 					for (uint32_t i = 0; i < meshGeom.numFaces; i++)
 					{
 						bimGeometry::Face f = meshGeom.GetFace(i);
-						glm::dvec3 a = newMat * glm::dvec4(meshGeom.GetPoint(f.i0), 1);
-						glm::dvec3 b = newMat * glm::dvec4(meshGeom.GetPoint(f.i1), 1);
-						glm::dvec3 c = newMat * glm::dvec4(meshGeom.GetPoint(f.i2), 1);
+						glm::dvec3 a = pointMat * glm::dvec4(meshGeom.GetPoint(f.i0), 1);
+						glm::dvec3 b = pointMat * glm::dvec4(meshGeom.GetPoint(f.i1), 1);
+						glm::dvec3 c = pointMat * glm::dvec4(meshGeom.GetPoint(f.i2), 1);
 
 						if (transformationBreaksWinding)
 						{
@@ -814,7 +992,7 @@ namespace webifc::geometry
 		}
 	}
 
-	inline std::vector<IfcGeometry> flatten(IfcComposedMesh &mesh, std::unordered_map<uint32_t, IfcGeometry> &geometryMap, glm::dmat4 mat = glm::dmat4(1))
+	inline std::vector<IfcGeometry> flatten(IfcComposedMesh &mesh, const std::unordered_map<uint32_t, IfcGeometry> &geometryMap, glm::dmat4 mat = glm::dmat4(1))
 	{
 		std::vector<IfcGeometry> geoms;
 		flattenRecursive(mesh, geometryMap, geoms, mat);
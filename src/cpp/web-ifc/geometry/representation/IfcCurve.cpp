@@ -30,47 +30,130 @@ namespace webifc::geometry
 		return points.at(i);
 	}
 
-    glm::dmat4 IfcCurve::getPlacementAtDistance(double distance, IfcCurve::CurvePlacementMode mode)
+    size_t IfcCurve::GetMemorySize() const
     {
-        // Mode-specific constants
-        const glm::dvec3 GLOBAL_Z(0.0, 0.0, 1.0);
-        const double EPS = 1e-6;
+        size_t size = sizeof(IfcCurve);
+        size += points.capacity() * sizeof(glm::dvec3);
+        size += arcSegments.capacity() * sizeof(uint32_t);
+        size += indices.capacity() * sizeof(uint16_t);
+        size += segmentStartTangents.capacity() * sizeof(glm::dvec3);
+        size += arcLengths.capacity() * sizeof(double);
+        size += userData.capacity() * sizeof(std::string);
+        for (const auto &data : userData)
+        {
+            size += data.capacity();
+        }
+        return size;
+    }
 
-        if (points.empty())
+    std::vector<double> IfcCurve::computeArcLengths() const
+    {
+        std::vector<double> lengths(points.size());
+        double length = 0.0;
+        for (size_t i = 1; i < points.size(); i++)
         {
-            return glm::dmat4(1.0); // Identity matrix (default orientation at 0,0,0)
+            const double segLength = glm::distance(points[i - 1], points[i]);
+            if (segLength >= EPS_SEGMENT)
+                length += segLength;
+            lengths[i] = length;
         }
+        return lengths;
+    }
 
-        glm::dvec3 pos = (points.size() == 1) ? points[0] : glm::dvec3(0.0);
-        glm::dvec3 tan(1.0, 0.0, 0.0); // Initialize tangent to a default value
+    void IfcCurve::BuildArcLengths()
+    {
+        arcLengths = computeArcLengths();
+    }
+
+    size_t IfcCurve::findSegment(const std::vector<double> &lengths, double distance) const
+    {
+        if (points.size() < 2)
+            return points.size();
+
+        // the first point at distance or beyond ends the segment, degenerate segments in front of it end there as well
+        auto end = std::lower_bound(lengths.begin() + 1, lengths.end(), distance - EPS_SEGMENT);
+        if (end == lengths.end())
+            return points.size();
+        size_t segment = end - lengths.begin() - 1;
+        while (lengths[segment + 1] == lengths[segment])
+        {
+            if (++segment + 1 == points.size())
+                return points.size();
+        }
+        return segment;
+    }
+
+    glm::dmat4 IfcCurve::getPlacementAtDistance(double distance, IfcCurve::CurvePlacementMode mode) const
+    {
+        if (arcLengths.size() == points.size())
+        {
+            const size_t segment = findSegment(arcLengths, distance);
+            return getPlacementOnSegment(segment, segment < points.size() ? arcLengths[segment] : 0.0, distance, mode);
+        }
 
         // --- Locate Position and Tangent ---
         double totalDistance = 0.0;
-        bool found = false;
-        for (uint32_t i = 0; i < points.size() - 1; i++)
+        for (size_t i = 0; i + 1 < points.size(); i++)
         {
             double segLength = glm::distance(points[i], points[i + 1]);
-            if (segLength < EPS)
+            if (segLength < EPS_SEGMENT)
                 continue;
 
             totalDistance += segLength;
-            if (totalDistance >= distance - EPS)
+            if (totalDistance >= distance - EPS_SEGMENT)
             {
-                // Position interpolation
-                double segStartLength = totalDistance - segLength;
-                double factor = glm::clamp((distance - segStartLength) / segLength, 0.0, 1.0);
-                pos = points[i] * (1.0 - factor) + points[i + 1] * factor;
+                return getPlacementOnSegment(i, totalDistance - segLength, distance, mode);
+            }
+        }
+        return getPlacementOnSegment(points.size(), 0.0, distance, mode);
+    }
 
-                // Tangent calculation
-                tan = points[i + 1] - points[i];
+    std::vector<glm::dmat4> IfcCurve::getPlacementsAtDistances(const std::vector<double> &distances, IfcCurve::CurvePlacementMode mode) const
+    {
+        std::vector<double> computed;
+        if (arcLengths.size() != points.size())
+        {
+            computed = computeArcLengths();
+        }
+        const std::vector<double> &lengths = computed.empty() ? arcLengths : computed;
 
-                found = true;
-                break;
-            }
+        std::vector<glm::dmat4> placements;
+        placements.reserve(distances.size());
+        for (double distance : distances)
+        {
+            const size_t segment = findSegment(lengths, distance);
+            placements.push_back(getPlacementOnSegment(segment, segment < points.size() ? lengths[segment] : 0.0, distance, mode));
         }
+        return placements;
+    }
+
+    glm::dmat4 IfcCurve::getPlacementOnSegment(size_t segment, double segmentStart, double distance, IfcCurve::CurvePlacementMode mode) const
+    {
+        // Mode-specific constants
+        const glm::dvec3 GLOBAL_Z(0.0, 0.0, 1.0);
+        const double EPS = EPS_SEGMENT;
 
+        if (points.empty())
+        {
+            return glm::dmat4(1.0); // Identity matrix (default orientation at 0,0,0)
+        }
+
+        glm::dvec3 pos = (points.size() == 1) ? points[0] : glm::dvec3(0.0);
+        glm::dvec3 tan(1.0, 0.0, 0.0); // Initialize tangent to a default value
+
+        // --- Locate Position and Tangent ---
+        if (segment + 1 < points.size())
+        {
+            // Position interpolation
+            const double segLength = glm::distance(points[segment], points[segment + 1]);
+            double factor = glm::clamp((distance - segmentStart) / segLength, 0.0, 1.0);
+            pos = points[segment] * (1.0 - factor) + points[segment + 1] * factor;
+
+            // Tangent calculation
+            tan = points[segment + 1] - points[segment];
+        }
         // --- Clamping to End Point ---
-        if (!found && points.size() > 1)
+        else if (points.size() > 1)
         {
             pos = points.back();
             tan = points.back() - points[points.size() - 2];
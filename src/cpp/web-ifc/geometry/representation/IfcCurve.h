@@ -21,16 +21,34 @@ namespace webifc::geometry {
 		glm::dvec3 endTangent = glm::dvec3(0,0,0);
 		// Stores the precise analytic tangent for the start of each segment, in case of IfcCurveSegment
 		std::vector<glm::dvec3> segmentStartTangents;
+		// the length along the curve at every point, degenerate segments add nothing. Only filled by BuildArcLengths,
+		// for curves whose points no longer change, distances are then looked up instead of walked
+		std::vector<double> arcLengths;
 
 		glm::dvec2 Get2d(size_t i) const;
 		glm::dvec3 Get3d(size_t i) const;
 		
 		enum CurvePlacementMode { TangentAsZAxis, GlobalZAxis };
 		/// \brief Get a transformation matrix at a specified distance along the curve. Z axis is aligned with the curve tangent, or with global z axis, depending on mode
-		glm::dmat4 getPlacementAtDistance(double distance, CurvePlacementMode mode);
+		glm::dmat4 getPlacementAtDistance(double distance, CurvePlacementMode mode) const;
+		// the placements at many distances, the arc lengths are computed once for all of them when they are not built
+		std::vector<glm::dmat4> getPlacementsAtDistances(const std::vector<double> &distances, CurvePlacementMode mode) const;
+		void BuildArcLengths();
+		// bytes held by the curve and its buffers
+		size_t GetMemorySize() const;
 
 	protected:
 		static constexpr double EPS_TINY = 1e-9;
+		// segments shorter than this are skipped when a distance is placed
+		static constexpr double EPS_SEGMENT = 1e-6;
+
+	private:
+		// the placement on segment from points[segment] on, starting at segmentStart along the curve, segment is
+		// points.size() for distances beyond the end
+		glm::dmat4 getPlacementOnSegment(size_t segment, double segmentStart, double distance, CurvePlacementMode mode) const;
+		std::vector<double> computeArcLengths() const;
+		// the first segment that is not degenerate and ends at distance or beyond, points.size() if there is none
+		size_t findSegment(const std::vector<double> &lengths, double distance) const;
 	};
 
 }
\ No newline at end of file
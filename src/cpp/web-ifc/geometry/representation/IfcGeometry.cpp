@@ -4,6 +4,10 @@
 
 // Implementation for IfcGeometry
 
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
 #include "IfcGeometry.h"
 #include "../operations/geometryutils.h"
 
@@ -141,6 +145,24 @@ namespace webifc::geometry {
 
 			return totalVolume;
 		}
+
+		double Geometry::Area(const glm::dmat4& trans)
+		{
+			double totalArea = 0;
+
+			for (uint32_t i = 0; i < numFaces; i++)
+			{
+				bimGeometry::Face f = GetFace(i);
+
+				glm::dvec3 a = trans * glm::dvec4(GetPoint(f.i0), 1);
+				glm::dvec3 b = trans * glm::dvec4(GetPoint(f.i1), 1);
+				glm::dvec3 c = trans * glm::dvec4(GetPoint(f.i2), 1);
+
+				totalArea += areaOfTriangle(a, b, c);
+			}
+
+			return totalArea;
+		}
 	
 	void IfcGeometry::ReverseFace(uint32_t index)
 	{
@@ -210,19 +232,375 @@ namespace webifc::geometry {
 		return  resultMat;
 	}
 
+	size_t IfcGeometry::GetMemorySize() const
+	{
+		size_t size = sizeof(IfcGeometry);
+		size += vertexData.capacity() * sizeof(double);
+		size += fvertexData.capacity() * sizeof(float);
+		size += qvertexData.capacity() * sizeof(uint16_t);
+		size += compactVertexData.capacity() * sizeof(CompactVertex);
+		size += indexData.capacity() * sizeof(uint32_t);
+		size += planeData.capacity() * sizeof(uint32_t);
+		size += planes.capacity() * sizeof(bimGeometry::Plane);
+		size += planeCells.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void *));
+		for (const auto &p : part)
+		{
+			size += p.GetMemorySize();
+		}
+		return size;
+	}
+
+	IfcGeometry IfcGeometry::Decimate(double cellSize) const
+	{
+		if (!(cellSize > 0) || isPolygon || released || numFaces == 0)
+		{
+			return *this;
+		}
+
+		glm::dvec3 min(DBL_MAX, DBL_MAX, DBL_MAX);
+		for (size_t i = 0; i < numPoints; i++)
+		{
+			min = glm::min(min, GetPoint(i));
+		}
+
+		// sorting by cell keeps the clusters free of the collisions a hash of the cell would bring
+		std::vector<std::pair<std::array<int64_t, 3>, uint32_t>> cells(numPoints);
+		for (size_t i = 0; i < numPoints; i++)
+		{
+			const glm::dvec3 scaled = (GetPoint(i) - min) / cellSize;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				cells[i].first[axis] = std::isfinite(scaled[axis]) ? static_cast<int64_t>(std::floor(std::clamp(scaled[axis], 0.0, 1.0e18))) : 0;
+			}
+			cells[i].second = static_cast<uint32_t>(i);
+		}
+		std::sort(cells.begin(), cells.end());
+
+		std::vector<uint32_t> clusterOfPoint(numPoints);
+		std::vector<glm::dvec3> clusterPoints;
+		std::vector<uint32_t> clusterSizes;
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			if (i == 0 || cells[i].first != cells[i - 1].first)
+			{
+				clusterPoints.push_back(glm::dvec3(0));
+				clusterSizes.push_back(0);
+			}
+			clusterPoints.back() += GetPoint(cells[i].second);
+			clusterSizes.back()++;
+			clusterOfPoint[cells[i].second] = static_cast<uint32_t>(clusterPoints.size() - 1);
+		}
+		for (size_t i = 0; i < clusterPoints.size(); i++)
+		{
+			clusterPoints[i] /= static_cast<double>(clusterSizes[i]);
+		}
+
+		IfcGeometry decimated;
+		for (size_t i = 0; i < numFaces; i++)
+		{
+			const auto face = GetFace(i);
+			const uint32_t a = clusterOfPoint[face.i0];
+			const uint32_t b = clusterOfPoint[face.i1];
+			const uint32_t c = clusterOfPoint[face.i2];
+			if (a == b || b == c || c == a)
+			{
+				continue;
+			}
+			decimated.AddFace(clusterPoints[a], clusterPoints[b], clusterPoints[c]);
+		}
+
+		decimated.halfSpace = halfSpace;
+		decimated.halfSpaceX = halfSpaceX;
+		decimated.halfSpaceY = halfSpaceY;
+		decimated.halfSpaceZ = halfSpaceZ;
+		decimated.halfSpaceOrigin = halfSpaceOrigin;
+		decimated.normalizationCenter = normalizationCenter;
+		decimated.normalized = normalized;
+		decimated.part = part;
+		decimated.sweptDiskSolid = sweptDiskSolid;
+		return decimated;
+	}
+
+	void IfcGeometry::WeldVertices(bool optimizeVertexCache)
+	{
+		if (welded || isPolygon || released || compact || numFaces == 0)
+		{
+			return;
+		}
+		welded = true;
+
+		glm::dvec3 center;
+		glm::dvec3 extents;
+		GetCenterExtents(center, extents);
+		const double extent = std::max(extents.x, std::max(extents.y, extents.z));
+		const double positionStep = extent > 0 && std::isfinite(extent) ? extent * 1e-7 : 1;
+		constexpr double NORMAL_STEP = 1e-4;
+
+		struct Key
+		{
+			std::array<int64_t, 6> cell;
+			bool operator==(const Key &other) const { return cell == other.cell; }
+		};
+		auto quantize = [](double value, double step)
+		{
+			const double scaled = value / step;
+			return std::isfinite(scaled) ? static_cast<int64_t>(std::llround(std::clamp(scaled, -1.0e18, 1.0e18))) : 0;
+		};
+		auto hash = [](const Key &key)
+		{
+			uint64_t h = 14695981039346656037ull;
+			for (int64_t c : key.cell)
+			{
+				h = (h ^ static_cast<uint64_t>(c)) * 1099511628211ull;
+			}
+			return h ^ (h >> 29);
+		};
+
+		// open addressing over the welded vertices, at most half full
+		size_t tableSize = 16;
+		while (tableSize < static_cast<size_t>(numPoints) * 2)
+		{
+			tableSize *= 2;
+		}
+		std::vector<uint32_t> table(tableSize, UINT32_MAX);
+		std::vector<Key> keys;
+		std::vector<uint32_t> weldedOfPoint(numPoints);
+		std::vector<double> weldedVertices;
+		weldedVertices.reserve(vertexData.size());
+		for (uint32_t i = 0; i < numPoints; i++)
+		{
+			const double *vertex = &vertexData[static_cast<size_t>(i) * VERTEX_FORMAT_SIZE_FLOATS];
+			Key key;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				key.cell[axis] = quantize(vertex[axis], positionStep);
+				key.cell[axis + 3] = quantize(vertex[axis + 3], NORMAL_STEP);
+			}
+			size_t slot = hash(key) & (tableSize - 1);
+			while (table[slot] != UINT32_MAX && !(keys[table[slot]] == key))
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == UINT32_MAX)
+			{
+				table[slot] = static_cast<uint32_t>(keys.size());
+				keys.push_back(key);
+				weldedVertices.insert(weldedVertices.end(), vertex, vertex + VERTEX_FORMAT_SIZE_FLOATS);
+			}
+			weldedOfPoint[i] = table[slot];
+		}
+
+		// faces that collapse onto a welded vertex are dropped with their planes
+		std::vector<uint32_t> weldedIndices;
+		std::vector<uint32_t> weldedPlanes;
+		weldedIndices.reserve(indexData.size());
+		const bool hasPlaneData = planeData.size() == numFaces;
+		for (uint32_t i = 0; i < numFaces; i++)
+		{
+			const uint32_t a = weldedOfPoint[indexData[i * 3 + 0]];
+			const uint32_t b = weldedOfPoint[indexData[i * 3 + 1]];
+			const uint32_t c = weldedOfPoint[indexData[i * 3 + 2]];
+			if (a == b || b == c || c == a)
+			{
+				continue;
+			}
+			weldedIndices.push_back(a);
+			weldedIndices.push_back(b);
+			weldedIndices.push_back(c);
+			if (hasPlaneData)
+			{
+				weldedPlanes.push_back(planeData[i]);
+			}
+		}
+
+		vertexData = std::move(weldedVertices);
+		indexData = std::move(weldedIndices);
+		if (hasPlaneData)
+		{
+			planeData = std::move(weldedPlanes);
+		}
+		numPoints = static_cast<uint32_t>(keys.size());
+		numFaces = static_cast<uint32_t>(indexData.size() / 3);
+		fvertexData.clear();
+
+		if (optimizeVertexCache)
+		{
+			OptimizeVertexCache();
+		}
+	}
+
+	bool IfcGeometry::IsWelded() const
+	{
+		return welded;
+	}
+
+	// Tipsify (Sander, Nehab and Barczak, 2007): the faces around a vertex are emitted together, then the walk goes on at
+	// the vertex of those just emitted that is still in the cache and has faces left, or past the last emitted vertices
+	void IfcGeometry::OptimizeVertexCache()
+	{
+		constexpr int64_t CACHE_SIZE = 16;
+		if (numFaces == 0)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> faceOffsets(numPoints + 1, 0);
+		for (uint32_t index : indexData)
+		{
+			faceOffsets[index + 1]++;
+		}
+		for (uint32_t i = 0; i < numPoints; i++)
+		{
+			faceOffsets[i + 1] += faceOffsets[i];
+		}
+		std::vector<uint32_t> vertexFaces(indexData.size());
+		std::vector<uint32_t> fill(faceOffsets.begin(), faceOffsets.end() - 1);
+		for (size_t i = 0; i < indexData.size(); i++)
+		{
+			vertexFaces[fill[indexData[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<uint32_t> liveFaces(numPoints);
+		for (uint32_t i = 0; i < numPoints; i++)
+		{
+			liveFaces[i] = faceOffsets[i + 1] - faceOffsets[i];
+		}
+		std::vector<int64_t> cacheTime(numPoints, 0);
+		std::vector<bool> emitted(numFaces, false);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> faceOrder;
+		faceOrder.reserve(numFaces);
+
+		int64_t time = CACHE_SIZE + 1;
+		uint32_t cursor = 0;
+		int64_t fanning = 0;
+		while (fanning >= 0)
+		{
+			candidates.clear();
+			for (uint32_t i = faceOffsets[fanning]; i < faceOffsets[fanning + 1]; i++)
+			{
+				const uint32_t face = vertexFaces[i];
+				if (emitted[face])
+				{
+					continue;
+				}
+				emitted[face] = true;
+				faceOrder.push_back(face);
+				for (int k = 0; k < 3; k++)
+				{
+					const uint32_t vertex = indexData[face * 3 + k];
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					liveFaces[vertex]--;
+					if (time - cacheTime[vertex] > CACHE_SIZE)
+					{
+						cacheTime[vertex] = time++;
+					}
+				}
+			}
+
+			fanning = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveFaces[vertex] == 0)
+				{
+					continue;
+				}
+				// a vertex that stays in the cache while its remaining faces are emitted, the oldest of them first
+				int64_t priority = 0;
+				if (time - cacheTime[vertex] + 2 * static_cast<int64_t>(liveFaces[vertex]) <= CACHE_SIZE)
+				{
+					priority = time - cacheTime[vertex];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanning = vertex;
+				}
+			}
+			while (fanning < 0 && !deadEnd.empty())
+			{
+				const uint32_t vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveFaces[vertex] > 0)
+				{
+					fanning = vertex;
+				}
+			}
+			while (fanning < 0 && cursor < numPoints)
+			{
+				if (liveFaces[cursor] > 0)
+				{
+					fanning = cursor;
+				}
+				cursor++;
+			}
+		}
+
+		// the vertices are renumbered in the order the faces first use them
+		std::vector<uint32_t> newIndex(numPoints, UINT32_MAX);
+		std::vector<double> orderedVertices(vertexData.size());
+		std::vector<uint32_t> orderedIndices;
+		std::vector<uint32_t> orderedPlanes;
+		orderedIndices.reserve(indexData.size());
+		const bool hasPlaneData = planeData.size() == numFaces;
+		uint32_t nextIndex = 0;
+		for (uint32_t face : faceOrder)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t vertex = indexData[face * 3 + k];
+				if (newIndex[vertex] == UINT32_MAX)
+				{
+					newIndex[vertex] = nextIndex;
+					std::copy_n(&vertexData[static_cast<size_t>(vertex) * VERTEX_FORMAT_SIZE_FLOATS], VERTEX_FORMAT_SIZE_FLOATS, &orderedVertices[static_cast<size_t>(nextIndex) * VERTEX_FORMAT_SIZE_FLOATS]);
+					nextIndex++;
+				}
+				orderedIndices.push_back(newIndex[vertex]);
+			}
+			if (hasPlaneData)
+			{
+				orderedPlanes.push_back(planeData[face]);
+			}
+		}
+
+		orderedVertices.resize(static_cast<size_t>(nextIndex) * VERTEX_FORMAT_SIZE_FLOATS);
+		vertexData = std::move(orderedVertices);
+		indexData = std::move(orderedIndices);
+		if (hasPlaneData)
+		{
+			planeData = std::move(orderedPlanes);
+		}
+		numPoints = nextIndex;
+	}
+
+	bool IfcGeometry::IsNormalized() const
+	{
+		return normalized;
+	}
+
+	void IfcGeometry::MarkNormalized(const glm::dvec3 &center)
+	{
+		normalizationCenter = center;
+		normalized = true;
+	}
+
 	uint32_t IfcGeometry::GetVertexData()
 	{
-		// unfortunately webgl can't do doubles
-		if (fvertexData.size() != vertexData.size())
+		if (vertexFormat == VertexFormat::QUANTIZED)
 		{
-			fvertexData.resize(vertexData.size());
-			for (size_t i = 0; i < vertexData.size(); i++)
+			if (qvertexData.empty())
 			{
-				// The vector was previously copied in batches of 6, but
-				// copying single entry at a time is more resilient if the 
-				// underlying geometry lib changes the treatment of normals
-				fvertexData[i] = vertexData[i];
+				return 0;
 			}
+			return (uint32_t)(size_t)&qvertexData[0];
+		}
+		// unfortunately webgl can't do doubles
+		if (!released && !compact && fvertexData.size() != vertexData.size())
+		{
+			WriteFloatVertexData();
 		}
 		if (fvertexData.empty())
 		{
@@ -233,9 +611,228 @@ namespace webifc::geometry {
 
     uint32_t IfcGeometry::GetVertexDataSize()
 	{
+		if (vertexFormat == VertexFormat::QUANTIZED)
+		{
+			return (uint32_t)qvertexData.size();
+		}
 		return (uint32_t)fvertexData.size();
 	}
 
+	void IfcGeometry::PrepareVertexData(VertexFormat format)
+	{
+		// the output of a released geometry is final, a compact one has its floats written already
+		if (released || compact)
+		{
+			return;
+		}
+		vertexFormat = format;
+		switch (format)
+		{
+		case VertexFormat::FLOAT:
+			WriteFloatVertexData();
+			break;
+		case VertexFormat::FLOAT_RELEASED:
+			WriteFloatVertexData();
+			ReleaseVertexData();
+			break;
+		case VertexFormat::QUANTIZED:
+			WriteQuantizedVertexData();
+			fvertexData.clear();
+			fvertexData.shrink_to_fit();
+			ReleaseVertexData();
+			break;
+		case VertexFormat::FLOAT_COMPACT:
+			WriteFloatVertexData();
+			WriteCompactVertexData();
+			break;
+		}
+	}
+
+	uint8_t IfcGeometry::GetVertexFormat() const
+	{
+		return static_cast<uint8_t>(vertexFormat);
+	}
+
+	bool IfcGeometry::IsReleased() const
+	{
+		return released;
+	}
+
+	bool IfcGeometry::IsCompact() const
+	{
+		return compact;
+	}
+
+	void IfcGeometry::RestoreVertexData()
+	{
+		if (!compact)
+		{
+			return;
+		}
+		vertexData.resize(compactVertexData.size() * VERTEX_FORMAT_SIZE_FLOATS);
+		for (size_t i = 0; i < compactVertexData.size(); i++)
+		{
+			const CompactVertex &source = compactVertexData[i];
+			double *vertex = &vertexData[i * VERTEX_FORMAT_SIZE_FLOATS];
+			const glm::dvec3 position = compactOrigin + glm::dvec3(source.position);
+
+			double x = static_cast<int16_t>(source.normal & 0xFFFF) / 32767.0;
+			double y = static_cast<int16_t>(source.normal >> 16) / 32767.0;
+			const double z = 1 - std::abs(x) - std::abs(y);
+			if (z < 0)
+			{
+				const double unfolded = (1 - std::abs(y)) * (x < 0 ? -1.0 : 1.0);
+				y = (1 - std::abs(x)) * (y < 0 ? -1.0 : 1.0);
+				x = unfolded;
+			}
+			const glm::dvec3 normal = glm::normalize(glm::dvec3(x, y, z));
+
+			vertex[0] = position.x;
+			vertex[1] = position.y;
+			vertex[2] = position.z;
+			vertex[3] = normal.x;
+			vertex[4] = normal.y;
+			vertex[5] = normal.z;
+		}
+		compactVertexData.clear();
+		compactVertexData.shrink_to_fit();
+		compact = false;
+	}
+
+	glm::dvec3 IfcGeometry::GetQuantizationOffset() const
+	{
+		return quantizationOffset;
+	}
+
+	glm::dvec3 IfcGeometry::GetQuantizationScale() const
+	{
+		return quantizationScale;
+	}
+
+	void IfcGeometry::WriteFloatVertexData()
+	{
+		fvertexData.resize(vertexData.size());
+		for (size_t i = 0; i < vertexData.size(); i++)
+		{
+			// The vector was previously copied in batches of 6, but
+			// copying single entry at a time is more resilient if the 
+			// underlying geometry lib changes the treatment of normals
+			fvertexData[i] = vertexData[i];
+		}
+	}
+
+	void IfcGeometry::WriteQuantizedVertexData()
+	{
+		const size_t count = vertexData.size() / VERTEX_FORMAT_SIZE_FLOATS;
+		qvertexData.resize(count * VERTEX_FORMAT_SIZE_QUANTIZED);
+		if (count == 0)
+		{
+			return;
+		}
+
+		glm::dvec3 low(DBL_MAX);
+		glm::dvec3 high(-DBL_MAX);
+		for (size_t i = 0; i < count; i++)
+		{
+			const double *vertex = &vertexData[i * VERTEX_FORMAT_SIZE_FLOATS];
+			glm::dvec3 position(vertex[0], vertex[1], vertex[2]);
+			low = glm::min(low, position);
+			high = glm::max(high, position);
+		}
+		quantizationOffset = low;
+		quantizationScale = high - low;
+
+		auto quantize = [](double value, double offset, double scale) -> uint16_t
+		{
+			if (scale <= 0)
+			{
+				return 0;
+			}
+			return static_cast<uint16_t>(std::round(std::clamp((value - offset) / scale, 0.0, 1.0) * 65535.0));
+		};
+		auto signNotZero = [](double value) { return value < 0 ? -1.0 : 1.0; };
+		auto snorm8 = [](double value) { return static_cast<uint8_t>(static_cast<int8_t>(std::round(std::clamp(value, -1.0, 1.0) * 127.0))); };
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const double *vertex = &vertexData[i * VERTEX_FORMAT_SIZE_FLOATS];
+			uint16_t *output = &qvertexData[i * VERTEX_FORMAT_SIZE_QUANTIZED];
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				output[axis] = quantize(vertex[axis], quantizationOffset[axis], quantizationScale[axis]);
+			}
+
+			// octahedral encoding: project on the octahedron and fold the lower half over the upper one
+			const glm::dvec3 normal(vertex[3], vertex[4], vertex[5]);
+			const double length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			double x = length > 0 ? normal.x / length : 0;
+			double y = length > 0 ? normal.y / length : 0;
+			if (normal.z < 0)
+			{
+				const double folded = (1 - std::abs(y)) * signNotZero(x);
+				y = (1 - std::abs(x)) * signNotZero(y);
+				x = folded;
+			}
+			output[3] = static_cast<uint16_t>(snorm8(x) | (snorm8(y) << 8));
+		}
+	}
+
+	void IfcGeometry::WriteCompactVertexData()
+	{
+		const size_t count = vertexData.size() / VERTEX_FORMAT_SIZE_FLOATS;
+		glm::dvec3 low(DBL_MAX);
+		glm::dvec3 high(-DBL_MAX);
+		for (size_t i = 0; i < count; i++)
+		{
+			const double *vertex = &vertexData[i * VERTEX_FORMAT_SIZE_FLOATS];
+			const glm::dvec3 position(vertex[0], vertex[1], vertex[2]);
+			low = glm::min(low, position);
+			high = glm::max(high, position);
+		}
+		// floats are precise enough around the center of the geometry, not around a far away origin
+		compactOrigin = count > 0 ? (low + high) * 0.5 : glm::dvec3(0);
+
+		auto snorm16 = [](double value) { return static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int16_t>(std::round(std::clamp(value, -1.0, 1.0) * 32767.0)))); };
+		compactVertexData.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const double *vertex = &vertexData[i * VERTEX_FORMAT_SIZE_FLOATS];
+			CompactVertex &output = compactVertexData[i];
+			output.position = glm::vec3(glm::dvec3(vertex[0], vertex[1], vertex[2]) - compactOrigin);
+
+			// octahedral encoding as for QUANTIZED, at 16 bits per coordinate
+			const glm::dvec3 normal(vertex[3], vertex[4], vertex[5]);
+			const double length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			double x = length > 0 ? normal.x / length : 0;
+			double y = length > 0 ? normal.y / length : 0;
+			if (normal.z < 0)
+			{
+				const double folded = (1 - std::abs(y)) * (x < 0 ? -1.0 : 1.0);
+				y = (1 - std::abs(x)) * (y < 0 ? -1.0 : 1.0);
+				x = folded;
+			}
+			output.normal = snorm16(x) | (snorm16(y) << 16);
+		}
+
+		vertexData.clear();
+		vertexData.shrink_to_fit();
+		// the boolean engine builds the planes again when it needs them
+		planeData.clear();
+		planeData.shrink_to_fit();
+		planes.clear();
+		planes.shrink_to_fit();
+		ResetPlaneIndex();
+		hasPlanes = false;
+		compact = true;
+	}
+
+	void IfcGeometry::ReleaseVertexData()
+	{
+		vertexData.clear();
+		vertexData.shrink_to_fit();
+		released = true;
+	}
+
 	uint32_t IfcGeometry::GetIndexData()
 	{
 		return (uint32_t)(size_t)&indexData[0];
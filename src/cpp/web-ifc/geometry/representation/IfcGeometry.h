@@ -21,6 +21,23 @@
 namespace webifc::geometry {
 
 	constexpr int VERTEX_FORMAT_SIZE_FLOATS = bimGeometry::VERTEX_FORMAT_SIZE_FLOATS;
+	constexpr int VERTEX_FORMAT_SIZE_QUANTIZED = 4;
+
+	// what GetVertexData hands out
+	enum class VertexFormat : uint8_t
+	{
+		// 6 floats per vertex, position then normal, the double vertices are kept
+		FLOAT = 0,
+		// 6 floats per vertex, the double vertices are released once the floats are written
+		FLOAT_RELEASED = 1,
+		// 4 uint16 per vertex: the position quantized to the box given by GetQuantizationOffset and GetQuantizationScale,
+		// then the normal oct encoded into two int8. The double vertices are released
+		QUANTIZED = 2,
+		// 6 floats per vertex like FLOAT. Instead of the double vertices and planes the geometry keeps float positions
+		// relative to a double origin with oct encoded normals, 16 bytes per vertex, and restores the doubles from them
+		// when it is reused, so about half the memory of FLOAT stays cached
+		FLOAT_COMPACT = 3
+	};
 
     struct Plane : bimGeometry::Plane
     {
@@ -43,6 +60,8 @@ namespace webifc::geometry {
 		Geometry DeNormalize(glm::dvec3 center, glm::dvec3 extents) const;
 		bool IsEmpty();
 		double Volume(const glm::dmat4& trans = glm::dmat4(1));
+		// the summed area of the faces placed by trans
+		double Area(const glm::dmat4& trans = glm::dmat4(1));
 	};
 
 	struct IfcGeometry : Geometry
@@ -62,14 +81,60 @@ namespace webifc::geometry {
 		void MergeGeometry(Geometry geom);
 		uint32_t GetVertexData();
 		uint32_t GetVertexDataSize();
+		// writes the output vertices in the given format, the geometry cannot be processed further once its vertices are released
+		void PrepareVertexData(VertexFormat format);
+		uint8_t GetVertexFormat() const;
+		bool IsReleased() const;
+		// true while a FLOAT_COMPACT geometry holds its compact vertices instead of the doubles
+		bool IsCompact() const;
+		// the double vertices of a compact geometry back, to the precision of its compact vertices, before it is processed
+		// further. Nothing is done for other geometries
+		void RestoreVertexData();
+		// position = offset + quantized / 65535 * scale
+		glm::dvec3 GetQuantizationOffset() const;
+		glm::dvec3 GetQuantizationScale() const;
 		uint32_t GetIndexData();
 		uint32_t GetIndexDataSize();
 		SweptDiskSolid GetSweptDiskSolid();
 		glm::dmat4 Normalize();
+		bool IsNormalized() const;
+		// bytes held by the buffers of the geometry and its parts, the swept disk solid is not counted
+		size_t GetMemorySize() const;
+		// for vertices that were moved by center already, Normalize then returns the translation back
+		void MarkNormalized(const glm::dvec3 &center);
+		// a coarser copy for levels of detail: the vertices in every cell of a grid with the given cell size are merged into
+		// their average and the faces that collapse are dropped. Parts and polygons are copied as they are
+		IfcGeometry Decimate(double cellSize) const;
+		// merges the vertices whose positions agree within a ten millionth of the geometry's extent, below what the float
+		// vertices can tell apart, and whose normals agree, so that the faces share them instead of having three each.
+		// With optimizeVertexCache the faces are then ordered for the vertex cache of the GPU and the vertices by first use.
+		// Polygons, released and compact geometries are left alone, the parts are not welded
+		void WeldVertices(bool optimizeVertexCache);
+		bool IsWelded() const;
 		SweptDiskSolid sweptDiskSolid;
 		private:
 			void ReverseFace(uint32_t index);
+			void WriteFloatVertexData();
+			void WriteQuantizedVertexData();
+			void WriteCompactVertexData();
+			void ReleaseVertexData();
+			void OptimizeVertexCache();
 			bool normalized = false;
+			bool welded = false;
+			bool released = false;
+			VertexFormat vertexFormat = VertexFormat::FLOAT;
+			std::vector<uint16_t> qvertexData;
+			glm::dvec3 quantizationOffset = glm::dvec3(0);
+			glm::dvec3 quantizationScale = glm::dvec3(1);
+			struct CompactVertex
+			{
+				glm::vec3 position;
+				// oct encoded into two int16
+				uint32_t normal;
+			};
+			bool compact = false;
+			std::vector<CompactVertex> compactVertexData;
+			glm::dvec3 compactOrigin = glm::dvec3(0);
 
 	};
 
@@ -236,6 +236,25 @@ namespace webifc::geometry {
 			uint32_t expressID;
 		};
 
+		// the part of a merged mesh that belongs to one element
+		struct IfcMergedRange
+		{
+			uint32_t expressID;
+			uint32_t indexOffset;
+			uint32_t indexCount;
+		};
+
+		// the geometries of several elements with the same color, transformed into place and merged into one buffer
+		struct IfcMergedMesh
+		{
+			glm::dvec4 color;
+			// 6 floats per vertex, position then normal
+			std::vector<float> vertexData;
+			std::vector<uint32_t> indexData;
+			// in the order of the elements, an element covers one range of every mesh it has geometry in
+			std::vector<IfcMergedRange> ranges;
+		};
+
 		struct IfcComposedMesh
 		{
 			glm::dvec4 color;
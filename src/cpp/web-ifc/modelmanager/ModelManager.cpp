@@ -3,12 +3,14 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include <vector>
+#include <mutex>
 #include <spdlog/spdlog.h>
 #include <sstream>
 #include "ModelManager.h"
 #include "../schema/IfcSchemaManager.h"
 #include "../geometry/IfcGeometryProcessor.h"
 #include "../parsing/IfcLoader.h"
+#include "../utility/parallel.h"
 #include "../../version.h"
 
 webifc::manager::ModelManager::ModelManager(bool _mt_enabled)
@@ -23,14 +25,16 @@ webifc::manager::ModelManager::~ModelManager()
 
 void webifc::manager::ModelManager::CloseAllModels()
 {
+    std::unique_lock lock(_modelsMutex);
     for (size_t i = 0; i < _loaders.size(); i++)
     {
-        if (!IsModelOpen(i))
+        if (_loaders[i] == nullptr)
             continue;
         delete _loaders[i];
         delete _geometryProcessors[i];
     }
     _loaders.clear();
+    _settings.clear();
     _geometryProcessors.clear();
 }
 
@@ -44,9 +48,27 @@ webifc::geometry::IfcGeometryProcessor *webifc::manager::ModelManager::GetGeomet
 {
     if (!IsModelOpen(modelID))
         return {};
+    {
+        std::shared_lock lock(_modelsMutex);
+        auto it = _geometryProcessors.find(modelID);
+        if (it != _geometryProcessors.end())
+            return it->second;
+    }
+    std::unique_lock lock(_modelsMutex);
+    // the model may have been closed while no lock was held
+    if (modelID >= _loaders.size() || _loaders[modelID] == nullptr)
+        return {};
     if (!_geometryProcessors.contains(modelID))
     {
-        webifc::geometry::IfcGeometryProcessor *processor = new webifc::geometry::IfcGeometryProcessor(*GetIfcLoader(modelID), _schemaManager, GetSettings(modelID).CIRCLE_SEGMENTS, GetSettings(modelID).COORDINATE_TO_ORIGIN, GetSettings(modelID).TOLERANCE_PLANE_INTERSECTION, GetSettings(modelID).TOLERANCE_PLANE_DEVIATION, GetSettings(modelID).TOLERANCE_BACK_DEVIATION_DISTANCE, GetSettings(modelID).TOLERANCE_INSIDE_OUTSIDE_PERIMETER, GetSettings(modelID).TOLERANCE_SCALAR_EQUALITY, GetSettings(modelID).PLANE_REFIT_ITERATIONS, GetSettings(modelID).BOOLEAN_UNION_THRESHOLD);
+        // the accessors lock as well, so the tables are read directly
+        const LoaderSettings &settings = _settings[modelID];
+        webifc::geometry::IfcGeometryProcessor *processor = new webifc::geometry::IfcGeometryProcessor(*_loaders[modelID], _schemaManager, settings.CIRCLE_SEGMENTS, settings.COORDINATE_TO_ORIGIN, settings.TOLERANCE_PLANE_INTERSECTION, settings.TOLERANCE_PLANE_DEVIATION, settings.TOLERANCE_BACK_DEVIATION_DISTANCE, settings.TOLERANCE_INSIDE_OUTSIDE_PERIMETER, settings.TOLERANCE_SCALAR_EQUALITY, settings.PLANE_REFIT_ITERATIONS, settings.BOOLEAN_UNION_THRESHOLD);
+        processor->SetGeometryMemoryLimit(settings.GEOMETRY_MEMORY_LIMIT);
+        processor->SetCircleChordTolerance(settings.CIRCLE_CHORD_TOLERANCE);
+        processor->SetVertexWelding(settings.WELD_VERTICES, settings.OPTIMIZE_VERTEX_CACHE);
+        processor->SetBooleanBudget(settings.BOOLEAN_TIME_BUDGET / 1000, settings.ELEMENT_TIME_BUDGET / 1000, settings.BOOLEAN_FACE_BUDGET);
+        processor->SetExportPolylines(settings.EXPORT_POLYLINES);
+        processor->SetTerrainChunkTriangles(settings.TERRAIN_CHUNK_TRIANGLES);
         _geometryProcessors[modelID] = processor;
     }
     return _geometryProcessors.at(modelID);
@@ -54,15 +76,16 @@ webifc::geometry::IfcGeometryProcessor *webifc::manager::ModelManager::GetGeomet
 
 webifc::parsing::IfcLoader *webifc::manager::ModelManager::GetIfcLoader(uint32_t modelID) const
 {
-    if (!IsModelOpen(modelID))
-        return {};
-    return _loaders[modelID];
+    std::shared_lock lock(_modelsMutex);
+    return modelID < _loaders.size() ? _loaders[modelID] : nullptr;
 }
 
 const webifc::manager::LoaderSettings &webifc::manager::ModelManager::GetSettings(uint32_t modelID) const
 {
-    if (!IsModelOpen(modelID))
-        return LoaderSettings();
+    static const LoaderSettings defaultSettings;
+    std::shared_lock lock(_modelsMutex);
+    if (_loaders.size() <= modelID || _loaders[modelID] == nullptr)
+        return defaultSettings;
     return _settings[modelID];
 }
 
@@ -73,6 +96,7 @@ const webifc::schema::IfcSchemaManager &webifc::manager::ModelManager::GetSchema
 
 bool webifc::manager::ModelManager::IsModelOpen(uint32_t modelID) const
 {
+    std::shared_lock lock(_modelsMutex);
     if (_loaders.size() <= modelID)
         return false;
     if (_loaders[modelID] == nullptr)
@@ -80,9 +104,24 @@ bool webifc::manager::ModelManager::IsModelOpen(uint32_t modelID) const
     return true;
 }
 
+webifc::utility::MemoryStats webifc::manager::ModelManager::GetMemoryStats(uint32_t modelID) const
+{
+    webifc::utility::MemoryStats stats;
+    std::shared_lock lock(_modelsMutex);
+    if (_loaders.size() <= modelID || _loaders[modelID] == nullptr)
+        return stats;
+    _loaders[modelID]->AddMemoryStats(stats);
+    // the processor is only there once geometry was asked for
+    auto it = _geometryProcessors.find(modelID);
+    if (it != _geometryProcessors.end() && it->second != nullptr)
+        it->second->AddMemoryStats(stats);
+    return stats;
+}
+
 void webifc::manager::ModelManager::CloseModel(uint32_t modelID)
 {
-    if (!IsModelOpen(modelID))
+    std::unique_lock lock(_modelsMutex);
+    if (_loaders.size() <= modelID || _loaders[modelID] == nullptr)
         return;
     delete _loaders[modelID];
     delete _geometryProcessors[modelID];
@@ -92,6 +131,11 @@ void webifc::manager::ModelManager::CloseModel(uint32_t modelID)
 
 uint32_t webifc::manager::ModelManager::CreateModel(LoaderSettings settings)
 {
+    webifc::parsing::IfcLoader *loader = new webifc::parsing::IfcLoader(settings.TAPE_SIZE, settings.MEMORY_LIMIT, settings.LINEWRITER_BUFFER, _schemaManager, settings.BINARY_NUMBERS);
+    loader->SetEntityFilter(settings.INCLUDE_TYPES, settings.EXCLUDE_TYPES);
+    if (settings.PARALLEL_TOKENIZING)
+        loader->SetTokenizerThreads(0);
+    std::unique_lock lock(_modelsMutex);
     if (!header_shown)
     {
         std::stringstream str;
@@ -103,8 +147,43 @@ uint32_t webifc::manager::ModelManager::CreateModel(LoaderSettings settings)
         spdlog::info(str.str());
         header_shown = true;
     }
-    webifc::parsing::IfcLoader *loader = new webifc::parsing::IfcLoader(settings.TAPE_SIZE, settings.MEMORY_LIMIT, settings.LINEWRITER_BUFFER, _schemaManager);
     _loaders.push_back(loader);
     _settings.push_back(settings);
     return _loaders.size() - 1;
-}
\ No newline at end of file
+}
+
+std::vector<uint32_t> webifc::manager::ModelManager::OpenModels(const LoaderSettings &settings, const std::vector<std::shared_ptr<const std::vector<uint8_t>>> &files)
+{
+    std::vector<uint32_t> modelIDs(files.size());
+    std::vector<webifc::parsing::IfcLoader *> loaders(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        modelIDs[i] = CreateModel(settings);
+        loaders[i] = GetIfcLoader(modelIDs[i]);
+    }
+    // a single file is still tokenized on all threads, with more every model gets a thread of its own
+    webifc::utility::ParallelFor(files.size(), mt_enabled ? webifc::utility::GetThreadCount() : 1, [&](const size_t i)
+        { loaders[i]->LoadFile(files[i]); });
+    return modelIDs;
+}
+
+std::optional<uint32_t> webifc::manager::ModelManager::AttachModel(uint32_t modelID)
+{
+    std::unique_lock lock(_modelsMutex);
+    if (_loaders.size() <= modelID || _loaders[modelID] == nullptr)
+        return std::nullopt;
+    webifc::parsing::IfcLoader *loader = _loaders[modelID];
+    if (loader->IsLoading())
+    {
+        spdlog::error("[AttachModel()] model {} is still loading", modelID);
+        return std::nullopt;
+    }
+    if (!loader->PrepareConcurrentReads())
+    {
+        spdlog::error("[AttachModel()] the tape of model {} does not fit the memory limit", modelID);
+        return std::nullopt;
+    }
+    _loaders.push_back(loader->Clone());
+    _settings.push_back(_settings[modelID]);
+    return _loaders.size() - 1;
+}
@@ -8,8 +8,11 @@
 #include "../geometry/IfcGeometryProcessor.h"
 #include "../parsing/IfcLoader.h"
 #include <vector>
+#include <deque>
 #include <map>
+#include <memory>
 #include <optional>
+#include <shared_mutex>
 
 namespace webifc::manager
 {
@@ -28,8 +31,23 @@ namespace webifc::manager
         double TOLERANCE_SCALAR_EQUALITY = 1.0E-04;
         uint16_t PLANE_REFIT_ITERATIONS = 1;
         uint16_t BOOLEAN_UNION_THRESHOLD = 150;
+        bool BINARY_NUMBERS = false;
+        bool PARALLEL_TOKENIZING = false; // the file is tokenized on one thread per hardware thread, the tape comes out the same
+        uint32_t GEOMETRY_MEMORY_LIMIT = 0; // 0 keeps all geometry until the next Clear
+        uint8_t VERTEX_FORMAT = 0; // webifc::geometry::VertexFormat of the vertex data handed out with meshes
+        bool WELD_VERTICES = false; // faces share the vertices they have in common instead of having three each
+        bool OPTIMIZE_VERTEX_CACHE = false; // with WELD_VERTICES the faces are ordered for the GPU's vertex cache
+        double CIRCLE_CHORD_TOLERANCE = 0; // largest deviation of arcs from their chords in model units, 0 uses CIRCLE_SEGMENTS on every arc
+        double BOOLEAN_TIME_BUDGET = 0; // milliseconds a single boolean may take before the operands are kept un-cut, 0 has no limit
+        double ELEMENT_TIME_BUDGET = 0; // milliseconds all booleans of one element may take, 0 has no limit
+        uint32_t BOOLEAN_FACE_BUDGET = 0; // faces the operands of a boolean may have before it is skipped, 0 has no limit
+        bool EXPORT_POLYLINES = false; // curves, points and edges among the representation items are meshed as polylines
+        uint32_t TERRAIN_CHUNK_TRIANGLES = 0; // triangulated irregular networks and face sets of more triangles are only streamed in chunks, 0 meshes them whole
+        std::vector<uint32_t> INCLUDE_TYPES; // only lines of these types and what they reference are kept, empty keeps all types
+        std::vector<uint32_t> EXCLUDE_TYPES; // lines of these types are never kept, even when referenced
     };
 
+    // models may be created, opened and closed from several threads at once, a model itself is used by one thread at a time
     class ModelManager
     {
     public:
@@ -42,14 +60,27 @@ namespace webifc::manager
         bool IsModelOpen(uint32_t modelID) const;
         void CloseModel(uint32_t modelID);
         uint32_t CreateModel(LoaderSettings settings);
+        // creates a model for every file and tokenizes and indexes the files concurrently, one thread per model, the
+        // models keep their file. Returns the modelIDs in the order of files
+        std::vector<uint32_t> OpenModels(const LoaderSettings &settings, const std::vector<std::shared_ptr<const std::vector<uint8_t>>> &files);
+        // a model over the lines of modelID with a geometry processor of its own, sharing the tape, the line table and the
+        // indices instead of loading the file again. The tape is made resident first so that both models can be meshed on
+        // different threads without reloading chunks, nullopt when the model is not open, still loading or the memory
+        // limit does not allow it. Edits to either model are not seen by the other
+        std::optional<uint32_t> AttachModel(uint32_t modelID);
+        // where the memory of an open model goes, all zero for models that are not open. The model must not be in use
+        // meanwhile
+        webifc::utility::MemoryStats GetMemoryStats(uint32_t modelID) const;
         void SetLogLevel(uint8_t levelArg);
         void CloseAllModels();
 
     private:
         const webifc::schema::IfcSchemaManager _schemaManager;
-        std::vector<webifc::parsing::IfcLoader *> _loaders;
-        std::vector<LoaderSettings> _settings;
+        // deques, so that loaders and settings handed out stay in place while models are created
+        std::deque<webifc::parsing::IfcLoader *> _loaders;
+        std::deque<LoaderSettings> _settings;
         std::map<uint32_t, webifc::geometry::IfcGeometryProcessor *> _geometryProcessors;
+        mutable std::shared_mutex _modelsMutex;
         bool header_shown = false;
         bool mt_enabled;
     };
@@ -0,0 +1,611 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <spdlog/spdlog.h>
+#include "IfcCompressedFile.h"
+
+// inflate follows RFC 1951, the containers RFC 1950 (zlib), RFC 1952 (gzip) and the local file headers of PKWARE's
+// APPNOTE (zip)
+namespace webifc::parsing
+{
+
+  namespace
+  {
+    constexpr size_t INPUT_SIZE = 64 * 1024;
+    // the farthest back reference of deflate
+    constexpr size_t WINDOW_SIZE = 32 * 1024;
+    // kept before the last read, so that stepping back a little does not inflate again from a checkpoint
+    constexpr size_t KEEP_SIZE = 2 * WINDOW_SIZE;
+    // bytes the decoder drops at once, fewer are left in place
+    constexpr size_t TRIM_SIZE = 1024 * 1024;
+    constexpr uint64_t CHECKPOINT_SPACING = 4 * 1024 * 1024;
+    constexpr uint32_t MAX_PADDING = 8;
+
+    constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    constexpr uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    constexpr uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    uint32_t ReadLE(const uint8_t *data, size_t size)
+    {
+      uint32_t value = 0;
+      for (size_t i = 0; i < size; i++) value |= uint32_t(data[i]) << (8 * i);
+      return value;
+    }
+
+    constexpr std::array<uint32_t, 256> MakeCrcTable()
+    {
+      std::array<uint32_t, 256> table{};
+      for (uint32_t n = 0; n < 256; n++)
+      {
+        uint32_t c = n;
+        for (uint32_t k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        table[n] = c;
+      }
+      return table;
+    }
+
+    constexpr std::array<uint32_t, 256> CRC_TABLE = MakeCrcTable();
+
+    // the CRC32 of gzip and zip, crc starts at 0
+    uint32_t UpdateCrc32(uint32_t crc, const uint8_t *data, size_t size)
+    {
+      crc = ~crc;
+      for (size_t i = 0; i < size; i++) crc = CRC_TABLE[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+      return ~crc;
+    }
+
+    // the Adler-32 of zlib, adler starts at 1. The sums are reduced every 5552 bytes, the most they take without
+    // overflowing
+    uint32_t UpdateAdler32(uint32_t adler, const uint8_t *data, size_t size)
+    {
+      constexpr uint32_t BASE = 65521;
+      uint32_t a = adler & 0xffff;
+      uint32_t b = adler >> 16;
+      while (size > 0)
+      {
+        size_t block = std::min<size_t>(size, 5552);
+        size -= block;
+        while (block-- > 0)
+        {
+          a += *data++;
+          b += a;
+        }
+        a %= BASE;
+        b %= BASE;
+      }
+      return (b << 16) | a;
+    }
+
+    // canonical codes from their lengths, incomplete codes are allowed as deflate streams with a single distance do
+    // have them, oversubscribed ones are not
+    bool BuildHuffman(IfcCompressedFile::Huffman &huffman, const uint8_t *lengths, uint32_t count)
+    {
+      std::memset(huffman.count, 0, sizeof(huffman.count));
+      for (uint32_t i = 0; i < count; i++) huffman.count[lengths[i]]++;
+      huffman.count[0] = 0;
+      int32_t left = 1;
+      for (uint32_t length = 1; length < 16; length++)
+      {
+        left = (left << 1) - huffman.count[length];
+        if (left < 0) return false;
+      }
+      uint16_t offsets[16];
+      offsets[1] = 0;
+      for (uint32_t length = 1; length < 15; length++) offsets[length + 1] = offsets[length] + huffman.count[length];
+      for (uint32_t i = 0; i < count; i++)
+      {
+        if (lengths[i] != 0) huffman.symbol[offsets[lengths[i]]++] = i;
+      }
+
+      std::memset(huffman.fast, 0, sizeof(huffman.fast));
+      constexpr uint32_t FAST_BITS = IfcCompressedFile::Huffman::FAST_BITS;
+      uint32_t code = 0;
+      uint32_t index = 0;
+      for (uint32_t length = 1; length <= FAST_BITS; length++)
+      {
+        for (uint32_t i = 0; i < huffman.count[length]; i++, code++)
+        {
+          // codes are sent from their most significant bit on, the input is read from the least significant bit on
+          uint32_t reversed = 0;
+          for (uint32_t bit = 0; bit < length; bit++) reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+          const uint16_t entry = (length << 9) | huffman.symbol[index++];
+          for (uint32_t fill = reversed; fill < (1u << FAST_BITS); fill += 1u << length) huffman.fast[fill] = entry;
+        }
+        code <<= 1;
+      }
+      return true;
+    }
+  }
+
+  bool IfcCompressedFile::IsCompressed(const uint8_t *header, size_t size)
+  {
+    if (size < 4) return false;
+    if (ReadLE(header, 4) == 0x04034b50) return true;
+    if (header[0] == 0x1f && header[1] == 0x8b && header[2] == 8) return true;
+    return (header[0] & 0x0f) == 8 && (header[0] >> 4) <= 7 && ((header[0] << 8) | header[1]) % 31 == 0;
+  }
+
+  bool IfcCompressedFile::Open(const uint8_t *data, size_t size)
+  {
+    return Open([data, size](char *dest, size_t offset, size_t destSize)
+                {
+      if (offset >= size) return uint32_t(0);
+      const size_t read = std::min(destSize, size - offset);
+      std::memcpy(dest, data + offset, read);
+      return uint32_t(read); });
+  }
+
+  bool IfcCompressedFile::Open(const std::function<uint32_t(char *, size_t, size_t)> &readData)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _readData = readData;
+    _input.resize(INPUT_SIZE);
+    _checkpoints.clear();
+    _failed = !openContainer();
+    if (_failed) return false;
+
+    uint8_t lengths[320];
+    std::fill(lengths, lengths + 144, 8);
+    std::fill(lengths + 144, lengths + 256, 9);
+    std::fill(lengths + 256, lengths + 280, 7);
+    std::fill(lengths + 280, lengths + 288, 8);
+    BuildHuffman(_fixedLengths, lengths, 288);
+    std::fill(lengths, lengths + 30, 5);
+    BuildHuffman(_fixedDistances, lengths, 30);
+
+    _checkpoints.push_back({_dataStart * 8, 0, {}, _container == Container::ZLIB ? 1u : 0u});
+    restart(_checkpoints.front());
+    return true;
+  }
+
+  bool IfcCompressedFile::openContainer()
+  {
+    // the container headers are parsed from the first bytes read at the header's offset
+    std::vector<uint8_t> header(INPUT_SIZE);
+    auto readHeader = [&](uint64_t offset)
+    {
+      header.resize(INPUT_SIZE);
+      header.resize(_readData(reinterpret_cast<char *>(header.data()), offset, header.size()));
+      return header.size();
+    };
+    if (readHeader(0) < 4)
+    {
+      spdlog::error("[IfcCompressedFile::Open()] file too small");
+      return false;
+    }
+
+    if (ReadLE(header.data(), 4) == 0x04034b50)
+    {
+      // the first .ifc entry, walking the local headers while their sizes are known, the first entry otherwise
+      uint64_t offset = 0;
+      struct Entry
+      {
+        uint64_t dataStart = 0;
+        uint32_t flags = 0;
+        uint32_t method = 0;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+      };
+      Entry first;
+      Entry chosen;
+      bool found = false;
+      uint32_t entries = 0;
+      for (uint32_t entry = 0; !found; entry++)
+      {
+        if (entry > 0 && readHeader(offset) < 30) break;
+        if (header.size() < 30 || ReadLE(header.data(), 4) != 0x04034b50) break;
+        const uint32_t nameLength = ReadLE(header.data() + 26, 2);
+        const uint32_t extraLength = ReadLE(header.data() + 28, 2);
+        if (header.size() < 30 + nameLength) break;
+        std::string name(reinterpret_cast<const char *>(header.data()) + 30, nameLength);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        Entry current;
+        current.dataStart = offset + 30 + nameLength + extraLength;
+        current.flags = ReadLE(header.data() + 6, 2);
+        current.method = ReadLE(header.data() + 8, 2);
+        current.size = ReadLE(header.data() + 22, 4);
+        current.crc = ReadLE(header.data() + 14, 4);
+        const uint64_t compressedSize = ReadLE(header.data() + 18, 4);
+        if (entry == 0) first = current;
+        entries++;
+        if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".ifc") == 0)
+        {
+          chosen = current;
+          found = true;
+        }
+        // with a data descriptor the sizes only follow the data
+        if ((current.flags & 8) != 0) break;
+        offset = current.dataStart + compressedSize;
+      }
+      if (entries == 0)
+      {
+        spdlog::error("[IfcCompressedFile::Open()] truncated zip header");
+        return false;
+      }
+      if (!found) chosen = first;
+      if ((chosen.flags & 1) != 0)
+      {
+        spdlog::error("[IfcCompressedFile::Open()] encrypted zip entries are not supported");
+        return false;
+      }
+      if (chosen.method == 0 && (chosen.flags & 8) == 0)
+      {
+        // stored entries are read in place, so their last byte has to be there
+        char last;
+        if (chosen.size > 0 && _readData(&last, chosen.dataStart + chosen.size - 1, 1) != 1)
+        {
+          spdlog::error("[IfcCompressedFile::Open()] zip entry runs past the end of the file");
+          return false;
+        }
+        _stored = true;
+        _storedSize = chosen.size;
+      }
+      else if (chosen.method != 8)
+      {
+        spdlog::error("[IfcCompressedFile::Open()] zip compression method {} is not supported", chosen.method);
+        return false;
+      }
+      // with a data descriptor the CRC and the size are not known until the data has been read
+      _knownChecksum = (chosen.flags & 8) == 0;
+      _expectedChecksum = chosen.crc;
+      _expectedSize = static_cast<uint32_t>(chosen.size);
+      _container = Container::ZIP;
+      _dataStart = chosen.dataStart;
+      return true;
+    }
+
+    if (header[0] == 0x1f && header[1] == 0x8b)
+    {
+      if (header[2] != 8)
+      {
+        spdlog::error("[IfcCompressedFile::Open()] gzip compression method {} is not supported", header[2]);
+        return false;
+      }
+      const uint8_t flags = header[3];
+      size_t offset = 10;
+      if ((flags & 4) != 0) offset += 2 + (header.size() >= offset + 2 ? ReadLE(header.data() + offset, 2) : 0);
+      // the file name and the comment end with a NUL
+      for (uint8_t field : {uint8_t(8), uint8_t(16)})
+      {
+        if ((flags & field) == 0) continue;
+        while (offset < header.size() && header[offset] != 0) offset++;
+        offset++;
+      }
+      if ((flags & 2) != 0) offset += 2;
+      if (offset >= header.size())
+      {
+        spdlog::error("[IfcCompressedFile::Open()] truncated gzip header");
+        return false;
+      }
+      _container = Container::GZIP;
+      _dataStart = offset;
+      return true;
+    }
+
+    if ((header[1] & 0x20) != 0)
+    {
+      spdlog::error("[IfcCompressedFile::Open()] zlib streams with a preset dictionary are not supported");
+      return false;
+    }
+    _container = Container::ZLIB;
+    _dataStart = 2;
+    return true;
+  }
+
+  void IfcCompressedFile::restart(const Checkpoint &checkpoint)
+  {
+    _output = checkpoint.window;
+    _outputStart = checkpoint.outputOffset - checkpoint.window.size();
+    _inputOffset = checkpoint.bitOffset / 8;
+    _inputSize = 0;
+    _inputPos = 0;
+    _padding = 0;
+    _bitBuffer = 0;
+    _bitCount = 0;
+    _finished = false;
+    _checksum = checkpoint.checksum;
+    _checkedEnd = checkpoint.outputOffset;
+    const uint32_t skipped = checkpoint.bitOffset % 8;
+    if (skipped > 0 && need(skipped)) bits(skipped);
+  }
+
+  bool IfcCompressedFile::refill()
+  {
+    _inputOffset += _inputSize;
+    _inputSize = _readData(reinterpret_cast<char *>(_input.data()), _inputOffset, _input.size());
+    _inputPos = 0;
+    return _inputSize > 0;
+  }
+
+  bool IfcCompressedFile::need(uint32_t count)
+  {
+    while (_bitCount < count)
+    {
+      uint64_t byte = 0;
+      if (_inputPos < _inputSize || refill()) byte = _input[_inputPos++];
+      else if (++_padding > MAX_PADDING) return false;
+      _bitBuffer |= byte << _bitCount;
+      _bitCount += 8;
+    }
+    return true;
+  }
+
+  uint32_t IfcCompressedFile::bits(uint32_t count)
+  {
+    const uint32_t value = static_cast<uint32_t>(_bitBuffer & ((uint64_t(1) << count) - 1));
+    _bitBuffer >>= count;
+    _bitCount -= count;
+    return value;
+  }
+
+  int32_t IfcCompressedFile::decode(const Huffman &huffman)
+  {
+    if (!need(15)) return -1;
+    const uint16_t entry = huffman.fast[_bitBuffer & ((1u << Huffman::FAST_BITS) - 1)];
+    if (entry != 0)
+    {
+      bits(entry >> 9);
+      return entry & 511;
+    }
+    int32_t code = 0;
+    int32_t first = 0;
+    int32_t index = 0;
+    for (uint32_t length = 1; length < 16; length++)
+    {
+      code |= (_bitBuffer >> (length - 1)) & 1;
+      const int32_t count = huffman.count[length];
+      if (code - first < count)
+      {
+        bits(length);
+        return huffman.symbol[index + code - first];
+      }
+      index += count;
+      first = (first + count) << 1;
+      code <<= 1;
+    }
+    return -1;
+  }
+
+  bool IfcCompressedFile::inflateBlock()
+  {
+    const uint64_t outputEnd = _outputStart + _output.size();
+    if (_padding == 0 && outputEnd >= _checkpoints.back().outputOffset + CHECKPOINT_SPACING)
+    {
+      const size_t window = std::min(_output.size(), WINDOW_SIZE);
+      updateChecksum();
+      _checkpoints.push_back({(_inputOffset + _inputPos) * 8 - _bitCount, outputEnd, std::vector<char>(_output.end() - window, _output.end()), _checksum});
+    }
+
+    if (!need(3)) return false;
+    const bool last = bits(1) == 1;
+    const uint32_t type = bits(2);
+    bool inflated = false;
+    if (type == 0) inflated = inflateStored();
+    else if (type == 1) inflated = inflateCodes(_fixedLengths, _fixedDistances);
+    else if (type == 2) inflated = inflateDynamic();
+    _finished = last;
+    if (inflated && last && !checkTrailer())
+    {
+      spdlog::error("[IfcCompressedFile::Read()] the checksum of the inflated bytes does not match");
+      return false;
+    }
+    return inflated;
+  }
+
+  void IfcCompressedFile::updateChecksum()
+  {
+    const uint64_t outputEnd = _outputStart + _output.size();
+    if (_checkedEnd >= outputEnd) return;
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(_output.data()) + (_checkedEnd - _outputStart);
+    const size_t size = outputEnd - _checkedEnd;
+    _checksum = _container == Container::ZLIB ? UpdateAdler32(_checksum, data, size) : UpdateCrc32(_checksum, data, size);
+    _checkedEnd = outputEnd;
+  }
+
+  bool IfcCompressedFile::checkTrailer()
+  {
+    updateChecksum();
+    const uint32_t size = static_cast<uint32_t>(_outputStart + _output.size());
+    bool matches = true;
+    if (_container == Container::ZIP)
+    {
+      matches = !_knownChecksum || (_checksum == _expectedChecksum && size == _expectedSize);
+    }
+    else
+    {
+      // the trailer starts at the next byte, zlib stores the Adler-32 big endian, gzip the CRC32 and the size little endian
+      bits(_bitCount % 8);
+      if (!need(32)) return false;
+      if (_container == Container::ZLIB)
+      {
+        uint32_t adler = 0;
+        for (int i = 0; i < 4; i++) adler = (adler << 8) | bits(8);
+        matches = adler == _checksum;
+      }
+      else
+      {
+        const uint32_t crc = bits(32);
+        if (!need(32)) return false;
+        matches = crc == _checksum && bits(32) == size;
+      }
+    }
+    // zeros fed in past the end of the input that were read as part of the stream mean it was cut off
+    return matches && _padding <= _bitCount / 8;
+  }
+
+  bool IfcCompressedFile::inflateStored()
+  {
+    bits(_bitCount % 8);
+    if (!need(32)) return false;
+    const uint32_t length = bits(16);
+    if (bits(16) != (~length & 0xffff)) return false;
+    size_t remaining = length;
+    // whole bytes still in the bit buffer come first
+    while (remaining > 0 && _bitCount >= 8)
+    {
+      _output.push_back(static_cast<char>(bits(8)));
+      remaining--;
+    }
+    while (remaining > 0)
+    {
+      if (_inputPos == _inputSize && !refill()) return false;
+      const size_t copied = std::min(remaining, _inputSize - _inputPos);
+      _output.insert(_output.end(), _input.begin() + _inputPos, _input.begin() + _inputPos + copied);
+      _inputPos += copied;
+      remaining -= copied;
+    }
+    return true;
+  }
+
+  bool IfcCompressedFile::inflateDynamic()
+  {
+    if (!need(14)) return false;
+    const uint32_t lengthCount = bits(5) + 257;
+    const uint32_t distanceCount = bits(5) + 1;
+    const uint32_t codeLengthCount = bits(4) + 4;
+    if (lengthCount > 286 || distanceCount > 30) return false;
+
+    uint8_t lengths[320] = {};
+    for (uint32_t i = 0; i < codeLengthCount; i++)
+    {
+      if (!need(3)) return false;
+      lengths[CODE_LENGTH_ORDER[i]] = bits(3);
+    }
+    if (!BuildHuffman(_lengths, lengths, 19)) return false;
+
+    // the literal/length and distance code lengths are one sequence, repeats may run from one into the other
+    uint8_t codeLengths[320] = {};
+    uint32_t index = 0;
+    while (index < lengthCount + distanceCount)
+    {
+      int32_t symbol = decode(_lengths);
+      if (symbol < 0) return false;
+      if (symbol < 16)
+      {
+        codeLengths[index++] = symbol;
+        continue;
+      }
+      uint8_t value = 0;
+      uint32_t repeat = 0;
+      if (!need(7)) return false;
+      if (symbol == 16)
+      {
+        if (index == 0) return false;
+        value = codeLengths[index - 1];
+        repeat = 3 + bits(2);
+      }
+      else if (symbol == 17) repeat = 3 + bits(3);
+      else repeat = 11 + bits(7);
+      if (index + repeat > lengthCount + distanceCount) return false;
+      while (repeat-- > 0) codeLengths[index++] = value;
+    }
+    // a block without an end of block code cannot end
+    if (codeLengths[256] == 0) return false;
+    if (!BuildHuffman(_lengths, codeLengths, lengthCount)) return false;
+    if (!BuildHuffman(_distances, codeLengths + lengthCount, distanceCount)) return false;
+    return inflateCodes(_lengths, _distances);
+  }
+
+  bool IfcCompressedFile::inflateCodes(const Huffman &lengths, const Huffman &distances)
+  {
+    while (true)
+    {
+      const int32_t symbol = decode(lengths);
+      if (symbol < 0) return false;
+      if (symbol < 256)
+      {
+        _output.push_back(static_cast<char>(symbol));
+        continue;
+      }
+      if (symbol == 256) return true;
+      const uint32_t lengthSymbol = symbol - 257;
+      if (lengthSymbol >= 29) return false;
+      if (!need(LENGTH_EXTRA[lengthSymbol])) return false;
+      const uint32_t length = LENGTH_BASE[lengthSymbol] + bits(LENGTH_EXTRA[lengthSymbol]);
+      const int32_t distanceSymbol = decode(distances);
+      if (distanceSymbol < 0 || distanceSymbol >= 30) return false;
+      if (!need(DISTANCE_EXTRA[distanceSymbol])) return false;
+      const uint32_t distance = DISTANCE_BASE[distanceSymbol] + bits(DISTANCE_EXTRA[distanceSymbol]);
+      if (distance > _output.size()) return false;
+      // the copy may overlap the bytes it appends
+      size_t from = _output.size() - distance;
+      _output.resize(_output.size() + length);
+      char *data = _output.data();
+      for (size_t to = _output.size() - length; to < _output.size(); to++) data[to] = data[from++];
+    }
+  }
+
+  void IfcCompressedFile::trim(uint64_t offset)
+  {
+    // the dropped bytes are not inflated again unless a read goes back to them
+    updateChecksum();
+    const uint64_t outputEnd = _outputStart + _output.size();
+    const uint64_t keepFrom = std::min(offset, outputEnd);
+    if (keepFrom < _outputStart + KEEP_SIZE + TRIM_SIZE) return;
+    const size_t dropped = keepFrom - KEEP_SIZE - _outputStart;
+    _output.erase(_output.begin(), _output.begin() + dropped);
+    _outputStart += dropped;
+  }
+
+  uint32_t IfcCompressedFile::Read(char *dest, size_t offset, size_t size)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_failed) return 0;
+    if (_stored)
+    {
+      if (offset >= _storedSize) return 0;
+      return _readData(dest, _dataStart + offset, std::min<uint64_t>(size, _storedSize - offset));
+    }
+
+    if (offset < _outputStart)
+    {
+      auto checkpoint = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), offset, [](uint64_t value, const Checkpoint &c) { return value < c.outputOffset; });
+      restart(*std::prev(checkpoint));
+    }
+    size_t filled = 0;
+    while (filled < size)
+    {
+      const uint64_t at = offset + filled;
+      const uint64_t outputEnd = _outputStart + _output.size();
+      if (at < outputEnd)
+      {
+        const size_t copied = std::min<uint64_t>(size - filled, outputEnd - at);
+        std::memcpy(dest + filled, _output.data() + (at - _outputStart), copied);
+        filled += copied;
+        continue;
+      }
+      if (_finished) break;
+      trim(at);
+      if (!inflateBlock())
+      {
+        spdlog::error("[IfcCompressedFile::Read()] corrupt deflate stream at {} inflated bytes", outputEnd);
+        _failed = true;
+        break;
+      }
+    }
+    return filled;
+  }
+
+  bool IfcCompressedFile::IsCorrupt() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _failed;
+  }
+
+  uint64_t IfcCompressedFile::GetMemorySize() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t bytes = _output.capacity() + _input.capacity() + _checkpoints.capacity() * sizeof(Checkpoint);
+    for (const auto &checkpoint : _checkpoints) bytes += checkpoint.window.capacity();
+    return bytes;
+  }
+
+}
@@ -0,0 +1,108 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace webifc::parsing
+{
+
+  // the IFC file of an IFCZIP archive, a gzip or a zlib stream, inflated while it is read. Only the bytes around the last
+  // read are kept, reads behind them inflate again from the closest checkpoint, so evicted chunks can be reloaded without
+  // the whole file ever being inflated at once
+  class IfcCompressedFile
+  {
+    public:
+      // true when the header starts a zip archive, a gzip stream or a zlib stream
+      static bool IsCompressed(const uint8_t *header, size_t size);
+      // the compressed bytes are read with readData(dest, offset, size), which returns how many it read. False when the
+      // container or its compression method is not supported
+      bool Open(const std::function<uint32_t(char *, size_t, size_t)> &readData);
+      // the data is read in place and must outlive the file
+      bool Open(const uint8_t *data, size_t size);
+      // inflated bytes from offset on, as many as there are up to size. 0 at the end and once the stream turned out to be
+      // corrupt. Reads from several threads are served one after another
+      uint32_t Read(char *dest, size_t offset, size_t size);
+      // true once a read found the stream corrupt or its checksum wrong, the bytes read before are then not to be trusted
+      bool IsCorrupt() const;
+      // the inflated bytes kept, the input buffer and the checkpoints
+      uint64_t GetMemorySize() const;
+
+      struct Huffman
+      {
+        static constexpr uint32_t FAST_BITS = 10;
+        // (length << 9) | symbol of the codes up to FAST_BITS long by their next FAST_BITS input bits, 0 for longer codes
+        uint16_t fast[1 << FAST_BITS];
+        uint16_t count[16];
+        uint16_t symbol[320];
+      };
+
+    private:
+      // the block at which inflating can start over, with the window its back references may reach into
+      struct Checkpoint
+      {
+        uint64_t bitOffset;
+        uint64_t outputOffset;
+        std::vector<char> window;
+        // of the inflated bytes up to the checkpoint
+        uint32_t checksum;
+      };
+      enum class Container
+      {
+        ZIP,
+        GZIP,
+        ZLIB
+      };
+      bool openContainer();
+      void restart(const Checkpoint &checkpoint);
+      bool refill();
+      bool need(uint32_t count);
+      uint32_t bits(uint32_t count);
+      int32_t decode(const Huffman &huffman);
+      bool inflateBlock();
+      bool inflateStored();
+      bool inflateDynamic();
+      bool inflateCodes(const Huffman &lengths, const Huffman &distances);
+      void trim(uint64_t offset);
+      void updateChecksum();
+      // verifies the checksum and size of the stream once its last block is inflated
+      bool checkTrailer();
+      std::function<uint32_t(char *, size_t, size_t)> _readData;
+      bool _stored = false;
+      Container _container = Container::ZLIB;
+      // the CRC32 and size a zip entry's local header gives when it has no data descriptor
+      bool _knownChecksum = false;
+      uint32_t _expectedChecksum = 0;
+      uint32_t _expectedSize = 0;
+      // of the inflated bytes up to _checkedEnd
+      uint32_t _checksum = 0;
+      uint64_t _checkedEnd = 0;
+      uint64_t _dataStart = 0;
+      uint64_t _storedSize = 0;
+      std::vector<uint8_t> _input;
+      uint64_t _inputOffset = 0;
+      size_t _inputSize = 0;
+      size_t _inputPos = 0;
+      // zero bytes fed in past the end of the input, a few are needed to peek at the last codes
+      uint32_t _padding = 0;
+      uint64_t _bitBuffer = 0;
+      uint32_t _bitCount = 0;
+      std::vector<char> _output;
+      uint64_t _outputStart = 0;
+      bool _finished = false;
+      bool _failed = false;
+      std::vector<Checkpoint> _checkpoints;
+      Huffman _fixedLengths;
+      Huffman _fixedDistances;
+      Huffman _lengths;
+      Huffman _distances;
+      mutable std::mutex _mutex;
+  };
+
+}
@@ -3,6 +3,8 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
  #include "IfcTokenStream.h"
+ #include "byte_scan.h"
+ #include <algorithm>
 
  namespace webifc::parsing {
 
@@ -12,13 +14,30 @@
      load();
    }
 
+   IfcTokenStream::IfcFileStream::IfcFileStream(const char *data, const size_t dataStartRef, const size_t dataEndRef, uint32_t size) : _memory(data), _memoryStartRef(dataStartRef), _memoryEndRef(dataEndRef), _size(size)
+   {
+     _buffer = nullptr;
+     load();
+   }
+
    IfcTokenStream::IfcFileStream::~IfcFileStream() 
    {
-    delete _buffer;
+    if (_memory == nullptr) delete[] _buffer;
    }
    
    void IfcTokenStream::IfcFileStream::load()
    {
+     if (_memory != nullptr)
+     {
+       const bool inRange = _startRef >= _memoryStartRef && _startRef < _memoryEndRef;
+       prev = _startRef > _memoryStartRef && _startRef <= _memoryEndRef ? _memory[_startRef - _memoryStartRef - 1] : 0;
+       // past the end of the range the lexer may still peek at the next byte, it then sees a NUL instead of the start of the range
+       static char rangeEnd = 0;
+       _buffer = inRange ? const_cast<char *>(_memory) + (_startRef - _memoryStartRef) : &rangeEnd;
+       _currentSize = inRange ? std::min<size_t>(_size, _memoryEndRef - _startRef) : 0;
+       _pointer = 0;
+       return;
+     }
      if (_buffer == nullptr) _buffer = new char[_size];
      else if (_currentSize > 0) prev=_buffer[_currentSize-1];
      _currentSize = _dataSource(_buffer, _startRef, _size);
@@ -41,6 +60,45 @@
      }
    }
 
+   void IfcTokenStream::IfcFileStream::SkipWhitespace()
+   {
+     while (_currentSize != 0)
+     {
+       _pointer += parsing::SkipWhitespace(_buffer + _pointer, _currentSize - _pointer);
+       if (_pointer < _currentSize) return;
+       _startRef += _currentSize;
+       load();
+     }
+   }
+
+   void IfcTokenStream::IfcFileStream::ReadUntil(const char delimiter, std::vector<char> &output)
+   {
+     while (_currentSize != 0)
+     {
+       const size_t length = FindByte(_buffer + _pointer, _currentSize - _pointer, delimiter);
+       output.insert(output.end(), _buffer + _pointer, _buffer + _pointer + length);
+       _pointer += length;
+       if (_pointer < _currentSize) return;
+       _startRef += _currentSize;
+       load();
+     }
+   }
+
+   std::string_view IfcTokenStream::IfcFileStream::Share(const size_t start, const size_t end, std::vector<char> &storage)
+   {
+     // memory sources are handed out in place, everything else is read into storage
+     if (_memory != nullptr) return std::string_view(_memory + (start - _memoryStartRef), end - start);
+     storage.resize(end - start);
+     size_t read = 0;
+     while (read < storage.size())
+     {
+       const size_t size = _dataSource(storage.data() + read, start + read, storage.size() - read);
+       if (size == 0) break;
+       read += size;
+     }
+     return std::string_view(storage.data(), read);
+   }
+
    void IfcTokenStream::IfcFileStream::Back()
    {
       if (_pointer == 0)
@@ -59,7 +117,7 @@
 
    void IfcTokenStream::IfcFileStream::Clear() 
    {
-      delete[] _buffer;
+      if (_memory == nullptr) delete[] _buffer;
       _buffer=nullptr;
    }
    
@@ -85,6 +143,7 @@
    }
 
    IfcTokenStream::IfcFileStream* IfcTokenStream::IfcFileStream::Clone() {
+    if (_memory != nullptr) return new IfcFileStream(_memory, _memoryStartRef, _memoryEndRef, _size);
     IfcFileStream * newStream = new IfcFileStream(_dataSource,_size);
     return newStream;
    }
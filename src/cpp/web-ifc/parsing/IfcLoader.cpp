@@ -3,37 +3,359 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
 #include <sstream>
+#include <array>
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <utility>
+#include <iterator>
+#include <cstring>
+#include <charconv>
+#include <type_traits>
 #include <format>
 #include <fast_float/fast_float.h>
 #include <spdlog/spdlog.h>
 #include "IfcLoader.h"
+#include "IfcRelationshipIndex.h"
+#include "byte_scan.h"
+#include "IfcTokenCursor.h"
 #include "../../version.h"
 #include "../schema/IfcSchemaManager.h" 
+#include "../utility/parallel.h"
+#include "../utility/binary_io.h"
+#include "../utility/hash.h"
+#include "../utility/timing.h"
+#include "../utility/trace.h"
 
 namespace webifc::parsing {
 
   void p21encode(std::string_view input, std::ostringstream &output);
+  void p21encode(std::string_view input, std::string &output);
   std::string p21decode(std::string_view & str);
+  std::string_view p21decode(std::string_view str, std::string &buffer);
   std::string generateStringUUID();
   std::string expandIfcGuid(const std::string_view &guid);
   std::string compressIfcGuid(const std::string& guid);
+  bool decodeIfcGuid(const std::string_view &guid, uint64_t &high, uint64_t &low);
+
+  namespace
+  {
+    // tape snapshots: header, line tables and type index, then the raw token chunks
+    constexpr char TAPE_MAGIC[8] = {'W', 'I', 'F', 'C', 'T', 'A', 'P', 'E'};
+    constexpr uint32_t TAPE_VERSION = 4;
+    constexpr uint32_t TAPE_FLAG_BINARY_NUMBERS = 1;
+    // sources read through a callback are hashed in blocks of this size
+    constexpr size_t TAPE_SOURCE_BLOCK_SIZE = 1 << 20;
+    // the source of a tape with written or removed lines, no file is that large so its snapshots load from none
+    constexpr uint64_t EDITED_TAPE_SOURCE_SIZE = UINT64_MAX;
+
+    IfcLoader::TapeSource HashSource(const std::function<uint32_t(char *, size_t, size_t)> &requestData)
+    {
+      std::vector<char> block(TAPE_SOURCE_BLOCK_SIZE);
+      utility::Fnv1a hash;
+      uint64_t size = 0;
+      while (true)
+      {
+        const uint32_t read = requestData(block.data(), size, block.size());
+        hash.Add(block.data(), read);
+        size += read;
+        if (read < block.size()) break;
+      }
+      return {size, hash.Get()};
+    }
+
+    // SaveFile only goes parallel for at least two ranges of this many tape bytes (ordered) or expressIDs (unordered)
+    constexpr size_t SAVE_TAPE_RANGE_SIZE = 1 << 23;
+    constexpr size_t SAVE_LINE_RANGE_SIZE = 1 << 16;
+
+    // the argument offsets of rewritten lines are dropped once they are at least this many entries and half of them
+    constexpr size_t MIN_STALE_ARGUMENT_OFFSETS = 1 << 16;
+
+    // LoadHeader reads the file in blocks of this size, gives up when the header is not over after the limit, and counts
+    // the lines in up to a block of the DATA section to estimate how many there are
+    constexpr size_t HEADER_PROBE_BLOCK = 1 << 16;
+    constexpr size_t HEADER_PROBE_LIMIT = 1 << 24;
+
+    // the offset just past the ENDSEC; that ends the HEADER section, searched from `from` on, 0 when it is not in text yet
+    size_t FindHeaderEnd(const std::string_view text, size_t &from)
+    {
+      while (true)
+      {
+        const size_t keyword = text.find("ENDSEC", from);
+        if (keyword == std::string_view::npos)
+        {
+          // the keyword may continue in the next block
+          from = text.size() < 6 ? 0 : text.size() - 5;
+          return 0;
+        }
+        size_t end = keyword + 6;
+        while (end < text.size() && (text[end] == ' ' || text[end] == '\n' || text[end] == '\r' || text[end] == '\t')) end++;
+        if (end == text.size())
+        {
+          from = keyword;
+          return 0;
+        }
+        if (text[end] == ';') return end + 1;
+        from = keyword + 6;
+      }
+    }
+
+    // what visitTokens does after a token, Stop leaves the position after the token and StopBefore in front of it
+    enum class TokenVisit
+    {
+      Next,
+      Stop,
+      StopBefore
+    };
+
+    // the number of #id= line starts in text
+    uint64_t CountLineStarts(const std::string_view text)
+    {
+      uint64_t lines = 0;
+      for (size_t i = text.find('#'); i != std::string_view::npos; i = text.find('#', i))
+      {
+        i++;
+        const size_t digits = i;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9') i++;
+        if (i == digits) continue;
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\t')) i++;
+        if (i < text.size() && text[i] == '=') lines++;
+      }
+      return lines;
+    }
+
+    // formats STEP text into a fixed-size buffer that is handed to outputData whenever it fills up, so writing a file
+    // does not allocate once the buffer exists
+    class StepWriter
+    {
+      public:
+        explicit StepWriter(const std::function<void(char *, size_t)> &outputData) : _outputData(outputData), _buffer(BUFFER_SIZE) {}
+
+        void Append(const char c)
+        {
+          if (_used == _buffer.size()) Flush();
+          _buffer[_used++] = c;
+        }
+
+        void Append(const std::string_view text)
+        {
+          if (text.size() > _buffer.size() - _used)
+          {
+            Flush();
+            if (text.size() > _buffer.size())
+            {
+              _outputData((char *)text.data(), text.size());
+              return;
+            }
+          }
+          std::memcpy(_buffer.data() + _used, text.data(), text.size());
+          _used += text.size();
+        }
+
+        void AppendNumber(const uint32_t value)
+        {
+          char digits[10];
+          const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+          Append(std::string_view(digits, result.ptr - digits));
+        }
+
+        // strings only need encoding when they hold quotes or characters outside printable ASCII
+        void AppendEncoded(const std::string_view text)
+        {
+          if (FindStepEncoding(text.data(), text.size()) != text.size())
+          {
+            _encoded.clear();
+            p21encode(text, _encoded);
+            Append(_encoded);
+            return;
+          }
+          Append(text);
+        }
+
+        void Flush()
+        {
+          if (_used == 0) return;
+          _outputData(_buffer.data(), _used);
+          _used = 0;
+        }
+
+      private:
+        static constexpr size_t BUFFER_SIZE = 1 << 20;
+        const std::function<void(char *, size_t)> &_outputData;
+        std::vector<char> _buffer;
+        size_t _used = 0;
+        std::string _encoded;
+    };
+
+    void skipToken(IfcTokenStream &tokenStream, const IfcTokenType t)
+    {
+      switch (t)
+      {
+        case IfcTokenType::STRING:
+        case IfcTokenType::ENUM:
+        case IfcTokenType::LABEL:
+        case IfcTokenType::REAL:
+        case IfcTokenType::INTEGER:
+          tokenStream.Forward(tokenStream.Read<uint16_t>());
+          break;
+        case IfcTokenType::REF:
+          tokenStream.Forward(sizeof(uint32_t));
+          break;
+        default:
+          break;
+      }
+    }
+
+    // writes the line starting at the current position of the token stream, up to and including its LINE_END
+    void writeLine(IfcTokenStream &tokenStream, StepWriter &output, const bool binaryNumbers)
+    {
+      bool newLine = true;
+      bool insideSet = false;
+      IfcTokenType prev = IfcTokenType::EMPTY;
+      while (!tokenStream.IsAtEnd())
+      {
+        IfcTokenType t = static_cast<IfcTokenType>(tokenStream.Read<char>());
+
+        if (t != IfcTokenType::SET_END && t != IfcTokenType::LINE_END)
+        {
+          if (insideSet && prev != IfcTokenType::SET_BEGIN && prev != IfcTokenType::LABEL && prev != IfcTokenType::LINE_END)
+          {
+            output.Append(',');
+          }
+        }
+
+        if (t == IfcTokenType::LINE_END)
+        {
+          output.Append(";\n");
+          break;
+        }
+
+        switch (t)
+        {
+          case IfcTokenType::UNKNOWN:
+          {
+            output.Append('*');
+            break;
+          }
+          case IfcTokenType::EMPTY:
+          {
+            output.Append('$');
+            break;
+          }
+          case IfcTokenType::SET_BEGIN:
+          {
+            output.Append('(');
+            insideSet = true;
+            break;
+          }
+          case IfcTokenType::SET_END:
+          {
+            output.Append(')');
+            break;
+          }
+          case IfcTokenType::STRING:
+          {
+            output.Append('\'');
+            output.AppendEncoded(tokenStream.ReadString());
+            output.Append('\'');
+            break;
+          }
+          case IfcTokenType::ENUM:
+          {
+            output.Append('.');
+            output.Append(tokenStream.ReadString());
+            output.Append('.');
+            break;
+          }
+          case IfcTokenType::REF:
+          {
+            output.Append('#');
+            output.AppendNumber(tokenStream.Read<uint32_t>());
+            if (newLine) output.Append('=');
+            break;
+          }
+          case IfcTokenType::LABEL:
+          { 
+            output.Append(tokenStream.ReadString());
+            break;
+          }
+          case IfcTokenType::REAL:
+          case IfcTokenType::INTEGER:
+          { 
+            output.Append(tokenStream.ReadString(binaryNumbers ? sizeof(double) : 0));
+            break;
+          }
+          default:
+            break;
+        }
+
+        newLine = false;
+        prev = t;
+      }
+    }
+
+    // the cursor of the IfcLoader::ReadScope that is open on this thread
+    struct ScopedReader
+    {
+      const IfcLoader *loader = nullptr;
+      IfcTokenStream *stream = nullptr;
+      IfcLoader::ReadScope *scope = nullptr;
+    };
+    thread_local ScopedReader scopedReader;
+  }
+
  
-   IfcLoader::IfcLoader(uint32_t tapeSize, uint64_t memoryLimit,uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager) :_lineWriterBuffer(lineWriterBuffer), _schemaManager(schemaManager)
+   IfcLoader::IfcLoader(uint32_t tapeSize, uint64_t memoryLimit,uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager, bool binaryNumbers) :_lineWriterBuffer(lineWriterBuffer), _schemaManager(schemaManager), _binaryNumbers(binaryNumbers)
    { 
      uint64_t maxChunks;
      if (memoryLimit > 0) maxChunks = memoryLimit/tapeSize; 
      else maxChunks = 0;
-     _tokenStream = new IfcTokenStream(tapeSize,maxChunks);
+     _tokenStream = new IfcTokenStream(tapeSize,maxChunks,binaryNumbers);
      _maxExpressId=0;
    }  
+
+   void IfcLoader::SetTokenizerThreads(const size_t threads)
+   {
+     _tokenStream->SetTokenizerThreads(threads);
+   }
+
+   IfcTokenStream * IfcLoader::stream() const
+   {
+      return scopedReader.loader == this ? scopedReader.stream : _tokenStream;
+   }
+
+   bool IfcLoader::PrepareConcurrentReads() const
+   {
+      return _tokenStream->LoadAll();
+   }
+
+   IfcLoader::ReadScope::ReadScope(const IfcLoader &loader) : _stream(loader._tokenStream->CreateReadView()), _previousLoader(scopedReader.loader), _previousStream(scopedReader.stream), _previousScope(scopedReader.scope)
+   {
+      scopedReader = {&loader, _stream.get(), this};
+   }
+
+   IfcLoader::ReadScope::~ReadScope()
+   {
+      scopedReader = {_previousLoader, _previousStream, _previousScope};
+   }
    
    const std::vector<uint32_t> IfcLoader::GetExpressIDsWithType(const uint32_t type) const
    { 
-      if (_ifcTypeToExpressID.count(type)==0) return {};
-      return _ifcTypeToExpressID.at(type);
+      std::vector<uint32_t> expressIDs;
+      const auto rangeIt = _typeRanges.find(type);
+      if (rangeIt != _typeRanges.end())
+      {
+        const auto begin = _typeExpressIDs->begin() + rangeIt->second.first;
+        expressIDs.assign(begin, begin + rangeIt->second.second);
+      }
+      // while the file is loading the lines parsed so far are not in the type index yet
+      for (const auto &[lineType, expressID] : _parseState.typedLines) 
+      {
+        if (lineType == type) expressIDs.push_back(expressID);
+      }
+      const auto addedIt = _addedTypeExpressIDs.find(type);
+      if (addedIt != _addedTypeExpressIDs.end()) expressIDs.insert(expressIDs.end(), addedIt->second.begin(), addedIt->second.end());
+      return expressIDs;
    }
    
    const std::vector<uint32_t> IfcLoader::GetHeaderLinesWithType(const uint32_t type) const
@@ -41,15 +363,122 @@ namespace webifc::parsing {
      std::vector<uint32_t> ret;
      for (size_t i=0; i < _headerLines.size();i++)
      {
-        if (_headerLines[i]->ifcType==type) ret.push_back(i);
+        if (_headerLines[i].ifcType==type) ret.push_back(i);
      }
      return ret;
    }
    
    void IfcLoader::LoadFile(const std::function<uint32_t(char *, size_t, size_t)> &requestData)
    { 
-     _tokenStream->SetTokenSource(requestData);
-     ParseLines();
+     char header[4];
+     const uint32_t headerSize = requestData(header, 0, sizeof(header));
+     // the callback is read once more for the hash, a source cannot be told apart by less than all of it
+     _tapeSource = HashSource(requestData);
+     if (auto compressedFile = openCompressed(reinterpret_cast<const uint8_t *>(header), headerSize, [&](IfcCompressedFile &file) { return file.Open(requestData); }))
+     {
+       loadTokens([&]() { _tokenStream->SetTokenSource(compressedFile); });
+       return;
+     }
+     loadTokens([&]() { _tokenStream->SetTokenSource(requestData); });
+   }
+
+   std::optional<IfcLoader::HeaderInfo> IfcLoader::LoadHeader(const std::function<uint32_t(char *, size_t, size_t)> &requestData, uint64_t fileSize)
+   {
+     std::function<uint32_t(char *, size_t, size_t)> readData = requestData;
+     char header[4];
+     const uint32_t headerSize = requestData(header, 0, sizeof(header));
+     if (auto compressedFile = openCompressed(reinterpret_cast<const uint8_t *>(header), headerSize, [&](IfcCompressedFile &file) { return file.Open(requestData); }))
+     {
+       readData = [compressedFile](char *dest, size_t sourceOffset, size_t destSize) { return compressedFile->Read(dest, sourceOffset, destSize); };
+       // the inflated size is not known up front
+       fileSize = 0;
+     }
+
+     auto data = std::make_shared<std::vector<uint8_t>>();
+     auto text = [&]() { return std::string_view(reinterpret_cast<const char *>(data->data()), data->size()); };
+     auto readBlock = [&]()
+     {
+       const size_t size = data->size();
+       data->resize(size + HEADER_PROBE_BLOCK);
+       const uint32_t read = readData(reinterpret_cast<char *>(data->data() + size), size, HEADER_PROBE_BLOCK);
+       data->resize(size + read);
+       return read > 0;
+     };
+
+     size_t headerEnd = 0;
+     size_t searched = 0;
+     bool atEnd = false;
+     while (headerEnd == 0 && !atEnd && data->size() < HEADER_PROBE_LIMIT)
+     {
+       atEnd = !readBlock();
+       headerEnd = FindHeaderEnd(text(), searched);
+     }
+     if (headerEnd == 0)
+     {
+       spdlog::error("[LoadHeader()] no end of the HEADER section in the first {} bytes", data->size());
+       return std::nullopt;
+     }
+
+     HeaderInfo info;
+     info.dataOffset = headerEnd;
+     while (!atEnd && data->size() < headerEnd + HEADER_PROBE_BLOCK) atEnd = !readBlock();
+     const std::string_view sample = text().substr(headerEnd, HEADER_PROBE_BLOCK);
+     info.estimatedLines = CountLineStarts(sample);
+     // the sample holds all of the DATA section when the file ended within it
+     const bool wholeData = atEnd && data->size() <= headerEnd + HEADER_PROBE_BLOCK;
+     if (!wholeData && fileSize > headerEnd && !sample.empty())
+     {
+       info.estimatedLines = static_cast<uint64_t>(static_cast<double>(info.estimatedLines) * (fileSize - headerEnd) / sample.size());
+     }
+
+     data->resize(headerEnd);
+     // the tape holds the header only, so it is the tape of those bytes
+     _tapeSource = GetTapeSource(data->data(), data->size());
+     _fileData = data;
+     loadTokens([&]() { _tokenStream->SetTokenSource(reinterpret_cast<const char *>(_fileData->data()), _fileData->size()); });
+     return info;
+   }
+
+   std::shared_ptr<IfcCompressedFile> IfcLoader::openCompressed(const uint8_t *header, const size_t size, const std::function<bool(IfcCompressedFile &)> &open)
+   {
+     if (!IfcCompressedFile::IsCompressed(header, size)) return nullptr;
+     auto compressedFile = std::make_shared<IfcCompressedFile>();
+     if (open(*compressedFile)) return compressedFile;
+     spdlog::error("[LoadFile()] unable to inflate the file, it is read as it is");
+     return nullptr;
+   }
+
+   void IfcLoader::SetLoadProgressCallback(const std::function<void(uint64_t)> &progress)
+   {
+     _loadProgress = progress;
+   }
+
+   uint64_t IfcLoader::GetLoadedFileOffset() const
+   {
+     return _loadedFileOffset;
+   }
+
+   bool IfcLoader::IsLoading() const
+   {
+     return _loading;
+   }
+
+   IfcLoader::LoadTimes IfcLoader::GetLoadTimes() const
+   {
+     return _loadTimes;
+   }
+
+   void IfcLoader::AddMemoryStats(utility::MemoryStats &stats) const
+   {
+     _tokenStream->AddMemoryStats(stats);
+     if (_fileData) stats.fileBytes += _fileData->size();
+     // tables shared with clones are counted by every loader holding them
+     stats.lineTableBytes += _lines.Bytes() + utility::MapBytes(_sparseLines) + utility::VectorBytes(_headerLines);
+     stats.typeIndexBytes += utility::MapBytes(_typeRanges) + utility::VectorBytes(*_typeExpressIDs) + utility::MapOfVectorsBytes(_addedTypeExpressIDs);
+     stats.argumentIndexBytes += _argumentOffsets.Bytes();
+     if (_inverseIndex) stats.inverseIndexBytes += utility::MapBytes(_inverseIndex->ranges) + utility::VectorBytes(_inverseIndex->references);
+     stats.inverseIndexBytes += utility::MapBytes(_editedInverseLines) + utility::MapOfVectorsBytes(_addedInverseReferences);
+     if (_globalIds) stats.globalIdIndexBytes += utility::MapBytes(*_globalIds);
    }
 
    IFC_SCHEMA IfcLoader::GetSchema() const
@@ -58,12 +487,12 @@ namespace webifc::parsing {
       MoveToHeaderLineArgument(line, 0);
       auto schemas = _schemaManager.GetAvailableSchemas();
 
-      while (!_tokenStream->IsAtEnd()) {
-          IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
+      while (!stream()->IsAtEnd()) {
+          IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
           if (t == IfcTokenType::LINE_END) break;
           if (t == IfcTokenType::LABEL) 
           {
-            std::string_view schemaName = _tokenStream->ReadString();
+            std::string_view schemaName = stream()->ReadString();
             for (size_t i = 0; i < schemas.size();i++) 
             {
               if (_schemaManager.GetSchemaName(schemas[i]) == schemaName) return schemas[i];
@@ -75,142 +504,183 @@ namespace webifc::parsing {
    
    void IfcLoader::LoadFile(std::istream &requestData)
    { 
-     _tokenStream->SetTokenSource(requestData);
-     ParseLines();
+     LoadFile([&](char *dest, size_t sourceOffset, size_t destSize) { requestData.clear(); requestData.seekg(sourceOffset); requestData.read(dest, destSize); return static_cast<uint32_t>(requestData.gcount()); });
+   }
+   
+   bool IfcLoader::LoadFile(const std::string &path)
+   {
+     // the tokenizer reads the mapped pages directly, evicted chunks are reloaded from the page cache
+     auto mappedFile = std::make_shared<IfcMappedFile>();
+     if (!mappedFile->Open(path)) return false;
+     _mappedFile = mappedFile;
+     const auto *data = reinterpret_cast<const uint8_t *>(_mappedFile->GetData());
+     _tapeSource = GetTapeSource(data, _mappedFile->GetSize());
+     if (auto compressedFile = openCompressed(data, _mappedFile->GetSize(), [&](IfcCompressedFile &file) { return file.Open(data, _mappedFile->GetSize()); }))
+     {
+       loadTokens([&]() { _tokenStream->SetTokenSource(compressedFile); });
+       return true;
+     }
+     loadTokens([&]() { _tokenStream->SetTokenSource(_mappedFile->GetData(), _mappedFile->GetSize()); });
+     return true;
+   }
+   
+   void IfcLoader::LoadFile(std::shared_ptr<const std::vector<uint8_t>> data)
+   {
+     _fileData = std::move(data);
+     _tapeSource = GetTapeSource(_fileData->data(), _fileData->size());
+     if (auto compressedFile = openCompressed(_fileData->data(), _fileData->size(), [&](IfcCompressedFile &file) { return file.Open(_fileData->data(), _fileData->size()); }))
+     {
+       loadTokens([&]() { _tokenStream->SetTokenSource(compressedFile); });
+       return;
+     }
+     loadTokens([&]() { _tokenStream->SetTokenSource(reinterpret_cast<const char *>(_fileData->data()), _fileData->size()); });
    }
    
    void IfcLoader::SaveFile(const std::function<void(char *, size_t)> &outputData, bool orderLinesByExpressID) const
    { 
-      std::ostringstream output;
-      output << "ISO-10303-21;"<<std::endl<<"HEADER;"<<std::endl;
-      output << "/******************************************************" << std::endl;
-      output << "* STEP Physical File produced by: That Open Engine WebIfc " << WEB_IFC_VERSION_NUMBER << std::endl;
-      output << "* Module: web-ifc/IfcLoader" << std::endl;
-      output << "* Version: " << WEB_IFC_VERSION_NUMBER << std::endl;
-      output << "* Source: https://github.com/ThatOpen/engine_web-ifc" << std::endl;
-      output << "* Issues: https://github.com/ThatOpen/engine_web-ifc/issues" << std::endl;
-      output << "******************************************************/" << std::endl;
-      
-      uint32_t linesWritten = 0;
-      for (uint8_t z=0; z < 2; z++)
-      {
-        std::vector<IfcLine*>* currentLines;
-        if(z==0) currentLines= (std::vector<IfcLine*>*) &_headerLines;
-        else {
-          currentLines =  new std::vector<IfcLine*>();
-          std::transform( _lines.begin(), _lines.end(), std::back_inserter( *currentLines ), [](auto &kv){ return kv.second;}  );
-        }
-		if (orderLinesByExpressID) {
-			// Sort based on tapeOffset, which preserves the order by which the lines have been pushed
-			std::sort(currentLines->begin(), currentLines->end(), [](const IfcLine* a, const IfcLine* b) { return a->tapeOffset < b->tapeOffset; });
-		}
-        for(uint32_t i=0; i < currentLines->size();i++)
-        {
-       
-          IfcLine * line = (*currentLines)[i];
-
-          if (line->ifcType == 0) continue;
-          _tokenStream->MoveTo(line->tapeOffset);
-          bool newLine = true;
-          bool insideSet = false;
-          IfcTokenType prev = IfcTokenType::EMPTY;
-          while (!_tokenStream->IsAtEnd())
-          {
-            IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
+      StepWriter output(outputData);
+      output.Append("ISO-10303-21;\nHEADER;\n");
+      output.Append("/******************************************************\n");
+      output.Append("* STEP Physical File produced by: That Open Engine WebIfc ");
+      output.Append(WEB_IFC_VERSION_NUMBER);
+      output.Append('\n');
+      output.Append("* Module: web-ifc/IfcLoader\n");
+      output.Append("* Version: ");
+      output.Append(WEB_IFC_VERSION_NUMBER);
+      output.Append('\n');
+      output.Append("* Source: https://github.com/ThatOpen/engine_web-ifc\n");
+      output.Append("* Issues: https://github.com/ThatOpen/engine_web-ifc/issues\n");
+      output.Append("******************************************************/\n");
 
-            if (t != IfcTokenType::SET_END && t != IfcTokenType::LINE_END)
-            {
-              if (insideSet && prev != IfcTokenType::SET_BEGIN && prev != IfcTokenType::LABEL && prev != IfcTokenType::LINE_END)
-              {
-                output << ",";
-              }
-            }
+      std::vector<const IfcLine*> headerLines;
+      headerLines.reserve(_headerLines.size());
+      for (const auto &line : _headerLines) headerLines.push_back(&line);
+      if (orderLinesByExpressID) std::sort(headerLines.begin(), headerLines.end(), [](const IfcLine* a, const IfcLine* b) { return a->tapeOffset < b->tapeOffset; });
+      for (const IfcLine * line : headerLines)
+      {
+        if (line->ifcType == 0) continue;
+        _tokenStream->MoveTo(line->tapeOffset);
+        writeLine(*_tokenStream, output, _binaryNumbers);
+      }
+      output.Append("ENDSEC;\nDATA;\n");
+      output.Flush();
 
-            if (t == IfcTokenType::LINE_END)
-            {
-              output << ";" << std::endl;
-              break;
-            }
+      const size_t threads = utility::GetThreadCount();
+      if (threads <= 1 || !saveLinesParallel(outputData, orderLinesByExpressID, threads))
+      {
+        saveLines(*_tokenStream, outputData, orderLinesByExpressID, 0, orderLinesByExpressID ? _tokenStream->GetTotalSize() : _lines.size());
+      }
+      output.Append("ENDSEC;\nEND-ISO-10303-21;");
+      output.Flush();
+   }
 
-            switch (t)
-            {
-              case IfcTokenType::UNKNOWN:
-              {
-                output << "*";
-                break;
-              }
-              case IfcTokenType::EMPTY:
-              {
-                output << "$";
-                break;
-              }
-              case IfcTokenType::SET_BEGIN:
-              {
-                output << "(";
-                insideSet = true;
-                break;
-              }
-              case IfcTokenType::SET_END:
-              {
-                output << ")";
-                break;
-              }
-              case IfcTokenType::STRING:
-              {
-                output << "'";
-                p21encode(_tokenStream->ReadString(),output);
-                output << "'";
-                break;
-              }
-              case IfcTokenType::ENUM:
-              {
-                output << "." << _tokenStream->ReadString() << ".";
-                break;
-              }
-              case IfcTokenType::REF:
-              {
-                output << "#" << _tokenStream->Read<uint32_t>();
-                if (newLine) output << "=";
-                break;
-              }
-              case IfcTokenType::LABEL:
-              case IfcTokenType::REAL:
-              case IfcTokenType::INTEGER:
-              { 
-                output << _tokenStream->ReadString();
-                break;
-              }
-              default:
-                break;
-            }
+   void IfcLoader::saveLines(IfcTokenStream &tokenStream, const std::function<void(char *, size_t)> &outputData, const bool orderLinesByExpressID, const size_t start, const size_t end) const
+   {
+      StepWriter output(outputData);
+      uint32_t linesWritten = 0;
+      auto writeDataLine = [&](const size_t tapeOffset)
+      {
+        tokenStream.MoveTo(tapeOffset);
+        writeLine(tokenStream, output, _binaryNumbers);
+        linesWritten++;
+        if (linesWritten > _lineWriterBuffer)
+        {
+          output.Flush();
+          linesWritten = 0;
+        }
+      };
 
-            if (t == IfcTokenType::LINE_END)
-            {
-              newLine = true;
-              insideSet = false;
-            }
-            else
+      if (orderLinesByExpressID && start < end)
+      {
+        // the tape already holds the lines in the order they were pushed, so walk it once and write every line whose
+        // current tape offset is the one we are at, this skips header lines and the stale copies left by UpdateLineTape
+        tokenStream.MoveTo(start);
+        while (!tokenStream.IsAtEnd() && tokenStream.GetReadOffset() < end)
+        {
+          const size_t lineStart = tokenStream.GetReadOffset();
+          IfcTokenType t = IfcTokenType::EMPTY;
+          uint32_t expressID = 0;
+          while (!tokenStream.IsAtEnd())
+          {
+            t = static_cast<IfcTokenType>(tokenStream.Read<char>());
+            if (t == IfcTokenType::LINE_END) break;
+            if (t == IfcTokenType::REF) 
             {
-              newLine = false;
+              expressID = tokenStream.Read<uint32_t>();
+              break;
             }
-            prev = t;
+            skipToken(tokenStream, t);
+          }
+          if (t == IfcTokenType::LINE_END) continue;
+          const IfcLine * line = expressID == 0 ? nullptr : findLine(expressID);
+          if (line != nullptr && line->tapeOffset == lineStart)
+          {
+            writeDataLine(lineStart);
+            continue;
           }
-        
-          linesWritten++;
-          if (linesWritten > _lineWriterBuffer ) 
+          while (!tokenStream.IsAtEnd())
           {
-            std::string tmp = output.str();
-            outputData((char*)tmp.c_str(),tmp.size());
-            output.str("");
-            output.clear();
-            linesWritten=0;
+            t = static_cast<IfcTokenType>(tokenStream.Read<char>());
+            if (t == IfcTokenType::LINE_END) break;
+            skipToken(tokenStream, t);
           }
         }
-        if (z==0) output << "ENDSEC;"<<std::endl<<"DATA;"<<std::endl;
       }
-      output << "ENDSEC;"<<std::endl<<"END-ISO-10303-21;";
-      std::string tmp = output.str();
-      outputData((char*)tmp.c_str(),tmp.size());
+      else if (!orderLinesByExpressID)
+      {
+        for (size_t expressID = start; expressID < std::min(end, _lines.size()); expressID++) 
+        {
+          if (_lines[expressID].ifcType != 0) writeDataLine(_lines[expressID].tapeOffset);
+        }
+        if (end >= _lines.size()) for (const auto & [key, line] : _sparseLines) writeDataLine(line.tapeOffset);
+      }
+      output.Flush();
+   }
+
+   bool IfcLoader::saveLinesParallel(const std::function<void(char *, size_t)> &outputData, const bool orderLinesByExpressID, const size_t threads) const
+   {
+      // ordered output is split by tape offset, unordered output by expressID
+      const size_t total = orderLinesByExpressID ? _tokenStream->GetTotalSize() : _lines.size();
+      const size_t rangeSize = orderLinesByExpressID ? SAVE_TAPE_RANGE_SIZE : SAVE_LINE_RANGE_SIZE;
+      if (total < 2 * rangeSize || !_tokenStream->LoadAll()) return false;
+      const size_t rangeCount = std::max(threads, total / rangeSize);
+      std::vector<size_t> bounds(rangeCount + 1);
+      for (size_t i = 0; i <= rangeCount; i++) bounds[i] = total * i / rangeCount;
+      if (orderLinesByExpressID)
+      {
+        // a range has to start on a line, so move every bound forward to the first current line at or after it
+        std::vector<size_t> lineBounds(rangeCount + 1, total);
+        lineBounds[0] = 0;
+        auto place = [&](const IfcLine &line)
+        {
+          if (line.ifcType == 0) return;
+          const size_t range = std::upper_bound(bounds.begin() + 1, bounds.end() - 1, line.tapeOffset) - bounds.begin() - 1;
+          if (range > 0) lineBounds[range] = std::min(lineBounds[range], (size_t)line.tapeOffset);
+        };
+        for (size_t expressID = 0; expressID < _lines.size(); expressID++) place(_lines[expressID]);
+        for (const auto & [key, line] : _sparseLines) place(line);
+        for (size_t i = rangeCount - 1; i > 0; i--) lineBounds[i] = std::min(lineBounds[i], lineBounds[i + 1]);
+        bounds.swap(lineBounds);
+      }
+
+      // format a batch of ranges concurrently, each into its own buffer, then hand them over in order
+      std::vector<std::vector<char>> buffers(threads);
+      for (size_t first = 0; first < rangeCount; first += threads)
+      {
+        const size_t count = std::min(threads, rangeCount - first);
+        utility::ParallelFor(count, threads, [&](const size_t i)
+        {
+          std::vector<char> &buffer = buffers[i];
+          buffer.clear();
+          std::unique_ptr<IfcTokenStream> view(_tokenStream->CreateReadView());
+          saveLines(*view, [&](char *data, size_t size) { buffer.insert(buffer.end(), data, data + size); }, orderLinesByExpressID, bounds[first + i], bounds[first + i + 1]);
+        });
+        for (size_t i = 0; i < count; i++) 
+        {
+          if (!buffers[i].empty()) outputData(buffers[i].data(), buffers[i].size());
+        }
+      }
+      return true;
    }
    
    void IfcLoader::SaveFile(std::ostream &outputData, bool orderLinesByExpressID) const
@@ -220,16 +690,172 @@ namespace webifc::parsing {
 		 },orderLinesByExpressID);
    }
       
+   void IfcLoader::SaveTape(const std::function<void(char *, size_t)> &outputData) const
+   {
+      std::vector<uint32_t> lines;
+      lines.reserve(_lines.size() * 2);
+      for (size_t expressID = 0; expressID < _lines.size(); expressID++) 
+      {
+        lines.push_back(_lines[expressID].ifcType);
+        lines.push_back(_lines[expressID].tapeOffset);
+      }
+      std::vector<uint32_t> sparseLines;
+      for (const auto &[expressID, line] : _sparseLines) sparseLines.insert(sparseLines.end(), {expressID, line.ifcType, line.tapeOffset});
+      std::vector<uint32_t> headerLines;
+      for (const auto &line : _headerLines) headerLines.insert(headerLines.end(), {line.ifcType, line.tapeOffset});
+      std::vector<uint32_t> typeRanges;
+      for (const auto &[type, range] : _typeRanges) typeRanges.insert(typeRanges.end(), {type, range.first, range.second});
+      std::vector<uint32_t> addedTypes;
+      for (const auto &[type, expressIDs] : _addedTypeExpressIDs) 
+      {
+        addedTypes.insert(addedTypes.end(), {type, (uint32_t)expressIDs.size()});
+        addedTypes.insert(addedTypes.end(), expressIDs.begin(), expressIDs.end());
+      }
+
+      outputData((char *)TAPE_MAGIC, sizeof(TAPE_MAGIC));
+      utility::WriteValue<uint32_t>(outputData, TAPE_VERSION);
+      utility::WriteValue<uint32_t>(outputData, _binaryNumbers ? TAPE_FLAG_BINARY_NUMBERS : 0);
+      utility::WriteValue<uint64_t>(outputData, _tapeSource.size);
+      utility::WriteValue<uint64_t>(outputData, _tapeSource.hash);
+      utility::WriteValue<uint32_t>(outputData, _maxExpressId);
+      utility::WriteValue<uint32_t>(outputData, _lineCount);
+      utility::WriteValues(outputData, lines);
+      utility::WriteValues(outputData, sparseLines);
+      utility::WriteValues(outputData, headerLines);
+      utility::WriteValues(outputData, typeRanges);
+      utility::WriteValues(outputData, *_typeExpressIDs);
+      utility::WriteValues(outputData, addedTypes);
+      utility::WriteValues(outputData, _tokenStream->GetChunkSizes());
+      _tokenStream->WriteTape(outputData);
+   }
+
+   uint64_t IfcLoader::GetTapeHash() const
+   {
+      utility::Fnv1a hash;
+      hash.Add(_binaryNumbers);
+      _tokenStream->WriteTape([&](char *data, size_t size) { hash.Add(data, size); });
+      return hash.Get();
+   }
+
+   void IfcLoader::SaveTape(std::ostream &outputData) const
+   {
+     SaveTape([&](char* src, size_t srcSize) {
+          outputData.write(src,srcSize);
+		 });
+   }
+
+   IfcLoader::TapeSource IfcLoader::GetTapeSource(const uint8_t *data, size_t size)
+   {
+      utility::Fnv1a hash;
+      hash.Add(data, size);
+      return {size, hash.Get()};
+   }
+
+   std::optional<IfcLoader::TapeSource> IfcLoader::GetTapeSource(const std::string &path)
+   {
+      IfcMappedFile mappedFile;
+      if (!mappedFile.Open(path)) return std::nullopt;
+      return GetTapeSource(reinterpret_cast<const uint8_t *>(mappedFile.GetData()), mappedFile.GetSize());
+   }
+
+   IfcLoader::TapeSource IfcLoader::GetLoadedTapeSource() const
+   {
+      return _tapeSource;
+   }
+
+   bool IfcLoader::IsEdited() const
+   {
+      return _tapeSource.size == EDITED_TAPE_SOURCE_SIZE;
+   }
+
+   bool IfcLoader::LoadTape(const std::string &path, const TapeSource &source)
+   {
+      // the snapshot stays mapped, token chunks are copied out of it when they are first read
+      auto mappedFile = std::make_shared<IfcMappedFile>();
+      if (!mappedFile->Open(path)) return false;
+      utility::BinaryReader reader{mappedFile->GetData(), mappedFile->GetSize()};
+      if (reader.size < sizeof(TAPE_MAGIC) || std::memcmp(reader.data, TAPE_MAGIC, sizeof(TAPE_MAGIC)) != 0)
+      {
+        spdlog::error("[LoadTape()] {} is not a tape snapshot", path);
+        return false;
+      }
+      reader.offset = sizeof(TAPE_MAGIC);
+      const uint32_t version = reader.Read<uint32_t>();
+      // older snapshots do not say what they were saved from, so they cannot be checked against the source
+      if (version != TAPE_VERSION)
+      {
+        spdlog::error("[LoadTape()] unsupported tape snapshot version {}", version);
+        return false;
+      }
+      const uint32_t flags = reader.Read<uint32_t>();
+      TapeSource savedSource;
+      savedSource.size = reader.Read<uint64_t>();
+      savedSource.hash = reader.Read<uint64_t>();
+      if (reader.valid && savedSource.size == EDITED_TAPE_SOURCE_SIZE)
+      {
+        spdlog::info("[LoadTape()] {} was saved after lines were written or removed", path);
+        return false;
+      }
+      if (reader.valid && savedSource != source)
+      {
+        spdlog::info("[LoadTape()] {} was saved from another file", path);
+        return false;
+      }
+      const uint32_t maxExpressId = reader.Read<uint32_t>();
+      const uint32_t lineCount = reader.Read<uint32_t>();
+      const auto lines = reader.ReadValues<uint32_t>();
+      const auto sparseLines = reader.ReadValues<uint32_t>();
+      const auto headerLines = reader.ReadValues<uint32_t>();
+      const auto typeRanges = reader.ReadValues<uint32_t>();
+      auto typeExpressIDs = reader.ReadValues<uint32_t>();
+      const auto addedTypes = reader.ReadValues<uint32_t>();
+      const auto chunkSizes = reader.ReadValues<uint64_t>();
+      uint64_t tapeSize = 0;
+      for (const uint64_t size : chunkSizes) tapeSize += size;
+      if (!reader.valid || tapeSize > reader.size - reader.offset)
+      {
+        spdlog::error("[LoadTape()] truncated tape snapshot {}", path);
+        return false;
+      }
+
+      _binaryNumbers = (flags & TAPE_FLAG_BINARY_NUMBERS) != 0;
+      _tapeSource = savedSource;
+      _maxExpressId = maxExpressId;
+      _lineCount = lineCount;
+      _lines.resize(lines.size() / 2, {0, 0});
+      for (size_t i = 0; i < _lines.size(); i++) _lines.Mutable(i) = {lines[i * 2], lines[i * 2 + 1]};
+      for (size_t i = 0; i + 2 < sparseLines.size(); i += 3) _sparseLines[sparseLines[i]] = {sparseLines[i + 1], sparseLines[i + 2]};
+      for (size_t i = 0; i + 1 < headerLines.size(); i += 2) _headerLines.push_back({headerLines[i], headerLines[i + 1]});
+      for (size_t i = 0; i + 2 < typeRanges.size(); i += 3) _typeRanges[typeRanges[i]] = {typeRanges[i + 1], typeRanges[i + 2]};
+      _typeExpressIDs = std::make_shared<const std::vector<uint32_t>>(std::move(typeExpressIDs));
+      for (size_t i = 0; i + 1 < addedTypes.size();)
+      {
+        const uint32_t type = addedTypes[i];
+        const uint32_t count = addedTypes[i + 1];
+        i += 2;
+        if (i + count > addedTypes.size()) break;
+        _addedTypeExpressIDs[type].assign(addedTypes.begin() + i, addedTypes.begin() + i + count);
+        i += count;
+      }
+      _mappedFile = mappedFile;
+      _tokenStream->SetTapeSource((const uint8_t *)reader.data + reader.offset, chunkSizes);
+      clearInverseIndex();
+      clearGlobalIdIndex();
+      _relationshipIndex.reset();
+      return true;
+   }
+
    bool IfcLoader::IsAtEnd() const
    {
-     return _tokenStream->IsAtEnd();
+     return stream()->IsAtEnd();
    }
   
    void IfcLoader::ParseLines() 
    {
-  			uint32_t currentIfcType = 0;
-  			uint32_t currentExpressID = 0;
-  			uint32_t currentTapeOffset = 0;
+        WEBIFC_TRACE_SCOPE("ParseLines");
+        // resumes where the previous call stopped, a line may be split over two calls
+        ParseState &state = _parseState;
+        _tokenStream->MoveTo(state.readOffset);
   			while (!_tokenStream->IsAtEnd())
   			{
           IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
@@ -237,25 +863,22 @@ namespace webifc::parsing {
   				{
   				case IfcTokenType::LINE_END:
   				{
-            if (currentIfcType !=0)
+            if (state.ifcType !=0)
   					{
-  						IfcLine* l = new IfcLine();
-  						l->ifcType = currentIfcType;
-  						l->tapeOffset = currentTapeOffset;
-  						if(currentIfcType == webifc::schema::FILE_DESCRIPTION || currentIfcType == webifc::schema::FILE_NAME || currentIfcType == webifc::schema::FILE_SCHEMA )
+  						if(state.ifcType == webifc::schema::FILE_DESCRIPTION || state.ifcType == webifc::schema::FILE_NAME || state.ifcType == webifc::schema::FILE_SCHEMA )
               {
-                _headerLines.push_back(l);
+                _headerLines.push_back({state.ifcType, state.tapeOffset});
               }
-              else if (currentExpressID != 0)
+              else if (state.expressID != 0)
               {
-                _ifcTypeToExpressID[currentIfcType].push_back(currentExpressID);
-                _maxExpressId = std::max(_maxExpressId, currentExpressID);
-                _lines[currentExpressID]=l;
-                currentExpressID = 0;
+                state.typedLines.emplace_back(state.ifcType, state.expressID);
+                _maxExpressId = std::max(_maxExpressId, state.expressID);
+                insertLine(state.expressID, state.ifcType, state.tapeOffset);
+                state.expressID = 0;
               }
-              currentIfcType = 0;
+              state.ifcType = 0;
   					}
-  					currentTapeOffset = _tokenStream->GetReadOffset();
+  					state.tapeOffset = _tokenStream->GetReadOffset();
   					break;
   				}
   				case IfcTokenType::UNKNOWN:
@@ -275,19 +898,181 @@ namespace webifc::parsing {
   				case IfcTokenType::LABEL:
   				{
   					std::string_view s = _tokenStream->ReadString();
-  					if (currentIfcType == 0) currentIfcType = _schemaManager.IfcTypeToTypeCode(s);
+  					if (state.ifcType == 0) state.ifcType = _schemaManager.IfcTypeToTypeCode(s);
   					break;
   				}
   				case IfcTokenType::REF:
   				{
   					uint32_t ref = _tokenStream->Read<uint32_t>();
-  					if (currentExpressID == 0) currentExpressID = ref;
+  					if (state.expressID == 0) state.expressID = ref;
   					break;
   				}
   				default:
   					break;
   				}
   			}
+        state.readOffset = _tokenStream->GetReadOffset();
+        // the inverse index only covers the lines parsed before it was built
+        if (_inverseIndexed) clearInverseIndex();
+        if (_globalIdsIndexed) clearGlobalIdIndex();
+        _relationshipIndex.reset();
+   }
+
+   void IfcLoader::SetEntityFilter(const std::vector<uint32_t> &includes, const std::vector<uint32_t> &excludes)
+   {
+      _includeTypes = std::unordered_set<uint32_t>(includes.begin(), includes.end());
+      _excludeTypes = std::unordered_set<uint32_t>(excludes.begin(), excludes.end());
+   }
+
+   void IfcLoader::applyEntityFilter(std::vector<std::pair<uint32_t, uint32_t>> &typedLines)
+   {
+      if (_includeTypes.empty() && _excludeTypes.empty()) return;
+      auto admitted = [&](const uint32_t type) { return _excludeTypes.count(type) == 0; };
+
+      // the included lines and then everything they reach
+      std::vector<bool> kept(_lines.size(), false);
+      std::unordered_set<uint32_t> keptSparse;
+      std::vector<uint32_t> pending;
+      auto keep = [&](const uint32_t expressID)
+      {
+        if (expressID < kept.size())
+        {
+          if (kept[expressID]) return;
+          kept[expressID] = true;
+        }
+        else if (!keptSparse.insert(expressID).second) return;
+        pending.push_back(expressID);
+      };
+      for (const auto &[type, expressID] : typedLines)
+      {
+        if (admitted(type) && (_includeTypes.empty() || _includeTypes.count(type) != 0)) keep(expressID);
+      }
+      while (!pending.empty())
+      {
+        const IfcLine *line = findLine(pending.back());
+        pending.pop_back();
+        _tokenStream->MoveTo(line->tapeOffset);
+        bool first = true;
+        while (!_tokenStream->IsAtEnd())
+        {
+          const IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
+          if (t == IfcTokenType::LINE_END) break;
+          if (t != IfcTokenType::REF)
+          {
+            skipToken(*_tokenStream, t);
+            continue;
+          }
+          const uint32_t ref = _tokenStream->Read<uint32_t>();
+          // the first reference is the line's own id
+          if (first)
+          {
+            first = false;
+            continue;
+          }
+          const IfcLine *target = findLine(ref);
+          if (target != nullptr && admitted(target->ifcType)) keep(ref);
+        }
+      }
+
+      auto isKept = [&](const uint32_t expressID) { return expressID < kept.size() ? kept[expressID] : keptSparse.count(expressID) != 0; };
+      std::erase_if(typedLines, [&](const std::pair<uint32_t, uint32_t> &typedLine) { return !isKept(typedLine.second); });
+      std::vector<uint32_t> offsets;
+      offsets.reserve(typedLines.size() + _headerLines.size());
+      for (auto &line : _headerLines) offsets.push_back(line.tapeOffset);
+      for (uint32_t expressID = 0; expressID < _lines.size(); expressID++)
+      {
+        if (_lines[expressID].ifcType == 0) continue;
+        if (kept[expressID]) offsets.push_back(_lines[expressID].tapeOffset);
+        else _lines.Mutable(expressID) = {0, 0};
+      }
+      std::erase_if(_sparseLines, [&](const auto &entry) { return keptSparse.count(entry.first) == 0; });
+      for (const auto &[expressID, line] : _sparseLines) offsets.push_back(line.tapeOffset);
+      _lineCount = typedLines.size();
+      std::sort(offsets.begin(), offsets.end());
+      _tokenStream->ReleaseChunks(offsets);
+   }
+
+   void IfcLoader::finishParse()
+   {
+      ParseLines();
+      applyEntityFilter(_parseState.typedLines);
+      buildTypeIndex(_parseState.typedLines);
+      _parseState.typedLines.clear();
+      _parseState.typedLines.shrink_to_fit();
+      _loading = false;
+   }
+
+   void IfcLoader::loadTokens(const std::function<void()> &setTokenSource)
+   {
+      _loading = true;
+      const uint64_t start = utility::NowNanoseconds();
+      uint64_t parseTime = 0;
+      _tokenStream->SetTokenizedCallback([&](const size_t fileOffset)
+      {
+        _loadedFileOffset = fileOffset;
+        if (!_loadProgress) return;
+        // index lines as soon as they are tokenized, so they can be queried from the progress callback
+        const uint64_t parseStart = utility::NowNanoseconds();
+        ParseLines();
+        parseTime += utility::NowNanoseconds() - parseStart;
+        _loadProgress(fileOffset);
+      });
+      setTokenSource();
+      _tokenStream->SetTokenizedCallback(nullptr);
+      const uint64_t parseStart = utility::NowNanoseconds();
+      finishParse();
+      const uint64_t end = utility::NowNanoseconds();
+      parseTime += end - parseStart;
+      _loadTimes.tokenize = (end - start - parseTime) / 1e9;
+      _loadTimes.parse = parseTime / 1e9;
+      if (_loadProgress) _loadProgress(_loadedFileOffset);
+   }
+
+   const IfcLoader::IfcLine * IfcLoader::findLine(const uint32_t expressID) const
+   {
+      if (expressID < _lines.size() && _lines[expressID].ifcType != 0) return &_lines[expressID];
+      if (_sparseLines.empty()) return nullptr;
+      const auto lineIt = _sparseLines.find(expressID);
+      if (lineIt == _sparseLines.end()) return nullptr;
+      return &lineIt->second;
+   }
+
+   IfcLoader::IfcLine * IfcLoader::findLine(const uint32_t expressID)
+   {
+      // the page of the line is no longer shared with clones once it is written to
+      if (expressID < _lines.size() && _lines[expressID].ifcType != 0) return &_lines.Mutable(expressID);
+      return const_cast<IfcLine *>(std::as_const(*this).findLine(expressID));
+   }
+
+   void IfcLoader::insertLine(const uint32_t expressID, const uint32_t type, const uint32_t tapeOffset)
+   {
+      // grow the dense table unless the id is far beyond what the number of lines justifies
+      if (expressID >= _lines.size() && expressID <= 2 * _lineCount + 1024) _lines.resize(expressID + 1, {0, 0});
+      if (expressID < _lines.size()) _lines.Mutable(expressID) = {type, tapeOffset};
+      else _sparseLines[expressID] = {type, tapeOffset};
+      _lineCount++;
+   }
+
+   void IfcLoader::buildTypeIndex(const std::vector<std::pair<uint32_t, uint32_t>> &typedLines)
+   {
+      // counting sort by type, stable so that every type keeps its ids in file order
+      std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> typeRanges;
+      for (const auto &[type, expressID] : typedLines) typeRanges[type].second++;
+      uint32_t offset = 0;
+      for (auto &[type, range] : typeRanges)
+      {
+        range.first = offset;
+        offset += range.second;
+        range.second = 0;
+      }
+      std::vector<uint32_t> typeExpressIDs(typedLines.size());
+      for (const auto &[type, expressID] : typedLines)
+      {
+        auto &range = typeRanges[type];
+        typeExpressIDs[range.first + range.second++] = expressID;
+      }
+      _typeRanges = std::move(typeRanges);
+      _typeExpressIDs = std::make_shared<const std::vector<uint32_t>>(std::move(typeExpressIDs));
    }
    
    uint32_t IfcLoader::GetMaxExpressId() const
@@ -297,7 +1082,7 @@ namespace webifc::parsing {
    
    bool IfcLoader::IsValidExpressID(const uint32_t expressID) const
    {  
-   	 if (expressID == 0 || expressID > _maxExpressId || !_lines.contains(expressID)) return false;
+   	 if (expressID == 0 || expressID > _maxExpressId || findLine(expressID) == nullptr) return false;
      else return true;
    }
    
@@ -308,42 +1093,37 @@ namespace webifc::parsing {
         return 0;
       }
 
-      const auto lineIt = _lines.find(expressID);
-      if (lineIt == _lines.end()) {
+      const IfcLine * line = findLine(expressID);
+      if (line == nullptr) {
           spdlog::error("[GetLineType()] Attempt to Access Invalid ExpressID {}", expressID);
           return 0;
       }
 
-      return lineIt->second->ifcType;
+      return line->ifcType;
    }
    
    IfcLoader::~IfcLoader()
    { 
       delete _tokenStream;
-      for (const auto & [key, value] : _lines) delete value;
-      for (size_t i=0; i < _headerLines.size();i++) delete _headerLines[i];
-      _lines.clear();
-      _headerLines.clear();
    }
    
    void IfcLoader::MoveToLineArgument(const uint32_t expressID, const uint32_t argumentIndex) const
    {
-       const auto lineIt = _lines.find(expressID);
-       if (lineIt == _lines.end()) return;
-       _tokenStream->MoveTo(lineIt->second->tapeOffset);
-       ArgumentOffset(argumentIndex);
+       const IfcLine * line = findLine(expressID);
+       if (line == nullptr) return;
+       moveToArgument(expressID, *line, argumentIndex);
    }
    
    void IfcLoader::MoveToHeaderLineArgument(const uint32_t lineID, const uint32_t argumentIndex) const
    { 
-     _tokenStream->MoveTo(_headerLines[lineID]->tapeOffset);
+     stream()->MoveTo(_headerLines[lineID].tapeOffset);
    	 ArgumentOffset(argumentIndex);	
    }
    
    std::string_view IfcLoader::GetStringArgument() const
    { 
-   	 _tokenStream->Read<char>(); // string type
-     return _tokenStream->ReadString();
+   	 const IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>()); // string type
+     return stream()->ReadString(isBinaryNumber(t) ? sizeof(double) : 0);
    }
 
    std::string IfcLoader::GetDecodedStringArgument() const
@@ -352,6 +1132,11 @@ namespace webifc::parsing {
       return p21decode(str);
    }
 
+   std::string_view IfcLoader::GetDecodedStringArgument(std::string &buffer) const
+   { 
+      return p21decode(GetStringArgument(), buffer);
+   }
+
    void IfcLoader::PushDouble(double input)
    {             
       std::string numberString = std::format("{}", input);
@@ -359,7 +1144,12 @@ namespace webifc::parsing {
       if (eLoc != std::string::npos) numberString[eLoc]='E';
       else if (std::floor(input) == input) numberString+='.';
       uint16_t length = numberString.size();
-      Push<uint16_t>((uint16_t)length);
+      if (_binaryNumbers)
+      {
+        Push<uint16_t>((uint16_t)(sizeof(double) + length));
+        Push<double>(input);
+      }
+      else Push<uint16_t>((uint16_t)length);
       Push((void*)numberString.c_str(), numberString.size());        
    }
 
@@ -367,13 +1157,34 @@ namespace webifc::parsing {
    {
     std::string numberString = std::to_string(input);
     uint16_t length = numberString.size();
-    Push<uint16_t>((uint16_t)length);
+    if (_binaryNumbers)
+    {
+      Push<uint16_t>((uint16_t)(sizeof(int64_t) + length));
+      Push<int64_t>(input);
+    }
+    else Push<uint16_t>((uint16_t)length);
     Push((void*)numberString.c_str(), numberString.size());             
    } 
+
+   bool IfcLoader::isBinaryNumber(const IfcTokenType t) const
+   {
+      return _binaryNumbers && (t == IfcTokenType::REAL || t == IfcTokenType::INTEGER);
+   }
+
+   double IfcLoader::readBinaryNumber(const IfcTokenType t) const
+   {
+      // the value sits in front of the text
+      const uint16_t length = stream()->Read<uint16_t>();
+      const double value = t == IfcTokenType::REAL ? stream()->Read<double>() : (double)stream()->Read<int64_t>();
+      stream()->Forward(length - sizeof(double));
+      return value;
+   }
    
    double IfcLoader::GetDoubleArgument() const
    { 
-      std::string_view str = GetStringArgument();
+      const IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+      if (isBinaryNumber(t)) return readBinaryNumber(t);
+      std::string_view str = stream()->ReadString();
       double number_value;
       fast_float::from_chars(str.data(), str.data() + str.size(), number_value);
       return number_value;
@@ -386,86 +1197,315 @@ namespace webifc::parsing {
 
    long IfcLoader::GetIntArgument() const
    {
-       std::string_view str = GetStringArgument();
+       const IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+       if (t == IfcTokenType::INTEGER && _binaryNumbers)
+       {
+         const uint16_t length = stream()->Read<uint16_t>();
+         const int64_t value = stream()->Read<int64_t>();
+         stream()->Forward(length - sizeof(int64_t));
+         return value;
+       }
+       if (isBinaryNumber(t)) return (long)readBinaryNumber(t);
+       std::string_view str = stream()->ReadString();
        return std::stoll(std::string(str));
    }
 
   long IfcLoader::GetIntArgument(const uint32_t tapeOffset) const
   {
-    _tokenStream->MoveTo(tapeOffset);
+    stream()->MoveTo(tapeOffset);
     return GetIntArgument();
   }
 
   uint32_t IfcLoader::GetCurrentLineExpressID() const
   {
-      if (_lines.size()==0) return 0;
+      // the line that starts closest before the current read position
       uint32_t prevLine = 0;
-      uint32_t pos = _tokenStream->GetReadOffset();
-      for (const auto & [key, value] : _lines) {
-         if (value->tapeOffset > pos) break;
+      uint32_t prevOffset = 0;
+      uint32_t pos = stream()->GetReadOffset();
+      for (uint32_t expressID = 0; expressID < _lines.size(); expressID++) {
+         const IfcLine &line = _lines[expressID];
+         if (line.ifcType == 0 || line.tapeOffset > pos || line.tapeOffset < prevOffset) continue;
+         prevLine = expressID;
+         prevOffset = line.tapeOffset;
+      }
+      for (const auto & [key, line] : _sparseLines) {
+         if (line.tapeOffset > pos || line.tapeOffset < prevOffset) continue;
          prevLine = key;
+         prevOffset = line.tapeOffset;
       }
       return prevLine;
   }
    
    uint32_t IfcLoader::GetRefArgument() const
    { 
-      if (_tokenStream->Read<char>() != IfcTokenType::REF)
+      if (stream()->Read<char>() != IfcTokenType::REF)
      	{
      		spdlog::error("[GetRefArgument()] unexpected token type, expected REF {}", GetCurrentLineExpressID());
      		return 0;
      	}
-     	return _tokenStream->Read<uint32_t>();
+     	return stream()->Read<uint32_t>();
    }
    
   uint32_t IfcLoader::GetRefArgument(const uint32_t tapeOffset) const
 	{
-			_tokenStream->MoveTo(tapeOffset);
+			stream()->MoveTo(tapeOffset);
 			return GetRefArgument();
 	}
     
   double IfcLoader::GetDoubleArgument(const uint32_t tapeOffset) const
 	{
-		_tokenStream->MoveTo(tapeOffset);
+		stream()->MoveTo(tapeOffset);
 		return GetDoubleArgument();
 	}
 
   void IfcLoader::RemoveLine(const uint32_t expressID)
   {
-      _lines.erase(expressID);
+      IfcLine * line = findLine(expressID);
+      if (line == nullptr) return;
+      if (_inverseIndexed) removeInverseReferences(expressID, *line);
+      if (_globalIdsIndexed) removeGlobalId(expressID, *line);
+      dropRelationshipIndex(expressID, line->ifcType);
+      dropArgumentOffsets(*line);
+      if (expressID < _lines.size() && _lines[expressID].ifcType != 0) _lines.Mutable(expressID) = {0, 0};
+      else _sparseLines.erase(expressID);
+      _lineCount--;
+      _tapeSource = {EDITED_TAPE_SOURCE_SIZE, 0};
   }
   
   void IfcLoader::UpdateLineTape(const uint32_t expressID, const uint32_t type, const uint32_t start)
   {
-      const auto lineIt = _lines.find(expressID);
-      if (lineIt == _lines.end()) {
-        // create line object
-  		IfcLine * line = new IfcLine();
-  		// fill line data
-  		line->ifcType = type;
-        line->tapeOffset = start;
-        //place in vector
-        _lines[expressID]=line;
-  		_ifcTypeToExpressID[type].push_back(expressID);
+      IfcLine * line = findLine(expressID);
+      if (line == nullptr) {
+        insertLine(expressID, type, start);
+  		_addedTypeExpressIDs[type].push_back(expressID);
         _maxExpressId = std::max(expressID, _maxExpressId);
       }
       else {
-          _lines[expressID]->tapeOffset = start;
+          if (_inverseIndexed) removeInverseReferences(expressID, *line);
+          if (_globalIdsIndexed) removeGlobalId(expressID, *line);
+          dropRelationshipIndex(expressID, line->ifcType);
+          dropArgumentOffsets(*line);
+          line->tapeOffset = start;
+      }
+      if (_inverseIndexed) addInverseReferences(expressID, *findLine(expressID));
+      if (_globalIdsIndexed) addGlobalId(expressID, *findLine(expressID));
+      dropRelationshipIndex(expressID, type);
+      _tapeSource = {EDITED_TAPE_SOURCE_SIZE, 0};
+  }
+
+  void IfcLoader::dropArgumentOffsets(IfcLine &line)
+  {
+      if (line.argumentOffsets == 0) return;
+      // the entry is its argument count, an offset per argument and the offset past the closing bracket
+      const size_t start = line.argumentOffsets - 1;
+      const size_t end = start + _argumentOffsets[start] + 2;
+      line.argumentOffsets = 0;
+      if (end == _argumentOffsets.size())
+      {
+        // the line indexed last, as when a line is written and read again in turn
+        _argumentOffsets.resize(start, 0);
+        return;
+      }
+      _staleArgumentOffsets += end - start;
+      if (_staleArgumentOffsets < MIN_STALE_ARGUMENT_OFFSETS || 2 * _staleArgumentOffsets < _argumentOffsets.size()) return;
+      // lines index their arguments again when they are read
+      for (uint32_t expressID = 0; expressID < _lines.size(); expressID++)
+      {
+        if (_lines[expressID].argumentOffsets != 0) _lines.Mutable(expressID).argumentOffsets = 0;
+      }
+      for (auto &[expressID, sparseLine] : _sparseLines) sparseLine.argumentOffsets = 0;
+      _argumentOffsets.clear();
+      _staleArgumentOffsets = 0;
+  }
+
+  bool IfcLoader::AppendLines(const uint8_t *data, const size_t size)
+  {
+      utility::BinaryReader reader{reinterpret_cast<const char *>(data), size};
+      const uint32_t count = reader.Read<uint32_t>();
+      if (!reader.valid || count > (size - reader.offset) / sizeof(uint32_t))
+      {
+        spdlog::error("[AppendLines()] malformed line buffer");
+        return false;
+      }
+
+      // the tape of all lines is built aside first, so a malformed line leaves the model untouched
+      std::vector<char> tape;
+      std::vector<std::array<uint32_t, 3>> lines;
+      lines.reserve(count);
+      std::unordered_map<uint32_t, std::string> labels;
+      const uint64_t tapeStart = GetTotalSize();
+      auto append = [&](const void *value, const size_t length)
+      {
+        tape.insert(tape.end(), static_cast<const char *>(value), static_cast<const char *>(value) + length);
+      };
+      auto appendString = [&](const std::string_view value)
+      {
+        const uint16_t length = static_cast<uint16_t>(value.size());
+        append(&length, sizeof(uint16_t));
+        append(value.data(), value.size());
+      };
+      auto appendLabel = [&](const uint32_t type)
+      {
+        auto it = labels.find(type);
+        if (it == labels.end())
+        {
+          std::string name = _schemaManager.IfcTypeCodeToType(type);
+          std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+          it = labels.emplace(type, std::move(name)).first;
+        }
+        const char token = IfcTokenType::LABEL;
+        append(&token, 1);
+        appendString(it->second);
+      };
+      // a uint32 length and the bytes, false when they do not fit the buffer or a token
+      auto readString = [&](std::string_view &value)
+      {
+        const uint32_t length = reader.Read<uint32_t>();
+        if (!reader.valid || length > size - reader.offset || length > UINT16_MAX - sizeof(double)) return false;
+        value = std::string_view(reader.data + reader.offset, length);
+        reader.offset += length;
+        return true;
+      };
+
+      for (uint32_t i = 0; i < count; i++)
+      {
+        reader.offset = sizeof(uint32_t) * (i + 1);
+        reader.offset = reader.Read<uint32_t>();
+        const uint32_t expressID = reader.Read<uint32_t>();
+        const uint32_t type = reader.Read<uint32_t>();
+        if (!reader.valid) break;
+        if (type == 0) continue;
+        if (expressID == 0) 
+        {
+          reader.valid = false;
+          break;
+        }
+
+        lines.push_back({expressID, type, static_cast<uint32_t>(tapeStart + tape.size())});
+        const char ref = IfcTokenType::REF;
+        append(&ref, 1);
+        append(&expressID, sizeof(uint32_t));
+        appendLabel(type);
+        const char setBegin = IfcTokenType::SET_BEGIN;
+        append(&setBegin, 1);
+
+        bool end = false;
+        while (!end && reader.valid)
+        {
+          const char t = reader.Read<char>();
+          if (!reader.valid) break;
+          switch (t)
+          {
+            case IfcTokenType::LINE_END:
+            {
+              const char tokens[] = {IfcTokenType::SET_END, IfcTokenType::LINE_END};
+              append(tokens, sizeof(tokens));
+              end = true;
+              break;
+            }
+            case IfcTokenType::UNKNOWN:
+            case IfcTokenType::EMPTY:
+            case IfcTokenType::SET_BEGIN:
+            case IfcTokenType::SET_END:
+              append(&t, 1);
+              break;
+            case IfcTokenType::LABEL:
+            {
+              const uint32_t labelType = reader.Read<uint32_t>();
+              if (reader.valid) appendLabel(labelType);
+              break;
+            }
+            case IfcTokenType::STRING:
+            case IfcTokenType::ENUM:
+            {
+              std::string_view value;
+              if (!readString(value)) 
+              {
+                reader.valid = false;
+                break;
+              }
+              append(&t, 1);
+              appendString(value);
+              break;
+            }
+            case IfcTokenType::REAL:
+            {
+              std::string_view value;
+              double number = 0;
+              if (!readString(value) || fast_float::from_chars(value.data(), value.data() + value.size(), number).ec != std::errc())
+              {
+                reader.valid = false;
+                break;
+              }
+              append(&t, 1);
+              if (_binaryNumbers)
+              {
+                // the value in front of the text, as PushDouble writes it
+                const uint16_t length = static_cast<uint16_t>(sizeof(double) + value.size());
+                append(&length, sizeof(uint16_t));
+                append(&number, sizeof(double));
+                append(value.data(), value.size());
+              }
+              else appendString(value);
+              break;
+            }
+            case IfcTokenType::INTEGER:
+            {
+              const int64_t number = static_cast<int64_t>(reader.Read<double>());
+              if (!reader.valid) break;
+              append(&t, 1);
+              const std::string text = std::to_string(number);
+              if (_binaryNumbers)
+              {
+                const uint16_t length = static_cast<uint16_t>(sizeof(int64_t) + text.size());
+                append(&length, sizeof(uint16_t));
+                append(&number, sizeof(int64_t));
+                append(text.data(), text.size());
+              }
+              else appendString(text);
+              break;
+            }
+            case IfcTokenType::REF:
+            {
+              const uint32_t value = reader.Read<uint32_t>();
+              if (!reader.valid) break;
+              append(&t, 1);
+              append(&value, sizeof(uint32_t));
+              break;
+            }
+            default:
+              reader.valid = false;
+              break;
+          }
+        }
+        if (!end) reader.valid = false;
+      }
+
+      if (!reader.valid)
+      {
+        spdlog::error("[AppendLines()] malformed line buffer");
+        return false;
       }
+      if (tape.empty()) return true;
+      Push(tape.data(), tape.size());
+
+      // the dense table grows once for the whole batch instead of with every line beyond its end
+      uint32_t maxExpressID = 0;
+      for (const auto &line : lines) maxExpressID = std::max(maxExpressID, line[0]);
+      if (maxExpressID >= _lines.size() && maxExpressID <= 2 * (_lineCount + lines.size()) + 1024) _lines.resize(maxExpressID + 1, {0, 0});
+      for (const auto &[expressID, type, start] : lines) UpdateLineTape(expressID, type, start);
+      return true;
   }
 
   void IfcLoader::AddHeaderLineTape(const uint32_t type, const uint32_t start)
   {
     
-      IfcLine *l = new IfcLine();
-      l->ifcType = type;
-      l->tapeOffset = start;
-      _headerLines.push_back(l);
+      _headerLines.push_back({type, start});
   }
   
   IfcTokenType IfcLoader::GetTokenType(uint32_t tapeOffset) const
   {
-    _tokenStream->MoveTo(tapeOffset);
+    stream()->MoveTo(tapeOffset);
     return GetTokenType();
   }
    
@@ -478,7 +1518,7 @@ namespace webifc::parsing {
      	}
      	else if (t == IfcTokenType::REF)
      	{
-     		return _tokenStream->Read<uint32_t>();
+     		return stream()->Read<uint32_t>();
      	}
      	else
      	{
@@ -489,7 +1529,7 @@ namespace webifc::parsing {
    
    IfcTokenType IfcLoader::GetTokenType() const
    { 
-     return static_cast<IfcTokenType>(_tokenStream->Read<char>());
+     return static_cast<IfcTokenType>(stream()->Read<char>());
    }
 
    void IfcLoader::Push(void *v, uint64_t size)
@@ -506,55 +1546,224 @@ namespace webifc::parsing {
    { 
      std::vector<uint32_t> tapeOffsets;
      tapeOffsets.reserve(4);
+     GetSetArgument(tapeOffsets);
+     return tapeOffsets;
+   }
 
-     _tokenStream->Read<char>(); // set begin
-     int depth = 1;
-     while (depth > 0)
+   template <typename Visit> void IfcLoader::visitTokens(const Visit &visit) const
+   {
+     std::vector<uint8_t> split;
+     while (!stream()->IsAtEnd())
      {
-         uint32_t offset = _tokenStream->GetReadOffset();
-         IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
-
-         switch (t) {
-         case IfcTokenType::SET_BEGIN:
-             depth++;
-             break;
-         case IfcTokenType::SET_END:
-             depth--;
-             break;
-         case IfcTokenType::REF:
-             tapeOffsets.push_back(offset);
-             _tokenStream->Read<uint32_t>();
-             break;
-         case IfcTokenType::STRING:
-         case IfcTokenType::INTEGER:
-         case IfcTokenType::REAL:
-         case IfcTokenType::LABEL:
-         case IfcTokenType::ENUM: {
-             tapeOffsets.push_back(offset);
-             uint16_t length = _tokenStream->Read<uint16_t>();
-             _tokenStream->Forward(length);
-             break;
-         }
-         default:
-             spdlog::error("[GetSetArgument[]) unexpected token", GetCurrentLineExpressID());
-             break;
+       const size_t base = stream()->GetReadOffset();
+       size_t available = 0;
+       const uint8_t *data = stream()->PinRange(available);
+       IfcTokenCursor cursor(data, available);
+       IfcToken token;
+       size_t tokenStart = 0;
+       while (cursor.Next(token))
+       {
+         const TokenVisit next = visit(token, static_cast<uint32_t>(base + tokenStart));
+         if (next != TokenVisit::Next)
+         {
+           stream()->Forward(next == TokenVisit::Stop ? cursor.Position() : tokenStart);
+           return;
          }
+         tokenStart = cursor.Position();
+       }
+       if (cursor.Position() > 0)
+       {
+         stream()->Forward(cursor.Position());
+         continue;
+       }
+
+       // pushed tokens may continue in the next chunk, the token is copied out through the stream
+       split.clear();
+       const IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+       split.push_back(t);
+       size_t payload = 0;
+       if (t == IfcTokenType::REF) payload = sizeof(uint32_t);
+       else if (t == IfcTokenType::STRING || t == IfcTokenType::LABEL || t == IfcTokenType::ENUM || t == IfcTokenType::REAL || t == IfcTokenType::INTEGER)
+       {
+         const uint16_t length = stream()->Read<uint16_t>();
+         split.resize(1 + sizeof(uint16_t));
+         std::memcpy(split.data() + 1, &length, sizeof(uint16_t));
+         payload = length;
+       }
+       for (size_t i = 0; i < payload; i++) split.push_back(stream()->Read<uint8_t>());
+       IfcTokenCursor splitCursor(split.data(), split.size());
+       if (!splitCursor.Next(token)) return;
+       const TokenVisit next = visit(token, static_cast<uint32_t>(base));
+       if (next == TokenVisit::StopBefore) stream()->MoveTo(base);
+       if (next != TokenVisit::Next) return;
      }
+   }
 
-     return tapeOffsets;
+   void IfcLoader::GetSetArgument(std::vector<uint32_t> &tapeOffsets) const
+   { 
+     tapeOffsets.clear();
+     stream()->Read<char>(); // set begin
+     int depth = 1;
+     visitTokens([&](const IfcToken &token, const uint32_t offset)
+     {
+       switch (token.type) {
+       case IfcTokenType::SET_BEGIN:
+           depth++;
+           break;
+       case IfcTokenType::SET_END:
+           if (--depth == 0) return TokenVisit::Stop;
+           break;
+       case IfcTokenType::REF:
+       case IfcTokenType::STRING:
+       case IfcTokenType::INTEGER:
+       case IfcTokenType::REAL:
+       case IfcTokenType::LABEL:
+       case IfcTokenType::ENUM:
+           tapeOffsets.push_back(offset);
+           break;
+       default:
+           spdlog::error("[GetSetArgument[]) unexpected token", GetCurrentLineExpressID());
+           break;
+       }
+       return TokenVisit::Next;
+     });
+   }
+
+   void IfcLoader::GetRefSetArgument(std::vector<uint32_t> &expressIDs) const
+   { 
+     expressIDs.clear();
+     stream()->Read<char>(); // set begin
+     int depth = 1;
+     visitTokens([&](const IfcToken &token, const uint32_t)
+     {
+       switch (token.type) {
+       case IfcTokenType::SET_BEGIN:
+           depth++;
+           break;
+       case IfcTokenType::SET_END:
+           if (--depth == 0) return TokenVisit::Stop;
+           break;
+       case IfcTokenType::REF:
+           expressIDs.push_back(token.ref);
+           break;
+       case IfcTokenType::STRING:
+       case IfcTokenType::INTEGER:
+       case IfcTokenType::REAL:
+       case IfcTokenType::LABEL:
+       case IfcTokenType::ENUM:
+           break;
+       default:
+           spdlog::error("[GetRefSetArgument[]) unexpected token", GetCurrentLineExpressID());
+           break;
+       }
+       return TokenVisit::Next;
+     });
    }
    
+   template <typename T> bool IfcLoader::readNumberSetList(std::vector<T> &values, const uint32_t width, const size_t threads) const
+   {
+     // the offset of the first inner set of every chunk, chunks are converted independently
+     constexpr size_t CHUNK_SETS = 4096;
+     const size_t start = stream()->GetReadOffset();
+     std::vector<size_t> chunkOffsets;
+     size_t sets = 0;
+     auto fail = [&]()
+     {
+       stream()->MoveTo(start);
+       return false;
+     };
+
+     if (GetTokenType() != IfcTokenType::SET_BEGIN) return fail();
+     while (true)
+     {
+       const size_t offset = stream()->GetReadOffset();
+       const IfcTokenType t = GetTokenType();
+       if (t == IfcTokenType::SET_END) break;
+       if (t != IfcTokenType::SET_BEGIN) return fail();
+       if (sets % CHUNK_SETS == 0) chunkOffsets.push_back(offset);
+       for (uint32_t i = 0; i < width; i++)
+       {
+         const IfcTokenType number = GetTokenType();
+         if (number != IfcTokenType::REAL && number != IfcTokenType::INTEGER) return fail();
+         stream()->Forward(stream()->Read<uint16_t>());
+       }
+       if (GetTokenType() != IfcTokenType::SET_END) return fail();
+       sets++;
+     }
+     const size_t end = stream()->GetReadOffset();
+
+     auto readNumber = [&]() -> T
+     {
+       if constexpr (std::is_floating_point_v<T>)
+       {
+         return GetDoubleArgument();
+       }
+       else
+       {
+         const IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+         if (t == IfcTokenType::INTEGER && _binaryNumbers)
+         {
+           const uint16_t length = stream()->Read<uint16_t>();
+           const int64_t value = stream()->Read<int64_t>();
+           stream()->Forward(length - sizeof(int64_t));
+           return static_cast<T>(value);
+         }
+         if (isBinaryNumber(t)) return static_cast<T>(readBinaryNumber(t));
+         std::string_view str = stream()->ReadString();
+         T value = 0;
+         std::from_chars(str.data(), str.data() + str.size(), value);
+         return value;
+       }
+     };
+     values.resize(sets * width);
+     auto convert = [&](const size_t chunk)
+     {
+       stream()->MoveTo(chunkOffsets[chunk]);
+       const size_t last = std::min(sets, (chunk + 1) * CHUNK_SETS);
+       for (size_t set = chunk * CHUNK_SETS; set < last; set++)
+       {
+         stream()->Read<char>(); // set begin
+         for (uint32_t i = 0; i < width; i++) values[set * width + i] = readNumber();
+         stream()->Read<char>(); // set end
+       }
+     };
+     if (threads > 1 && chunkOffsets.size() > 1 && PrepareConcurrentReads())
+     {
+       utility::ParallelFor(chunkOffsets.size(), threads, [&](const size_t chunk)
+       {
+         ReadScope scope(*this);
+         convert(chunk);
+       });
+     }
+     else
+     {
+       for (size_t chunk = 0; chunk < chunkOffsets.size(); chunk++) convert(chunk);
+     }
+     stream()->MoveTo(end);
+     return true;
+   }
+
+   bool IfcLoader::GetNumberSetListArgument(std::vector<double> &values, const uint32_t width, const size_t threads) const
+   {
+     return readNumberSetList(values, width, threads);
+   }
+
+   bool IfcLoader::GetNumberSetListArgument(std::vector<uint32_t> &values, const uint32_t width, const size_t threads) const
+   {
+     return readNumberSetList(values, width, threads);
+   }
+
    const std::vector<std::vector<uint32_t>> IfcLoader::GetSetListArgument() const
    { 
      std::vector<std::vector<uint32_t>> tapeOffsets;
-   	 _tokenStream->Read<char>(); // set begin
+   	 stream()->Read<char>(); // set begin
    	 int depth = 1;
    	 std::vector<uint32_t> tempSet;
 
      	while (true)
      	{
-     		uint32_t offset = _tokenStream->GetReadOffset();
-     		IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
+     		uint32_t offset = stream()->GetReadOffset();
+     		IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
 
      		if (t == IfcTokenType::SET_BEGIN)
      		{
@@ -576,12 +1785,12 @@ namespace webifc::parsing {
 
      			if (t == IfcTokenType::REF)
      			{
-     				_tokenStream->Read<uint32_t>();
+     				stream()->Read<uint32_t>();
      			}
      			else if (t == IfcTokenType::STRING || t == IfcTokenType::INTEGER || t == IfcTokenType::REAL || t == IfcTokenType::LABEL || t == IfcTokenType::ENUM)
      			{
-     				uint16_t length = _tokenStream->Read<uint16_t>();
-     				_tokenStream->Forward(length);
+     				uint16_t length = stream()->Read<uint16_t>();
+     				stream()->Forward(length);
      			}
      			else
      			{
@@ -602,76 +1811,394 @@ namespace webifc::parsing {
    {
    	uint32_t movedOver = 0;
    	uint32_t setDepth = 0;
-   	while (true)
+   	visitTokens([&](const IfcToken &token, const uint32_t)
    	{
-   		if (setDepth == 1)
-   		{
-   			movedOver++;
-
-   			if (movedOver-1 == argumentIndex)
-   			{
-   				return;
-   			}
-   		}
-
-   		IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
+   		if (setDepth == 1 && movedOver++ == argumentIndex) return TokenVisit::StopBefore;
 
-   		switch (t)
+   		switch (token.type)
    		{
    		case IfcTokenType::LINE_END:
-   		{
    			spdlog::error("[ArgumentOffset()] unexpected line end {}", GetCurrentLineExpressID());
    			break;
-   		}
-   		case IfcTokenType::UNKNOWN:
-   		case IfcTokenType::EMPTY:
-   			break;
    		case IfcTokenType::SET_BEGIN:
    			setDepth++;
    			break;
    		case IfcTokenType::SET_END:
    			setDepth--;
-   			if (setDepth == 0)
-   			{
-   				return;
-   			}
-   			break;
-   		case IfcTokenType::STRING:
-   		case IfcTokenType::ENUM:
-   		case IfcTokenType::LABEL:
-      case IfcTokenType::INTEGER:
-      case IfcTokenType::REAL:
-   		{
-   			uint16_t length = _tokenStream->Read<uint16_t>();
-   			_tokenStream->Forward(length);
-   			break;
-   		}
-   		case IfcTokenType::REF:
-   		{
-   			_tokenStream->Read<uint32_t>();
+   			if (setDepth == 0) return TokenVisit::Stop;
    			break;
-   		}
    		default:
    			break;
    		}
-   	}
+   		return TokenVisit::Next;
+   	});
+   }
+
+   void IfcLoader::moveToArgument(const uint32_t expressID, const IfcLine &line, const uint32_t argumentIndex) const
+   {
+      // reading the first arguments is cheap, lines are only indexed once a later argument is requested, the index is
+      // shared by all threads so inside a ReadScope lines it lacks are indexed by the scope
+      uint32_t argumentOffsets = line.argumentOffsets;
+      if (argumentOffsets == 0)
+      {
+        if (argumentIndex < 2)
+        {
+          stream()->MoveTo(line.tapeOffset);
+          ArgumentOffset(argumentIndex);
+          return;
+        }
+        if (scopedReader.loader == this)
+        {
+          ReadScope &scope = *scopedReader.scope;
+          auto [offsetsIt, added] = scope._argumentOffsetsByLine.try_emplace(expressID, scope._argumentOffsets.size());
+          if (added) readArgumentOffsets(line, [&](const uint32_t value) { scope._argumentOffsets.push_back(value); });
+          const uint32_t *offsets = &scope._argumentOffsets[offsetsIt->second];
+          stream()->MoveTo(argumentIndex < offsets[0] ? offsets[1 + argumentIndex] : offsets[1 + offsets[0]]);
+          return;
+        }
+        argumentOffsets = indexArguments(expressID, line);
+      }
+      const size_t offsets = argumentOffsets - 1;
+      const uint32_t count = _argumentOffsets[offsets];
+      stream()->MoveTo(argumentIndex < count ? _argumentOffsets[offsets + 1 + argumentIndex] : _argumentOffsets[offsets + 1 + count]);
+   }
+
+   void IfcLoader::readArgumentOffsets(const IfcLine &line, const std::function<void(uint32_t)> &add) const
+   {
+      // records the positions ArgumentOffset() would stop at, for every argument index
+      std::vector<uint32_t> offsets;
+      stream()->MoveTo(line.tapeOffset);
+      uint32_t setDepth = 0;
+      visitTokens([&](const IfcToken &token, const uint32_t offset)
+      {
+        if (setDepth == 1) offsets.push_back(offset);
+        if (token.type == IfcTokenType::LINE_END) return TokenVisit::Stop;
+        if (token.type == IfcTokenType::SET_BEGIN) setDepth++;
+        else if (token.type == IfcTokenType::SET_END)
+        {
+          setDepth--;
+          if (setDepth == 0) return TokenVisit::Stop;
+        }
+        return TokenVisit::Next;
+      });
+      add(offsets.size());
+      for (const uint32_t offset : offsets) add(offset);
+      add(stream()->GetReadOffset());
+   }
+
+   uint32_t IfcLoader::indexArguments(const uint32_t expressID, const IfcLine &line) const
+   {
+      const size_t start = _argumentOffsets.size();
+      readArgumentOffsets(line, [&](const uint32_t value) { _argumentOffsets.push_back(value); });
+      // line may sit on a page shared with clones, which index into their own offsets, so the page is written through
+      if (expressID < _lines.size() && _lines[expressID].ifcType != 0) _lines.Mutable(expressID).argumentOffsets = start + 1;
+      else line.argumentOffsets = start + 1;
+      return start + 1;
+   }
+
+   void IfcLoader::collectReferences(const uint32_t expressID, const IfcLine &line, std::vector<std::pair<uint32_t, InverseReference>> &references) const
+   {
+      // argument indices follow the positions indexArguments() records, so they match MoveToLineArgument()
+      stream()->MoveTo(line.tapeOffset);
+      uint32_t setDepth = 0;
+      uint32_t argumentIndex = 0;
+      uint32_t currentArgument = 0;
+      while (!stream()->IsAtEnd())
+      {
+        if (setDepth == 1) currentArgument = argumentIndex++;
+        IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+        if (t == IfcTokenType::LINE_END) break;
+        if (t == IfcTokenType::SET_BEGIN) setDepth++;
+        else if (t == IfcTokenType::SET_END)
+        {
+          setDepth--;
+          if (setDepth == 0) break;
+        }
+        else if (t == IfcTokenType::STRING || t == IfcTokenType::ENUM || t == IfcTokenType::LABEL || t == IfcTokenType::INTEGER || t == IfcTokenType::REAL)
+        {
+          uint16_t length = stream()->Read<uint16_t>();
+          stream()->Forward(length);
+        }
+        else if (t == IfcTokenType::REF)
+        {
+          const uint32_t ref = stream()->Read<uint32_t>();
+          // the reference before the arguments is the line's own id
+          if (setDepth > 0) references.push_back({ref, {expressID, currentArgument}});
+        }
+      }
+   }
+
+   void IfcLoader::buildInverseIndex() const
+   {
+      std::vector<std::pair<uint32_t, InverseReference>> references;
+      for (uint32_t expressID = 0; expressID < _lines.size(); expressID++)
+      {
+        if (_lines[expressID].ifcType != 0) collectReferences(expressID, _lines[expressID], references);
+      }
+      for (const auto &[expressID, line] : _sparseLines) collectReferences(expressID, line, references);
+      // same counting sort as buildTypeIndex, every referenced id keeps its references in line order
+      std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> ranges;
+      for (const auto &[ref, reference] : references) ranges[ref].second++;
+      uint32_t offset = 0;
+      for (auto &[ref, range] : ranges)
+      {
+        range.first = offset;
+        offset += range.second;
+        range.second = 0;
+      }
+      std::vector<InverseReference> inverseReferences(references.size());
+      for (const auto &[ref, reference] : references)
+      {
+        auto &range = ranges[ref];
+        inverseReferences[range.first + range.second++] = reference;
+      }
+      _inverseIndex = std::make_shared<const InverseIndex>(InverseIndex{std::move(ranges), std::move(inverseReferences)});
+      _editedInverseLines.clear();
+      _addedInverseReferences.clear();
+      _inverseIndexed = true;
+   }
+
+   void IfcLoader::clearInverseIndex()
+   {
+      _inverseIndexed = false;
+      _inverseIndex.reset();
+      _editedInverseLines.clear();
+      _addedInverseReferences.clear();
+   }
+
+   void IfcLoader::removeInverseReferences(const uint32_t expressID, const IfcLine &line)
+   {
+      // references of a line edited before are in the added table, otherwise marking the line hides its parsed references
+      if (_editedInverseLines.insert(expressID).second) return;
+      std::vector<std::pair<uint32_t, InverseReference>> references;
+      collectReferences(expressID, line, references);
+      for (const auto &[ref, reference] : references)
+      {
+        const auto addedIt = _addedInverseReferences.find(ref);
+        if (addedIt == _addedInverseReferences.end()) continue;
+        std::erase_if(addedIt->second, [&](const InverseReference &added) { return added.expressID == expressID; });
+        if (addedIt->second.empty()) _addedInverseReferences.erase(addedIt);
+      }
+   }
+
+   void IfcLoader::addInverseReferences(const uint32_t expressID, const IfcLine &line)
+   {
+      _editedInverseLines.insert(expressID);
+      std::vector<std::pair<uint32_t, InverseReference>> references;
+      collectReferences(expressID, line, references);
+      for (const auto &[ref, reference] : references) _addedInverseReferences[ref].push_back(reference);
+   }
+
+   std::vector<IfcLoader::InverseReference> IfcLoader::GetInverseReferences(const uint32_t expressID) const
+   {
+      if (!_inverseIndexed) buildInverseIndex();
+      std::vector<InverseReference> references;
+      const auto rangeIt = _inverseIndex->ranges.find(expressID);
+      if (rangeIt != _inverseIndex->ranges.end())
+      {
+        const auto begin = _inverseIndex->references.begin() + rangeIt->second.first;
+        if (_editedInverseLines.empty()) references.assign(begin, begin + rangeIt->second.second);
+        else std::copy_if(begin, begin + rangeIt->second.second, std::back_inserter(references), [&](const InverseReference &reference) { return !_editedInverseLines.contains(reference.expressID); });
+      }
+      const auto addedIt = _addedInverseReferences.find(expressID);
+      if (addedIt != _addedInverseReferences.end()) references.insert(references.end(), addedIt->second.begin(), addedIt->second.end());
+      return references;
+   }
+
+   std::vector<uint32_t> IfcLoader::GetExpressIDsByGlobalIds(const std::vector<std::string_view> &globalIds) const
+   {
+      if (!_globalIdsIndexed) buildGlobalIdIndex();
+      std::vector<uint32_t> expressIDs(globalIds.size(), 0);
+      for (size_t i = 0; i < globalIds.size(); i++)
+      {
+        GlobalIdKey key;
+        if (!decodeIfcGuid(globalIds[i], key.high, key.low)) continue;
+        const auto it = _globalIds->find(key);
+        if (it != _globalIds->end()) expressIDs[i] = it->second;
+      }
+      return expressIDs;
+   }
+
+   bool IfcLoader::readGlobalId(const IfcLine &line, GlobalIdKey &key) const
+   {
+      // the line's own id and type come before the set of its arguments
+      stream()->MoveTo(line.tapeOffset);
+      while (!stream()->IsAtEnd())
+      {
+        IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+        if (t == IfcTokenType::SET_BEGIN) break;
+        if (t == IfcTokenType::REF) stream()->Read<uint32_t>();
+        else if (t == IfcTokenType::LABEL)
+        {
+          uint16_t length = stream()->Read<uint16_t>();
+          stream()->Forward(length);
+        }
+        else return false;
+      }
+      if (stream()->IsAtEnd() || static_cast<IfcTokenType>(stream()->Read<char>()) != IfcTokenType::STRING) return false;
+      return decodeIfcGuid(stream()->ReadString(), key.high, key.low);
+   }
+
+   void IfcLoader::buildGlobalIdIndex() const
+   {
+      auto globalIds = std::make_shared<GlobalIdMap>();
+      GlobalIdKey key;
+      for (uint32_t expressID = 0; expressID < _lines.size(); expressID++)
+      {
+        if (_lines[expressID].ifcType != 0 && readGlobalId(_lines[expressID], key)) globalIds->try_emplace(key, expressID);
+      }
+      for (const auto &[expressID, line] : _sparseLines)
+      {
+        if (readGlobalId(line, key)) globalIds->try_emplace(key, expressID);
+      }
+      _globalIds = std::move(globalIds);
+      _globalIdsIndexed = true;
+   }
+
+   void IfcLoader::clearGlobalIdIndex()
+   {
+      _globalIdsIndexed = false;
+      _globalIds.reset();
+   }
+
+   IfcLoader::GlobalIdMap &IfcLoader::mutableGlobalIds()
+   {
+      if (_globalIds.use_count() > 1) _globalIds = std::make_shared<GlobalIdMap>(*_globalIds);
+      return *_globalIds;
+   }
+
+   void IfcLoader::removeGlobalId(const uint32_t expressID, const IfcLine &line)
+   {
+      GlobalIdKey key;
+      if (!readGlobalId(line, key)) return;
+      GlobalIdMap &globalIds = mutableGlobalIds();
+      const auto it = globalIds.find(key);
+      if (it != globalIds.end() && it->second == expressID) globalIds.erase(it);
+   }
+
+   void IfcLoader::addGlobalId(const uint32_t expressID, const IfcLine &line)
+   {
+      GlobalIdKey key;
+      if (readGlobalId(line, key)) mutableGlobalIds().insert_or_assign(key, expressID);
+   }
+
+   const IfcRelationshipIndex &IfcLoader::GetRelationshipIndex() const
+   {
+      if (!_relationshipIndex)
+      {
+        auto relationshipIndex = std::make_shared<IfcRelationshipIndex>();
+        relationshipIndex->Build(*this);
+        _relationshipIndex = std::move(relationshipIndex);
+      }
+      return *_relationshipIndex;
+   }
+
+   void IfcLoader::dropRelationshipIndex(const uint32_t expressID, const uint32_t type)
+   {
+      if (_relationshipIndex && _relationshipIndex->IsIndexed(expressID, type)) _relationshipIndex.reset();
+   }
+
+   uint64_t IfcLoader::GetContentHash(const uint32_t expressID, std::unordered_map<uint32_t, uint64_t> &hashes, const uint32_t ignoredArgument) const
+   {
+      // a hash that leaves an argument out is not what references to the line see, so it is not kept
+      const bool complete = ignoredArgument == UINT32_MAX;
+      const auto hashIt = hashes.find(expressID);
+      if (complete && hashIt != hashes.end()) return hashIt->second;
+      const IfcLine * line = findLine(expressID);
+      if (line == nullptr) return 0;
+      // a line that references itself through others sees 0 for itself
+      const bool placeholder = hashIt == hashes.end();
+      if (placeholder) hashes[expressID] = 0;
+      utility::Fnv1a hash;
+      // the references are hashed once the line is read, hashing them moves the cursor
+      std::vector<uint32_t> references;
+      readContent(*line, ignoredArgument, [&](const void *data, const size_t size) { hash.Add(data, size); }, references);
+      for (const uint32_t ref : references)
+      {
+        const uint64_t referenceHash = findLine(ref) == nullptr ? ref : GetContentHash(ref, hashes);
+        hash.Add(referenceHash);
+      }
+      if (complete) hashes[expressID] = hash.Get();
+      else if (placeholder) hashes.erase(expressID);
+      return hash.Get();
+   }
+
+   void IfcLoader::readContent(const IfcLine &line, const uint32_t ignoredArgument, const std::function<void(const void *, size_t)> &add, std::vector<uint32_t> &references) const
+   {
+      stream()->MoveTo(line.tapeOffset);
+      uint32_t setDepth = 0;
+      uint32_t argumentIndex = 0;
+      uint32_t currentArgument = 0;
+      while (!stream()->IsAtEnd())
+      {
+        if (setDepth == 1) currentArgument = argumentIndex++;
+        const bool ignored = setDepth > 0 && currentArgument == ignoredArgument;
+        IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
+        if (t == IfcTokenType::LINE_END) break;
+        if (!ignored) add(&t, sizeof(t));
+        if (t == IfcTokenType::SET_BEGIN) setDepth++;
+        else if (t == IfcTokenType::SET_END)
+        {
+          setDepth--;
+          if (setDepth == 0) break;
+        }
+        else if (t == IfcTokenType::STRING || t == IfcTokenType::ENUM || t == IfcTokenType::LABEL || t == IfcTokenType::INTEGER || t == IfcTokenType::REAL)
+        {
+          std::string_view value = stream()->ReadString(isBinaryNumber(t) ? sizeof(double) : 0);
+          if (!ignored) add(value.data(), value.size());
+        }
+        else if (t == IfcTokenType::REF)
+        {
+          const uint32_t ref = stream()->Read<uint32_t>();
+          if (setDepth > 0 && !ignored) references.push_back(ref);
+        }
+      }
+   }
+
+   bool IfcLoader::HasSameContent(const uint32_t expressID, const uint32_t otherExpressID, const uint32_t ignoredArgument) const
+   {
+      std::set<std::pair<uint32_t, uint32_t>> compared;
+      return hasSameContent(expressID, otherExpressID, ignoredArgument, compared);
+   }
+
+   bool IfcLoader::hasSameContent(const uint32_t expressID, const uint32_t otherExpressID, const uint32_t ignoredArgument, std::set<std::pair<uint32_t, uint32_t>> &compared) const
+   {
+      if (expressID == otherExpressID && ignoredArgument == UINT32_MAX) return true;
+      const IfcLine * line = findLine(expressID);
+      const IfcLine * otherLine = findLine(otherExpressID);
+      // GetContentHash takes the reference itself for a line that does not exist
+      if (line == nullptr || otherLine == nullptr) return line == otherLine && expressID == otherExpressID;
+      // lines being compared already count as alike, as GetContentHash takes 0 for lines that reference themselves
+      if (ignoredArgument == UINT32_MAX && !compared.insert({expressID, otherExpressID}).second) return true;
+      std::string content;
+      std::string otherContent;
+      std::vector<uint32_t> references;
+      std::vector<uint32_t> otherReferences;
+      readContent(*line, ignoredArgument, [&](const void *data, const size_t size) { content.append(static_cast<const char *>(data), size); }, references);
+      readContent(*otherLine, ignoredArgument, [&](const void *data, const size_t size) { otherContent.append(static_cast<const char *>(data), size); }, otherReferences);
+      if (content != otherContent || references.size() != otherReferences.size()) return false;
+      for (size_t i = 0; i < references.size(); i++)
+      {
+        if (!hasSameContent(references[i], otherReferences[i], UINT32_MAX, compared)) return false;
+      }
+      return true;
    }
 
    uint32_t IfcLoader::GetNoLineArguments(uint32_t expressID) const
    {
-      const auto lineIt = _lines.find(expressID);
-      if (lineIt == _lines.end()) return 0;
-      _tokenStream->MoveTo(lineIt->second->tapeOffset);
-      _tokenStream->Read<char>();
-      _tokenStream->Read<uint32_t>();
-      _tokenStream->Read<char>();
-      uint16_t length = _tokenStream->Read<uint16_t>();
-      _tokenStream->Forward(length);
-      _tokenStream->Read<char>();
+      const IfcLine * line = findLine(expressID);
+      if (line == nullptr) return 0;
+      stream()->MoveTo(line->tapeOffset);
+      stream()->Read<char>();
+      stream()->Read<uint32_t>();
+      stream()->Read<char>();
+      uint16_t length = stream()->Read<uint16_t>();
+      stream()->Forward(length);
+      stream()->Read<char>();
       uint32_t noArguments = 0;
 
        while (true) {
-        IfcTokenType t = static_cast<IfcTokenType>(_tokenStream->Read<char>());
+        IfcTokenType t = static_cast<IfcTokenType>(stream()->Read<char>());
         if (t == SET_END || t==LINE_END) return noArguments;
         if (t == UNKNOWN || t==EMPTY) {
           noArguments++;
@@ -685,14 +2212,14 @@ namespace webifc::parsing {
 
         }
         if (t == IfcTokenType::STRING || t == IfcTokenType::INTEGER || t == IfcTokenType::REAL || t == IfcTokenType::LABEL || t == IfcTokenType::ENUM) {
-          uint16_t length = _tokenStream->Read<uint16_t>();
-          _tokenStream->Forward(length);
+          uint16_t length = stream()->Read<uint16_t>();
+          stream()->Forward(length);
           noArguments++;
           if (t==IfcTokenType::LABEL) GetSetArgument();
           continue;
         }
         if (t == REF) {
-          _tokenStream->Read<uint32_t>();
+          stream()->Read<uint32_t>();
           noArguments++;
           continue;
         }
@@ -703,15 +2230,13 @@ namespace webifc::parsing {
    
    void IfcLoader::MoveToArgumentOffset(const uint32_t expressID, const uint32_t argumentIndex) const
    {
-       const auto lineIt = _lines.find(expressID);
-       if (lineIt == _lines.end()) return;
-
-        _tokenStream->MoveTo(lineIt->second->tapeOffset);
-   	    ArgumentOffset(argumentIndex);
+       const IfcLine * line = findLine(expressID);
+       if (line == nullptr) return;
+       moveToArgument(expressID, *line, argumentIndex);
    }
    
    void IfcLoader::StepBack() const {
-     _tokenStream->Back();
+     stream()->Back();
    }
 
     double IfcLoader::GetOptionalDoubleParam(double defaultValue = 0) const
@@ -732,13 +2257,18 @@ namespace webifc::parsing {
 
     std::vector<uint32_t> IfcLoader::GetAllLines() const {
       std::vector<uint32_t> expressIDs;
-      std::transform( _lines.begin(), _lines.end(), std::back_inserter( expressIDs ), [](auto &kv){ return kv.first;}  );
+      expressIDs.reserve(_lineCount);
+      for (uint32_t expressID = 0; expressID < _lines.size(); expressID++) if (_lines[expressID].ifcType != 0) expressIDs.push_back(expressID);
+      std::vector<uint32_t> sparseIDs;
+      for (const auto & [key, line] : _sparseLines) sparseIDs.push_back(key);
+      std::sort(sparseIDs.begin(), sparseIDs.end());
+      expressIDs.insert(expressIDs.end(), sparseIDs.begin(), sparseIDs.end());
       return expressIDs;
     }
 
     uint32_t IfcLoader::GetNextExpressID(uint32_t expressId) const {
       uint32_t currentId = expressId+1;
-      while(!_lines.contains(currentId)) currentId++;
+      while(currentId <= _maxExpressId && findLine(currentId) == nullptr) currentId++;
       return currentId;
     }
 
@@ -752,11 +2282,33 @@ namespace webifc::parsing {
     }
 
     IfcLoader * IfcLoader::Clone() {
-      return new IfcLoader(_maxExpressId, _lineWriterBuffer,_schemaManager,  _tokenStream->Clone(), _lines, _headerLines, _ifcTypeToExpressID);
+      IfcLoader * clone = new IfcLoader(_lineWriterBuffer,_schemaManager,  _tokenStream->Clone());
+      clone->_maxExpressId = _maxExpressId;
+      clone->_binaryNumbers = _binaryNumbers;
+      clone->_mappedFile = _mappedFile;
+      clone->_fileData = _fileData;
+      clone->_tapeSource = _tapeSource;
+      clone->_lines = _lines;
+      clone->_sparseLines = _sparseLines;
+      clone->_lineCount = _lineCount;
+      clone->_headerLines = _headerLines;
+      clone->_typeRanges = _typeRanges;
+      clone->_typeExpressIDs = _typeExpressIDs;
+      clone->_addedTypeExpressIDs = _addedTypeExpressIDs;
+      clone->_argumentOffsets = _argumentOffsets;
+      clone->_staleArgumentOffsets = _staleArgumentOffsets;
+      clone->_inverseIndexed = _inverseIndexed;
+      clone->_inverseIndex = _inverseIndex;
+      clone->_editedInverseLines = _editedInverseLines;
+      clone->_addedInverseReferences = _addedInverseReferences;
+      clone->_globalIdsIndexed = _globalIdsIndexed;
+      clone->_globalIds = _globalIds;
+      clone->_relationshipIndex = _relationshipIndex;
+      return clone;
     }
 
-    IfcLoader::IfcLoader(uint32_t maxExpressId,uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager, IfcTokenStream * tokenStream, std::unordered_map<uint32_t,IfcLine*> &lines, std::vector<IfcLine*> &headerLines,std::unordered_map<uint32_t, std::vector<uint32_t>> &ifcTypeToExpressID)
-      : _maxExpressId(maxExpressId) , _lineWriterBuffer(lineWriterBuffer), _schemaManager(schemaManager), _tokenStream(tokenStream), _lines(lines) , _headerLines(headerLines), _ifcTypeToExpressID(ifcTypeToExpressID)
+    IfcLoader::IfcLoader(uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager, IfcTokenStream * tokenStream)
+      : _maxExpressId(0), _lineWriterBuffer(lineWriterBuffer), _schemaManager(schemaManager), _tokenStream(tokenStream)
     {}
     
 }
\ No newline at end of file
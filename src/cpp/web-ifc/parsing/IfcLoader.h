@@ -6,27 +6,99 @@
 
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <istream>
 #include <set>
 #include <cstdint>
 #include <string_view>
+#include <memory>
+#include <optional>
 
 #include "IfcTokenStream.h"
+#include "IfcMappedFile.h"
 #include "../schema/IfcSchemaManager.h"
+#include "../utility/shared_pages.h"
 
 namespace webifc::parsing
 {
+
+  class IfcRelationshipIndex;
   
 	class IfcLoader {
   
     public:
-      IfcLoader(uint32_t tapeSize, uint64_t memoryLimit,uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager);  
+      struct InverseReference
+      {
+        uint32_t expressID;
+        // the top level argument of the referencing line, references nested in sets belong to the set's argument
+        uint32_t argumentIndex;
+      };
+      // with binaryNumbers REAL and INTEGER values are decoded once when the file is tokenized and kept on the tape
+      IfcLoader(uint32_t tapeSize, uint64_t memoryLimit,uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager, bool binaryNumbers = false);  
       ~IfcLoader();
+      // threads that tokenize the files loaded from now on, 0 takes one per hardware thread and 1, the default, tokenizes
+      // on the calling thread only, see IfcTokenStream
+      void SetTokenizerThreads(const size_t threads);
       const std::vector<uint32_t> GetHeaderLinesWithType(const uint32_t type) const;
+      // IFCZIP archives, gzip and zlib streams are recognized by their first bytes and inflated while they are tokenized
       void LoadFile(const std::function<uint32_t(char *, size_t, size_t)> &requestData);
       void LoadFile(std::istream &requestData);
+      bool LoadFile(const std::string &path);
+      // the loader keeps data, evicted chunks are reloaded from it
+      void LoadFile(std::shared_ptr<const std::vector<uint8_t>> data);
+      struct HeaderInfo
+      {
+        // the file offset just past the ENDSEC; of the HEADER section
+        uint64_t dataOffset = 0;
+        // the lines in the first block of the DATA section scaled up to fileSize, exact when the file ends within the block
+        // and a lower bound when fileSize is 0, as it is for compressed files whose inflated size is not known
+        uint64_t estimatedLines = 0;
+      };
+      // reads the file only up to the end of its HEADER section, so the header lines and GetSchema are available without
+      // tokenizing the file, and samples the start of the DATA section for the number of lines. Nullopt when the HEADER
+      // section does not end within the first 16MB
+      std::optional<HeaderInfo> LoadHeader(const std::function<uint32_t(char *, size_t, size_t)> &requestData, uint64_t fileSize = 0);
+      // called while LoadFile runs with the number of bytes of the file read so far, every line that ends before that
+      // offset can already be queried from the callback, it is called once more with the final offset when loading is done
+      void SetLoadProgressCallback(const std::function<void(uint64_t)> &progress);
+      // once loading is done only the lines of the included types, all types when includes is empty, and the lines they
+      // reference directly or indirectly are kept, lines of excluded types are never kept and their references are not
+      // followed. Tape chunks without kept lines are released, must be set before LoadFile
+      void SetEntityFilter(const std::vector<uint32_t> &includes, const std::vector<uint32_t> &excludes);
+      uint64_t GetLoadedFileOffset() const;
+      bool IsLoading() const;
+      // seconds the last LoadFile spent tokenizing the file and indexing its lines
+      struct LoadTimes
+      {
+        double tokenize = 0;
+        double parse = 0;
+      };
+      LoadTimes GetLoadTimes() const;
+      // the tape, the file kept for it and the line tables and indices
+      void AddMemoryStats(utility::MemoryStats &stats) const;
       void SaveFile(const std::function<void(char *, size_t)> &outputData, bool orderLinesByExpressID) const;
       void SaveFile(std::ostream &outputData, bool orderLinesByExpressID) const;
+      // what a tape snapshot is saved from: the size of the file and a hash of all of it, as it is stored so compressed
+      // files are hashed before they are inflated. Once lines are written or removed the tape has no source, its
+      // snapshots do not load
+      struct TapeSource
+      {
+        uint64_t size = 0;
+        uint64_t hash = 0;
+        bool operator==(const TapeSource &other) const = default;
+      };
+      static TapeSource GetTapeSource(const uint8_t *data, size_t size);
+      // nullopt when the file cannot be opened
+      static std::optional<TapeSource> GetTapeSource(const std::string &path);
+      TapeSource GetLoadedTapeSource() const;
+      // whether lines were written or removed since the file or the tape was loaded
+      bool IsEdited() const;
+      void SaveTape(const std::function<void(char *, size_t)> &outputData) const;
+      void SaveTape(std::ostream &outputData) const;
+      // fails for snapshots saved from another source than the given one and for those of other versions
+      bool LoadTape(const std::string &path, const TapeSource &source);
+      // hash of the tokenized file, equal for loads of the same file with the same settings
+      uint64_t GetTapeHash() const;
       const std::vector<uint32_t> GetExpressIDsWithType(const uint32_t type) const;
       uint32_t GetMaxExpressId() const;
       bool IsValidExpressID(const uint32_t expressID) const;
@@ -36,6 +108,9 @@ namespace webifc::parsing
       void MoveToHeaderLineArgument(const uint32_t lineID, const uint32_t argumentIndex) const;
       std::string_view GetStringArgument() const;
       std::string GetDecodedStringArgument() const;
+      // the decoded string without a copy when it has no quotes or escapes, which is most strings, otherwise it is decoded
+      // into buffer and the view is of buffer
+      std::string_view GetDecodedStringArgument(std::string &buffer) const;
       std::string GetExpandedUUIDArgument() const;
       double GetDoubleArgument() const;
       long GetIntArgument() const;
@@ -49,8 +124,19 @@ namespace webifc::parsing
       IfcTokenType GetTokenType() const;
       IfcTokenType GetTokenType(const uint32_t tapeOffset) const;
       const std::vector<uint32_t> GetSetArgument() const;
+      // the tape offsets of GetSetArgument written to tapeOffsets, which is cleared first, so a buffer kept by the caller
+      // decodes sets without allocating once it has grown
+      void GetSetArgument(std::vector<uint32_t> &tapeOffsets) const;
+      // the references of the set read in a single pass, as expressIDs instead of the offsets GetRefArgument would have to
+      // go back to, other values are skipped and expressIDs is cleared first like with GetSetArgument
+      void GetRefSetArgument(std::vector<uint32_t> &expressIDs) const;
       std::vector<uint32_t> GetAllLines() const;
       const std::vector<std::vector<uint32_t>> GetSetListArgument() const;
+      // reads a set of sets of `width` numbers, such as a CoordList or CoordIndex, into values. The inner sets are located
+      // in one pass and converted on up to `threads` threads once concurrent reads are possible, false and the cursor left
+      // where it was when the argument has another shape
+      bool GetNumberSetListArgument(std::vector<double> &values, const uint32_t width, const size_t threads) const;
+      bool GetNumberSetListArgument(std::vector<uint32_t> &values, const uint32_t width, const size_t threads) const;
       void MoveToArgumentOffset(const uint32_t expressID, const uint32_t argumentIndex) const;
       uint32_t GetNoLineArguments(uint32_t expressID) const;
       void StepBack() const;
@@ -58,15 +144,60 @@ namespace webifc::parsing
       void Push(void *v, const uint64_t size);
       uint64_t GetTotalSize() const;
       void UpdateLineTape(const uint32_t expressID, const uint32_t type, const uint32_t start);
+      // writes many lines at once from the layout GetLinesBinary exports: the uint32 line count, a uint32 byte offset per
+      // line, and per line its uint32 expressID and type and its argument tokens up to LINE_END. The lines are appended
+      // to the tape in one push and the line table grows once, lines of type 0 are skipped. Nothing is written and
+      // false returned when the buffer is malformed
+      bool AppendLines(const uint8_t *data, const size_t size);
       void AddHeaderLineTape(const uint32_t type, const uint32_t start);
       uint32_t GetCurrentLineExpressID() const;
       void RemoveLine(const uint32_t expressID);
       void PushDouble(double input);
       void PushInt(int input);
       std::string GenerateUUID() const;
+      // a loader over the same lines that shares the tape, the line table and the indices with this one, both can be read
+      // and edited on their own threads afterwards and only the tape chunks and table pages either of them writes to are
+      // copied then
       IfcLoader* Clone();
+      // keeps the whole tape in memory so that ReadScopes can be opened, false when the memory limit does not allow it
+      bool PrepareConcurrentReads() const;
+      // while a scope is open the thread reads the loader through its own cursor, so several threads can read one loader at
+      // once, every thread reading it must then be in a scope and nothing may modify the loader until they are closed
+      class ReadScope
+      {
+        public:
+          explicit ReadScope(const IfcLoader &loader);
+          ~ReadScope();
+          ReadScope(const ReadScope &) = delete;
+          ReadScope &operator=(const ReadScope &) = delete;
+        private:
+          friend class IfcLoader;
+          std::unique_ptr<IfcTokenStream> _stream;
+          const IfcLoader *_previousLoader;
+          IfcTokenStream *_previousStream;
+          ReadScope *_previousScope;
+          // the lines the scope indexed, laid out as in _argumentOffsets of the loader, which scopes do not extend
+          std::unordered_map<uint32_t, uint32_t> _argumentOffsetsByLine;
+          std::vector<uint32_t> _argumentOffsets;
+      };
 
       uint32_t GetNextExpressID(uint32_t expressId) const;
+      // lines that reference expressID, the index is built by the first call and kept up to date by UpdateLineTape and RemoveLine
+      std::vector<InverseReference> GetInverseReferences(const uint32_t expressID) const;
+      // the line of every GlobalId, a compressed GUID of 22 characters, 0 for GlobalIds no line has. Lines are indexed by
+      // their first argument decoded to 128 bits where it is such a GUID, as with every IfcRoot, the index is built by the
+      // first call and kept up to date by UpdateLineTape and RemoveLine. Of lines sharing a GlobalId the first is found
+      std::vector<uint32_t> GetExpressIDsByGlobalIds(const std::vector<std::string_view> &globalIds) const;
+      // the aggregation, containment, property, type and material relationships, the index is built by the first call and
+      // built again by the call after one of the lines it is read from was written or removed
+      const IfcRelationshipIndex &GetRelationshipIndex() const;
+      // hash of the line's type and arguments with every reference replaced by the hash of the line it points to, so lines
+      // describing the same data under different expressIDs hash alike, hashes keeps the lines hashed so far and can be
+      // passed to the next call, the argument at ignoredArgument is left out of the line itself
+      uint64_t GetContentHash(const uint32_t expressID, std::unordered_map<uint32_t, uint64_t> &hashes, const uint32_t ignoredArgument = UINT32_MAX) const;
+      // whether the lines hold the same data as GetContentHash sees it, compared token by token with the referenced lines
+      // compared alike, so that lines whose hashes only collide are told apart
+      bool HasSameContent(const uint32_t expressID, const uint32_t otherExpressID, const uint32_t ignoredArgument = UINT32_MAX) const;
       template <typename T> void Push(T input)
       {
         _tokenStream->Push(input);
@@ -77,16 +208,119 @@ namespace webifc::parsing
       {
         uint32_t ifcType;
         uint32_t tapeOffset;
+        // 1-based position of the line's entry in _argumentOffsets, 0 while the line is not indexed
+        mutable uint32_t argumentOffsets = 0;
       };
-      IfcLoader(uint32_t maxExpressId, uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager, IfcTokenStream * tokenStream, std::unordered_map<uint32_t,IfcLine*> &lines, std::vector<IfcLine*> &headerLines,std::unordered_map<uint32_t, std::vector<uint32_t>> &ifcTypeToExpressID);
+      IfcLoader(uint32_t lineWriterBuffer, const schema::IfcSchemaManager &schemaManager, IfcTokenStream * tokenStream);
       uint32_t _maxExpressId;
       const uint32_t _lineWriterBuffer;
       const schema::IfcSchemaManager &_schemaManager;
       IfcTokenStream * _tokenStream;
-      std::unordered_map<uint32_t,IfcLine*> _lines;
-      std::vector<IfcLine*> _headerLines;
-      std::unordered_map<uint32_t, std::vector<uint32_t>> _ifcTypeToExpressID;
+      // the read cursor of the calling thread, its ReadScope's stream or _tokenStream
+      IfcTokenStream * stream() const;
+      bool _binaryNumbers = false;
+      bool isBinaryNumber(const IfcTokenType t) const;
+      double readBinaryNumber(const IfcTokenType t) const;
+      template <typename T> bool readNumberSetList(std::vector<T> &values, const uint32_t width, const size_t threads) const;
+      // passes the tokens from the read position on to visit(token, tapeOffset) with the position left after the last one
+      // visited, see TokenVisit. Tokens are decoded straight from the pinned current chunk, only tokens that cross a chunk
+      // boundary are copied out first
+      template <typename Visit> void visitTokens(const Visit &visit) const;
+      std::shared_ptr<IfcMappedFile> _mappedFile;
+      // a compressed file, which open fills in, when the header starts one, nullptr otherwise
+      static std::shared_ptr<IfcCompressedFile> openCompressed(const uint8_t *header, const size_t size, const std::function<bool(IfcCompressedFile &)> &open);
+      std::shared_ptr<const std::vector<uint8_t>> _fileData;
+      // lines are stored densely by expressID, ids far beyond the number of lines go to the sparse table, empty slots have ifcType 0.
+      // Indexing the arguments of a line writes to its page, so the table is mutable
+      mutable utility::SharedPages<IfcLine> _lines;
+      std::unordered_map<uint32_t, IfcLine> _sparseLines;
+      uint32_t _lineCount = 0;
+      std::vector<IfcLine> _headerLines;
+      // expressIDs by type, laid out contiguously per type when the file is parsed, lines added later are kept per type
+      std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> _typeRanges;
+      std::shared_ptr<const std::vector<uint32_t>> _typeExpressIDs = std::make_shared<const std::vector<uint32_t>>();
+      std::unordered_map<uint32_t, std::vector<uint32_t>> _addedTypeExpressIDs;
+      const IfcLine * findLine(const uint32_t expressID) const;
+      IfcLine * findLine(const uint32_t expressID);
+      void insertLine(const uint32_t expressID, const uint32_t type, const uint32_t tapeOffset);
+      // hands the bytes GetContentHash hashes of the line itself to add, and the lines it references to references
+      void readContent(const IfcLine &line, const uint32_t ignoredArgument, const std::function<void(const void *, size_t)> &add, std::vector<uint32_t> &references) const;
+      bool hasSameContent(const uint32_t expressID, const uint32_t otherExpressID, const uint32_t ignoredArgument, std::set<std::pair<uint32_t, uint32_t>> &compared) const;
+      void buildTypeIndex(const std::vector<std::pair<uint32_t, uint32_t>> &typedLines);
+      // per line: argument count, tape offset of every top level argument, offset past the closing bracket
+      mutable utility::SharedPages<uint32_t> _argumentOffsets;
+      // entries of _argumentOffsets no line points to any more
+      size_t _staleArgumentOffsets = 0;
+      // forgets the argument offsets of a line whose tape is rewritten or removed
+      void dropArgumentOffsets(IfcLine &line);
+      void moveToArgument(const uint32_t expressID, const IfcLine &line, const uint32_t argumentIndex) const;
+      // the 1-based position of the line's entry
+      uint32_t indexArguments(const uint32_t expressID, const IfcLine &line) const;
+      // hands the entry of the line in _argumentOffsets to add, value by value
+      void readArgumentOffsets(const IfcLine &line, const std::function<void(uint32_t)> &add) const;
+      // references of the parsed lines are laid out contiguously per referenced id, lines edited afterwards are ignored there
+      // and their current references are kept per referenced id instead
+      struct InverseIndex
+      {
+        std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> ranges;
+        std::vector<InverseReference> references;
+      };
+      mutable bool _inverseIndexed = false;
+      mutable std::shared_ptr<const InverseIndex> _inverseIndex;
+      mutable std::unordered_set<uint32_t> _editedInverseLines;
+      mutable std::unordered_map<uint32_t, std::vector<InverseReference>> _addedInverseReferences;
+      void buildInverseIndex() const;
+      void clearInverseIndex();
+      void collectReferences(const uint32_t expressID, const IfcLine &line, std::vector<std::pair<uint32_t, InverseReference>> &references) const;
+      void removeInverseReferences(const uint32_t expressID, const IfcLine &line);
+      void addInverseReferences(const uint32_t expressID, const IfcLine &line);
+      struct GlobalIdKey
+      {
+        uint64_t high = 0;
+        uint64_t low = 0;
+        bool operator==(const GlobalIdKey &other) const = default;
+      };
+      struct GlobalIdHash
+      {
+        size_t operator()(const GlobalIdKey &key) const { return static_cast<size_t>(key.high ^ (key.low * 0x9E3779B97F4A7C15ull)); }
+      };
+      using GlobalIdMap = std::unordered_map<GlobalIdKey, uint32_t, GlobalIdHash>;
+      mutable bool _globalIdsIndexed = false;
+      // shared with clones until one of them edits a line
+      mutable std::shared_ptr<GlobalIdMap> _globalIds;
+      GlobalIdMap &mutableGlobalIds();
+      // false when the line's first argument is no compressed GUID
+      bool readGlobalId(const IfcLine &line, GlobalIdKey &key) const;
+      void buildGlobalIdIndex() const;
+      void clearGlobalIdIndex();
+      void removeGlobalId(const uint32_t expressID, const IfcLine &line);
+      void addGlobalId(const uint32_t expressID, const IfcLine &line);
+      mutable std::shared_ptr<const IfcRelationshipIndex> _relationshipIndex;
+      void dropRelationshipIndex(const uint32_t expressID, const uint32_t type);
+      // ParseLines resumes from here, so lines can be indexed while the file is still being tokenized
+      struct ParseState
+      {
+        uint32_t ifcType = 0;
+        uint32_t expressID = 0;
+        uint32_t tapeOffset = 0;
+        size_t readOffset = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> typedLines;
+      };
+      ParseState _parseState;
+      std::function<void(uint64_t)> _loadProgress;
+      uint64_t _loadedFileOffset = 0;
+      TapeSource _tapeSource;
+      bool _loading = false;
+      LoadTimes _loadTimes;
+      void loadTokens(const std::function<void()> &setTokenSource);
       void ParseLines();
+      void finishParse();
+      std::unordered_set<uint32_t> _includeTypes;
+      std::unordered_set<uint32_t> _excludeTypes;
+      void applyEntityFilter(std::vector<std::pair<uint32_t, uint32_t>> &typedLines);
+      // writes the current lines whose tape offset (ordered) or expressID (unordered) is in [start, end)
+      void saveLines(IfcTokenStream &tokenStream, const std::function<void(char *, size_t)> &outputData, const bool orderLinesByExpressID, const size_t start, const size_t end) const;
+      bool saveLinesParallel(const std::function<void(char *, size_t)> &outputData, const bool orderLinesByExpressID, const size_t threads) const;
       void ArgumentOffset(const uint32_t argumentIndex) const;      
       
 	};
@@ -0,0 +1,114 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <spdlog/spdlog.h>
+#include "IfcMappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace webifc::parsing
+{
+
+  IfcMappedFile::~IfcMappedFile()
+  {
+    Close();
+  }
+
+  bool IfcMappedFile::Open(const std::string &path)
+  {
+    Close();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      spdlog::error("[IfcMappedFile::Open()] unable to open {}", path);
+      return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+      spdlog::error("[IfcMappedFile::Open()] unable to map empty file {}", path);
+      CloseHandle(file);
+      return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr)
+    {
+      spdlog::error("[IfcMappedFile::Open()] unable to map {}", path);
+      if (mapping != nullptr) CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+    _file = file;
+    _mapping = mapping;
+    _data = static_cast<const char *>(view);
+    _size = static_cast<size_t>(size.QuadPart);
+    return true;
+#elif !defined(__EMSCRIPTEN__)
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+      spdlog::error("[IfcMappedFile::Open()] unable to open {}", path);
+      return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+      spdlog::error("[IfcMappedFile::Open()] unable to map empty file {}", path);
+      close(file);
+      return false;
+    }
+    void *view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(file);
+    if (view == MAP_FAILED)
+    {
+      spdlog::error("[IfcMappedFile::Open()] unable to map {}", path);
+      return false;
+    }
+    _data = static_cast<const char *>(view);
+    _size = static_cast<size_t>(info.st_size);
+    return true;
+#else
+    spdlog::error("[IfcMappedFile::Open()] memory mapped files are not available in this build {}", path);
+    return false;
+#endif
+  }
+
+  void IfcMappedFile::Close()
+  {
+    if (_data == nullptr) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+    CloseHandle(_file);
+    _mapping = nullptr;
+    _file = nullptr;
+#elif !defined(__EMSCRIPTEN__)
+    munmap(const_cast<char *>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+  }
+
+  const char *IfcMappedFile::GetData() const
+  {
+    return _data;
+  }
+
+  size_t IfcMappedFile::GetSize() const
+  {
+    return _size;
+  }
+
+}
@@ -0,0 +1,35 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace webifc::parsing
+{
+
+  // read-only memory mapping of a whole file, only available in native builds
+  class IfcMappedFile
+  {
+    public:
+      IfcMappedFile() = default;
+      ~IfcMappedFile();
+      IfcMappedFile(const IfcMappedFile &) = delete;
+      IfcMappedFile &operator=(const IfcMappedFile &) = delete;
+      bool Open(const std::string &path);
+      void Close();
+      const char *GetData() const;
+      size_t GetSize() const;
+
+    private:
+      const char *_data = nullptr;
+      size_t _size = 0;
+#ifdef _WIN32
+      void *_file = nullptr;
+      void *_mapping = nullptr;
+#endif
+  };
+
+}
@@ -0,0 +1,228 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include "IfcRelationshipIndex.h"
+#include "IfcLoader.h"
+#include "../schema/ifc-schema.h"
+#include "../utility/scratch.h"
+
+namespace webifc::parsing
+{
+
+  namespace
+  {
+    // a single reference or the references of a set, other values are skipped
+    void ReadRefs(const IfcLoader &loader, std::vector<uint32_t> &refs)
+    {
+      const IfcTokenType t = loader.GetTokenType();
+      loader.StepBack();
+      if (t == IfcTokenType::REF)
+      {
+        refs.push_back(loader.GetRefArgument());
+      }
+      else if (t == IfcTokenType::SET_BEGIN)
+      {
+        utility::ScratchVector<uint32_t> set;
+        loader.GetRefSetArgument(*set);
+        refs.insert(refs.end(), set->begin(), set->end());
+      }
+    }
+
+    void AppendUnique(std::vector<uint32_t> &values, const std::vector<uint32_t> &added)
+    {
+      for (uint32_t value : added)
+      {
+        if (std::find(values.begin(), values.end(), value) == values.end()) values.push_back(value);
+      }
+    }
+  }
+
+  void IfcRelationshipIndex::Build(const IfcLoader &loader)
+  {
+    _aggregated.clear();
+    _contained.clear();
+    _propertyDefinitions.clear();
+    _materials.clear();
+    _typeObjects.clear();
+    _typePropertySets.clear();
+
+    std::vector<uint32_t> relating;
+    std::vector<uint32_t> related;
+    // reads the relating and related arguments of every relationship of the type and passes them on per relationship
+    auto forEachRelationship = [&](const uint32_t type, const uint32_t relatingArgument, const uint32_t relatedArgument, const auto &add)
+    {
+      for (uint32_t expressID : loader.GetExpressIDsWithType(type))
+      {
+        relating.clear();
+        related.clear();
+        loader.MoveToArgumentOffset(expressID, relatingArgument);
+        ReadRefs(loader, relating);
+        loader.MoveToArgumentOffset(expressID, relatedArgument);
+        ReadRefs(loader, related);
+        add();
+      }
+    };
+
+    forEachRelationship(schema::IFCRELAGGREGATES, 4, 5, [&]()
+    {
+      for (uint32_t object : relating)
+      {
+        auto &aggregated = _aggregated[object];
+        aggregated.insert(aggregated.end(), related.begin(), related.end());
+      }
+    });
+    forEachRelationship(schema::IFCRELCONTAINEDINSPATIALSTRUCTURE, 5, 4, [&]()
+    {
+      for (uint32_t structure : relating)
+      {
+        auto &contained = _contained[structure];
+        contained.insert(contained.end(), related.begin(), related.end());
+      }
+    });
+    // RelatingPropertyDefinition is a single definition or, from IFC4 on, a set of them
+    forEachRelationship(schema::IFCRELDEFINESBYPROPERTIES, 5, 4, [&]()
+    {
+      for (uint32_t object : related) AppendUnique(_propertyDefinitions[object], relating);
+    });
+    forEachRelationship(schema::IFCRELASSOCIATESMATERIAL, 5, 4, [&]()
+    {
+      for (uint32_t object : related) AppendUnique(_materials[object], relating);
+    });
+    forEachRelationship(schema::IFCRELDEFINESBYTYPE, 5, 4, [&]()
+    {
+      if (relating.empty()) return;
+      for (uint32_t object : related) _typeObjects.try_emplace(object, relating[0]);
+      _typePropertySets.try_emplace(relating[0]);
+    });
+
+    // HasPropertySets is the sixth argument of IfcTypeObject in every schema
+    for (auto &[typeObject, propertySets] : _typePropertySets)
+    {
+      if (loader.GetNoLineArguments(typeObject) <= 5) continue;
+      loader.MoveToArgumentOffset(typeObject, 5);
+      ReadRefs(loader, propertySets);
+    }
+  }
+
+  bool IfcRelationshipIndex::IsIndexed(const uint32_t expressID, const uint32_t type) const
+  {
+    switch (type)
+    {
+      case schema::IFCRELAGGREGATES:
+      case schema::IFCRELCONTAINEDINSPATIALSTRUCTURE:
+      case schema::IFCRELDEFINESBYPROPERTIES:
+      case schema::IFCRELDEFINESBYTYPE:
+      case schema::IFCRELASSOCIATESMATERIAL:
+        return true;
+      default:
+        return _typePropertySets.contains(expressID);
+    }
+  }
+
+  const std::vector<uint32_t> &IfcRelationshipIndex::find(const std::unordered_map<uint32_t, std::vector<uint32_t>> &relation, const uint32_t expressID)
+  {
+    static const std::vector<uint32_t> none;
+    const auto it = relation.find(expressID);
+    return it == relation.end() ? none : it->second;
+  }
+
+  const std::vector<uint32_t> &IfcRelationshipIndex::GetAggregated(const uint32_t expressID) const
+  {
+    return find(_aggregated, expressID);
+  }
+
+  const std::vector<uint32_t> &IfcRelationshipIndex::GetContained(const uint32_t expressID) const
+  {
+    return find(_contained, expressID);
+  }
+
+  const std::vector<uint32_t> &IfcRelationshipIndex::GetPropertyDefinitions(const uint32_t expressID) const
+  {
+    return find(_propertyDefinitions, expressID);
+  }
+
+  const std::vector<uint32_t> &IfcRelationshipIndex::GetMaterials(const uint32_t expressID) const
+  {
+    return find(_materials, expressID);
+  }
+
+  uint32_t IfcRelationshipIndex::GetTypeObject(const uint32_t expressID) const
+  {
+    const auto it = _typeObjects.find(expressID);
+    return it == _typeObjects.end() ? 0 : it->second;
+  }
+
+  std::vector<uint32_t> IfcRelationshipIndex::GetPropertySets(const uint32_t expressID, const bool typeProperties) const
+  {
+    std::vector<uint32_t> propertySets = GetPropertyDefinitions(expressID);
+    const uint32_t typeObject = typeProperties ? GetTypeObject(expressID) : 0;
+    if (typeObject != 0)
+    {
+      AppendUnique(propertySets, find(_typePropertySets, typeObject));
+      AppendUnique(propertySets, GetPropertyDefinitions(typeObject));
+    }
+    return propertySets;
+  }
+
+  std::vector<uint32_t> IfcRelationshipIndex::GetPropertySets(const std::vector<uint32_t> &expressIDs, const bool typeProperties) const
+  {
+    std::vector<uint32_t> result;
+    result.reserve(expressIDs.size() * 2);
+    for (uint32_t expressID : expressIDs)
+    {
+      const auto propertySets = GetPropertySets(expressID, typeProperties);
+      result.push_back(static_cast<uint32_t>(propertySets.size()));
+      result.insert(result.end(), propertySets.begin(), propertySets.end());
+    }
+    return result;
+  }
+
+  std::vector<uint32_t> IfcRelationshipIndex::GetSpatialTree(const IfcLoader &loader, const bool propertySets, const bool typeProperties) const
+  {
+    const auto projects = loader.GetExpressIDsWithType(schema::IFCPROJECT);
+    std::vector<uint32_t> tree;
+    tree.push_back(static_cast<uint32_t>(projects.size()));
+    std::vector<bool> visited(loader.GetMaxExpressId() + 1, false);
+    for (uint32_t project : projects)
+    {
+      visited[project] = true;
+      appendNode(loader, project, propertySets, typeProperties, tree, visited);
+    }
+    return tree;
+  }
+
+  void IfcRelationshipIndex::appendNode(const IfcLoader &loader, const uint32_t expressID, const bool propertySets, const bool typeProperties, std::vector<uint32_t> &tree, std::vector<bool> &visited) const
+  {
+    tree.push_back(expressID);
+    tree.push_back(loader.GetLineType(expressID));
+    const size_t childCount = tree.size();
+    tree.push_back(0);
+    if (propertySets)
+    {
+      const auto sets = GetPropertySets(expressID, typeProperties);
+      tree.push_back(static_cast<uint32_t>(sets.size()));
+      tree.insert(tree.end(), sets.begin(), sets.end());
+    }
+    else tree.push_back(0);
+
+    // the children are marked before descending so an object reached through two relationships stays where it was first
+    std::vector<uint32_t> children;
+    for (const auto *related : {&GetAggregated(expressID), &GetContained(expressID)})
+    {
+      for (uint32_t child : *related)
+      {
+        if (child >= visited.size() || visited[child]) continue;
+        visited[child] = true;
+        children.push_back(child);
+      }
+    }
+    tree[childCount] = static_cast<uint32_t>(children.size());
+    for (uint32_t child : children)
+    {
+      appendNode(loader, child, propertySets, typeProperties, tree, visited);
+    }
+  }
+
+}
@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace webifc::parsing
+{
+
+  class IfcLoader;
+
+  // the objectified relationships properties and spatial trees are read from, gathered by one pass over the lines of
+  // each relationship type. Related objects are kept in the order of the relationships in the file
+  class IfcRelationshipIndex
+  {
+  public:
+    void Build(const IfcLoader &loader);
+    // true for the lines the index is read from, which are IfcRelAggregates, IfcRelContainedInSpatialStructure,
+    // IfcRelDefinesByProperties, IfcRelDefinesByType, IfcRelAssociatesMaterial and the type objects they name
+    bool IsIndexed(const uint32_t expressID, const uint32_t type) const;
+    const std::vector<uint32_t> &GetAggregated(const uint32_t expressID) const;
+    const std::vector<uint32_t> &GetContained(const uint32_t expressID) const;
+    // the property set definitions of IfcRelDefinesByProperties with the object
+    const std::vector<uint32_t> &GetPropertyDefinitions(const uint32_t expressID) const;
+    const std::vector<uint32_t> &GetMaterials(const uint32_t expressID) const;
+    // the type object of IfcRelDefinesByType with the object, 0 for untyped objects
+    uint32_t GetTypeObject(const uint32_t expressID) const;
+    // the object's own property set definitions followed, with typeProperties, by the HasPropertySets of its type object
+    // and the definitions related to the type object, each definition once
+    std::vector<uint32_t> GetPropertySets(const uint32_t expressID, const bool typeProperties) const;
+    // per object the uint32 count of its property sets and their expressIDs as GetPropertySets has them
+    std::vector<uint32_t> GetPropertySets(const std::vector<uint32_t> &expressIDs, const bool typeProperties) const;
+    // the tree below every IfcProject as uint32 values: the number of roots, then every node in preorder as its
+    // expressID, type, number of children and number of property sets followed by their expressIDs, which are only
+    // filled in with propertySets. The children of a node are its aggregated objects and then its contained elements,
+    // objects reached a second time are left out
+    std::vector<uint32_t> GetSpatialTree(const IfcLoader &loader, const bool propertySets, const bool typeProperties) const;
+
+  private:
+    void appendNode(const IfcLoader &loader, const uint32_t expressID, const bool propertySets, const bool typeProperties, std::vector<uint32_t> &tree, std::vector<bool> &visited) const;
+    static const std::vector<uint32_t> &find(const std::unordered_map<uint32_t, std::vector<uint32_t>> &relation, const uint32_t expressID);
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _aggregated;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _contained;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _propertyDefinitions;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _materials;
+    std::unordered_map<uint32_t, uint32_t> _typeObjects;
+    // HasPropertySets of every type object named by IfcRelDefinesByType
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _typePropertySets;
+  };
+
+}
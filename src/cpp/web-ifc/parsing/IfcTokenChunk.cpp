@@ -3,12 +3,16 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
 
+#include <algorithm>
+#include <charconv>
+#include <fast_float/fast_float.h>
 #include "IfcTokenStream.h"
+#include "../utility/trace.h"
 
 namespace webifc::parsing
 {
   
-  IfcTokenStream::IfcTokenChunk::IfcTokenChunk(const size_t chunkSize, const size_t startRef, const size_t fileStartRef, IfcFileStream *fileStream) :  _startRef(startRef), _fileStartRef(fileStartRef), _chunkSize(chunkSize), _fileStream(fileStream)
+  IfcTokenStream::IfcTokenChunk::IfcTokenChunk(const size_t chunkSize, const size_t startRef, const size_t fileStartRef, IfcFileStream *fileStream, const bool binaryNumbers) :  _startRef(startRef), _fileStartRef(fileStartRef), _binaryNumbers(binaryNumbers), _chunkSize(chunkSize), _fileStream(fileStream)
   {
     _chunkData = nullptr;
     _loaded=true;
@@ -16,10 +20,18 @@ namespace webifc::parsing
     if (_fileStream!=nullptr) Load();
   }
 
+  IfcTokenStream::IfcTokenChunk::IfcTokenChunk(const size_t startRef, const uint8_t *tapeData, const size_t size) : _startRef(startRef), _fileStartRef(0), _binaryNumbers(false), _chunkSize(size), _fileStream(nullptr), _tapeData(tapeData)
+  {
+    _chunkData = nullptr;
+    _loaded=false;
+    _currentSize = size;
+  }
+
   bool IfcTokenStream::IfcTokenChunk::Clear(bool force)
   {
-    if (_fileStream==nullptr && !force) return false; 
-    if (_chunkData!=nullptr) delete[] _chunkData;
+    if (!IsReloadable() && !force) return false; 
+    // clones of the stream keep the data they share
+    _chunkData.reset();
     _loaded=false;
     return true;
   }
@@ -49,40 +61,98 @@ namespace webifc::parsing
     return _chunkSize;
   }
   
+  void IfcTokenStream::IfcTokenChunk::Rebase(const size_t startRef, IfcFileStream *fileStream)
+  {
+    _startRef = startRef;
+    _fileStream = fileStream;
+  }
+
+  bool IfcTokenStream::IfcTokenChunk::IsReloadable()
+  {
+    return _fileStream != nullptr || _tapeData != nullptr;
+  }
+
+  void IfcTokenStream::IfcTokenChunk::Touch(const uint64_t tick)
+  {
+    _lastAccess = tick;
+  }
+
+  uint64_t IfcTokenStream::IfcTokenChunk::LastAccess()
+  {
+    return _lastAccess;
+  }
+
+  size_t IfcTokenStream::IfcTokenChunk::GetFileStartRef()
+  {
+    return _fileStartRef;
+  }
+
+  size_t IfcTokenStream::IfcTokenChunk::GetFileEndRef()
+  {
+    return _fileEndRef;
+  }
+
+  void IfcTokenStream::IfcTokenChunk::LoadFrom(IfcFileStream *fileStream)
+  {
+    // used on a detached copy of an evicted chunk, so it can be tokenized on another thread
+    _fileStream = fileStream;
+    _chunkData = nullptr;
+    Load();
+  }
+
+  const uint8_t * IfcTokenStream::IfcTokenChunk::GetData()
+  {
+    if (!_loaded) Load();
+    return _chunkData.get();
+  }
+
+  void IfcTokenStream::IfcTokenChunk::Adopt(IfcTokenChunk &loaded)
+  {
+    _chunkData = std::move(loaded._chunkData);
+    _loaded = true;
+  }
+
   std::string_view IfcTokenStream::IfcTokenChunk::ReadString(const size_t ptr,const size_t size) 
   {
   		if (!_loaded) Load();
-      return std::string_view((char*)_chunkData+ptr,size);
+      return std::string_view((char*)_chunkData.get()+ptr,size);
   }
   
   void IfcTokenStream::IfcTokenChunk::Push(void *v, const size_t size)
   {
-      if (_chunkData == nullptr) _chunkData =  new uint8_t[_chunkSize];
+      if (_chunkData == nullptr) _chunkData.reset(new uint8_t[_chunkSize]);
       _currentSize+=size;
-      if (_currentSize > _chunkSize) {
-          uint8_t * tmp = _chunkData;
-          _chunkData = new uint8_t[_currentSize];
-          std::memcpy(_chunkData, tmp, _currentSize-size);
-          _chunkSize = _currentSize;
-          delete[] tmp;
+      // data shared with a clone of the stream is copied before it is written to
+      if (_currentSize > _chunkSize || _chunkData.use_count() > 1) {
+          std::shared_ptr<uint8_t[]> tmp = std::move(_chunkData);
+          _chunkSize = std::max(_chunkSize, _currentSize);
+          _chunkData.reset(new uint8_t[_chunkSize]);
+          std::memcpy(_chunkData.get(), tmp.get(), _currentSize-size);
       }
-      std::memcpy(_chunkData + _currentSize - size, v, size);
+      std::memcpy(_chunkData.get() + _currentSize - size, v, size);
   }
   
   void IfcTokenStream::IfcTokenChunk::Load()
   {
-      _chunkData = new uint8_t[_chunkSize];
+      WEBIFC_TRACE_SCOPE("IfcTokenChunk::Load", _startRef);
+      _chunkData.reset(new uint8_t[_chunkSize]);
       _loaded=true;
+      if (_tapeData != nullptr)
+      {
+        std::memcpy(_chunkData.get(), _tapeData, _currentSize);
+        return;
+      }
       if (_fileStream->GetRef()!=_fileStartRef) _fileStream->Go(_fileStartRef);
       std::vector<char> temp;
       temp.reserve(50);
       _currentSize = 0;
-      while ( !_fileStream->IsAtEnd() && _currentSize < _chunkSize)
+      // once loaded a chunk is bound to its file range, so that reloads reproduce the same tokens
+      while ( !_fileStream->IsAtEnd() && _currentSize < _chunkSize && (_fileEndRef == 0 || _fileStream->GetRef() < _fileEndRef))
       {
         const char c = _fileStream->Get();
         if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
         { 
-          _fileStream->Forward();
+          _fileStream->SkipWhitespace();
           continue;
         }
 
@@ -97,26 +167,23 @@ namespace webifc::parsing
           // turns out this is just part of ISO 10303-21, thanks ottosson!
           while (true)
           {
-  
-            temp.push_back(_fileStream->Get());
+            // copy everything up to the next quote in bulk
+            _fileStream->ReadUntil('\'', temp);
+            if (_fileStream->IsAtEnd()) break;
             // if its a quote, maybe its the end of the string
+            _fileStream->Forward();
             if (_fileStream->Get() == '\'')
             {
-              // if there's another quote behind it, its not
+              // if there's another quote behind it, its not, both quotes are kept on the tape
+              temp.push_back('\'');
+              temp.push_back('\'');
               _fileStream->Forward();
-              if (_fileStream->Get() == '\'')
-              {
-                // we also bump pos, otherwise we still break next loop...
-                temp.push_back(_fileStream->Get());
-              }
-              else
-              {
-                _fileStream->Back();
-                temp.pop_back();
-                break;
-              }
             }
-             _fileStream->Forward();
+            else
+            {
+              _fileStream->Back();
+              break;
+            }
           }
           Push<uint8_t>(IfcTokenType::STRING);
           Push<uint16_t>(temp.size());
@@ -145,8 +212,9 @@ namespace webifc::parsing
           {
             _fileStream->Forward();
 
-            // comment
-            while (!(_fileStream->Prev() == '*' && _fileStream->Get() == '/')) _fileStream->Forward();
+            // comment, the '*' that opens it does not also close it, as in "/*/"
+            do _fileStream->Forward();
+            while (!(_fileStream->Prev() == '*' && _fileStream->Get() == '/'));
   
           }
           else Push<uint8_t>(IfcTokenType::UNKNOWN);
@@ -167,7 +235,24 @@ namespace webifc::parsing
           }
           if (isFrac) Push<uint8_t>(IfcTokenType::REAL);
           else Push<uint8_t>(IfcTokenType::INTEGER);  
-          Push<uint16_t>(temp.size());
+          if (_binaryNumbers)
+          {
+            // the value is decoded once here, the text stays behind it so the number is written back unchanged
+            Push<uint16_t>(sizeof(double) + temp.size());
+            if (isFrac)
+            {
+              double value = 0;
+              fast_float::from_chars(temp.data(), temp.data() + temp.size(), value);
+              Push<double>(value);
+            }
+            else
+            {
+              int64_t value = 0;
+              std::from_chars(temp.data(), temp.data() + temp.size(), value);
+              Push<int64_t>(value);
+            }
+          }
+          else Push<uint16_t>(temp.size());
           Push(temp.data(), temp.size());
 
           // skip next advance
@@ -211,5 +296,6 @@ namespace webifc::parsing
         else if (c == ';') Push<uint8_t>(IfcTokenType::LINE_END);
         _fileStream->Forward();  
       }
+      if (_fileEndRef == 0) _fileEndRef = _fileStream->GetRef();
     }
 }
\ No newline at end of file
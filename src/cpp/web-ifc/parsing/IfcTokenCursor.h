@@ -0,0 +1,83 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "IfcTokenStream.h"
+
+namespace webifc::parsing
+{
+
+  struct IfcToken
+  {
+    IfcTokenType type = IfcTokenType::UNKNOWN;
+    // the expressID of REF tokens
+    uint32_t ref = 0;
+    // the payload of STRING, LABEL, ENUM, REAL and INTEGER tokens, with binary numbers it starts with the value
+    const uint8_t *payload = nullptr;
+    uint16_t length = 0;
+
+    std::string_view Text(const size_t skip = 0) const
+    {
+      return std::string_view(reinterpret_cast<const char *>(payload) + skip, length - skip);
+    }
+  };
+
+  // decodes the tokens of a range of the tape with plain pointer arithmetic, the range is a pinned chunk of a stream or a
+  // copy of tokens that crossed a chunk boundary
+  class IfcTokenCursor
+  {
+    public:
+      IfcTokenCursor(const uint8_t *data, const size_t size) : _data(data), _size(size) {}
+
+      // the next token when all of it lies in the range, false and the cursor unchanged otherwise
+      bool Next(IfcToken &token)
+      {
+        if (_position >= _size) return false;
+        const IfcTokenType type = static_cast<IfcTokenType>(_data[_position]);
+        size_t next = _position + 1;
+        token.type = type;
+        switch (type)
+        {
+          case IfcTokenType::REF:
+            if (next + sizeof(uint32_t) > _size) return false;
+            std::memcpy(&token.ref, _data + next, sizeof(uint32_t));
+            next += sizeof(uint32_t);
+            break;
+          case IfcTokenType::STRING:
+          case IfcTokenType::LABEL:
+          case IfcTokenType::ENUM:
+          case IfcTokenType::REAL:
+          case IfcTokenType::INTEGER:
+            if (next + sizeof(uint16_t) > _size) return false;
+            std::memcpy(&token.length, _data + next, sizeof(uint16_t));
+            next += sizeof(uint16_t);
+            if (next + token.length > _size) return false;
+            token.payload = _data + next;
+            next += token.length;
+            break;
+          default:
+            break;
+        }
+        _position = next;
+        return true;
+      }
+
+      // bytes of the range decoded so far
+      size_t Position() const
+      {
+        return _position;
+      }
+
+    private:
+      const uint8_t *_data;
+      size_t _size;
+      size_t _position = 0;
+  };
+
+}
@@ -4,13 +4,16 @@
  
 #include <vector>
 #include <istream>
+#include <algorithm>
+#include <memory>
 #include "IfcTokenStream.h"
+#include "../utility/parallel.h"
 
 namespace webifc::parsing
 {
 
-  IfcTokenStream::IfcTokenStream(const size_t chunkSize, const uint64_t maxChunks) 
-  :  _chunkSize(chunkSize), _maxChunks(maxChunks)
+  IfcTokenStream::IfcTokenStream(const size_t chunkSize, const uint64_t maxChunks, const bool binaryNumbers) 
+  :  _chunkSize(chunkSize), _maxChunks(maxChunks), _binaryNumbers(binaryNumbers)
   { 
     _cChunk=nullptr;
     _fileStream=nullptr;
@@ -18,43 +21,296 @@ namespace webifc::parsing
 
   IfcTokenStream::~IfcTokenStream() 
   {
+    if (!_ownsChunks) return;
+    for (auto &[index, pending] : _prefetches)
+    {
+      IfcTokenChunk loaded = pending.get();
+      loaded.Clear(true);
+    }
+    _prefetches.clear();
     for (size_t i=0; i < _chunks.size();i++)  _chunks[i].Clear(true);
     _chunks.clear();
     std::vector<IfcTokenChunk>().swap(_chunks);
     delete _fileStream;
   }
 
+  namespace
+  {
+    // reads of chunks ahead of the cursor that may be in flight at once
+    constexpr size_t MAX_PREFETCHES = 1;
+
+    // finds safe split points: right after a ';' that is not inside a string or a comment
+    struct LineBoundaryScanner
+    {
+      bool inString = false;
+      bool inComment = false;
+      char last = 0;
+
+      // returns one past the last safe split point in data[0, size), or 0 if there is none
+      size_t Scan(const char *data, const size_t size)
+      {
+        size_t boundary = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+          const char c = data[i];
+          if (inComment) inComment = !(last == '*' && c == '/');
+          else if (inString) inString = c != '\'';
+          else if (c == '\'') inString = true;
+          else if (c == '*' && last == '/')
+          {
+            // the '*' that opens the comment does not also close it, as in "/*/"
+            inComment = true;
+            last = 0;
+            continue;
+          }
+          else if (c == ';') boundary = i + 1;
+          last = c;
+        }
+        return boundary;
+      }
+    };
+  }
+
   void IfcTokenStream::SetTokenSource(const std::function<uint32_t(char *, size_t, size_t)> &requestData) 
   {
       _fileStream = new IfcFileStream(requestData,_chunkSize);
-      size_t tokenOffset=0;
-      while (!_fileStream->IsAtEnd())
+      const size_t threads = _tokenizerThreads == 0 ? utility::GetThreadCount() : _tokenizerThreads;
+      if (threads > 1) tokenizeParallel(requestData, threads);
+      else
       {
-          checkMemory();
-          IfcTokenChunk chunk(_chunkSize,tokenOffset,_fileStream->GetRef(),_fileStream);
-          auto cSize = chunk.TokenSize();
-          tokenOffset+=cSize;
-          if (cSize > _chunkSize) _chunkSize = cSize;
-          _chunks.push_back(chunk);
-          _activeChunks++;
+        size_t tokenOffset=0;
+        while (!_fileStream->IsAtEnd())
+        {
+            checkMemory();
+            IfcTokenChunk chunk(_chunkSize,tokenOffset,_fileStream->GetRef(),_fileStream,_binaryNumbers);
+            tokenOffset+=chunk.TokenSize();
+            appendChunk(chunk);
+            notifyTokenized(_fileStream->GetRef());
+        }
       }
       _cChunk = &_chunks.front();
+      _currentChunk = 0;
+      _readPtr = 0;
       _fileStream->Clear();
   }
 
+  void IfcTokenStream::SetTokenSource(const char *data, const size_t size)
+  {
+      // the data is tokenized in place and must outlive the stream, evicted chunks are reloaded from it
+      _fileStream = new IfcFileStream(data, 0, size, _chunkSize);
+      const size_t threads = _tokenizerThreads == 0 ? utility::GetThreadCount() : _tokenizerThreads;
+      if (threads > 1) tokenizeParallel(data, size, threads);
+      else
+      {
+        size_t tokenOffset=0;
+        while (!_fileStream->IsAtEnd())
+        {
+            checkMemory();
+            IfcTokenChunk chunk(_chunkSize,tokenOffset,_fileStream->GetRef(),_fileStream,_binaryNumbers);
+            tokenOffset+=chunk.TokenSize();
+            appendChunk(chunk);
+            notifyTokenized(_fileStream->GetRef());
+        }
+      }
+      _cChunk = &_chunks.front();
+      _currentChunk = 0;
+      _readPtr = 0;
+      _fileStream->Clear();
+  }
+
+  void IfcTokenStream::SetTokenSource(const std::shared_ptr<IfcCompressedFile> &compressedFile)
+  {
+      _compressedFile = compressedFile;
+      SetTokenSource([compressedFile](char *dest, size_t sourceOffset, size_t destSize) { return compressedFile->Read(dest, sourceOffset, destSize); });
+  }
+
+  void IfcTokenStream::SetTapeSource(const uint8_t *tape, const std::vector<uint64_t> &chunkSizes)
+  {
+      // the tape must outlive the stream, chunks are copied from it when they are first read
+      size_t tokenOffset = 0;
+      for (const uint64_t size : chunkSizes)
+      {
+        _chunks.emplace_back(tokenOffset, tape + tokenOffset, size);
+        tokenOffset += size;
+      }
+      if (_chunks.empty()) _chunks.emplace_back(_chunkSize,0,0,nullptr);
+      _cChunk = &_chunks.front();
+      _currentChunk = 0;
+      _readPtr = 0;
+  }
+
+  void IfcTokenStream::WriteTape(const std::function<void(char *, size_t)> &outputData)
+  {
+      for (size_t i = 0; i < _chunks.size(); i++)
+      {
+        selectChunk(i);
+        if (!_cChunk->IsLoaded()) loadCurrentChunk();
+        if (_cChunk->TokenSize() > 0) outputData((char *)_cChunk->GetData(), _cChunk->TokenSize());
+      }
+      MoveTo(0);
+  }
+
+  std::vector<uint64_t> IfcTokenStream::GetChunkSizes()
+  {
+      std::vector<uint64_t> sizes;
+      sizes.reserve(_chunks.size());
+      for (auto &chunk : _chunks) sizes.push_back(chunk.TokenSize());
+      return sizes;
+  }
+
+  void IfcTokenStream::tokenizeParallel(const std::function<uint32_t(char *, size_t, size_t)> &requestData, const size_t threads)
+  {
+      // the file is read on this thread (the data source may not be callable from workers) and cut into segments that
+      // can be tokenized independently
+      LineBoundaryScanner scanner;
+      std::vector<char> carry;
+      size_t carryRef = 0;
+      size_t fileOffset = 0;
+      bool atEnd = false;
+      tokenizeSegments([&](IfcTokenSegment &segment)
+      {
+        while (!atEnd)
+        {
+          segment.fileStartRef = carryRef;
+          segment.storage.swap(carry);
+          carry.clear();
+          size_t boundary = 0;
+          while (boundary == 0)
+          {
+            const size_t scanned = segment.storage.size();
+            segment.storage.resize(scanned + _chunkSize);
+            const size_t read = requestData(segment.storage.data() + scanned, fileOffset, _chunkSize);
+            segment.storage.resize(scanned + read);
+            fileOffset += read;
+            if (read == 0)
+            {
+              atEnd = true;
+              boundary = segment.storage.size();
+              break;
+            }
+            const size_t found = scanner.Scan(segment.storage.data() + scanned, read);
+            if (found != 0) boundary = scanned + found;
+          }
+          carry.assign(segment.storage.begin() + boundary, segment.storage.end());
+          segment.storage.resize(boundary);
+          segment.data = segment.storage.data();
+          segment.size = boundary;
+          carryRef = segment.fileStartRef + boundary;
+          if (segment.size > 0) return true;
+        }
+        return false;
+      }, threads);
+      // leave the shared stream where the sequential path leaves it, chunk reloads then always reposition it
+      _fileStream->Go(fileOffset);
+  }
+
+  void IfcTokenStream::tokenizeParallel(const char *data, const size_t size, const size_t threads)
+  {
+      LineBoundaryScanner scanner;
+      size_t segmentStart = 0;
+      size_t scanned = 0;
+      tokenizeSegments([&](IfcTokenSegment &segment)
+      {
+        if (segmentStart >= size) return false;
+        size_t boundary = 0;
+        while (boundary == 0)
+        {
+          const size_t scanEnd = std::min(size, scanned + _chunkSize);
+          if (scanned == scanEnd)
+          {
+            boundary = size;
+            break;
+          }
+          const size_t found = scanner.Scan(data + scanned, scanEnd - scanned);
+          if (found != 0) boundary = scanned + found;
+          scanned = scanEnd;
+        }
+        segment.data = data + segmentStart;
+        segment.fileStartRef = segmentStart;
+        segment.size = boundary - segmentStart;
+        segmentStart = boundary;
+        return true;
+      }, threads);
+      _fileStream->Go(size);
+  }
+
+  void IfcTokenStream::tokenizeSegments(const std::function<bool(IfcTokenSegment &)> &nextSegment, const size_t threads)
+  {
+      // appendChunk grows _chunkSize on this thread while the workers tokenize
+      const size_t chunkSize = _chunkSize;
+      size_t tokenOffset = 0;
+      utility::ParallelPipeline<IfcTokenSegment>(threads, threads * 2, nextSegment, [&](IfcTokenSegment &segment)
+      {
+        IfcFileStream stream(segment.data, segment.fileStartRef, segment.fileStartRef + segment.size, chunkSize);
+        stream.Go(segment.fileStartRef);
+        size_t segmentOffset = 0;
+        while (!stream.IsAtEnd())
+        {
+          IfcTokenChunk chunk(chunkSize, segmentOffset, stream.GetRef(), &stream, _binaryNumbers);
+          segmentOffset += chunk.TokenSize();
+          segment.chunks.push_back(chunk);
+        }
+      }, [&](IfcTokenSegment &segment)
+      {
+        // the segments come back in file order, token offsets continue from the previous segment
+        for (auto &chunk : segment.chunks)
+        {
+          checkMemory();
+          chunk.Rebase(tokenOffset, _fileStream);
+          tokenOffset += chunk.TokenSize();
+          appendChunk(chunk);
+        }
+        segment.chunks.clear();
+        notifyTokenized(segment.fileStartRef + segment.size);
+      });
+  }
+
+  void IfcTokenStream::appendChunk(IfcTokenChunk &chunk)
+  {
+      if (chunk.TokenSize() > _chunkSize) _chunkSize = chunk.TokenSize();
+      chunk.Touch(++_accessTick);
+      _chunks.push_back(chunk);
+      _activeChunks++;
+      // the chunk table may have moved
+      _cChunk = &_chunks[_currentChunk];
+  }
+
+  void IfcTokenStream::SetTokenizedCallback(const std::function<void(size_t)> &tokenized)
+  {
+      _tokenized = tokenized;
+  }
+
+  void IfcTokenStream::SetTokenizerThreads(const size_t threads)
+  {
+      _tokenizerThreads = threads;
+  }
+
+  void IfcTokenStream::notifyTokenized(const size_t fileOffset)
+  {
+      if (!_tokenized) return;
+      // reading may reload evicted chunks through the file stream, the tokenizer continues from where it was
+      const size_t fileRef = _fileStream->GetRef();
+      _tokenized(fileOffset);
+      if (_fileStream->GetRef() != fileRef) _fileStream->Go(fileRef);
+  }
+
   void IfcTokenStream::SetTokenSource(std::istream &requestData)
   { 
-     SetTokenSource([&](char* dest, size_t sourceOffset, size_t destSize) { requestData.seekg(sourceOffset); requestData.read(dest, destSize); return requestData.gcount();});
+     SetTokenSource([&](char* dest, size_t sourceOffset, size_t destSize) { requestData.clear(); requestData.seekg(sourceOffset); requestData.read(dest, destSize); return requestData.gcount();});
   }
   
-  std::string_view IfcTokenStream::ReadString() 
+  std::string_view IfcTokenStream::ReadString(const size_t skip) 
   {
-      if (!_cChunk->IsLoaded()) {
-        checkMemory();
-        _activeChunks++;
-      }
+      if (!_cChunk->IsLoaded()) loadCurrentChunk();
       auto length = _cChunk->Read<uint16_t>(_readPtr);
       Forward(2);
+      if (skip > 0)
+      {
+        // a pushed token may continue in the next chunk after the skipped bytes
+        Forward(skip);
+        if (!_cChunk->IsLoaded()) loadCurrentChunk();
+        length -= skip;
+      }
       if (length > 0) 
       {
         auto str = _cChunk->ReadString(_readPtr,length);
@@ -64,6 +320,14 @@ namespace webifc::parsing
       return "";
   }
   
+  const uint8_t *IfcTokenStream::PinRange(size_t &available)
+  {
+      if (!_cChunk->IsLoaded()) loadCurrentChunk();
+      const uint8_t *data = _cChunk->GetData();
+      available = _cChunk->TokenSize() - std::min(_readPtr, _cChunk->TokenSize());
+      return data + _readPtr;
+  }
+
   void IfcTokenStream::Forward(const size_t size)
   {
       _readPtr+=size;
@@ -75,8 +339,7 @@ namespace webifc::parsing
           return;
         }
         _readPtr -= _cChunk->TokenSize();
-        _currentChunk++;
-        _cChunk = &_chunks[_currentChunk];
+        selectChunk(_currentChunk + 1);
       }
   }
   
@@ -86,44 +349,126 @@ namespace webifc::parsing
       {
         if (_chunks[i].GetTokenRef() <= pos) 
         {
-          _currentChunk = i;
-          _cChunk = &_chunks[_currentChunk];
+          selectChunk(i);
           _readPtr = pos - _cChunk->GetTokenRef();
           break;
         }
       }
   }
   
-  void IfcTokenStream::checkMemory()
+  void IfcTokenStream::ReleaseChunks(const std::vector<uint32_t> &offsets)
+  {
+    // reading a cleared chunk again reloads it, so a line continuing into a released chunk is still read in full
+    size_t next = 0;
+    for (auto &chunk : _chunks)
+    {
+      const size_t start = chunk.GetTokenRef();
+      const size_t end = start + chunk.TokenSize();
+      while (next < offsets.size() && offsets[next] < start) next++;
+      if (next < offsets.size() && offsets[next] < end) continue;
+      if (&chunk == _cChunk || !chunk.IsLoaded() || !chunk.IsReloadable()) continue;
+      if (chunk.Clear()) _activeChunks--;
+    }
+  }
+
+  void IfcTokenStream::checkMemory(const size_t keep)
   {
-    if (_maxChunks != 0 && _activeChunks == _maxChunks){
-      for (uint32_t x = 0; x < _chunks.size(); x++) 
+    // evict the least recently used chunk that can be reloaded from its source
+    if (_maxChunks != 0 && _activeChunks >= _maxChunks){
+      IfcTokenChunk * victim = nullptr;
+      for (size_t i = 0; i < _chunks.size(); i++) 
       {
-        if (_chunks[x].IsLoaded())
-        {
-          if (_chunks[x].Clear())
-          {
-            _activeChunks--;
-            break;
-          }
-        }
+        IfcTokenChunk &chunk = _chunks[i];
+        if (&chunk == _cChunk || i == keep || !chunk.IsLoaded() || !chunk.IsReloadable()) continue;
+        if (victim == nullptr || chunk.LastAccess() < victim->LastAccess()) victim = &chunk;
       }
+      if (victim != nullptr && victim->Clear()) _activeChunks--;
     }
   }
+
+  void IfcTokenStream::loadCurrentChunk()
+  {
+    auto pending = _prefetches.find(_currentChunk);
+    if (pending != _prefetches.end())
+    {
+      // a prefetched chunk was counted as resident when its read started
+      IfcTokenChunk loaded = pending->second.get();
+      _cChunk->Adopt(loaded);
+      _prefetches.erase(pending);
+      return;
+    }
+    checkMemory();
+    _activeChunks++;
+  }
+
+  void IfcTokenStream::selectChunk(const size_t index)
+  {
+    const bool changed = index != _currentChunk || _cChunk != &_chunks[index];
+    _currentChunk = index;
+    _cChunk = &_chunks[index];
+    _cChunk->Touch(++_accessTick);
+    // reading is mostly sequential, so the chunk after the one we just entered is likely needed next
+    if (!changed) return;
+    dropPrefetches(index);
+    prefetch(index + 1);
+  }
+
+  void IfcTokenStream::dropPrefetches(const size_t index)
+  {
+    // reads left behind by a jump cannot be cancelled, they are waited on so their memory is returned now
+    for (auto it = _prefetches.begin(); it != _prefetches.end();)
+    {
+      if (it->first == index || it->first == index + 1)
+      {
+        it++;
+        continue;
+      }
+      IfcTokenChunk loaded = it->second.get();
+      loaded.Clear(true);
+      _activeChunks--;
+      it = _prefetches.erase(it);
+    }
+  }
+
+  void IfcTokenStream::prefetch(const size_t index)
+  {
+#ifdef WEBIFC_THREADS_ENABLED
+    if (_maxChunks == 0 || _fileStream == nullptr || index >= _chunks.size()) return;
+    IfcTokenChunk &chunk = _chunks[index];
+    if (chunk.IsLoaded() || !chunk.IsReloadable() || _prefetches.contains(index) || _prefetches.size() >= MAX_PREFETCHES) return;
+    // the chunk is counted against the memory limit before it is read, a prefetch never goes past the limit. The chunk
+    // just left is kept, a string read from it may still be in use
+    checkMemory(index > 1 ? index - 2 : SIZE_MAX);
+    if (_activeChunks >= _maxChunks) return;
+    _activeChunks++;
+    // the raw bytes are fetched on this thread, only memory sources are shared with the worker as they are
+    auto storage = std::make_shared<std::vector<char>>();
+    const size_t start = chunk.GetFileStartRef();
+    const std::string_view source = _fileStream->Share(start, chunk.GetFileEndRef(), *storage);
+    IfcTokenChunk detached = chunk;
+    _prefetches.emplace(index, std::async(std::launch::async, [detached, storage, source, start]() mutable
+    {
+      IfcFileStream stream(source.data(), start, start + source.size(), source.size());
+      detached.LoadFrom(&stream);
+      return detached;
+    }));
+#else
+    (void)index;
+#endif
+  }
   
   void IfcTokenStream::Push(void *v, const size_t size)
   {
       if (_chunks.empty())
       {
-        _chunks.emplace_back(_chunkSize,0,0,_fileStream);
+        _chunks.emplace_back(_chunkSize,0,0,nullptr);
         _activeChunks++;
       }
       if ( _chunks.back().TokenSize() + size > _chunks.back().GetMaxSize())
       {
+        // pushed tokens have no file source to reload them from, so these chunks are never evicted
         checkMemory();
-        size_t fsRef = 0;
-        if (_fileStream !=nullptr) fsRef = _fileStream->GetRef();
-        _chunks.emplace_back(_chunkSize,_chunks.back().GetTokenRef() + _chunks.back().TokenSize(),fsRef,_fileStream);
+        _chunks.emplace_back(_chunkSize,_chunks.back().GetTokenRef() + _chunks.back().TokenSize(),0,nullptr);
         _activeChunks++;
       }
       _chunks.back().Push(v,size);
@@ -135,13 +480,31 @@ namespace webifc::parsing
     return _chunks.back().TokenSize() + _chunks.back().GetTokenRef();
   }
   
+  void IfcTokenStream::AddMemoryStats(utility::MemoryStats &stats)
+  {
+    for (auto &chunk : _chunks)
+    {
+      if (chunk.IsLoaded())
+      {
+        stats.loadedChunks++;
+        stats.loadedChunkBytes += chunk.GetMaxSize();
+      }
+      else
+      {
+        stats.evictedChunks++;
+        stats.evictedChunkBytes += chunk.TokenSize();
+      }
+    }
+    if (_compressedFile) stats.fileBytes += _compressedFile->GetMemorySize();
+  }
+
   void IfcTokenStream::Back()
   {
       if (_readPtr == 0 ) 
       {
         if (_currentChunk > 0) 
         {
-          _cChunk = &_chunks[--_currentChunk];
+          selectChunk(_currentChunk - 1);
           _readPtr=_cChunk->TokenSize()-1;
           return;
         }
@@ -160,11 +523,48 @@ namespace webifc::parsing
   }
 
   IfcTokenStream * IfcTokenStream::Clone() {
-    IfcTokenStream * newStream = new IfcTokenStream(_activeChunks,_maxChunks,_chunks,_fileStream->Clone());
+    // the chunks share their data with this stream, only chunks either stream pushes to are copied then, reloads of
+    // the clone go through its own file stream
+    IfcTokenStream * newStream = new IfcTokenStream(_activeChunks,_maxChunks,_chunks,_fileStream == nullptr ? nullptr : _fileStream->Clone());
+    newStream->_chunkSize = _chunkSize;
+    newStream->_binaryNumbers = _binaryNumbers;
+    newStream->_tokenizerThreads = _tokenizerThreads;
+    newStream->_compressedFile = _compressedFile;
+    for (auto &chunk : newStream->_chunks)
+    {
+      if (chunk.IsReloadable() && newStream->_fileStream != nullptr) chunk.Rebase(chunk.GetTokenRef(), newStream->_fileStream);
+    }
     return newStream;
   }
 
-  IfcTokenStream::IfcTokenStream(size_t activeChunks, uint64_t maxChunks, std::vector<IfcTokenStream::IfcTokenChunk> &chunks,IfcTokenStream::IfcFileStream * fileStream) : _activeChunks(activeChunks), _maxChunks(maxChunks), _chunks(chunks),  _cChunk(&chunks[0]), _fileStream(fileStream)
+  bool IfcTokenStream::LoadAll()
+  {
+    if (_chunks.empty()) return true;
+    if (_maxChunks != 0 && _chunks.size() > _maxChunks) return false;
+    const size_t readOffset = GetReadOffset();
+    for (size_t i = 0; i < _chunks.size(); i++)
+    {
+      selectChunk(i);
+      if (!_cChunk->IsLoaded()) 
+      {
+        loadCurrentChunk();
+        _cChunk->GetData();
+      }
+    }
+    MoveTo(readOffset);
+    return true;
+  }
+
+  IfcTokenStream * IfcTokenStream::CreateReadView()
+  {
+    // the chunk copies share their data with this stream, with no file stream and no memory limit nothing is ever
+    // loaded, evicted or prefetched through them
+    IfcTokenStream * view = new IfcTokenStream(_activeChunks,0,_chunks,nullptr);
+    view->_ownsChunks = false;
+    return view;
+  }
+
+  IfcTokenStream::IfcTokenStream(size_t activeChunks, uint64_t maxChunks, std::vector<IfcTokenStream::IfcTokenChunk> &chunks,IfcTokenStream::IfcFileStream * fileStream) : _activeChunks(activeChunks), _maxChunks(maxChunks), _chunks(chunks),  _cChunk(_chunks.empty() ? nullptr : &_chunks[0]), _fileStream(fileStream)
   {}
 
 }
\ No newline at end of file
@@ -8,9 +8,14 @@
 #include <istream>
 #include <iostream>
 #include <functional>
+#include <future>
+#include <memory>
+#include <unordered_map>
 #include <string_view>
 #include <cstring>
 #include <cstdint>
+#include "../utility/memory.h"
+#include "IfcCompressedFile.h"
  
 namespace webifc::parsing
 {
@@ -34,16 +39,26 @@ namespace webifc::parsing
   class IfcTokenStream 
   {
       public:
-        IfcTokenStream(const size_t chunkSize, const uint64_t maxChunks);
+        // with binaryNumbers, REAL and INTEGER payloads start with the value as a double or int64_t, followed by the text
+        IfcTokenStream(const size_t chunkSize, const uint64_t maxChunks, const bool binaryNumbers = false);
         ~IfcTokenStream();
+        // called while a source is tokenized, every time tokens are appended, with the file offset up to which the file is
+        // tokenized, the tokens so far can be read from it as long as the read position is restored with MoveTo afterwards
+        void SetTokenizedCallback(const std::function<void(size_t)> &tokenized);
+        // threads that tokenize the sources set from now on, 0 takes one per hardware thread and 1, the default, tokenizes
+        // on the calling thread only. The tape is the same for any number of threads
+        void SetTokenizerThreads(const size_t threads);
         void SetTokenSource(const std::function<uint32_t(char *, size_t, size_t)> &requestData);
         void SetTokenSource(std::istream &requestData);
+        void SetTokenSource(const char *data, const size_t size);
+        // the file is inflated while it is tokenized and kept by the stream, evicted chunks are inflated again from it
+        void SetTokenSource(const std::shared_ptr<IfcCompressedFile> &compressedFile);
+        void SetTapeSource(const uint8_t *tape, const std::vector<uint64_t> &chunkSizes);
+        void WriteTape(const std::function<void(char *, size_t)> &outputData);
+        std::vector<uint64_t> GetChunkSizes();
         template <typename T> T Read()
         {
-          if (!_cChunk->IsLoaded()) {
-            checkMemory();
-            _activeChunks++;
-          }
+          if (!_cChunk->IsLoaded()) loadCurrentChunk();
           T v =  _cChunk->Read<T>(_readPtr);
           Forward(sizeof(T));
           return v;
@@ -54,29 +69,61 @@ namespace webifc::parsing
         }
         void Push(void *v, const size_t size);
         void Forward(const size_t size);
-        std::string_view ReadString();
+        // the tokens of the current chunk from the read position on, available is set to how many bytes there are. The
+        // range stays valid until the stream moves to another chunk or is pushed to, as the current chunk is never evicted
+        const uint8_t *PinRange(size_t &available);
+        // skip leaves out the first bytes of the payload, the value in front of the text of a binary number
+        std::string_view ReadString(const size_t skip = 0);
         void Back();
         bool IsAtEnd();
         void MoveTo(const size_t pos);
         size_t GetReadOffset();
         size_t GetTotalSize();
+        void AddMemoryStats(utility::MemoryStats &stats);
         IfcTokenStream * Clone();
+        // loads every chunk, fails when the memory limit does not allow all of them to be resident at once
+        bool LoadAll();
+        // a cursor of its own over the chunks of this stream, it can be read from another thread while nothing is
+        // pushed or evicted, so LoadAll must have succeeded first and the view must not outlive this stream
+        IfcTokenStream * CreateReadView();
+        // clears every chunk that holds none of the sorted tape offsets and can be reloaded from its source
+        void ReleaseChunks(const std::vector<uint32_t> &offsets);
 
       private:
-        void checkMemory();
+        // keep is the index of a chunk that is not evicted besides the current one
+        void checkMemory(const size_t keep = SIZE_MAX);
+        void notifyTokenized(const size_t fileOffset);
+        std::function<void(size_t)> _tokenized;
+        void loadCurrentChunk();
+        void selectChunk(const size_t index);
+        void prefetch(const size_t index);
+        void dropPrefetches(const size_t index);
+        struct IfcTokenSegment;
+        void tokenizeParallel(const std::function<uint32_t(char *, size_t, size_t)> &requestData, const size_t threads);
+        void tokenizeParallel(const char *data, const size_t size, const size_t threads);
+        // tokenizes the segments nextSegment gives until it returns false on up to `threads` threads, in file order
+        void tokenizeSegments(const std::function<bool(IfcTokenSegment &)> &nextSegment, const size_t threads);
         size_t _readPtr = 0;
       	size_t _currentChunk = 0;
         size_t _activeChunks = 0;
+        uint64_t _accessTick = 0;
         size_t _chunkSize;
         uint64_t _maxChunks;
+        bool _ownsChunks = true;
+        bool _binaryNumbers = false;
+        size_t _tokenizerThreads = 1;
         class IfcFileStream
         {
           public:
             IfcFileStream(const std::function<uint32_t(char *, size_t, size_t)> &requestData, const uint32_t size);
+            IfcFileStream(const char *data, const size_t dataStartRef, const size_t dataEndRef, const uint32_t size);
             ~IfcFileStream();
             void Go(const uint32_t ref);
             void Forward();
             void Back();
+            void SkipWhitespace();
+            void ReadUntil(const char delimiter, std::vector<char> &output);
+            std::string_view Share(const size_t start, const size_t end, std::vector<char> &storage);
             size_t GetRef();
             char Next();
             char Prev();
@@ -87,9 +134,13 @@ namespace webifc::parsing
           private:
             void load();
             std::function<uint32_t(char *, size_t, size_t)> _dataSource;
+            // memory sources are read in place, _buffer is then a window into _memory
+            const char * _memory = nullptr;
+            size_t _memoryStartRef = 0;
+            size_t _memoryEndRef = 0;
             size_t _pointer=0;
             size_t _size;
-            char prev;
+            char prev = 0;
             size_t _currentSize=0;
             size_t _startRef=0;
             char * _buffer; 
@@ -97,7 +148,8 @@ namespace webifc::parsing
         class IfcTokenChunk
         {
             public:
-            	IfcTokenChunk(const size_t chunkSize, const size_t startRef, const size_t fileStartRef, IfcTokenStream::IfcFileStream *_fileStream);
+            	IfcTokenChunk(const size_t chunkSize, const size_t startRef, const size_t fileStartRef, IfcTokenStream::IfcFileStream *_fileStream, const bool binaryNumbers = false);
+              IfcTokenChunk(const size_t startRef, const uint8_t *tapeData, const size_t size);
               bool Clear(bool force);
               bool Clear();
               bool IsLoaded();
@@ -105,12 +157,21 @@ namespace webifc::parsing
               size_t GetTokenRef();
               void Push(void *v, const size_t size);
               size_t GetMaxSize();
+              void Rebase(const size_t startRef, IfcTokenStream::IfcFileStream *fileStream);
+              bool IsReloadable();
+              void Touch(const uint64_t tick);
+              uint64_t LastAccess();
+              size_t GetFileStartRef();
+              size_t GetFileEndRef();
+              void LoadFrom(IfcTokenStream::IfcFileStream *fileStream);
+              void Adopt(IfcTokenChunk &loaded);
+              const uint8_t * GetData();
               std::string_view ReadString(const size_t ptr,const size_t size); 
               template <typename T> T Read(const size_t ptr)
               {
                 if (!_loaded) Load();
                 T v;
-                std::memcpy(&v, _chunkData+ptr, sizeof(T));
+                std::memcpy(&v, _chunkData.get()+ptr, sizeof(T));
                 return v;
               }
               template <typename T> void Push(T input)
@@ -123,14 +184,31 @@ namespace webifc::parsing
               size_t _currentSize=0;
               size_t _startRef=0;
               size_t _fileStartRef;
+              size_t _fileEndRef=0;
+              uint64_t _lastAccess=0;
+              bool _binaryNumbers;
               size_t _chunkSize;
-            	uint8_t *_chunkData;
+              // shared with the chunks of clones and read views, Push copies it first while it is shared
+            	std::shared_ptr<uint8_t[]> _chunkData;
               IfcFileStream *_fileStream;
+              // chunks of a tape snapshot are copied from it instead of being tokenized
+              const uint8_t *_tapeData = nullptr;
         };
-        IfcTokenStream(size_t activeChunks, uint64_t maxChunks, std::vector<IfcTokenChunk> &chunks,IfcFileStream * fileStream);
+        struct IfcTokenSegment
+        {
+          const char *data = nullptr;
+          size_t fileStartRef = 0;
+          size_t size = 0;
+          std::vector<char> storage;
+          std::vector<IfcTokenChunk> chunks;
+        };
+                IfcTokenStream(size_t activeChunks, uint64_t maxChunks, std::vector<IfcTokenChunk> &chunks,IfcFileStream * fileStream);
+        void appendChunk(IfcTokenChunk &chunk);
         std::vector<IfcTokenChunk> _chunks;
+        std::unordered_map<size_t, std::future<IfcTokenChunk>> _prefetches;
         IfcTokenChunk * _cChunk;
         IfcFileStream * _fileStream;
+        std::shared_ptr<IfcCompressedFile> _compressedFile;
   };
   
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Vectorised helpers for the STEP lexer, they process 16 or 32 bytes per step and fall back to a scalar loop
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace webifc::parsing
+{
+
+	inline bool IsStepWhitespace(const char c)
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	// returns the index of the first byte that is not whitespace, or size if there is none
+	inline size_t SkipWhitespace(const char *data, const size_t size)
+	{
+		size_t i = 0;
+#if defined(__AVX2__)
+		const __m256i space = _mm256_set1_epi8(' ');
+		const __m256i newLine = _mm256_set1_epi8('\n');
+		const __m256i carriageReturn = _mm256_set1_epi8('\r');
+		const __m256i tab = _mm256_set1_epi8('\t');
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+			const __m256i whitespace = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, newLine)), _mm256_or_si256(_mm256_cmpeq_epi8(block, carriageReturn), _mm256_cmpeq_epi8(block, tab)));
+			const uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(whitespace));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i newLine = _mm_set1_epi8('\n');
+		const __m128i carriageReturn = _mm_set1_epi8('\r');
+		const __m128i tab = _mm_set1_epi8('\t');
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+			const __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, newLine)), _mm_or_si128(_mm_cmpeq_epi8(block, carriageReturn), _mm_cmpeq_epi8(block, tab)));
+			const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(whitespace)) & 0xFFFF;
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__wasm_simd128__)
+		const v128_t space = wasm_i8x16_splat(' ');
+		const v128_t newLine = wasm_i8x16_splat('\n');
+		const v128_t carriageReturn = wasm_i8x16_splat('\r');
+		const v128_t tab = wasm_i8x16_splat('\t');
+		for (; i + 16 <= size; i += 16)
+		{
+			const v128_t block = wasm_v128_load(data + i);
+			const v128_t whitespace = wasm_v128_or(wasm_v128_or(wasm_i8x16_eq(block, space), wasm_i8x16_eq(block, newLine)), wasm_v128_or(wasm_i8x16_eq(block, carriageReturn), wasm_i8x16_eq(block, tab)));
+			const uint32_t mask = ~static_cast<uint32_t>(wasm_i8x16_bitmask(whitespace)) & 0xFFFF;
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			if (!IsStepWhitespace(data[i])) return i;
+		}
+		return size;
+	}
+
+	// returns the index of the first occurrence of value, or size if there is none
+	inline size_t FindByte(const char *data, const size_t size, const char value)
+	{
+		size_t i = 0;
+#if defined(__AVX2__)
+		const __m256i needle = _mm256_set1_epi8(value);
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+			const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		const __m128i needle = _mm_set1_epi8(value);
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+			const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__wasm_simd128__)
+		const v128_t needle = wasm_i8x16_splat(value);
+		for (; i + 16 <= size; i += 16)
+		{
+			const uint32_t mask = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(data + i), needle));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			if (data[i] == value) return i;
+		}
+		return size;
+	}
+
+	// true for the bytes that make a STEP string need decoding, the apostrophe doubled inside strings, the backslash of
+	// the escapes and the terminating zero the decoder stops at, other bytes are copied as they are
+	inline bool IsStringEscape(const char c)
+	{
+		return c == '\\' || c == '\'' || c == 0;
+	}
+
+	// returns the index of the first byte IsStringEscape is true for, or size if there is none
+	inline size_t FindStringEscape(const char *data, const size_t size)
+	{
+		size_t i = 0;
+#if defined(__AVX2__)
+		const __m256i backslash = _mm256_set1_epi8('\\');
+		const __m256i apostrophe = _mm256_set1_epi8('\'');
+		const __m256i zero = _mm256_setzero_si256();
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+			const __m256i escape = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, backslash), _mm256_cmpeq_epi8(block, apostrophe)), _mm256_cmpeq_epi8(block, zero));
+			const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(escape));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i apostrophe = _mm_set1_epi8('\'');
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+			const __m128i escape = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, backslash), _mm_cmpeq_epi8(block, apostrophe)), _mm_cmpeq_epi8(block, zero));
+			const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(escape));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__wasm_simd128__)
+		const v128_t backslash = wasm_i8x16_splat('\\');
+		const v128_t apostrophe = wasm_i8x16_splat('\'');
+		const v128_t zero = wasm_i8x16_splat(0);
+		for (; i + 16 <= size; i += 16)
+		{
+			const v128_t block = wasm_v128_load(data + i);
+			const v128_t escape = wasm_v128_or(wasm_v128_or(wasm_i8x16_eq(block, backslash), wasm_i8x16_eq(block, apostrophe)), wasm_i8x16_eq(block, zero));
+			const uint32_t mask = wasm_i8x16_bitmask(escape);
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			if (IsStringEscape(data[i])) return i;
+		}
+		return size;
+	}
+
+	// true for the bytes p21encode has to encode, everything outside printable ASCII and the apostrophe it doubles
+	inline bool NeedsStepEncoding(const char c)
+	{
+		return c > 126 || c < 32 || c == '\'';
+	}
+
+	// returns the index of the first byte NeedsStepEncoding is true for, or size if there is none. Bytes are compared
+	// signed so the bytes of UTF-8 sequences are below 32 like they are for NeedsStepEncoding
+	inline size_t FindStepEncoding(const char *data, const size_t size)
+	{
+		size_t i = 0;
+#if defined(__AVX2__)
+		const __m256i low = _mm256_set1_epi8(32);
+		const __m256i high = _mm256_set1_epi8(126);
+		const __m256i apostrophe = _mm256_set1_epi8('\'');
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+			const __m256i encoded = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi8(low, block), _mm256_cmpgt_epi8(block, high)), _mm256_cmpeq_epi8(block, apostrophe));
+			const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(encoded));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		const __m128i low = _mm_set1_epi8(32);
+		const __m128i high = _mm_set1_epi8(126);
+		const __m128i apostrophe = _mm_set1_epi8('\'');
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+			const __m128i encoded = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(block, low), _mm_cmpgt_epi8(block, high)), _mm_cmpeq_epi8(block, apostrophe));
+			const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(encoded));
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#elif defined(__wasm_simd128__)
+		const v128_t low = wasm_i8x16_splat(32);
+		const v128_t high = wasm_i8x16_splat(126);
+		const v128_t apostrophe = wasm_i8x16_splat('\'');
+		for (; i + 16 <= size; i += 16)
+		{
+			const v128_t block = wasm_v128_load(data + i);
+			const v128_t encoded = wasm_v128_or(wasm_v128_or(wasm_i8x16_lt(block, low), wasm_i8x16_gt(block, high)), wasm_i8x16_eq(block, apostrophe));
+			const uint32_t mask = wasm_i8x16_bitmask(encoded);
+			if (mask != 0) return i + std::countr_zero(mask);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			if (NeedsStepEncoding(data[i])) return i;
+		}
+		return size;
+	}
+
+}
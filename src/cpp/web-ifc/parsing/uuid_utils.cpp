@@ -72,6 +72,24 @@ namespace webifc::parsing {
 	}
 
 
+	bool decodeIfcGuid(const std::string_view &guid, uint64_t &high, uint64_t &low)
+	{
+		if (guid.size() != 22) return false;
+		high = 0;
+		low = 0;
+		for (size_t i = 0; i < 22; i++)
+		{
+			const uint8_t c = (uint8_t)guid[i];
+			const int8_t value = c < 128 ? base64mask[c] : -1;
+			// the first character holds the 2 bits above the 126 of the others
+			if (value < 0 || (i == 0 && value > 3)) return false;
+			const int bits = i == 0 ? 2 : 6;
+			high = (high << bits) | (low >> (64 - bits));
+			low = (low << bits) | (uint64_t)value;
+		}
+		return true;
+	}
+
 	std::string compressIfcGuid(const std::string& guid)
 	{
 		std::string temp;
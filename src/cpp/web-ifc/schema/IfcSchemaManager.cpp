@@ -2,34 +2,77 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
-#include <vector>
+#include <array>
+#include <cstddef>
 #include <string_view>
-#include <unordered_set>
 #include "IfcSchemaManager.h"
 
 namespace webifc::schema {
-   
-    IfcSchemaManager::IfcSchemaManager() : _crcTable(256)
+
+    namespace
     {
-        uint32_t c;
-        for (uint32_t n = 0; n < 256; n++) {
-            c = n;
-            for (uint32_t k = 0; k < 8; k++) {
-                c = ((c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1));
+        // the type codes are the CRC32 of the upper case names, computed with slicing by 8: table k advances the CRC of a
+        // byte by k more bytes, so eight bytes are folded in per step
+        using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+        constexpr CrcTables makeCrcTables()
+        {
+            CrcTables tables{};
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (uint32_t k = 0; k < 8; k++) {
+                    c = ((c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1));
+                }
+                tables[0][n] = c;
             }
-            _crcTable[n] = c;
+            for (uint32_t n = 0; n < 256; n++) {
+                for (uint32_t k = 1; k < 8; k++) {
+                    tables[k][n] = (tables[k - 1][n] >> 8) ^ tables[0][tables[k - 1][n] & 0xFF];
+                }
+            }
+            return tables;
         }
-        initSchemaData();
-    }
 
-    std::string_view IfcSchemaManager::GetSchemaName(IFC_SCHEMA schema)  const
-    {
-        return _schemaNames[schema];
-    }
+        constexpr CrcTables CRC_TABLES = makeCrcTables();
 
-    const std::vector<IFC_SCHEMA> IfcSchemaManager::GetAvailableSchemas() const
+        constexpr uint32_t readUint32(const uint8_t *u)
+        {
+            return uint32_t(u[0]) | (uint32_t(u[1]) << 8) | (uint32_t(u[2]) << 16) | (uint32_t(u[3]) << 24);
+        }
+
+        constexpr uint32_t crc32(const uint8_t *u, size_t len)
+        {
+            uint32_t c = 0 ^ 0xFFFFFFFF;
+            for (; len >= 8; len -= 8, u += 8)
+            {
+                const uint32_t first = readUint32(u) ^ c;
+                const uint32_t second = readUint32(u + 4);
+                c = CRC_TABLES[7][first & 0xFF] ^ CRC_TABLES[6][(first >> 8) & 0xFF] ^ CRC_TABLES[5][(first >> 16) & 0xFF] ^ CRC_TABLES[4][first >> 24] ^
+                    CRC_TABLES[3][second & 0xFF] ^ CRC_TABLES[2][(second >> 8) & 0xFF] ^ CRC_TABLES[1][(second >> 16) & 0xFF] ^ CRC_TABLES[0][second >> 24];
+            }
+            for (; len > 0; len--, u++)
+            {
+                c = CRC_TABLES[0][(c ^ *u) & 0xFF] ^ (c >> 8);
+            }
+            return c ^ 0xFFFFFFFF;
+        }
+
+        constexpr uint32_t crc32(std::string_view name)
+        {
+            std::array<uint8_t, 64> bytes{};
+            for (size_t i = 0; i < name.size(); i++) bytes[i] = static_cast<uint8_t>(name[i]);
+            return crc32(bytes.data(), name.size());
+        }
+
+        // the generated codes, with names of every length modulo 8
+        static_assert(crc32("IFCWALL") == IFCWALL);
+        static_assert(crc32("IFCCARTESIANPOINT") == IFCCARTESIANPOINT);
+        static_assert(crc32("IFCRELDEFINESBYPROPERTIES") == IFCRELDEFINESBYPROPERTIES);
+        static_assert(crc32("IFCPOLYLOOP") == IFCPOLYLOOP);
+    }
+   
+    IfcSchemaManager::IfcSchemaManager()
     {
-        return _schemas;
     }
 
     uint32_t IfcSchemaManager::IfcTypeToTypeCode(std::string_view name) const
@@ -39,23 +82,7 @@ namespace webifc::schema {
  
     uint32_t IfcSchemaManager::IfcTypeToTypeCode(const void * name, size_t len) const
     {
-        uint32_t c = 0 ^ 0xFFFFFFFF;
-        const uint8_t* u = static_cast<const uint8_t*>(name);
-        for (size_t i = 0; i < len; ++i)
-        {
-            c = _crcTable[(c ^ u[i]) & 0xFF] ^ (c >> 8);
-        }
-        return c ^ 0xFFFFFFFF;
-    }
-
-    bool IfcSchemaManager::IsIfcElement(uint32_t typeCode) const
-    {
-        return _ifcElements.find(typeCode) != _ifcElements.end();
-    }
-
-    const std::unordered_set<uint32_t> & IfcSchemaManager::GetIfcElementList() const
-    {
-        return _ifcElements;
+        return crc32(static_cast<const uint8_t*>(name), len);
     }
   
 }
\ No newline at end of file
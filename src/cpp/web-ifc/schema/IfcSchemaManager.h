@@ -6,13 +6,15 @@
 
 #include "ifc-schema.h"
 #include <vector>
+#include <span>
 #include <string>
 #include <string_view>
-#include <unordered_set>
 #include <cstdint>
 
 
 namespace webifc::schema {
+    // the schema tables are generated as constant data in schema-functions.cpp, so a manager holds no state and costs
+    // nothing to construct
     class IfcSchemaManager {
         public:
             IfcSchemaManager();
@@ -21,13 +23,9 @@ namespace webifc::schema {
             uint32_t IfcTypeToTypeCode(const std::string_view name) const;
             std::string IfcTypeCodeToType(const uint32_t typeCode) const; 
             bool IsIfcElement(const uint32_t typeCode) const;
-            const std::unordered_set<uint32_t> & GetIfcElementList() const;
+            // sorted by type code
+            std::span<const uint32_t> GetIfcElementList() const;
         private: 
-            std::vector<uint32_t> _crcTable;
-            std::unordered_set<uint32_t> _ifcElements;
-            std::vector<IFC_SCHEMA> _schemas;
-            std::vector<std::string_view> _schemaNames;
-            void initSchemaData();
             uint32_t IfcTypeToTypeCode(const void * name, const size_t len) const;
     };
 }
\ No newline at end of file
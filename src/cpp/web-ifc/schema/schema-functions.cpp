@@ -1,250 +1,271 @@
-#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "ifc-schema.h"
 #include "IfcSchemaManager.h"
 namespace webifc::schema {
-void IfcSchemaManager::initSchemaData() {
-_ifcElements.insert(IFCPRODUCT);
-_ifcElements.insert(IFCPROXY);
-_ifcElements.insert(IFCSPATIALSTRUCTUREELEMENT);
-_ifcElements.insert(IFCSTRUCTURALACTIVITY);
-_ifcElements.insert(IFCSTRUCTURALITEM);
-_ifcElements.insert(IFCSTRUCTURALMEMBER);
-_ifcElements.insert(IFCSTRUCTURALREACTION);
-_ifcElements.insert(IFCSTRUCTURALSURFACEMEMBER);
-_ifcElements.insert(IFCSTRUCTURALSURFACEMEMBERVARYING);
-_ifcElements.insert(IFCANNOTATION);
-_ifcElements.insert(IFCBUILDING);
-_ifcElements.insert(IFCBUILDINGSTOREY);
-_ifcElements.insert(IFCELEMENT);
-_ifcElements.insert(IFCELEMENTASSEMBLY);
-_ifcElements.insert(IFCELEMENTCOMPONENT);
-_ifcElements.insert(IFCEQUIPMENTELEMENT);
-_ifcElements.insert(IFCFASTENER);
-_ifcElements.insert(IFCFEATUREELEMENT);
-_ifcElements.insert(IFCFEATUREELEMENTADDITION);
-_ifcElements.insert(IFCFEATUREELEMENTSUBTRACTION);
-_ifcElements.insert(IFCFURNISHINGELEMENT);
-_ifcElements.insert(IFCGRID);
-_ifcElements.insert(IFCMECHANICALFASTENER);
-_ifcElements.insert(IFCOPENINGELEMENT);
-_ifcElements.insert(IFCPORT);
-_ifcElements.insert(IFCPROJECTIONELEMENT);
-_ifcElements.insert(IFCSITE);
-_ifcElements.insert(IFCSPACE);
-_ifcElements.insert(IFCSTRUCTURALACTION);
-_ifcElements.insert(IFCSTRUCTURALCONNECTION);
-_ifcElements.insert(IFCSTRUCTURALCURVECONNECTION);
-_ifcElements.insert(IFCSTRUCTURALCURVEMEMBER);
-_ifcElements.insert(IFCSTRUCTURALCURVEMEMBERVARYING);
-_ifcElements.insert(IFCSTRUCTURALLINEARACTION);
-_ifcElements.insert(IFCSTRUCTURALLINEARACTIONVARYING);
-_ifcElements.insert(IFCSTRUCTURALPLANARACTION);
-_ifcElements.insert(IFCSTRUCTURALPLANARACTIONVARYING);
-_ifcElements.insert(IFCSTRUCTURALPOINTACTION);
-_ifcElements.insert(IFCSTRUCTURALPOINTCONNECTION);
-_ifcElements.insert(IFCSTRUCTURALPOINTREACTION);
-_ifcElements.insert(IFCSTRUCTURALSURFACECONNECTION);
-_ifcElements.insert(IFCTRANSPORTELEMENT);
-_ifcElements.insert(IFCVIRTUALELEMENT);
-_ifcElements.insert(IFCBUILDINGELEMENT);
-_ifcElements.insert(IFCBUILDINGELEMENTCOMPONENT);
-_ifcElements.insert(IFCBUILDINGELEMENTPART);
-_ifcElements.insert(IFCBUILDINGELEMENTPROXY);
-_ifcElements.insert(IFCCOLUMN);
-_ifcElements.insert(IFCCOVERING);
-_ifcElements.insert(IFCCURTAINWALL);
-_ifcElements.insert(IFCDISCRETEACCESSORY);
-_ifcElements.insert(IFCDISTRIBUTIONELEMENT);
-_ifcElements.insert(IFCDISTRIBUTIONFLOWELEMENT);
-_ifcElements.insert(IFCDISTRIBUTIONPORT);
-_ifcElements.insert(IFCDOOR);
-_ifcElements.insert(IFCEDGEFEATURE);
-_ifcElements.insert(IFCELECTRICALELEMENT);
-_ifcElements.insert(IFCENERGYCONVERSIONDEVICE);
-_ifcElements.insert(IFCFLOWCONTROLLER);
-_ifcElements.insert(IFCFLOWFITTING);
-_ifcElements.insert(IFCFLOWMOVINGDEVICE);
-_ifcElements.insert(IFCFLOWSEGMENT);
-_ifcElements.insert(IFCFLOWSTORAGEDEVICE);
-_ifcElements.insert(IFCFLOWTERMINAL);
-_ifcElements.insert(IFCFLOWTREATMENTDEVICE);
-_ifcElements.insert(IFCFOOTING);
-_ifcElements.insert(IFCMEMBER);
-_ifcElements.insert(IFCPILE);
-_ifcElements.insert(IFCPLATE);
-_ifcElements.insert(IFCRAILING);
-_ifcElements.insert(IFCRAMP);
-_ifcElements.insert(IFCRAMPFLIGHT);
-_ifcElements.insert(IFCREINFORCINGELEMENT);
-_ifcElements.insert(IFCREINFORCINGMESH);
-_ifcElements.insert(IFCROOF);
-_ifcElements.insert(IFCROUNDEDEDGEFEATURE);
-_ifcElements.insert(IFCSLAB);
-_ifcElements.insert(IFCSTAIR);
-_ifcElements.insert(IFCSTAIRFLIGHT);
-_ifcElements.insert(IFCTENDON);
-_ifcElements.insert(IFCTENDONANCHOR);
-_ifcElements.insert(IFCWALL);
-_ifcElements.insert(IFCWALLSTANDARDCASE);
-_ifcElements.insert(IFCWINDOW);
-_ifcElements.insert(IFCBEAM);
-_ifcElements.insert(IFCCHAMFEREDGEFEATURE);
-_ifcElements.insert(IFCDISTRIBUTIONCHAMBERELEMENT);
-_ifcElements.insert(IFCDISTRIBUTIONCONTROLELEMENT);
-_ifcElements.insert(IFCELECTRICDISTRIBUTIONPOINT);
-_ifcElements.insert(IFCREINFORCINGBAR);
-_ifcElements.insert(IFCSPATIALELEMENT);
-_ifcElements.insert(IFCSPATIALZONE);
-_ifcElements.insert(IFCSTRUCTURALSURFACEREACTION);
-_ifcElements.insert(IFCEXTERNALSPATIALSTRUCTUREELEMENT);
-_ifcElements.insert(IFCFURNITURE);
-_ifcElements.insert(IFCGEOGRAPHICELEMENT);
-_ifcElements.insert(IFCOPENINGSTANDARDCASE);
-_ifcElements.insert(IFCSTRUCTURALCURVEACTION);
-_ifcElements.insert(IFCSTRUCTURALCURVEREACTION);
-_ifcElements.insert(IFCSTRUCTURALSURFACEACTION);
-_ifcElements.insert(IFCSURFACEFEATURE);
-_ifcElements.insert(IFCSYSTEMFURNITUREELEMENT);
-_ifcElements.insert(IFCVIBRATIONISOLATOR);
-_ifcElements.insert(IFCVOIDINGFEATURE);
-_ifcElements.insert(IFCCHIMNEY);
-_ifcElements.insert(IFCCIVILELEMENT);
-_ifcElements.insert(IFCCOLUMNSTANDARDCASE);
-_ifcElements.insert(IFCDOORSTANDARDCASE);
-_ifcElements.insert(IFCENGINE);
-_ifcElements.insert(IFCEVAPORATIVECOOLER);
-_ifcElements.insert(IFCEVAPORATOR);
-_ifcElements.insert(IFCEXTERNALSPATIALELEMENT);
-_ifcElements.insert(IFCFLOWMETER);
-_ifcElements.insert(IFCHEATEXCHANGER);
-_ifcElements.insert(IFCHUMIDIFIER);
-_ifcElements.insert(IFCINTERCEPTOR);
-_ifcElements.insert(IFCJUNCTIONBOX);
-_ifcElements.insert(IFCLAMP);
-_ifcElements.insert(IFCLIGHTFIXTURE);
-_ifcElements.insert(IFCMEDICALDEVICE);
-_ifcElements.insert(IFCMEMBERSTANDARDCASE);
-_ifcElements.insert(IFCMOTORCONNECTION);
-_ifcElements.insert(IFCOUTLET);
-_ifcElements.insert(IFCPIPEFITTING);
-_ifcElements.insert(IFCPIPESEGMENT);
-_ifcElements.insert(IFCPLATESTANDARDCASE);
-_ifcElements.insert(IFCPROTECTIVEDEVICE);
-_ifcElements.insert(IFCPUMP);
-_ifcElements.insert(IFCSANITARYTERMINAL);
-_ifcElements.insert(IFCSHADINGDEVICE);
-_ifcElements.insert(IFCSLABELEMENTEDCASE);
-_ifcElements.insert(IFCSLABSTANDARDCASE);
-_ifcElements.insert(IFCSOLARDEVICE);
-_ifcElements.insert(IFCSPACEHEATER);
-_ifcElements.insert(IFCSTACKTERMINAL);
-_ifcElements.insert(IFCSWITCHINGDEVICE);
-_ifcElements.insert(IFCTANK);
-_ifcElements.insert(IFCTRANSFORMER);
-_ifcElements.insert(IFCTUBEBUNDLE);
-_ifcElements.insert(IFCUNITARYEQUIPMENT);
-_ifcElements.insert(IFCVALVE);
-_ifcElements.insert(IFCWALLELEMENTEDCASE);
-_ifcElements.insert(IFCWASTETERMINAL);
-_ifcElements.insert(IFCWINDOWSTANDARDCASE);
-_ifcElements.insert(IFCAIRTERMINAL);
-_ifcElements.insert(IFCAIRTERMINALBOX);
-_ifcElements.insert(IFCAIRTOAIRHEATRECOVERY);
-_ifcElements.insert(IFCAUDIOVISUALAPPLIANCE);
-_ifcElements.insert(IFCBEAMSTANDARDCASE);
-_ifcElements.insert(IFCBOILER);
-_ifcElements.insert(IFCBURNER);
-_ifcElements.insert(IFCCABLECARRIERFITTING);
-_ifcElements.insert(IFCCABLECARRIERSEGMENT);
-_ifcElements.insert(IFCCABLEFITTING);
-_ifcElements.insert(IFCCABLESEGMENT);
-_ifcElements.insert(IFCCHILLER);
-_ifcElements.insert(IFCCOIL);
-_ifcElements.insert(IFCCOMMUNICATIONSAPPLIANCE);
-_ifcElements.insert(IFCCOMPRESSOR);
-_ifcElements.insert(IFCCONDENSER);
-_ifcElements.insert(IFCCOOLEDBEAM);
-_ifcElements.insert(IFCCOOLINGTOWER);
-_ifcElements.insert(IFCDAMPER);
-_ifcElements.insert(IFCDUCTFITTING);
-_ifcElements.insert(IFCDUCTSEGMENT);
-_ifcElements.insert(IFCDUCTSILENCER);
-_ifcElements.insert(IFCELECTRICAPPLIANCE);
-_ifcElements.insert(IFCELECTRICDISTRIBUTIONBOARD);
-_ifcElements.insert(IFCELECTRICFLOWSTORAGEDEVICE);
-_ifcElements.insert(IFCELECTRICGENERATOR);
-_ifcElements.insert(IFCELECTRICMOTOR);
-_ifcElements.insert(IFCELECTRICTIMECONTROL);
-_ifcElements.insert(IFCFAN);
-_ifcElements.insert(IFCFILTER);
-_ifcElements.insert(IFCFIRESUPPRESSIONTERMINAL);
-_ifcElements.insert(IFCFLOWINSTRUMENT);
-_ifcElements.insert(IFCPROTECTIVEDEVICETRIPPINGUNIT);
-_ifcElements.insert(IFCSENSOR);
-_ifcElements.insert(IFCUNITARYCONTROLELEMENT);
-_ifcElements.insert(IFCACTUATOR);
-_ifcElements.insert(IFCALARM);
-_ifcElements.insert(IFCCONTROLLER);
-_ifcElements.insert(IFCFACILITY);
-_ifcElements.insert(IFCFACILITYPART);
-_ifcElements.insert(IFCFACILITYPARTCOMMON);
-_ifcElements.insert(IFCGEOTECHNICALELEMENT);
-_ifcElements.insert(IFCGEOTECHNICALSTRATUM);
-_ifcElements.insert(IFCIMPACTPROTECTIONDEVICE);
-_ifcElements.insert(IFCLINEARELEMENT);
-_ifcElements.insert(IFCMARINEFACILITY);
-_ifcElements.insert(IFCMARINEPART);
-_ifcElements.insert(IFCPOSITIONINGELEMENT);
-_ifcElements.insert(IFCRAILWAY);
-_ifcElements.insert(IFCRAILWAYPART);
-_ifcElements.insert(IFCREFERENT);
-_ifcElements.insert(IFCROAD);
-_ifcElements.insert(IFCROADPART);
-_ifcElements.insert(IFCSIGN);
-_ifcElements.insert(IFCTENDONCONDUIT);
-_ifcElements.insert(IFCTRANSPORTATIONDEVICE);
-_ifcElements.insert(IFCVEHICLE);
-_ifcElements.insert(IFCVIBRATIONDAMPER);
-_ifcElements.insert(IFCALIGNMENTCANT);
-_ifcElements.insert(IFCALIGNMENTHORIZONTAL);
-_ifcElements.insert(IFCALIGNMENTSEGMENT);
-_ifcElements.insert(IFCALIGNMENTVERTICAL);
-_ifcElements.insert(IFCBRIDGE);
-_ifcElements.insert(IFCBRIDGEPART);
-_ifcElements.insert(IFCBUILTELEMENT);
-_ifcElements.insert(IFCCOURSE);
-_ifcElements.insert(IFCDEEPFOUNDATION);
-_ifcElements.insert(IFCEARTHWORKSCUT);
-_ifcElements.insert(IFCEARTHWORKSELEMENT);
-_ifcElements.insert(IFCEARTHWORKSFILL);
-_ifcElements.insert(IFCGEOTECHNICALASSEMBLY);
-_ifcElements.insert(IFCKERB);
-_ifcElements.insert(IFCLINEARPOSITIONINGELEMENT);
-_ifcElements.insert(IFCLIQUIDTERMINAL);
-_ifcElements.insert(IFCMOBILETELECOMMUNICATIONSAPPLIANCE);
-_ifcElements.insert(IFCMOORINGDEVICE);
-_ifcElements.insert(IFCNAVIGATIONELEMENT);
-_ifcElements.insert(IFCPAVEMENT);
-_ifcElements.insert(IFCRAIL);
-_ifcElements.insert(IFCREINFORCEDSOIL);
-_ifcElements.insert(IFCSIGNAL);
-_ifcElements.insert(IFCTRACKELEMENT);
-_ifcElements.insert(IFCALIGNMENT);
-_ifcElements.insert(IFCBEARING);
-_ifcElements.insert(IFCBOREHOLE);
-_ifcElements.insert(IFCCAISSONFOUNDATION);
-_ifcElements.insert(IFCCONVEYORSEGMENT);
-_ifcElements.insert(IFCDISTRIBUTIONBOARD);
-_ifcElements.insert(IFCELECTRICFLOWTREATMENTDEVICE);
-_ifcElements.insert(IFCGEOMODEL);
-_ifcElements.insert(IFCGEOSLICE);
-_schemaNames.push_back("IFC2X3");
-_schemas.push_back(IFC2X3);
-_schemaNames.push_back("IFC4");
-_schemas.push_back(IFC4);
-_schemaNames.push_back("IFC4X3");
-_schemas.push_back(IFC4X3);
+// sorted by type code
+constexpr std::array<uint32_t,235> IFC_ELEMENTS = {
+IFCFACILITY,
+IFCELECTRICFLOWTREATMENTDEVICE,
+IFCCONTROLLER,
+IFCBOILER,
+IFCSIGN,
+IFCBUILDINGELEMENTCOMPONENT,
+IFCLAMP,
+IFCPUMP,
+IFCROAD,
+IFCAIRTERMINALBOX,
+IFCFLOWINSTRUMENT,
+IFCSTRUCTURALCURVEMEMBER,
+IFCMOORINGDEVICE,
+IFCFURNISHINGELEMENT,
+IFCELECTRICGENERATOR,
+IFCAUDIOVISUALAPPLIANCE,
+IFCPIPEFITTING,
+IFCALIGNMENTSEGMENT,
+IFCALIGNMENT,
+IFCSTAIR,
+IFCDUCTFITTING,
+IFCMECHANICALFASTENER,
+IFCDOOR,
+IFCELECTRICMOTOR,
+IFCSYSTEMFURNITUREELEMENT,
+IFCSPATIALZONE,
+IFCEVAPORATOR,
+IFCWINDOWSTANDARDCASE,
+IFCMARINEFACILITY,
+IFCSTRUCTURALMEMBER,
+IFCROADPART,
+IFCSTRUCTURALSURFACEREACTION,
+IFCLIGHTFIXTURE,
+IFCUNITARYCONTROLELEMENT,
+IFCCABLECARRIERFITTING,
+IFCCOIL,
+IFCBRIDGE,
+IFCFASTENER,
+IFCSTRUCTURALACTION,
+IFCFLOWSTORAGEDEVICE,
+IFCSTRUCTURALPOINTCONNECTION,
+IFCPROTECTIVEDEVICE,
+IFCBEAM,
+IFCTANK,
+IFCFILTER,
+IFCVEHICLE,
+IFCCOLUMN,
+IFCEDGEFEATURE,
+IFCELECTRICALELEMENT,
+IFCELECTRICDISTRIBUTIONBOARD,
+IFCFOOTING,
+IFCCOLUMNSTANDARDCASE,
+IFCVOIDINGFEATURE,
+IFCBRIDGEPART,
+IFCMARINEPART,
+IFCREINFORCINGBAR,
+IFCFLOWSEGMENT,
+IFCSIGNAL,
+IFCELECTRICTIMECONTROL,
+IFCSTRUCTURALCURVEACTION,
+IFCCABLEFITTING,
+IFCDISTRIBUTIONCHAMBERELEMENT,
+IFCDISTRIBUTIONCONTROLELEMENT,
+IFCMEMBER,
+IFCEARTHWORKSELEMENT,
+IFCBUILDINGELEMENTPROXY,
+IFCLINEARPOSITIONINGELEMENT,
+IFCPLATESTANDARDCASE,
+IFCSWITCHINGDEVICE,
+IFCSTRUCTURALCONNECTION,
+IFCEXTERNALSPATIALELEMENT,
+IFCSTRUCTURALPOINTREACTION,
+IFCFEATUREELEMENTSUBTRACTION,
+IFCFACILITYPART,
+IFCSHADINGDEVICE,
+IFCDISCRETEACCESSORY,
+IFCDUCTSILENCER,
+IFCROUNDEDEDGEFEATURE,
+IFCPAVEMENT,
+IFCSTACKTERMINAL,
+IFCSPATIALELEMENT,
+IFCFIRESUPPRESSIONTERMINAL,
+IFCMEDICALDEVICE,
+IFCCOURSE,
+IFCFURNITURE,
+IFCSLAB,
+IFCVIBRATIONDAMPER,
+IFCALIGNMENTHORIZONTAL,
+IFCGEOTECHNICALSTRATUM,
+IFCTRANSPORTELEMENT,
+IFCSTRUCTURALPLANARACTION,
+IFCELEMENTCOMPONENT,
+IFCAIRTERMINAL,
+IFCLIQUIDTERMINAL,
+IFCENERGYCONVERSIONDEVICE,
+IFCALIGNMENTVERTICAL,
+IFCANNOTATION,
+IFCCIVILELEMENT,
+IFCPILE,
+IFCSTRUCTURALLINEARACTIONVARYING,
+IFCELEMENT,
+IFCSTRUCTURALLINEARACTION,
+IFCBUILTELEMENT,
+IFCRAILWAYPART,
+IFCELECTRICAPPLIANCE,
+IFCMEMBERSTANDARDCASE,
+IFCDISTRIBUTIONELEMENT,
+IFCPOSITIONINGELEMENT,
+IFCTRANSPORTATIONDEVICE,
+IFCEQUIPMENTELEMENT,
+IFCGEOSLICE,
+IFCCOVERING,
+IFCSTRUCTURALSURFACECONNECTION,
+IFCSPACEHEATER,
+IFCROOF,
+IFCAIRTOAIRHEATRECOVERY,
+IFCFLOWCONTROLLER,
+IFCHUMIDIFIER,
+IFCMOBILETELECOMMUNICATIONSAPPLIANCE,
+IFCSTRUCTURALPOINTACTION,
+IFCFEATUREELEMENTADDITION,
+IFCJUNCTIONBOX,
+IFCLINEARELEMENT,
+IFCNAVIGATIONELEMENT,
+IFCFLOWMETER,
+IFCSTRUCTURALSURFACEMEMBERVARYING,
+IFCFLOWTERMINAL,
+IFCRAILING,
+IFCCONDENSER,
+IFCPROTECTIVEDEVICETRIPPINGUNIT,
+IFCREINFORCINGMESH,
+IFCTENDONANCHOR,
+IFCVIBRATIONISOLATOR,
+IFCWALL,
+IFCSTRUCTURALCURVEMEMBERVARYING,
+IFCCHAMFEREDGEFEATURE,
+IFCMOTORCONNECTION,
+IFCIMPACTPROTECTIONDEVICE,
+IFCGEOMODEL,
+IFCKERB,
+IFCSPATIALSTRUCTUREELEMENT,
+IFCGEOTECHNICALASSEMBLY,
+IFCSTRUCTURALCURVEREACTION,
+IFCVIRTUALELEMENT,
+IFCENGINE,
+IFCFEATUREELEMENT,
+IFCEXTERNALSPATIALSTRUCTUREELEMENT,
+IFCBEAMSTANDARDCASE,
+IFCBURNER,
+IFCBUILDINGELEMENTPART,
+IFCGRID,
+IFCRAMP,
+IFCTUBEBUNDLE,
+IFCREINFORCINGELEMENT,
+IFCSLABSTANDARDCASE,
+IFCDISTRIBUTIONFLOWELEMENT,
+IFCDISTRIBUTIONPORT,
+IFCSANITARYTERMINAL,
+IFCEARTHWORKSCUT,
+IFCOPENINGSTANDARDCASE,
+IFCALARM,
+IFCSURFACEFEATURE,
+IFCBUILDINGSTOREY,
+IFCSLABELEMENTEDCASE,
+IFCFLOWMOVINGDEVICE,
+IFCSTRUCTURALITEM,
+IFCPLATE,
+IFCPROXY,
+IFCCOMMUNICATIONSAPPLIANCE,
+IFCDOORSTANDARDCASE,
+IFCRAMPFLIGHT,
+IFCRAIL,
+IFCCHIMNEY,
+IFCBUILDINGELEMENT,
+IFCWINDOW,
+IFCELECTRICFLOWSTORAGEDEVICE,
+IFCBOREHOLE,
+IFCHEATEXCHANGER,
+IFCEARTHWORKSFILL,
+IFCFAN,
+IFCSOLARDEVICE,
+IFCTRACKELEMENT,
+IFCDEEPFOUNDATION,
+IFCCONVEYORSEGMENT,
+IFCGEOGRAPHICELEMENT,
+IFCCURTAINWALL,
+IFCFLOWTREATMENTDEVICE,
+IFCWALLSTANDARDCASE,
+IFCDUCTSEGMENT,
+IFCSTRUCTURALACTIVITY,
+IFCCOMPRESSOR,
+IFCOPENINGELEMENT,
+IFCPIPESEGMENT,
+IFCCOOLINGTOWER,
+IFCPROJECTIONELEMENT,
+IFCSTRUCTURALSURFACEACTION,
+IFCTENDONCONDUIT,
+IFCSTRUCTURALREACTION,
+IFCDISTRIBUTIONBOARD,
+IFCOUTLET,
+IFCELECTRICDISTRIBUTIONPOINT,
+IFCPORT,
+IFCEVAPORATIVECOOLER,
+IFCCABLECARRIERSEGMENT,
+IFCREINFORCEDSOIL,
+IFCTENDON,
+IFCTRANSFORMER,
+IFCSPACE,
+IFCCHILLER,
+IFCSTRUCTURALSURFACEMEMBER,
+IFCSTRUCTURALPLANARACTIONVARYING,
+IFCRAILWAY,
+IFCCAISSONFOUNDATION,
+IFCREFERENT,
+IFCBUILDING,
+IFCDAMPER,
+IFCSENSOR,
+IFCSITE,
+IFCELEMENTASSEMBLY,
+IFCCOOLEDBEAM,
+IFCWALLELEMENTEDCASE,
+IFCINTERCEPTOR,
+IFCBEARING,
+IFCVALVE,
+IFCPRODUCT,
+IFCCABLESEGMENT,
+IFCFACILITYPARTCOMMON,
+IFCGEOTECHNICALELEMENT,
+IFCWASTETERMINAL,
+IFCSTRUCTURALCURVECONNECTION,
+IFCSTAIRFLIGHT,
+IFCALIGNMENTCANT,
+IFCFLOWFITTING,
+IFCACTUATOR,
+IFCUNITARYEQUIPMENT,
+};
+constexpr std::array<IFC_SCHEMA,3> SCHEMAS = {
+IFC2X3,
+IFC4,
+IFC4X3,
+};
+constexpr std::array<std::string_view,3> SCHEMA_NAMES = {
+"IFC2X3",
+"IFC4",
+"IFC4X3",
+};
+bool IfcSchemaManager::IsIfcElement(uint32_t typeCode) const {
+return std::binary_search(IFC_ELEMENTS.begin(), IFC_ELEMENTS.end(), typeCode);
+}
+std::span<const uint32_t> IfcSchemaManager::GetIfcElementList() const {
+return IFC_ELEMENTS;
+}
+const std::vector<IFC_SCHEMA> IfcSchemaManager::GetAvailableSchemas() const {
+return std::vector<IFC_SCHEMA>(SCHEMAS.begin(), SCHEMAS.end());
+}
+std::string_view IfcSchemaManager::GetSchemaName(IFC_SCHEMA schema) const {
+return SCHEMA_NAMES[schema];
 }
 std::string IfcSchemaManager::IfcTypeCodeToType(uint32_t typeCode) const {
 switch(typeCode) {
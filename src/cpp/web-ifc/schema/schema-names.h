@@ -1,5 +1,5 @@
-std::array<std::string,1215> propyNames = {"Role","UserDefinedRole","Description","Purpose","UserDefinedPurpose","ApplicationDeveloper","Version","ApplicationFullName","ApplicationIdentifier","Name","AppliedValue","UnitBasis","ApplicableDate","FixedUntilDate","ComponentOfTotal","Components","ArithmeticOperator","ApprovalDateTime","ApprovalStatus","ApprovalLevel","ApprovalQualifier","Identifier","Actor","Approval","ApprovedProperties","RelatedApproval","RelatingApproval","LinearStiffnessByLengthX","LinearStiffnessByLengthY","LinearStiffnessByLengthZ","RotationalStiffnessByLengthX","RotationalStiffnessByLengthY","RotationalStiffnessByLengthZ","LinearStiffnessByAreaX","LinearStiffnessByAreaY","LinearStiffnessByAreaZ","LinearStiffnessX","LinearStiffnessY","LinearStiffnessZ","RotationalStiffnessX","RotationalStiffnessY","RotationalStiffnessZ","WarpingStiffness","DayComponent","MonthComponent","YearComponent","Source","Edition","EditionDate","Notation","ItemOf","Title","RelatingItem","RelatedItems","NotationFacets","NotationValue","PointOnRelatingElement","PointOnRelatedElement","LocationAtRelatingElement","LocationAtRelatedElement","ProfileOfPort","SurfaceOnRelatingElement","SurfaceOnRelatedElement","ConstraintGrade","ConstraintSource","CreatingActor","CreationTime","UserDefinedGrade","RelatingConstraint","RelatedConstraints","LogicalAggregator","ClassifiedConstraint","RelatedClassifications","HourOffset","MinuteOffset","Sense","CostType","Condition","RelatingMonetaryUnit","RelatedMonetaryUnit","ExchangeRate","RateDateTime","RateSource","PatternList","CurveFont","CurveFontScaling","VisibleSegmentLength","InvisibleSegmentLength","DateComponent","TimeComponent","Elements","UnitType","UserDefinedType","Unit","Exponent","LengthExponent","MassExponent","TimeExponent","ElectricCurrentExponent","ThermodynamicTemperatureExponent","AmountOfSubstanceExponent","LuminousIntensityExponent","FileExtension","MimeContentType","MimeSubtype","DocumentId","DocumentReferences","IntendedUse","Scope","Revision","DocumentOwner","Editors","LastRevisionTime","ElectronicFormat","ValidFrom","ValidUntil","Confidentiality","Status","RelatingDocument","RelatedDocuments","RelationshipType","RelatingDraughtingCallout","RelatedDraughtingCallout","ImpactType","Category","UserDefinedCategory","Location","ItemReference","AxisTag","AxisCurve","SameSense","TimeStamp","ListValues","Publisher","VersionDate","LibraryReference","MainPlaneAngle","SecondaryPlaneAngle","LuminousIntensity","LightDistributionCurve","DistributionData","HourComponent","MinuteComponent","SecondComponent","Zone","DaylightSavingOffset","MaterialClassifications","ClassifiedMaterial","Material","LayerThickness","IsVentilated","MaterialLayers","LayerSetName","ForLayerSet","LayerSetDirection","DirectionSense","OffsetFromReferenceLine","Materials","ValueComponent","UnitComponent","DynamicViscosity","YoungModulus","ShearModulus","PoissonRatio","ThermalExpansionCoefficient","YieldStress","UltimateStress","UltimateStrain","HardeningModule","ProportionalStress","PlasticStrain","Relaxations","Benchmark","ValueSource","DataValue","Currency","Dimensions","BenchmarkValues","ResultValues","ObjectiveQualifier","UserDefinedQualifier","VisibleTransmittance","SolarTransmittance","ThermalIrTransmittance","ThermalIrEmissivityBack","ThermalIrEmissivityFront","VisibleReflectanceBack","VisibleReflectanceFront","SolarReflectanceFront","SolarReflectanceBack","Id","Roles","Addresses","RelatingOrganization","RelatedOrganizations","OwningUser","OwningApplication","State","ChangeAction","LastModifiedDate","LastModifyingUser","LastModifyingApplication","CreationDate","FamilyName","GivenName","MiddleNames","PrefixTitles","SuffixTitles","ThePerson","TheOrganization","InternalLocation","AddressLines","PostalBox","Town","Region","PostalCode","Country","AssignedItems","LayerOn","LayerFrozen","LayerBlocked","LayerStyles","Styles","Representations","SpecificHeatCapacity","N20Content","COContent","CO2Content","ProfileType","ProfileName","ProfileDefinition","RelatedProperties","DependingProperty","DependantProperty","Expression","EnumerationValues","AreaValue","CountValue","LengthValue","TimeValue","VolumeValue","WeightValue","ReferencedDocument","ReferencingValues","TotalCrossSectionArea","SteelGrade","BarSurface","EffectiveDepth","NominalBarDiameter","BarCount","RelaxationValue","InitialStress","ContextOfItems","RepresentationIdentifier","RepresentationType","Items","ContextIdentifier","ContextType","MappingOrigin","MappedRepresentation","Thickness","RibHeight","RibWidth","RibSpacing","Direction","GlobalId","OwnerHistory","Prefix","SectionType","StartProfile","EndProfile","LongitudinalStartPosition","LongitudinalEndPosition","TransversePosition","ReinforcementRole","SectionDefinition","CrossSectionReinforcementDefinitions","ShapeRepresentations","ProductDefinitional","PartOfProductDefinitionShape","DeltaT_Constant","DeltaT_Y","DeltaT_Z","Item","Side","DiffuseTransmissionColour","DiffuseReflectionColour","TransmissionColour","ReflectanceColour","RefractionIndex","DispersionFactor","SurfaceColour","Textures","RepeatS","RepeatT","TextureType","TextureTransform","StyleOfSymbol","Rows","RowCells","IsHeading","TelephoneNumbers","FacsimileNumbers","PagerNumber","ElectronicMailAddresses","WWWHomePageURL","TextCharacterAppearance","TextStyle","TextFontStyle","FontFamily","FontStyle","FontVariant","FontWeight","FontSize","Colour","BackgroundColour","TextIndent","TextAlign","TextDecoration","LetterSpacing","WordSpacing","TextTransform","LineHeight","BoxHeight","BoxWidth","BoxSlantAngle","BoxRotateAngle","CharacterSpacing","Mode","Parameter","TextureMaps","Coordinates","BoilingPoint","FreezingPoint","ThermalConductivity","StartTime","EndTime","TimeSeriesDataType","DataOrigin","UserDefinedDataOrigin","ReferencedTimeSeries","TimeSeriesReferences","Units","TextureVertices","TexturePoints","VertexGeometry","IntersectingAxes","OffsetDistances","IsPotable","Hardness","AlkalinityConcentration","AcidityConcentration","ImpuritiesContent","PHLevel","DissolvedSolidsContent","OuterCurve","Curve","InnerCurves","RasterFormat","RasterCode","ReferencedSource","Red","Green","Blue","UsageName","HasProperties","Profiles","Label","CfsFaces","CurveOnRelatingElement","CurveOnRelatedElement","EccentricityInX","EccentricityInY","EccentricityInZ","ConversionFactor","CurveWidth","CurveColour","ParentProfile","Operator","EdgeStart","EdgeEnd","EdgeGeometry","ExtendedProperties","Bounds","Bound","Orientation","FaceSurface","TensionFailureX","TensionFailureY","TensionFailureZ","CompressionFailureX","CompressionFailureY","CompressionFailureZ","FillStyles","CombustionTemperature","CarbonContent","LowerHeatingValue","HigherHeatingValue","MolecularWeight","Porosity","MassDensity","PhysicalWeight","Perimeter","MinimumPlateThickness","MaximumPlateThickness","CrossSectionArea","CoordinateSpaceDimension","Precision","WorldCoordinateSystem","TrueNorth","ParentContext","TargetScale","TargetView","UserDefinedTargetView","PlacementLocation","PlacementRefDirection","BaseSurface","AgreementFlag","UpperVaporResistanceFactor","LowerVaporResistanceFactor","IsothermalMoistureCapacity","VaporPermeability","MoistureDiffusivity","UrlReference","Values","LightColour","AmbientIntensity","Intensity","Position","ColourAppearance","ColourTemperature","LuminousFlux","LightEmissionSource","LightDistributionDataSource","Radius","ConstantAttenuation","DistanceAttenuation","QuadricAttenuation","ConcentrationExponent","SpreadAngle","BeamWidthAngle","PlacementRelTo","RelativePlacement","MappingSource","MappingTarget","RepresentedMaterial","CompressiveStrength","MaxAggregateSize","AdmixturesDescription","Workability","ProtectivePoreRatio","WaterImpermeability","RepeatFactor","EdgeElement","EdgeList","HasQuantities","Discrimination","Quality","Usage","Width","Height","ColourComponents","Pixel","SizeInX","SizeInY","BasisCurve","PointParameter","BasisSurface","PointParameterU","PointParameterV","Polygon","PolygonalBoundary","UpperBoundValue","LowerBoundValue","EnumerationReference","PropertyReference","NominalValue","DefiningValues","DefinedValues","DefiningUnit","DefinedUnit","XDim","YDim","TimeStep","DefinitionType","ReinforcementSectionDefinitions","RoundingRadius","SpineCurve","CrossSections","CrossSectionPositions","PredefinedType","UpperValue","MostUsedValue","LowerValue","SbsmBoundary","SlippageX","SlippageY","SlippageZ","IsAttenuating","SoundScale","SoundValues","SoundLevelTimeSeries","Frequency","SoundLevelSingleValue","ApplicableValueRatio","ThermalLoadSource","PropertySource","SourceDescription","MaximumValue","MinimumValue","ThermalLoadTimeSeriesValues","UserDefinedThermalLoadSource","UserDefinedPropertySource","ThermalLoadType","LinearForceX","LinearForceY","LinearForceZ","LinearMomentX","LinearMomentY","LinearMomentZ","PlanarForceX","PlanarForceY","PlanarForceZ","DisplacementX","DisplacementY","DisplacementZ","RotationalDisplacementRX","RotationalDisplacementRY","RotationalDisplacementRZ","Distortion","ForceX","ForceY","ForceZ","MomentX","MomentY","MomentZ","WarpingMoment","TorsionalConstantX","MomentOfInertiaYZ","MomentOfInertiaY","MomentOfInertiaZ","WarpingConstant","ShearCentreZ","ShearCentreY","ShearDeformationAreaZ","ShearDeformationAreaY","MaximumSectionModulusY","MinimumSectionModulusY","MaximumSectionModulusZ","MinimumSectionModulusZ","TorsionalSectionModulus","CentreOfGravityInX","CentreOfGravityInY","ShearAreaZ","ShearAreaY","PlasticShapeFactorY","PlasticShapeFactorZ","ParentEdge","Transparency","DiffuseColour","ReflectionColour","SpecularColour","SpecularHighlight","ReflectanceMethod","SweptArea","Directrix","InnerRadius","StartParam","EndParam","SweptCurve","Depth","FlangeWidth","WebThickness","FlangeThickness","FilletRadius","FlangeEdgeRadius","WebEdgeRadius","WebSlope","FlangeSlope","AnnotatedCurve","Literal","Placement","Path","Extent","BoxAlignment","BottomXDim","TopXDim","TopXOffset","SecondRepeatFactor","ApplicableOccurrence","HasPropertySets","RepresentationMaps","Tag","EdgeRadius","Magnitude","LoopVertex","LiningDepth","LiningThickness","TransomThickness","MullionThickness","FirstTransomOffset","SecondTransomOffset","FirstMullionOffset","SecondMullionOffset","ShapeAspectStyle","OperationType","PanelPosition","FrameDepth","FrameThickness","ConstructionType","ParameterTakesPrecedence","Sizeable","OuterBoundary","InnerBoundaries","FillStyleTarget","GlobalOrLocal","TextureCoordinates","Axis","RefDirection","FirstOperand","SecondOperand","Corner","ZDim","Enclosure","WallThickness","Girth","InternalFilletRadius","Axis1","Axis2","LocalOrigin","Scale","Scale2","Axis3","Scale3","Transition","ParentCurve","OverallHeight","BaseWidth2","HeadWidth","HeadDepth2","HeadDepth3","BaseWidth4","BaseDepth1","BaseDepth2","BaseDepth3","TreeRootExpression","Definition","Target","DirectionRatios","ThresholdDepth","ThresholdThickness","TransomOffset","LiningOffset","ThresholdOffset","CasingThickness","CasingDepth","PanelDepth","PanelOperation","PanelWidth","Contents","MethodOfMeasurement","Quantities","ElementType","SemiAxis1","SemiAxis2","EnergySequence","UserDefinedEnergySequence","ExtrudedDirection","FbsmFaces","HatchLineAppearance","StartOfNextHatchLine","PointOfReferenceHatchLine","PatternStart","HatchLineAngle","Symbol","TilingPattern","Tiles","TilingScale","FlowConditionTimeSeries","VelocityTimeSeries","FlowrateTimeSeries","Fluid","PressureTimeSeries","TemperatureSingleValue","WetBulbTemperatureSingleValue","WetBulbTemperatureTimeSeries","TemperatureTimeSeries","FlowrateSingleValue","FlowConditionSingleValue","VelocitySingleValue","PressureSingleValue","AssemblyPlace","OverallWidth","OverallDepth","LegSlope","Pnt","Dir","Outer","ObjectType","Distance","SelfIntersect","ObjectPlacement","Representation","LongName","Phase","RepresentationContexts","UnitsInContext","ProxyType","InnerFilletRadius","OuterFilletRadius","XLength","YLength","U1","V1","U2","V2","Usense","Vsense","RelatedObjects","RelatedObjectsType","RelatingActor","ActingRole","RelatingControl","RelatingGroup","RelatingProcess","QuantityInProcess","RelatingProduct","RelatingResource","RelatingAppliedValue","RelatingClassification","Intent","RelatingLibrary","RelatingMaterial","RelatingProfileProperties","ProfileSectionLocation","ProfileOrientation","ConnectionGeometry","RelatingElement","RelatedElement","RelatingPriorities","RelatedPriorities","RelatedConnectionType","RelatingConnectionType","RelatingPort","RelatedPort","RealizingElement","RelatedStructuralActivity","RelatedStructuralMember","RelatingStructuralMember","RelatedStructuralConnection","AppliedCondition","AdditionalConditions","SupportedLength","ConditionCoordinateSystem","ConnectionConstraint","RealizingElements","ConnectionType","RelatedElements","RelatingStructure","RelatingBuildingElement","RelatedCoverings","RelatedSpace","RelatingObject","RelatingPropertyDefinition","RelatingType","RelatingOpeningElement","RelatedBuildingElement","RelatedControlElements","RelatingFlowElement","DailyInteraction","ImportanceRating","LocationOfInteraction","RelatedSpaceProgram","RelatingSpaceProgram","OverridingProperties","RelatedFeatureElement","RelatedProcess","TimeLag","SequenceType","RelatingSystem","RelatedBuildings","RelatingSpace","PhysicalOrVirtualBoundary","InternalOrExternalBoundary","RelatedOpeningElement","Angle","BottomRadius","CompositionType","AppliedLoad","SubsequentThickness","VaryingThicknessLocation","ReferenceSurface","AxisPosition","TaskId","WorkMethod","IsMilestone","Priority","TheActor","TopFlangeWidth","TopFlangeThickness","TopFlangeFilletRadius","ZLength","ElevationOfRefHeight","ElevationOfTerrain","BuildingAddress","Elevation","Segments","ResourceIdentifier","ResourceGroup","ResourceConsumption","BaseQuantity","SubmittedBy","PreparedBy","SubmittedOn","TargetUsers","UpdateDate","ID","ElectricCurrentType","InputVoltage","InputFrequency","FullLoadCurrent","MinimumCircuitCurrent","MaximumPowerInput","RatedPowerInput","InputPhase","Voids","UAxes","VAxes","WAxes","InventoryType","Jurisdiction","ResponsiblePersons","LastUpdateDate","CurrentValue","OriginalValue","SkillSet","NominalDiameter","NominalLength","MoveFrom","MoveTo","PunchList","ActionID","LifeCyclePhase","PermitID","Points","ProcedureID","ProcedureType","UserDefinedProcedureType","Records","TimeForTask","ActualStart","EarlyStart","LateStart","ScheduleStart","ActualFinish","EarlyFinish","LateFinish","ScheduleFinish","ScheduleDuration","ActualDuration","RemainingTime","FreeFloat","TotalFloat","IsCritical","StatusTime","StartFloat","FinishFloat","Completion","ServiceLifeType","ServiceLifeDuration","RefLatitude","RefLongitude","RefElevation","LandTitleNumber","SiteAddress","InteriorOrExteriorSpace","ElevationWithFlooring","SpaceProgramIdentifier","MaxRequiredArea","MinRequiredArea","RequestedLocation","StandardRequiredArea","DestabilizingLoad","CausedBy","ProjectedOrTrue","VaryingAppliedLoadLocation","SubsequentAppliedLoads","ActionType","ActionSource","Coefficient","TheoryType","ResultForLoadGroup","IsLinear","SubContractor","JobDescription","ApplicableDates","TimeSeriesScheduleType","TimeSeries","CapacityByWeight","CapacityByNumber","Trim1","Trim2","SenseAgreement","MasterRepresentation","Creators","Duration","FinishTime","WorkControlType","UserDefinedControlType","RequestID","AssetID","TotalReplacementCost","Owner","User","ResponsiblePerson","IncorporationDate","DepreciatedValue","Degree","ControlPointsList","CurveForm","ClosedCurve","Criterion","CriterionDateTime","Suppliers","UsageRatio","FlowDirection","FeatureLength","ShapeType","WeightsData","MeshLength","MeshWidth","LongitudinalBarNominalDiameter","TransverseBarNominalDiameter","LongitudinalBarCrossSectionArea","TransverseBarCrossSectionArea","LongitudinalBarSpacing","TransverseBarSpacing","NumberOfRiser","NumberOfTreads","RiserHeight","TreadLength","OrientationOf2DPlane","LoadedBy","HasResults","TensionForce","PreStress","FrictionCoefficient","AnchorageSlip","MinCurvatureRadius","ControlElementId","DistributionPointFunction","UserDefinedFunction","BarLength","BarRole","TimeOfApproval","Level","Qualifier","RequestingApproval","GivingApproval","TranslationalStiffnessByLengthX","TranslationalStiffnessByLengthY","TranslationalStiffnessByLengthZ","TranslationalStiffnessByAreaX","TranslationalStiffnessByAreaY","TranslationalStiffnessByAreaZ","TranslationalStiffnessX","TranslationalStiffnessY","TranslationalStiffnessZ","VolumeOnRelatingElement","VolumeOnRelatedElement","SourceCRS","TargetCRS","GeodeticDatum","VerticalDatum","Identification","Language","ReferencedLibrary","Eastings","Northings","OrthogonalHeight","XAxisAbscissa","XAxisOrdinate","OffsetDirection","OffsetValues","Profile","MaterialProfiles","CompositeProfile","ReferencePath","MapProjection","MapZone","MapUnit","Formula","RecurrenceType","WeekdayComponent","Interval","Occurrences","TimePeriods","TypeIdentifier","AttributeIdentifier","InstanceName","ListPositions","InnerReference","Locations","DeltaTConstant","DeltaTY","DeltaTZ","SurfaceReinforcement1","SurfaceReinforcement2","ShearReinforcement","Columns","DurationType","Recurrence","MessagingIDs","ModelOrDraughting","Maps","Vertices","MappedTo","TexCoordsList","RecurrencePattern","Start","Finish","RelatedApprovals","ReferenceTokens","Sort","ColourList","ConversionOffset","ActualDate","EarlyDate","LateDate","ScheduleDate","Properties","RelatingReference","RelatedResourceObjects","ModelorDraughting","URLReference","Opacity","Colours","ColourIndex","TexCoords","TexCoordIndex","LagValue","Fraction","MaterialConstituents","ReferenceExtent","ForProfileSet","CardinalPoint","ForProfileEndSet","CardinalEndPoint","RelatedMaterials","ScheduleWork","ScheduleUsage","ScheduleContour","LevelingDelay","IsOverAllocated","ActualWork","ActualUsage","RemainingWork","RemainingUsage","LongDescription","ProcessType","ResourceType","BottomFlangeWidth","BottomFlangeThickness","BottomFlangeFilletRadius","BottomFlangeEdgeRadius","BottomFlangeSlope","TopFlangeEdgeRadius","TopFlangeSlope","CoordList","BaseCosts","Boundaries","ImplicitOuter","EventTriggerType","UserDefinedEventTriggerType","EndSweptArea","FixedReference","CoordIndex","InnerCoordIndices","ReferenceCurve","SetPointValue","TemplateType","ApplicableEntity","HasPropertyTemplates","CurveInterpolation","Factor","RelatingContext","RelatedDefinitions","RelatedPropertySets","RelatingTemplate","InterferenceGeometry","InterferenceType","ImpliedOrder","UserDefinedSequenceType","ParentBoundary","CorrespondingBoundary","ParamLength","PrimaryMeasureType","SecondaryMeasureType","Enumerators","PrimaryUnit","SecondaryUnit","AccessState","Curve3D","AssociatedGeometry","TaskTime","MajorRadius","MinorRadius","Normals","Closed","PnIndex","LiningToPanelOffsetX","LiningToPanelOffsetY","UDegree","VDegree","SurfaceForm","UClosed","VClosed","UMultiplicities","VMultiplicities","UKnots","VKnots","KnotSpec","CostValues","CostQuantities","UserDefinedOperationType","EventOccurenceTime","Faces","BendingShapeCode","BendingParameters","SheathDiameter","PartitioningType","UserDefinedPartitioningType","WorkingTimes","ExceptionTimes","KnotMultiplicities","Knots","SystemType","NumberOfRisers","SharedPlacement","SelfWeightCoefficients","StartTag","EndTag","StartDistAlong","HorizontalLength","StartHeight","StartGradient","EndGradient","RadiusOfCurvature","PrimeMeridian","AngleUnit","HeightUnit","FactorX","FactorY","FactorZ","NumberValue","FirstCoordinate","SecondCoordinate","TexCoordsOf","InnerTexCoordIndices","WellKnownText","CoordinateReferenceSystem","StartDate","FinishDate","StartCantLeft","EndCantLeft","StartCantRight","EndCantRight","StartPoint","StartDirection","StartRadiusOfCurvature","EndRadiusOfCurvature","SegmentLength","GravityCenterLineHeight","Specification","CurveStyleFont","CartesianPosition","MaterialExpression","HorizontalWidths","Widths","Slopes","Tags","OffsetPoint","DistanceAlong","OffsetLateral","OffsetVertical","OffsetLongitudinal","TagList","SegmentStart","TexCoordIndices","CoefficientsX","CoefficientsY","CoefficientsZ","RelatingProfileDef","InterferenceSpace","RelatingPositioningElement","RelatedProducts","CubicTerm","QuadraticTerm","LinearTerm","ConstantTerm","Flags","ClothoidConstant","CosineTerm","UsageType","BaseCurve","EndPoint","RelatedSurfaceFeatures","SepticTerm","SexticTerm","QuinticTerm","QuarticTerm","SineTerm","AxisDirection","RailHeadDistance","DesignParameters",};
-std::string getPropertyName(IFC_SCHEMA schema,uint32_t typeCode,uint32_t prop) {
+constexpr std::array<std::string_view,1215> propyNames = {"Role","UserDefinedRole","Description","Purpose","UserDefinedPurpose","ApplicationDeveloper","Version","ApplicationFullName","ApplicationIdentifier","Name","AppliedValue","UnitBasis","ApplicableDate","FixedUntilDate","ComponentOfTotal","Components","ArithmeticOperator","ApprovalDateTime","ApprovalStatus","ApprovalLevel","ApprovalQualifier","Identifier","Actor","Approval","ApprovedProperties","RelatedApproval","RelatingApproval","LinearStiffnessByLengthX","LinearStiffnessByLengthY","LinearStiffnessByLengthZ","RotationalStiffnessByLengthX","RotationalStiffnessByLengthY","RotationalStiffnessByLengthZ","LinearStiffnessByAreaX","LinearStiffnessByAreaY","LinearStiffnessByAreaZ","LinearStiffnessX","LinearStiffnessY","LinearStiffnessZ","RotationalStiffnessX","RotationalStiffnessY","RotationalStiffnessZ","WarpingStiffness","DayComponent","MonthComponent","YearComponent","Source","Edition","EditionDate","Notation","ItemOf","Title","RelatingItem","RelatedItems","NotationFacets","NotationValue","PointOnRelatingElement","PointOnRelatedElement","LocationAtRelatingElement","LocationAtRelatedElement","ProfileOfPort","SurfaceOnRelatingElement","SurfaceOnRelatedElement","ConstraintGrade","ConstraintSource","CreatingActor","CreationTime","UserDefinedGrade","RelatingConstraint","RelatedConstraints","LogicalAggregator","ClassifiedConstraint","RelatedClassifications","HourOffset","MinuteOffset","Sense","CostType","Condition","RelatingMonetaryUnit","RelatedMonetaryUnit","ExchangeRate","RateDateTime","RateSource","PatternList","CurveFont","CurveFontScaling","VisibleSegmentLength","InvisibleSegmentLength","DateComponent","TimeComponent","Elements","UnitType","UserDefinedType","Unit","Exponent","LengthExponent","MassExponent","TimeExponent","ElectricCurrentExponent","ThermodynamicTemperatureExponent","AmountOfSubstanceExponent","LuminousIntensityExponent","FileExtension","MimeContentType","MimeSubtype","DocumentId","DocumentReferences","IntendedUse","Scope","Revision","DocumentOwner","Editors","LastRevisionTime","ElectronicFormat","ValidFrom","ValidUntil","Confidentiality","Status","RelatingDocument","RelatedDocuments","RelationshipType","RelatingDraughtingCallout","RelatedDraughtingCallout","ImpactType","Category","UserDefinedCategory","Location","ItemReference","AxisTag","AxisCurve","SameSense","TimeStamp","ListValues","Publisher","VersionDate","LibraryReference","MainPlaneAngle","SecondaryPlaneAngle","LuminousIntensity","LightDistributionCurve","DistributionData","HourComponent","MinuteComponent","SecondComponent","Zone","DaylightSavingOffset","MaterialClassifications","ClassifiedMaterial","Material","LayerThickness","IsVentilated","MaterialLayers","LayerSetName","ForLayerSet","LayerSetDirection","DirectionSense","OffsetFromReferenceLine","Materials","ValueComponent","UnitComponent","DynamicViscosity","YoungModulus","ShearModulus","PoissonRatio","ThermalExpansionCoefficient","YieldStress","UltimateStress","UltimateStrain","HardeningModule","ProportionalStress","PlasticStrain","Relaxations","Benchmark","ValueSource","DataValue","Currency","Dimensions","BenchmarkValues","ResultValues","ObjectiveQualifier","UserDefinedQualifier","VisibleTransmittance","SolarTransmittance","ThermalIrTransmittance","ThermalIrEmissivityBack","ThermalIrEmissivityFront","VisibleReflectanceBack","VisibleReflectanceFront","SolarReflectanceFront","SolarReflectanceBack","Id","Roles","Addresses","RelatingOrganization","RelatedOrganizations","OwningUser","OwningApplication","State","ChangeAction","LastModifiedDate","LastModifyingUser","LastModifyingApplication","CreationDate","FamilyName","GivenName","MiddleNames","PrefixTitles","SuffixTitles","ThePerson","TheOrganization","InternalLocation","AddressLines","PostalBox","Town","Region","PostalCode","Country","AssignedItems","LayerOn","LayerFrozen","LayerBlocked","LayerStyles","Styles","Representations","SpecificHeatCapacity","N20Content","COContent","CO2Content","ProfileType","ProfileName","ProfileDefinition","RelatedProperties","DependingProperty","DependantProperty","Expression","EnumerationValues","AreaValue","CountValue","LengthValue","TimeValue","VolumeValue","WeightValue","ReferencedDocument","ReferencingValues","TotalCrossSectionArea","SteelGrade","BarSurface","EffectiveDepth","NominalBarDiameter","BarCount","RelaxationValue","InitialStress","ContextOfItems","RepresentationIdentifier","RepresentationType","Items","ContextIdentifier","ContextType","MappingOrigin","MappedRepresentation","Thickness","RibHeight","RibWidth","RibSpacing","Direction","GlobalId","OwnerHistory","Prefix","SectionType","StartProfile","EndProfile","LongitudinalStartPosition","LongitudinalEndPosition","TransversePosition","ReinforcementRole","SectionDefinition","CrossSectionReinforcementDefinitions","ShapeRepresentations","ProductDefinitional","PartOfProductDefinitionShape","DeltaT_Constant","DeltaT_Y","DeltaT_Z","Item","Side","DiffuseTransmissionColour","DiffuseReflectionColour","TransmissionColour","ReflectanceColour","RefractionIndex","DispersionFactor","SurfaceColour","Textures","RepeatS","RepeatT","TextureType","TextureTransform","StyleOfSymbol","Rows","RowCells","IsHeading","TelephoneNumbers","FacsimileNumbers","PagerNumber","ElectronicMailAddresses","WWWHomePageURL","TextCharacterAppearance","TextStyle","TextFontStyle","FontFamily","FontStyle","FontVariant","FontWeight","FontSize","Colour","BackgroundColour","TextIndent","TextAlign","TextDecoration","LetterSpacing","WordSpacing","TextTransform","LineHeight","BoxHeight","BoxWidth","BoxSlantAngle","BoxRotateAngle","CharacterSpacing","Mode","Parameter","TextureMaps","Coordinates","BoilingPoint","FreezingPoint","ThermalConductivity","StartTime","EndTime","TimeSeriesDataType","DataOrigin","UserDefinedDataOrigin","ReferencedTimeSeries","TimeSeriesReferences","Units","TextureVertices","TexturePoints","VertexGeometry","IntersectingAxes","OffsetDistances","IsPotable","Hardness","AlkalinityConcentration","AcidityConcentration","ImpuritiesContent","PHLevel","DissolvedSolidsContent","OuterCurve","Curve","InnerCurves","RasterFormat","RasterCode","ReferencedSource","Red","Green","Blue","UsageName","HasProperties","Profiles","Label","CfsFaces","CurveOnRelatingElement","CurveOnRelatedElement","EccentricityInX","EccentricityInY","EccentricityInZ","ConversionFactor","CurveWidth","CurveColour","ParentProfile","Operator","EdgeStart","EdgeEnd","EdgeGeometry","ExtendedProperties","Bounds","Bound","Orientation","FaceSurface","TensionFailureX","TensionFailureY","TensionFailureZ","CompressionFailureX","CompressionFailureY","CompressionFailureZ","FillStyles","CombustionTemperature","CarbonContent","LowerHeatingValue","HigherHeatingValue","MolecularWeight","Porosity","MassDensity","PhysicalWeight","Perimeter","MinimumPlateThickness","MaximumPlateThickness","CrossSectionArea","CoordinateSpaceDimension","Precision","WorldCoordinateSystem","TrueNorth","ParentContext","TargetScale","TargetView","UserDefinedTargetView","PlacementLocation","PlacementRefDirection","BaseSurface","AgreementFlag","UpperVaporResistanceFactor","LowerVaporResistanceFactor","IsothermalMoistureCapacity","VaporPermeability","MoistureDiffusivity","UrlReference","Values","LightColour","AmbientIntensity","Intensity","Position","ColourAppearance","ColourTemperature","LuminousFlux","LightEmissionSource","LightDistributionDataSource","Radius","ConstantAttenuation","DistanceAttenuation","QuadricAttenuation","ConcentrationExponent","SpreadAngle","BeamWidthAngle","PlacementRelTo","RelativePlacement","MappingSource","MappingTarget","RepresentedMaterial","CompressiveStrength","MaxAggregateSize","AdmixturesDescription","Workability","ProtectivePoreRatio","WaterImpermeability","RepeatFactor","EdgeElement","EdgeList","HasQuantities","Discrimination","Quality","Usage","Width","Height","ColourComponents","Pixel","SizeInX","SizeInY","BasisCurve","PointParameter","BasisSurface","PointParameterU","PointParameterV","Polygon","PolygonalBoundary","UpperBoundValue","LowerBoundValue","EnumerationReference","PropertyReference","NominalValue","DefiningValues","DefinedValues","DefiningUnit","DefinedUnit","XDim","YDim","TimeStep","DefinitionType","ReinforcementSectionDefinitions","RoundingRadius","SpineCurve","CrossSections","CrossSectionPositions","PredefinedType","UpperValue","MostUsedValue","LowerValue","SbsmBoundary","SlippageX","SlippageY","SlippageZ","IsAttenuating","SoundScale","SoundValues","SoundLevelTimeSeries","Frequency","SoundLevelSingleValue","ApplicableValueRatio","ThermalLoadSource","PropertySource","SourceDescription","MaximumValue","MinimumValue","ThermalLoadTimeSeriesValues","UserDefinedThermalLoadSource","UserDefinedPropertySource","ThermalLoadType","LinearForceX","LinearForceY","LinearForceZ","LinearMomentX","LinearMomentY","LinearMomentZ","PlanarForceX","PlanarForceY","PlanarForceZ","DisplacementX","DisplacementY","DisplacementZ","RotationalDisplacementRX","RotationalDisplacementRY","RotationalDisplacementRZ","Distortion","ForceX","ForceY","ForceZ","MomentX","MomentY","MomentZ","WarpingMoment","TorsionalConstantX","MomentOfInertiaYZ","MomentOfInertiaY","MomentOfInertiaZ","WarpingConstant","ShearCentreZ","ShearCentreY","ShearDeformationAreaZ","ShearDeformationAreaY","MaximumSectionModulusY","MinimumSectionModulusY","MaximumSectionModulusZ","MinimumSectionModulusZ","TorsionalSectionModulus","CentreOfGravityInX","CentreOfGravityInY","ShearAreaZ","ShearAreaY","PlasticShapeFactorY","PlasticShapeFactorZ","ParentEdge","Transparency","DiffuseColour","ReflectionColour","SpecularColour","SpecularHighlight","ReflectanceMethod","SweptArea","Directrix","InnerRadius","StartParam","EndParam","SweptCurve","Depth","FlangeWidth","WebThickness","FlangeThickness","FilletRadius","FlangeEdgeRadius","WebEdgeRadius","WebSlope","FlangeSlope","AnnotatedCurve","Literal","Placement","Path","Extent","BoxAlignment","BottomXDim","TopXDim","TopXOffset","SecondRepeatFactor","ApplicableOccurrence","HasPropertySets","RepresentationMaps","Tag","EdgeRadius","Magnitude","LoopVertex","LiningDepth","LiningThickness","TransomThickness","MullionThickness","FirstTransomOffset","SecondTransomOffset","FirstMullionOffset","SecondMullionOffset","ShapeAspectStyle","OperationType","PanelPosition","FrameDepth","FrameThickness","ConstructionType","ParameterTakesPrecedence","Sizeable","OuterBoundary","InnerBoundaries","FillStyleTarget","GlobalOrLocal","TextureCoordinates","Axis","RefDirection","FirstOperand","SecondOperand","Corner","ZDim","Enclosure","WallThickness","Girth","InternalFilletRadius","Axis1","Axis2","LocalOrigin","Scale","Scale2","Axis3","Scale3","Transition","ParentCurve","OverallHeight","BaseWidth2","HeadWidth","HeadDepth2","HeadDepth3","BaseWidth4","BaseDepth1","BaseDepth2","BaseDepth3","TreeRootExpression","Definition","Target","DirectionRatios","ThresholdDepth","ThresholdThickness","TransomOffset","LiningOffset","ThresholdOffset","CasingThickness","CasingDepth","PanelDepth","PanelOperation","PanelWidth","Contents","MethodOfMeasurement","Quantities","ElementType","SemiAxis1","SemiAxis2","EnergySequence","UserDefinedEnergySequence","ExtrudedDirection","FbsmFaces","HatchLineAppearance","StartOfNextHatchLine","PointOfReferenceHatchLine","PatternStart","HatchLineAngle","Symbol","TilingPattern","Tiles","TilingScale","FlowConditionTimeSeries","VelocityTimeSeries","FlowrateTimeSeries","Fluid","PressureTimeSeries","TemperatureSingleValue","WetBulbTemperatureSingleValue","WetBulbTemperatureTimeSeries","TemperatureTimeSeries","FlowrateSingleValue","FlowConditionSingleValue","VelocitySingleValue","PressureSingleValue","AssemblyPlace","OverallWidth","OverallDepth","LegSlope","Pnt","Dir","Outer","ObjectType","Distance","SelfIntersect","ObjectPlacement","Representation","LongName","Phase","RepresentationContexts","UnitsInContext","ProxyType","InnerFilletRadius","OuterFilletRadius","XLength","YLength","U1","V1","U2","V2","Usense","Vsense","RelatedObjects","RelatedObjectsType","RelatingActor","ActingRole","RelatingControl","RelatingGroup","RelatingProcess","QuantityInProcess","RelatingProduct","RelatingResource","RelatingAppliedValue","RelatingClassification","Intent","RelatingLibrary","RelatingMaterial","RelatingProfileProperties","ProfileSectionLocation","ProfileOrientation","ConnectionGeometry","RelatingElement","RelatedElement","RelatingPriorities","RelatedPriorities","RelatedConnectionType","RelatingConnectionType","RelatingPort","RelatedPort","RealizingElement","RelatedStructuralActivity","RelatedStructuralMember","RelatingStructuralMember","RelatedStructuralConnection","AppliedCondition","AdditionalConditions","SupportedLength","ConditionCoordinateSystem","ConnectionConstraint","RealizingElements","ConnectionType","RelatedElements","RelatingStructure","RelatingBuildingElement","RelatedCoverings","RelatedSpace","RelatingObject","RelatingPropertyDefinition","RelatingType","RelatingOpeningElement","RelatedBuildingElement","RelatedControlElements","RelatingFlowElement","DailyInteraction","ImportanceRating","LocationOfInteraction","RelatedSpaceProgram","RelatingSpaceProgram","OverridingProperties","RelatedFeatureElement","RelatedProcess","TimeLag","SequenceType","RelatingSystem","RelatedBuildings","RelatingSpace","PhysicalOrVirtualBoundary","InternalOrExternalBoundary","RelatedOpeningElement","Angle","BottomRadius","CompositionType","AppliedLoad","SubsequentThickness","VaryingThicknessLocation","ReferenceSurface","AxisPosition","TaskId","WorkMethod","IsMilestone","Priority","TheActor","TopFlangeWidth","TopFlangeThickness","TopFlangeFilletRadius","ZLength","ElevationOfRefHeight","ElevationOfTerrain","BuildingAddress","Elevation","Segments","ResourceIdentifier","ResourceGroup","ResourceConsumption","BaseQuantity","SubmittedBy","PreparedBy","SubmittedOn","TargetUsers","UpdateDate","ID","ElectricCurrentType","InputVoltage","InputFrequency","FullLoadCurrent","MinimumCircuitCurrent","MaximumPowerInput","RatedPowerInput","InputPhase","Voids","UAxes","VAxes","WAxes","InventoryType","Jurisdiction","ResponsiblePersons","LastUpdateDate","CurrentValue","OriginalValue","SkillSet","NominalDiameter","NominalLength","MoveFrom","MoveTo","PunchList","ActionID","LifeCyclePhase","PermitID","Points","ProcedureID","ProcedureType","UserDefinedProcedureType","Records","TimeForTask","ActualStart","EarlyStart","LateStart","ScheduleStart","ActualFinish","EarlyFinish","LateFinish","ScheduleFinish","ScheduleDuration","ActualDuration","RemainingTime","FreeFloat","TotalFloat","IsCritical","StatusTime","StartFloat","FinishFloat","Completion","ServiceLifeType","ServiceLifeDuration","RefLatitude","RefLongitude","RefElevation","LandTitleNumber","SiteAddress","InteriorOrExteriorSpace","ElevationWithFlooring","SpaceProgramIdentifier","MaxRequiredArea","MinRequiredArea","RequestedLocation","StandardRequiredArea","DestabilizingLoad","CausedBy","ProjectedOrTrue","VaryingAppliedLoadLocation","SubsequentAppliedLoads","ActionType","ActionSource","Coefficient","TheoryType","ResultForLoadGroup","IsLinear","SubContractor","JobDescription","ApplicableDates","TimeSeriesScheduleType","TimeSeries","CapacityByWeight","CapacityByNumber","Trim1","Trim2","SenseAgreement","MasterRepresentation","Creators","Duration","FinishTime","WorkControlType","UserDefinedControlType","RequestID","AssetID","TotalReplacementCost","Owner","User","ResponsiblePerson","IncorporationDate","DepreciatedValue","Degree","ControlPointsList","CurveForm","ClosedCurve","Criterion","CriterionDateTime","Suppliers","UsageRatio","FlowDirection","FeatureLength","ShapeType","WeightsData","MeshLength","MeshWidth","LongitudinalBarNominalDiameter","TransverseBarNominalDiameter","LongitudinalBarCrossSectionArea","TransverseBarCrossSectionArea","LongitudinalBarSpacing","TransverseBarSpacing","NumberOfRiser","NumberOfTreads","RiserHeight","TreadLength","OrientationOf2DPlane","LoadedBy","HasResults","TensionForce","PreStress","FrictionCoefficient","AnchorageSlip","MinCurvatureRadius","ControlElementId","DistributionPointFunction","UserDefinedFunction","BarLength","BarRole","TimeOfApproval","Level","Qualifier","RequestingApproval","GivingApproval","TranslationalStiffnessByLengthX","TranslationalStiffnessByLengthY","TranslationalStiffnessByLengthZ","TranslationalStiffnessByAreaX","TranslationalStiffnessByAreaY","TranslationalStiffnessByAreaZ","TranslationalStiffnessX","TranslationalStiffnessY","TranslationalStiffnessZ","VolumeOnRelatingElement","VolumeOnRelatedElement","SourceCRS","TargetCRS","GeodeticDatum","VerticalDatum","Identification","Language","ReferencedLibrary","Eastings","Northings","OrthogonalHeight","XAxisAbscissa","XAxisOrdinate","OffsetDirection","OffsetValues","Profile","MaterialProfiles","CompositeProfile","ReferencePath","MapProjection","MapZone","MapUnit","Formula","RecurrenceType","WeekdayComponent","Interval","Occurrences","TimePeriods","TypeIdentifier","AttributeIdentifier","InstanceName","ListPositions","InnerReference","Locations","DeltaTConstant","DeltaTY","DeltaTZ","SurfaceReinforcement1","SurfaceReinforcement2","ShearReinforcement","Columns","DurationType","Recurrence","MessagingIDs","ModelOrDraughting","Maps","Vertices","MappedTo","TexCoordsList","RecurrencePattern","Start","Finish","RelatedApprovals","ReferenceTokens","Sort","ColourList","ConversionOffset","ActualDate","EarlyDate","LateDate","ScheduleDate","Properties","RelatingReference","RelatedResourceObjects","ModelorDraughting","URLReference","Opacity","Colours","ColourIndex","TexCoords","TexCoordIndex","LagValue","Fraction","MaterialConstituents","ReferenceExtent","ForProfileSet","CardinalPoint","ForProfileEndSet","CardinalEndPoint","RelatedMaterials","ScheduleWork","ScheduleUsage","ScheduleContour","LevelingDelay","IsOverAllocated","ActualWork","ActualUsage","RemainingWork","RemainingUsage","LongDescription","ProcessType","ResourceType","BottomFlangeWidth","BottomFlangeThickness","BottomFlangeFilletRadius","BottomFlangeEdgeRadius","BottomFlangeSlope","TopFlangeEdgeRadius","TopFlangeSlope","CoordList","BaseCosts","Boundaries","ImplicitOuter","EventTriggerType","UserDefinedEventTriggerType","EndSweptArea","FixedReference","CoordIndex","InnerCoordIndices","ReferenceCurve","SetPointValue","TemplateType","ApplicableEntity","HasPropertyTemplates","CurveInterpolation","Factor","RelatingContext","RelatedDefinitions","RelatedPropertySets","RelatingTemplate","InterferenceGeometry","InterferenceType","ImpliedOrder","UserDefinedSequenceType","ParentBoundary","CorrespondingBoundary","ParamLength","PrimaryMeasureType","SecondaryMeasureType","Enumerators","PrimaryUnit","SecondaryUnit","AccessState","Curve3D","AssociatedGeometry","TaskTime","MajorRadius","MinorRadius","Normals","Closed","PnIndex","LiningToPanelOffsetX","LiningToPanelOffsetY","UDegree","VDegree","SurfaceForm","UClosed","VClosed","UMultiplicities","VMultiplicities","UKnots","VKnots","KnotSpec","CostValues","CostQuantities","UserDefinedOperationType","EventOccurenceTime","Faces","BendingShapeCode","BendingParameters","SheathDiameter","PartitioningType","UserDefinedPartitioningType","WorkingTimes","ExceptionTimes","KnotMultiplicities","Knots","SystemType","NumberOfRisers","SharedPlacement","SelfWeightCoefficients","StartTag","EndTag","StartDistAlong","HorizontalLength","StartHeight","StartGradient","EndGradient","RadiusOfCurvature","PrimeMeridian","AngleUnit","HeightUnit","FactorX","FactorY","FactorZ","NumberValue","FirstCoordinate","SecondCoordinate","TexCoordsOf","InnerTexCoordIndices","WellKnownText","CoordinateReferenceSystem","StartDate","FinishDate","StartCantLeft","EndCantLeft","StartCantRight","EndCantRight","StartPoint","StartDirection","StartRadiusOfCurvature","EndRadiusOfCurvature","SegmentLength","GravityCenterLineHeight","Specification","CurveStyleFont","CartesianPosition","MaterialExpression","HorizontalWidths","Widths","Slopes","Tags","OffsetPoint","DistanceAlong","OffsetLateral","OffsetVertical","OffsetLongitudinal","TagList","SegmentStart","TexCoordIndices","CoefficientsX","CoefficientsY","CoefficientsZ","RelatingProfileDef","InterferenceSpace","RelatingPositioningElement","RelatedProducts","CubicTerm","QuadraticTerm","LinearTerm","ConstantTerm","Flags","ClothoidConstant","CosineTerm","UsageType","BaseCurve","EndPoint","RelatedSurfaceFeatures","SepticTerm","SexticTerm","QuinticTerm","QuarticTerm","SineTerm","AxisDirection","RailHeadDistance","DesignParameters",};
+std::string_view getPropertyName(IFC_SCHEMA schema,uint32_t typeCode,uint32_t prop) {
 if (schema == IFC2X3) {
 switch (typeCode) {
 case  3630933823:
@@ -22208,7 +22208,7 @@ case 8: return propyNames[490];
 }
 }
 }
-std::array<uint32_t,1215> propTypeNames = {3869224543,3258342251,2801250643,33568735,4251960020,983778844,2887218128,2597039031,2679630077,411424972,373436428,1728812236,130549933,3630933823,2598011224,2173214787,1052454078,1753493141,1307019551,3211557302,1718600412,86635668,765770214,4065007721,622194075,3639012971,747523909,1767535486,3931646380,382301979,3958567839,2844211000,4111266820,1959218052,2449831054,2680653174,2589826445,102610177,1641986514,2706619895,1245737093,1072939445,2655187982,3510044353,3345948710,1243674935,2815919920,30780891,1045800335,124742581,1918398963,1718147282,3732053477,1376555844,2885466731,4068098364,1154170062,3073041342,3376698491,2601014836,2735952531,3521532855,3452421091,4042175685,2755797622,881902783,4162380809,2766185779,1065062679,300323983,1838606355,503418787,248100487,3303938423,1469346588,3389681023,1103567559,69416015,3341486342,2281867870,3665567075,1222501353,207745069,1042063629,2917043736,2949456006,1197507443,3368373690,1962769620,618182010,101040310,639542469,4223916898,531202833,2591213694,2077209135,939592812,148024130,287783114,1076942058,3477203348,2321227483,2650437152,1778710042,2726807636,3458127941,3124614049,3247369562,1190328964,2095195183,3377609919,3008791417,274646400,3064340077,1207048766,1787361927,542029231,2342653256,3202202375,2042790032,1580146022,3982875396,673634403,743184107,2417041796,2785408664,1225378771,776857604,200335297,626085974,3049289330,1381336441,3749851601,2597065344,1850111279,531007025,916597516,2562834741,1286164555,603696268,1102727119,2715512545,2590844177,1570177309,3052078743,1460886941,3490877962,296282323,1844851602,3304826586,2260317790,2645777649,1432008316,290688911,3101149627,1210645708,1123145078,2067069095,852622518,3686016028,929793134,1260505505,2556980723,4149869811,3733406562,2799835756,1809719519,1008929658,2513912981,1361398929,544876936,1158859006,1648970520,1477762836,3531705166,4134073009,32440307,3448662350,1131349010,3346224455,891718957,3192672207,3345633955,3177669450,3020489413,2740243338,2095003142,3034186359,3739410009,3054510233,3701648758,1660063152,59481748,1417489154,3900360178,3125803723,1029017970,2483315170,1939436016,3710013099,1430971844,581633288,4165799628,3732776249,387828814,990564147,2298722686,3657550814,1202362311,3044325142,1050256046,2895544493,506871491,1364037233,85334491,191860431,2128979029,2642773653,94842927,1278329552,3114022597,51269191,3467162246,1877383524,3921983062,1011845978,3288037868,2169031380,1152197495,1663979128,1867003952,3357820518,867548509,2324037503,278839091,3672713367,1074166056,3637616042,2453401579,280115917,3054888242,1532845080,2581212453,1914407012,717039860,220341763,2460950869,3481340091,3571493279,2872136011,509816776,2721224556,2504768628,1025434211,370225590,3800577675,2356011799,3612888222,2833995503,4250110687,3086160713,1925676203,2205249479,3446698506,2095639259,180925521,1545711075,219451334,2296667514,3293443760,2706460486,2945172077,4208778838,2914609552,2341007311,288382656,4274534246,2802850158,2898209111,2859738748,1758889154,2128902557,3740093272,2688182192,3544373492,530289379,1179482911,4037036970,2273995522,2706606064,1973544240,3856911033,3888040117,1628702193,3588315303,1062813311,3040386961,652456506,2143335405,628493158,2254336722,64643665,1687521235,1287392070,4261334040,690167070,2162789131,3337205297,3740788744,3355820592,1460979143,2485617015,3924139846,672692152,2966862399,2451242878,1021431103,2506197118,3790457270,2841622424,1002142388,554647353,2973211341,1154284921,1007984134,237118112,2774431236,602808272,1844818999,185388416,4215032627,3818625751,527936033,3349296550,103775553,3531860660,2293803863,661370862,3037870609,1551283683,3372526763,386187035,3739419792,473029300,1491040762,1040890966,3517283431,1367202144,2934217365,3812528620,639531123,1855850635,1455546828,3956248403,3038022802,3689010777,1094947699,960326014,2602792976,2261624226,126693432,96294661,2506162743,1252848954,1942645678,3300536621,4121373105,291444547,437759802,3407053508,3627328112,935604799,3594581223,3551551017,3676660675,3340908731,1269596434,1239913253,1797193231,3573632694,358033588,3726661758,1913101020,54623293,1501183454,649472068,1693487766,1760651496,798148481,3453182476,3089591714,3405941096,668377315,2079224331,8322439,2183683140,376935608,1280103771,1875623387,1290156191,3044747827,3185663589,3531917241,667340609,1262424489,3754373064,3959380518,2793383123,897523405,4155216521,2974343352,2457772935,3995464546,1736192930,1098295817,2319738306,3881097202,2986769608,3917635812,1282226622,815500815,4164688622,3805913727,3470481846,937566702,2195413836,613796396,4241973650,1880189351,972054012,2509546566,854899952,11730523,2853304871,1466758467,950732822,1275358634,49088397,525895558,2235152071,1485152156,2433181523,3119450353,1390679141,3701338814,1199560280,4021806647,609421318,3172978893,2043862942,3555794193,2541165894,3915482550,2636378356,1640371178,4075327185,2314439260,3714063296,3200245327,4036359239,440562759,2387106220,3285139300,1790229001,3611470254,3242977126,3708119000,164193824,1683019596,760658860,2952703181,1136057603,1401066283,3717035687,3958052878,1639589134,460077198,1162880614,606860825,3521284610,3547450287,1959371038,2211051443,2207572250,736530666,1945004755,1412071761,3419103109,49845113,492091185,1585845231,4134219045,3523091289,1521410863,3841475323,3647622174,316539858,2860242611,4008630002,1682466193,960210175,1021971458,1549132990,384449397,2059837836,37940459,2053683727,627898853,1692979113,91683625,3593671318,506783830,1042787934,683809370,1970628803,4016286979,3462168616,211053100,2244117335,3041753155,574549367,183626358,2548949139,962935207,3989067775,2874063949,571176181,3061959087,178912537,1897649832,1385270127,2739565819,1823282114,244819378,3876018962,2680421541,652748602,1479426229,3288126668,255461614,1932549289,1236880293,1471118587,2706281606,3098684301,4151168619,2981638260,3476419373,3114819794,1973315761,2089642407,614319689,697765865,860830233,922449830,365584592,3344706444,2749697471,145283476,3301026240,1505327130,2395907400,2149462589,2969962241,3194911961,3425423356,3166912612,2004835150,222769930,2165702409,1805707277,1837433645,463610769,1946335990,2394031724,1184275752,3733744356,823603102,1420568751,2447993252,1019252178,3178974365,4013007887,2615076639,3099164984,4135496989,1095732595,423474865,2707447046,3294834125,1938929368,2906317437,827741273,2181869104,1718859833,3101698114,1464019863,3629595153,3160627042,1506544127,2641080392,859079163,1672225696,2630368378,2879124712,3124462625,1536983066,492794765,1338660958,4218053802,1906401893,3829999316,1268632640,2872680054,1128263546,2875026444,2326367582,};
+constexpr std::array<uint32_t,1215> propTypeNames = {3869224543,3258342251,2801250643,33568735,4251960020,983778844,2887218128,2597039031,2679630077,411424972,373436428,1728812236,130549933,3630933823,2598011224,2173214787,1052454078,1753493141,1307019551,3211557302,1718600412,86635668,765770214,4065007721,622194075,3639012971,747523909,1767535486,3931646380,382301979,3958567839,2844211000,4111266820,1959218052,2449831054,2680653174,2589826445,102610177,1641986514,2706619895,1245737093,1072939445,2655187982,3510044353,3345948710,1243674935,2815919920,30780891,1045800335,124742581,1918398963,1718147282,3732053477,1376555844,2885466731,4068098364,1154170062,3073041342,3376698491,2601014836,2735952531,3521532855,3452421091,4042175685,2755797622,881902783,4162380809,2766185779,1065062679,300323983,1838606355,503418787,248100487,3303938423,1469346588,3389681023,1103567559,69416015,3341486342,2281867870,3665567075,1222501353,207745069,1042063629,2917043736,2949456006,1197507443,3368373690,1962769620,618182010,101040310,639542469,4223916898,531202833,2591213694,2077209135,939592812,148024130,287783114,1076942058,3477203348,2321227483,2650437152,1778710042,2726807636,3458127941,3124614049,3247369562,1190328964,2095195183,3377609919,3008791417,274646400,3064340077,1207048766,1787361927,542029231,2342653256,3202202375,2042790032,1580146022,3982875396,673634403,743184107,2417041796,2785408664,1225378771,776857604,200335297,626085974,3049289330,1381336441,3749851601,2597065344,1850111279,531007025,916597516,2562834741,1286164555,603696268,1102727119,2715512545,2590844177,1570177309,3052078743,1460886941,3490877962,296282323,1844851602,3304826586,2260317790,2645777649,1432008316,290688911,3101149627,1210645708,1123145078,2067069095,852622518,3686016028,929793134,1260505505,2556980723,4149869811,3733406562,2799835756,1809719519,1008929658,2513912981,1361398929,544876936,1158859006,1648970520,1477762836,3531705166,4134073009,32440307,3448662350,1131349010,3346224455,891718957,3192672207,3345633955,3177669450,3020489413,2740243338,2095003142,3034186359,3739410009,3054510233,3701648758,1660063152,59481748,1417489154,3900360178,3125803723,1029017970,2483315170,1939436016,3710013099,1430971844,581633288,4165799628,3732776249,387828814,990564147,2298722686,3657550814,1202362311,3044325142,1050256046,2895544493,506871491,1364037233,85334491,191860431,2128979029,2642773653,94842927,1278329552,3114022597,51269191,3467162246,1877383524,3921983062,1011845978,3288037868,2169031380,1152197495,1663979128,1867003952,3357820518,867548509,2324037503,278839091,3672713367,1074166056,3637616042,2453401579,280115917,3054888242,1532845080,2581212453,1914407012,717039860,220341763,2460950869,3481340091,3571493279,2872136011,509816776,2721224556,2504768628,1025434211,370225590,3800577675,2356011799,3612888222,2833995503,4250110687,3086160713,1925676203,2205249479,3446698506,2095639259,180925521,1545711075,219451334,2296667514,3293443760,2706460486,2945172077,4208778838,2914609552,2341007311,288382656,4274534246,2802850158,2898209111,2859738748,1758889154,2128902557,3740093272,2688182192,3544373492,530289379,1179482911,4037036970,2273995522,2706606064,1973544240,3856911033,3888040117,1628702193,3588315303,1062813311,3040386961,652456506,2143335405,628493158,2254336722,64643665,1687521235,1287392070,4261334040,690167070,2162789131,3337205297,3740788744,3355820592,1460979143,2485617015,3924139846,672692152,2966862399,2451242878,1021431103,2506197118,3790457270,2841622424,1002142388,554647353,2973211341,1154284921,1007984134,237118112,2774431236,602808272,1844818999,185388416,4215032627,3818625751,527936033,3349296550,103775553,3531860660,2293803863,661370862,3037870609,1551283683,3372526763,386187035,3739419792,473029300,1491040762,1040890966,3517283431,1367202144,2934217365,3812528620,639531123,1855850635,1455546828,3956248403,3038022802,3689010777,1094947699,960326014,2602792976,2261624226,126693432,96294661,2506162743,1252848954,1942645678,3300536621,4121373105,291444547,437759802,3407053508,3627328112,935604799,3594581223,3551551017,3676660675,3340908731,1269596434,1239913253,1797193231,3573632694,358033588,3726661758,1913101020,54623293,1501183454,649472068,1693487766,1760651496,798148481,3453182476,3089591714,3405941096,668377315,2079224331,8322439,2183683140,376935608,1280103771,1875623387,1290156191,3044747827,3185663589,3531917241,667340609,1262424489,3754373064,3959380518,2793383123,897523405,4155216521,2974343352,2457772935,3995464546,1736192930,1098295817,2319738306,3881097202,2986769608,3917635812,1282226622,815500815,4164688622,3805913727,3470481846,937566702,2195413836,613796396,4241973650,1880189351,972054012,2509546566,854899952,11730523,2853304871,1466758467,950732822,1275358634,49088397,525895558,2235152071,1485152156,2433181523,3119450353,1390679141,3701338814,1199560280,4021806647,609421318,3172978893,2043862942,3555794193,2541165894,3915482550,2636378356,1640371178,4075327185,2314439260,3714063296,3200245327,4036359239,440562759,2387106220,3285139300,1790229001,3611470254,3242977126,3708119000,164193824,1683019596,760658860,2952703181,1136057603,1401066283,3717035687,3958052878,1639589134,460077198,1162880614,606860825,3521284610,3547450287,1959371038,2211051443,2207572250,736530666,1945004755,1412071761,3419103109,49845113,492091185,1585845231,4134219045,3523091289,1521410863,3841475323,3647622174,316539858,2860242611,4008630002,1682466193,960210175,1021971458,1549132990,384449397,2059837836,37940459,2053683727,627898853,1692979113,91683625,3593671318,506783830,1042787934,683809370,1970628803,4016286979,3462168616,211053100,2244117335,3041753155,574549367,183626358,2548949139,962935207,3989067775,2874063949,571176181,3061959087,178912537,1897649832,1385270127,2739565819,1823282114,244819378,3876018962,2680421541,652748602,1479426229,3288126668,255461614,1932549289,1236880293,1471118587,2706281606,3098684301,4151168619,2981638260,3476419373,3114819794,1973315761,2089642407,614319689,697765865,860830233,922449830,365584592,3344706444,2749697471,145283476,3301026240,1505327130,2395907400,2149462589,2969962241,3194911961,3425423356,3166912612,2004835150,222769930,2165702409,1805707277,1837433645,463610769,1946335990,2394031724,1184275752,3733744356,823603102,1420568751,2447993252,1019252178,3178974365,4013007887,2615076639,3099164984,4135496989,1095732595,423474865,2707447046,3294834125,1938929368,2906317437,827741273,2181869104,1718859833,3101698114,1464019863,3629595153,3160627042,1506544127,2641080392,859079163,1672225696,2630368378,2879124712,3124462625,1536983066,492794765,1338660958,4218053802,1906401893,3829999316,1268632640,2872680054,1128263546,2875026444,2326367582,};
 uint32_t getPropertyTypeCode(IFC_SCHEMA schema,uint32_t typeCode,uint32_t prop) {
 if (schema == IFC2X3) {
 switch (typeCode) {
@@ -0,0 +1,111 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace webifc::utility
+{
+
+    // the monotonic arena of one thread for the buffers that live while one element is meshed. Containers allocated from
+    // it must be gone by the time the outermost ArenaScope of the thread ends, which is when its memory is reused
+    class ThreadArena
+    {
+    public:
+        static constexpr size_t INITIAL_SIZE = 256 * 1024;
+        // the buffer reused between elements does not grow beyond this, larger elements take the rest from the heap
+        static constexpr size_t MAX_SIZE = 16 * 1024 * 1024;
+
+        static ThreadArena &Get()
+        {
+            thread_local ThreadArena arena;
+            return arena;
+        }
+
+        // the arena inside an ArenaScope, the heap outside of one
+        std::pmr::memory_resource *Resource()
+        {
+            return _depth > 0 ? &*_resource : std::pmr::new_delete_resource();
+        }
+
+        void Enter()
+        {
+            _depth++;
+        }
+
+        // the outermost scope frees everything, the buffer grows to what the element took so that the next one fits
+        void Leave()
+        {
+            if (--_depth > 0) return;
+            const size_t used = _buffer.size() + _upstream.allocated;
+            _resource.reset();
+            _upstream.allocated = 0;
+            if (used > _buffer.size() && _buffer.size() < MAX_SIZE) _buffer.resize(std::min(used, MAX_SIZE));
+            _resource.emplace(_buffer.data(), _buffer.size(), &_upstream);
+        }
+
+    private:
+        // the heap, counting what the arena takes beyond its buffer
+        struct Upstream : std::pmr::memory_resource
+        {
+            size_t allocated = 0;
+
+            void *do_allocate(size_t bytes, size_t alignment) override
+            {
+                allocated += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void *p, size_t bytes, size_t alignment) override
+            {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+
+        ThreadArena() : _buffer(INITIAL_SIZE)
+        {
+            _resource.emplace(_buffer.data(), _buffer.size(), &_upstream);
+        }
+
+        std::vector<std::byte> _buffer;
+        Upstream _upstream;
+        std::optional<std::pmr::monotonic_buffer_resource> _resource;
+        uint32_t _depth = 0;
+    };
+
+    // meshing of one element on this thread, nested scopes share the arena of the outermost one
+    class ArenaScope
+    {
+    public:
+        ArenaScope()
+        {
+            ThreadArena::Get().Enter();
+        }
+
+        ~ArenaScope()
+        {
+            ThreadArena::Get().Leave();
+        }
+
+        ArenaScope(const ArenaScope &) = delete;
+        ArenaScope &operator=(const ArenaScope &) = delete;
+    };
+
+    inline std::pmr::memory_resource *TransientMemory()
+    {
+        return ThreadArena::Get().Resource();
+    }
+
+}
@@ -0,0 +1,62 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Helpers for the binary snapshots web-ifc writes, values are stored as raw bytes and vectors are prefixed by their size
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace webifc::utility
+{
+
+    template <typename T> void WriteValue(const std::function<void(char *, size_t)> &outputData, const T value)
+    {
+        outputData((char *)&value, sizeof(T));
+    }
+
+    template <typename T> void WriteValues(const std::function<void(char *, size_t)> &outputData, const std::vector<T> &values)
+    {
+        WriteValue<uint64_t>(outputData, values.size());
+        if (!values.empty()) outputData((char *)values.data(), values.size() * sizeof(T));
+    }
+
+    // reads what WriteValue and WriteValues wrote, reading past the end returns empty values and clears valid
+    struct BinaryReader
+    {
+        const char *data;
+        size_t size;
+        size_t offset = 0;
+        bool valid = true;
+
+        template <typename T> T Read()
+        {
+            T value{};
+            if (offset + sizeof(T) > size) valid = false;
+            else std::memcpy(&value, data + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        template <typename T> std::vector<T> ReadValues()
+        {
+            const uint64_t count = Read<uint64_t>();
+            std::vector<T> values;
+            if (!valid || count > (size - offset) / sizeof(T))
+            {
+                valid = false;
+                return values;
+            }
+            values.resize(count);
+            if (count > 0) std::memcpy(values.data(), data + offset, count * sizeof(T));
+            offset += count * sizeof(T);
+            return values;
+        }
+    };
+
+}
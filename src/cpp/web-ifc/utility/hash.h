@@ -0,0 +1,39 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace webifc::utility
+{
+
+    // 64 bit FNV-1a, for content hashes that have to be stable across runs and builds
+    class Fnv1a
+    {
+    public:
+        void Add(const void *data, const size_t size)
+        {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; i++) _hash = (_hash ^ bytes[i]) * PRIME;
+        }
+
+        template <typename T> void Add(const T &value)
+        {
+            Add(&value, sizeof(T));
+        }
+
+        uint64_t Get() const
+        {
+            return _hash;
+        }
+
+    private:
+        static constexpr uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+        static constexpr uint64_t PRIME = 1099511628211ULL;
+        uint64_t _hash = OFFSET_BASIS;
+    };
+
+}
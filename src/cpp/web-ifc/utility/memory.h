@@ -0,0 +1,69 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace webifc::utility
+{
+
+    // bytes a model holds by where they are held, the containers are estimated from their sizes and capacities, so the
+    // numbers follow growth closely but leave allocator overhead out
+    struct MemoryStats
+    {
+        // IfcTokenStream, evicted chunks are not held, their bytes are what reloading them takes
+        uint64_t loadedChunks = 0;
+        uint64_t evictedChunks = 0;
+        uint64_t loadedChunkBytes = 0;
+        uint64_t evictedChunkBytes = 0;
+        // the file kept for reloading evicted chunks, mapped files are left out as they live in the page cache, compressed
+        // files add what inflating them holds
+        uint64_t fileBytes = 0;
+        // IfcLoader
+        uint64_t lineTableBytes = 0;
+        uint64_t typeIndexBytes = 0;
+        uint64_t argumentIndexBytes = 0;
+        uint64_t inverseIndexBytes = 0;
+        uint64_t globalIdIndexBytes = 0;
+        // IfcGeometryLoader caches, summed over threads
+        uint64_t placementBytes = 0;
+        uint64_t pointBytes = 0;
+        uint64_t curveBytes = 0;
+        uint64_t profileBytes = 0;
+        uint64_t relationBytes = 0;
+        // IfcGeometryProcessor, the geometry stores of all threads
+        uint64_t geometryBytes = 0;
+
+        uint64_t GetTotal() const
+        {
+            return loadedChunkBytes + fileBytes + lineTableBytes + typeIndexBytes + argumentIndexBytes + inverseIndexBytes + globalIdIndexBytes + placementBytes + pointBytes + curveBytes + profileBytes + relationBytes + geometryBytes;
+        }
+    };
+
+    template <typename T>
+    uint64_t VectorBytes(const std::vector<T> &values)
+    {
+        return values.capacity() * sizeof(T);
+    }
+
+    // the bucket array and one node per element holding the value and the link to the next node
+    template <typename Map>
+    uint64_t MapBytes(const Map &map)
+    {
+        return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(typename Map::value_type) + sizeof(void *));
+    }
+
+    // with what the mapped vectors hold
+    template <typename Map>
+    uint64_t MapOfVectorsBytes(const Map &map)
+    {
+        uint64_t bytes = MapBytes(map);
+        for (const auto &entry : map) bytes += VectorBytes(entry.second);
+        return bytes;
+    }
+
+}
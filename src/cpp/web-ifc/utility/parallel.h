@@ -0,0 +1,371 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// threads are available natively and in the pthread (web-ifc-mt) wasm build only
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define WEBIFC_THREADS_ENABLED
+#endif
+
+namespace webifc::utility
+{
+
+    inline size_t GetThreadCount()
+    {
+#ifdef WEBIFC_THREADS_ENABLED
+        const size_t threads = std::thread::hardware_concurrency();
+        return threads == 0 ? 1 : threads;
+#else
+        return 1;
+#endif
+    }
+
+    // true while the thread runs work of ParallelFor or ParallelProduce, parallel work started from there runs on the
+    // thread itself so that nested calls do not multiply the threads
+    inline bool &InParallelWork()
+    {
+        thread_local bool inParallelWork = false;
+        return inParallelWork;
+    }
+
+    // runs task(i) for every i in [0, count) on up to `threads` threads, the calling thread included
+    template <typename Task>
+    void ParallelFor(const size_t count, const size_t threads, const Task &task)
+    {
+#ifdef WEBIFC_THREADS_ENABLED
+        const size_t workerCount = InParallelWork() ? 1 : std::min(threads, count);
+        if (workerCount > 1)
+        {
+            std::atomic<size_t> next = 0;
+            auto work = [&]()
+            {
+                InParallelWork() = true;
+                for (size_t i = next++; i < count; i = next++)
+                    task(i);
+                InParallelWork() = false;
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(workerCount - 1);
+            for (size_t i = 1; i < workerCount; i++)
+                workers.emplace_back(work);
+            work();
+            for (auto &worker : workers)
+                worker.join();
+            return;
+        }
+#else
+        (void)threads;
+#endif
+        for (size_t i = 0; i < count; i++)
+            task(i);
+    }
+
+    // runs produce(i) for every i in [0, count) on up to `threads` worker threads and hands the results to consume() on
+    // the calling thread, in batches of batchSize in the order they complete. Every worker keeps what setup() returns
+    // while it works, and workers wait while a few batches are already waiting to be consumed
+    template <typename Setup, typename Produce, typename Consume>
+    void ParallelProduce(const size_t count, const size_t threads, const size_t batchSize, const Setup &setup, const Produce &produce, const Consume &consume)
+    {
+        using Result = decltype(produce(size_t(0)));
+#ifdef WEBIFC_THREADS_ENABLED
+        const size_t workerCount = InParallelWork() ? 1 : std::min(threads, count);
+        if (workerCount > 1 && batchSize > 0)
+        {
+            std::mutex mutex;
+            std::condition_variable readyCondition;
+            std::condition_variable spaceCondition;
+            std::vector<Result> ready;
+            size_t produced = 0;
+            const size_t maxReady = batchSize * 4;
+            std::atomic<size_t> next = 0;
+            auto work = [&]()
+            {
+                InParallelWork() = true;
+                [[maybe_unused]] auto state = setup();
+                for (size_t i = next++; i < count; i = next++)
+                {
+                    Result result = produce(i);
+                    std::unique_lock<std::mutex> lock(mutex);
+                    spaceCondition.wait(lock, [&]() { return ready.size() < maxReady; });
+                    ready.push_back(std::move(result));
+                    produced++;
+                    if (ready.size() >= batchSize || produced == count) readyCondition.notify_one();
+                }
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(workerCount);
+            for (size_t i = 0; i < workerCount; i++)
+                workers.emplace_back(work);
+            std::vector<Result> batch;
+            for (size_t consumed = 0; consumed < count; consumed += batch.size())
+            {
+                batch.clear();
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    readyCondition.wait(lock, [&]() { return ready.size() >= batchSize || produced == count; });
+                    batch.swap(ready);
+                }
+                spaceCondition.notify_all();
+                for (auto &result : batch)
+                    consume(result);
+            }
+            for (auto &worker : workers)
+                worker.join();
+            return;
+        }
+#else
+        (void)threads;
+        (void)batchSize;
+#endif
+        [[maybe_unused]] auto state = setup();
+        for (size_t i = 0; i < count; i++)
+        {
+            Result result = produce(i);
+            consume(result);
+        }
+    }
+
+    // reads items with read(item) on the calling thread until it returns false, runs process(item) on up to `threads`
+    // threads, the calling thread included, and hands the items to consume(item) on the calling thread in the order they
+    // were read. The workers are started once for all items, and at most `window` items are read ahead of those consumed
+    template <typename Item, typename Read, typename Process, typename Consume>
+    void ParallelPipeline(const size_t threads, const size_t window, const Read &read, const Process &process, const Consume &consume)
+    {
+#ifdef WEBIFC_THREADS_ENABLED
+        const size_t workerCount = InParallelWork() ? 1 : threads;
+        if (workerCount > 1 && window > 0)
+        {
+            std::vector<Item> items(window);
+            std::vector<uint8_t> processed(window, 0);
+            std::mutex mutex;
+            std::condition_variable changed;
+            size_t readCount = 0;
+            size_t claimed = 0;
+            size_t consumed = 0;
+            bool atEnd = false;
+            // with the lock held, processes the next item that was read and nobody took yet
+            auto processNext = [&](std::unique_lock<std::mutex> &lock)
+            {
+                const size_t slot = claimed++ % window;
+                lock.unlock();
+                process(items[slot]);
+                lock.lock();
+                processed[slot] = 1;
+                changed.notify_all();
+            };
+            auto work = [&]()
+            {
+                InParallelWork() = true;
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    changed.wait(lock, [&]() { return claimed < readCount || atEnd; });
+                    if (claimed == readCount)
+                        break;
+                    processNext(lock);
+                }
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(workerCount - 1);
+            for (size_t i = 1; i < workerCount; i++)
+                workers.emplace_back(work);
+            // readCount and consumed only change on this thread, the slots between them are not touched by the workers
+            // once processed, and those past readCount not at all
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!atEnd || consumed < readCount)
+            {
+                const size_t slot = consumed % window;
+                if (consumed < readCount && processed[slot])
+                {
+                    processed[slot] = 0;
+                    lock.unlock();
+                    consume(items[slot]);
+                    lock.lock();
+                    consumed++;
+                }
+                else if (!atEnd && readCount - consumed < window)
+                {
+                    lock.unlock();
+                    const bool hasItem = read(items[readCount % window]);
+                    lock.lock();
+                    if (hasItem)
+                        readCount++;
+                    else
+                        atEnd = true;
+                    changed.notify_all();
+                }
+                else if (claimed < readCount)
+                    processNext(lock);
+                else
+                    changed.wait(lock);
+            }
+            lock.unlock();
+            for (auto &worker : workers)
+                worker.join();
+            return;
+        }
+#else
+        (void)threads;
+        (void)window;
+#endif
+        Item item;
+        while (read(item))
+        {
+            process(item);
+            consume(item);
+        }
+    }
+
+#ifdef WEBIFC_THREADS_ENABLED
+    // a small index per live thread, the slot of a thread that ended is handed to the next new thread so that the
+    // short lived workers of ParallelFor and ParallelProduce do not add a slot each
+    inline size_t GetThreadSlot()
+    {
+        struct Registry
+        {
+            std::mutex mutex;
+            size_t slots = 0;
+            std::vector<size_t> unused;
+        };
+        // never destroyed, threads may still end after static destruction began
+        static Registry *registry = new Registry();
+        thread_local struct ThreadSlot
+        {
+            size_t slot = SIZE_MAX;
+
+            ~ThreadSlot()
+            {
+                if (slot == SIZE_MAX) return;
+                std::lock_guard<std::mutex> lock(registry->mutex);
+                registry->unused.push_back(slot);
+            }
+        } threadSlot;
+        if (threadSlot.slot != SIZE_MAX) return threadSlot.slot;
+        std::lock_guard<std::mutex> lock(registry->mutex);
+        if (!registry->unused.empty())
+        {
+            // the lowest slot first, so the slots stay as few as the threads that run at once
+            auto lowest = std::min_element(registry->unused.begin(), registry->unused.end());
+            threadSlot.slot = *lowest;
+            registry->unused.erase(lowest);
+        }
+        else
+            threadSlot.slot = registry->slots++;
+        return threadSlot.slot;
+    }
+#endif
+
+    // one value per thread slot, for caches and scratch state that are cheaper to keep per thread than to share. A new
+    // thread takes over the value of the thread that held its slot before, which is what merging it would give as the
+    // values are caches that Clear and ForEachMutable keep valid for every slot, and counters that ForEach sums
+    template <typename T>
+    class PerThread
+    {
+    public:
+        PerThread() = default;
+
+        // the value becomes the calling thread's
+        explicit PerThread(const T &value)
+        {
+            Get() = value;
+        }
+
+        // copies the calling thread's value only
+        PerThread(const PerThread &other) : PerThread(other.Get()) {}
+
+        PerThread &operator=(const PerThread &other)
+        {
+            if (this != &other) Get() = other.Get();
+            return *this;
+        }
+
+        T &Get() const
+        {
+#ifdef WEBIFC_THREADS_ENABLED
+            // the last instance used on this thread is remembered, ids are never reused so a stale entry cannot match
+            thread_local struct
+            {
+                uint64_t id = 0;
+                T *value = nullptr;
+            } last;
+            if (last.id == _id) return *last.value;
+            const size_t slot = GetThreadSlot();
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (slot >= _values.size()) _values.resize(slot + 1);
+            auto &value = _values[slot];
+            if (!value) value = std::make_unique<T>();
+            last = {_id, value.get()};
+            return *value;
+#else
+            return _value;
+#endif
+        }
+
+        // resets the value of every thread, no thread may use its value meanwhile
+        void Clear() const
+        {
+#ifdef WEBIFC_THREADS_ENABLED
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto &value : _values)
+                if (value) *value = T();
+#else
+            _value = T();
+#endif
+        }
+
+        // visits the value of every thread that has one, no thread may use its value meanwhile
+        template <typename F>
+        void ForEach(F f) const
+        {
+#ifdef WEBIFC_THREADS_ENABLED
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto &value : _values)
+                if (value) f(std::as_const(*value));
+#else
+            f(std::as_const(_value));
+#endif
+        }
+
+        // like ForEach, with the values to change
+        template <typename F>
+        void ForEachMutable(F f) const
+        {
+#ifdef WEBIFC_THREADS_ENABLED
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto &value : _values)
+                if (value) f(*value);
+#else
+            f(_value);
+#endif
+        }
+
+    private:
+#ifdef WEBIFC_THREADS_ENABLED
+        static uint64_t nextId()
+        {
+            static std::atomic<uint64_t> ids = 0;
+            return ++ids;
+        }
+        const uint64_t _id = nextId();
+        mutable std::mutex _mutex;
+        // indexed by the thread slot
+        mutable std::vector<std::unique_ptr<T>> _values;
+#else
+        mutable T _value;
+#endif
+    };
+
+}
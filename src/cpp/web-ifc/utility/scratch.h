@@ -0,0 +1,58 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <vector>
+
+namespace webifc::utility
+{
+
+    // an empty vector leased from a pool of the calling thread and given back, cleared but with its capacity, when the
+    // lease ends, so the sets read for every face or loop reuse the buffers of the ones read before. Leases may be
+    // nested, each gets its own vector
+    template <typename T>
+    class ScratchVector
+    {
+    public:
+        ScratchVector()
+        {
+            auto &pool = Pool();
+            if (!pool.empty())
+            {
+                _values = std::move(pool.back());
+                pool.pop_back();
+            }
+        }
+
+        ~ScratchVector()
+        {
+            _values.clear();
+            Pool().push_back(std::move(_values));
+        }
+
+        ScratchVector(const ScratchVector &) = delete;
+        ScratchVector &operator=(const ScratchVector &) = delete;
+
+        std::vector<T> &operator*()
+        {
+            return _values;
+        }
+
+        std::vector<T> *operator->()
+        {
+            return &_values;
+        }
+
+    private:
+        static std::vector<std::vector<T>> &Pool()
+        {
+            thread_local std::vector<std::vector<T>> pool;
+            return pool;
+        }
+
+        std::vector<T> _values;
+    };
+
+}
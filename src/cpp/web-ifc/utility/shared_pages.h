@@ -0,0 +1,85 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace webifc::utility
+{
+
+    // an array kept in pages of 2^PageBits values that copies share, a page is copied by the first copy that writes to
+    // it while it is still shared, so copying the array only copies the page pointers. Copies may be used on different
+    // threads as long as each is only used by one
+    template <typename T, size_t PageBits = 12>
+    class SharedPages
+    {
+    public:
+        static constexpr size_t PAGE_SIZE = size_t(1) << PageBits;
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        const T &operator[](const size_t index) const
+        {
+            return (*_pages[index >> PageBits])[index & (PAGE_SIZE - 1)];
+        }
+
+        T &Mutable(const size_t index)
+        {
+            return mutablePage(index >> PageBits)[index & (PAGE_SIZE - 1)];
+        }
+
+        void resize(const size_t size, const T &value)
+        {
+            // values past the end of the last page may be left from a shrink, so they are filled in again
+            for (size_t index = _size; index < std::min(size, _pages.size() * PAGE_SIZE); index++) Mutable(index) = value;
+            while (_pages.size() * PAGE_SIZE < size) _pages.push_back(std::make_shared<std::vector<T>>(PAGE_SIZE, value));
+            _pages.resize((size + PAGE_SIZE - 1) >> PageBits);
+            _size = size;
+        }
+
+        void push_back(const T &value)
+        {
+            if (_size == _pages.size() * PAGE_SIZE) _pages.push_back(std::make_shared<std::vector<T>>(PAGE_SIZE));
+            Mutable(_size++) = value;
+        }
+
+        void clear()
+        {
+            _pages.clear();
+            _pages.shrink_to_fit();
+            _size = 0;
+        }
+
+        // the pages this array holds, pages shared with copies are counted by each of them
+        uint64_t Bytes() const
+        {
+            return _pages.capacity() * sizeof(std::shared_ptr<std::vector<T>>) + _pages.size() * PAGE_SIZE * sizeof(T);
+        }
+
+    private:
+        std::vector<T> &mutablePage(const size_t page)
+        {
+            // no other copy can start sharing a page while this one writes to it, as copies are made by its thread
+            if (_pages[page].use_count() > 1) _pages[page] = std::make_shared<std::vector<T>>(*_pages[page]);
+            return *_pages[page];
+        }
+
+        std::vector<std::shared_ptr<std::vector<T>>> _pages;
+        size_t _size = 0;
+    };
+
+}
@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace webifc::utility
+{
+
+    inline uint64_t NowNanoseconds()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // adds the nanoseconds it lives to total, several threads may add to the same total
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(std::atomic<uint64_t> &total) : _total(total), _start(NowNanoseconds())
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            _total.fetch_add(NowNanoseconds() - _start, std::memory_order_relaxed);
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        std::atomic<uint64_t> &_total;
+        uint64_t _start;
+    };
+
+}
@@ -0,0 +1,133 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "trace.h"
+
+namespace webifc::utility::trace
+{
+
+    namespace
+    {
+        // written by one thread at a time, the ring of a thread that ended is handed to the next new thread with its
+        // events, so the short lived workers of ParallelFor do not add a ring each
+        struct Ring
+        {
+            uint32_t id;
+            std::unique_ptr<Event[]> events = std::make_unique<Event[]>(RING_SIZE);
+            std::atomic<uint64_t> written = 0;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Ring>> rings;
+            std::vector<Ring *> unused;
+        };
+
+        // never destroyed, threads may still end after static destruction began
+        Registry &GetRegistry()
+        {
+            static Registry *registry = new Registry();
+            return *registry;
+        }
+
+        struct ThreadRing
+        {
+            Ring *ring = nullptr;
+
+            ~ThreadRing()
+            {
+                if (ring == nullptr) return;
+                auto &registry = GetRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.unused.push_back(ring);
+            }
+        };
+
+        Ring &GetThreadRing()
+        {
+            thread_local ThreadRing threadRing;
+            if (threadRing.ring != nullptr) return *threadRing.ring;
+            auto &registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            if (!registry.unused.empty())
+            {
+                threadRing.ring = registry.unused.back();
+                registry.unused.pop_back();
+            }
+            else
+            {
+                registry.rings.push_back(std::make_unique<Ring>());
+                registry.rings.back()->id = static_cast<uint32_t>(registry.rings.size());
+                threadRing.ring = registry.rings.back().get();
+            }
+            return *threadRing.ring;
+        }
+    }
+
+    void Record(const Event &event)
+    {
+        Ring &ring = GetThreadRing();
+        const uint64_t written = ring.written.load(std::memory_order_relaxed);
+        ring.events[written % RING_SIZE] = event;
+        ring.written.store(written + 1, std::memory_order_release);
+    }
+
+    void Clear()
+    {
+        auto &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (auto &ring : registry.rings) ring->written = 0;
+    }
+
+    std::string ExportChromeTrace()
+    {
+        auto &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        struct Range
+        {
+            const Ring *ring;
+            uint64_t first;
+            uint64_t end;
+        };
+        std::vector<Range> ranges;
+        uint64_t origin = std::numeric_limits<uint64_t>::max();
+        for (const auto &ring : registry.rings)
+        {
+            const uint64_t end = ring->written.load(std::memory_order_acquire);
+            const uint64_t first = end > RING_SIZE ? end - RING_SIZE : 0;
+            if (first == end) continue;
+            ranges.push_back({ring.get(), first, end});
+            for (uint64_t i = first; i < end; i++) origin = std::min(origin, ring->events[i % RING_SIZE].start);
+        }
+
+        std::ostringstream output;
+        output.setf(std::ios::fixed);
+        output.precision(3);
+        output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto &range : ranges)
+        {
+            output << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << range.ring->id << ",\"args\":{\"name\":\"web-ifc " << range.ring->id << "\"}}";
+            first = false;
+            for (uint64_t i = range.first; i < range.end; i++)
+            {
+                const Event &event = range.ring->events[i % RING_SIZE];
+                output << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << range.ring->id;
+                output << ",\"ts\":" << (event.start - origin) / 1e3 << ",\"dur\":" << event.duration / 1e3;
+                output << ",\"args\":{\"id\":" << event.argument << "}}";
+            }
+        }
+        output << "\n]}\n";
+        return output.str();
+    }
+
+}
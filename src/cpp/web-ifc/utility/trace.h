@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "timing.h"
+
+// scoped trace events for incident analysis, every thread writes into a ring buffer of its own without locking, so
+// tracing can stay on in production, and the events are exported in the Chrome trace format, which Perfetto reads
+//
+//   WEBIFC_TRACE_SCOPE("GetFlatMesh", expressID);
+//
+// while tracing is off a scope costs one relaxed load
+namespace webifc::utility::trace
+{
+
+    // events a thread keeps, older ones are overwritten
+    constexpr size_t RING_SIZE = 1 << 16;
+
+    struct Event
+    {
+        // a string literal, it is only referenced
+        const char *name;
+        uint64_t start;
+        uint64_t duration;
+        uint64_t argument;
+    };
+
+    inline std::atomic<bool> &Enabled()
+    {
+        static std::atomic<bool> enabled = false;
+        return enabled;
+    }
+
+    inline void SetEnabled(const bool enabled)
+    {
+        Enabled() = enabled;
+    }
+
+    inline bool IsEnabled()
+    {
+        return Enabled().load(std::memory_order_relaxed);
+    }
+
+    void Record(const Event &event);
+    // drops the events of all threads, no thread may be recording meanwhile
+    void Clear();
+    // the events of all threads as Chrome trace JSON, in microseconds since the first event, events a thread writes
+    // while they are exported may come out torn
+    std::string ExportChromeTrace();
+
+    class Scope
+    {
+    public:
+        Scope(const char *name, const uint64_t argument = 0) : _name(name), _argument(argument), _start(IsEnabled() ? NowNanoseconds() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (_start != 0) Record({_name, _start, NowNanoseconds() - _start, _argument});
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char *_name;
+        uint64_t _argument;
+        uint64_t _start;
+    };
+
+}
+
+#define WEBIFC_TRACE_CONCAT_INNER(a, b) a##b
+#define WEBIFC_TRACE_CONCAT(a, b) WEBIFC_TRACE_CONCAT_INNER(a, b)
+#define WEBIFC_TRACE_SCOPE(...) ::webifc::utility::trace::Scope WEBIFC_TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
@@ -27,7 +27,7 @@ completeEntityList.add("FILE_DESCRIPTION");
 
 let typeList = new Set<string>();
 
-cppPropertyNames.push("std::string getPropertyName(IFC_SCHEMA schema,uint32_t typeCode,uint32_t prop) {")
+cppPropertyNames.push("std::string_view getPropertyName(IFC_SCHEMA schema,uint32_t typeCode,uint32_t prop) {")
 cppPropertyTypes.push("uint32_t getPropertyTypeCode(IFC_SCHEMA schema,uint32_t typeCode,uint32_t prop) {")
 cppPropertyCounts.push("uint32_t getPropertyCount(IFC_SCHEMA schema,uint32_t typeCode) {")
 
@@ -349,26 +349,51 @@ new Set([...completeEntityList,...typeList]).forEach(entity => {
 
 chSchema.push("}");
 
-cppSchema.push("#include <unordered_set>");
+cppSchema.push("#include <algorithm>");
+cppSchema.push("#include <array>");
+cppSchema.push("#include <span>");
 cppSchema.push("#include <string>");
+cppSchema.push("#include <string_view>");
+cppSchema.push("#include <vector>");
 cppSchema.push("#include \"ifc-schema.h\"");
 cppSchema.push("#include \"IfcSchemaManager.h\"");
 cppSchema.push("namespace webifc::schema {")
-cppSchema.push("void IfcSchemaManager::initSchemaData() {");
-completeifcElementList.forEach(element => {
-    cppSchema.push(`_ifcElements.insert(${element.toUpperCase()});`);
+// constant tables, nothing is built when a schema manager is created
+let sortedElements = [...new Set([...completeifcElementList].map((element) => element.toUpperCase()))].sort((a, b) => crc32(a,crcTable) - crc32(b,crcTable));
+cppSchema.push("// sorted by type code");
+cppSchema.push(`constexpr std::array<uint32_t,${sortedElements.length}> IFC_ELEMENTS = {`);
+sortedElements.forEach(element => {
+    cppSchema.push(`${element},`);
 });
+cppSchema.push("};");
+let schemaNames: Array<string> = [];
 chSchema.push(`enum IFC_SCHEMA {`)
 for (var i = 0; i < files.length; i++) {
   if (!files[i].endsWith(".exp")) continue;
   var schemaName = files[i].replace(".exp","");
   var schemaNameClean = schemaName.replace(".","_");
   chSchema.push(`${schemaNameClean},`)
-  cppSchema.push(`_schemaNames.push_back("${schemaNameClean}");`);
-  cppSchema.push(`_schemas.push_back(${schemaNameClean});`);
+  schemaNames.push(schemaNameClean);
 }
-cppSchema.push("}");
 chSchema.push(`};`)
+cppSchema.push(`constexpr std::array<IFC_SCHEMA,${schemaNames.length}> SCHEMAS = {`);
+schemaNames.forEach(name => cppSchema.push(`${name},`));
+cppSchema.push("};");
+cppSchema.push(`constexpr std::array<std::string_view,${schemaNames.length}> SCHEMA_NAMES = {`);
+schemaNames.forEach(name => cppSchema.push(`"${name}",`));
+cppSchema.push("};");
+cppSchema.push("bool IfcSchemaManager::IsIfcElement(uint32_t typeCode) const {");
+cppSchema.push("return std::binary_search(IFC_ELEMENTS.begin(), IFC_ELEMENTS.end(), typeCode);");
+cppSchema.push("}");
+cppSchema.push("std::span<const uint32_t> IfcSchemaManager::GetIfcElementList() const {");
+cppSchema.push("return IFC_ELEMENTS;");
+cppSchema.push("}");
+cppSchema.push("const std::vector<IFC_SCHEMA> IfcSchemaManager::GetAvailableSchemas() const {");
+cppSchema.push("return std::vector<IFC_SCHEMA>(SCHEMAS.begin(), SCHEMAS.end());");
+cppSchema.push("}");
+cppSchema.push("std::string_view IfcSchemaManager::GetSchemaName(IFC_SCHEMA schema) const {");
+cppSchema.push("return SCHEMA_NAMES[schema];");
+cppSchema.push("}");
 
 cppSchema.push("std::string IfcSchemaManager::IfcTypeCodeToType(uint32_t typeCode) const {");
 cppSchema.push("switch(typeCode) {");
@@ -381,7 +406,7 @@ cppSchema.push("}");
 cppSchema.push("}");
 cppSchema.push("}");
 
-let nameList ="std::array<std::string,"+cppPropertyNamesList.length+"> propyNames = {";
+let nameList ="constexpr std::array<std::string_view,"+cppPropertyNamesList.length+"> propyNames = {";
 for (let x=0; x < cppPropertyNamesList.length; x++) {
   nameList+="\""+cppPropertyNamesList[x]+"\"";
   if (x!+cppPropertyNamesList.length-1) nameList+=",";
@@ -391,7 +416,7 @@ cppPropertyNames.unshift(nameList);
 cppPropertyNames.push("}")
 
 
-let typeNameList ="std::array<uint32_t,"+cppPropertyNamesList.length+"> propTypeNames = {";
+let typeNameList ="constexpr std::array<uint32_t,"+cppPropertyNamesList.length+"> propTypeNames = {";
 for (let x=0; x < cppPropertyTypesList.length; x++) {
   typeNameList+= crc32(cppPropertyTypesList[x].toUpperCase(),crcTable);
   if (x!+cppPropertyTypesList.length-1) typeNameList+=",";
@@ -0,0 +1,267 @@
+/**
+ * Web-IFC Binary Lines
+ * @module Lines
+ */
+
+import {
+    RawLineData,
+    STRING, LABEL, ENUM, REAL, REF, EMPTY, SET_BEGIN, SET_END, LINE_END, INTEGER, UNKNOWN,
+} from "../web-ifc-api";
+
+const textDecoder = new TextDecoder();
+const textEncoder = new TextEncoder();
+
+/**
+ * Lines exported by GetLinesBinary, every line is only decoded when it is read
+ */
+export class RawLineBuffer {
+    private bytes: Uint8Array;
+    private view: DataView;
+    private offset = 0;
+
+    /**
+     * @param bytes the buffer of GetLinesBinary, it is kept as it is, so pass a copy of a view into wasm memory
+     */
+    constructor(bytes: Uint8Array) {
+        this.bytes = bytes;
+        this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    }
+
+    /** number of lines in the buffer */
+    get length(): number {
+        return this.bytes.byteLength < 4 ? 0 : this.view.getUint32(0, true);
+    }
+
+    /** expressID of the line at index, 0 for lines that do not exist */
+    GetExpressID(index: number): number {
+        return this.view.getUint32(this.GetLineOffset(index), true);
+    }
+
+    /** type of the line at index, 0 for lines that do not exist */
+    GetType(index: number): number {
+        return this.view.getUint32(this.GetLineOffset(index) + 4, true);
+    }
+
+    /** the line at index as GetRawLineData returns it */
+    GetLine(index: number): RawLineData {
+        const lineOffset = this.GetLineOffset(index);
+        const ID = this.view.getUint32(lineOffset, true);
+        const type = this.view.getUint32(lineOffset + 4, true);
+        if (type == 0) return {} as RawLineData;
+        this.offset = lineOffset + 8;
+        return { ID, type, arguments: this.ReadArguments(false, false) };
+    }
+
+    private GetLineOffset(index: number): number {
+        return this.view.getUint32(4 + index * 4, true);
+    }
+
+    private ReadLength(): number {
+        const length = this.view.getUint32(this.offset, true);
+        this.offset += 4;
+        return length;
+    }
+
+    private ReadAscii(): string {
+        const length = this.ReadLength();
+        let value = "";
+        for (let i = 0; i < length; i++) value += String.fromCharCode(this.bytes[this.offset + i]);
+        this.offset += length;
+        return value;
+    }
+
+    private ReadValue(type: number): any {
+        switch (type) {
+            case STRING: {
+                const length = this.ReadLength();
+                const value = textDecoder.decode(this.bytes.subarray(this.offset, this.offset + length));
+                this.offset += length;
+                return value;
+            }
+            case ENUM: {
+                const value = this.ReadAscii();
+                if (value == "T") return true;
+                if (value == "F") return false;
+                if (value == "U") return undefined;
+                return value;
+            }
+            case REAL:
+                return this.ReadAscii();
+            case INTEGER: {
+                const value = this.view.getFloat64(this.offset, true);
+                this.offset += 8;
+                return value;
+            }
+            case REF: {
+                const value = this.view.getUint32(this.offset, true);
+                this.offset += 4;
+                return value;
+            }
+        }
+        return undefined;
+    }
+
+    // the same shape GetArgs builds in wasm
+    private ReadArguments(inObject: boolean, inList: boolean): any {
+        const args: any[] = [];
+        let end = false;
+        while (!end && this.offset < this.bytes.byteLength) {
+            const type = this.bytes[this.offset++];
+            switch (type) {
+                case LINE_END:
+                case SET_END:
+                    end = true;
+                    break;
+                case EMPTY:
+                    args.push(null);
+                    break;
+                case SET_BEGIN:
+                    args.push(this.ReadArguments(false, true));
+                    break;
+                case LABEL: {
+                    const typecode = this.view.getUint32(this.offset, true);
+                    this.offset += 4;
+                    if (this.bytes[this.offset] == SET_BEGIN) this.offset++;
+                    args.push({ type: LABEL, typecode, value: this.ReadArguments(true, false) });
+                    break;
+                }
+                default: {
+                    const value = this.ReadValue(type);
+                    args.push(inObject ? value : { type, value });
+                    break;
+                }
+            }
+        }
+        if (args.length == 0 && !inList) return null;
+        if (args.length == 1 && inObject) return args[0];
+        return args;
+    }
+}
+
+/**
+ * Builds a buffer of lines for WriteRawLinesBuffer in the layout of GetLinesBinary, the arguments take the shape
+ * RawLineBuffer.GetLine returns, a label may name its valueType, otherwise it is taken from the value
+ */
+export class RawLineWriter {
+    private bytes = new Uint8Array(1 << 16);
+    private view = new DataView(this.bytes.buffer);
+    private size = 0;
+    private offsets: number[] = [];
+
+    /** number of lines added */
+    get length(): number {
+        return this.offsets.length;
+    }
+
+    AddLine(expressID: number, type: number, args: any[] | null) {
+        this.offsets.push(this.size);
+        this.WriteUint32(expressID);
+        this.WriteUint32(type);
+        if (args) for (const arg of args) this.WriteArgument(arg);
+        this.WriteByte(LINE_END);
+    }
+
+    /** the lines with their header, the writer may be reused after Clear */
+    GetBuffer(): Uint8Array {
+        const headerSize = 4 + this.offsets.length * 4;
+        const buffer = new Uint8Array(headerSize + this.size);
+        const view = new DataView(buffer.buffer);
+        view.setUint32(0, this.offsets.length, true);
+        for (let i = 0; i < this.offsets.length; i++) view.setUint32(4 + i * 4, headerSize + this.offsets[i], true);
+        buffer.set(this.bytes.subarray(0, this.size), headerSize);
+        return buffer;
+    }
+
+    Clear() {
+        this.size = 0;
+        this.offsets = [];
+    }
+
+    private Reserve(size: number) {
+        if (this.size + size <= this.bytes.byteLength) return;
+        let capacity = this.bytes.byteLength * 2;
+        while (capacity < this.size + size) capacity *= 2;
+        const bytes = new Uint8Array(capacity);
+        bytes.set(this.bytes.subarray(0, this.size));
+        this.bytes = bytes;
+        this.view = new DataView(bytes.buffer);
+    }
+
+    private WriteByte(value: number) {
+        this.Reserve(1);
+        this.bytes[this.size++] = value;
+    }
+
+    private WriteUint32(value: number) {
+        this.Reserve(4);
+        this.view.setUint32(this.size, value, true);
+        this.size += 4;
+    }
+
+    private WriteBytes(bytes: Uint8Array) {
+        this.WriteUint32(bytes.byteLength);
+        this.Reserve(bytes.byteLength);
+        this.bytes.set(bytes, this.size);
+        this.size += bytes.byteLength;
+    }
+
+    private WriteAscii(value: string) {
+        this.WriteUint32(value.length);
+        this.Reserve(value.length);
+        for (let i = 0; i < value.length; i++) this.bytes[this.size++] = value.charCodeAt(i);
+    }
+
+    private WriteValue(type: number, value: any) {
+        this.WriteByte(type);
+        switch (type) {
+            case STRING:
+                this.WriteBytes(textEncoder.encode(value));
+                break;
+            case ENUM:
+                this.WriteAscii(value === true ? "T" : value === false ? "F" : value === undefined || value === null ? "U" : value);
+                break;
+            case REAL:
+                this.WriteAscii(typeof value == "number" ? RealText(value) : value);
+                break;
+            case INTEGER:
+                this.Reserve(8);
+                this.view.setFloat64(this.size, value, true);
+                this.size += 8;
+                break;
+            case REF:
+                this.WriteUint32(value);
+                break;
+        }
+    }
+
+    private WriteArgument(arg: any) {
+        if (arg === null) this.WriteByte(EMPTY);
+        else if (arg === undefined) this.WriteByte(UNKNOWN);
+        else if (Array.isArray(arg)) {
+            this.WriteByte(SET_BEGIN);
+            for (const item of arg) this.WriteArgument(item);
+            this.WriteByte(SET_END);
+        } else if (arg.type == LABEL) {
+            this.WriteByte(LABEL);
+            this.WriteUint32(arg.typecode);
+            this.WriteByte(SET_BEGIN);
+            const values = Array.isArray(arg.value) ? arg.value : [arg.value];
+            for (const value of values) this.WriteValue(arg.valueType ?? ValueType(value), value);
+            this.WriteByte(SET_END);
+        } else this.WriteValue(arg.type, arg.value);
+    }
+}
+
+function ValueType(value: any): number {
+    if (typeof value == "number") return REAL;
+    if (typeof value == "string") return STRING;
+    return ENUM;
+}
+
+// STEP wants a decimal point in every real, also in front of the exponent
+function RealText(value: number): string {
+    const text = String(value).toUpperCase();
+    if (text.includes(".")) return text;
+    const exponent = text.indexOf("E");
+    return exponent < 0 ? text + "." : text.slice(0, exponent) + "." + text.slice(exponent);
+}
@@ -5,7 +5,7 @@
 
 import {
     IfcAPI,
-    IFCPROJECT, IFCRELAGGREGATES,
+    IFCRELAGGREGATES,
     IFCRELCONTAINEDINSPATIALSTRUCTURE,
     IFCRELDEFINESBYPROPERTIES,
     IFCRELASSOCIATESMATERIAL,
@@ -91,6 +91,11 @@ export class Properties {
             for (let t of types) results.push(...await this.getPropertySets(modelID,t.expressID,recursive));
             return results;
 
+        } else if (elementID !== 0) {
+            const propSetIds = this.api.GetPropertySetIDs(modelID, [elementID]);
+            const results: any[] = [];
+            for (let i = 1; i < propSetIds.length; i++) results.push(await this.api.GetLine(modelID, propSetIds[i], recursive));
+            return results;
         } else return await this.getRelatedProperties(modelID, elementID, PropsNames.psets, recursive);
     }
 
@@ -159,12 +164,9 @@ export class Properties {
 	 * @returns IfcProject as Node
 	 */
     async getSpatialStructure(modelID: number, includeProperties = false): Promise<Node> {
-        const chunks = await this.getSpatialTreeChunks(modelID);
-        const allLines = await this.api.GetLineIDsWithType(modelID, IFCPROJECT);
-        const projectID = allLines.get(0);
-        const project = Properties.newIfcProject(projectID);
-        await this.getSpatialNode(modelID, project, chunks, includeProperties);
-        return project;
+        const tree = this.api.GetSpatialTree(modelID);
+        if (tree.length < 1 || tree[0] == 0) return Properties.newIfcProject(0);
+        return await this.getSpatialNode(modelID, tree, { offset: 1 }, includeProperties, true);
     }
 
 
@@ -193,14 +195,6 @@ export class Properties {
         return result;
     }
 
-    private async getChunks(modelID: number, chunks: any, propNames: pName) {
-        const relation = await this.api.GetLineIDsWithType(modelID, propNames.name, true);
-        for (let i = 0; i < relation.size(); i++) {
-            const rel = await this.api.GetLine(modelID, relation.get(i), false);
-            this.saveChunk(chunks, propNames, rel);
-        }
-    }
-
     private static newIfcProject(id: number) {
         return {
             expressID: id,
@@ -209,27 +203,20 @@ export class Properties {
         };
     }
 
-    private async getSpatialNode(modelID: number, node: Node, treeChunks: any, includeProperties?: boolean) {
-        await this.getChildren(modelID, node, treeChunks, PropsNames.aggregates, includeProperties);
-        await this.getChildren(modelID, node, treeChunks, PropsNames.spatial, includeProperties);
-    }
-
-    private async getChildren(modelID: number, node: Node, treeChunks: any, propNames: pName, includeProperties?: boolean) {
-        const children = treeChunks[node.expressID];
-        if (children == undefined) return;
-        const prop = propNames.key as keyof Node;
-        const nodes: any[] = [];
-        for (let i = 0; i < children.length; i++) {
-            const child = children[i];
-            let node = this.newNode(child,this.api.GetLineType(modelID, child));
-            if (includeProperties) {
-                const properties = await this.getItemProperties(modelID, node.expressID) as any;
-                node = {...properties, ...node};
-            }
-            await this.getSpatialNode(modelID, node, treeChunks, includeProperties);
-            nodes.push(node);
+    private async getSpatialNode(modelID: number, tree: Uint32Array, cursor: { offset: number }, includeProperties: boolean, root = false): Promise<Node> {
+        const expressID = tree[cursor.offset];
+        const type = tree[cursor.offset + 1];
+        const childCount = tree[cursor.offset + 2];
+        cursor.offset += 4 + tree[cursor.offset + 3];
+        let node: Node = root ? Properties.newIfcProject(expressID) : this.newNode(expressID, type);
+        if (includeProperties && !root) {
+            const properties = await this.getItemProperties(modelID, node.expressID) as any;
+            node = {...properties, ...node};
         }
-        (node[prop] as Node[]) = nodes;
+        for (let i = 0; i < childCount; i++) {
+            node.children.push(await this.getSpatialNode(modelID, tree, cursor, includeProperties));
+        }
+        return node;
     }
 
     private newNode(id: number, type: number) {
@@ -239,22 +226,6 @@ export class Properties {
             children: []
         };
     }
-    private async getSpatialTreeChunks(modelID: number) {
-        const treeChunks: any = {};
-        await this.getChunks(modelID, treeChunks, PropsNames.aggregates);
-        await this.getChunks(modelID, treeChunks, PropsNames.spatial);
-        return treeChunks;
-    }
-
-    private saveChunk(chunks: any, propNames: pName, rel: any) {
-        const relating = rel[propNames.relating].value;
-        const related = rel[propNames.related].map((r: any) => r.value);
-        if (chunks[relating] == undefined) {
-            chunks[relating] = related;
-        } else {
-            chunks[relating] = chunks[relating].concat(related);
-        }
-    }
 
 	private async setItemProperties(modelID: number, elementID: number|number[], propID: number|number[], propsName: pName) {
 		if (!Array.isArray(elementID)) elementID = [elementID];
@@ -41,6 +41,8 @@ export * from "./ifc-schema";
 import { Properties } from "./helpers/properties";
 export { Properties };
 import { Log, LogLevel } from "./helpers/log";
+import { RawLineBuffer, RawLineWriter } from "./helpers/lines";
+export { RawLineBuffer, RawLineWriter };
 export { LogLevel };
 
 export const UNKNOWN = 0;
@@ -55,6 +57,17 @@ export const SET_END = 8;
 export const LINE_END = 9;
 export const INTEGER = 10;
 
+export const VERTEX_FORMAT_FLOAT = 0;
+export const VERTEX_FORMAT_FLOAT_RELEASED = 1;
+export const VERTEX_FORMAT_QUANTIZED = 2;
+export const VERTEX_FORMAT_FLOAT_COMPACT = 3;
+
+/** Numbers per instance record of StreamInstancedMeshes */
+export const INSTANCE_RECORD_SIZE = 22;
+
+/** Numbers per record of StreamMeshesBatched */
+export const MESH_RECORD_SIZE = 27;
+
 /**
  * Settings for the IFCLoader
  * @property {boolean} COORDINATE_TO_ORIGIN - If true, the model will be translated to the origin.
@@ -69,6 +82,20 @@ export const INTEGER = 10;
  * @property {number} TOLERANCE_SCALAR_EQUALITY - Tolerance used to compare scalar values as equal.
  * @property {number} PLANE_REFIT_ITERATIONS - Number of iterations used when adjusting triangles to a plane.
  * @property {number} BOOLEAN_UNION_THRESHOLD - Minimum number of solids before triggering a boolean union operation.
+ * @property {boolean} BINARY_NUMBERS - Decode numbers once while loading and keep the values in memory, faster geometry at the cost of a larger tape.
+ * @property {boolean} PARALLEL_TOKENIZING - Tokenize the file on all threads of the web-ifc-mt build, or natively, the model comes out the same. Default false, the file is tokenized on the calling thread.
+ * @property {number} GEOMETRY_MEMORY_LIMIT - Maximum memory (in bytes) of meshed geometry kept between elements, least recently used geometry is released beyond it. 0 keeps everything. With a limit, geometry is only guaranteed to be available until the next mesh is requested, so it does not suit LoadAllGeometry.
+ * @property {number} CIRCLE_CHORD_TOLERANCE - Largest distance, in model units, between an arc and the chords approximating it. Above 0 every circle, arc and ellipse gets as many segments as it needs instead of CIRCLE_SEGMENTS, so small arcs get fewer and large arcs more. 0 (default) uses CIRCLE_SEGMENTS everywhere.
+ * @property {number} BOOLEAN_TIME_BUDGET - Milliseconds a single boolean may take. A boolean over budget gives up and the element keeps its host un-cut, or the operands side by side for a union, and is listed by GetOverBudgetElements. 0 (default) has no limit.
+ * @property {number} ELEMENT_TIME_BUDGET - Milliseconds all booleans of one element may take together, booleans over it are given up as with BOOLEAN_TIME_BUDGET. 0 (default) has no limit.
+ * @property {number} BOOLEAN_FACE_BUDGET - Faces the operands of a boolean may have together, larger booleans are given up as with BOOLEAN_TIME_BUDGET without being tried. 0 (default) has no limit.
+ * @property {boolean} EXPORT_POLYLINES - Curves, points and edges among the representation items are meshed as polylines, one point per vertex in order, read packed with GetPolylines. Default false, only triangles are meshed.
+ * @property {number} TERRAIN_CHUNK_TRIANGLES - Triangulated irregular networks and triangulated face sets of more triangles are left out of the meshes of their elements and streamed in chunks of about that many triangles with StreamTerrain. 0 (default) meshes them whole.
+ * @property {Array<number>} INCLUDE_TYPES - Types of the lines kept once the model is loaded, with every line they reference directly or indirectly. Subtypes are not included by themselves, list them as well. Empty (default) keeps all types.
+ * @property {Array<number>} EXCLUDE_TYPES - Types of lines that are dropped once the model is loaded, also when a kept line references them, their references are not followed. Memory of the dropped lines is released where the tape allows it.
+ * @property {number} VERTEX_FORMAT - Vertex data handed out with meshes. VERTEX_FORMAT_FLOAT (default) gives 6 floats per vertex. VERTEX_FORMAT_FLOAT_RELEASED gives the same but frees the double precision vertices once a mesh is read. VERTEX_FORMAT_QUANTIZED gives 4 uint16 per vertex, read with GetQuantizedVertexArray: the position relative to GetQuantizationOffset and GetQuantizationScale, then the oct encoded normal as two int8. VERTEX_FORMAT_FLOAT_COMPACT gives 6 floats per vertex like VERTEX_FORMAT_FLOAT, but the model keeps float positions and compressed normals instead of the double precision vertices, about half the memory, and restores the doubles when a geometry is reused.
+ * @property {boolean} WELD_VERTICES - Faces of a mesh share the vertices they have in common, with the same position and normal, instead of having three vertices each. Vertex buffers get several times smaller, default false.
+ * @property {boolean} OPTIMIZE_VERTEX_CACHE - With WELD_VERTICES the faces are also ordered for the GPU's vertex cache and the vertices by their first use, default false.
  */
 export interface LoaderSettings {
   COORDINATE_TO_ORIGIN?: boolean;
@@ -83,6 +110,20 @@ export interface LoaderSettings {
   TOLERANCE_SCALAR_EQUALITY?: number;
   PLANE_REFIT_ITERATIONS?: number;
   BOOLEAN_UNION_THRESHOLD?: number;
+  BINARY_NUMBERS?: boolean;
+  PARALLEL_TOKENIZING?: boolean;
+  GEOMETRY_MEMORY_LIMIT?: number;
+  VERTEX_FORMAT?: number;
+  WELD_VERTICES?: boolean;
+  OPTIMIZE_VERTEX_CACHE?: boolean;
+  CIRCLE_CHORD_TOLERANCE?: number;
+  BOOLEAN_TIME_BUDGET?: number;
+  ELEMENT_TIME_BUDGET?: number;
+  BOOLEAN_FACE_BUDGET?: number;
+  EXPORT_POLYLINES?: boolean;
+  TERRAIN_CHUNK_TRIANGLES?: number;
+  INCLUDE_TYPES?: Array<number>;
+  EXCLUDE_TYPES?: Array<number>;
 }
 
 export interface Vector<T> extends Iterable<T> {
@@ -90,6 +131,9 @@ export interface Vector<T> extends Iterable<T> {
   size(): number;
 }
 
+/** IDs or type codes, a Uint32Array is copied into wasm in one go */
+export type IDArray = Array<number> | Uint32Array;
+
 export interface Color {
   x: number;
   y: number;
@@ -115,6 +159,110 @@ export interface FlatMesh {
   delete(): void;
 }
 
+/**
+ * A placed geometry with its vertices transformed into place, see GetFlatMeshWorldSpace
+ * @property {Float32Array} vertexData - 6 floats per vertex, position then normal, in the space of the flat meshes.
+ * @property {Uint32Array} indexData - 3 indices per triangle, wound for the placed vertices.
+ */
+export interface WorldSpaceGeometry {
+  geometryExpressID: number;
+  color: Color;
+  vertexData: Float32Array;
+  indexData: Uint32Array;
+}
+
+export interface WorldSpaceMesh {
+  expressID: number;
+  geometries: Array<WorldSpaceGeometry>;
+}
+
+/**
+ * Geometry of several elements with one color, transformed into place and merged
+ * @property {Float32Array} vertices - 6 floats per vertex, position then normal.
+ * @property {Uint32Array} indices - 3 indices per triangle.
+ * @property {Uint32Array} ranges - 3 numbers per element: its expressID, its first index and its number of indices.
+ */
+export interface MergedMesh {
+  color: Color;
+  vertices: Float32Array;
+  indices: Uint32Array;
+  ranges: Uint32Array;
+}
+
+/**
+ * The first triangle hit by a ray, see RayCast
+ * @property {number} distance - From the ray origin.
+ * @property {Point} normal - Unit normal of the triangle hit, by its winding.
+ */
+export interface RayHit {
+  expressID: number;
+  geometryExpressID: number;
+  faceIndex: number;
+  distance: number;
+  position: Point;
+  normal: Point;
+}
+
+/**
+ * The closest point on a triangle, see ClosestPoint
+ */
+export interface ClosestPoint {
+  expressID: number;
+  geometryExpressID: number;
+  faceIndex: number;
+  distance: number;
+  position: Point;
+}
+
+/**
+ * Bytes a model holds, estimated from the sizes of its containers, see GetMemoryStats
+ * @property {number} evictedChunkBytes - Tape chunks not held right now, what reloading them takes.
+ * @property {number} fileBytes - The file kept for reloading evicted chunks.
+ * @property {number} totalBytes - Everything held, evicted chunks left out.
+ */
+export interface MemoryStats {
+  loadedChunks: number;
+  evictedChunks: number;
+  loadedChunkBytes: number;
+  evictedChunkBytes: number;
+  fileBytes: number;
+  lineTableBytes: number;
+  typeIndexBytes: number;
+  argumentIndexBytes: number;
+  inverseIndexBytes: number;
+  globalIdIndexBytes: number;
+  placementBytes: number;
+  pointBytes: number;
+  curveBytes: number;
+  profileBytes: number;
+  relationBytes: number;
+  geometryBytes: number;
+  totalBytes: number;
+}
+
+/**
+ * What GetMesh did for one type or element, see GetGeometryProfile
+ * @property {number} inclusiveTime - Milliseconds, nested calls included.
+ * @property {number} exclusiveTime - Milliseconds, nested calls excluded.
+ * @property {number} bytes - Held by the geometry produced.
+ */
+export interface GeometryProfileCounters {
+  calls: number;
+  inclusiveTime: number;
+  exclusiveTime: number;
+  triangles: number;
+  bytes: number;
+}
+
+/**
+ * Counters of GetMesh per type of the lines meshed, with the triangles of their own geometry, and per element, with
+ * everything meshed for it
+ */
+export interface GeometryProfile {
+  types: Array<GeometryProfileCounters & { type: number }>;
+  elements: Array<GeometryProfileCounters & { expressID: number; type: number }>;
+}
+
 export interface Point {
   x: number;
   y: number;
@@ -163,6 +311,13 @@ export interface IfcGeometry {
   GetIndexData(): number;
   GetIndexDataSize(): number;
   GetSweptDiskSolid(): SweptDiskSolid;
+  GetVertexFormat(): number;
+  GetQuantizationOffset(): Point;
+  GetQuantizationScale(): Point;
+  /** view into wasm memory, valid while the geometry lives and until wasm memory grows, Uint16Array for VERTEX_FORMAT_QUANTIZED */
+  GetVertexArray(): Float32Array | Uint16Array;
+  /** view into wasm memory, valid while the geometry lives and until wasm memory grows */
+  GetIndexArray(): Uint32Array;
   delete(): void;
 }
 
@@ -318,6 +473,35 @@ export interface ProfileSection {
   ): void;
 }
 
+/**
+ * Kinds of the primitives of a packed description for GetBatchBuffers. Every item is its kind followed by the arguments
+ * of the primitive's SetValues in order, booleans as 0 or 1 and arrays as their length followed by their values. An
+ * extrusion is followed by its hole count and holes, a boolean starts with 0 for difference or 1 for union and ends with
+ * the count and triangles of its second operands
+ */
+export enum BatchGeometryKind {
+  AABB = 0,
+  EXTRUSION,
+  SWEEP,
+  CIRCULAR_SWEEP,
+  REVOLUTION,
+  CYLINDRICAL_REVOLUTION,
+  PARABOLA,
+  CLOTHOID,
+  ARC,
+  ALIGNMENT,
+  BOOLEAN,
+  PROFILE,
+}
+
+export interface BatchBuffers {
+  fvertexData: Float32Array;
+  // indices count from the first vertex of their item
+  indexData: Uint32Array;
+  // per item its first vertex float, vertex float count, first index and index count
+  ranges: Uint32Array;
+}
+
 export interface IfcType {
   typeID: number;
   typeName: string;
@@ -332,9 +516,69 @@ export interface NewIfcModel {
   authorization?: string;
 }
 
+/**
+ * The header of a file read by ProbeModel, the header lines are the objects GetHeaderLine returns
+ * @property {string} originatingSystem - The application that wrote the file, from FILE_NAME.
+ * @property {number} dataOffset - Bytes of the file up to the end of the HEADER section.
+ * @property {number} estimatedLines - Lines of the DATA section estimated from a sample of its start.
+ */
+export interface ModelProbe {
+  schema: string;
+  fileName: any;
+  fileDescription: any;
+  fileSchema: any;
+  originatingSystem: string;
+  dataOffset: number;
+  estimatedLines: number;
+}
+
+export interface TerrainChunk {
+  // the triangulated irregular network or face set
+  expressID: number;
+  // of the chunks of the terrain, in the order they are streamed
+  index: number;
+  count: number;
+  color: Color;
+  // 6 floats per vertex, position then normal, already in place
+  vertexData: Float32Array;
+  indexData: Uint32Array;
+}
+
+export interface PolylineBuffer {
+  // x, y, z of every point, curve after curve
+  points: Float32Array;
+  // the first point of every curve and at last the point count, curve i runs from offsets[i] to offsets[i + 1]
+  offsets: Uint32Array;
+  // of the element or alignment of every curve
+  expressIDs: Uint32Array;
+}
+
+/**
+ * One shard of a partition manifest from GetPartitionManifest.
+ * @property {number} firstExpressID - First expressID of the shard.
+ * @property {number} lastExpressID - Last expressID of the shard, the range includes it.
+ * @property {number} elementCount - Elements of the shard.
+ * @property {number} cost - Estimated meshing cost of the shard.
+ */
+export interface PartitionShard {
+  firstExpressID: number;
+  lastExpressID: number;
+  elementCount: number;
+  cost: number;
+}
+
 export type ModelLoadCallback = (offset: number, size: number) => Uint8Array;
 export type ModelSaveCallback = (data: Uint8Array) => void;
 
+/** @ignore */
+function ToVector(ids: Uint32Array): Vector<number> {
+  return {
+    get: (index: number) => ids[index],
+    size: () => ids.length,
+    [Symbol.iterator]: () => ids[Symbol.iterator](),
+  };
+}
+
 /** @ignore */
 export function ms() {
   return new Date().getTime();
@@ -439,10 +683,12 @@ export class IfcAPI {
       ...settings,
     };
     s.MEMORY_LIMIT = s.MEMORY_LIMIT! / dataSets.length;
-    let modelIDs: Array<number> = [];
-
-    for (let dataSet of dataSets) modelIDs.push(this.OpenModel(dataSet, s));
-    return modelIDs;
+    // the files are tokenized concurrently in wasm
+    const result: Uint32Array = this.wasmModule.OpenModels(
+      this.CreateSettings(s),
+      dataSets
+    );
+    return Array.from(result, (modelID) => this.InitOpenedModel(modelID));
   }
 
   private CreateSettings(settings?: LoaderSettings) {
@@ -459,6 +705,20 @@ export class IfcAPI {
       TOLERANCE_SCALAR_EQUALITY: 1.0e-4,
       PLANE_REFIT_ITERATIONS: 1,
       BOOLEAN_UNION_THRESHOLD: 150,
+      BINARY_NUMBERS: false,
+      PARALLEL_TOKENIZING: false,
+      GEOMETRY_MEMORY_LIMIT: 0,
+      VERTEX_FORMAT: 0,
+      WELD_VERTICES: false,
+      OPTIMIZE_VERTEX_CACHE: false,
+      CIRCLE_CHORD_TOLERANCE: 0,
+      BOOLEAN_TIME_BUDGET: 0,
+      ELEMENT_TIME_BUDGET: 0,
+      BOOLEAN_FACE_BUDGET: 0,
+      EXPORT_POLYLINES: false,
+      TERRAIN_CHUNK_TRIANGLES: 0,
+      INCLUDE_TYPES: [],
+      EXCLUDE_TYPES: [],
       ...settings,
     };
     return s;
@@ -493,19 +753,37 @@ export class IfcAPI {
         return srcSize;
       }
     );
-    this.deletedLines.set(result, new Set());
-    var schemaName = this.GetHeaderLine(result, FILE_SCHEMA).arguments[0][0]
+    return this.InitOpenedModel(result);
+  }
+
+  /**
+   * Opens a second handle on a model that shares its loaded data instead of reading the file again. The new model has
+   * its own geometry, so the mt build can mesh both on different threads while memory only grows by the geometry
+   * @param modelID Model handle retrieved by OpenModel
+   * @returns ModelID or -1 if the model is not open, still loading or does not fit the memory limit
+   */
+  AttachModel(modelID: number): number {
+    const result = this.wasmModule.AttachModel(modelID);
+    if (result == -1 || this.InitOpenedModel(result) == -1) return -1;
+    this.deletedLines.set(result, new Set(this.deletedLines.get(modelID)));
+    return result;
+  }
+
+  // reads the schema of a model just opened, -1 and the model closed when it is not supported
+  private InitOpenedModel(modelID: number): number {
+    this.deletedLines.set(modelID, new Set());
+    var schemaName = this.GetHeaderLine(modelID, FILE_SCHEMA).arguments[0][0]
       .value;
     let id = this.LookupSchemaId(schemaName);
     if (id == -1) {
       Log.error("Unsupported Schema:" + schemaName);
-      this.CloseModel(result);
+      this.CloseModel(modelID);
       return -1;
     }
-    this.modelSchemaList[result] = id;
-    this.modelSchemaNameList[result] = schemaName;
+    this.modelSchemaList[modelID] = id;
+    this.modelSchemaNameList[modelID] = schemaName;
     Log.debug("Parsing Model using " + schemaName + " Schema");
-    return result;
+    return modelID;
   }
 
   /**
@@ -543,6 +821,61 @@ export class IfcAPI {
     return result;
   }
 
+  /**
+   * Reads a file only up to the end of its HEADER section, which takes a few blocks of the file instead of tokenizing all
+   * of it, to decide how to handle the file before opening it
+   * @param data Buffer containing IFC data (bytes)
+   * @param settings Settings for loading the model @see LoaderSettings
+   * @returns The header lines and the estimated number of lines, undefined when the file has no HEADER section
+   */
+  ProbeModel(data: Uint8Array, settings?: LoaderSettings): ModelProbe | undefined {
+    return this.ProbeModelFromCallback(
+      (offset: number, size: number) => data.subarray(offset, offset + size),
+      data.byteLength,
+      settings
+    );
+  }
+
+  /**
+   * Reads a file only up to the end of its HEADER section, see ProbeModel
+   * @param callback a function of signature (offset:number, size: number) => Uint8Array that will retrieve the IFC data
+   * @param fileSize Bytes of the file, the number of lines is only estimated for the whole file when it is known
+   * @param settings Settings for loading the model @see LoaderSettings
+   * @returns The header lines and the estimated number of lines, undefined when the file has no HEADER section
+   */
+  ProbeModelFromCallback(
+    callback: ModelLoadCallback,
+    fileSize: number = 0,
+    settings?: LoaderSettings
+  ): ModelProbe | undefined {
+    let s = this.CreateSettings(settings);
+    let result = this.wasmModule.ProbeModel(
+      s,
+      (destPtr: number, offsetInSrc: number, destSize: number) => {
+        let data = callback(offsetInSrc, destSize);
+        let srcSize = Math.min(data.byteLength, destSize);
+        let dest = this.wasmModule.HEAPU8.subarray(destPtr, destPtr + srcSize);
+        dest.set(data.subarray(0, srcSize));
+        return srcSize;
+      },
+      fileSize
+    );
+    if (result.modelID == -1) return undefined;
+    const fileName = this.GetHeaderLine(result.modelID, FILE_NAME);
+    const fileSchema = this.GetHeaderLine(result.modelID, FILE_SCHEMA);
+    const probe: ModelProbe = {
+      schema: fileSchema?.arguments[0]?.[0]?.value ?? "",
+      fileName: fileName,
+      fileDescription: this.GetHeaderLine(result.modelID, FILE_DESCRIPTION),
+      fileSchema: fileSchema,
+      originatingSystem: fileName?.arguments[5]?.value ?? "",
+      dataOffset: result.dataOffset,
+      estimatedLines: result.estimatedLines,
+    };
+    this.wasmModule.CloseModel(result.modelID);
+    return probe;
+  }
+
   /**
    * Fetches the ifc schema version of a given model
    * @param modelID Model ID
@@ -642,9 +975,11 @@ export class IfcAPI {
    * Retrieves the geometry of an element
    * @param modelID Model handle retrieved by OpenModel
    * @param geometryExpressID express ID of the element
+   * @param lod level of detail of a mesh from GetFlatMesh or StreamMeshesLOD, 0 is the full geometry
    * @returns Geometry of the element as a list of vertices and indices
    */
-  GetGeometry(modelID: number, geometryExpressID: number): IfcGeometry {
+  GetGeometry(modelID: number, geometryExpressID: number, lod: number = 0): IfcGeometry {
+    if (lod > 0) return this.wasmModule.GetGeometryLOD(modelID, geometryExpressID, lod);
     return this.wasmModule.GetGeometry(modelID, geometryExpressID);
   }
 
@@ -696,6 +1031,16 @@ export class IfcAPI {
     return this.wasmModule.CreateProfile();
   }
 
+  /**
+   * Generates the buffers of many primitives in one call, on several threads where there are, instead of a
+   * Create, SetValues and GetBuffers round trip for each
+   * @param packed the items one after the other, see BatchGeometryKind
+   * @returns the buffers of all items in one contiguous output, null when the description is malformed
+   */
+  GetBatchBuffers(packed: ArrayLike<number>): BatchBuffers | null {
+    return this.wasmModule.GetBatchBuffers(packed instanceof Float64Array ? packed : Float64Array.from(packed));
+  }
+
   /**
    * Gets the header information required by the user
    * @param modelID Model handle retrieved by OpenModel
@@ -764,7 +1109,7 @@ export class IfcAPI {
    */
   GetLines(
     modelID: number,
-    expressIDs: Array<number>,
+    expressIDs: IDArray,
     flatten = false,
     inverse = false,
     inversePropKey: string | null | undefined = null
@@ -812,31 +1157,31 @@ export class IfcAPI {
               InheritanceDef[this.modelSchemaList[modelID]][inverseProp[1]]
             );
           }
-          let inverseIDs = this.wasmModule.GetInversePropertyForItem(
+          let inverseIDs: Uint32Array = this.wasmModule.GetInversePropertyForItem(
             modelID,
             rawLineData.ID,
             targetTypes,
             inverseProp[2],
             inverseProp[3]
           );
-          if (!inverseProp[3] && inverseIDs.size() > 0) {
+          if (!inverseProp[3] && inverseIDs.length > 0) {
             if (!flatten)
-              lineData[inverseProp[0]] = { type: 5, value: inverseIDs.get(0) };
+              lineData[inverseProp[0]] = { type: 5, value: inverseIDs[0] };
             else
               lineData[inverseProp[0]] = this.GetLine(
                 modelID,
-                inverseIDs.get(0)
+                inverseIDs[0]
               );
           } else {
-            for (let x = 0; x < inverseIDs.size(); x++) {
+            for (let x = 0; x < inverseIDs.length; x++) {
               if (!flatten)
                 lineData[inverseProp[0]].push({
                   type: 5,
-                  value: inverseIDs.get(x),
+                  value: inverseIDs[x],
                 });
               else
                 lineData[inverseProp[0]].push(
-                  this.GetLine(modelID, inverseIDs.get(x))
+                  this.GetLine(modelID, inverseIDs[x])
                 );
             }
           }
@@ -873,6 +1218,39 @@ export class IfcAPI {
     return Constructors[this.modelSchemaList[modelID]][type](args);
   }
 
+  /**
+   * Resolves GlobalIds to the lines that have them through an index built by the first call, without reading the lines
+   * @param modelID Model handle retrieved by OpenModel
+   * @param globalIds compressed GUIDs of 22 characters
+   * @returns the expressID of the line with each GlobalId in the same order, 0 for GlobalIds no line has
+   */
+  GetExpressIDsByGlobalIds(modelID: number, globalIds: Array<string>): Uint32Array {
+    return this.wasmModule.GetExpressIDsByGlobalIds(modelID, globalIds);
+  }
+
+  /**
+   * Gets the spatial tree below every IfcProject in one call from relationships indexed natively
+   * @param modelID Model handle retrieved by OpenModel
+   * @param propertySets if true each node lists its property sets
+   * @param typeProperties if true the property sets include those of the node's type object
+   * @returns the number of roots, then every node in preorder as its expressID, type code, number of children and
+   * number of property sets followed by their expressIDs. Children are aggregated objects and then contained elements
+   */
+  GetSpatialTree(modelID: number, propertySets = false, typeProperties = false): Uint32Array {
+    return this.wasmModule.GetSpatialTree(modelID, propertySets, typeProperties);
+  }
+
+  /**
+   * Gets the property sets of many elements in one call from relationships indexed natively
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of the elements
+   * @param typeProperties if true the property sets include those of each element's type object
+   * @returns per element in the same order the number of its property sets followed by their expressIDs
+   */
+  GetPropertySetIDs(modelID: number, expressIDs: Array<number>, typeProperties = false): Uint32Array {
+    return this.wasmModule.GetPropertySetIDs(modelID, expressIDs, typeProperties);
+  }
+
   /**
    * Creates a new ifc globally unqiue ID
    * @param modelID Model handle retrieved by OpenModel
@@ -1054,9 +1432,25 @@ export class IfcAPI {
   /** @ignore */
   GetRawLinesData(
     modelID: number,
-    expressIDs: Array<number>
+    expressIDs: IDArray
   ): Array<RawLineData> {
-    return this.wasmModule.GetLines(modelID, expressIDs) as Array<RawLineData>;
+    const buffer = this.GetRawLinesBuffer(modelID, expressIDs);
+    const lines: Array<RawLineData> = [];
+    for (let i = 0; i < buffer.length; i++) lines.push(buffer.GetLine(i));
+    return lines;
+  }
+
+  /**
+   * Exports lines in one binary buffer that is decoded line by line when read, much cheaper than reading every
+   * token of every line across the wasm boundary
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of the lines
+   * @returns the lines in the order of expressIDs
+   */
+  GetRawLinesBuffer(modelID: number, expressIDs: IDArray): RawLineBuffer {
+    // a view into wasm memory that lives until the next call, so it is copied
+    const bytes: Uint8Array = this.wasmModule.GetLinesBinary(modelID, expressIDs);
+    return new RawLineBuffer(bytes.slice());
   }
 
   /** @ignore */
@@ -1069,6 +1463,16 @@ export class IfcAPI {
     this.wasmModule.WriteLine(modelID, data.ID, data.type, data.arguments);
   }
 
+  /**
+   * Writes many lines in one call, much cheaper than WriteLine for every line, existing lines are updated
+   * @param modelID Model handle retrieved by OpenModel
+   * @param buffer lines in the layout of GetRawLinesBuffer, as RawLineWriter builds them
+   * @returns false and nothing written when the buffer is malformed
+   */
+  WriteRawLinesBuffer(modelID: number, buffer: Uint8Array): boolean {
+    return this.wasmModule.WriteLinesBinary(modelID, buffer);
+  }
+
   /** @ignore */
   WriteRawLinesData(modelID: number, data: Array<RawLineData>) {
     for (let rawLine of data)
@@ -1100,11 +1504,7 @@ export class IfcAPI {
     ) {
       types = types.concat(InheritanceDef[this.modelSchemaList[modelID]][type]);
     }
-    let lineIds = this.wasmModule.GetLineIDsWithType(modelID, types);
-    lineIds[Symbol.iterator] = function* () {
-      for (let i = 0; i < lineIds.size(); i++) yield lineIds.get(i);
-    };
-    return lineIds;
+    return ToVector(this.wasmModule.GetLineIDsWithType(modelID, types));
   }
 
   /**
@@ -1113,11 +1513,7 @@ export class IfcAPI {
    * @returns vector of all line IDs
    */
   GetAllLines(modelID: number): Vector<number> {
-    let lineIds = this.wasmModule.GetAllLines(modelID);
-    lineIds[Symbol.iterator] = function* () {
-      for (let i = 0; i < lineIds.size(); i++) yield lineIds.get(i);
-    };
-    return lineIds;
+    return ToVector(this.wasmModule.GetAllLines(modelID));
   }
 
   /**
@@ -1196,6 +1592,37 @@ export class IfcAPI {
     return crossSectionList;
   }
 
+  /**
+   * Streams the crossSections contained in IFCSECTIONEDSOLID, IFCSECTIONEDSURFACE, IFCSECTIONEDSOLIDHORIZONTAL (IFC4x3 or superior)
+   * They are extracted on several threads when the module is multithreaded and handed to the callback as they are done, so not in the order of GetAllCrossSections2D/3D
+   * @param modelID Model handle retrieved by OpenModel
+   * @param dimensions 2 for the cross sections in 2D, 3 for the cross sections in 3D
+   * @param callback Called with the cross sections of one element, its position in the order they are done and the number of elements
+   */
+  StreamAllCrossSections(modelID: number, dimensions: 2 | 3, callback: (crossSection: CrossSection, index: number, total: number) => void) {
+    const coordinationMatrix = this.GetCoordinationMatrix(modelID);
+    this.wasmModule.StreamAllCrossSections(modelID, dimensions, (alignment: any, index: number, total: number) => {
+      const curveList: Array<Curve> = [];
+      const expressList: Array<number> = [];
+      for (let j = 0; j < alignment.curves.size(); j++) {
+        const curve = alignment.curves.get(j);
+        const ptList: Array<Point> = [];
+        for (let p = 0; p < curve.points.size(); p++) {
+          const pt = curve.points.get(p);
+          ptList.push({ x: pt.x, y: pt.y, z: pt.z });
+        }
+        curveList.push({ points: ptList, userData: [], arcSegments: [] });
+        expressList.push(alignment.expressID.get(j));
+      }
+      const crossSection = {
+        FlatCoordinationMatrix: coordinationMatrix,
+        curves: curveList,
+        expressID: expressList,
+      };
+      callback(crossSection, index, total);
+    });
+  }
+
   /**
    * Returns all alignments contained in the IFC model (IFC4x3 or superior)
    * @param modelID model ID
@@ -1272,6 +1699,39 @@ export class IfcAPI {
     return alignmentList;
   }
 
+  /**
+   * Returns the curves of the elements of a model opened with _exportPolylines in place, packed into one buffer
+   * @param modelID Model handle retrieved by OpenModel
+   * @param types types of elements to read, all that StreamAllMeshes streams when empty
+   * @returns the curves, null when the model is not open
+   */
+  GetPolylines(modelID: number, types: IDArray = []): PolylineBuffer | null {
+    return this.wasmModule.GetPolylines(modelID, types);
+  }
+
+  /**
+   * Returns the curves of all alignments like GetAllAlignments, packed into one buffer with the alignment of every curve
+   * @param modelID Model handle retrieved by OpenModel
+   * @param part 0 for the horizontal curves, 1 for the vertical ones and 2 for the 3D curve of every alignment
+   * @returns the curves, null when the model is not open
+   */
+  GetAlignmentPolylines(modelID: number, part: number = 2): PolylineBuffer | null {
+    return this.wasmModule.GetAlignmentPolylines(modelID, part);
+  }
+
+  /**
+   * Streams the terrains of an element that TERRAIN_CHUNK_TRIANGLES left out of its mesh, one chunk at a time
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressID express ID of the element
+   * @param maxError furthest a vertex may move when the chunks are simplified, 0 keeps every triangle. A coarse pass
+   * can be streamed before a fine one
+   * @param chunkCallback called for every chunk, its arrays are only valid during the call
+   * @returns the number of chunks, -1 when the model is not open
+   */
+  StreamTerrain(modelID: number, expressID: number, maxError: number, chunkCallback: (chunk: TerrainChunk) => void): number {
+    return this.wasmModule.StreamTerrain(modelID, expressID, maxError, chunkCallback);
+  }
+
   /**
    * Set the transformation matrix
    * @param modelID model ID
@@ -1300,10 +1760,61 @@ export class IfcAPI {
     return this.getSubArray(this.wasmModule.HEAPF32, ptr, size);
   }
 
+  /**
+   * Reads vertex data written with VERTEX_FORMAT_QUANTIZED
+   * @param ptr pointer returned by GetVertexData
+   * @param size number of uint16 values returned by GetVertexDataSize
+   * @returns 4 values per vertex, see LoaderSettings.VERTEX_FORMAT
+   */
+  GetQuantizedVertexArray(ptr: number, size: number): Uint16Array {
+    return this.wasmModule.HEAPU16.subarray(ptr / 2, ptr / 2 + size).slice(0);
+  }
+
   GetIndexArray(ptr: number, size: number): Uint32Array {
     return this.getSubArray(this.wasmModule.HEAPU32, ptr, size);
   }
 
+  /**
+   * Keeps a geometry in wasm memory until it is released as often as it was pinned, Clear and GEOMETRY_MEMORY_LIMIT
+   * leave it alone meanwhile, so its buffers can be read in place with GetPinnedVertexArray and GetPinnedIndexArray
+   * @param modelID Model handle retrieved by OpenModel
+   * @param geometryExpressID geometryExpressID of a placed geometry of the last meshes requested
+   * @returns false when there is no such geometry
+   */
+  PinGeometry(modelID: number, geometryExpressID: number): boolean {
+    return this.wasmModule.PinGeometry(modelID, geometryExpressID);
+  }
+
+  /**
+   * Releases a geometry pinned with PinGeometry, views of it become invalid once it is released as often as it was pinned
+   * @param modelID Model handle retrieved by OpenModel
+   * @param geometryExpressID geometryExpressID of the pinned geometry
+   */
+  ReleaseGeometry(modelID: number, geometryExpressID: number) {
+    this.wasmModule.ReleaseGeometry(modelID, geometryExpressID);
+  }
+
+  /**
+   * A view of the vertex data of a pinned geometry, without a copy. The view is valid until the geometry is released
+   * and until wasm memory grows, so upload it before calling into web-ifc again
+   * @param modelID Model handle retrieved by OpenModel
+   * @param geometryExpressID geometryExpressID of the pinned geometry
+   * @returns null when the geometry is not pinned, Uint16Array for VERTEX_FORMAT_QUANTIZED
+   */
+  GetPinnedVertexArray(modelID: number, geometryExpressID: number): Float32Array | Uint16Array | null {
+    return this.wasmModule.GetPinnedVertexArray(modelID, geometryExpressID);
+  }
+
+  /**
+   * A view of the index data of a pinned geometry, without a copy, valid like GetPinnedVertexArray
+   * @param modelID Model handle retrieved by OpenModel
+   * @param geometryExpressID geometryExpressID of the pinned geometry
+   * @returns null when the geometry is not pinned
+   */
+  GetPinnedIndexArray(modelID: number, geometryExpressID: number): Uint32Array | null {
+    return this.wasmModule.GetPinnedIndexArray(modelID, geometryExpressID);
+  }
+
   getSubArray(heap: any, startPtr: number, sizeBytes: number) {
     return heap.subarray(startPtr / 4, startPtr / 4 + sizeBytes).slice(0);
   }
@@ -1334,12 +1845,234 @@ export class IfcAPI {
    */
   StreamMeshes(
     modelID: number,
-    expressIDs: Array<number>,
+    expressIDs: IDArray,
     meshCallback: (mesh: FlatMesh, index: number, total: number) => void
   ) {
     this.wasmModule.StreamMeshes(modelID, expressIDs, meshCallback);
   }
 
+  /**
+   * Streams meshes of a model like StreamMeshes, with the vertices of every geometry already transformed by its
+   * placement, so that they can be used without their flatTransformation
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of elements to stream
+   * @param meshCallback callback function that is called for each mesh, the arrays are views into wasm memory that only
+   * live for the time of the callback
+   */
+  StreamMeshesWorldSpace(
+    modelID: number,
+    expressIDs: IDArray,
+    meshCallback: (mesh: WorldSpaceMesh, index: number, total: number) => void
+  ) {
+    this.wasmModule.StreamMeshesWorldSpace(modelID, expressIDs, meshCallback);
+  }
+
+  /**
+   * Gets the mesh of an element with the vertices of every geometry already transformed by its placement
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressID expressID of the element
+   * @returns the mesh with arrays of its own, null when the model is not open
+   */
+  GetFlatMeshWorldSpace(modelID: number, expressID: number): WorldSpaceMesh | null {
+    return this.wasmModule.GetFlatMeshWorldSpace(modelID, expressID);
+  }
+
+  /**
+   * Streams meshes of a model with specific express id at several levels of detail, every mesh is handed to the
+   * callback from the coarsest level down to the full mesh at level 0, read its geometries with GetGeometry and the
+   * level. The coarse levels are decimated from the full mesh, so they cost no second meshing
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of elements to stream
+   * @param levels number of coarse levels before the full mesh
+   * @param meshCallback callback function that is called for each mesh and level
+   */
+  StreamMeshesLOD(
+    modelID: number,
+    expressIDs: IDArray,
+    levels: number,
+    meshCallback: (mesh: FlatMesh, lod: number, index: number, total: number) => void
+  ) {
+    this.wasmModule.StreamMeshesLOD(modelID, expressIDs, levels, meshCallback);
+  }
+
+  /**
+   * Streams meshes of a model with specific express id as instances: every geometry is handed to geometryCallback
+   * once, read it with GetGeometry within the callback, and every placement of it follows as an instance record.
+   * The records arrive in batches, INSTANCE_RECORD_SIZE numbers each: the element's expressID, the geometry's
+   * expressID, the color as r, g, b, a and the column major transformation. A record always arrives after the
+   * callback of its geometry, the array is only valid for the time of the callback
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of elements to stream
+   * @param geometryCallback callback function that is called for each geometry
+   * @param instanceCallback callback function that is called for each batch of instance records
+   */
+  StreamInstancedMeshes(
+    modelID: number,
+    expressIDs: IDArray,
+    geometryCallback: (geometryExpressID: number) => void,
+    instanceCallback: (instances: Float64Array) => void
+  ) {
+    this.wasmModule.StreamInstancedMeshes(modelID, expressIDs, geometryCallback, instanceCallback);
+  }
+
+  /**
+   * Streams meshes of a model with specific express id in batches, with one callback per batch instead of one per mesh.
+   * A batch holds MESH_RECORD_SIZE numbers per placed geometry: the element's expressID, the geometry's expressID, the
+   * element's index in expressIDs, the color as r, g, b, a, the column major transformation and then the pointer and
+   * size of the vertex data and of the index data, to be read with GetVertexArray and GetIndexArray. The batch and the
+   * data it points to are only valid for the time of the callback
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of elements to stream
+   * @param meshesCallback callback function that is called for each batch
+   * @param batchBytes bytes of geometry a batch collects before it is sent, 0 uses 16MB
+   */
+  StreamMeshesBatched(
+    modelID: number,
+    expressIDs: IDArray,
+    meshesCallback: (records: Float64Array, total: number) => void,
+    batchBytes: number = 0
+  ) {
+    this.wasmModule.StreamMeshesBatched(modelID, expressIDs, batchBytes, meshesCallback);
+  }
+
+  /**
+   * Merges the meshes of elements into one mesh per color, so that they take one draw call each. The vertices are
+   * transformed by their placement already, the ranges tell which indices belong to which element for picking
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of elements to merge
+   * @returns one mesh per color, in the order the colors first appear
+   */
+  GetMergedMeshes(modelID: number, expressIDs: IDArray): Array<MergedMesh> {
+    const meshes: Array<MergedMesh> = [];
+    this.wasmModule.GetMergedMeshes(modelID, expressIDs, (color: Color, vertices: Float32Array, indices: Uint32Array, ranges: Uint32Array) => {
+      // the arrays are views into wasm memory that only live for the time of the callback
+      meshes.push({ color, vertices: vertices.slice(), indices: indices.slice(), ranges: ranges.slice() });
+    });
+    return meshes;
+  }
+
+  /**
+   * Indexes the meshes of elements for RayCast, FrustumQuery and ClosestPoint, replacing what was indexed before.
+   * The queries work in the space of the flat mesh transformations
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs expressIDs of elements to index
+   */
+  BuildSpatialIndex(modelID: number, expressIDs: IDArray) {
+    this.wasmModule.BuildSpatialIndex(modelID, expressIDs);
+  }
+
+  /**
+   * Casts a ray against the indexed elements, see BuildSpatialIndex
+   * @param modelID Model handle retrieved by OpenModel
+   * @param origin start of the ray
+   * @param direction direction of the ray, of any length
+   * @param maxDistance farthest hit to report, 0 has no limit
+   * @returns the first hit, null when the ray misses
+   */
+  RayCast(modelID: number, origin: Point, direction: Point, maxDistance: number = 0): RayHit | null {
+    return this.wasmModule.RayCast(modelID, origin, direction, maxDistance);
+  }
+
+  /**
+   * Finds the indexed elements whose bounding boxes are inside the planes, e.g. the 6 planes of a view frustum
+   * @param modelID Model handle retrieved by OpenModel
+   * @param planes 4 numbers per plane: the normal and d, what has dot(normal, p) + d >= 0 is inside
+   * @returns expressIDs of the elements found
+   */
+  FrustumQuery(modelID: number, planes: Array<number> | Float64Array): Vector<number> {
+    return ToVector(this.wasmModule.FrustumQuery(modelID, planes));
+  }
+
+  /**
+   * Finds the closest point on the indexed elements, see BuildSpatialIndex
+   * @param modelID Model handle retrieved by OpenModel
+   * @param point point to measure from
+   * @param maxDistance farthest point to report, 0 has no limit
+   * @returns the closest point, null when nothing is within maxDistance
+   */
+  ClosestPoint(modelID: number, point: Point, maxDistance: number = 0): ClosestPoint | null {
+    return this.wasmModule.ClosestPoint(modelID, point, maxDistance);
+  }
+
+  /**
+   * Finds the pairs of elements of two sets whose meshes clash, the sets may be in different models. Boxes are swept and
+   * pruned first, the triangles of the pairs left are tested on several threads in multithreaded builds. Models meshed
+   * with COORDINATE_TO_ORIGIN are only compared correctly when they were moved by the same offset
+   * @param modelA Model handle of the first set
+   * @param expressIDsA elements of the first set
+   * @param modelB Model handle of the second set, pairs of an element with itself are skipped when it is modelA
+   * @param expressIDsB elements of the second set
+   * @param clashCallback gets the clashing pairs in batches as [expressIDA, expressIDB, ...], a view into wasm memory
+   * that only lives for the time of the callback
+   * @param tolerance triangles closer than this clash, with a negative tolerance they have to overlap by that much so
+   * that touching faces are not reported
+   * @returns false when a model is not open
+   */
+  DetectClashes(
+    modelA: number,
+    expressIDsA: IDArray,
+    modelB: number,
+    expressIDsB: IDArray,
+    clashCallback: (pairs: Uint32Array) => void,
+    tolerance: number = 0
+  ): boolean {
+    return this.wasmModule.DetectClashes(modelA, expressIDsA, modelB, expressIDsB, tolerance, clashCallback);
+  }
+
+  /**
+   * Turns the counters of GetGeometryProfile on or off, they cost some time per mesh while on
+   * @param modelID Model handle retrieved by OpenModel
+   * @returns false when the wasm was built without WEBIFC_GEOMETRY_PROFILING
+   */
+  SetGeometryProfiling(modelID: number, enabled: boolean): boolean {
+    return this.wasmModule.SetGeometryProfiling(modelID, enabled);
+  }
+
+  /**
+   * Counters collected while profiling was on, see SetGeometryProfiling
+   * @param modelID Model handle retrieved by OpenModel
+   */
+  GetGeometryProfile(modelID: number): GeometryProfile {
+    return this.wasmModule.GetGeometryProfile(modelID);
+  }
+
+  /**
+   * Drops the counters collected so far
+   * @param modelID Model handle retrieved by OpenModel
+   */
+  ResetGeometryProfile(modelID: number) {
+    this.wasmModule.ResetGeometryProfile(modelID);
+  }
+
+  /**
+   * Elements meshed with a boolean over budget since the last ClearOverBudgetElements, see BOOLEAN_TIME_BUDGET. Their
+   * meshes kept the operands un-cut, reprocess them with a model opened without a budget
+   * @param modelID Model handle retrieved by OpenModel
+   * @returns expressIDs in ascending order
+   */
+  GetOverBudgetElements(modelID: number): Vector<number> {
+    return ToVector(this.wasmModule.GetOverBudgetElements(modelID));
+  }
+
+  /**
+   * Forgets the elements listed by GetOverBudgetElements
+   * @param modelID Model handle retrieved by OpenModel
+   */
+  ClearOverBudgetElements(modelID: number) {
+    this.wasmModule.ClearOverBudgetElements(modelID);
+  }
+
+  /**
+   * Drops the cached geometry derived from the lines and from every line depending on them, WriteLine, WriteLines and
+   * DeleteLine do so by themselves. After an edit it tells which elements to mesh again, everything else stays cached
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs the edited lines
+   * @returns expressIDs of the elements depending on the lines in ascending order
+   */
+  InvalidateLines(modelID: number, expressIDs: IDArray): Vector<number> {
+    return ToVector(this.wasmModule.InvalidateLines(modelID, expressIDs));
+  }
+
   /**
    * Streams all meshes of a model
    * @param modelID Model handle retrieved by OpenModel
@@ -1352,6 +2085,24 @@ export class IfcAPI {
     this.wasmModule.StreamAllMeshes(modelID, meshCallback);
   }
 
+  /**
+   * Streams the meshes of a model with what is seen first first: the largest elements, or with a camera those covering
+   * the largest angle from it. The order comes from cheap boxes of the elements' placements and representations, the
+   * meshing work is the same as for StreamAllMeshes
+   * @param modelID Model handle retrieved by OpenModel
+   * @param meshCallback callback function that is called for each mesh, index is the rank of the element
+   * @param camera position [x, y, z] of the camera in the space of the meshes, null orders by size alone
+   * @param types types of elements to stream, all that StreamAllMeshes streams when empty
+   */
+  StreamAllMeshesPrioritized(
+    modelID: number,
+    meshCallback: (mesh: FlatMesh, index: number, total: number) => void,
+    camera: ArrayLike<number> | null = null,
+    types: IDArray = []
+  ) {
+    this.wasmModule.StreamAllMeshesPrioritized(modelID, types, camera === null ? null : Array.from(camera), meshCallback);
+  }
+
   /**
    * Streams all meshes of a model with a specific ifc type
    * @param modelID Model handle retrieved by OpenModel
@@ -1360,12 +2111,154 @@ export class IfcAPI {
    */
   StreamAllMeshesWithTypes(
     modelID: number,
-    types: Array<number>,
+    types: IDArray,
     meshCallback: (mesh: FlatMesh, index: number, total: number) => void
   ) {
     this.wasmModule.StreamAllMeshesWithTypes(modelID, types, meshCallback);
   }
 
+  /**
+   * Splits the elements of a model into shards of consecutive expressIDs with about the same estimated meshing cost,
+   * from the types of their representation items and the openings voiding them. The manifest only depends on the file
+   * and the types, so nodes that open the same file get the same one without exchanging it
+   * @param modelID Model handle retrieved by OpenModel
+   * @param shards number of shards wanted, fewer when there are fewer elements
+   * @param types types of elements to split, all that StreamAllMeshes streams when empty
+   * @returns the shards in expressID order, null when the model is not open
+   */
+  GetPartitionManifest(modelID: number, shards: number, types: IDArray = []): Array<PartitionShard> | null {
+    const manifest: Uint32Array | null = this.wasmModule.GetPartitionManifest(modelID, types, shards);
+    if (manifest === null) return null;
+    const result: Array<PartitionShard> = [];
+    for (let i = 0; i < manifest[0]; i++) {
+      result.push({
+        firstExpressID: manifest[1 + 4 * i],
+        lastExpressID: manifest[2 + 4 * i],
+        elementCount: manifest[3 + 4 * i],
+        cost: manifest[4 + 4 * i],
+      });
+    }
+    return result;
+  }
+
+  /**
+   * Streams the meshes of one shard of a manifest from GetPartitionManifest, with the index and total they get from
+   * StreamAllMeshesWithTypes, so the meshes of all shards together are those of a single run
+   * @param modelID Model handle retrieved by OpenModel
+   * @param manifest shards from GetPartitionManifest made with the same types
+   * @param shard index of the shard to stream
+   * @param meshCallback callback function that is called for each mesh
+   * @param types types of elements to stream, all that StreamAllMeshes streams when empty
+   * @returns false when the shard is not in the manifest
+   */
+  StreamAllMeshesShard(
+    modelID: number,
+    manifest: Array<PartitionShard>,
+    shard: number,
+    meshCallback: (mesh: FlatMesh, index: number, total: number) => void,
+    types: IDArray = []
+  ): boolean {
+    const packed: Array<number> = [manifest.length];
+    for (const entry of manifest) {
+      packed.push(entry.firstExpressID, entry.lastExpressID, entry.elementCount, entry.cost);
+    }
+    return this.wasmModule.StreamAllMeshesShard(modelID, types, packed, shard, meshCallback);
+  }
+
+  /**
+   * Starts streaming the meshes of a model a slice at a time, so that a single thread can render between the slices.
+   * The meshes come in the order StreamAllMeshes streams them on one thread, call StepStream until it returns false and
+   * EndStream once done or to stop early. The model must not change while the stream is open
+   * @param modelID Model handle retrieved by OpenModel
+   * @param types types of elements to stream, all that StreamAllMeshes streams when empty
+   * @returns the stream handle, -1 when the model is not open
+   */
+  BeginStream(modelID: number, types: IDArray = []): number {
+    return this.wasmModule.BeginStream(modelID, types);
+  }
+
+  /**
+   * Streams the next meshes of a stream from BeginStream until the time budget is spent, at least one per call
+   * @param stream handle retrieved by BeginStream
+   * @param timeBudgetMs milliseconds after which no further element is started
+   * @param meshCallback callback function that is called for each mesh, index and total are over the whole stream
+   * @returns true while meshes are left
+   */
+  StepStream(
+    stream: number,
+    timeBudgetMs: number,
+    meshCallback: (mesh: FlatMesh, index: number, total: number) => void
+  ): boolean {
+    return this.wasmModule.StepStream(stream, timeBudgetMs, meshCallback);
+  }
+
+  /**
+   * Ends a stream from BeginStream and frees what was cached for it, closing the model ends its streams too
+   * @param stream handle retrieved by BeginStream
+   */
+  EndStream(stream: number) {
+    this.wasmModule.EndStream(stream);
+  }
+
+  /**
+   * Converts the meshes of a model into a binary glTF (GLB) in one pass. Every geometry is written once and shared by its
+   * placements, every element is a node with its expressID and type in extras
+   * @param modelID Model handle retrieved by OpenModel
+   * @param types types of elements to convert, all that StreamAllMeshes streams when empty
+   * @returns the parts of the GLB in order, new Blob(parts) or writing them one after the other gives the file, null when
+   * the model is not open or the GLB would exceed 4GB
+   */
+  ExportGLB(modelID: number, types: IDArray = []): Array<Uint8Array> | null {
+    const chunks: Array<Uint8Array> = [];
+    let prefix: Uint8Array | null = null;
+    const done = this.wasmModule.ExportGLB(modelID, types, (bytes: Uint8Array, isPrefix: boolean) => {
+      // the bytes are a view into wasm memory that only lives for the time of the callback
+      if (isPrefix) prefix = bytes.slice();
+      else chunks.push(bytes.slice());
+    });
+    if (!done || prefix === null) return null;
+    return [prefix, ...chunks];
+  }
+
+  /**
+   * Converts the meshes of a model into 3D Tiles: an octree of GLB tiles that refine by adding elements, for models too
+   * large to be drawn at once. The tiles are written on several threads in multithreaded builds
+   * @param modelID Model handle retrieved by OpenModel
+   * @param fileCallback gets every file with its path relative to tileset.json, tiles/<index>.glb for the tiles and at
+   * last tileset.json itself. The bytes are a view into wasm memory that only lives for the time of the callback
+   * @param maxElementsPerTile elements a tile is split above, larger elements stay in the tiles above
+   * @param types types of elements to convert, all that StreamAllMeshes streams when empty
+   * @returns false when the model is not open or has nothing to tile
+   */
+  ExportTiles(
+    modelID: number,
+    fileCallback: (path: string, bytes: Uint8Array) => void,
+    maxElementsPerTile: number = 256,
+    types: IDArray = []
+  ): boolean {
+    return this.wasmModule.ExportTiles(modelID, types, maxElementsPerTile, fileCallback);
+  }
+
+  /**
+   * Measures the volume, surface area and box of elements from their meshes in one call, on several threads in
+   * multithreaded builds, without copying any mesh to JS. The quantities are in the space of the streamed meshes
+   * @param modelID Model handle retrieved by OpenModel
+   * @param expressIDs elements to measure, all that StreamAllMeshes streams when empty
+   * @returns 8 values per element in the order of expressIDs: volume, area, minX, minY, minZ, maxX, maxY, maxZ. Elements
+   * without geometry have a volume and area of 0 and a box of NaN. Null when the model is not open
+   */
+  GetElementQuantities(modelID: number, expressIDs: IDArray = []): Float64Array | null {
+    return this.wasmModule.GetElementQuantities(modelID, expressIDs);
+  }
+
+  /**
+   * Where the memory of a model goes, see MemoryStats
+   * @param modelID Model handle retrieved by OpenModel
+   */
+  GetMemoryStats(modelID: number): MemoryStats {
+    return this.wasmModule.GetMemoryStats(modelID);
+  }
+
   /**
    * Checks if a specific model ID is open or closed
    * @param modelID Model handle retrieved by OpenModel
@@ -1392,9 +2285,11 @@ export class IfcAPI {
    * Load geometry for a single element
    * @param modelID Model handle retrieved by OpenModel
    * @param expressID ExpressID of the element
+   * @param lod level of detail, 0 is the full mesh and every further level is coarser, read the geometries with GetGeometry and the same level
    * @returns FlatMesh object
    */
-  GetFlatMesh(modelID: number, expressID: number): FlatMesh {
+  GetFlatMesh(modelID: number, expressID: number, lod: number = 0): FlatMesh {
+    if (lod > 0) return this.wasmModule.GetFlatMeshLOD(modelID, expressID, lod);
     return this.wasmModule.GetFlatMesh(modelID, expressID);
   }
 
@@ -1493,6 +2388,28 @@ export class IfcAPI {
     this.wasmModule.SetLogLevel(level);
   }
 
+  /**
+   * Records trace events of loading and meshing, for all models, far cheaper than debug logging
+   * @param enabled whether events are recorded
+   */
+  SetTracing(enabled: boolean): void {
+    this.wasmModule.SetTracing(enabled);
+  }
+
+  /**
+   * The most recent trace events of every thread as Chrome trace JSON, it opens in Perfetto or chrome://tracing
+   */
+  GetTrace(): string {
+    return this.wasmModule.GetTrace();
+  }
+
+  /**
+   * Drops the trace events recorded so far
+   */
+  ClearTrace(): void {
+    this.wasmModule.ClearTrace();
+  }
+
   /**
    * Encodes test using IFC Encoding
    * @text the text to encode
@@ -116,6 +116,15 @@ describe('Properties', () => {
         expect(elements[0].hasOwnProperty("GlobalId")).toBeTruthy();
     })
 
+    test('can get the spatial tree and property sets in one call', async () => {
+        const tree = ifcApi.GetSpatialTree(modelID, true);
+        expect(tree[0]).toEqual(1);
+        expect(tree[1]).toEqual(119);
+        const propSetIds = ifcApi.GetPropertySetIDs(modelID, [9989]);
+        expect(propSetIds[0]).toEqual(4);
+        expect(propSetIds.length).toEqual(5);
+    })
+
     test('can get all items of a given type', async () => {
         const IFCWALLSTANDARDCASEITEMS: any = await ifcApi.GetLineIDsWithType(modelID, IFCWALLSTANDARDCASE);
         expect(IFCWALLSTANDARDCASEITEMS.size()).toEqual(17);
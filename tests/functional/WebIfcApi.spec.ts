@@ -151,6 +151,16 @@ describe('WebIfcApi reading methods', () => {
         expect(schemaLine.arguments.length).toBe(1);
         expect(schemaLine.arguments[0][0].value).toEqual(expectedFileSchema);
     });
+    test('can probe the header without opening the model', () => {
+        const probe : any = ifcApi.ProbeModel(exampleIFCData);
+        expect(probe).toBeDefined();
+        expect(probe.schema).toEqual(expectedFileSchema);
+        expect(probe.fileName.arguments[0].value).toEqual(expectedFileName);
+        expect(probe.fileDescription.arguments[0][0].value).toEqual(expectedFileDescription);
+        expect(probe.dataOffset).toBeLessThan(exampleIFCData.byteLength);
+        expect(probe.estimatedLines).toBeGreaterThan(0);
+        expect(ifcApi.ProbeModel(new TextEncoder().encode("ISO-10303-21;\nHEADER;\n"))).toBeUndefined();
+    });
     test('can get name for type code', () => {
         expect(ifcApi.GetNameFromTypeCode(WebIFC.IFCPROPERTYSINGLEVALUE)).toBe("IfcPropertySingleValue");
         expect(ifcApi.GetNameFromTypeCode(WebIFC.IFCWALL)).toBe("IfcWall");
@@ -170,6 +180,57 @@ describe('WebIfcApi reading methods', () => {
         expect(ifcApi.IsIfcElement(-1)).toBeFalsy();
         expect(ifcApi.IsIfcElement(-5)).toBeFalsy();
     });
+    test('decodes binary lines like GetLine for every line of a model', () => {
+        const lines: number[] = [...ifcApi.GetAllLines(modelID)];
+        const buffer = ifcApi.GetRawLinesBuffer(modelID, lines);
+        expect(buffer.length).toEqual(lines.length);
+        for (let i = 0; i < lines.length; i++) {
+            expect(buffer.GetExpressID(i)).toEqual(lines[i]);
+            expect(buffer.GetType(i)).toEqual(ifcApi.GetLineType(modelID, lines[i]));
+            expect(buffer.GetLine(i)).toEqual(ifcApi.wasmModule.GetLine(modelID, lines[i]));
+        }
+    });
+    test('decodes binary lines like GetLine for every kind of argument', () => {
+        const argumentsIFC = new TextEncoder().encode([
+            "ISO-10303-21;", "HEADER;", "FILE_DESCRIPTION((''),'2;1');", "FILE_NAME('arguments.ifc','',(''),(''),'','','');", "FILE_SCHEMA(('IFC4'));", "ENDSEC;", "DATA;",
+            "#1=IFCPERSON($,'Family','Given',('A','B'),$,$,$,$);",
+            "#2=IFCPROPERTYSINGLEVALUE('Count',$,IFCINTEGER(-42),$);",
+            "#3=IFCPROPERTYSINGLEVALUE('Width',$,IFCLENGTHMEASURE(1.5E-3),$);",
+            "#4=IFCPROPERTYSINGLEVALUE('Flag',$,IFCBOOLEAN(.T.),$);",
+            "#5=IFCPROPERTYSINGLEVALUE('Unknown',$,IFCLOGICAL(.U.),$);",
+            "#6=IFCPROPERTYLISTVALUE('Values',$,(IFCREAL(0.10),IFCREAL(-2.)),$);",
+            "#7=IFCPROPERTYLISTVALUE('Empty',$,(),$);",
+            "#8=IFCCARTESIANPOINTLIST3D(((0.,0.,0.),(1.,0.,0.),(1.,1.,1.E10)));",
+            "#9=IFCINDEXEDPOLYGONALFACE((1,2,3));",
+            "#10=IFCPROPERTYSET('0000000000000000000001',$,'Set','\\X2\\03C0\\X0\\',(#2,#3,#4,#5,#6,#7));",
+            "#12=IFCWALL('0000000000000000000002',*,$,$,$,$,$,$,.NOTDEFINED.);",
+            "ENDSEC;", "END-ISO-10303-21;"].join("\n"));
+        const argumentsModelID = ifcApi.OpenModel(argumentsIFC);
+        // 11 and 13 do not exist
+        const lines = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13];
+        const buffer = ifcApi.GetRawLinesBuffer(argumentsModelID, lines);
+        for (let i = 0; i < lines.length; i++) expect(buffer.GetLine(i)).toEqual(ifcApi.wasmModule.GetLine(argumentsModelID, lines[i]));
+
+        const line = (expressID: number) => buffer.GetLine(lines.indexOf(expressID)).arguments;
+        expect(line(1)[0]).toBeNull();
+        expect(line(1)[3]).toEqual([{ type: WebIFC.STRING, value: 'A' }, { type: WebIFC.STRING, value: 'B' }]);
+        expect(line(2)[2]).toEqual({ type: WebIFC.LABEL, typecode: WebIFC.IFCINTEGER, value: -42 });
+        // reals keep the text they were written with
+        expect(line(3)[2]).toEqual({ type: WebIFC.LABEL, typecode: WebIFC.IFCLENGTHMEASURE, value: '1.5E-3' });
+        expect(line(4)[2].value).toBe(true);
+        expect(line(5)[2].value).toBeUndefined();
+        expect(line(6)[2]).toEqual([{ type: WebIFC.LABEL, typecode: WebIFC.IFCREAL, value: '0.10' }, { type: WebIFC.LABEL, typecode: WebIFC.IFCREAL, value: '-2.' }]);
+        expect(line(7)[2]).toEqual([]);
+        expect(line(8)[0][2]).toEqual([{ type: WebIFC.REAL, value: '1.' }, { type: WebIFC.REAL, value: '1.' }, { type: WebIFC.REAL, value: '1.E10' }]);
+        expect(line(9)[0]).toEqual([{ type: WebIFC.INTEGER, value: 1 }, { type: WebIFC.INTEGER, value: 2 }, { type: WebIFC.INTEGER, value: 3 }]);
+        expect(line(10)[3]).toEqual({ type: WebIFC.STRING, value: '\u03C0' });
+        expect(line(10)[4]).toEqual([2, 3, 4, 5, 6, 7].map((value) => ({ type: WebIFC.REF, value })));
+        // the unset attribute is left out as GetLine leaves it out
+        expect(line(12)[line(12).length - 1]).toEqual({ type: WebIFC.ENUM, value: 'NOTDEFINED' });
+        expect(buffer.GetExpressID(lines.indexOf(11))).toEqual(0);
+        expect(buffer.GetLine(lines.indexOf(13))).toEqual({});
+        ifcApi.CloseModel(argumentsModelID);
+    });
 });
 
 describe('WebIfcApi geometries', () => {
@@ -235,6 +296,171 @@ describe('WebIfcApi geometries', () => {
         expect(geometryIndexDatasString).toEqual(expectedVertexAndIndexDatas.indexDatas);
         expect(geometryVertexArrayString).toEqual(expectedVertexAndIndexDatas.vertexDatas);
     })
+    test('bakes the placements of a flat mesh into its vertices', () => {
+        const expressID = geometries.get(4).expressID;
+        const flatMesh = ifcApi.GetFlatMesh(modelID, expressID);
+        const placed = flatMesh.geometries.get(0);
+        const geometry = ifcApi.GetGeometry(modelID, placed.geometryExpressID);
+        const local = ifcApi.GetVertexArray(geometry.GetVertexData(), geometry.GetVertexDataSize());
+        const m = placed.flatTransformation;
+        const baked = ifcApi.GetFlatMeshWorldSpace(modelID, expressID);
+        expect(baked!.expressID).toEqual(expressID);
+        const vertices = baked!.geometries[0].vertexData;
+        expect(vertices.length).toEqual(local.length);
+        for (let i = 0; i < local.length; i += 6) {
+            for (let axis = 0; axis < 3; axis++) {
+                const world = m[axis] * local[i] + m[4 + axis] * local[i + 1] + m[8 + axis] * local[i + 2] + m[12 + axis];
+                expect(vertices[i + axis]).toBeCloseTo(world, 3);
+            }
+        }
+        let streamed = 0;
+        ifcApi.StreamMeshesWorldSpace(modelID, [expressID], (mesh) => {
+            streamed += mesh.geometries.length;
+        });
+        expect(streamed).toEqual(baked!.geometries.length);
+    })
+    test('coordinates to the origin the same whichever element is meshed first', () => {
+        const exampleIFCData = fs.readFileSync(path.join(__dirname, '../ifcfiles/public/example.ifc'));
+        const first = ifcApi.OpenModel(exampleIFCData, { COORDINATE_TO_ORIGIN: true });
+        const second = ifcApi.OpenModel(exampleIFCData, { COORDINATE_TO_ORIGIN: true });
+        ifcApi.GetFlatMesh(first, geometries.get(0).expressID);
+        ifcApi.GetFlatMesh(second, geometries.get(geometries.size() - 1).expressID);
+        expect(ifcApi.GetCoordinationMatrix(first).join(",")).toEqual(ifcApi.GetCoordinationMatrix(second).join(","));
+        ifcApi.CloseModel(first);
+        ifcApi.CloseModel(second);
+    })
+    test('packs the curves of elements and alignments into one buffer', () => {
+        const exampleIFCData = fs.readFileSync(path.join(__dirname, '../ifcfiles/public/example.ifc'));
+        const polylineModelID = ifcApi.OpenModel(exampleIFCData, { EXPORT_POLYLINES: true });
+        const polylines = ifcApi.GetPolylines(polylineModelID);
+        expect(polylines).not.toBeNull();
+        expect(polylines!.offsets.length).toEqual(polylines!.expressIDs.length + 1);
+        expect(polylines!.offsets[polylines!.offsets.length - 1] * 3).toEqual(polylines!.points.length);
+        ifcApi.CloseModel(polylineModelID);
+
+        const roadIFCData = fs.readFileSync(path.join(__dirname, '../ifcfiles/public/KIT-Simple-Road-Test-Web-IFC4x3_RC2.ifc'));
+        const roadModelID = ifcApi.OpenModel(roadIFCData);
+        const alignments = ifcApi.GetAllAlignments(roadModelID);
+        const horizontal = ifcApi.GetAlignmentPolylines(roadModelID, 0);
+        let points = 0;
+        for (const alignment of alignments) {
+            for (const curve of alignment.horizontal) points += curve.points.length;
+        }
+        expect(horizontal!.points.length).toEqual(points * 3);
+        expect(ifcApi.GetAlignmentPolylines(roadModelID, 3)).toBeNull();
+        ifcApi.CloseModel(roadModelID);
+    })
+    test('generates the buffers of a batch of primitives in one call', () => {
+        const boxes = [[0, 0, 0, 1, 1, 1], [2, -1, 0, 3, 4, 5]];
+        const packed: number[] = [];
+        for (const box of boxes) packed.push(WebIFC.BatchGeometryKind.AABB, ...box);
+        const batch = ifcApi.GetBatchBuffers(packed);
+        expect(batch).not.toBeNull();
+        expect(batch!.ranges.length).toEqual(boxes.length * 4);
+        boxes.forEach((box, i) => {
+            const aabb = ifcApi.CreateAABB();
+            aabb.SetValues(box[0], box[1], box[2], box[3], box[4], box[5]);
+            const single = aabb.GetBuffers();
+            const [firstVertex, vertexCount, firstIndex, indexCount] = batch!.ranges.subarray(i * 4, i * 4 + 4);
+            expect(vertexCount).toEqual(single.fvertexData.size());
+            expect(indexCount).toEqual(single.indexData.size());
+            for (let v = 0; v < vertexCount; v++) expect(batch!.fvertexData[firstVertex + v]).toEqual(single.fvertexData.get(v));
+            for (let x = 0; x < indexCount; x++) expect(batch!.indexData[firstIndex + x]).toEqual(single.indexData.get(x));
+        });
+        expect(ifcApi.GetBatchBuffers([WebIFC.BatchGeometryKind.AABB, 0, 0])).toBeNull();
+    })
+    test('streams the same colours from the resolved styles as single meshes read', () => {
+        const exampleIFCData = fs.readFileSync(path.join(__dirname, '../ifcfiles/public/example.ifc'));
+        const streamedModelID = ifcApi.OpenModel(exampleIFCData);
+        const singleModelID = ifcApi.OpenModel(exampleIFCData);
+        let compared = 0;
+        ifcApi.StreamAllMeshes(streamedModelID, (mesh) => {
+            const single = ifcApi.GetFlatMesh(singleModelID, mesh.expressID);
+            expect(single.geometries.size()).toEqual(mesh.geometries.size());
+            for (let i = 0; i < mesh.geometries.size(); i++) {
+                const streamed = mesh.geometries.get(i).color;
+                const read = single.geometries.get(i).color;
+                expect([streamed.x, streamed.y, streamed.z, streamed.w]).toEqual([read.x, read.y, read.z, read.w]);
+                compared++;
+            }
+        });
+        expect(compared).toBeGreaterThan(0);
+        ifcApi.CloseModel(streamedModelID);
+        ifcApi.CloseModel(singleModelID);
+    })
+    test('streams a large terrain in chunks instead of meshing it whole', () => {
+        const terrainIFC = new TextEncoder().encode([
+            "ISO-10303-21;", "HEADER;", "FILE_DESCRIPTION((''),'2;1');", "FILE_NAME('terrain.ifc','',(''),(''),'','','');", "FILE_SCHEMA(('IFC4'));", "ENDSEC;", "DATA;",
+            "#1=IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.);",
+            "#2=IFCUNITASSIGNMENT((#1));",
+            "#3=IFCPROJECT('0000000000000000000001',$,'Project',$,$,$,$,$,#2);",
+            "#4=IFCCARTESIANPOINT((0.,0.,0.));",
+            "#5=IFCAXIS2PLACEMENT3D(#4,$,$);",
+            "#6=IFCLOCALPLACEMENT($,#5);",
+            "#7=IFCCARTESIANPOINTLIST3D(((0.,0.,0.),(1.,0.,0.),(2.,0.,0.),(0.,1.,0.),(1.,1.,0.),(2.,1.,0.)));",
+            "#8=IFCTRIANGULATEDFACESET(#7,$,$,((1,2,5),(1,5,4),(2,3,6),(2,6,5)),$);",
+            "#9=IFCSHAPEREPRESENTATION($,'Body','Tessellation',(#8));",
+            "#10=IFCPRODUCTDEFINITIONSHAPE($,$,(#9));",
+            "#11=IFCGEOGRAPHICELEMENT('0000000000000000000002',$,'Terrain',$,$,#6,#10,$,.TERRAIN.);",
+            "ENDSEC;", "END-ISO-10303-21;"].join("\n"));
+        const wholeModelID = ifcApi.OpenModel(terrainIFC);
+        expect(ifcApi.GetFlatMesh(wholeModelID, 11).geometries.size()).toEqual(1);
+        ifcApi.CloseModel(wholeModelID);
+
+        const chunkedModelID = ifcApi.OpenModel(terrainIFC, { TERRAIN_CHUNK_TRIANGLES: 1 });
+        expect(ifcApi.GetFlatMesh(chunkedModelID, 11).geometries.size()).toEqual(0);
+        let triangles = 0;
+        const indices: number[] = [];
+        const chunks = ifcApi.StreamTerrain(chunkedModelID, 11, 0, (chunk) => {
+            expect(chunk.expressID).toEqual(8);
+            expect(chunk.vertexData.length % 6).toEqual(0);
+            indices.push(chunk.index);
+            triangles += chunk.indexData.length / 3;
+        });
+        expect(chunks).toBeGreaterThan(1);
+        expect(indices).toEqual([...Array(chunks).keys()]);
+        expect(triangles).toEqual(4);
+        // every vertex falls into one cluster, which leaves no triangle
+        expect(ifcApi.StreamTerrain(chunkedModelID, 11, 100, () => {})).toEqual(0);
+        ifcApi.CloseModel(chunkedModelID);
+    })
+    test('keeps terrain chunks within the error under a placement that scales one axis', () => {
+        const terrainIFC = new TextEncoder().encode([
+            "ISO-10303-21;", "HEADER;", "FILE_DESCRIPTION((''),'2;1');", "FILE_NAME('terrain.ifc','',(''),(''),'','','');", "FILE_SCHEMA(('IFC4'));", "ENDSEC;", "DATA;",
+            "#1=IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.);",
+            "#2=IFCUNITASSIGNMENT((#1));",
+            "#3=IFCPROJECT('0000000000000000000001',$,'Project',$,$,$,$,$,#2);",
+            "#4=IFCCARTESIANPOINT((0.,0.,0.));",
+            "#5=IFCAXIS2PLACEMENT3D(#4,$,$);",
+            "#6=IFCLOCALPLACEMENT($,#5);",
+            "#7=IFCCARTESIANPOINTLIST3D(((0.,0.,0.),(1.,0.,0.),(2.,0.,0.),(0.,1.,0.),(1.,1.,0.),(2.,1.,0.)));",
+            "#8=IFCTRIANGULATEDFACESET(#7,$,$,((1,2,5),(1,5,4),(2,3,6),(2,6,5)),$);",
+            "#9=IFCSHAPEREPRESENTATION($,'Body','Tessellation',(#8));",
+            "#10=IFCPRODUCTDEFINITIONSHAPE($,$,(#9));",
+            "#11=IFCGEOGRAPHICELEMENT('0000000000000000000002',$,'Terrain',$,$,#6,#10,$,.TERRAIN.);",
+            "ENDSEC;", "END-ISO-10303-21;"].join("\n"));
+        const scaledModelID = ifcApi.OpenModel(terrainIFC, { TERRAIN_CHUNK_TRIANGLES: 1 });
+        // x is stretched a hundred times, the points are 100 apart along it and 1 apart across it
+        ifcApi.SetGeometryTransformation(scaledModelID, [100, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1]);
+        let triangles = 0;
+        ifcApi.StreamTerrain(scaledModelID, 11, 10, (chunk) => {
+            for (let i = 0; i < chunk.vertexData.length; i += 6) {
+                const x = chunk.vertexData[i];
+                expect(Math.abs(x - Math.round(x / 100) * 100)).toBeLessThanOrEqual(10);
+            }
+            triangles += chunk.indexData.length / 3;
+        });
+        expect(triangles).toEqual(4);
+        ifcApi.CloseModel(scaledModelID);
+    })
+    test('can mesh an attached model without loading the file again', () => {
+        const attachedModelID = ifcApi.AttachModel(modelID);
+        expect(attachedModelID).not.toEqual(-1);
+        expect(ifcApi.GetMaxExpressID(attachedModelID)).toEqual(lastExpressId);
+        expect(ifcApi.LoadAllGeometry(attachedModelID).size()).toBe(allGeometriesSize);
+        ifcApi.CloseModel(attachedModelID);
+        expect(ifcApi.IsModelOpen(modelID)).toBeTruthy();
+    })
     test('can ensure the corret number of all streamed meshes ', () => {
         let count: number = 0;
         ifcApi.StreamAllMeshes(modelID, () => {
@@ -242,6 +468,102 @@ describe('WebIfcApi geometries', () => {
         });
         expect(count).toEqual(meshesCount);
     })
+    test('streams all meshes a time slice at a time', () => {
+        const stream = ifcApi.BeginStream(modelID);
+        expect(stream).not.toEqual(-1);
+        let count = 0;
+        let steps = 0;
+        while (ifcApi.StepStream(stream, 0, () => { count++; })) {
+            steps++;
+        }
+        ifcApi.EndStream(stream);
+        expect(count).toEqual(meshesCount);
+        expect(steps).toBeGreaterThan(0);
+        expect(ifcApi.StepStream(stream, 0, () => {})).toBeFalsy();
+    })
+    test('measures the quantities of elements without streaming their meshes', () => {
+        const walls = ifcApi.GetLineIDsWithType(modelID, WebIFC.IFCWALLSTANDARDCASE);
+        const ids = Array.from({ length: walls.size() }, (_, i) => walls.get(i));
+        const quantities = ifcApi.GetElementQuantities(modelID, ids);
+        expect(quantities).not.toBeNull();
+        expect(quantities!.length).toEqual(ids.length * 8);
+        for (let i = 0; i < ids.length; i++) {
+            expect(Math.abs(quantities![i * 8])).toBeGreaterThan(0);
+            expect(quantities![i * 8 + 1]).toBeGreaterThan(0);
+            for (let axis = 0; axis < 3; axis++) expect(quantities![i * 8 + 5 + axis]).toBeGreaterThanOrEqual(quantities![i * 8 + 2 + axis]);
+        }
+    })
+    test('reports clashes between two sets of elements', () => {
+        const walls = ifcApi.GetLineIDsWithType(modelID, WebIFC.IFCWALLSTANDARDCASE);
+        const slabs = ifcApi.GetLineIDsWithType(modelID, WebIFC.IFCSLAB);
+        const wallIDs = Array.from({ length: walls.size() }, (_, i) => walls.get(i));
+        const slabIDs = Array.from({ length: slabs.size() }, (_, i) => slabs.get(i));
+        const pairs: Array<[number, number]> = [];
+        expect(ifcApi.DetectClashes(modelID, wallIDs, modelID, wallIDs.concat(slabIDs), (batch) => {
+            for (let i = 0; i < batch.length; i += 2) pairs.push([batch[i], batch[i + 1]]);
+        }, 0.001)).toBeTruthy();
+        for (const [a, b] of pairs) {
+            expect(wallIDs).toContain(a);
+            expect(a).not.toEqual(b);
+        }
+        const touching: Array<number> = [];
+        ifcApi.DetectClashes(modelID, wallIDs, modelID, slabIDs, (batch) => touching.push(...batch), -0.001);
+        expect(touching.length / 2).toBeLessThanOrEqual(pairs.length);
+    })
+    test('merges the meshes of all shards into those of a single run', () => {
+        const manifest = ifcApi.GetPartitionManifest(modelID, 3);
+        expect(manifest).not.toBeNull();
+        let elements = 0;
+        manifest!.forEach((shard, i) => {
+            elements += shard.elementCount;
+            if (i > 0) expect(shard.firstExpressID).toBeGreaterThan(manifest![i - 1].lastExpressID);
+        });
+        const single: Array<string> = [];
+        ifcApi.StreamAllMeshes(modelID, (mesh, index, total) => {
+            single.push(`${mesh.expressID}:${index}:${total}`);
+        });
+        const sharded: Array<string> = [];
+        manifest!.forEach((_, shard) => {
+            expect(ifcApi.StreamAllMeshesShard(modelID, manifest!, shard, (mesh, index, total) => {
+                sharded.push(`${mesh.expressID}:${index}:${total}`);
+            })).toBeTruthy();
+        });
+        expect(elements).toBeGreaterThanOrEqual(single.length);
+        expect(sharded.sort()).toEqual(single.sort());
+    })
+    test('keeps the geometries of a batch while later elements are meshed under a memory limit', () => {
+        const hausIFCData = fs.readFileSync(path.join(__dirname, '../ifcfiles/public/AC20-FZK-Haus.ifc'));
+        const unlimitedModelID = ifcApi.OpenModel(hausIFCData);
+        const limitedModelID = ifcApi.OpenModel(hausIFCData, { GEOMETRY_MEMORY_LIMIT: 64 * 1024 });
+        // the walls have openings, so every wall meshes voids after the walls before it in the batch
+        const walls = ifcApi.GetLineIDsWithType(unlimitedModelID, WebIFC.IFCWALLSTANDARDCASE);
+        const wallIDs = Array.from({ length: walls.size() }, (_, i) => walls.get(i));
+        const expected: Array<string> = [];
+        for (const wallID of wallIDs) {
+            const flatMesh = ifcApi.GetFlatMesh(unlimitedModelID, wallID);
+            for (let i = 0; i < flatMesh.geometries.size(); i++) {
+                const geometryExpressID = flatMesh.geometries.get(i).geometryExpressID;
+                const geometry = ifcApi.GetGeometry(unlimitedModelID, geometryExpressID);
+                const vertices = ifcApi.GetVertexArray(geometry.GetVertexData(), geometry.GetVertexDataSize());
+                const indices = ifcApi.GetIndexArray(geometry.GetIndexData(), geometry.GetIndexDataSize());
+                expected.push(`${wallID}:${geometryExpressID}:${vertices.join(",")}:${indices.join(",")}`);
+            }
+        }
+        const streamed: Array<string> = [];
+        let batches = 0;
+        ifcApi.StreamMeshesBatched(limitedModelID, wallIDs, (records) => {
+            batches++;
+            for (let r = 0; r < records.length; r += WebIFC.MESH_RECORD_SIZE) {
+                const vertices = ifcApi.GetVertexArray(records[r + 23], records[r + 24]);
+                const indices = ifcApi.GetIndexArray(records[r + 25], records[r + 26]);
+                streamed.push(`${records[r]}:${records[r + 1]}:${vertices.join(",")}:${indices.join(",")}`);
+            }
+        });
+        expect(batches).toBeLessThan(wallIDs.length);
+        expect(streamed.sort()).toEqual(expected.sort());
+        ifcApi.CloseModel(unlimitedModelID);
+        ifcApi.CloseModel(limitedModelID);
+    })
     test('get totals and indexes of streamed meshes ', () => {
         ifcApi.StreamAllMeshes(modelID, (_,index,total) => {
             expect(index).toBeLessThan(total);